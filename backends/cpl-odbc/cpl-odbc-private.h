@@ -50,6 +50,17 @@
 /** ODBC Database Backend                                                 **/
 /***************************************************************************/
 
+/**
+ * The number of keys (such as version nodes) in a single batched query
+ */
+#define CPL_ODBC_BATCH_SIZE		64
+
+/**
+ * The maximum number of times to retry a transaction on the closure
+ * connection after a serialization failure or a deadlock
+ */
+#define CPL_ODBC_TRANSACTION_RETRIES	10
+
 /**
  * The ODBC database backend
  */
@@ -70,6 +81,13 @@ typedef struct {
 	 */
 	SQLHDBC db_connection;
 
+	/**
+	 * The connection for the transactions that update the ancestry
+	 * closure, which does not use autocommit and runs at the serializable
+	 * isolation level (only if has_closure is true)
+	 */
+	SQLHDBC closure_connection;
+
 	/**
 	 * The database type
 	 */
@@ -80,6 +98,21 @@ typedef struct {
 	 */
 	std::string connection_string;
 
+	/**
+	 * Whether the database has the optional cpl_ancestry_closure table
+	 */
+	bool has_closure;
+
+	/**
+	 * Whether the database has the cpl_latest_versions table
+	 */
+	bool has_latest_versions;
+
+	/**
+	 * Whether the database supports recursive common table expressions
+	 */
+	bool has_recursive_queries;
+
 	/**
 	 * Lock for session creation
 	 */
@@ -163,6 +196,27 @@ typedef struct {
 	 */
 	SQLHSTMT add_ancestry_edge_stmt;
 
+	/**
+	 * The lock for the closure connection and its statements
+	 */
+	mutex_t update_closure_lock;
+
+	/**
+	 * The insert statement for version creation on the closure connection
+	 */
+	SQLHSTMT closure_create_version_stmt;
+
+	/**
+	 * The statement that adds a new ancestry edge on the closure connection
+	 */
+	SQLHSTMT closure_add_ancestry_edge_stmt;
+
+	/**
+	 * The statement that adds the pairs of nodes connected through a new
+	 * edge to the ancestry closure, on the closure connection
+	 */
+	SQLHSTMT update_closure_stmt;
+
 	/**
 	 * The lock for has_immediate_ancestor
 	 */
@@ -201,7 +255,14 @@ typedef struct {
 	SQLHSTMT get_session_info_stmt;
 
 	/**
-	 * The lock for get_all_objects
+	 * The statement that returns information about up to
+	 * CPL_ODBC_BATCH_SIZE provenance sessions at once
+	 */
+	SQLHSTMT get_session_info_batch_stmt;
+
+	/**
+	 * The lock for get_all_objects, get_objects_page, and
+	 * get_contained_objects
 	 */
 	mutex_t get_all_objects_lock;
 
@@ -216,6 +277,31 @@ typedef struct {
 	 */
 	SQLHSTMT get_all_objects_with_session_stmt;
 
+	/**
+	 * The statement that returns the objects inside a container
+	 */
+	SQLHSTMT get_contained_objects_stmt;
+
+	/**
+	 * The statement that returns the objects inside a container and inside
+	 * all containers nested in it
+	 */
+	SQLHSTMT get_contained_objects_recursive_stmt;
+
+	/**
+	 * The statements that return the first and the next pages of objects
+	 * for a cursor, with only the basic information
+	 */
+	SQLHSTMT get_objects_first_page_fast_stmt;
+	SQLHSTMT get_objects_next_page_fast_stmt;
+
+	/**
+	 * The statements that return the first and the next pages of objects
+	 * for a cursor, including the creation session and the latest version
+	 */
+	SQLHSTMT get_objects_first_page_stmt;
+	SQLHSTMT get_objects_next_page_stmt;
+
 	/**
 	 * The lock for get_object_info
 	 */
@@ -226,6 +312,12 @@ typedef struct {
 	 */
 	SQLHSTMT get_object_info_stmt;
 
+	/**
+	 * The statement that returns information about up to
+	 * CPL_ODBC_BATCH_SIZE provenance objects at once
+	 */
+	SQLHSTMT get_object_info_batch_stmt;
+
 	/**
 	 * The lock for get_version_info
 	 */
@@ -237,6 +329,27 @@ typedef struct {
 	 */
 	SQLHSTMT get_version_info_stmt;
 
+	/**
+	 * The statement that returns information about up to
+	 * CPL_ODBC_BATCH_SIZE version nodes at once
+	 */
+	SQLHSTMT get_version_info_batch_stmt;
+
+	/**
+	 * The lock for get_versions_in_range and get_session_activity
+	 */
+	mutex_t get_version_activity_lock;
+
+	/**
+	 * The statement that lists the version nodes created within a time range
+	 */
+	SQLHSTMT get_versions_in_range_stmt;
+
+	/**
+	 * The statement that lists the version nodes created by a session
+	 */
+	SQLHSTMT get_session_activity_stmt;
+
 	/**
 	 * The mutex for get_object_ancestry
 	 */
@@ -262,6 +375,28 @@ typedef struct {
 	 */
 	SQLHSTMT get_object_descendants_with_ver_stmt;
 
+	/**
+	 * The statement for listing ancestors of up to CPL_ODBC_BATCH_SIZE
+	 * version nodes at once
+	 */
+	SQLHSTMT get_object_ancestors_batch_stmt;
+
+	/**
+	 * The statement for listing descendants of up to CPL_ODBC_BATCH_SIZE
+	 * version nodes at once
+	 */
+	SQLHSTMT get_object_descendants_batch_stmt;
+
+	/**
+	 * The statement for listing all transitive ancestors using the closure
+	 */
+	SQLHSTMT get_closure_ancestors_stmt;
+
+	/**
+	 * The statement for listing all transitive descendants using the closure
+	 */
+	SQLHSTMT get_closure_descendants_stmt;
+
 	/**
 	 * The mutex for get_properties
 	 */
@@ -297,6 +432,16 @@ typedef struct {
 	 */
 	SQLHSTMT lookup_by_property_stmt;
 
+	/**
+	 * The mutex for lookup_by_name_prefix
+	 */
+	mutex_t lookup_by_name_prefix_lock;
+
+	/**
+	 * The statement for looking up objects by a prefix of their names
+	 */
+	SQLHSTMT lookup_by_name_prefix_stmt;
+
 } cpl_odbc_t;
 
 
@@ -35,7 +35,10 @@
 #include "stdafx.h"
 #include "cpl-odbc-private.h"
 
+#include <algorithm>
 #include <list>
+#include <map>
+#include <sstream>
 #include <vector>
 
 
@@ -149,6 +152,27 @@ should_reconnect_due_to_odbc_error(std::vector<cpl_odbc_error_record_t>& errors)
 }
 
 
+/**
+ * Determine whether to retry a transaction because of the given error
+ * records, which is the case after a serialization failure or a deadlock
+ *
+ * @param errors the vector of error records
+ * @return true if the transaction should be retried
+ */
+static bool
+should_retry_transaction_due_to_odbc_error(
+		std::vector<cpl_odbc_error_record_t>& errors)
+{
+	for (size_t i = 0; i < errors.size(); i++) {
+		const char* state = (const char*) errors[i].state;
+		if (strcmp(state, "40001") == 0 || strcmp(state, "40P01") == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
 /**
  * If the variable ret is an error, print the SQL error
  * and goto the given label
@@ -204,6 +228,98 @@ should_reconnect_due_to_odbc_error(std::vector<cpl_odbc_error_record_t>& errors)
 	SQL_EXECUTE_EXT(handle, retry, err);
 
 
+/**
+ * Start a transaction on the closure connection that uses SQL_EXECUTE_TXN,
+ * SQL_CHECK_TXN, and SQL_COMMIT_TXN. On error, the variable txn_error holds
+ * the error code to return.
+ */
+#define SQL_START_TXN \
+	SQL_START; \
+	int conflicts_left = CPL_ODBC_TRANSACTION_RETRIES; \
+	cpl_return_t txn_error = CPL_E_STATEMENT_ERROR;
+
+
+/**
+ * Handle an error in a transaction on the closure connection: roll back
+ * the transaction, and then retry it after a serialization failure or a
+ * deadlock, reconnect and retry it after a lost connection, or set
+ * txn_error and jump to the error label
+ *
+ * @param handle the failed handle
+ * @param type the handle type
+ * @param fn the name of the failed function
+ * @param retry the label to jump to on retry
+ * @param error the label to jump to on error
+ */
+#define SQL_HANDLE_TXN_ERROR(handle, type, fn, retry, error) { \
+	std::vector<cpl_odbc_error_record_t> errors; \
+	fetch_odbc_error(handle, type, errors); \
+	SQLEndTran(SQL_HANDLE_DBC, odbc->closure_connection, SQL_ROLLBACK); \
+	if (should_retry_transaction_due_to_odbc_error(errors) \
+			&& conflicts_left-- > 0) { \
+		goto retry; \
+	} \
+	if (should_reconnect_due_to_odbc_error(errors)) { \
+		if (retries_left-- > 0) { \
+			cpl_return_t ____r = cpl_odbc_reconnect(odbc); \
+			if (CPL_IS_OK(____r)) goto retry; \
+		} \
+	} \
+	if (!errors.empty() \
+			&& strcmp((const char*) errors[0].state, "23000") == 0) { \
+		txn_error = CPL_E_ALREADY_EXISTS; \
+	} \
+	else { \
+		print_odbc_error(fn, errors); \
+	} \
+	goto error; \
+}
+
+
+/**
+ * Check the result of a statement in a transaction on the closure
+ * connection, which is stored in the variable ret
+ *
+ * @param handle the statement handle
+ * @param retry the label to jump to on retry
+ * @param error the label to jump to on error
+ */
+#define SQL_CHECK_TXN(handle, retry, error) { \
+	if (!SQL_SUCCEEDED(ret) && ret != SQL_NO_DATA) { \
+		SQL_HANDLE_TXN_ERROR(handle, SQL_HANDLE_STMT, "SQLExecute", \
+				retry, error); \
+	}}
+
+
+/**
+ * Execute the prepared statement in a transaction on the closure
+ * connection and handle the error, if any
+ *
+ * @param handle the statement handle
+ * @param retry the label to jump to on retry
+ * @param error the label to jump to on error
+ */
+#define SQL_EXECUTE_TXN(handle, retry, error) { \
+	ret = SQLExecute(handle); \
+	SQL_CHECK_TXN(handle, retry, error); \
+}
+
+
+/**
+ * Commit the transaction on the closure connection and handle the error,
+ * if any
+ *
+ * @param retry the label to jump to on retry
+ * @param error the label to jump to on error
+ */
+#define SQL_COMMIT_TXN(retry, error) { \
+	ret = SQLEndTran(SQL_HANDLE_DBC, odbc->closure_connection, SQL_COMMIT); \
+	if (!SQL_SUCCEEDED(ret)) { \
+		SQL_HANDLE_TXN_ERROR(odbc->closure_connection, SQL_HANDLE_DBC, \
+				"SQLEndTran", retry, error); \
+	}}
+
+
 /**
  * Read a single value from the result set. Close the cursor on error,
  * or if configured to do so (which is the default), also on success
@@ -337,6 +453,33 @@ cpl_sql_timestamp_to_unix_time(const SQL_TIMESTAMP_STRUCT& t)
 }
 
 
+/**
+ * Convert UNIX time to a SQL timestamp in the local time zone, which is
+ * the inverse of cpl_sql_timestamp_to_unix_time()
+ *
+ * @param T the UNIX time
+ * @param out the pointer to store the timestamp
+ */
+static void
+cpl_unix_time_to_sql_timestamp(const unsigned long T, SQL_TIMESTAMP_STRUCT* out)
+{
+	time_t t = (time_t) T;
+	struct tm m;
+#ifdef _WINDOWS
+	localtime_s(&m, &t);
+#else
+	localtime_r(&t, &m);
+#endif
+	memset(out, 0, sizeof(*out));
+	out->year = m.tm_year + 1900;
+	out->month = m.tm_mon + 1;
+	out->day = m.tm_mday;
+	out->hour = m.tm_hour;
+	out->minute = m.tm_min;
+	out->second = m.tm_sec;
+}
+
+
 /**
  * Read a timestamp from the result set and return it as UNIX time. Close
  * the cursor on error, or if configured to do so (which is the default),
@@ -469,801 +612,2975 @@ cpl_odbc_free_statement_handles(cpl_odbc_t* odbc)
 	SQLFreeHandle(SQL_HANDLE_STMT, odbc->has_immediate_ancestor_with_ver_stmt);
 	SQLFreeHandle(SQL_HANDLE_STMT, odbc->add_property_stmt);
 	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_session_info_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_session_info_batch_stmt);
 	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_all_objects_stmt);
 	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_all_objects_with_session_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_contained_objects_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT,
+			odbc->get_contained_objects_recursive_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_objects_first_page_fast_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_objects_next_page_fast_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_objects_first_page_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_objects_next_page_stmt);
 	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_object_info_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_object_info_batch_stmt);
 	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_version_info_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_version_info_batch_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_versions_in_range_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_session_activity_stmt);
 	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_object_ancestors_stmt);
 	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_object_ancestors_with_ver_stmt);
 	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_object_descendants_stmt);
 	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_object_descendants_with_ver_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_object_ancestors_batch_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_object_descendants_batch_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_closure_ancestors_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_closure_descendants_stmt);
 	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_properties_stmt);
 	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_properties_with_ver_stmt);
 	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_properties_with_key_stmt);
 	SQLFreeHandle(SQL_HANDLE_STMT, odbc->get_properties_with_key_ver_stmt);
 	SQLFreeHandle(SQL_HANDLE_STMT, odbc->lookup_by_property_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->lookup_by_name_prefix_stmt);
 }
 
 
 /**
- * Connect to a database using ODBC
+ * Create a LIKE pattern that matches the strings with the given prefix,
+ * using '!' as the escape character
  *
- * @param odbc an initialized backend structure
- * @return the error code
+ * @param prefix the prefix
+ * @param max_chars the maximum number of (UTF-8) characters of the prefix
+ *                  to include in the pattern
+ * @return the pattern
  */
-static cpl_return_t
-cpl_odbc_connect(cpl_odbc_t* odbc)
+static std::string
+cpl_odbc_like_prefix(const char* prefix, size_t max_chars)
 {
-	cpl_return_t r = CPL_OK;
-	const char* connection_string = odbc->connection_string.c_str();
-
-
-	// Open the ODBC connection
-
-	SQLRETURN ret;
-	SQLCHAR outstr[1024];
-	SQLCHAR* connection_string_copy;
-	SQLSMALLINT outstrlen;
-	size_t l_connection_string = strlen(connection_string);
+	std::string s;
+	size_t chars = 0;
 
-	connection_string_copy = (SQLCHAR*) malloc(l_connection_string + 4);
-	if (connection_string_copy == NULL) {
-		return CPL_E_INSUFFICIENT_RESOURCES;
+	for (const char* p = prefix; *p != '\0'; p++) {
+		if ((*p & 0xc0) != 0x80 && chars++ == max_chars) break;
+		if (*p == '!' || *p == '%' || *p == '_') s.push_back('!');
+		s.push_back(*p);
 	}
 
-#ifdef _WINDOWS
-	strcpy_s((char*) connection_string_copy,
-			 strlen(connection_string) + 1,
-			 connection_string);
-#else
-	strcpy((char*) connection_string_copy, connection_string);
-#endif
-	connection_string_copy[l_connection_string] = '\0';
+	s.push_back('%');
+	return s;
+}
 
-	SQLAllocHandle(SQL_HANDLE_ENV, SQL_NULL_HANDLE, &odbc->db_environment);
-	SQLSetEnvAttr(odbc->db_environment,
-				  SQL_ATTR_ODBC_VERSION,
-				  (void *) SQL_OV_ODBC3, 0);
-	SQLAllocHandle(SQL_HANDLE_DBC, odbc->db_environment, &odbc->db_connection);
-	
-	ret = SQLDriverConnect(odbc->db_connection, NULL,
-						   connection_string_copy, l_connection_string,
-						   outstr, sizeof(outstr), &outstrlen,
-						   SQL_DRIVER_NOPROMPT /*SQL_DRIVER_COMPLETE*/);
-	free(connection_string_copy);
-	connection_string_copy = NULL;
 
-	if (!SQL_SUCCEEDED(ret)) {
-		print_odbc_error("SQLDriverConnect",
-						 odbc->db_connection, SQL_HANDLE_DBC);
-		r = CPL_E_DB_CONNECTION_ERROR;
-		goto err_handles;
+/**
+ * Create a condition that matches any of CPL_ODBC_BATCH_SIZE keys, each
+ * consisting of the given columns and bound as consecutive parameters
+ *
+ * @param columns the key columns
+ * @param num_columns the number of key columns
+ * @return the text of the condition
+ */
+static std::string
+cpl_odbc_batch_condition(const char* const* columns, int num_columns)
+{
+	std::ostringstream ss;
+
+	for (int i = 0; i < CPL_ODBC_BATCH_SIZE; i++) {
+		if (i > 0) ss << " OR ";
+		ss << "(";
+		for (int c = 0; c < num_columns; c++) {
+			if (c > 0) ss << " AND ";
+			ss << columns[c] << " = ?";
+		}
+		ss << ")";
 	}
 
+	return ss.str();
+}
 
-	// Allocate the statement handles
 
-#define ALLOC_STMT(handle) \
-	SQLAllocHandle(SQL_HANDLE_STMT, odbc->db_connection, &odbc->handle);
-	
-	ALLOC_STMT(create_session_insert_stmt);
-	ALLOC_STMT(create_object_insert_stmt);
-	ALLOC_STMT(create_object_insert_container_stmt);
-	ALLOC_STMT(create_object_insert_version_stmt);
-	ALLOC_STMT(lookup_object_stmt);
-	ALLOC_STMT(lookup_object_ext_stmt);
-	ALLOC_STMT(create_version_stmt);
-	ALLOC_STMT(get_version_stmt);
-	ALLOC_STMT(add_ancestry_edge_stmt);
-	ALLOC_STMT(has_immediate_ancestor_stmt);
-	ALLOC_STMT(has_immediate_ancestor_with_ver_stmt);
-	ALLOC_STMT(add_property_stmt);
-	ALLOC_STMT(get_session_info_stmt);
-	ALLOC_STMT(get_all_objects_stmt);
-	ALLOC_STMT(get_all_objects_with_session_stmt);
-	ALLOC_STMT(get_object_info_stmt);
-	ALLOC_STMT(get_version_info_stmt);
-	ALLOC_STMT(get_object_ancestors_stmt);
-	ALLOC_STMT(get_object_ancestors_with_ver_stmt);
-	ALLOC_STMT(get_object_descendants_stmt);
-	ALLOC_STMT(get_object_descendants_with_ver_stmt);
-	ALLOC_STMT(get_properties_stmt);
-	ALLOC_STMT(get_properties_with_ver_stmt);
-	ALLOC_STMT(get_properties_with_key_stmt);
-	ALLOC_STMT(get_properties_with_key_ver_stmt);
-	ALLOC_STMT(lookup_by_property_stmt);
+/**
+ * Create the text of the statement that lists the ancestors or the
+ * descendants of CPL_ODBC_BATCH_SIZE version nodes at once
+ *
+ * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+ *                  or CPL_D_DESCENDANTS)
+ * @return the statement text
+ */
+static std::string
+cpl_odbc_ancestry_batch_sql(int direction)
+{
+	const char* q = direction == CPL_D_ANCESTORS ? "from" : "to";
+	const char* o = direction == CPL_D_ANCESTORS ? "to" : "from";
+
+	std::string q_id_hi = std::string(q) + "_id_hi";
+	std::string q_id_lo = std::string(q) + "_id_lo";
+	std::string q_version = std::string(q) + "_version";
+	const char* columns[] = {
+		q_id_hi.c_str(), q_id_lo.c_str(), q_version.c_str() };
+
+	std::ostringstream ss;
+	ss << "SELECT " << o << "_id_hi, " << o << "_id_lo, " << o << "_version, "
+	   << q << "_id_hi, " << q << "_id_lo, " << q << "_version, type"
+	   << "  FROM cpl_ancestry"
+	   << " WHERE " << cpl_odbc_batch_condition(columns, 3);
+
+	return ss.str();
+}
 
-#undef ALLOC_STMT
 
+/**
+ * Create the text of the scalar subquery that returns the latest version
+ * of the object in the current row of cpl_objects
+ *
+ * @param latest whether to use the cpl_latest_versions table
+ * @return the subquery text
+ */
+static std::string
+cpl_odbc_latest_version_sql(bool latest)
+{
+	std::ostringstream ss;
+	ss << (latest ? "(SELECT version" : "(SELECT MAX(version)")
+	   << "   FROM " << (latest ? "cpl_latest_versions" : "cpl_versions")
+	   << " m WHERE m.id_hi = cpl_objects.id_hi"
+	   << "     AND m.id_lo = cpl_objects.id_lo)";
 
-	// Prepare the statements
+	return ss.str();
+}
 
-#define PREPARE(handle, text) { \
-	ret = SQLPrepare(odbc->handle, (SQLCHAR*) text, SQL_NTS); \
-	if (!SQL_SUCCEEDED(ret)) { \
-		r = CPL_E_PREPARE_STATEMENT_ERROR; \
-		print_odbc_error("SQLPrepare", odbc->handle, SQL_HANDLE_STMT); \
-		goto err_stmts; \
-	}}
 
-	PREPARE(create_session_insert_stmt,
-			"INSERT INTO cpl_sessions"
-			"            (id_hi, id_lo, mac_address, username, pid, program,"
-			"             cmdline)"
-			"     VALUES (?, ?, ?, ?, ?, ?, ?);");
+/**
+ * Create the text of the statement that returns information about
+ * CPL_ODBC_BATCH_SIZE provenance objects at once, including their latest
+ * versions
+ *
+ * @param latest whether to use the cpl_latest_versions table
+ * @return the statement text
+ */
+static std::string
+cpl_odbc_object_info_batch_sql(bool latest)
+{
+	const char* columns[] = { "cpl_objects.id_hi", "cpl_objects.id_lo" };
+
+	std::ostringstream ss;
+	ss << "SELECT cpl_objects.id_hi, cpl_objects.id_lo,"
+	   << "       session_id_hi, session_id_lo,"
+	   << "       cpl_objects.creation_time, originator, name, type,"
+	   << "       container_id_hi, container_id_lo, container_ver,"
+	   << "       " << cpl_odbc_latest_version_sql(latest)
+	   << "  FROM cpl_objects, cpl_versions"
+	   << " WHERE cpl_objects.id_hi = cpl_versions.id_hi"
+	   << "   AND cpl_objects.id_lo = cpl_versions.id_lo"
+	   << "   AND version = 0"
+	   << "   AND (" << cpl_odbc_batch_condition(columns, 2) << ")";
+
+	return ss.str();
+}
 
-	PREPARE(create_object_insert_stmt,
-			"INSERT INTO cpl_objects"
-			"            (id_hi, id_lo, originator, name, type) "
-			"     VALUES (?, ?, ?, ?, ?);");
 
-	PREPARE(create_object_insert_container_stmt,
-			"INSERT INTO cpl_objects"
-			"            (id_hi, id_lo, originator, name, type,"
-			"             container_id_hi, container_id_lo, container_ver)"
-			"     VALUES (?, ?, ?, ?, ?, ?, ?, ?);");
+/**
+ * Create the text of the statement that returns information about
+ * CPL_ODBC_BATCH_SIZE version nodes at once
+ *
+ * @return the statement text
+ */
+static std::string
+cpl_odbc_version_info_batch_sql(void)
+{
+	const char* columns[] = { "id_hi", "id_lo", "version" };
 
-	PREPARE(create_object_insert_version_stmt,
-			"INSERT INTO cpl_versions"
-			"            (id_hi, id_lo, version, session_id_hi, session_id_lo)"
-			"     VALUES (?, ?, 0, ?, ?);");
+	std::ostringstream ss;
+	ss << "SELECT id_hi, id_lo, version,"
+	   << "       session_id_hi, session_id_lo, creation_time"
+	   << "  FROM cpl_versions"
+	   << " WHERE " << cpl_odbc_batch_condition(columns, 3);
 
-	PREPARE(lookup_object_stmt,
-			"SELECT id_hi, id_lo"
-			"  FROM cpl_objects"
-			" WHERE originator = ? AND name = ? AND type = ?"
-			" ORDER BY creation_time DESC"
-			" LIMIT 1;");
+	return ss.str();
+}
 
-	PREPARE(lookup_object_ext_stmt,
-			"SELECT id_hi, id_lo, creation_time"
-			"  FROM cpl_objects"
-			" WHERE originator = ? AND name = ? AND type = ?;");
 
-	PREPARE(create_version_stmt,
-			"INSERT INTO cpl_versions"
-			"            (id_hi, id_lo, version, session_id_hi, session_id_lo)"
-			"     VALUES (?, ?, ?, ?, ?);");
+/**
+ * Create the text of the statement that returns information about
+ * CPL_ODBC_BATCH_SIZE provenance sessions at once
+ *
+ * @return the statement text
+ */
+static std::string
+cpl_odbc_session_info_batch_sql(void)
+{
+	const char* columns[] = { "id_hi", "id_lo" };
 
-	PREPARE(get_version_stmt,
-			"SELECT MAX(version)"
-			"  FROM cpl_versions"
-			" WHERE id_hi = ? AND id_lo = ?;");
+	std::ostringstream ss;
+	ss << "SELECT id_hi, id_lo, mac_address, username,"
+	   << "       pid, program, cmdline, initialization_time"
+	   << "  FROM cpl_sessions"
+	   << " WHERE " << cpl_odbc_batch_condition(columns, 2);
 
-	PREPARE(add_ancestry_edge_stmt,
-			"INSERT INTO cpl_ancestry"
-			"            (from_id_hi, from_id_lo, from_version,"
-			"             to_id_hi, to_id_lo, to_version, type)"
-			"     VALUES (?, ?, ?, ?, ?, ?, ?);");
+	return ss.str();
+}
 
-	PREPARE(has_immediate_ancestor_stmt,
-			"SELECT to_version"
-			"  FROM cpl_ancestry"
-			" WHERE to_id_hi = ? AND to_id_lo = ? AND to_version <= ?"
-			"   AND from_id_hi = ? AND from_id_lo = ?"
-			" LIMIT 1;");
 
-	PREPARE(has_immediate_ancestor_with_ver_stmt,
-			"SELECT to_version"
-			"  FROM cpl_ancestry"
-			" WHERE to_id_hi = ? AND to_id_lo = ? AND to_version <= ?"
-			"   AND from_id_hi = ? AND from_id_lo = ? AND from_version <= ?"
-			" LIMIT 1;");
+/**
+ * Create the text of the statement that returns a page of objects ordered
+ * by their IDs, optionally restricted to the given originator and type.
+ * The parameters are the last ID of the previous page (if after is true),
+ * the originator and the type (each twice, so that NULL matches anything),
+ * and the maximum number of rows.
+ *
+ * @param after whether to return only the objects after the given ID
+ * @param fast whether to omit the creation session and the latest version
+ * @param latest whether to use the cpl_latest_versions table
+ * @return the statement text
+ */
+static std::string
+cpl_odbc_objects_page_sql(bool after, bool fast, bool latest)
+{
+	std::ostringstream ss;
+	ss << "SELECT cpl_objects.id_hi, cpl_objects.id_lo,"
+	   << "       cpl_objects.creation_time, originator, name, type,"
+	   << "       container_id_hi, container_id_lo, container_ver";
+	if (!fast) {
+		ss << ",      session_id_hi, session_id_lo,"
+		   << "       " << cpl_odbc_latest_version_sql(latest)
+		   << "  FROM cpl_objects, cpl_versions"
+		   << " WHERE cpl_objects.id_hi = cpl_versions.id_hi"
+		   << "   AND cpl_objects.id_lo = cpl_versions.id_lo"
+		   << "   AND version = 0";
+	}
+	else {
+		ss << "  FROM cpl_objects"
+		   << " WHERE 1 = 1";
+	}
+	if (after) {
+		ss << "   AND cpl_objects.id_hi >= ?"
+		   << "   AND (cpl_objects.id_hi > ? OR cpl_objects.id_lo > ?)";
+	}
+	ss << "   AND (? IS NULL OR originator = ?)"
+	   << "   AND (? IS NULL OR type = ?)"
+	   << " ORDER BY cpl_objects.id_hi, cpl_objects.id_lo"
+	   << " LIMIT ?";
 
-	PREPARE(add_property_stmt,
-			"INSERT INTO cpl_properties"
-			"            (id_hi, id_lo, version, name, value)"
-			"     VALUES (?, ?, ?, ?, ?);");
+	return ss.str();
+}
 
-	PREPARE(get_all_objects_stmt,
-			"SELECT id_hi, id_lo, creation_time, originator, name, type,"
-			"       container_id_hi, container_id_lo, container_ver"
-			"  FROM cpl_objects;");
 
-	PREPARE(get_all_objects_with_session_stmt,
-			"SELECT cpl_objects.id_hi, cpl_objects.id_lo,"
-			"       cpl_objects.creation_time, originator, name, type,"
-			"       container_id_hi, container_id_lo, container_ver,"
-			"       session_id_hi, session_id_lo"
-			"  FROM cpl_objects, cpl_versions"
-			" WHERE cpl_objects.id_hi = cpl_versions.id_hi"
-			"   AND cpl_objects.id_lo = cpl_versions.id_lo"
-			"   AND version = 0;");
-
-	PREPARE(get_object_info_stmt,
-			"SELECT session_id_hi, session_id_lo,"
-			"       cpl_objects.creation_time, originator, name, type,"
-			"       container_id_hi, container_id_lo, container_ver"
-			"  FROM cpl_objects, cpl_versions"
-			" WHERE cpl_objects.id_hi = ? AND cpl_objects.id_lo = ?"
-			"   AND cpl_objects.id_hi = cpl_versions.id_hi"
-			"   AND cpl_objects.id_lo = cpl_versions.id_lo"
-			"   AND version = 0"
-			" LIMIT 1;");
-
-	PREPARE(get_session_info_stmt,
-			"SELECT mac_address, username,"
-			"       pid, program, cmdline, initialization_time"
-			"  FROM cpl_sessions"
-			" WHERE id_hi = ? AND id_lo = ?"
-			" LIMIT 1;");
-
-	PREPARE(get_version_info_stmt,
-			"SELECT session_id_hi, session_id_lo, creation_time"
-			"  FROM cpl_versions"
-			" WHERE id_hi = ? AND id_lo = ? AND version = ?"
-			" LIMIT 1;");
+/**
+ * Create the text of the statement that returns the objects inside the
+ * given container, together with their creation sessions. The parameters
+ * are the container ID and the container version (twice, so that a
+ * negative version matches all versions).
+ *
+ * If recursive is true, the statement returns also the objects inside all
+ * nested containers, which it finds using a recursive common table
+ * expression, so that the entire hierarchy is traversed by a single query.
+ * The nested containers match in all of their versions.
+ *
+ * @param recursive whether to include the contents of nested containers
+ * @return the statement text
+ */
+static std::string
+cpl_odbc_contained_objects_sql(bool recursive)
+{
+	std::ostringstream ss;
+
+	if (recursive) {
+		ss << "WITH RECURSIVE cpl_contents(id_hi, id_lo) AS ("
+		   << "SELECT id_hi, id_lo"
+		   << "  FROM cpl_objects"
+		   << " WHERE container_id_hi = ? AND container_id_lo = ?"
+		   << "   AND (? < 0 OR container_ver = ?)"
+		   << " UNION "
+		   << "SELECT cpl_objects.id_hi, cpl_objects.id_lo"
+		   << "  FROM cpl_objects, cpl_contents"
+		   << " WHERE container_id_hi = cpl_contents.id_hi"
+		   << "   AND container_id_lo = cpl_contents.id_lo) ";
+	}
 
-	PREPARE(get_object_ancestors_stmt,
-			"SELECT to_id_hi, to_id_lo, to_version, from_version, type"
-			"  FROM cpl_ancestry"
-			" WHERE from_id_hi = ? AND from_id_lo = ?");
+	ss << "SELECT cpl_objects.id_hi, cpl_objects.id_lo,"
+	   << "       cpl_objects.creation_time, originator, name, type,"
+	   << "       container_id_hi, container_id_lo, container_ver,"
+	   << "       session_id_hi, session_id_lo";
+
+	if (recursive) {
+		ss << "  FROM cpl_contents, cpl_objects, cpl_versions"
+		   << " WHERE cpl_objects.id_hi = cpl_contents.id_hi"
+		   << "   AND cpl_objects.id_lo = cpl_contents.id_lo"
+		   << "   AND cpl_versions.id_hi = cpl_contents.id_hi"
+		   << "   AND cpl_versions.id_lo = cpl_contents.id_lo"
+		   << "   AND version = 0;";
+	}
+	else {
+		ss << "  FROM cpl_objects, cpl_versions"
+		   << " WHERE cpl_objects.id_hi = cpl_versions.id_hi"
+		   << "   AND cpl_objects.id_lo = cpl_versions.id_lo"
+		   << "   AND version = 0"
+		   << "   AND container_id_hi = ? AND container_id_lo = ?"
+		   << "   AND (? < 0 OR container_ver = ?);";
+	}
 
-	PREPARE(get_object_ancestors_with_ver_stmt,
-			"SELECT to_id_hi, to_id_lo, to_version, from_version, type"
-			"  FROM cpl_ancestry"
-			" WHERE from_id_hi = ? AND from_id_lo = ? AND from_version = ?");
+	return ss.str();
+}
 
-	PREPARE(get_object_descendants_stmt,
-			"SELECT from_id_hi, from_id_lo, from_version, to_version, type"
-			"  FROM cpl_ancestry"
-			" WHERE to_id_hi = ? AND to_id_lo = ?");
 
-	PREPARE(get_object_descendants_with_ver_stmt,
-			"SELECT from_id_hi, from_id_lo, from_version, to_version, type"
-			"  FROM cpl_ancestry"
-			" WHERE to_id_hi = ? AND to_id_lo = ? AND to_version = ?");
+/**
+ * Determine whether the database contains the given table
+ *
+ * @param odbc an initialized backend structure with an open connection
+ * @param table the table name
+ * @return true if the table exists
+ */
+static bool
+cpl_odbc_has_table(cpl_odbc_t* odbc, const char* table)
+{
+	SQLHSTMT stmt;
+	SQLRETURN ret;
 
-	PREPARE(get_properties_stmt,
-			"SELECT id_hi, id_lo, version, name, value"
-			"  FROM cpl_properties"
-			" WHERE id_hi = ? AND id_lo = ?;");
+	ret = SQLAllocHandle(SQL_HANDLE_STMT, odbc->db_connection, &stmt);
+	if (!SQL_SUCCEEDED(ret)) return false;
 
-	PREPARE(get_properties_with_ver_stmt,
-			"SELECT id_hi, id_lo, version, name, value"
-			"  FROM cpl_properties"
-			" WHERE id_hi = ? AND id_lo = ? AND version = ?;");
+	std::string q = "SELECT 1 FROM ";
+	q += table;
+	q += " WHERE 1 = 0;";
 
-	PREPARE(get_properties_with_key_stmt,
-			"SELECT id_hi, id_lo, version, name, value"
-			"  FROM cpl_properties"
-			" WHERE id_hi = ? AND id_lo = ? AND name = ?;");
+	ret = SQLExecDirect(stmt, (SQLCHAR*) q.c_str(), SQL_NTS);
+	bool exists = SQL_SUCCEEDED(ret);
+	if (exists) SQLCloseCursor(stmt);
 
-	PREPARE(get_properties_with_key_ver_stmt,
-			"SELECT id_hi, id_lo, version, name, value"
-			"  FROM cpl_properties"
-			" WHERE id_hi = ? AND id_lo = ? AND name = ? AND version = ?;");
+	SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+	return exists;
+}
 
-	PREPARE(lookup_by_property_stmt,
-			"SELECT id_hi, id_lo, version"
-			"  FROM cpl_properties"
-			" WHERE name = ? AND value = ?;");
 
+/**
+ * Determine whether the database server supports recursive common table
+ * expressions, which requires MySQL 8.0, MariaDB 10.2, PostgreSQL 8.4, or
+ * SQLite 3.8.3 or newer. Preparing the query is not a sufficient test,
+ * since some drivers, such as MySQL Connector/ODBC, only emulate it and do
+ * not send the query to the server until it is executed.
+ *
+ * @param odbc an initialized backend structure with an open connection
+ * @return true if the server is known to support recursive queries, or if
+ *         the server is not known at all, in which case the support is
+ *         determined by the first execution of the query
+ */
+static bool
+cpl_odbc_supports_recursive_queries(cpl_odbc_t* odbc)
+{
+	SQLCHAR name[256];
+	SQLCHAR version[256];
+	SQLSMALLINT length;
+	SQLRETURN ret;
+	int major = 0;
+	int minor = 0;
+	int patch = 0;
 
-#undef PREPARE
+	ret = SQLGetInfo(odbc->db_connection, SQL_DBMS_NAME, name,
+					 sizeof(name), &length);
+	if (!SQL_SUCCEEDED(ret)) return true;
+	ret = SQLGetInfo(odbc->db_connection, SQL_DBMS_VER, version,
+					 sizeof(version), &length);
+	if (!SQL_SUCCEEDED(ret)) return true;
 
+	const char* n = (const char*) name;
+	const char* v = (const char*) version;
 
-	// Return
 
-	return CPL_OK;
+	// MariaDB reports itself to the MySQL clients with versions such as
+	// 5.5.5-10.6.12-MariaDB, in which the real version follows the dash
 
+	if (strstr(v, "MariaDB") != NULL || strstr(n, "MariaDB") != NULL) {
+		const char* dash = strchr(v, '-');
+		if (strncmp(v, "5.5.5-", 6) == 0 && dash != NULL) v = dash + 1;
+		if (sscanf(v, "%d.%d", &major, &minor) < 2) return false;
+		return major > 10 || (major == 10 && minor >= 2);
+	}
 
-	// Error handling -- the variable r must be set
+	if (strstr(n, "MySQL") != NULL) {
+		if (sscanf(v, "%d", &major) < 1) return false;
+		return major >= 8;
+	}
 
-err_stmts:
-	cpl_odbc_free_statement_handles(odbc);
-	SQLDisconnect(odbc->db_connection);
+	if (strstr(n, "PostgreSQL") != NULL) {
+		if (sscanf(v, "%d.%d", &major, &minor) < 2) return false;
+		return major > 8 || (major == 8 && minor >= 4);
+	}
 
-err_handles:
-	SQLFreeHandle(SQL_HANDLE_DBC, odbc->db_connection);
-	SQLFreeHandle(SQL_HANDLE_ENV, odbc->db_environment);
+	if (strstr(n, "SQLite") != NULL) {
+		if (sscanf(v, "%d.%d.%d", &major, &minor, &patch) < 3) return false;
+		return major > 3 || (major == 3 && (minor > 8
+					|| (minor == 8 && patch >= 3)));
+	}
 
-	return r;
+	return true;
 }
 
 
 /**
- * Disconnect from a database
+ * Open the connection for the transactions that update the ancestry
+ * closure and prepare its statements. The connection does not use
+ * autocommit, and it runs at the serializable isolation level, so that
+ * the concurrent updates from other processes either serialize or fail
+ * with an error that causes the transaction to be retried.
  *
- * @param odbc the backend structure
+ * @param odbc the backend structure connected to the database
  * @return the error code
  */
-static cpl_return_t cpl_odbc_disconnect(cpl_odbc_t* odbc)
+static cpl_return_t
+cpl_odbc_connect_closure(cpl_odbc_t* odbc)
 {
 	cpl_return_t r = CPL_OK;
+	SQLRETURN ret;
+	SQLCHAR outstr[1024];
+	SQLSMALLINT outstrlen;
 
-	cpl_odbc_free_statement_handles(odbc);
+	std::string connection_string = odbc->connection_string;
 
-	SQLRETURN ret = SQLDisconnect(odbc->db_connection);
+	SQLAllocHandle(SQL_HANDLE_DBC, odbc->db_environment,
+				   &odbc->closure_connection);
+
+	ret = SQLDriverConnect(odbc->closure_connection, NULL,
+						   (SQLCHAR*) &connection_string[0],
+						   connection_string.length(),
+						   outstr, sizeof(outstr), &outstrlen,
+						   SQL_DRIVER_NOPROMPT);
 	if (!SQL_SUCCEEDED(ret)) {
+		print_odbc_error("SQLDriverConnect",
+						 odbc->closure_connection, SQL_HANDLE_DBC);
 		r = CPL_E_DB_CONNECTION_ERROR;
+		goto err_handle;
 	}
 
-	SQLFreeHandle(SQL_HANDLE_DBC, odbc->db_connection);
-	SQLFreeHandle(SQL_HANDLE_ENV, odbc->db_environment);
-
-	return r;
-}
-
-
-/**
- * Reconnect
- *
- * @param odbc the backend structure
- * @return the error code
- */
-static cpl_return_t
-cpl_odbc_reconnect(cpl_odbc_t* odbc)
-{
-	cpl_odbc_disconnect(odbc);
-	return cpl_odbc_connect(odbc);
-}
-
+	ret = SQLSetConnectAttr(odbc->closure_connection, SQL_ATTR_AUTOCOMMIT,
+							(SQLPOINTER) SQL_AUTOCOMMIT_OFF, 0);
+	if (SQL_SUCCEEDED(ret)) {
+		ret = SQLSetConnectAttr(odbc->closure_connection,
+								SQL_ATTR_TXN_ISOLATION,
+								(SQLPOINTER) SQL_TXN_SERIALIZABLE, 0);
+	}
+	if (!SQL_SUCCEEDED(ret)) {
+		print_odbc_error("SQLSetConnectAttr",
+						 odbc->closure_connection, SQL_HANDLE_DBC);
+		r = CPL_E_DB_CONNECTION_ERROR;
+		goto err_connection;
+	}
 
 
-/***************************************************************************/
-/** Constructors and a Destructor                                         **/
-/***************************************************************************/
+	// Allocate and prepare the statements
 
+#define ALLOC_STMT(handle) \
+	SQLAllocHandle(SQL_HANDLE_STMT, odbc->closure_connection, &odbc->handle);
 
-/**
- * Create an ODBC backend
- *
- * @param connection_string the ODBC connection string
- * @param db_type the database type
- * @param out the pointer to the database backend variable
- * @return the error code
- */
-extern "C" EXPORT cpl_return_t
-cpl_create_odbc_backend(const char* connection_string,
-						int db_type,
-						cpl_db_backend_t** out)
-{
-	cpl_return_t r = CPL_OK;
+	ALLOC_STMT(closure_create_version_stmt);
+	ALLOC_STMT(closure_add_ancestry_edge_stmt);
+	ALLOC_STMT(update_closure_stmt);
 
-	assert(out != NULL);
-	assert(connection_string != NULL);
+#undef ALLOC_STMT
 
+#define PREPARE(handle, text) { \
+	ret = SQLPrepare(odbc->handle, (SQLCHAR*) text, SQL_NTS); \
+	if (!SQL_SUCCEEDED(ret)) { \
+		r = CPL_E_PREPARE_STATEMENT_ERROR; \
+		print_odbc_error("SQLPrepare", odbc->handle, SQL_HANDLE_STMT); \
+		goto err_stmts; \
+	}}
 
-	// Allocate the backend struct
+	PREPARE(closure_create_version_stmt,
+			"INSERT INTO cpl_versions"
+			"            (id_hi, id_lo, version, session_id_hi, session_id_lo)"
+			"     VALUES (?, ?, ?, ?, ?);");
 
-	cpl_odbc_t* odbc = new cpl_odbc_t;
-	if (odbc == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
-	memcpy(&odbc->backend, &CPL_ODBC_BACKEND, sizeof(odbc->backend));
-	odbc->db_type = db_type;
-	odbc->connection_string = connection_string;
+	PREPARE(closure_add_ancestry_edge_stmt,
+			"INSERT INTO cpl_ancestry"
+			"            (from_id_hi, from_id_lo, from_version,"
+			"             to_id_hi, to_id_lo, to_version, type)"
+			"     VALUES (?, ?, ?, ?, ?, ?, ?);");
 
+	// Add all pairs (a, d), where a is the source of the new edge or
+	// one of its descendants, and d is the destination or one of its
+	// ancestors
 
-	// Initialize the synchronization primitives
+	PREPARE(update_closure_stmt,
+			"INSERT INTO cpl_ancestry_closure"
+			"            (from_id_hi, from_id_lo, from_version,"
+			"             to_id_hi, to_id_lo, to_version)"
+			"     SELECT a.id_hi, a.id_lo, a.version,"
+			"            d.id_hi, d.id_lo, d.version"
+			"       FROM (SELECT id_hi, id_lo, version"
+			"               FROM cpl_versions"
+			"              WHERE id_hi = ? AND id_lo = ? AND version = ?"
+			"              UNION"
+			"             SELECT from_id_hi, from_id_lo, from_version"
+			"               FROM cpl_ancestry_closure"
+			"              WHERE to_id_hi = ? AND to_id_lo = ?"
+			"                AND to_version = ?) a,"
+			"            (SELECT id_hi, id_lo, version"
+			"               FROM cpl_versions"
+			"              WHERE id_hi = ? AND id_lo = ? AND version = ?"
+			"              UNION"
+			"             SELECT to_id_hi, to_id_lo, to_version"
+			"               FROM cpl_ancestry_closure"
+			"              WHERE from_id_hi = ? AND from_id_lo = ?"
+			"                AND from_version = ?) d"
+			"      WHERE NOT EXISTS"
+			"            (SELECT 1"
+			"               FROM cpl_ancestry_closure c"
+			"              WHERE c.from_id_hi = a.id_hi"
+			"                AND c.from_id_lo = a.id_lo"
+			"                AND c.from_version = a.version"
+			"                AND c.to_id_hi = d.id_hi"
+			"                AND c.to_id_lo = d.id_lo"
+			"                AND c.to_version = d.version);");
 
-	mutex_init(odbc->create_session_lock);
-	mutex_init(odbc->create_object_lock);
-	mutex_init(odbc->lookup_object_lock);
-	mutex_init(odbc->lookup_object_ext_lock);
-	mutex_init(odbc->create_version_lock);
-	mutex_init(odbc->get_version_lock);
-	mutex_init(odbc->add_ancestry_edge_lock);
-	mutex_init(odbc->has_immediate_ancestor_lock);
-	mutex_init(odbc->add_property_lock);
-	mutex_init(odbc->get_session_info_lock);
-	mutex_init(odbc->get_all_objects_lock);
-	mutex_init(odbc->get_object_info_lock);
-	mutex_init(odbc->get_version_info_lock);
-	mutex_init(odbc->get_object_ancestry_lock);
-	mutex_init(odbc->get_properties_lock);
-	mutex_init(odbc->lookup_by_property_lock);
+#undef PREPARE
 
+	return CPL_OK;
 
-	// Open the database connection
-	
-	r = cpl_odbc_connect(odbc);
-	if (!CPL_IS_OK(r)) goto err_sync;
 
+	// Error handling -- the variable r must be set
 
-	// Return
+err_stmts:
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->closure_create_version_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->closure_add_ancestry_edge_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->update_closure_stmt);
 
-	*out = (cpl_db_backend_t*) odbc;
-	return CPL_OK;
+err_connection:
+	SQLDisconnect(odbc->closure_connection);
 
+err_handle:
+	SQLFreeHandle(SQL_HANDLE_DBC, odbc->closure_connection);
+	return r;
+}
 
-	// Error handling -- the variable r must be set
 
-err_sync:
-	mutex_destroy(odbc->create_session_lock);
-	mutex_destroy(odbc->create_object_lock);
-	mutex_destroy(odbc->lookup_object_lock);
-	mutex_destroy(odbc->lookup_object_ext_lock);
-	mutex_destroy(odbc->create_version_lock);
-	mutex_destroy(odbc->get_version_lock);
-	mutex_destroy(odbc->add_ancestry_edge_lock);
-	mutex_destroy(odbc->has_immediate_ancestor_lock);
-	mutex_destroy(odbc->add_property_lock);
-	mutex_destroy(odbc->get_session_info_lock);
-	mutex_destroy(odbc->get_all_objects_lock);
-	mutex_destroy(odbc->get_object_info_lock);
-	mutex_destroy(odbc->get_version_info_lock);
-	mutex_destroy(odbc->get_object_ancestry_lock);
-	mutex_destroy(odbc->get_properties_lock);
-	mutex_destroy(odbc->lookup_by_property_lock);
+/**
+ * Close the connection for updating the ancestry closure, rolling back any
+ * unfinished transaction
+ *
+ * @param odbc the backend structure
+ */
+static void
+cpl_odbc_disconnect_closure(cpl_odbc_t* odbc)
+{
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->closure_create_version_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->closure_add_ancestry_edge_stmt);
+	SQLFreeHandle(SQL_HANDLE_STMT, odbc->update_closure_stmt);
 
-	delete odbc;
-	return r;
+	SQLEndTran(SQL_HANDLE_DBC, odbc->closure_connection, SQL_ROLLBACK);
+	SQLDisconnect(odbc->closure_connection);
+	SQLFreeHandle(SQL_HANDLE_DBC, odbc->closure_connection);
 }
 
 
 /**
- * Create an ODBC backend
+ * Connect to a database using ODBC
  *
- * @param dsn the data source name
- * @param db_type the database type
- * @param out the pointer to the database backend variable
+ * @param odbc an initialized backend structure
  * @return the error code
  */
-extern "C" EXPORT cpl_return_t
-cpl_create_odbc_backend_dsn(const char* dsn,
-							int db_type,
-							cpl_db_backend_t** out)
+static cpl_return_t
+cpl_odbc_connect(cpl_odbc_t* odbc)
 {
-	assert(out != NULL);
-	assert(dsn != NULL);
+	cpl_return_t r = CPL_OK;
+	const char* connection_string = odbc->connection_string.c_str();
 
-	*out = NULL;
 
+	// Open the ODBC connection
+
+	SQLRETURN ret;
+	SQLCHAR outstr[1024];
+	SQLCHAR* connection_string_copy;
+	SQLSMALLINT outstrlen;
+	size_t l_connection_string = strlen(connection_string);
+
+	connection_string_copy = (SQLCHAR*) malloc(l_connection_string + 4);
+	if (connection_string_copy == NULL) {
+		return CPL_E_INSUFFICIENT_RESOURCES;
+	}
+
+#ifdef _WINDOWS
+	strcpy_s((char*) connection_string_copy,
+			 strlen(connection_string) + 1,
+			 connection_string);
+#else
+	strcpy((char*) connection_string_copy, connection_string);
+#endif
+	connection_string_copy[l_connection_string] = '\0';
+
+	SQLAllocHandle(SQL_HANDLE_ENV, SQL_NULL_HANDLE, &odbc->db_environment);
+	SQLSetEnvAttr(odbc->db_environment,
+				  SQL_ATTR_ODBC_VERSION,
+				  (void *) SQL_OV_ODBC3, 0);
+	SQLAllocHandle(SQL_HANDLE_DBC, odbc->db_environment, &odbc->db_connection);
+	
+	ret = SQLDriverConnect(odbc->db_connection, NULL,
+						   connection_string_copy, l_connection_string,
+						   outstr, sizeof(outstr), &outstrlen,
+						   SQL_DRIVER_NOPROMPT /*SQL_DRIVER_COMPLETE*/);
+	free(connection_string_copy);
+	connection_string_copy = NULL;
+
+	if (!SQL_SUCCEEDED(ret)) {
+		print_odbc_error("SQLDriverConnect",
+						 odbc->db_connection, SQL_HANDLE_DBC);
+		r = CPL_E_DB_CONNECTION_ERROR;
+		goto err_handles;
+	}
+
+
+	// Allocate the statement handles
+
+#define ALLOC_STMT(handle) \
+	SQLAllocHandle(SQL_HANDLE_STMT, odbc->db_connection, &odbc->handle);
+	
+	ALLOC_STMT(create_session_insert_stmt);
+	ALLOC_STMT(create_object_insert_stmt);
+	ALLOC_STMT(create_object_insert_container_stmt);
+	ALLOC_STMT(create_object_insert_version_stmt);
+	ALLOC_STMT(lookup_object_stmt);
+	ALLOC_STMT(lookup_object_ext_stmt);
+	ALLOC_STMT(create_version_stmt);
+	ALLOC_STMT(get_version_stmt);
+	ALLOC_STMT(add_ancestry_edge_stmt);
+	ALLOC_STMT(has_immediate_ancestor_stmt);
+	ALLOC_STMT(has_immediate_ancestor_with_ver_stmt);
+	ALLOC_STMT(add_property_stmt);
+	ALLOC_STMT(get_session_info_stmt);
+	ALLOC_STMT(get_session_info_batch_stmt);
+	ALLOC_STMT(get_all_objects_stmt);
+	ALLOC_STMT(get_all_objects_with_session_stmt);
+	ALLOC_STMT(get_contained_objects_stmt);
+	ALLOC_STMT(get_contained_objects_recursive_stmt);
+	ALLOC_STMT(get_objects_first_page_fast_stmt);
+	ALLOC_STMT(get_objects_next_page_fast_stmt);
+	ALLOC_STMT(get_objects_first_page_stmt);
+	ALLOC_STMT(get_objects_next_page_stmt);
+	ALLOC_STMT(get_object_info_stmt);
+	ALLOC_STMT(get_object_info_batch_stmt);
+	ALLOC_STMT(get_version_info_stmt);
+	ALLOC_STMT(get_version_info_batch_stmt);
+	ALLOC_STMT(get_versions_in_range_stmt);
+	ALLOC_STMT(get_session_activity_stmt);
+	ALLOC_STMT(get_object_ancestors_stmt);
+	ALLOC_STMT(get_object_ancestors_with_ver_stmt);
+	ALLOC_STMT(get_object_descendants_stmt);
+	ALLOC_STMT(get_object_descendants_with_ver_stmt);
+	ALLOC_STMT(get_object_ancestors_batch_stmt);
+	ALLOC_STMT(get_object_descendants_batch_stmt);
+	ALLOC_STMT(get_closure_ancestors_stmt);
+	ALLOC_STMT(get_closure_descendants_stmt);
+	ALLOC_STMT(get_properties_stmt);
+	ALLOC_STMT(get_properties_with_ver_stmt);
+	ALLOC_STMT(get_properties_with_key_stmt);
+	ALLOC_STMT(get_properties_with_key_ver_stmt);
+	ALLOC_STMT(lookup_by_property_stmt);
+	ALLOC_STMT(lookup_by_name_prefix_stmt);
+
+#undef ALLOC_STMT
+
+
+	// Check whether the optional ancestry closure is present
+
+	odbc->has_closure = cpl_odbc_has_table(odbc, "cpl_ancestry_closure");
+
+
+	// Check whether the table of the latest versions is present, which is
+	// maintained by a trigger on cpl_versions
+
+	odbc->has_latest_versions = cpl_odbc_has_table(odbc, "cpl_latest_versions");
+
+
+	// Prepare the statements
+
+#define PREPARE(handle, text) { \
+	ret = SQLPrepare(odbc->handle, (SQLCHAR*) text, SQL_NTS); \
+	if (!SQL_SUCCEEDED(ret)) { \
+		r = CPL_E_PREPARE_STATEMENT_ERROR; \
+		print_odbc_error("SQLPrepare", odbc->handle, SQL_HANDLE_STMT); \
+		goto err_stmts; \
+	}}
+
+	PREPARE(create_session_insert_stmt,
+			"INSERT INTO cpl_sessions"
+			"            (id_hi, id_lo, mac_address, username, pid, program,"
+			"             cmdline)"
+			"     VALUES (?, ?, ?, ?, ?, ?, ?);");
+
+	PREPARE(create_object_insert_stmt,
+			"INSERT INTO cpl_objects"
+			"            (id_hi, id_lo, originator, name, type) "
+			"     VALUES (?, ?, ?, ?, ?);");
+
+	PREPARE(create_object_insert_container_stmt,
+			"INSERT INTO cpl_objects"
+			"            (id_hi, id_lo, originator, name, type,"
+			"             container_id_hi, container_id_lo, container_ver)"
+			"     VALUES (?, ?, ?, ?, ?, ?, ?, ?);");
+
+	PREPARE(create_object_insert_version_stmt,
+			"INSERT INTO cpl_versions"
+			"            (id_hi, id_lo, version, session_id_hi, session_id_lo)"
+			"     VALUES (?, ?, 0, ?, ?);");
+
+	PREPARE(lookup_object_stmt,
+			"SELECT id_hi, id_lo"
+			"  FROM cpl_objects"
+			" WHERE originator = ? AND name = ? AND type = ?"
+			" ORDER BY creation_time DESC"
+			" LIMIT 1;");
+
+	PREPARE(lookup_object_ext_stmt,
+			"SELECT id_hi, id_lo, creation_time"
+			"  FROM cpl_objects"
+			" WHERE originator = ? AND name = ? AND type = ?;");
+
+	PREPARE(create_version_stmt,
+			"INSERT INTO cpl_versions"
+			"            (id_hi, id_lo, version, session_id_hi, session_id_lo)"
+			"     VALUES (?, ?, ?, ?, ?);");
+
+	if (odbc->has_latest_versions) {
+		PREPARE(get_version_stmt,
+				"SELECT version"
+				"  FROM cpl_latest_versions"
+				" WHERE id_hi = ? AND id_lo = ?;");
+	}
+	else {
+		PREPARE(get_version_stmt,
+				"SELECT MAX(version)"
+				"  FROM cpl_versions"
+				" WHERE id_hi = ? AND id_lo = ?;");
+	}
+
+	PREPARE(add_ancestry_edge_stmt,
+			"INSERT INTO cpl_ancestry"
+			"            (from_id_hi, from_id_lo, from_version,"
+			"             to_id_hi, to_id_lo, to_version, type)"
+			"     VALUES (?, ?, ?, ?, ?, ?, ?);");
+
+	PREPARE(has_immediate_ancestor_stmt,
+			"SELECT to_version"
+			"  FROM cpl_ancestry"
+			" WHERE to_id_hi = ? AND to_id_lo = ? AND to_version <= ?"
+			"   AND from_id_hi = ? AND from_id_lo = ?"
+			" LIMIT 1;");
+
+	PREPARE(has_immediate_ancestor_with_ver_stmt,
+			"SELECT to_version"
+			"  FROM cpl_ancestry"
+			" WHERE to_id_hi = ? AND to_id_lo = ? AND to_version <= ?"
+			"   AND from_id_hi = ? AND from_id_lo = ? AND from_version <= ?"
+			" LIMIT 1;");
+
+	PREPARE(add_property_stmt,
+			"INSERT INTO cpl_properties"
+			"            (id_hi, id_lo, version, name, value)"
+			"     VALUES (?, ?, ?, ?, ?);");
+
+	PREPARE(get_all_objects_stmt,
+			"SELECT id_hi, id_lo, creation_time, originator, name, type,"
+			"       container_id_hi, container_id_lo, container_ver"
+			"  FROM cpl_objects;");
+
+	PREPARE(get_all_objects_with_session_stmt,
+			"SELECT cpl_objects.id_hi, cpl_objects.id_lo,"
+			"       cpl_objects.creation_time, originator, name, type,"
+			"       container_id_hi, container_id_lo, container_ver,"
+			"       session_id_hi, session_id_lo"
+			"  FROM cpl_objects, cpl_versions"
+			" WHERE cpl_objects.id_hi = cpl_versions.id_hi"
+			"   AND cpl_objects.id_lo = cpl_versions.id_lo"
+			"   AND version = 0;");
+
+	PREPARE(get_contained_objects_stmt,
+			cpl_odbc_contained_objects_sql(false).c_str());
+
+	PREPARE(get_objects_first_page_fast_stmt,
+			cpl_odbc_objects_page_sql(false, true,
+				odbc->has_latest_versions).c_str());
+
+	PREPARE(get_objects_next_page_fast_stmt,
+			cpl_odbc_objects_page_sql(true, true,
+				odbc->has_latest_versions).c_str());
+
+	PREPARE(get_objects_first_page_stmt,
+			cpl_odbc_objects_page_sql(false, false,
+				odbc->has_latest_versions).c_str());
+
+	PREPARE(get_objects_next_page_stmt,
+			cpl_odbc_objects_page_sql(true, false,
+				odbc->has_latest_versions).c_str());
+
+	PREPARE(get_object_info_stmt,
+			"SELECT session_id_hi, session_id_lo,"
+			"       cpl_objects.creation_time, originator, name, type,"
+			"       container_id_hi, container_id_lo, container_ver"
+			"  FROM cpl_objects, cpl_versions"
+			" WHERE cpl_objects.id_hi = ? AND cpl_objects.id_lo = ?"
+			"   AND cpl_objects.id_hi = cpl_versions.id_hi"
+			"   AND cpl_objects.id_lo = cpl_versions.id_lo"
+			"   AND version = 0"
+			" LIMIT 1;");
+
+	PREPARE(get_object_info_batch_stmt,
+			cpl_odbc_object_info_batch_sql(odbc->has_latest_versions).c_str());
+
+	PREPARE(get_session_info_stmt,
+			"SELECT mac_address, username,"
+			"       pid, program, cmdline, initialization_time"
+			"  FROM cpl_sessions"
+			" WHERE id_hi = ? AND id_lo = ?"
+			" LIMIT 1;");
+
+	PREPARE(get_session_info_batch_stmt,
+			cpl_odbc_session_info_batch_sql().c_str());
+
+	PREPARE(get_version_info_stmt,
+			"SELECT session_id_hi, session_id_lo, creation_time"
+			"  FROM cpl_versions"
+			" WHERE id_hi = ? AND id_lo = ? AND version = ?"
+			" LIMIT 1;");
+
+	PREPARE(get_version_info_batch_stmt,
+			cpl_odbc_version_info_batch_sql().c_str());
+
+	PREPARE(get_versions_in_range_stmt,
+			"SELECT id_hi, id_lo, version, session_id_hi, session_id_lo,"
+			"       creation_time"
+			"  FROM cpl_versions"
+			" WHERE creation_time >= ? AND creation_time <= ?"
+			" ORDER BY creation_time, id_hi, id_lo, version;");
+
+	PREPARE(get_session_activity_stmt,
+			"SELECT id_hi, id_lo, version, session_id_hi, session_id_lo,"
+			"       creation_time"
+			"  FROM cpl_versions"
+			" WHERE session_id_hi = ? AND session_id_lo = ?"
+			" ORDER BY creation_time, id_hi, id_lo, version;");
+
+	PREPARE(get_object_ancestors_stmt,
+			"SELECT to_id_hi, to_id_lo, to_version, from_version, type"
+			"  FROM cpl_ancestry"
+			" WHERE from_id_hi = ? AND from_id_lo = ?");
+
+	PREPARE(get_object_ancestors_with_ver_stmt,
+			"SELECT to_id_hi, to_id_lo, to_version, from_version, type"
+			"  FROM cpl_ancestry"
+			" WHERE from_id_hi = ? AND from_id_lo = ? AND from_version = ?");
+
+	PREPARE(get_object_descendants_stmt,
+			"SELECT from_id_hi, from_id_lo, from_version, to_version, type"
+			"  FROM cpl_ancestry"
+			" WHERE to_id_hi = ? AND to_id_lo = ?");
+
+	PREPARE(get_object_descendants_with_ver_stmt,
+			"SELECT from_id_hi, from_id_lo, from_version, to_version, type"
+			"  FROM cpl_ancestry"
+			" WHERE to_id_hi = ? AND to_id_lo = ? AND to_version = ?");
+
+	PREPARE(get_object_ancestors_batch_stmt,
+			cpl_odbc_ancestry_batch_sql(CPL_D_ANCESTORS).c_str());
+
+	PREPARE(get_object_descendants_batch_stmt,
+			cpl_odbc_ancestry_batch_sql(CPL_D_DESCENDANTS).c_str());
+
+	if (odbc->has_closure) {
+
+		PREPARE(get_closure_ancestors_stmt,
+				"SELECT to_id_hi, to_id_lo, to_version"
+				"  FROM cpl_ancestry_closure"
+				" WHERE from_id_hi = ? AND from_id_lo = ? AND from_version = ?;");
+
+		PREPARE(get_closure_descendants_stmt,
+				"SELECT from_id_hi, from_id_lo, from_version"
+				"  FROM cpl_ancestry_closure"
+				" WHERE to_id_hi = ? AND to_id_lo = ? AND to_version = ?;");
+	}
+
+	PREPARE(get_properties_stmt,
+			"SELECT id_hi, id_lo, version, name, value"
+			"  FROM cpl_properties"
+			" WHERE id_hi = ? AND id_lo = ?;");
+
+	PREPARE(get_properties_with_ver_stmt,
+			"SELECT id_hi, id_lo, version, name, value"
+			"  FROM cpl_properties"
+			" WHERE id_hi = ? AND id_lo = ? AND version = ?;");
+
+	PREPARE(get_properties_with_key_stmt,
+			"SELECT id_hi, id_lo, version, name, value"
+			"  FROM cpl_properties"
+			" WHERE id_hi = ? AND id_lo = ? AND name = ?;");
+
+	PREPARE(get_properties_with_key_ver_stmt,
+			"SELECT id_hi, id_lo, version, name, value"
+			"  FROM cpl_properties"
+			" WHERE id_hi = ? AND id_lo = ? AND name = ? AND version = ?;");
+
+	PREPARE(lookup_by_property_stmt,
+			"SELECT id_hi, id_lo, version"
+			"  FROM cpl_properties"
+			" WHERE name = ? AND value = ?;");
+
+	PREPARE(lookup_by_name_prefix_stmt,
+			"SELECT cpl_objects.id_hi, cpl_objects.id_lo,"
+			"       cpl_objects.creation_time, originator, name, type,"
+			"       container_id_hi, container_id_lo, container_ver,"
+			"       session_id_hi, session_id_lo"
+			"  FROM cpl_objects, cpl_versions"
+			" WHERE cpl_objects.id_hi = cpl_versions.id_hi"
+			"   AND cpl_objects.id_lo = cpl_versions.id_lo"
+			"   AND version = 0"
+			"   AND name LIKE ? ESCAPE '!'"
+			"   AND (? IS NULL OR originator = ?)"
+			"   AND (? IS NULL OR type = ?)"
+			" ORDER BY name;");
+
+
+#undef PREPARE
+
+
+	// Prepare the recursive query for the container hierarchy, which needs
+	// the support for common table expressions (MySQL 8.0 or PostgreSQL 8.4
+	// and newer). Without it, the hierarchy is traversed one container at a
+	// time. A successful prepare does not prove the support, so check the
+	// server version as well; if the query still fails when executed,
+	// cpl_odbc_get_contained_objects() falls back to the traversal.
+
+	ret = SQLPrepare(odbc->get_contained_objects_recursive_stmt,
+			(SQLCHAR*) cpl_odbc_contained_objects_sql(true).c_str(), SQL_NTS);
+	odbc->has_recursive_queries = SQL_SUCCEEDED(ret)
+		&& cpl_odbc_supports_recursive_queries(odbc);
+
+
+	// Open the connection for updating the closure
+
+	if (odbc->has_closure) {
+		r = cpl_odbc_connect_closure(odbc);
+		if (!CPL_IS_OK(r)) goto err_stmts;
+	}
+
+
+	// Return
+
+	return CPL_OK;
+
+
+	// Error handling -- the variable r must be set
+
+err_stmts:
+	cpl_odbc_free_statement_handles(odbc);
+	SQLDisconnect(odbc->db_connection);
+
+err_handles:
+	SQLFreeHandle(SQL_HANDLE_DBC, odbc->db_connection);
+	SQLFreeHandle(SQL_HANDLE_ENV, odbc->db_environment);
+
+	return r;
+}
+
+
+/**
+ * Disconnect from a database
+ *
+ * @param odbc the backend structure
+ * @return the error code
+ */
+static cpl_return_t cpl_odbc_disconnect(cpl_odbc_t* odbc)
+{
+	cpl_return_t r = CPL_OK;
+
+	if (odbc->has_closure) cpl_odbc_disconnect_closure(odbc);
+	cpl_odbc_free_statement_handles(odbc);
+
+	SQLRETURN ret = SQLDisconnect(odbc->db_connection);
+	if (!SQL_SUCCEEDED(ret)) {
+		r = CPL_E_DB_CONNECTION_ERROR;
+	}
+
+	SQLFreeHandle(SQL_HANDLE_DBC, odbc->db_connection);
+	SQLFreeHandle(SQL_HANDLE_ENV, odbc->db_environment);
+
+	return r;
+}
+
+
+/**
+ * Reconnect
+ *
+ * @param odbc the backend structure
+ * @return the error code
+ */
+static cpl_return_t
+cpl_odbc_reconnect(cpl_odbc_t* odbc)
+{
+	cpl_odbc_disconnect(odbc);
+	return cpl_odbc_connect(odbc);
+}
+
+
+
+/***************************************************************************/
+/** Constructors and a Destructor                                         **/
+/***************************************************************************/
+
+
+/**
+ * Create an ODBC backend
+ *
+ * @param connection_string the ODBC connection string
+ * @param db_type the database type
+ * @param out the pointer to the database backend variable
+ * @return the error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_create_odbc_backend(const char* connection_string,
+						int db_type,
+						cpl_db_backend_t** out)
+{
+	cpl_return_t r = CPL_OK;
+
+	assert(out != NULL);
+	assert(connection_string != NULL);
+
+
+	// Allocate the backend struct
+
+	cpl_odbc_t* odbc = new cpl_odbc_t;
+	if (odbc == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
+	memcpy(&odbc->backend, &CPL_ODBC_BACKEND, sizeof(odbc->backend));
+	odbc->db_type = db_type;
+	odbc->connection_string = connection_string;
+
+
+	// Initialize the synchronization primitives
+
+	mutex_init(odbc->create_session_lock);
+	mutex_init(odbc->create_object_lock);
+	mutex_init(odbc->lookup_object_lock);
+	mutex_init(odbc->lookup_object_ext_lock);
+	mutex_init(odbc->create_version_lock);
+	mutex_init(odbc->get_version_lock);
+	mutex_init(odbc->add_ancestry_edge_lock);
+	mutex_init(odbc->update_closure_lock);
+	mutex_init(odbc->has_immediate_ancestor_lock);
+	mutex_init(odbc->add_property_lock);
+	mutex_init(odbc->get_session_info_lock);
+	mutex_init(odbc->get_all_objects_lock);
+	mutex_init(odbc->get_object_info_lock);
+	mutex_init(odbc->get_version_info_lock);
+	mutex_init(odbc->get_version_activity_lock);
+	mutex_init(odbc->get_object_ancestry_lock);
+	mutex_init(odbc->get_properties_lock);
+	mutex_init(odbc->lookup_by_property_lock);
+	mutex_init(odbc->lookup_by_name_prefix_lock);
+
+
+	// Open the database connection
+	
+	r = cpl_odbc_connect(odbc);
+	if (!CPL_IS_OK(r)) goto err_sync;
+
+
+	// Return
+
+	*out = (cpl_db_backend_t*) odbc;
+	return CPL_OK;
+
+
+	// Error handling -- the variable r must be set
+
+err_sync:
+	mutex_destroy(odbc->create_session_lock);
+	mutex_destroy(odbc->create_object_lock);
+	mutex_destroy(odbc->lookup_object_lock);
+	mutex_destroy(odbc->lookup_object_ext_lock);
+	mutex_destroy(odbc->create_version_lock);
+	mutex_destroy(odbc->get_version_lock);
+	mutex_destroy(odbc->add_ancestry_edge_lock);
+	mutex_destroy(odbc->update_closure_lock);
+	mutex_destroy(odbc->has_immediate_ancestor_lock);
+	mutex_destroy(odbc->add_property_lock);
+	mutex_destroy(odbc->get_session_info_lock);
+	mutex_destroy(odbc->get_all_objects_lock);
+	mutex_destroy(odbc->get_object_info_lock);
+	mutex_destroy(odbc->get_version_info_lock);
+	mutex_destroy(odbc->get_version_activity_lock);
+	mutex_destroy(odbc->get_object_ancestry_lock);
+	mutex_destroy(odbc->get_properties_lock);
+	mutex_destroy(odbc->lookup_by_property_lock);
+	mutex_destroy(odbc->lookup_by_name_prefix_lock);
+
+	delete odbc;
+	return r;
+}
+
+
+/**
+ * Create an ODBC backend
+ *
+ * @param dsn the data source name
+ * @param db_type the database type
+ * @param out the pointer to the database backend variable
+ * @return the error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_create_odbc_backend_dsn(const char* dsn,
+							int db_type,
+							cpl_db_backend_t** out)
+{
+	assert(out != NULL);
+	assert(dsn != NULL);
+
+	*out = NULL;
+
+
+	// Check the DSN
+
+	if (strchr(dsn, ';') != NULL
+			|| strchr(dsn, '{') != NULL
+			|| strchr(dsn, '}') != NULL) {
+		return CPL_E_INVALID_ARGUMENT;
+	}
+
+
+	// Create the connection string
+
+	std::string conn = "DSN=";
+	conn += dsn;
+	conn += ";";
+
+
+	// Create the backend
+	
+	return cpl_create_odbc_backend(conn.c_str(), db_type, out);
+}
+
+
+/**
+ * Destructor. If the constructor allocated the backend structure, it
+ * should be freed by this function
+ *
+ * @param backend the pointer to the backend structure
+ * @param the error code
+ */
+extern "C" cpl_return_t
+cpl_odbc_destroy(struct _cpl_db_backend_t* backend)
+{
+	assert(backend != NULL);
+	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+
+	cpl_return_t r = cpl_odbc_disconnect(odbc);
+	if (!CPL_IS_OK(r)) {
+		fprintf(stderr, "Warning: Could not terminate the ODBC connection.\n");
+	}
+
+	mutex_destroy(odbc->create_session_lock);
+	mutex_destroy(odbc->create_object_lock);
+	mutex_destroy(odbc->lookup_object_lock);
+	mutex_destroy(odbc->lookup_object_ext_lock);
+	mutex_destroy(odbc->create_version_lock);
+	mutex_destroy(odbc->get_version_lock);
+	mutex_destroy(odbc->add_ancestry_edge_lock);
+	mutex_destroy(odbc->update_closure_lock);
+	mutex_destroy(odbc->has_immediate_ancestor_lock);
+	mutex_destroy(odbc->add_property_lock);
+	mutex_destroy(odbc->get_session_info_lock);
+	mutex_destroy(odbc->get_all_objects_lock);
+	mutex_destroy(odbc->get_object_info_lock);
+	mutex_destroy(odbc->get_version_info_lock);
+	mutex_destroy(odbc->get_version_activity_lock);
+	mutex_destroy(odbc->get_object_ancestry_lock);
+	mutex_destroy(odbc->get_properties_lock);
+	mutex_destroy(odbc->lookup_by_property_lock);
+	mutex_destroy(odbc->lookup_by_name_prefix_lock);
+	
+	delete odbc;
+	
+	return CPL_OK;
+}
+
+
+
+/***************************************************************************/
+/** Helpers for Binding                                                   **/
+/***************************************************************************/
+
+
+/**
+ * Bind a VARCHAR parameter. Jump to "err" on error. Variable "ret" must be
+ * already defined.
+ *
+ * @param stmt the statement
+ * @param arg the argument number
+ * @param size the VARCHAR size
+ * @param value the char* value
+ */
+#define SQL_BIND_VARCHAR(stmt, arg, size, value) { \
+	SQLLEN* cb = (SQLLEN*) alloca(sizeof(SQLLEN)); \
+	*cb = (value) == NULL ? SQL_NULL_DATA : SQL_NTS; \
+	ret = SQLBindParameter(stmt, arg, SQL_PARAM_INPUT, \
+			SQL_C_CHAR, SQL_VARCHAR, size, 0, \
+			(SQLCHAR*) (value), 0, cb); \
+	SQL_ASSERT_NO_ERROR(SQLBindParameter, stmt, err); \
+}
+
+
+/**
+ * Bind an INTEGER parameter. Jump to "err" on error. Variable "ret" must be
+ * already defined.
+ *
+ * @param stmt the statement
+ * @param arg the argument number
+ * @param value the int value
+ */
+#define SQL_BIND_INTEGER(stmt, arg, value) { \
+	long long* __p = (long long*) alloca(sizeof(long long)); \
+	*__p = (long long) value; \
+	ret = SQLBindParameter(stmt, arg, SQL_PARAM_INPUT, \
+			SQL_C_SBIGINT, SQL_INTEGER, 0, 0, \
+			(void*) __p, 0, NULL); \
+	SQL_ASSERT_NO_ERROR(SQLBindParameter, stmt, err); \
+}
+
+
+/**
+ * Bind a TIMESTAMP parameter given as UNIX time. Jump to "err" on error.
+ * Variable "ret" must be already defined.
+ *
+ * @param stmt the statement
+ * @param arg the argument number
+ * @param value the UNIX time
+ */
+#define SQL_BIND_TIMESTAMP(stmt, arg, value) { \
+	SQL_TIMESTAMP_STRUCT* __p = (SQL_TIMESTAMP_STRUCT*) \
+			alloca(sizeof(SQL_TIMESTAMP_STRUCT)); \
+	cpl_unix_time_to_sql_timestamp((value), __p); \
+	ret = SQLBindParameter(stmt, arg, SQL_PARAM_INPUT, \
+			SQL_C_TYPE_TIMESTAMP, SQL_TYPE_TIMESTAMP, 19, 0, \
+			(void*) __p, sizeof(SQL_TIMESTAMP_STRUCT), NULL); \
+	SQL_ASSERT_NO_ERROR(SQLBindParameter, stmt, err); \
+}
+
+
+
+/***************************************************************************/
+/** Helpers for the Info Structures                                       **/
+/***************************************************************************/
+
+
+/**
+ * Free an object info structure allocated by this backend
+ *
+ * @param p the object info structure
+ */
+static void
+cpl_odbc_free_object_info(cpl_object_info_t* p)
+{
+	if (p->originator != NULL) free(p->originator);
+	if (p->name != NULL) free(p->name);
+	if (p->type != NULL) free(p->type);
+	free(p);
+}
+
+
+/**
+ * Free a session info structure allocated by this backend
+ *
+ * @param p the session info structure
+ */
+static void
+cpl_odbc_free_session_info(cpl_session_info_t* p)
+{
+	if (p->mac_address != NULL) free(p->mac_address);
+	if (p->user != NULL) free(p->user);
+	if (p->program != NULL) free(p->program);
+	if (p->cmdline != NULL) free(p->cmdline);
+	free(p);
+}
+
+
+
+/***************************************************************************/
+/** Helpers for the Ancestry Closure                                      **/
+/***************************************************************************/
+
+
+/**
+ * Update the ancestry closure with a new edge as a part of the current
+ * transaction on the closure connection. The new pairs are those
+ * connecting the source of the edge or any of its descendants with the
+ * destination or any of its ancestors, so the closure stays complete as
+ * long as all edges, including the implicit edges between consecutive
+ * versions of an object, are added in the same transaction as the update.
+ *
+ * @param odbc the backend structure
+ * @param from_id the edge source ID
+ * @param from_ver the edge source version
+ * @param to_id the edge destination ID
+ * @param to_ver the edge destination version
+ * @return the result of SQLBindParameter() or SQLExecute(), which is
+ *         SQL_NO_DATA if the edge is already implied by the closure
+ */
+static SQLRETURN
+cpl_odbc_update_closure(cpl_odbc_t* odbc,
+						const cpl_id_t from_id,
+						const cpl_version_t from_ver,
+						const cpl_id_t to_id,
+						const cpl_version_t to_ver)
+{
+	SQLRETURN ret;
+
+
+	// Prepare the statement
+
+	SQLHSTMT stmt = odbc->update_closure_stmt;
+
+	SQL_BIND_INTEGER(stmt,  1, from_id.hi);
+	SQL_BIND_INTEGER(stmt,  2, from_id.lo);
+	SQL_BIND_INTEGER(stmt,  3, from_ver);
+	SQL_BIND_INTEGER(stmt,  4, from_id.hi);
+	SQL_BIND_INTEGER(stmt,  5, from_id.lo);
+	SQL_BIND_INTEGER(stmt,  6, from_ver);
+	SQL_BIND_INTEGER(stmt,  7, to_id.hi);
+	SQL_BIND_INTEGER(stmt,  8, to_id.lo);
+	SQL_BIND_INTEGER(stmt,  9, to_ver);
+	SQL_BIND_INTEGER(stmt, 10, to_id.hi);
+	SQL_BIND_INTEGER(stmt, 11, to_id.lo);
+	SQL_BIND_INTEGER(stmt, 12, to_ver);
+
+
+	// Execute
+
+	return SQLExecute(stmt);
+
+
+	// Error handling
+
+err:
+	return ret;
+}
+
+
+/**
+ * Create a new version of an object and connect it to its previous version
+ * in the ancestry closure, in a single transaction on the closure
+ * connection
+ *
+ * @param odbc the backend structure
+ * @param object_id the object ID
+ * @param version the new version
+ * @param session the session ID
+ * @return CPL_OK, CPL_E_ALREADY_EXISTS, or an error code
+ */
+static cpl_return_t
+cpl_odbc_create_version_with_closure(cpl_odbc_t* odbc,
+									 const cpl_id_t object_id,
+									 const cpl_version_t version,
+									 const cpl_session_t session)
+{
+	SQL_START_TXN;
+
+	mutex_lock(odbc->update_closure_lock);
+
+
+	// Insert the version
+
+retry:
+	SQLHSTMT stmt = odbc->closure_create_version_stmt;
+	SQL_BIND_INTEGER(stmt, 1, object_id.hi);
+	SQL_BIND_INTEGER(stmt, 2, object_id.lo);
+	SQL_BIND_INTEGER(stmt, 3, version);
+	SQL_BIND_INTEGER(stmt, 4, session.hi);
+	SQL_BIND_INTEGER(stmt, 5, session.lo);
+
+	SQL_EXECUTE_TXN(stmt, retry, err);
+
+
+	// Update the closure
+
+	if (version > 0) {
+		ret = cpl_odbc_update_closure(odbc, object_id, version,
+									  object_id, version - 1);
+		SQL_CHECK_TXN(odbc->update_closure_stmt, retry, err);
+	}
+
+	SQL_COMMIT_TXN(retry, err);
+
+
+	// Cleanup
+
+	mutex_unlock(odbc->update_closure_lock);
+	return CPL_OK;
+
+
+	// Error handling
+
+err:
+	SQLEndTran(SQL_HANDLE_DBC, odbc->closure_connection, SQL_ROLLBACK);
+	mutex_unlock(odbc->update_closure_lock);
+	return txn_error;
+}
+
+
+/**
+ * Add an ancestry edge and update the ancestry closure, in a single
+ * transaction on the closure connection
+ *
+ * @param odbc the backend structure
+ * @param from_id the edge source ID
+ * @param from_ver the edge source version
+ * @param to_id the edge destination ID
+ * @param to_ver the edge destination version
+ * @param type the data or control dependency type
+ * @return the error code
+ */
+static cpl_return_t
+cpl_odbc_add_ancestry_edge_with_closure(cpl_odbc_t* odbc,
+										const cpl_id_t from_id,
+										const cpl_version_t from_ver,
+										const cpl_id_t to_id,
+										const cpl_version_t to_ver,
+										const int type)
+{
+	SQL_START_TXN;
+
+	mutex_lock(odbc->update_closure_lock);
+
+
+	// Insert the edge
+
+retry:
+	SQLHSTMT stmt = odbc->closure_add_ancestry_edge_stmt;
+	SQL_BIND_INTEGER(stmt, 1, from_id.hi);
+	SQL_BIND_INTEGER(stmt, 2, from_id.lo);
+	SQL_BIND_INTEGER(stmt, 3, from_ver);
+	SQL_BIND_INTEGER(stmt, 4, to_id.hi);
+	SQL_BIND_INTEGER(stmt, 5, to_id.lo);
+	SQL_BIND_INTEGER(stmt, 6, to_ver);
+	SQL_BIND_INTEGER(stmt, 7, type);
+
+	SQL_EXECUTE_TXN(stmt, retry, err);
+
+
+	// Update the closure
+
+	ret = cpl_odbc_update_closure(odbc, from_id, from_ver, to_id, to_ver);
+	SQL_CHECK_TXN(odbc->update_closure_stmt, retry, err);
+
+	SQL_COMMIT_TXN(retry, err);
+
+
+	// Cleanup
+
+	mutex_unlock(odbc->update_closure_lock);
+	return CPL_OK;
+
+
+	// Error handling
+
+err:
+	SQLEndTran(SQL_HANDLE_DBC, odbc->closure_connection, SQL_ROLLBACK);
+	mutex_unlock(odbc->update_closure_lock);
+	return txn_error;
+}
+
+
+
+/***************************************************************************/
+/** Public API                                                            **/
+/***************************************************************************/
+
+
+/**
+ * Create a session.
+ *
+ * @param backend the pointer to the backend structure
+ * @param session the session ID to use
+ * @param mac_address human-readable MAC address (NULL if not available)
+ * @param user the user name
+ * @param pid the process ID
+ * @param program the program name
+ * @param cmdline the command line
+ * @return CPL_OK or an error code
+ */
+extern "C" cpl_return_t
+cpl_odbc_create_session(struct _cpl_db_backend_t* backend,
+						const cpl_session_t session,
+						const char* mac_address,
+						const char* user,
+						const int pid,
+						const char* program,
+						const char* cmdline)
+{
+	assert(backend != NULL && user != NULL && program != NULL && cmdline!=NULL);
+	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+
+	mutex_lock(odbc->create_session_lock);
+
+	
+	// Bind the statement parameters
+
+	SQL_START;
+
+retry:
+	SQLHSTMT stmt = odbc->create_session_insert_stmt;
+
+	SQL_BIND_INTEGER(stmt, 1, session.hi);
+	SQL_BIND_INTEGER(stmt, 2, session.lo);
+	SQL_BIND_VARCHAR(stmt, 3, 18, mac_address);
+	SQL_BIND_VARCHAR(stmt, 4, 255, user);
+	SQL_BIND_INTEGER(stmt, 5, pid);
+	SQL_BIND_VARCHAR(stmt, 6, 4095, program);
+	SQL_BIND_VARCHAR(stmt, 7, 4095, cmdline);
+
+
+	// Insert the new row to the sessions table
+
+	SQL_EXECUTE(stmt);
+
+
+	// Finish
+
+	mutex_unlock(odbc->create_session_lock);
+	return CPL_OK;
+
+
+	// Error handling
+
+err:
+	mutex_unlock(odbc->create_session_lock);
+	return CPL_E_STATEMENT_ERROR;
+}
+
+
+/**
+ * Create an object.
+ *
+ * @param backend the pointer to the backend structure
+ * @param id the ID of the new object
+ * @param originator the originator
+ * @param name the object name
+ * @param type the object type
+ * @param container the ID of the object that should contain this object
+ *                  (use CPL_NONE for no container)
+ * @param container_version the version of the container (if not CPL_NONE)
+ * @param session the session ID responsible for this provenance record
+ * @return CPL_OK or an error code
+ */
+extern "C" cpl_return_t
+cpl_odbc_create_object(struct _cpl_db_backend_t* backend,
+					   const cpl_id_t id,
+					   const char* originator,
+					   const char* name,
+					   const char* type,
+					   const cpl_id_t container,
+					   const cpl_version_t container_version,
+					   const cpl_session_t session)
+{
+	assert(backend != NULL && originator != NULL
+			&& name != NULL && type != NULL);
+	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+	
+	mutex_lock(odbc->create_object_lock);
+
+	
+	// Bind the statement parameters
+
+	SQL_START;
+
+retry:
+	SQLHSTMT stmt = container == CPL_NONE
+		? odbc->create_object_insert_stmt
+		: odbc->create_object_insert_container_stmt;
+
+	SQL_BIND_INTEGER(stmt, 1, id.hi);
+	SQL_BIND_INTEGER(stmt, 2, id.lo);
+	SQL_BIND_VARCHAR(stmt, 3, 255, originator);
+	SQL_BIND_VARCHAR(stmt, 4, 255, name);
+	SQL_BIND_VARCHAR(stmt, 5, 100, type);
+
+	if (container != CPL_NONE) {
+		SQL_BIND_INTEGER(stmt, 6, container.hi);
+		SQL_BIND_INTEGER(stmt, 7, container.lo);
+		SQL_BIND_INTEGER(stmt, 8, container_version);
+	}
+
+
+	// Insert the new row to the objects table
+
+	SQL_EXECUTE(stmt);
+
+
+	// Insert the corresponding entry to the versions table
+
+retry2:
+	stmt = odbc->create_object_insert_version_stmt;
+	SQL_BIND_INTEGER(stmt, 1, id.hi);
+	SQL_BIND_INTEGER(stmt, 2, id.lo);
+	SQL_BIND_INTEGER(stmt, 3, session.hi);
+	SQL_BIND_INTEGER(stmt, 4, session.lo);
+
+	SQL_EXECUTE_EXT(stmt, retry2, err);
+
+	
+	// Finish
+
+	mutex_unlock(odbc->create_object_lock);
+	return CPL_OK;
+
+
+	// Error handling
+
+err:
+	mutex_unlock(odbc->create_object_lock);
+	return CPL_E_STATEMENT_ERROR;
+}
+
+
+/**
+ * Look up an object by name. If multiple objects share the same name,
+ * get the latest one.
+ *
+ * @param backend the pointer to the backend structure
+ * @param originator the object originator (namespace)
+ * @param name the object name
+ * @param type the object type
+ * @param out_id the pointer to store the object ID
+ * @return CPL_OK or an error code
+ */
+extern "C" cpl_return_t
+cpl_odbc_lookup_object(struct _cpl_db_backend_t* backend,
+					   const char* originator,
+					   const char* name,
+					   const char* type,
+					   cpl_id_t* out_id)
+{
+	assert(backend != NULL);
+	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+	
+	SQL_START;
+
+	cpl_id_t id = CPL_NONE;
+	cpl_return_t r = CPL_E_INTERNAL_ERROR;
+
+	mutex_lock(odbc->lookup_object_lock);
+
+
+	// Prepare the statement
+
+retry:
+	SQLHSTMT stmt = odbc->lookup_object_stmt;
+
+	SQL_BIND_VARCHAR(stmt, 1, 255, originator);
+	SQL_BIND_VARCHAR(stmt, 2, 255, name);
+	SQL_BIND_VARCHAR(stmt, 3, 100, type);
+
+
+	// Execute
+	
+	SQL_EXECUTE(stmt);
+
+
+	// Fetch the result
+
+	r = cpl_sql_fetch_single_llong(stmt, (long long*) &id.hi, 1, true, false);
+	if (!CPL_IS_OK(r)) {
+		mutex_unlock(odbc->lookup_object_lock);
+		return r;
+	}
+
+	r = cpl_sql_fetch_single_llong(stmt, (long long*) &id.lo, 2, false, true);
+	if (!CPL_IS_OK(r)) {
+		mutex_unlock(odbc->lookup_object_lock);
+		return r;
+	}
+
+
+	// Cleanup
+
+	mutex_unlock(odbc->lookup_object_lock);
+	
+	if (out_id != NULL) *out_id = id;
+	return CPL_OK;
+
+
+	// Error handling
+
+err:
+	mutex_unlock(odbc->lookup_object_lock);
+	return CPL_E_STATEMENT_ERROR;
+}
+
+
+/**
+ * Look up an object by name. If multiple objects share the same name,
+ * get the latest one.
+ *
+ * @param backend the pointer to the backend structure
+ * @param originator the object originator (namespace)
+ * @param name the object name
+ * @param type the object type
+ * @param flags a logical combination of CPL_L_* flags
+ * @param iterator the iterator to be called for each matching object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK or an error code
+ */
+extern "C" cpl_return_t
+cpl_odbc_lookup_object_ext(struct _cpl_db_backend_t* backend,
+						   const char* originator,
+						   const char* name,
+						   const char* type,
+						   const int flags,
+						   cpl_id_timestamp_iterator_t iterator,
+						   void* context)
+{
+	assert(backend != NULL);
+	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+
+	SQL_START;
+
+	cpl_return_t r = CPL_E_INTERNAL_ERROR;
+	cpl_id_timestamp_t entry;
+	std::list<cpl_id_timestamp_t> entries;
+	SQL_TIMESTAMP_STRUCT t;
+
+	mutex_lock(odbc->lookup_object_ext_lock);
+
+
+	// Prepare the statement
+
+retry:
+	SQLHSTMT stmt = odbc->lookup_object_ext_stmt;
+
+	SQL_BIND_VARCHAR(stmt, 1, 255, originator);
+	SQL_BIND_VARCHAR(stmt, 2, 255, name);
+	SQL_BIND_VARCHAR(stmt, 3, 100, type);
+
+
+	// Execute
+	
+	SQL_EXECUTE(stmt);
+
+
+	// Bind the columns
+
+	ret = SQLBindCol(stmt, 1, SQL_C_UBIGINT, &entry.id.hi, 0, NULL);
+	if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+	ret = SQLBindCol(stmt, 2, SQL_C_UBIGINT, &entry.id.lo, 0, NULL);
+	if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+	ret = SQLBindCol(stmt, 3, SQL_C_TYPE_TIMESTAMP, &t, sizeof(t), NULL);
+	if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+
+	// Fetch the result
+
+	while (true) {
+
+		ret = SQLFetch(stmt);
+		if (!SQL_SUCCEEDED(ret)) {
+			if (ret != SQL_NO_DATA) {
+				print_odbc_error("SQLFetch", stmt, SQL_HANDLE_STMT);
+				goto err_close;
+			}
+			break;
+		}
+
+		entry.timestamp = cpl_sql_timestamp_to_unix_time(t);
+		entries.push_back(entry);
+	}
+	
+	ret = SQLCloseCursor(stmt);
+	if (!SQL_SUCCEEDED(ret)) {
+		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
+		goto err;
+	}
+
+
+	// Unlock
+
+	mutex_unlock(odbc->lookup_object_ext_lock);
+
+
+	// If we did not get any data back, terminate
+
+	if (entries.empty()) return CPL_E_NOT_FOUND;
+
+
+	// Call the user-provided callback function
+
+	if (iterator != NULL) {
+		std::list<cpl_id_timestamp_t>::iterator i;
+		for (i = entries.begin(); i != entries.end(); i++) {
+			r = iterator(i->id, i->timestamp, context);
+			if (!CPL_IS_OK(r)) return r;
+		}
+	}
+
+	return CPL_OK;
+
+
+	// Error handling
+
+err_close:
+	ret = SQLCloseCursor(stmt);
+	if (!SQL_SUCCEEDED(ret)) {
+		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
+	}
+
+err:
+	mutex_unlock(odbc->lookup_object_ext_lock);
+	return CPL_E_STATEMENT_ERROR;
+}
+
+
+/**
+ * Create a new version of the given object
+ *
+ * @param backend the pointer to the backend structure
+ * @param object_id the object ID
+ * @param version the new version of the object
+ * @param session the session ID responsible for this provenance record
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+cpl_odbc_create_version(struct _cpl_db_backend_t* backend,
+						const cpl_id_t object_id,
+						const cpl_version_t version,
+						const cpl_session_t session)
+{
+	assert(backend != NULL);
+	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+
+	if (odbc->has_closure) {
+		return cpl_odbc_create_version_with_closure(odbc, object_id, version,
+													session);
+	}
+	
+	SQLRETURN ret;
+
+	mutex_lock(odbc->create_version_lock);
+
+
+	// Prepare the statement
+
+	SQLHSTMT stmt = odbc->create_version_stmt;
+	SQL_BIND_INTEGER(stmt, 1, object_id.hi);
+	SQL_BIND_INTEGER(stmt, 2, object_id.lo);
+	SQL_BIND_INTEGER(stmt, 3, version);
+	SQL_BIND_INTEGER(stmt, 4, session.hi);
+	SQL_BIND_INTEGER(stmt, 5, session.lo);
+
+
+	// Execute
+	
+	ret = SQLExecute(stmt);
+	if (!SQL_SUCCEEDED(ret)) {
+		
+		SQLINTEGER native;
+		SQLCHAR	state[ 7 ];
+		SQLCHAR	text[256];
+		SQLSMALLINT	len;
+
+		ret = SQLGetDiagRec(SQL_HANDLE_STMT, stmt, 1, state, &native,
+							text, sizeof(text), &len);
+		
+		if (SQL_SUCCEEDED(ret)) {
+			if (strcmp((const char*) state, "23000") == 0) {
+				mutex_unlock(odbc->create_version_lock);
+				return CPL_E_ALREADY_EXISTS;
+			}
+			else {
+				print_odbc_error("SQLExecute", stmt, SQL_HANDLE_STMT);
+			}
+		}
+		else if (ret != SQL_NO_DATA) {
+			fprintf(stderr, "  SQLGetDiagRec failed with error code %ld\n",
+					(long) ret);
+		}
+
+		goto err;
+	}
+
+
+	// Cleanup
+
+	mutex_unlock(odbc->create_version_lock);
+	return CPL_OK;
+
+
+	// Error handling
+
+err:
+	mutex_unlock(odbc->create_version_lock);
+	return CPL_E_STATEMENT_ERROR;
+}
+
+
+/**
+ * Determine the version of the object
+ *
+ * @param backend the pointer to the backend structure
+ * @param id the object ID
+ * @param out_version the pointer to store the version of the object
+ * @return CPL_OK or an error code
+ */
+extern "C" cpl_return_t
+cpl_odbc_get_version(struct _cpl_db_backend_t* backend,
+					 const cpl_id_t id,
+					 cpl_version_t* out_version)
+{
+	assert(backend != NULL);
+	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+	
+	SQL_START;
+
+	long long l;
+	cpl_return_t r;
+
+	mutex_lock(odbc->get_version_lock);
+
+
+	// Prepare the statement
+
+retry:
+	SQLHSTMT stmt = odbc->get_version_stmt;
+	SQL_BIND_INTEGER(stmt, 1, id.hi);
+	SQL_BIND_INTEGER(stmt, 2, id.lo);
+
+
+	// Execute
+	
+	SQL_EXECUTE(stmt);
+
+
+	// Fetch the result
+
+	r = cpl_sql_fetch_single_llong(stmt, &l);
+	if (!CPL_IS_OK(r)) {
+		mutex_unlock(odbc->get_version_lock);
+		return r;
+	}
+
+
+	// Cleanup
+
+	mutex_unlock(odbc->get_version_lock);
+
+	if (out_version != NULL) *out_version = (cpl_version_t) l;
+	return CPL_OK;
+
+
+	// Error handling
+
+err:
+	mutex_unlock(odbc->get_version_lock);
+	return CPL_E_STATEMENT_ERROR;
+}
+
+
+/**
+ * Add an ancestry edge
+ *
+ * @param backend the pointer to the backend structure
+ * @param from_id the edge source ID
+ * @param from_ver the edge source version
+ * @param to_id the edge destination ID
+ * @param to_ver the edge destination version
+ * @param type the data or control dependency type
+ * @return the error code
+ */
+extern "C" cpl_return_t
+cpl_odbc_add_ancestry_edge(struct _cpl_db_backend_t* backend,
+						   const cpl_id_t from_id,
+						   const cpl_version_t from_ver,
+						   const cpl_id_t to_id,
+						   const cpl_version_t to_ver,
+						   const int type)
+{
+	assert(backend != NULL);
+	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+
+	if (odbc->has_closure) {
+		return cpl_odbc_add_ancestry_edge_with_closure(odbc, from_id, from_ver,
+													   to_id, to_ver, type);
+	}
+
+	mutex_lock(odbc->add_ancestry_edge_lock);
+
+
+	// Prepare the statement
+
+	SQL_START;
+
+retry:
+	SQLHSTMT stmt = odbc->add_ancestry_edge_stmt;
+
+	SQL_BIND_INTEGER(stmt, 1, from_id.hi);
+	SQL_BIND_INTEGER(stmt, 2, from_id.lo);
+	SQL_BIND_INTEGER(stmt, 3, from_ver);
+	SQL_BIND_INTEGER(stmt, 4, to_id.hi);
+	SQL_BIND_INTEGER(stmt, 5, to_id.lo);
+	SQL_BIND_INTEGER(stmt, 6, to_ver);
+	SQL_BIND_INTEGER(stmt, 7, type);
+
+
+	// Execute
+	
+	SQL_EXECUTE(stmt);
+
+
+	// Cleanup
+
+	mutex_unlock(odbc->add_ancestry_edge_lock);
+	return CPL_OK;
+
+
+	// Error handling
+
+err:
+	mutex_unlock(odbc->add_ancestry_edge_lock);
+	return CPL_E_STATEMENT_ERROR;
+}
+
+
+/**
+ * Determine whether the given object has the given ancestor
+ *
+ * @param backend the pointer to the backend structure
+ * @param object_id the object ID
+ * @param version_hint the object version (if known), or CPL_VERSION_NONE
+ *                     otherwise
+ * @param query_object_id the object that we want to determine whether it
+ *                        is one of the immediate ancestors
+ * @param query_object_max_version the maximum version of the query
+ *                                 object to consider
+ * @param out the pointer to store a positive number if yes, or 0 if no
+ * @return CPL_OK or an error code
+ */
+extern "C" cpl_return_t
+cpl_odbc_has_immediate_ancestor(struct _cpl_db_backend_t* backend,
+								const cpl_id_t object_id,
+								const cpl_version_t version_hint,
+								const cpl_id_t query_object_id,
+								const cpl_version_t query_object_max_version,
+								int* out)
+{
+	assert(backend != NULL);
+	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+	
+	SQL_START;
+
+	cpl_return_t r = CPL_E_INTERNAL_ERROR;
+	int cr = CPL_E_INTERNAL_ERROR;
+
+	mutex_lock(odbc->has_immediate_ancestor_lock);
+
+
+	// Prepare the statement
+
+retry:
+	SQLHSTMT stmt = version_hint == CPL_VERSION_NONE 
+		? odbc->has_immediate_ancestor_stmt
+		: odbc->has_immediate_ancestor_with_ver_stmt;
+	SQL_BIND_INTEGER(stmt, 1, query_object_id.hi);
+	SQL_BIND_INTEGER(stmt, 2, query_object_id.lo);
+	SQL_BIND_INTEGER(stmt, 3, query_object_max_version);
+	SQL_BIND_INTEGER(stmt, 4, object_id.hi);
+	SQL_BIND_INTEGER(stmt, 5, object_id.lo);
+	if (version_hint != CPL_VERSION_NONE) {
+		SQL_BIND_INTEGER(stmt, 6, version_hint);
+	}
+
+
+	// Execute
+	
+	SQL_EXECUTE(stmt);
+
+
+	// Fetch the data
+
+	r = cpl_sql_fetch_single_llong(stmt, NULL);
+	if (CPL_IS_OK(r)) cr = 1;
+	if (r == CPL_E_NOT_FOUND) { r = CPL_OK; cr = 0; }
+	if (!CPL_IS_OK(r)) {
+		mutex_unlock(odbc->has_immediate_ancestor_lock);
+		return r;
+	}
+
+
+	// Cleanup
+
+	mutex_unlock(odbc->has_immediate_ancestor_lock);
+
+	if (out != NULL) *out = cr;
+	return CPL_OK;
+
+
+	// Error handling
+
+err:
+	mutex_unlock(odbc->has_immediate_ancestor_lock);
+	return CPL_E_STATEMENT_ERROR;
+}
+
+
+/**
+ * Add a property to the given object
+ *
+ * @param backend the pointer to the backend structure
+ * @param id the object ID
+ * @param version the version number
+ * @param key the key
+ * @param value the value
+ * @return CPL_OK or an error code
+ */
+extern "C" cpl_return_t
+cpl_odbc_add_property(struct _cpl_db_backend_t* backend,
+                      const cpl_id_t id,
+                      const cpl_version_t version,
+                      const char* key,
+                      const char* value)
+{
+    assert(backend != NULL);
+    cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+
+	mutex_lock(odbc->add_property_lock);
+
+
+	// Prepare the statement
+
+	SQL_START;
+
+retry:
+	SQLHSTMT stmt = odbc->add_property_stmt;
+
+	SQL_BIND_INTEGER(stmt, 1, id.hi);
+	SQL_BIND_INTEGER(stmt, 2, id.lo);
+	SQL_BIND_INTEGER(stmt, 3, version);
+	SQL_BIND_VARCHAR(stmt, 4, 255, key);
+	SQL_BIND_VARCHAR(stmt, 5, 4095, value);
+
+
+	// Execute
+	
+	SQL_EXECUTE(stmt);
+
+
+	// Cleanup
+
+	mutex_unlock(odbc->add_property_lock);
+	return CPL_OK;
+
+
+	// Error handling
+
+err:
+	mutex_unlock(odbc->add_property_lock);
+	return CPL_E_STATEMENT_ERROR;
+}
+
+
+/**
+ * Get information about the given provenance session.
+ *
+ * @param backend the pointer to the backend structure
+ * @param id the session ID
+ * @param out_info the pointer to store the session info structure
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+cpl_odbc_get_session_info(struct _cpl_db_backend_t* backend,
+						  const cpl_session_t id,
+						  cpl_session_info_t** out_info)
+{
+	assert(backend != NULL);
+	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+
+	SQL_START;
+
+	cpl_return_t r = CPL_E_INTERNAL_ERROR;
+	long long l = 0;
+
+	cpl_session_info_t* p = (cpl_session_info_t*) malloc(sizeof(*p));
+	if (p == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
+	memset(p, 0, sizeof(*p));
+	p->id = id;
+
+
+	// Prepare the statement
+
+	mutex_lock(odbc->get_session_info_lock);
+
+retry:
+	SQLHSTMT stmt = odbc->get_session_info_stmt;
+
+	SQL_BIND_INTEGER(stmt, 1, id.hi);
+	SQL_BIND_INTEGER(stmt, 2, id.lo);
+
+
+	// Execute
+	
+	SQL_EXECUTE(stmt);
+
+
+	// Fetch the result
+
+	CPL_SQL_SIMPLE_FETCH(dynamically_allocated_string, 1, &p->mac_address);
+	CPL_SQL_SIMPLE_FETCH(dynamically_allocated_string, 2, &p->user);
+	CPL_SQL_SIMPLE_FETCH(llong, 3, &l); p->pid = (int) l;
+	CPL_SQL_SIMPLE_FETCH(dynamically_allocated_string, 4, &p->program);
+	CPL_SQL_SIMPLE_FETCH(dynamically_allocated_string, 5, &p->cmdline);
+	CPL_SQL_SIMPLE_FETCH(timestamp_as_unix_time, 6, &p->start_time);
+
+	ret = SQLCloseCursor(stmt);
+	if (!SQL_SUCCEEDED(ret)) {
+		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
+		goto err;
+	}
+
+
+	// Cleanup
+
+	mutex_unlock(odbc->get_session_info_lock);
+	
+	*out_info = p;
+	return CPL_OK;
+
+
+	// Error handling
+
+err:
+	r = CPL_E_STATEMENT_ERROR;
+
+err_r:
+	mutex_unlock(odbc->get_session_info_lock);
+
+	if (p->mac_address != NULL) free(p->mac_address);
+	if (p->user != NULL) free(p->user);
+	if (p->program != NULL) free(p->program);
+	if (p->cmdline != NULL) free(p->cmdline);
+	free(p);
+
+	return r;
+}
+
+/**
+ * Get information about several provenance sessions at once, fetching up
+ * to CPL_ODBC_BATCH_SIZE sessions per query.
+ *
+ * @param backend the pointer to the backend structure
+ * @param ids the array of unique session IDs
+ * @param count the number of session IDs
+ * @param out_infos the array of count pointers to store the session info
+ *                  structures
+ * @return CPL_OK, CPL_E_NOT_FOUND if any of the sessions does not exist,
+ *         or an error code
+ */
+cpl_return_t
+cpl_odbc_get_session_info_batch(struct _cpl_db_backend_t* backend,
+								const cpl_session_t* ids,
+								const size_t count,
+								cpl_session_info_t** out_infos)
+{
+	assert(backend != NULL);
+	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+
+	SQL_START;
+
+	cpl_return_t r = CPL_E_INTERNAL_ERROR;
+	long long l = 0;
+	cpl_session_t id;
+	cpl_session_info_t* p = NULL;
+	size_t found = 0;
+	size_t start = 0;
+
+	std::map<cpl_session_t, size_t> index;
+	for (size_t i = 0; i < count; i++) {
+		index[ids[i]] = i;
+		out_infos[i] = NULL;
+	}
+
+	SQLHSTMT stmt = odbc->get_session_info_batch_stmt;
+
+	mutex_lock(odbc->get_session_info_lock);
+
+
+	// Run one query per CPL_ODBC_BATCH_SIZE sessions, padding the last batch
+	// by repeating its last session
+
+	for (start = 0; start < count; start += CPL_ODBC_BATCH_SIZE) {
+
+retry:
+		for (int i = 0; i < CPL_ODBC_BATCH_SIZE; i++) {
+			size_t k = start + i < count ? start + i : count - 1;
+			SQL_BIND_INTEGER(stmt, 2 * i + 1, ids[k].hi);
+			SQL_BIND_INTEGER(stmt, 2 * i + 2, ids[k].lo);
+		}
+
+
+		// Execute
+
+		SQL_EXECUTE(stmt);
+
+
+		// Fetch the result
+
+		while (true) {
+
+			r = cpl_sql_fetch_single_llong(stmt, (long long*) &id.hi, 1,
+										   true, false);
+			if (r == CPL_E_NOT_FOUND) break;
+			if (!CPL_IS_OK(r)) goto err_r;
+			CPL_SQL_SIMPLE_FETCH(llong, 2, (long long*) &id.lo);
+
+			p = (cpl_session_info_t*) malloc(sizeof(*p));
+			if (p == NULL) {
+				r = CPL_E_INSUFFICIENT_RESOURCES;
+				SQLCloseCursor(stmt);
+				goto err_r;
+			}
+			memset(p, 0, sizeof(*p));
+			p->id = id;
+
+			CPL_SQL_SIMPLE_FETCH(dynamically_allocated_string, 3,
+								 &p->mac_address);
+			CPL_SQL_SIMPLE_FETCH(dynamically_allocated_string, 4, &p->user);
+			CPL_SQL_SIMPLE_FETCH(llong, 5, &l); p->pid = (int) l;
+			CPL_SQL_SIMPLE_FETCH(dynamically_allocated_string, 6,
+								 &p->program);
+			CPL_SQL_SIMPLE_FETCH(dynamically_allocated_string, 7,
+								 &p->cmdline);
+			CPL_SQL_SIMPLE_FETCH(timestamp_as_unix_time, 8, &p->start_time);
+
+			std::map<cpl_session_t, size_t>::iterator k = index.find(id);
+			if (k != index.end() && out_infos[k->second] == NULL) {
+				out_infos[k->second] = p;
+				found++;
+			}
+			else {
+				cpl_odbc_free_session_info(p);
+			}
+			p = NULL;
+		}
+	}
+
+
+	// Cleanup
+
+	mutex_unlock(odbc->get_session_info_lock);
+
+	if (found < count) {
+		r = CPL_E_NOT_FOUND;
+		goto err_free;
+	}
+
+	return CPL_OK;
+
+
+	// Error handling
+
+err:
+	r = CPL_E_STATEMENT_ERROR;
+
+err_r:
+	mutex_unlock(odbc->get_session_info_lock);
+	if (p != NULL) cpl_odbc_free_session_info(p);
+
+err_free:
+	for (size_t i = 0; i < count; i++) {
+		if (out_infos[i] != NULL) {
+			cpl_odbc_free_session_info(out_infos[i]);
+			out_infos[i] = NULL;
+		}
+	}
+
+	return r;
+}
+
+
+
+/**
+ * Get all objects in the database
+ *
+ * @param backend the pointer to the backend structure
+ * @param flags a logical combination of CPL_I_* flags
+ * @param iterator the iterator to be called for each matching object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+cpl_odbc_get_all_objects(struct _cpl_db_backend_t* backend,
+						 const int flags,
+						 cpl_object_info_iterator_t iterator,
+						 void* context)
+{
+	assert(backend != NULL);
+	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+
+	SQL_START;
+
+	cpl_return_t r = CPL_E_INTERNAL_ERROR;
+	cplxx_object_info_t entry;
+	std::list<cplxx_object_info_t> entries;
+	SQL_TIMESTAMP_STRUCT t;
+
+	size_t originator_size = 4096;
+	size_t name_size = 4096;
+	size_t type_size = 256;
+
+	char* entry_originator = (char*) alloca(originator_size);
+	char* entry_name = (char*) alloca(name_size);
+	char* entry_type = (char*) alloca(type_size);
+
+	if (entry_originator == NULL || entry_name == NULL || entry_type == NULL) {
+		return CPL_E_INSUFFICIENT_RESOURCES;
+	}
+
+	SQLLEN cb_container_id_lo = 0;
+	SQLLEN cb_container_id_hi = 0;
+	SQLLEN cb_container_ver = 0;
+
+	mutex_lock(odbc->get_all_objects_lock);
+
+
+	// Get and execute the statement
+	
+retry:
+
+	entries.clear();
+
+	SQLHSTMT stmt = ((flags & CPL_I_NO_CREATION_SESSION) != 0)
+						? odbc->get_all_objects_stmt
+						: odbc->get_all_objects_with_session_stmt;
+
+
+	// Execute
+	
+	SQL_EXECUTE(stmt);
+
+
+	// Bind the columns
+
+	ret = SQLBindCol(stmt, 1, SQL_C_UBIGINT, &entry.id.hi, 0, NULL);
+	if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+	ret = SQLBindCol(stmt, 2, SQL_C_UBIGINT, &entry.id.lo, 0, NULL);
+	if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+	ret = SQLBindCol(stmt, 3, SQL_C_TYPE_TIMESTAMP, &t, sizeof(t), NULL);
+	if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+	ret = SQLBindCol(stmt, 4, SQL_C_CHAR, entry_originator, originator_size,
+					 NULL);
+	if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+	ret = SQLBindCol(stmt, 5, SQL_C_CHAR, entry_name, name_size, NULL);
+	if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+	ret = SQLBindCol(stmt, 6, SQL_C_CHAR, entry_type, type_size, NULL);
+	if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+    ret = SQLBindCol(stmt, 7, SQL_C_UBIGINT, &entry.container_id.hi, 0,
+                     &cb_container_id_lo);
+    if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+    ret = SQLBindCol(stmt, 8, SQL_C_UBIGINT, &entry.container_id.lo, 0,
+                     &cb_container_id_hi);
+    if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+    ret = SQLBindCol(stmt, 9, SQL_C_SBIGINT, &entry.container_version, 0,
+                     &cb_container_ver);
+    if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+
+	if ((flags & CPL_I_NO_CREATION_SESSION) == 0) {
+
+		ret = SQLBindCol(stmt, 10, SQL_C_UBIGINT, &entry.creation_session.hi,0,
+						 &cb_container_id_lo);
+		if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+		ret = SQLBindCol(stmt, 11, SQL_C_UBIGINT, &entry.creation_session.lo,0,
+						 &cb_container_id_hi);
+		if (!SQL_SUCCEEDED(ret)) goto err_close;
+	}
+    else {
+        
+        entry.creation_session = CPL_NONE;
+    }
+
+    entry.version = CPL_VERSION_NONE;
+
+
+	// Fetch the result
+
+	while (true) {
+
+		ret = SQLFetch(stmt);
+		if (!SQL_SUCCEEDED(ret)) {
+			if (ret == SQL_INVALID_HANDLE) {
+				fprintf(stderr, "\nThe ODBC driver failed while running "
+								"SQLFetch due to SQL_INVALID_HANDLE\n\n");
+				goto err_close;
+			}
+			else if (ret != SQL_NO_DATA) {
+				print_odbc_error("SQLFetch", stmt, SQL_HANDLE_STMT);
+				goto err_close;
+			}
+			break;
+		}
 
-	// Check the DSN
+		entry.creation_time = cpl_sql_timestamp_to_unix_time(t);
+		entry.originator = entry_originator;
+		entry.name = entry_name;
+		entry.type = entry_type;
 
-	if (strchr(dsn, ';') != NULL
-			|| strchr(dsn, '{') != NULL
-			|| strchr(dsn, '}') != NULL) {
-		return CPL_E_INVALID_ARGUMENT;
-	}
+		if (cb_container_id_lo <= 0) entry.container_id = CPL_NONE;
+		if (cb_container_id_hi <= 0) entry.container_id = CPL_NONE;
+		if (cb_container_ver   <= 0) entry.container_version =CPL_VERSION_NONE;
 
+		entries.push_back(entry);
+	}
+	
+	ret = SQLCloseCursor(stmt);
+	if (!SQL_SUCCEEDED(ret)) {
+		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
+		goto err;
+	}
 
-	// Create the connection string
 
-	std::string conn = "DSN=";
-	conn += dsn;
-	conn += ";";
+	// Unlock
 
+	mutex_unlock(odbc->get_all_objects_lock);
 
-	// Create the backend
-	
-	return cpl_create_odbc_backend(conn.c_str(), db_type, out);
-}
 
+	// If we did not get any data back, terminate
 
-/**
- * Destructor. If the constructor allocated the backend structure, it
- * should be freed by this function
- *
- * @param backend the pointer to the backend structure
- * @param the error code
- */
-extern "C" cpl_return_t
-cpl_odbc_destroy(struct _cpl_db_backend_t* backend)
-{
-	assert(backend != NULL);
-	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+	if (entries.empty()) return CPL_S_NO_DATA;
 
-	cpl_return_t r = cpl_odbc_disconnect(odbc);
-	if (!CPL_IS_OK(r)) {
-		fprintf(stderr, "Warning: Could not terminate the ODBC connection.\n");
-	}
 
-	mutex_destroy(odbc->create_session_lock);
-	mutex_destroy(odbc->create_object_lock);
-	mutex_destroy(odbc->lookup_object_lock);
-	mutex_destroy(odbc->lookup_object_ext_lock);
-	mutex_destroy(odbc->create_version_lock);
-	mutex_destroy(odbc->get_version_lock);
-	mutex_destroy(odbc->add_ancestry_edge_lock);
-	mutex_destroy(odbc->has_immediate_ancestor_lock);
-	mutex_destroy(odbc->add_property_lock);
-	mutex_destroy(odbc->get_session_info_lock);
-	mutex_destroy(odbc->get_all_objects_lock);
-	mutex_destroy(odbc->get_object_info_lock);
-	mutex_destroy(odbc->get_version_info_lock);
-	mutex_destroy(odbc->get_object_ancestry_lock);
-	mutex_destroy(odbc->get_properties_lock);
-	mutex_destroy(odbc->lookup_by_property_lock);
-	
-	delete odbc;
-	
-	return CPL_OK;
-}
+	// Call the user-provided callback function
 
+	if (iterator != NULL) {
+		std::list<cplxx_object_info_t>::iterator i;
+		for (i = entries.begin(); i != entries.end(); i++) {
 
+#ifdef _WINDOWS
+			strcpy_s(entry_originator, originator_size, i->originator.c_str());
+			strcpy_s(entry_name, name_size, i->name.c_str());
+			strcpy_s(entry_type, type_size, i->type.c_str());
+#else
+			strncpy(entry_originator, i->originator.c_str(), originator_size);
+			strncpy(entry_name, i->name.c_str(), name_size);
+			strncpy(entry_type, i->type.c_str(), type_size);
+#endif
+			entry_originator[originator_size - 1] = '\0';
+			entry_name[name_size - 1] = '\0';
+			entry_type[type_size - 1] = '\0';
 
-/***************************************************************************/
-/** Helpers for Binding                                                   **/
-/***************************************************************************/
+			cpl_version_t version = CPL_VERSION_NONE;
+			if ((flags & CPL_I_NO_VERSION) == 0) {
+				cpl_return_t r = cpl_odbc_get_version(backend, i->id,&version);
+				if (!CPL_IS_OK(r)) return r;
+			}
 
+			cpl_object_info_t e;
+			e.id = i->id;
+			e.version = version;
+			e.creation_session = i->creation_session;
+			e.creation_time = i->creation_time;
+			e.originator = entry_originator;
+			e.name = entry_name;
+			e.type = entry_type;
+			e.container_id = i->container_id;
+			e.container_version = i->container_version;
 
-/**
- * Bind a VARCHAR parameter. Jump to "err" on error. Variable "ret" must be
- * already defined.
- *
- * @param stmt the statement
- * @param arg the argument number
- * @param size the VARCHAR size
- * @param value the char* value
- */
-#define SQL_BIND_VARCHAR(stmt, arg, size, value) { \
-	SQLLEN* cb = (SQLLEN*) alloca(sizeof(SQLLEN)); \
-	*cb = (value) == NULL ? SQL_NULL_DATA : SQL_NTS; \
-	ret = SQLBindParameter(stmt, arg, SQL_PARAM_INPUT, \
-			SQL_C_CHAR, SQL_VARCHAR, size, 0, \
-			(SQLCHAR*) (value), 0, cb); \
-	SQL_ASSERT_NO_ERROR(SQLBindParameter, stmt, err); \
-}
+			r = iterator(&e, context);
+			if (!CPL_IS_OK(r)) return r;
+		}
+	}
 
+	return CPL_OK;
 
-/**
- * Bind an INTEGER parameter. Jump to "err" on error. Variable "ret" must be
- * already defined.
- *
- * @param stmt the statement
- * @param arg the argument number
- * @param value the int value
- */
-#define SQL_BIND_INTEGER(stmt, arg, value) { \
-	long long* __p = (long long*) alloca(sizeof(long long)); \
-	*__p = (long long) value; \
-	ret = SQLBindParameter(stmt, arg, SQL_PARAM_INPUT, \
-			SQL_C_SBIGINT, SQL_INTEGER, 0, 0, \
-			(void*) __p, 0, NULL); \
-	SQL_ASSERT_NO_ERROR(SQLBindParameter, stmt, err); \
-}
 
+	// Error handling
 
+err_close:
+	ret = SQLCloseCursor(stmt);
+	if (!SQL_SUCCEEDED(ret)) {
+		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
+	}
 
-/***************************************************************************/
-/** Public API                                                            **/
-/***************************************************************************/
+err:
+	mutex_unlock(odbc->get_all_objects_lock);
+	return CPL_E_STATEMENT_ERROR;
+}
 
 
 /**
- * Create a session.
+ * Read all rows of an executed statement that returns object information
+ * in the columns id_hi, id_lo, creation_time, originator, name, type,
+ * container_id_hi, container_id_lo, container_ver, session_id_hi, and
+ * session_id_lo, and append them to a list. The cursor is closed at the
+ * end, or on error.
  *
- * @param backend the pointer to the backend structure
- * @param session the session ID to use
- * @param mac_address human-readable MAC address (NULL if not available)
- * @param user the user name
- * @param pid the process ID
- * @param program the program name
- * @param cmdline the command line
+ * @param stmt the executed statement
+ * @param out the list to which to append the newly allocated object info
+ *            structures
  * @return CPL_OK or an error code
  */
-extern "C" cpl_return_t
-cpl_odbc_create_session(struct _cpl_db_backend_t* backend,
-						const cpl_session_t session,
-						const char* mac_address,
-						const char* user,
-						const int pid,
-						const char* program,
-						const char* cmdline)
+static cpl_return_t
+cpl_odbc_fetch_object_info_list(SQLHSTMT stmt,
+								std::list<cpl_object_info_t*>& out)
 {
-	assert(backend != NULL && user != NULL && program != NULL && cmdline!=NULL);
-	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
-
-	mutex_lock(odbc->create_session_lock);
-
-	
-	// Bind the statement parameters
+	cpl_return_t r = CPL_E_INTERNAL_ERROR;
+	cpl_object_info_t* p = NULL;
+	long long l = 0;
 
-	SQL_START;
+	while (true) {
 
-retry:
-	SQLHSTMT stmt = odbc->create_session_insert_stmt;
+		p = (cpl_object_info_t*) malloc(sizeof(*p));
+		if (p == NULL) {
+			r = CPL_E_INSUFFICIENT_RESOURCES;
+			SQLCloseCursor(stmt);
+			goto err_r;
+		}
+		memset(p, 0, sizeof(*p));
 
-	SQL_BIND_INTEGER(stmt, 1, session.hi);
-	SQL_BIND_INTEGER(stmt, 2, session.lo);
-	SQL_BIND_VARCHAR(stmt, 3, 18, mac_address);
-	SQL_BIND_VARCHAR(stmt, 4, 255, user);
-	SQL_BIND_INTEGER(stmt, 5, pid);
-	SQL_BIND_VARCHAR(stmt, 6, 4095, program);
-	SQL_BIND_VARCHAR(stmt, 7, 4095, cmdline);
+		r = cpl_sql_fetch_single_llong(stmt, (long long*) &p->id.hi, 1,
+									   true, false);
+		if (r == CPL_E_NOT_FOUND) break;
+		if (!CPL_IS_OK(r)) goto err_r;
+		CPL_SQL_SIMPLE_FETCH(llong, 2, (long long*) &p->id.lo);
+		CPL_SQL_SIMPLE_FETCH(timestamp_as_unix_time, 3, &p->creation_time);
 
+		CPL_SQL_SIMPLE_FETCH_EXT(dynamically_allocated_string, 4,
+								 &p->originator, true);
+#ifdef _WINDOWS
+		if (r == CPL_E_DB_NULL) p->originator = _strdup("");
+#else
+		if (r == CPL_E_DB_NULL) p->originator = strdup("");
+#endif
+		CPL_SQL_SIMPLE_FETCH_EXT(dynamically_allocated_string, 5,
+								 &p->name, true);
+#ifdef _WINDOWS
+		if (r == CPL_E_DB_NULL) p->name = _strdup("");
+#else
+		if (r == CPL_E_DB_NULL) p->name = strdup("");
+#endif
+		CPL_SQL_SIMPLE_FETCH_EXT(dynamically_allocated_string, 6,
+								 &p->type, true);
+#ifdef _WINDOWS
+		if (r == CPL_E_DB_NULL) p->type = _strdup("");
+#else
+		if (r == CPL_E_DB_NULL) p->type = strdup("");
+#endif
 
-	// Insert the new row to the sessions table
+		CPL_SQL_SIMPLE_FETCH_EXT(llong, 7,
+								 (long long*) &p->container_id.hi, true);
+		if (r == CPL_E_DB_NULL) p->container_id = CPL_NONE;
+		CPL_SQL_SIMPLE_FETCH_EXT(llong, 8,
+								 (long long*) &p->container_id.lo, true);
+		if (r == CPL_E_DB_NULL) p->container_id = CPL_NONE;
+		CPL_SQL_SIMPLE_FETCH_EXT(llong, 9, &l, true);
+		if (r == CPL_E_DB_NULL) l = CPL_VERSION_NONE;
+		p->container_version = (cpl_version_t) l;
 
-	SQL_EXECUTE(stmt);
+		CPL_SQL_SIMPLE_FETCH(llong, 10, (long long*) &p->creation_session.hi);
+		CPL_SQL_SIMPLE_FETCH(llong, 11, (long long*) &p->creation_session.lo);
 
+		p->version = CPL_VERSION_NONE;
 
-	// Finish
+		out.push_back(p);
+		p = NULL;
+	}
 
-	mutex_unlock(odbc->create_session_lock);
+	free(p);
 	return CPL_OK;
 
 
 	// Error handling
 
-err:
-	mutex_unlock(odbc->create_session_lock);
-	return CPL_E_STATEMENT_ERROR;
+err_r:
+	if (p != NULL) cpl_odbc_free_object_info(p);
+	return r;
 }
 
 
 /**
- * Create an object.
+ * Call the iterator for each object in the list, after looking up its
+ * current version (unless CPL_I_NO_VERSION is set), and free the list
  *
  * @param backend the pointer to the backend structure
- * @param id the ID of the new object
- * @param originator the originator
- * @param name the object name
- * @param type the object type
- * @param container the ID of the object that should contain this object
- *                  (use CPL_NONE for no container)
- * @param container_version the version of the container (if not CPL_NONE)
- * @param session the session ID responsible for this provenance record
+ * @param entries the list of object info structures
+ * @param flags a logical combination of CPL_I_* flags
+ * @param iterator the iterator
+ * @param context the caller-provided iterator context
  * @return CPL_OK or an error code
  */
-extern "C" cpl_return_t
-cpl_odbc_create_object(struct _cpl_db_backend_t* backend,
-					   const cpl_id_t id,
-					   const char* originator,
-					   const char* name,
-					   const char* type,
-					   const cpl_id_t container,
-					   const cpl_version_t container_version,
-					   const cpl_session_t session)
+static cpl_return_t
+cpl_odbc_iterate_object_info_list(struct _cpl_db_backend_t* backend,
+								  std::list<cpl_object_info_t*>& entries,
+								  const int flags,
+								  cpl_object_info_iterator_t iterator,
+								  void* context)
 {
-	assert(backend != NULL && originator != NULL
-			&& name != NULL && type != NULL);
-	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
-	
-	mutex_lock(odbc->create_object_lock);
+	cpl_return_t r = CPL_OK;
+	std::list<cpl_object_info_t*>::iterator i;
+
+	for (i = entries.begin(); CPL_IS_OK(r) && i != entries.end(); i++) {
+		if ((flags & CPL_I_NO_VERSION) == 0) {
+			r = cpl_odbc_get_version(backend, (*i)->id, &(*i)->version);
+			if (!CPL_IS_OK(r)) break;
+		}
+		r = iterator(*i, context);
+	}
+
+	for (i = entries.begin(); i != entries.end(); i++) {
+		cpl_odbc_free_object_info(*i);
+	}
+	entries.clear();
+
+	return CPL_IS_OK(r) ? CPL_OK : r;
+}
+
+
+/**
+ * Fetch the objects inside the given container and append them to a list.
+ * The caller must hold get_all_objects_lock.
+ *
+ * @param odbc the backend structure
+ * @param container the container ID
+ * @param version the container version, or CPL_VERSION_NONE for all
+ * @param recursive whether to use the recursive statement
+ * @param out the list to which to append the newly allocated object info
+ *            structures
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_odbc_fetch_contained_objects(cpl_odbc_t* odbc,
+								 const cpl_id_t container,
+								 const cpl_version_t version,
+								 bool recursive,
+								 std::list<cpl_object_info_t*>& out)
+{
+	SQL_START;
 
-	
-	// Bind the statement parameters
+	SQLHSTMT stmt;
 
-	SQL_START;
+
+	// Bind the parameters
 
 retry:
-	SQLHSTMT stmt = container == CPL_NONE
-		? odbc->create_object_insert_stmt
-		: odbc->create_object_insert_container_stmt;
 
-	SQL_BIND_INTEGER(stmt, 1, id.hi);
-	SQL_BIND_INTEGER(stmt, 2, id.lo);
-	SQL_BIND_VARCHAR(stmt, 3, 255, originator);
-	SQL_BIND_VARCHAR(stmt, 4, 255, name);
-	SQL_BIND_VARCHAR(stmt, 5, 100, type);
+	stmt = recursive
+		? odbc->get_contained_objects_recursive_stmt
+		: odbc->get_contained_objects_stmt;
 
-	if (container != CPL_NONE) {
-		SQL_BIND_INTEGER(stmt, 6, container.hi);
-		SQL_BIND_INTEGER(stmt, 7, container.lo);
-		SQL_BIND_INTEGER(stmt, 8, container_version);
-	}
+	SQL_BIND_INTEGER(stmt, 1, container.hi);
+	SQL_BIND_INTEGER(stmt, 2, container.lo);
+	SQL_BIND_INTEGER(stmt, 3, version);
+	SQL_BIND_INTEGER(stmt, 4, version);
 
 
-	// Insert the new row to the objects table
+	// Execute and fetch the result
 
 	SQL_EXECUTE(stmt);
 
+	return cpl_odbc_fetch_object_info_list(stmt, out);
 
-	// Insert the corresponding entry to the versions table
 
-retry2:
-	stmt = odbc->create_object_insert_version_stmt;
-	SQL_BIND_INTEGER(stmt, 1, id.hi);
-	SQL_BIND_INTEGER(stmt, 2, id.lo);
-	SQL_BIND_INTEGER(stmt, 3, session.hi);
-	SQL_BIND_INTEGER(stmt, 4, session.lo);
+	// Error handling
 
-	SQL_EXECUTE_EXT(stmt, retry2, err);
+err:
+	return CPL_E_STATEMENT_ERROR;
+}
 
-	
-	// Finish
 
-	mutex_unlock(odbc->create_object_lock);
-	return CPL_OK;
+/**
+ * Get the objects created inside the given container, optionally including
+ * the contents of the nested containers at any depth.
+ *
+ * @param backend the pointer to the backend structure
+ * @param container the container ID
+ * @param version the container version, or CPL_VERSION_NONE for all
+ *                versions of the container
+ * @param recursive whether to descend into the nested containers
+ * @param flags a logical combination of CPL_I_* flags
+ * @param iterator the iterator to be called for each contained object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+cpl_return_t
+cpl_odbc_get_contained_objects(struct _cpl_db_backend_t* backend,
+							   const cpl_id_t container,
+							   const cpl_version_t version,
+							   const int recursive,
+							   const int flags,
+							   cpl_object_info_iterator_t iterator,
+							   void* context)
+{
+	assert(backend != NULL);
+	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
 
+	cpl_return_t r = CPL_OK;
+	std::list<cpl_object_info_t*> entries;
+	std::list<cpl_object_info_t*>::iterator i;
 
-	// Error handling
+	mutex_lock(odbc->get_all_objects_lock);
 
-err:
-	mutex_unlock(odbc->create_object_lock);
-	return CPL_E_STATEMENT_ERROR;
+
+	// Fetch the contents of the container using a single query, or if the
+	// database does not support recursive queries, visit the nested
+	// containers one at a time (the list doubles as the queue of the
+	// containers to visit). If the recursive query fails, assume that the
+	// server does not support it after all, and fall back to the traversal.
+
+	if (!recursive || odbc->has_recursive_queries) {
+		r = cpl_odbc_fetch_contained_objects(odbc, container, version,
+											 recursive != 0, entries);
+		if (recursive && r == CPL_E_STATEMENT_ERROR) {
+			odbc->has_recursive_queries = false;
+			for (i = entries.begin(); i != entries.end(); i++) {
+				cpl_odbc_free_object_info(*i);
+			}
+			entries.clear();
+		}
+	}
+
+	if (recursive && !odbc->has_recursive_queries) {
+		r = cpl_odbc_fetch_contained_objects(odbc, container, version,
+											 false, entries);
+		for (i = entries.begin(); CPL_IS_OK(r) && i != entries.end(); i++) {
+			r = cpl_odbc_fetch_contained_objects(odbc, (*i)->id,
+					CPL_VERSION_NONE, false, entries);
+		}
+	}
+
+	mutex_unlock(odbc->get_all_objects_lock);
+
+	if (!CPL_IS_OK(r)) {
+		for (i = entries.begin(); i != entries.end(); i++) {
+			cpl_odbc_free_object_info(*i);
+		}
+		return r;
+	}
+
+	if (entries.empty()) return CPL_S_NO_DATA;
+
+
+	// Call the user-provided callback function
+
+	return cpl_odbc_iterate_object_info_list(backend, entries, flags,
+											 iterator, context);
 }
 
 
 /**
- * Look up an object by name. If multiple objects share the same name,
- * get the latest one.
+ * Get the objects whose names start with the given prefix, ordered by their
+ * names, optionally restricted to the given originator and type.
  *
  * @param backend the pointer to the backend structure
- * @param originator the object originator (namespace)
- * @param name the object name
- * @param type the object type
- * @param out_id the pointer to store the object ID
- * @return CPL_OK or an error code
+ * @param originator the object originator, or NULL for any
+ * @param prefix the name prefix
+ * @param type the object type, or NULL for any
+ * @param flags a logical combination of CPL_I_* flags
+ * @param iterator the iterator to be called for each matching object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
  */
-extern "C" cpl_return_t
-cpl_odbc_lookup_object(struct _cpl_db_backend_t* backend,
-					   const char* originator,
-					   const char* name,
-					   const char* type,
-					   cpl_id_t* out_id)
+cpl_return_t
+cpl_odbc_lookup_by_name_prefix(struct _cpl_db_backend_t* backend,
+							   const char* originator,
+							   const char* prefix,
+							   const char* type,
+							   const int flags,
+							   cpl_object_info_iterator_t iterator,
+							   void* context)
 {
 	assert(backend != NULL);
 	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
-	
+
 	SQL_START;
 
-	cpl_id_t id = CPL_NONE;
 	cpl_return_t r = CPL_E_INTERNAL_ERROR;
+	std::list<cpl_object_info_t*> entries;
+	std::string pattern = cpl_odbc_like_prefix(prefix, (size_t) -1);
 
-	mutex_lock(odbc->lookup_object_lock);
+	mutex_lock(odbc->lookup_by_name_prefix_lock);
 
 
-	// Prepare the statement
+	// Bind the parameters
 
 retry:
-	SQLHSTMT stmt = odbc->lookup_object_stmt;
+	SQLHSTMT stmt = odbc->lookup_by_name_prefix_stmt;
 
-	SQL_BIND_VARCHAR(stmt, 1, 255, originator);
-	SQL_BIND_VARCHAR(stmt, 2, 255, name);
-	SQL_BIND_VARCHAR(stmt, 3, 100, type);
+	SQL_BIND_VARCHAR(stmt, 1, 255, pattern.c_str());
+	SQL_BIND_VARCHAR(stmt, 2, 255, originator);
+	SQL_BIND_VARCHAR(stmt, 3, 255, originator);
+	SQL_BIND_VARCHAR(stmt, 4, 100, type);
+	SQL_BIND_VARCHAR(stmt, 5, 100, type);
 
 
-	// Execute
-	
+	// Execute and fetch the result
+
 	SQL_EXECUTE(stmt);
 
+	r = cpl_odbc_fetch_object_info_list(stmt, entries);
 
-	// Fetch the result
+	mutex_unlock(odbc->lookup_by_name_prefix_lock);
 
-	r = cpl_sql_fetch_single_llong(stmt, (long long*) &id.hi, 1, true, false);
 	if (!CPL_IS_OK(r)) {
-		mutex_unlock(odbc->lookup_object_lock);
+		std::list<cpl_object_info_t*>::iterator i;
+		for (i = entries.begin(); i != entries.end(); i++) {
+			cpl_odbc_free_object_info(*i);
+		}
 		return r;
 	}
 
-	r = cpl_sql_fetch_single_llong(stmt, (long long*) &id.lo, 2, false, true);
-	if (!CPL_IS_OK(r)) {
-		mutex_unlock(odbc->lookup_object_lock);
-		return r;
-	}
+	if (entries.empty()) return CPL_S_NO_DATA;
 
 
-	// Cleanup
+	// Call the user-provided callback function
 
-	mutex_unlock(odbc->lookup_object_lock);
-	
-	if (out_id != NULL) *out_id = id;
-	return CPL_OK;
+	return cpl_odbc_iterate_object_info_list(backend, entries, flags,
+											 iterator, context);
 
 
 	// Error handling
 
 err:
-	mutex_unlock(odbc->lookup_object_lock);
+	mutex_unlock(odbc->lookup_by_name_prefix_lock);
 	return CPL_E_STATEMENT_ERROR;
 }
 
 
 /**
- * Look up an object by name. If multiple objects share the same name,
- * get the latest one.
+ * Get the next page of objects in the order of their IDs, using keyset
+ * pagination
  *
  * @param backend the pointer to the backend structure
- * @param originator the object originator (namespace)
- * @param name the object name
- * @param type the object type
- * @param flags a logical combination of CPL_L_* flags
- * @param iterator the iterator to be called for each matching object
- * @param context the caller-provided iterator context
- * @return CPL_OK or an error code
+ * @param after the ID of the last object of the previous page, or
+ *              CPL_NONE to get the first page
+ * @param originator the object originator, or NULL for any
+ * @param type the object type, or NULL for any
+ * @param flags a logical combination of CPL_I_* flags
+ * @param max_count the maximum number of objects to return
+ * @param out_infos the array of max_count pointers to store the object
+ *                  info structures
+ * @param out_count the pointer to store the number of returned objects
+ * @return CPL_OK, CPL_S_NO_DATA if there are no more objects, or an error
+ *         code
  */
-extern "C" cpl_return_t
-cpl_odbc_lookup_object_ext(struct _cpl_db_backend_t* backend,
-						   const char* originator,
-						   const char* name,
-						   const char* type,
-						   const int flags,
-						   cpl_id_timestamp_iterator_t iterator,
-						   void* context)
+cpl_return_t
+cpl_odbc_get_objects_page(struct _cpl_db_backend_t* backend,
+						  const cpl_id_t after,
+						  const char* originator,
+						  const char* type,
+						  const int flags,
+						  const size_t max_count,
+						  cpl_object_info_t** out_infos,
+						  size_t* out_count)
 {
 	assert(backend != NULL);
 	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
@@ -1271,280 +3588,488 @@ cpl_odbc_lookup_object_ext(struct _cpl_db_backend_t* backend,
 	SQL_START;
 
 	cpl_return_t r = CPL_E_INTERNAL_ERROR;
-	cpl_id_timestamp_t entry;
-	std::list<cpl_id_timestamp_t> entries;
-	SQL_TIMESTAMP_STRUCT t;
-
-	mutex_lock(odbc->lookup_object_ext_lock);
+	long long l = 0;
+	cpl_object_info_t* p = NULL;
+	size_t count = 0;
+	int arg = 1;
 
+	bool fast = (flags & CPL_I_FAST) == CPL_I_FAST;
+	bool first = after == CPL_NONE;
 
-	// Prepare the statement
+	SQLHSTMT stmt = fast
+		? (first ? odbc->get_objects_first_page_fast_stmt
+				 : odbc->get_objects_next_page_fast_stmt)
+		: (first ? odbc->get_objects_first_page_stmt
+				 : odbc->get_objects_next_page_stmt);
 
-retry:
-	SQLHSTMT stmt = odbc->lookup_object_ext_stmt;
+	*out_count = 0;
+	if (max_count == 0) return CPL_OK;
 
-	SQL_BIND_VARCHAR(stmt, 1, 255, originator);
-	SQL_BIND_VARCHAR(stmt, 2, 255, name);
-	SQL_BIND_VARCHAR(stmt, 3, 100, type);
+	mutex_lock(odbc->get_all_objects_lock);
 
 
-	// Execute
-	
-	SQL_EXECUTE(stmt);
+	// Bind the parameters
 
+retry:
 
-	// Bind the columns
+	arg = 1;
+	if (!first) {
+		SQL_BIND_INTEGER(stmt, arg++, after.hi);
+		SQL_BIND_INTEGER(stmt, arg++, after.hi);
+		SQL_BIND_INTEGER(stmt, arg++, after.lo);
+	}
+	SQL_BIND_VARCHAR(stmt, arg++, 255, originator);
+	SQL_BIND_VARCHAR(stmt, arg++, 255, originator);
+	SQL_BIND_VARCHAR(stmt, arg++, 100, type);
+	SQL_BIND_VARCHAR(stmt, arg++, 100, type);
+	SQL_BIND_INTEGER(stmt, arg++, max_count);
 
-	ret = SQLBindCol(stmt, 1, SQL_C_UBIGINT, &entry.id.hi, 0, NULL);
-	if (!SQL_SUCCEEDED(ret)) goto err_close;
 
-	ret = SQLBindCol(stmt, 2, SQL_C_UBIGINT, &entry.id.lo, 0, NULL);
-	if (!SQL_SUCCEEDED(ret)) goto err_close;
+	// Execute
 
-	ret = SQLBindCol(stmt, 3, SQL_C_TYPE_TIMESTAMP, &t, sizeof(t), NULL);
-	if (!SQL_SUCCEEDED(ret)) goto err_close;
+	SQL_EXECUTE(stmt);
 
 
 	// Fetch the result
 
-	while (true) {
+	while (count < max_count) {
 
-		ret = SQLFetch(stmt);
-		if (!SQL_SUCCEEDED(ret)) {
-			if (ret != SQL_NO_DATA) {
-				print_odbc_error("SQLFetch", stmt, SQL_HANDLE_STMT);
-				goto err_close;
-			}
-			break;
+		p = (cpl_object_info_t*) malloc(sizeof(*p));
+		if (p == NULL) {
+			r = CPL_E_INSUFFICIENT_RESOURCES;
+			SQLCloseCursor(stmt);
+			goto err_r;
 		}
+		memset(p, 0, sizeof(*p));
 
-		entry.timestamp = cpl_sql_timestamp_to_unix_time(t);
-		entries.push_back(entry);
-	}
-	
-	ret = SQLCloseCursor(stmt);
-	if (!SQL_SUCCEEDED(ret)) {
-		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
-		goto err;
-	}
+		r = cpl_sql_fetch_single_llong(stmt, (long long*) &p->id.hi, 1,
+									   true, false);
+		if (r == CPL_E_NOT_FOUND) break;
+		if (!CPL_IS_OK(r)) goto err_r;
+		CPL_SQL_SIMPLE_FETCH(llong, 2, (long long*) &p->id.lo);
+		CPL_SQL_SIMPLE_FETCH(timestamp_as_unix_time, 3, &p->creation_time);
 
+		CPL_SQL_SIMPLE_FETCH_EXT(dynamically_allocated_string, 4,
+								 &p->originator, true);
+#ifdef _WINDOWS
+		if (r == CPL_E_DB_NULL) p->originator = _strdup("");
+#else
+		if (r == CPL_E_DB_NULL) p->originator = strdup("");
+#endif
+		CPL_SQL_SIMPLE_FETCH_EXT(dynamically_allocated_string, 5,
+								 &p->name, true);
+#ifdef _WINDOWS
+		if (r == CPL_E_DB_NULL) p->name = _strdup("");
+#else
+		if (r == CPL_E_DB_NULL) p->name = strdup("");
+#endif
+		CPL_SQL_SIMPLE_FETCH_EXT(dynamically_allocated_string, 6,
+								 &p->type, true);
+#ifdef _WINDOWS
+		if (r == CPL_E_DB_NULL) p->type = _strdup("");
+#else
+		if (r == CPL_E_DB_NULL) p->type = strdup("");
+#endif
 
-	// Unlock
+		CPL_SQL_SIMPLE_FETCH_EXT(llong, 7,
+								 (long long*) &p->container_id.hi, true);
+		if (r == CPL_E_DB_NULL) p->container_id = CPL_NONE;
+		CPL_SQL_SIMPLE_FETCH_EXT(llong, 8,
+								 (long long*) &p->container_id.lo, true);
+		if (r == CPL_E_DB_NULL) p->container_id = CPL_NONE;
+		CPL_SQL_SIMPLE_FETCH_EXT(llong, 9, &l, true);
+		if (r == CPL_E_DB_NULL) l = CPL_VERSION_NONE;
+		p->container_version = (cpl_version_t) l;
+
+		p->creation_session = CPL_NONE;
+		p->version = CPL_VERSION_NONE;
+
+		if (!fast) {
+			if ((flags & CPL_I_NO_CREATION_SESSION) == 0) {
+				CPL_SQL_SIMPLE_FETCH(llong, 10,
+						(long long*) &p->creation_session.hi);
+				CPL_SQL_SIMPLE_FETCH(llong, 11,
+						(long long*) &p->creation_session.lo);
+			}
+			if ((flags & CPL_I_NO_VERSION) == 0) {
+				CPL_SQL_SIMPLE_FETCH(llong, 12, &l);
+				p->version = (cpl_version_t) l;
+			}
+		}
 
-	mutex_unlock(odbc->lookup_object_ext_lock);
+		out_infos[count++] = p;
+		p = NULL;
+	}
 
+	if (p != NULL) {
+		free(p);
+		p = NULL;
+	}
+	else {
+		ret = SQLCloseCursor(stmt);
+		if (!SQL_SUCCEEDED(ret)) {
+			print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
+			goto err;
+		}
+	}
 
-	// If we did not get any data back, terminate
 
-	if (entries.empty()) return CPL_E_NOT_FOUND;
+	// Cleanup
 
+	mutex_unlock(odbc->get_all_objects_lock);
 
-	// Call the user-provided callback function
+	*out_count = count;
+	return count == 0 ? CPL_S_NO_DATA : CPL_OK;
 
-	if (iterator != NULL) {
-		std::list<cpl_id_timestamp_t>::iterator i;
-		for (i = entries.begin(); i != entries.end(); i++) {
-			r = iterator(i->id, i->timestamp, context);
-			if (!CPL_IS_OK(r)) return r;
-		}
-	}
 
-	return CPL_OK;
+	// Error handling
 
+err:
+	r = CPL_E_STATEMENT_ERROR;
 
-	// Error handling
+err_r:
+	mutex_unlock(odbc->get_all_objects_lock);
+	if (p != NULL) cpl_odbc_free_object_info(p);
 
-err_close:
-	ret = SQLCloseCursor(stmt);
-	if (!SQL_SUCCEEDED(ret)) {
-		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
+	for (size_t i = 0; i < count; i++) {
+		cpl_odbc_free_object_info(out_infos[i]);
+		out_infos[i] = NULL;
 	}
 
-err:
-	mutex_unlock(odbc->lookup_object_ext_lock);
-	return CPL_E_STATEMENT_ERROR;
+	return r;
 }
 
 
 /**
- * Create a new version of the given object
+ * Get information about the given provenance object
  *
  * @param backend the pointer to the backend structure
- * @param object_id the object ID
- * @param version the new version of the object
- * @param session the session ID responsible for this provenance record
+ * @param id the object ID
+ * @param version_hint the version of the given provenance object if known,
+ *                     or CPL_VERSION_NONE if not
+ * @param out_info the pointer to store the object info structure
  * @return CPL_OK or an error code
  */
 cpl_return_t
-cpl_odbc_create_version(struct _cpl_db_backend_t* backend,
-						const cpl_id_t object_id,
-						const cpl_version_t version,
-						const cpl_session_t session)
+cpl_odbc_get_object_info(struct _cpl_db_backend_t* backend,
+						 const cpl_id_t id,
+						 const cpl_version_t version_hint,
+						 cpl_object_info_t** out_info)
 {
 	assert(backend != NULL);
+	
 	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
 	
-	SQLRETURN ret;
+	SQL_START;
 
-	mutex_lock(odbc->create_version_lock);
+	cpl_return_t r = CPL_E_INTERNAL_ERROR;
+	long long l;
+
+	cpl_object_info_t* p = (cpl_object_info_t*) malloc(sizeof(*p));
+	if (p == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
+	memset(p, 0, sizeof(*p));
+	p->id = id;
+
+
+	// Get the version
+
+	if (version_hint == CPL_VERSION_NONE) {
+		r = cpl_odbc_get_version(backend, id, &p->version);
+		if (!CPL_IS_OK(r)) {
+			free(p);
+			return r;
+		}
+	}
+	else {
+		p->version = version_hint;
+	}
 
 
 	// Prepare the statement
 
-	SQLHSTMT stmt = odbc->create_version_stmt;
-	SQL_BIND_INTEGER(stmt, 1, object_id.hi);
-	SQL_BIND_INTEGER(stmt, 2, object_id.lo);
-	SQL_BIND_INTEGER(stmt, 3, version);
-	SQL_BIND_INTEGER(stmt, 4, session.hi);
-	SQL_BIND_INTEGER(stmt, 5, session.lo);
+	mutex_lock(odbc->get_object_info_lock);
+
+retry:
+	SQLHSTMT stmt = odbc->get_object_info_stmt;
+
+	SQL_BIND_INTEGER(stmt, 1, id.hi);
+	SQL_BIND_INTEGER(stmt, 2, id.lo);
 
 
 	// Execute
 	
-	ret = SQLExecute(stmt);
-	if (!SQL_SUCCEEDED(ret)) {
-		
-		SQLINTEGER native;
-		SQLCHAR	state[ 7 ];
-		SQLCHAR	text[256];
-		SQLSMALLINT	len;
+	SQL_EXECUTE(stmt);
 
-		ret = SQLGetDiagRec(SQL_HANDLE_STMT, stmt, 1, state, &native,
-							text, sizeof(text), &len);
-		
-		if (SQL_SUCCEEDED(ret)) {
-			if (strcmp((const char*) state, "23000") == 0) {
-				mutex_unlock(odbc->create_version_lock);
-				return CPL_E_ALREADY_EXISTS;
-			}
-			else {
-				print_odbc_error("SQLExecute", stmt, SQL_HANDLE_STMT);
-			}
-		}
-		else if (ret != SQL_NO_DATA) {
-			fprintf(stderr, "  SQLGetDiagRec failed with error code %ld\n",
-					(long) ret);
-		}
 
+	// Fetch the result
+
+	CPL_SQL_SIMPLE_FETCH(llong, 1, (long long*) &p->creation_session.hi);
+	CPL_SQL_SIMPLE_FETCH(llong, 2, (long long*) &p->creation_session.lo);
+	CPL_SQL_SIMPLE_FETCH(timestamp_as_unix_time, 3, &p->creation_time);
+
+	CPL_SQL_SIMPLE_FETCH_EXT(dynamically_allocated_string, 4, &p->originator,
+							 true);
+#ifdef _WINDOWS
+	if (r == CPL_E_DB_NULL) p->originator = _strdup("");
+#else
+	if (r == CPL_E_DB_NULL) p->originator = strdup("");
+#endif
+	CPL_SQL_SIMPLE_FETCH_EXT(dynamically_allocated_string, 5, &p->name, true);
+#ifdef _WINDOWS
+	if (r == CPL_E_DB_NULL) p->name = _strdup("");
+#else
+	if (r == CPL_E_DB_NULL) p->name = strdup("");
+#endif
+	CPL_SQL_SIMPLE_FETCH_EXT(dynamically_allocated_string, 6, &p->type, true);
+#ifdef _WINDOWS
+	if (r == CPL_E_DB_NULL) p->type = _strdup("");
+#else
+	if (r == CPL_E_DB_NULL) p->type = strdup("");
+#endif
+
+	CPL_SQL_SIMPLE_FETCH_EXT(llong, 7, (long long*) &p->container_id.hi, true);
+	if (r == CPL_E_DB_NULL) p->container_id = CPL_NONE;
+	CPL_SQL_SIMPLE_FETCH_EXT(llong, 8, (long long*) &p->container_id.lo, true);
+	if (r == CPL_E_DB_NULL) p->container_id = CPL_NONE;
+	CPL_SQL_SIMPLE_FETCH_EXT(llong, 9, &l, true);
+	if (r == CPL_E_DB_NULL) l = CPL_VERSION_NONE;
+	p->container_version = (cpl_version_t) l;
+	
+	ret = SQLCloseCursor(stmt);
+	if (!SQL_SUCCEEDED(ret)) {
+		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
 		goto err;
 	}
 
 
 	// Cleanup
 
-	mutex_unlock(odbc->create_version_lock);
+	mutex_unlock(odbc->get_object_info_lock);
+	
+	*out_info = p;
 	return CPL_OK;
 
 
 	// Error handling
 
 err:
-	mutex_unlock(odbc->create_version_lock);
-	return CPL_E_STATEMENT_ERROR;
-}
+	r = CPL_E_STATEMENT_ERROR;
+
+err_r:
+	mutex_unlock(odbc->get_object_info_lock);
 
+	if (p->originator != NULL) free(p->originator);
+	if (p->name != NULL) free(p->name);
+	if (p->type != NULL) free(p->type);
+	free(p);
+
+	return r;
+}
 
 /**
- * Determine the version of the object
+ * Get information about several provenance objects at once, fetching up
+ * to CPL_ODBC_BATCH_SIZE objects per query. The returned structures
+ * include the latest version of each object.
  *
  * @param backend the pointer to the backend structure
- * @param id the object ID
- * @param out_version the pointer to store the version of the object
- * @return CPL_OK or an error code
+ * @param ids the array of unique object IDs
+ * @param count the number of object IDs
+ * @param out_infos the array of count pointers to store the object info
+ *                  structures
+ * @return CPL_OK, CPL_E_NOT_FOUND if any of the objects does not exist,
+ *         or an error code
  */
-extern "C" cpl_return_t
-cpl_odbc_get_version(struct _cpl_db_backend_t* backend,
-					 const cpl_id_t id,
-					 cpl_version_t* out_version)
+cpl_return_t
+cpl_odbc_get_object_info_batch(struct _cpl_db_backend_t* backend,
+							   const cpl_id_t* ids,
+							   const size_t count,
+							   cpl_object_info_t** out_infos)
 {
 	assert(backend != NULL);
 	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
-	
+
 	SQL_START;
 
-	long long l;
-	cpl_return_t r;
+	cpl_return_t r = CPL_E_INTERNAL_ERROR;
+	long long l = 0;
+	cpl_id_t id;
+	cpl_object_info_t* p = NULL;
+	size_t found = 0;
+	size_t start = 0;
+
+	std::map<cpl_id_t, size_t> index;
+	for (size_t i = 0; i < count; i++) {
+		index[ids[i]] = i;
+		out_infos[i] = NULL;
+	}
 
-	mutex_lock(odbc->get_version_lock);
+	SQLHSTMT stmt = odbc->get_object_info_batch_stmt;
+
+	mutex_lock(odbc->get_object_info_lock);
 
 
-	// Prepare the statement
+	// Run one query per CPL_ODBC_BATCH_SIZE objects, padding the last batch
+	// by repeating its last object
+
+	for (start = 0; start < count; start += CPL_ODBC_BATCH_SIZE) {
 
 retry:
-	SQLHSTMT stmt = odbc->get_version_stmt;
-	SQL_BIND_INTEGER(stmt, 1, id.hi);
-	SQL_BIND_INTEGER(stmt, 2, id.lo);
+		for (int i = 0; i < CPL_ODBC_BATCH_SIZE; i++) {
+			size_t k = start + i < count ? start + i : count - 1;
+			SQL_BIND_INTEGER(stmt, 2 * i + 1, ids[k].hi);
+			SQL_BIND_INTEGER(stmt, 2 * i + 2, ids[k].lo);
+		}
 
 
-	// Execute
-	
-	SQL_EXECUTE(stmt);
+		// Execute
 
+		SQL_EXECUTE(stmt);
 
-	// Fetch the result
 
-	r = cpl_sql_fetch_single_llong(stmt, &l);
-	if (!CPL_IS_OK(r)) {
-		mutex_unlock(odbc->get_version_lock);
-		return r;
+		// Fetch the result
+
+		while (true) {
+
+			r = cpl_sql_fetch_single_llong(stmt, (long long*) &id.hi, 1,
+										   true, false);
+			if (r == CPL_E_NOT_FOUND) break;
+			if (!CPL_IS_OK(r)) goto err_r;
+			CPL_SQL_SIMPLE_FETCH(llong, 2, (long long*) &id.lo);
+
+			p = (cpl_object_info_t*) malloc(sizeof(*p));
+			if (p == NULL) {
+				r = CPL_E_INSUFFICIENT_RESOURCES;
+				SQLCloseCursor(stmt);
+				goto err_r;
+			}
+			memset(p, 0, sizeof(*p));
+			p->id = id;
+
+			CPL_SQL_SIMPLE_FETCH(llong, 3, (long long*) &p->creation_session.hi);
+			CPL_SQL_SIMPLE_FETCH(llong, 4, (long long*) &p->creation_session.lo);
+			CPL_SQL_SIMPLE_FETCH(timestamp_as_unix_time, 5, &p->creation_time);
+
+			CPL_SQL_SIMPLE_FETCH_EXT(dynamically_allocated_string, 6,
+									 &p->originator, true);
+#ifdef _WINDOWS
+			if (r == CPL_E_DB_NULL) p->originator = _strdup("");
+#else
+			if (r == CPL_E_DB_NULL) p->originator = strdup("");
+#endif
+			CPL_SQL_SIMPLE_FETCH_EXT(dynamically_allocated_string, 7,
+									 &p->name, true);
+#ifdef _WINDOWS
+			if (r == CPL_E_DB_NULL) p->name = _strdup("");
+#else
+			if (r == CPL_E_DB_NULL) p->name = strdup("");
+#endif
+			CPL_SQL_SIMPLE_FETCH_EXT(dynamically_allocated_string, 8,
+									 &p->type, true);
+#ifdef _WINDOWS
+			if (r == CPL_E_DB_NULL) p->type = _strdup("");
+#else
+			if (r == CPL_E_DB_NULL) p->type = strdup("");
+#endif
+
+			CPL_SQL_SIMPLE_FETCH_EXT(llong, 9,
+									 (long long*) &p->container_id.hi, true);
+			if (r == CPL_E_DB_NULL) p->container_id = CPL_NONE;
+			CPL_SQL_SIMPLE_FETCH_EXT(llong, 10,
+									 (long long*) &p->container_id.lo, true);
+			if (r == CPL_E_DB_NULL) p->container_id = CPL_NONE;
+			CPL_SQL_SIMPLE_FETCH_EXT(llong, 11, &l, true);
+			if (r == CPL_E_DB_NULL) l = CPL_VERSION_NONE;
+			p->container_version = (cpl_version_t) l;
+
+			CPL_SQL_SIMPLE_FETCH(llong, 12, &l);
+			p->version = (cpl_version_t) l;
+
+			std::map<cpl_id_t, size_t>::iterator k = index.find(id);
+			if (k != index.end() && out_infos[k->second] == NULL) {
+				out_infos[k->second] = p;
+				found++;
+			}
+			else {
+				cpl_odbc_free_object_info(p);
+			}
+			p = NULL;
+		}
 	}
 
 
 	// Cleanup
 
-	mutex_unlock(odbc->get_version_lock);
+	mutex_unlock(odbc->get_object_info_lock);
+
+	if (found < count) {
+		r = CPL_E_NOT_FOUND;
+		goto err_free;
+	}
 
-	if (out_version != NULL) *out_version = (cpl_version_t) l;
 	return CPL_OK;
 
 
 	// Error handling
 
 err:
-	mutex_unlock(odbc->get_version_lock);
-	return CPL_E_STATEMENT_ERROR;
+	r = CPL_E_STATEMENT_ERROR;
+
+err_r:
+	mutex_unlock(odbc->get_object_info_lock);
+	if (p != NULL) cpl_odbc_free_object_info(p);
+
+err_free:
+	for (size_t i = 0; i < count; i++) {
+		if (out_infos[i] != NULL) {
+			cpl_odbc_free_object_info(out_infos[i]);
+			out_infos[i] = NULL;
+		}
+	}
+
+	return r;
 }
 
 
+
 /**
- * Add an ancestry edge
+ * Get information about the specific version of a provenance object
  *
  * @param backend the pointer to the backend structure
- * @param from_id the edge source ID
- * @param from_ver the edge source version
- * @param to_id the edge destination ID
- * @param to_ver the edge destination version
- * @param type the data or control dependency type
- * @return the error code
+ * @param id the object ID
+ * @param version the version of the given provenance object
+ * @param out_info the pointer to store the version info structure
+ * @return CPL_OK or an error code
  */
-extern "C" cpl_return_t
-cpl_odbc_add_ancestry_edge(struct _cpl_db_backend_t* backend,
-						   const cpl_id_t from_id,
-						   const cpl_version_t from_ver,
-						   const cpl_id_t to_id,
-						   const cpl_version_t to_ver,
-						   const int type)
+cpl_return_t
+cpl_odbc_get_version_info(struct _cpl_db_backend_t* backend,
+						  const cpl_id_t id,
+						  const cpl_version_t version,
+						  cpl_version_info_t** out_info)
 {
 	assert(backend != NULL);
 	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+	
+	SQL_START;
 
-	mutex_lock(odbc->add_ancestry_edge_lock);
+	cpl_return_t r = CPL_E_INTERNAL_ERROR;
+
+	cpl_version_info_t* p = (cpl_version_info_t*) malloc(sizeof(*p));
+	if (p == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
+	memset(p, 0, sizeof(*p));
+	p->id = id;
+	p->version = version;
 
+	mutex_lock(odbc->get_version_info_lock);
 
-	// Prepare the statement
 
-	SQL_START;
+	// Prepare the statement
 
 retry:
-	SQLHSTMT stmt = odbc->add_ancestry_edge_stmt;
+	SQLHSTMT stmt = odbc->get_version_info_stmt;
 
-	SQL_BIND_INTEGER(stmt, 1, from_id.hi);
-	SQL_BIND_INTEGER(stmt, 2, from_id.lo);
-	SQL_BIND_INTEGER(stmt, 3, from_ver);
-	SQL_BIND_INTEGER(stmt, 4, to_id.hi);
-	SQL_BIND_INTEGER(stmt, 5, to_id.lo);
-	SQL_BIND_INTEGER(stmt, 6, to_ver);
-	SQL_BIND_INTEGER(stmt, 7, type);
+	SQL_BIND_INTEGER(stmt, 1, id.hi);
+	SQL_BIND_INTEGER(stmt, 2, id.lo);
+	SQL_BIND_INTEGER(stmt, 3, version);
 
 
 	// Execute
@@ -1552,169 +4077,307 @@ retry:
 	SQL_EXECUTE(stmt);
 
 
+	// Fetch the result
+
+	CPL_SQL_SIMPLE_FETCH(llong, 1, (long long*) &p->session.hi);
+	CPL_SQL_SIMPLE_FETCH(llong, 2, (long long*) &p->session.lo);
+	CPL_SQL_SIMPLE_FETCH(timestamp_as_unix_time, 3, &p->creation_time);
+
+	ret = SQLCloseCursor(stmt);
+	if (!SQL_SUCCEEDED(ret)) {
+		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
+		goto err;
+	}
+
+
 	// Cleanup
 
-	mutex_unlock(odbc->add_ancestry_edge_lock);
+	mutex_unlock(odbc->get_version_info_lock);
+	
+	*out_info = p;
 	return CPL_OK;
 
 
 	// Error handling
 
 err:
-	mutex_unlock(odbc->add_ancestry_edge_lock);
-	return CPL_E_STATEMENT_ERROR;
-}
+	r = CPL_E_STATEMENT_ERROR;
+
+err_r:
+	mutex_unlock(odbc->get_version_info_lock);
 
+	free(p);
+	return r;
+}
 
 /**
- * Determine whether the given object has the given ancestor
+ * Get information about several version nodes at once, fetching up to
+ * CPL_ODBC_BATCH_SIZE nodes per query.
  *
  * @param backend the pointer to the backend structure
- * @param object_id the object ID
- * @param version_hint the object version (if known), or CPL_VERSION_NONE
- *                     otherwise
- * @param query_object_id the object that we want to determine whether it
- *                        is one of the immediate ancestors
- * @param query_object_max_version the maximum version of the query
- *                                 object to consider
- * @param out the pointer to store a positive number if yes, or 0 if no
- * @return CPL_OK or an error code
+ * @param nodes the array of unique version nodes
+ * @param count the number of version nodes
+ * @param out_infos the array of count pointers to store the version info
+ *                  structures
+ * @return CPL_OK, CPL_E_NOT_FOUND if any of the versions does not exist,
+ *         or an error code
  */
-extern "C" cpl_return_t
-cpl_odbc_has_immediate_ancestor(struct _cpl_db_backend_t* backend,
-								const cpl_id_t object_id,
-								const cpl_version_t version_hint,
-								const cpl_id_t query_object_id,
-								const cpl_version_t query_object_max_version,
-								int* out)
+cpl_return_t
+cpl_odbc_get_version_info_batch(struct _cpl_db_backend_t* backend,
+								const cpl_id_version_t* nodes,
+								const size_t count,
+								cpl_version_info_t** out_infos)
 {
 	assert(backend != NULL);
 	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
-	
+
 	SQL_START;
 
+	typedef std::pair<cpl_id_t, cpl_version_t> node_t;
+
 	cpl_return_t r = CPL_E_INTERNAL_ERROR;
-	int cr = CPL_E_INTERNAL_ERROR;
+	long long l = 0;
+	cpl_id_t id;
+	cpl_version_info_t* p = NULL;
+	size_t found = 0;
+	size_t start = 0;
+
+	std::map<node_t, size_t> index;
+	for (size_t i = 0; i < count; i++) {
+		index[node_t(nodes[i].id, nodes[i].version)] = i;
+		out_infos[i] = NULL;
+	}
 
-	mutex_lock(odbc->has_immediate_ancestor_lock);
+	SQLHSTMT stmt = odbc->get_version_info_batch_stmt;
 
+	mutex_lock(odbc->get_version_info_lock);
 
-	// Prepare the statement
+
+	// Run one query per CPL_ODBC_BATCH_SIZE nodes, padding the last batch
+	// by repeating its last node
+
+	for (start = 0; start < count; start += CPL_ODBC_BATCH_SIZE) {
 
 retry:
-	SQLHSTMT stmt = version_hint == CPL_VERSION_NONE 
-		? odbc->has_immediate_ancestor_stmt
-		: odbc->has_immediate_ancestor_with_ver_stmt;
-	SQL_BIND_INTEGER(stmt, 1, query_object_id.hi);
-	SQL_BIND_INTEGER(stmt, 2, query_object_id.lo);
-	SQL_BIND_INTEGER(stmt, 3, query_object_max_version);
-	SQL_BIND_INTEGER(stmt, 4, object_id.hi);
-	SQL_BIND_INTEGER(stmt, 5, object_id.lo);
-	if (version_hint != CPL_VERSION_NONE) {
-		SQL_BIND_INTEGER(stmt, 6, version_hint);
-	}
+		for (int i = 0; i < CPL_ODBC_BATCH_SIZE; i++) {
+			size_t k = start + i < count ? start + i : count - 1;
+			SQL_BIND_INTEGER(stmt, 3 * i + 1, nodes[k].id.hi);
+			SQL_BIND_INTEGER(stmt, 3 * i + 2, nodes[k].id.lo);
+			SQL_BIND_INTEGER(stmt, 3 * i + 3, nodes[k].version);
+		}
 
 
-	// Execute
-	
-	SQL_EXECUTE(stmt);
+		// Execute
 
+		SQL_EXECUTE(stmt);
 
-	// Fetch the data
 
-	r = cpl_sql_fetch_single_llong(stmt, NULL);
-	if (CPL_IS_OK(r)) cr = 1;
-	if (r == CPL_E_NOT_FOUND) { r = CPL_OK; cr = 0; }
-	if (!CPL_IS_OK(r)) {
-		mutex_unlock(odbc->has_immediate_ancestor_lock);
-		return r;
+		// Fetch the result
+
+		while (true) {
+
+			r = cpl_sql_fetch_single_llong(stmt, (long long*) &id.hi, 1,
+										   true, false);
+			if (r == CPL_E_NOT_FOUND) break;
+			if (!CPL_IS_OK(r)) goto err_r;
+			CPL_SQL_SIMPLE_FETCH(llong, 2, (long long*) &id.lo);
+			CPL_SQL_SIMPLE_FETCH(llong, 3, &l);
+
+			p = (cpl_version_info_t*) malloc(sizeof(*p));
+			if (p == NULL) {
+				r = CPL_E_INSUFFICIENT_RESOURCES;
+				SQLCloseCursor(stmt);
+				goto err_r;
+			}
+			memset(p, 0, sizeof(*p));
+			p->id = id;
+			p->version = (cpl_version_t) l;
+
+			CPL_SQL_SIMPLE_FETCH(llong, 4, (long long*) &p->session.hi);
+			CPL_SQL_SIMPLE_FETCH(llong, 5, (long long*) &p->session.lo);
+			CPL_SQL_SIMPLE_FETCH(timestamp_as_unix_time, 6, &p->creation_time);
+
+			std::map<node_t, size_t>::iterator k
+				= index.find(node_t(p->id, p->version));
+			if (k != index.end() && out_infos[k->second] == NULL) {
+				out_infos[k->second] = p;
+				found++;
+			}
+			else {
+				free(p);
+			}
+			p = NULL;
+		}
 	}
 
 
 	// Cleanup
 
-	mutex_unlock(odbc->has_immediate_ancestor_lock);
+	mutex_unlock(odbc->get_version_info_lock);
+
+	if (found < count) {
+		r = CPL_E_NOT_FOUND;
+		goto err_free;
+	}
 
-	if (out != NULL) *out = cr;
 	return CPL_OK;
 
 
 	// Error handling
 
 err:
-	mutex_unlock(odbc->has_immediate_ancestor_lock);
-	return CPL_E_STATEMENT_ERROR;
+	r = CPL_E_STATEMENT_ERROR;
+
+err_r:
+	mutex_unlock(odbc->get_version_info_lock);
+	if (p != NULL) free(p);
+
+err_free:
+	for (size_t i = 0; i < count; i++) {
+		if (out_infos[i] != NULL) {
+			free(out_infos[i]);
+			out_infos[i] = NULL;
+		}
+	}
+
+	return r;
 }
 
 
 /**
- * Add a property to the given object
+ * Read all rows of the result set of a version info query, which must have
+ * the columns id_hi, id_lo, version, session_id_hi, session_id_lo, and
+ * creation_time, and close the cursor
  *
- * @param backend the pointer to the backend structure
- * @param id the object ID
- * @param version the version number
- * @param key the key
- * @param value the value
+ * @param stmt the executed statement
+ * @param entries the list to append the version info structures to
  * @return CPL_OK or an error code
  */
-extern "C" cpl_return_t
-cpl_odbc_add_property(struct _cpl_db_backend_t* backend,
-                      const cpl_id_t id,
-                      const cpl_version_t version,
-                      const char* key,
-                      const char* value)
+static cpl_return_t
+cpl_odbc_fetch_version_infos(SQLHSTMT stmt,
+							 std::list<cpl_version_info_t>& entries)
 {
-    assert(backend != NULL);
-    cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+	cpl_return_t r = CPL_E_INTERNAL_ERROR;
+	cpl_version_info_t e;
+	long long l = 0;
 
-	mutex_lock(odbc->add_property_lock);
+	while (true) {
 
+		r = cpl_sql_fetch_single_llong(stmt, (long long*) &e.id.hi, 1,
+									   true, false);
+		if (r == CPL_E_NOT_FOUND) break;
+		if (!CPL_IS_OK(r)) return r;
+		CPL_SQL_SIMPLE_FETCH(llong, 2, (long long*) &e.id.lo);
+		CPL_SQL_SIMPLE_FETCH(llong, 3, &l);
+		CPL_SQL_SIMPLE_FETCH(llong, 4, (long long*) &e.session.hi);
+		CPL_SQL_SIMPLE_FETCH(llong, 5, (long long*) &e.session.lo);
+		CPL_SQL_SIMPLE_FETCH(timestamp_as_unix_time, 6, &e.creation_time);
+
+		e.version = (cpl_version_t) l;
+		entries.push_back(e);
+	}
 
-	// Prepare the statement
+	return CPL_OK;
+
+err_r:
+	return r;
+}
+
+
+/**
+ * Iterate over all version nodes created within the given time range,
+ * ordered by their creation time
+ *
+ * @param backend the pointer to the backend structure
+ * @param start_time the start of the time range (inclusive)
+ * @param end_time the end of the time range (inclusive)
+ * @param iterator the iterator to be called for each matching version
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+cpl_return_t
+cpl_odbc_get_versions_in_range(struct _cpl_db_backend_t* backend,
+							   const unsigned long start_time,
+							   const unsigned long end_time,
+							   cpl_version_info_iterator_t iterator,
+							   void* context)
+{
+	assert(backend != NULL);
+	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
 
 	SQL_START;
 
+	cpl_return_t r = CPL_E_INTERNAL_ERROR;
+	std::list<cpl_version_info_t> entries;
+
+	mutex_lock(odbc->get_version_activity_lock);
+
+
+	// Prepare the statement
+
 retry:
-	SQLHSTMT stmt = odbc->add_property_stmt;
+	entries.clear();
+	SQLHSTMT stmt = odbc->get_versions_in_range_stmt;
 
-	SQL_BIND_INTEGER(stmt, 1, id.hi);
-	SQL_BIND_INTEGER(stmt, 2, id.lo);
-	SQL_BIND_INTEGER(stmt, 3, version);
-	SQL_BIND_VARCHAR(stmt, 4, 255, key);
-	SQL_BIND_VARCHAR(stmt, 5, 4095, value);
+	SQL_BIND_TIMESTAMP(stmt, 1, start_time);
+	SQL_BIND_TIMESTAMP(stmt, 2, end_time);
 
 
 	// Execute
-	
+
 	SQL_EXECUTE(stmt);
 
 
-	// Cleanup
+	// Fetch the result
+
+	r = cpl_odbc_fetch_version_infos(stmt, entries);
+	if (!CPL_IS_OK(r)) goto err_r;
+
+
+	// Unlock
+
+	mutex_unlock(odbc->get_version_activity_lock);
+
+
+	// Call the user-provided callback function
+
+	if (entries.empty()) return CPL_S_NO_DATA;
+
+	for (std::list<cpl_version_info_t>::iterator i = entries.begin();
+		 i != entries.end(); i++) {
+		r = iterator(&(*i), context);
+		if (!CPL_IS_OK(r)) return r;
+	}
 
-	mutex_unlock(odbc->add_property_lock);
 	return CPL_OK;
 
 
 	// Error handling
 
 err:
-	mutex_unlock(odbc->add_property_lock);
-	return CPL_E_STATEMENT_ERROR;
+	r = CPL_E_STATEMENT_ERROR;
+
+err_r:
+	mutex_unlock(odbc->get_version_activity_lock);
+	return r;
 }
 
 
 /**
- * Get information about the given provenance session.
+ * Iterate over all version nodes created by the given session, ordered by
+ * their creation time
  *
  * @param backend the pointer to the backend structure
- * @param id the session ID
- * @param out_info the pointer to store the session info structure
- * @return CPL_OK or an error code
+ * @param session the session ID
+ * @param iterator the iterator to be called for each matching version
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
  */
 cpl_return_t
-cpl_odbc_get_session_info(struct _cpl_db_backend_t* backend,
-						  const cpl_session_t id,
-						  cpl_session_info_t** out_info)
+cpl_odbc_get_session_activity(struct _cpl_db_backend_t* backend,
+							  const cpl_session_t session,
+							  cpl_version_info_iterator_t iterator,
+							  void* context)
 {
 	assert(backend != NULL);
 	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
@@ -1722,51 +4385,47 @@ cpl_odbc_get_session_info(struct _cpl_db_backend_t* backend,
 	SQL_START;
 
 	cpl_return_t r = CPL_E_INTERNAL_ERROR;
-	long long l = 0;
+	std::list<cpl_version_info_t> entries;
 
-	cpl_session_info_t* p = (cpl_session_info_t*) malloc(sizeof(*p));
-	if (p == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
-	memset(p, 0, sizeof(*p));
-	p->id = id;
+	mutex_lock(odbc->get_version_activity_lock);
 
 
 	// Prepare the statement
 
-	mutex_lock(odbc->get_session_info_lock);
-
 retry:
-	SQLHSTMT stmt = odbc->get_session_info_stmt;
+	entries.clear();
+	SQLHSTMT stmt = odbc->get_session_activity_stmt;
 
-	SQL_BIND_INTEGER(stmt, 1, id.hi);
-	SQL_BIND_INTEGER(stmt, 2, id.lo);
+	SQL_BIND_INTEGER(stmt, 1, session.hi);
+	SQL_BIND_INTEGER(stmt, 2, session.lo);
 
 
 	// Execute
-	
+
 	SQL_EXECUTE(stmt);
 
 
 	// Fetch the result
 
-	CPL_SQL_SIMPLE_FETCH(dynamically_allocated_string, 1, &p->mac_address);
-	CPL_SQL_SIMPLE_FETCH(dynamically_allocated_string, 2, &p->user);
-	CPL_SQL_SIMPLE_FETCH(llong, 3, &l); p->pid = (int) l;
-	CPL_SQL_SIMPLE_FETCH(dynamically_allocated_string, 4, &p->program);
-	CPL_SQL_SIMPLE_FETCH(dynamically_allocated_string, 5, &p->cmdline);
-	CPL_SQL_SIMPLE_FETCH(timestamp_as_unix_time, 6, &p->start_time);
+	r = cpl_odbc_fetch_version_infos(stmt, entries);
+	if (!CPL_IS_OK(r)) goto err_r;
 
-	ret = SQLCloseCursor(stmt);
-	if (!SQL_SUCCEEDED(ret)) {
-		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
-		goto err;
-	}
 
+	// Unlock
+
+	mutex_unlock(odbc->get_version_activity_lock);
 
-	// Cleanup
 
-	mutex_unlock(odbc->get_session_info_lock);
-	
-	*out_info = p;
+	// Call the user-provided callback function
+
+	if (entries.empty()) return CPL_S_NO_DATA;
+
+	for (std::list<cpl_version_info_t>::iterator i = entries.begin();
+		 i != entries.end(); i++) {
+		r = iterator(&(*i), context);
+		if (!CPL_IS_OK(r)) return r;
+	}
+
 	return CPL_OK;
 
 
@@ -1776,71 +4435,89 @@ err:
 	r = CPL_E_STATEMENT_ERROR;
 
 err_r:
-	mutex_unlock(odbc->get_session_info_lock);
-
-	if (p->mac_address != NULL) free(p->mac_address);
-	if (p->user != NULL) free(p->user);
-	if (p->program != NULL) free(p->program);
-	if (p->cmdline != NULL) free(p->cmdline);
-	free(p);
-
+	mutex_unlock(odbc->get_version_activity_lock);
 	return r;
 }
 
 
+
 /**
- * Get all objects in the database
+ * An entry in the result set of the queries issued by
+ * cpl_odbc_get_object_ancestry().
+ */
+typedef struct __get_object_ancestry__entry {
+	cpl_id_t id;
+	long version;
+	long query_version;
+	long type;
+} __get_object_ancestry__entry_t;
+
+
+/**
+ * Iterate over the ancestors or the descendants of a provenance object.
  *
  * @param backend the pointer to the backend structure
- * @param flags a logical combination of CPL_I_* flags
- * @param iterator the iterator to be called for each matching object
- * @param context the caller-provided iterator context
- * @return CPL_OK or an error code
+ * @param id the object ID
+ * @param version the object version, or CPL_VERSION_NONE to access all
+ *                version nodes associated with the given object
+ * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+ *                  or CPL_D_DESCENDANTS)
+ * @param flags the bitwise combination of flags describing how should
+ *              the graph be traversed (a logical combination of the
+ *              CPL_A_* flags)
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
  */
 cpl_return_t
-cpl_odbc_get_all_objects(struct _cpl_db_backend_t* backend,
-						 const int flags,
-						 cpl_object_info_iterator_t iterator,
-						 void* context)
+cpl_odbc_get_object_ancestry(struct _cpl_db_backend_t* backend,
+							 const cpl_id_t id,
+							 const cpl_version_t version,
+							 const int direction,
+							 const int flags,
+							 cpl_ancestry_iterator_t iterator,
+							 void* context)
 {
 	assert(backend != NULL);
 	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
 
+	if ((flags & ~CPL_ODBC_A_SUPPORTED_FLAGS) != 0) {
+		return CPL_E_NOT_IMPLEMENTED;
+	}
+	
 	SQL_START;
 
 	cpl_return_t r = CPL_E_INTERNAL_ERROR;
-	cplxx_object_info_t entry;
-	std::list<cplxx_object_info_t> entries;
-	SQL_TIMESTAMP_STRUCT t;
-
-	size_t originator_size = 4096;
-	size_t name_size = 4096;
-	size_t type_size = 256;
-
-	char* entry_originator = (char*) alloca(originator_size);
-	char* entry_name = (char*) alloca(name_size);
-	char* entry_type = (char*) alloca(type_size);
 
-	if (entry_originator == NULL || entry_name == NULL || entry_type == NULL) {
-		return CPL_E_INSUFFICIENT_RESOURCES;
-	}
+	std::list<__get_object_ancestry__entry_t> entries;
+	__get_object_ancestry__entry_t entry;
+	SQLLEN ind_type;
+	bool found = false;
 
-	SQLLEN cb_container_id_lo = 0;
-	SQLLEN cb_container_id_hi = 0;
-	SQLLEN cb_container_ver = 0;
+	mutex_lock(odbc->get_object_ancestry_lock);
 
-	mutex_lock(odbc->get_all_objects_lock);
 
+	// Prepare the statement
 
-	// Get and execute the statement
-	
 retry:
+	SQLHSTMT stmt;
+	if (direction == CPL_D_ANCESTORS) {
+		stmt = version == CPL_VERSION_NONE
+			? odbc->get_object_ancestors_stmt
+			: odbc->get_object_ancestors_with_ver_stmt;
+	}
+	else {
+		stmt = version == CPL_VERSION_NONE
+			? odbc->get_object_descendants_stmt
+			: odbc->get_object_descendants_with_ver_stmt;
+	}
 
-	entries.clear();
+	SQL_BIND_INTEGER(stmt, 1, id.hi);
+	SQL_BIND_INTEGER(stmt, 2, id.lo);
 
-	SQLHSTMT stmt = ((flags & CPL_I_NO_CREATION_SESSION) != 0)
-						? odbc->get_all_objects_stmt
-						: odbc->get_all_objects_with_session_stmt;
+	if (version != CPL_VERSION_NONE) {
+		SQL_BIND_INTEGER(stmt, 3, version);
+	}
 
 
 	// Execute
@@ -1856,49 +4533,15 @@ retry:
 	ret = SQLBindCol(stmt, 2, SQL_C_UBIGINT, &entry.id.lo, 0, NULL);
 	if (!SQL_SUCCEEDED(ret)) goto err_close;
 
-	ret = SQLBindCol(stmt, 3, SQL_C_TYPE_TIMESTAMP, &t, sizeof(t), NULL);
-	if (!SQL_SUCCEEDED(ret)) goto err_close;
-
-	ret = SQLBindCol(stmt, 4, SQL_C_CHAR, entry_originator, originator_size,
-					 NULL);
+	ret = SQLBindCol(stmt, 3, SQL_C_SLONG, &entry.version, 0, NULL);
 	if (!SQL_SUCCEEDED(ret)) goto err_close;
 
-	ret = SQLBindCol(stmt, 5, SQL_C_CHAR, entry_name, name_size, NULL);
+	ret = SQLBindCol(stmt, 4, SQL_C_SLONG, &entry.query_version, 0, NULL);
 	if (!SQL_SUCCEEDED(ret)) goto err_close;
 
-	ret = SQLBindCol(stmt, 6, SQL_C_CHAR, entry_type, type_size, NULL);
+	ret = SQLBindCol(stmt, 5, SQL_C_SLONG, &entry.type, 0, &ind_type);
 	if (!SQL_SUCCEEDED(ret)) goto err_close;
 
-    ret = SQLBindCol(stmt, 7, SQL_C_UBIGINT, &entry.container_id.hi, 0,
-                     &cb_container_id_lo);
-    if (!SQL_SUCCEEDED(ret)) goto err_close;
-
-    ret = SQLBindCol(stmt, 8, SQL_C_UBIGINT, &entry.container_id.lo, 0,
-                     &cb_container_id_hi);
-    if (!SQL_SUCCEEDED(ret)) goto err_close;
-
-    ret = SQLBindCol(stmt, 9, SQL_C_SBIGINT, &entry.container_version, 0,
-                     &cb_container_ver);
-    if (!SQL_SUCCEEDED(ret)) goto err_close;
-
-
-	if ((flags & CPL_I_NO_CREATION_SESSION) == 0) {
-
-		ret = SQLBindCol(stmt, 10, SQL_C_UBIGINT, &entry.creation_session.hi,0,
-						 &cb_container_id_lo);
-		if (!SQL_SUCCEEDED(ret)) goto err_close;
-
-		ret = SQLBindCol(stmt, 11, SQL_C_UBIGINT, &entry.creation_session.lo,0,
-						 &cb_container_id_hi);
-		if (!SQL_SUCCEEDED(ret)) goto err_close;
-	}
-    else {
-        
-        entry.creation_session = CPL_NONE;
-    }
-
-    entry.version = CPL_VERSION_NONE;
-
 
 	// Fetch the result
 
@@ -1906,26 +4549,26 @@ retry:
 
 		ret = SQLFetch(stmt);
 		if (!SQL_SUCCEEDED(ret)) {
-			if (ret == SQL_INVALID_HANDLE) {
-				fprintf(stderr, "\nThe ODBC driver failed while running "
-								"SQLFetch due to SQL_INVALID_HANDLE\n\n");
-				goto err_close;
-			}
-			else if (ret != SQL_NO_DATA) {
+			if (ret != SQL_NO_DATA) {
 				print_odbc_error("SQLFetch", stmt, SQL_HANDLE_STMT);
 				goto err_close;
 			}
 			break;
 		}
 
-		entry.creation_time = cpl_sql_timestamp_to_unix_time(t);
-		entry.originator = entry_originator;
-		entry.name = entry_name;
-		entry.type = entry_type;
+		found = true;
 
-		if (cb_container_id_lo <= 0) entry.container_id = CPL_NONE;
-		if (cb_container_id_hi <= 0) entry.container_id = CPL_NONE;
-		if (cb_container_ver   <= 0) entry.container_version =CPL_VERSION_NONE;
+		if (ind_type == SQL_NULL_DATA) {
+			// Should we handle NULL dependency types? They should never occur.
+			// entry.type = CPL_DEPENDENCY_NONE;
+			continue;
+		}
+
+		int type_category = CPL_GET_DEPENDENCY_CATEGORY((int) entry.type);
+		if (type_category == CPL_DEPENDENCY_CATEGORY_DATA
+				&& (flags & CPL_A_NO_DATA_DEPENDENCIES) != 0) continue;
+		if (type_category == CPL_DEPENDENCY_CATEGORY_CONTROL
+				&& (flags & CPL_A_NO_CONTROL_DEPENDENCIES) != 0) continue;
 
 		entries.push_back(entry);
 	}
@@ -1939,7 +4582,18 @@ retry:
 
 	// Unlock
 
-	mutex_unlock(odbc->get_all_objects_lock);
+	mutex_unlock(odbc->get_object_ancestry_lock);
+
+
+	// If we did not get any data back, check for whether the object exists.
+	// If the version is set, the library already verified that the object
+	// actually exists.
+
+	if (!found && version != CPL_VERSION_NONE) {
+		// XXX This is ugly and potentially quite slow
+		r = cpl_odbc_get_version(backend, id, NULL);
+		if (!CPL_IS_SUCCESS(r)) return r;
+	}
 
 
 	// If we did not get any data back, terminate
@@ -1950,40 +4604,195 @@ retry:
 	// Call the user-provided callback function
 
 	if (iterator != NULL) {
-		std::list<cplxx_object_info_t>::iterator i;
+		std::list<__get_object_ancestry__entry_t>::iterator i;
 		for (i = entries.begin(); i != entries.end(); i++) {
+			r = iterator(id, (cpl_version_t) i->query_version,
+						 i->id, (cpl_version_t) i->version,
+						 (int) i->type, context);
+			if (!CPL_IS_OK(r)) return r;
+		}
+	}
 
-#ifdef _WINDOWS
-			strcpy_s(entry_originator, originator_size, i->originator.c_str());
-			strcpy_s(entry_name, name_size, i->name.c_str());
-			strcpy_s(entry_type, type_size, i->type.c_str());
-#else
-			strncpy(entry_originator, i->originator.c_str(), originator_size);
-			strncpy(entry_name, i->name.c_str(), name_size);
-			strncpy(entry_type, i->type.c_str(), type_size);
-#endif
-			entry_originator[originator_size - 1] = '\0';
-			entry_name[name_size - 1] = '\0';
-			entry_type[type_size - 1] = '\0';
+	return CPL_OK;
+
+
+	// Error handling
+
+err_close:
+	ret = SQLCloseCursor(stmt);
+	if (!SQL_SUCCEEDED(ret)) {
+		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
+	}
+
+err:
+	mutex_unlock(odbc->get_object_ancestry_lock);
+	return CPL_E_STATEMENT_ERROR;
+}
+
+
+/**
+ * An entry in the result set of the queries issued by
+ * cpl_odbc_get_object_ancestry_batch().
+ */
+typedef struct __get_object_ancestry_batch__entry {
+	cpl_id_t id;
+	long version;
+	cpl_id_t query_id;
+	long query_version;
+	long type;
+} __get_object_ancestry_batch__entry_t;
+
+
+/**
+ * Iterate over the immediate ancestors or descendants of several version
+ * nodes at once, fetching up to CPL_ODBC_BATCH_SIZE nodes per query.
+ *
+ * @param backend the pointer to the backend structure
+ * @param nodes the array of version nodes (the versions must not be
+ *              CPL_VERSION_NONE)
+ * @param count the number of nodes in the array
+ * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+ *                  or CPL_D_DESCENDANTS)
+ * @param flags the bitwise combination of flags describing how should
+ *              the graph be traversed (a logical combination of the
+ *              CPL_A_* flags)
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+cpl_return_t
+cpl_odbc_get_object_ancestry_batch(struct _cpl_db_backend_t* backend,
+								   const cpl_id_version_t* nodes,
+								   const size_t count,
+								   const int direction,
+								   const int flags,
+								   cpl_ancestry_iterator_t iterator,
+								   void* context)
+{
+	assert(backend != NULL);
+	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+
+	if ((flags & ~CPL_ODBC_A_SUPPORTED_FLAGS) != 0) {
+		return CPL_E_NOT_IMPLEMENTED;
+	}
+	if (direction != CPL_D_ANCESTORS && direction != CPL_D_DESCENDANTS) {
+		return CPL_E_INVALID_ARGUMENT;
+	}
+	for (size_t i = 0; i < count; i++) {
+		if (nodes[i].version == CPL_VERSION_NONE) {
+			return CPL_E_INVALID_ARGUMENT;
+		}
+	}
+
+	SQL_START;
+
+	cpl_return_t r = CPL_E_INTERNAL_ERROR;
+
+	std::list<__get_object_ancestry_batch__entry_t> entries;
+	__get_object_ancestry_batch__entry_t entry;
+	SQLLEN ind_type;
+	size_t start = 0;
+
+	SQLHSTMT stmt = direction == CPL_D_ANCESTORS
+		? odbc->get_object_ancestors_batch_stmt
+		: odbc->get_object_descendants_batch_stmt;
+
+	mutex_lock(odbc->get_object_ancestry_lock);
+
+
+	// Run one query per CPL_ODBC_BATCH_SIZE nodes, padding the last batch
+	// by repeating its last node
+
+	for (start = 0; start < count; start += CPL_ODBC_BATCH_SIZE) {
+
+retry:
+		for (int i = 0; i < CPL_ODBC_BATCH_SIZE; i++) {
+			size_t k = start + i < count ? start + i : count - 1;
+			SQL_BIND_INTEGER(stmt, 3 * i + 1, nodes[k].id.hi);
+			SQL_BIND_INTEGER(stmt, 3 * i + 2, nodes[k].id.lo);
+			SQL_BIND_INTEGER(stmt, 3 * i + 3, nodes[k].version);
+		}
+
+
+		// Execute
+
+		SQL_EXECUTE(stmt);
+
+
+		// Bind the columns
+
+		ret = SQLBindCol(stmt, 1, SQL_C_UBIGINT, &entry.id.hi, 0, NULL);
+		if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+		ret = SQLBindCol(stmt, 2, SQL_C_UBIGINT, &entry.id.lo, 0, NULL);
+		if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+		ret = SQLBindCol(stmt, 3, SQL_C_SLONG, &entry.version, 0, NULL);
+		if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+		ret = SQLBindCol(stmt, 4, SQL_C_UBIGINT, &entry.query_id.hi, 0, NULL);
+		if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+		ret = SQLBindCol(stmt, 5, SQL_C_UBIGINT, &entry.query_id.lo, 0, NULL);
+		if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+		ret = SQLBindCol(stmt, 6, SQL_C_SLONG, &entry.query_version, 0, NULL);
+		if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+		ret = SQLBindCol(stmt, 7, SQL_C_SLONG, &entry.type, 0, &ind_type);
+		if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+
+		// Fetch the result
+
+		while (true) {
+
+			ret = SQLFetch(stmt);
+			if (!SQL_SUCCEEDED(ret)) {
+				if (ret != SQL_NO_DATA) {
+					print_odbc_error("SQLFetch", stmt, SQL_HANDLE_STMT);
+					goto err_close;
+				}
+				break;
+			}
+
+			if (ind_type == SQL_NULL_DATA) continue;
+
+			int type_category = CPL_GET_DEPENDENCY_CATEGORY((int) entry.type);
+			if (type_category == CPL_DEPENDENCY_CATEGORY_DATA
+					&& (flags & CPL_A_NO_DATA_DEPENDENCIES) != 0) continue;
+			if (type_category == CPL_DEPENDENCY_CATEGORY_CONTROL
+					&& (flags & CPL_A_NO_CONTROL_DEPENDENCIES) != 0) continue;
+
+			entries.push_back(entry);
+		}
+
+		ret = SQLCloseCursor(stmt);
+		if (!SQL_SUCCEEDED(ret)) {
+			print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
+			goto err;
+		}
+	}
+
+
+	// Unlock
+
+	mutex_unlock(odbc->get_object_ancestry_lock);
 
-			cpl_version_t version = CPL_VERSION_NONE;
-			if ((flags & CPL_I_NO_VERSION) == 0) {
-				cpl_return_t r = cpl_odbc_get_version(backend, i->id,&version);
-				if (!CPL_IS_OK(r)) return r;
-			}
 
-			cpl_object_info_t e;
-			e.id = i->id;
-			e.version = version;
-			e.creation_session = i->creation_session;
-			e.creation_time = i->creation_time;
-			e.originator = entry_originator;
-			e.name = entry_name;
-			e.type = entry_type;
-			e.container_id = i->container_id;
-			e.container_version = i->container_version;
+	// If we did not get any data back, terminate
 
-			r = iterator(&e, context);
+	if (entries.empty()) return CPL_S_NO_DATA;
+
+
+	// Call the user-provided callback function
+
+	if (iterator != NULL) {
+		std::list<__get_object_ancestry_batch__entry_t>::iterator i;
+		for (i = entries.begin(); i != entries.end(); i++) {
+			r = iterator(i->query_id, (cpl_version_t) i->query_version,
+						 i->id, (cpl_version_t) i->version,
+						 (int) i->type, context);
 			if (!CPL_IS_OK(r)) return r;
 		}
 	}
@@ -2000,106 +4809,108 @@ err_close:
 	}
 
 err:
-	mutex_unlock(odbc->get_all_objects_lock);
+	mutex_unlock(odbc->get_object_ancestry_lock);
 	return CPL_E_STATEMENT_ERROR;
 }
 
 
 /**
- * Get information about the given provenance object
+ * An entry in the result set of the queries issued by
+ * cpl_odbc_get_transitive_ancestry().
+ */
+typedef struct __get_transitive_ancestry__entry {
+	cpl_id_t id;
+	long version;
+} __get_transitive_ancestry__entry_t;
+
+
+/**
+ * Iterate over all transitive ancestors or descendants of a version node,
+ * including the other versions of the same object, using a single lookup
+ * in the ancestry closure.
  *
  * @param backend the pointer to the backend structure
  * @param id the object ID
- * @param version_hint the version of the given provenance object if known,
- *                     or CPL_VERSION_NONE if not
- * @param out_info the pointer to store the object info structure
- * @return CPL_OK or an error code
+ * @param version the object version (must not be CPL_VERSION_NONE)
+ * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+ *                  or CPL_D_DESCENDANTS)
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA, CPL_E_NOT_IMPLEMENTED if the database
+ *         does not have the closure table, or an error code
  */
 cpl_return_t
-cpl_odbc_get_object_info(struct _cpl_db_backend_t* backend,
-						 const cpl_id_t id,
-						 const cpl_version_t version_hint,
-						 cpl_object_info_t** out_info)
+cpl_odbc_get_transitive_ancestry(struct _cpl_db_backend_t* backend,
+								 const cpl_id_t id,
+								 const cpl_version_t version,
+								 const int direction,
+								 cpl_ancestry_iterator_t iterator,
+								 void* context)
 {
 	assert(backend != NULL);
-	
 	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
-	
-	SQL_START;
 
-	cpl_return_t r = CPL_E_INTERNAL_ERROR;
-	long long l;
+	if (!odbc->has_closure) return CPL_E_NOT_IMPLEMENTED;
+	if (version == CPL_VERSION_NONE) return CPL_E_INVALID_ARGUMENT;
+	if (direction != CPL_D_ANCESTORS && direction != CPL_D_DESCENDANTS) {
+		return CPL_E_INVALID_ARGUMENT;
+	}
 
-	cpl_object_info_t* p = (cpl_object_info_t*) malloc(sizeof(*p));
-	if (p == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
-	memset(p, 0, sizeof(*p));
-	p->id = id;
+	SQL_START;
 
+	cpl_return_t r = CPL_E_INTERNAL_ERROR;
 
-	// Get the version
+	std::list<__get_transitive_ancestry__entry_t> entries;
+	__get_transitive_ancestry__entry_t entry;
 
-	if (version_hint == CPL_VERSION_NONE) {
-		r = cpl_odbc_get_version(backend, id, &p->version);
-		if (!CPL_IS_OK(r)) {
-			free(p);
-			return r;
-		}
-	}
-	else {
-		p->version = version_hint;
-	}
+	mutex_lock(odbc->get_object_ancestry_lock);
 
 
 	// Prepare the statement
 
-	mutex_lock(odbc->get_object_info_lock);
-
 retry:
-	SQLHSTMT stmt = odbc->get_object_info_stmt;
+	SQLHSTMT stmt = direction == CPL_D_ANCESTORS
+		? odbc->get_closure_ancestors_stmt
+		: odbc->get_closure_descendants_stmt;
 
 	SQL_BIND_INTEGER(stmt, 1, id.hi);
 	SQL_BIND_INTEGER(stmt, 2, id.lo);
+	SQL_BIND_INTEGER(stmt, 3, version);
 
 
 	// Execute
-	
+
 	SQL_EXECUTE(stmt);
 
 
+	// Bind the columns
+
+	ret = SQLBindCol(stmt, 1, SQL_C_UBIGINT, &entry.id.hi, 0, NULL);
+	if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+	ret = SQLBindCol(stmt, 2, SQL_C_UBIGINT, &entry.id.lo, 0, NULL);
+	if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+	ret = SQLBindCol(stmt, 3, SQL_C_SLONG, &entry.version, 0, NULL);
+	if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+
 	// Fetch the result
 
-	CPL_SQL_SIMPLE_FETCH(llong, 1, (long long*) &p->creation_session.hi);
-	CPL_SQL_SIMPLE_FETCH(llong, 2, (long long*) &p->creation_session.lo);
-	CPL_SQL_SIMPLE_FETCH(timestamp_as_unix_time, 3, &p->creation_time);
+	while (true) {
 
-	CPL_SQL_SIMPLE_FETCH_EXT(dynamically_allocated_string, 4, &p->originator,
-							 true);
-#ifdef _WINDOWS
-	if (r == CPL_E_DB_NULL) p->originator = _strdup("");
-#else
-	if (r == CPL_E_DB_NULL) p->originator = strdup("");
-#endif
-	CPL_SQL_SIMPLE_FETCH_EXT(dynamically_allocated_string, 5, &p->name, true);
-#ifdef _WINDOWS
-	if (r == CPL_E_DB_NULL) p->name = _strdup("");
-#else
-	if (r == CPL_E_DB_NULL) p->name = strdup("");
-#endif
-	CPL_SQL_SIMPLE_FETCH_EXT(dynamically_allocated_string, 6, &p->type, true);
-#ifdef _WINDOWS
-	if (r == CPL_E_DB_NULL) p->type = _strdup("");
-#else
-	if (r == CPL_E_DB_NULL) p->type = strdup("");
-#endif
+		ret = SQLFetch(stmt);
+		if (!SQL_SUCCEEDED(ret)) {
+			if (ret != SQL_NO_DATA) {
+				print_odbc_error("SQLFetch", stmt, SQL_HANDLE_STMT);
+				goto err_close;
+			}
+			break;
+		}
+
+		entries.push_back(entry);
+	}
 
-	CPL_SQL_SIMPLE_FETCH_EXT(llong, 7, (long long*) &p->container_id.hi, true);
-	if (r == CPL_E_DB_NULL) p->container_id = CPL_NONE;
-	CPL_SQL_SIMPLE_FETCH_EXT(llong, 8, (long long*) &p->container_id.lo, true);
-	if (r == CPL_E_DB_NULL) p->container_id = CPL_NONE;
-	CPL_SQL_SIMPLE_FETCH_EXT(llong, 9, &l, true);
-	if (r == CPL_E_DB_NULL) l = CPL_VERSION_NONE;
-	p->container_version = (cpl_version_t) l;
-	
 	ret = SQLCloseCursor(stmt);
 	if (!SQL_SUCCEEDED(ret)) {
 		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
@@ -2107,83 +4918,172 @@ retry:
 	}
 
 
-	// Cleanup
+	// Unlock
+
+	mutex_unlock(odbc->get_object_ancestry_lock);
+
+
+	// If we did not get any data back, terminate
+
+	if (entries.empty()) return CPL_S_NO_DATA;
+
+
+	// Call the user-provided callback function
+
+	if (iterator != NULL) {
+		std::list<__get_transitive_ancestry__entry_t>::iterator i;
+		for (i = entries.begin(); i != entries.end(); i++) {
+			r = iterator(id, version, i->id, (cpl_version_t) i->version,
+						 CPL_DEPENDENCY_NONE, context);
+			if (!CPL_IS_OK(r)) return r;
+		}
+	}
 
-	mutex_unlock(odbc->get_object_info_lock);
-	
-	*out_info = p;
 	return CPL_OK;
 
 
 	// Error handling
 
-err:
-	r = CPL_E_STATEMENT_ERROR;
+err_close:
+	ret = SQLCloseCursor(stmt);
+	if (!SQL_SUCCEEDED(ret)) {
+		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
+	}
 
-err_r:
-	mutex_unlock(odbc->get_object_info_lock);
+err:
+	mutex_unlock(odbc->get_object_ancestry_lock);
+	return CPL_E_STATEMENT_ERROR;
+}
 
-	if (p->originator != NULL) free(p->originator);
-	if (p->name != NULL) free(p->name);
-	if (p->type != NULL) free(p->type);
-	free(p);
 
-	return r;
-}
+/**
+ * An entry in the result set of the queries issued by
+ * cpl_odbc_get_properties().
+ */
+typedef struct __get_properties__entry {
+	cpl_id_t id;
+	long version;
+	SQLCHAR key[256];
+	SQLCHAR value[4096];
+} __get_properties__entry_t;
 
 
 /**
- * Get information about the specific version of a provenance object
+ * Get the properties associated with the given provenance object.
  *
  * @param backend the pointer to the backend structure
- * @param id the object ID
- * @param version the version of the given provenance object
- * @param out_info the pointer to store the version info structure
- * @return CPL_OK or an error code
+ * @param id the the object ID
+ * @param version the object version, or CPL_VERSION_NONE to access all
+ *                version nodes associated with the given object
+ * @param key the property to fetch - or NULL for all properties
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
  */
 cpl_return_t
-cpl_odbc_get_version_info(struct _cpl_db_backend_t* backend,
-						  const cpl_id_t id,
-						  const cpl_version_t version,
-						  cpl_version_info_t** out_info)
+cpl_odbc_get_properties(struct _cpl_db_backend_t* backend,
+						const cpl_id_t id,
+						const cpl_version_t version,
+						const char* key,
+						cpl_property_iterator_t iterator,
+						void* context)
 {
 	assert(backend != NULL);
 	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
-	
+
+	std::list<__get_properties__entry_t*> entries;
+	__get_properties__entry_t entry;
+	SQLLEN ind_key, ind_value;
+
 	SQL_START;
 
 	cpl_return_t r = CPL_E_INTERNAL_ERROR;
+	bool found = false;
+	std::list<__get_properties__entry_t*>::iterator i;
 
-	cpl_version_info_t* p = (cpl_version_info_t*) malloc(sizeof(*p));
-	if (p == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
-	memset(p, 0, sizeof(*p));
-	p->id = id;
-	p->version = version;
+	mutex_lock(odbc->get_properties_lock);
+
+
+	// Prepare the statement
+
+retry:
+	SQLHSTMT stmt;
+	int column_i = 3;
+	if (key == NULL) {
+		stmt = version == CPL_VERSION_NONE
+			? odbc->get_properties_stmt
+			: odbc->get_properties_with_ver_stmt;
+	}
+	else {
+		stmt = version == CPL_VERSION_NONE
+			? odbc->get_properties_with_key_stmt
+			: odbc->get_properties_with_key_ver_stmt;
+	}
+
+	SQL_BIND_INTEGER(stmt, 1, id.hi);
+	SQL_BIND_INTEGER(stmt, 2, id.lo);
+
+	if (key != NULL) {
+		SQL_BIND_VARCHAR(stmt, column_i, 255, key);
+		column_i++;
+	}
+	if (version != CPL_VERSION_NONE) {
+		SQL_BIND_INTEGER(stmt, column_i, version);
+		column_i++;
+	}
+
+
+	// Execute
+	
+	SQL_EXECUTE(stmt);
 
-	mutex_lock(odbc->get_version_info_lock);
 
+	// Bind the columns
 
-	// Prepare the statement
+	ret = SQLBindCol(stmt, 1, SQL_C_UBIGINT, &entry.id.hi, 0, NULL);
+	if (!SQL_SUCCEEDED(ret)) goto err_close;
 
-retry:
-	SQLHSTMT stmt = odbc->get_version_info_stmt;
+	ret = SQLBindCol(stmt, 2, SQL_C_UBIGINT, &entry.id.lo, 0, NULL);
+	if (!SQL_SUCCEEDED(ret)) goto err_close;
 
-	SQL_BIND_INTEGER(stmt, 1, id.hi);
-	SQL_BIND_INTEGER(stmt, 2, id.lo);
-	SQL_BIND_INTEGER(stmt, 3, version);
+	ret = SQLBindCol(stmt, 3, SQL_C_SLONG, &entry.version, 0, NULL);
+	if (!SQL_SUCCEEDED(ret)) goto err_close;
 
+	ret = SQLBindCol(stmt, 4, SQL_C_CHAR, entry.key, sizeof(entry.key),
+			&ind_key);
+	if (!SQL_SUCCEEDED(ret)) goto err_close;
 
-	// Execute
-	
-	SQL_EXECUTE(stmt);
+	ret = SQLBindCol(stmt, 5, SQL_C_CHAR, entry.value, sizeof(entry.value),
+			&ind_value);
+	if (!SQL_SUCCEEDED(ret)) goto err_close;
 
 
 	// Fetch the result
 
-	CPL_SQL_SIMPLE_FETCH(llong, 1, (long long*) &p->session.hi);
-	CPL_SQL_SIMPLE_FETCH(llong, 2, (long long*) &p->session.lo);
-	CPL_SQL_SIMPLE_FETCH(timestamp_as_unix_time, 3, &p->creation_time);
+	while (true) {
+
+		ret = SQLFetch(stmt);
+		if (!SQL_SUCCEEDED(ret)) {
+			if (ret != SQL_NO_DATA) {
+				print_odbc_error("SQLFetch", stmt, SQL_HANDLE_STMT);
+				goto err_close;
+			}
+			break;
+		}
+
+		found = true;
+
+		if (ind_key == SQL_NULL_DATA || ind_value == SQL_NULL_DATA) {
+			// NULLs should never occur here
+			continue;
+		}
+
+		__get_properties__entry_t* e = new __get_properties__entry_t;
+		memcpy(e, (const void*) &entry, sizeof(*e));
 
+		entries.push_back(e);
+	}
+	
 	ret = SQLCloseCursor(stmt);
 	if (!SQL_SUCCEEDED(ret)) {
 		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
@@ -2191,104 +5091,108 @@ retry:
 	}
 
 
-	// Cleanup
+	// Unlock
 
-	mutex_unlock(odbc->get_version_info_lock);
-	
-	*out_info = p;
-	return CPL_OK;
+	mutex_unlock(odbc->get_properties_lock);
 
 
-	// Error handling
+	// If we did not get any data back, check for whether the object exists.
+	// If the version is set, the library already verified that the object
+	// actually exists.
 
-err:
-	r = CPL_E_STATEMENT_ERROR;
+	if (!found && version != CPL_VERSION_NONE) {
+		// XXX This is ugly and potentially quite slow
+		r = cpl_odbc_get_version(backend, id, NULL);
+		if (!CPL_IS_SUCCESS(r)) goto err_free;
+	}
 
-err_r:
-	mutex_unlock(odbc->get_version_info_lock);
 
-	free(p);
+	// If we did not get any data back, terminate
+
+	if (entries.empty()) return CPL_S_NO_DATA;
+
+
+	// Call the user-provided callback function
+
+	if (iterator != NULL) {
+		for (i = entries.begin(); i != entries.end(); i++) {
+			r = iterator(id, (cpl_version_t) (*i)->version,
+						 (const char*) (*i)->key,
+						 (const char*) (*i)->value,
+						 context);
+			if (!CPL_IS_OK(r)) goto err_free;
+		}
+	}
+
+	r = CPL_OK;
+
+
+	// Error handling
+
+err_free:
+	for (i = entries.begin(); i != entries.end(); i++) {
+		delete *i;
+	}
 	return r;
+
+err_close:
+	ret = SQLCloseCursor(stmt);
+	if (!SQL_SUCCEEDED(ret)) {
+		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
+	}
+
+err:
+	mutex_unlock(odbc->get_properties_lock);
+	return CPL_E_STATEMENT_ERROR;
 }
 
 
 /**
  * An entry in the result set of the queries issued by
- * cpl_odbc_get_object_ancestry().
+ * cpl_odbc_lookup_by_property().
  */
-typedef struct __get_object_ancestry__entry {
+typedef struct __lookup_by_property__entry {
 	cpl_id_t id;
 	long version;
-	long query_version;
-	long type;
-} __get_object_ancestry__entry_t;
+} __lookup_by_property__entry_t;
 
 
 /**
- * Iterate over the ancestors or the descendants of a provenance object.
+ * Lookup an object based on a property value.
  *
  * @param backend the pointer to the backend structure
- * @param id the object ID
- * @param version the object version, or CPL_VERSION_NONE to access all
- *                version nodes associated with the given object
- * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
- *                  or CPL_D_DESCENDANTS)
- * @param flags the bitwise combination of flags describing how should
- *              the graph be traversed (a logical combination of the
- *              CPL_A_* flags)
+ * @param key the property name
+ * @param value the property value
  * @param iterator the iterator callback function
  * @param context the user context to be passed to the iterator function
- * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ * @return CPL_OK, CPL_E_NOT_FOUND, or an error code
  */
 cpl_return_t
-cpl_odbc_get_object_ancestry(struct _cpl_db_backend_t* backend,
-							 const cpl_id_t id,
-							 const cpl_version_t version,
-							 const int direction,
-							 const int flags,
-							 cpl_ancestry_iterator_t iterator,
-							 void* context)
+cpl_odbc_lookup_by_property(struct _cpl_db_backend_t* backend,
+							const char* key,
+							const char* value,
+							cpl_property_iterator_t iterator,
+							void* context)
 {
 	assert(backend != NULL);
 	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
 
-	if ((flags & ~CPL_ODBC_A_SUPPORTED_FLAGS) != 0) {
-		return CPL_E_NOT_IMPLEMENTED;
-	}
-	
 	SQL_START;
 
 	cpl_return_t r = CPL_E_INTERNAL_ERROR;
 
-	std::list<__get_object_ancestry__entry_t> entries;
-	__get_object_ancestry__entry_t entry;
-	SQLLEN ind_type;
-	bool found = false;
+	std::list<__lookup_by_property__entry_t> entries;
+	__lookup_by_property__entry_t entry;
 
-	mutex_lock(odbc->get_object_ancestry_lock);
+	mutex_lock(odbc->lookup_by_property_lock);
 
 
 	// Prepare the statement
 
 retry:
-	SQLHSTMT stmt;
-	if (direction == CPL_D_ANCESTORS) {
-		stmt = version == CPL_VERSION_NONE
-			? odbc->get_object_ancestors_stmt
-			: odbc->get_object_ancestors_with_ver_stmt;
-	}
-	else {
-		stmt = version == CPL_VERSION_NONE
-			? odbc->get_object_descendants_stmt
-			: odbc->get_object_descendants_with_ver_stmt;
-	}
-
-	SQL_BIND_INTEGER(stmt, 1, id.hi);
-	SQL_BIND_INTEGER(stmt, 2, id.lo);
-
-	if (version != CPL_VERSION_NONE) {
-		SQL_BIND_INTEGER(stmt, 3, version);
-	}
+	SQLHSTMT stmt = odbc->lookup_by_property_stmt;
+	SQL_BIND_VARCHAR(stmt, 1, 255, key);
+	SQL_BIND_VARCHAR(stmt, 2, 4095, value);
 
 
 	// Execute
@@ -2307,12 +5211,6 @@ retry:
 	ret = SQLBindCol(stmt, 3, SQL_C_SLONG, &entry.version, 0, NULL);
 	if (!SQL_SUCCEEDED(ret)) goto err_close;
 
-	ret = SQLBindCol(stmt, 4, SQL_C_SLONG, &entry.query_version, 0, NULL);
-	if (!SQL_SUCCEEDED(ret)) goto err_close;
-
-	ret = SQLBindCol(stmt, 5, SQL_C_SLONG, &entry.type, 0, &ind_type);
-	if (!SQL_SUCCEEDED(ret)) goto err_close;
-
 
 	// Fetch the result
 
@@ -2327,20 +5225,6 @@ retry:
 			break;
 		}
 
-		found = true;
-
-		if (ind_type == SQL_NULL_DATA) {
-			// Should we handle NULL dependency types? They should never occur.
-			// entry.type = CPL_DEPENDENCY_NONE;
-			continue;
-		}
-
-		int type_category = CPL_GET_DEPENDENCY_CATEGORY((int) entry.type);
-		if (type_category == CPL_DEPENDENCY_CATEGORY_DATA
-				&& (flags & CPL_A_NO_DATA_DEPENDENCIES) != 0) continue;
-		if (type_category == CPL_DEPENDENCY_CATEGORY_CONTROL
-				&& (flags & CPL_A_NO_CONTROL_DEPENDENCIES) != 0) continue;
-
 		entries.push_back(entry);
 	}
 	
@@ -2353,33 +5237,21 @@ retry:
 
 	// Unlock
 
-	mutex_unlock(odbc->get_object_ancestry_lock);
-
-
-	// If we did not get any data back, check for whether the object exists.
-	// If the version is set, the library already verified that the object
-	// actually exists.
-
-	if (!found && version != CPL_VERSION_NONE) {
-		// XXX This is ugly and potentially quite slow
-		r = cpl_odbc_get_version(backend, id, NULL);
-		if (!CPL_IS_SUCCESS(r)) return r;
-	}
+	mutex_unlock(odbc->lookup_by_property_lock);
 
 
 	// If we did not get any data back, terminate
 
-	if (entries.empty()) return CPL_S_NO_DATA;
+	if (entries.empty()) return CPL_E_NOT_FOUND;
 
 
 	// Call the user-provided callback function
 
 	if (iterator != NULL) {
-		std::list<__get_object_ancestry__entry_t>::iterator i;
+		std::list<__lookup_by_property__entry_t>::iterator i;
 		for (i = entries.begin(); i != entries.end(); i++) {
-			r = iterator(id, (cpl_version_t) i->query_version,
-						 i->id, (cpl_version_t) i->version,
-						 (int) i->type, context);
+			r = iterator(i->id, (cpl_version_t) i->version,
+						 key, value, context);
 			if (!CPL_IS_OK(r)) return r;
 		}
 	}
@@ -2387,94 +5259,241 @@ retry:
 	return CPL_OK;
 
 
-	// Error handling
+	// Error handling
+
+err_close:
+	ret = SQLCloseCursor(stmt);
+	if (!SQL_SUCCEEDED(ret)) {
+		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
+	}
+
+err:
+	mutex_unlock(odbc->lookup_by_property_lock);
+	return CPL_E_STATEMENT_ERROR;
+}
+
+
+/**
+ * The number of characters at the beginning of a property value that are
+ * covered by the cpl_properties_name_value index
+ */
+#define CPL_ODBC_PROPERTY_INDEX_PREFIX	255
+
+
+/**
+ * Determine the order in which to intersect the sets of objects that match
+ * the given property predicates, so that the most selective index lookups
+ * come first: the exact matches, then the shortest IN-lists, and finally
+ * the prefix matches, which scan ranges of the index
+ *
+ * @param a the first predicate
+ * @param b the second predicate
+ * @return true if the first predicate should come before the second
+ */
+static bool
+cpl_odbc_predicate_order(const cpl_property_predicate_t* a,
+						 const cpl_property_predicate_t* b)
+{
+	int ra = a->op == CPL_PQ_EQUALS ? 0 : a->op == CPL_PQ_IN ? 1 : 2;
+	int rb = b->op == CPL_PQ_EQUALS ? 0 : b->op == CPL_PQ_IN ? 1 : 2;
+
+	if (ra != rb) return ra < rb;
+	return a->num_values < b->num_values;
+}
+
+
+/**
+ * Create the text of the statement for cpl_odbc_query_by_properties(). Each
+ * predicate selects the IDs of the matching objects using a lookup in the
+ * cpl_properties_name_value index, and the results are intersected by
+ * joining them on the object IDs before joining with cpl_objects, which is
+ * filtered by the originator and the type.
+ *
+ * PostgreSQL indexes only the first CPL_ODBC_PROPERTY_INDEX_PREFIX characters
+ * of the values (since the values can exceed the maximum size of a B-tree
+ * key), so the conditions on the values are expressed both on this prefix,
+ * for the index lookup, and on the complete value.
+ *
+ * @param db_type the database type
+ * @param originator the object originator, or NULL for any
+ * @param type the object type, or NULL for any
+ * @param predicates the array of property predicates
+ * @param num_predicates the number of predicates
+ * @param params the vector to which to append the statement parameters
+ * @return the statement text
+ */
+static std::string
+cpl_odbc_query_by_properties_sql(int db_type,
+								 const char* originator,
+								 const char* type,
+								 const cpl_property_predicate_t* predicates,
+								 const size_t num_predicates,
+								 std::vector<std::string>& params)
+{
+	std::ostringstream ss;
+	bool truncated = db_type == CPL_ODBC_POSTGRESQL;
+
+	std::vector<const cpl_property_predicate_t*> order;
+	for (size_t i = 0; i < num_predicates; i++) {
+		order.push_back(&predicates[i]);
+	}
+	std::stable_sort(order.begin(), order.end(), cpl_odbc_predicate_order);
+
+
+	// The intersection of the sets of matching objects
+
+	ss << "SELECT cpl_objects.id_hi, cpl_objects.id_lo,"
+	   << "       cpl_objects.creation_time"
+	   << "  FROM ";
+
+	for (size_t i = 0; i < order.size(); i++) {
+		const cpl_property_predicate_t* p = order[i];
+
+		if (i > 0) ss << " JOIN ";
+		ss << "(SELECT DISTINCT id_hi, id_lo"
+		   << "   FROM cpl_properties"
+		   << "  WHERE name = ?";
+		params.push_back(p->key);
+
+		switch (p->op) {
+
+			case CPL_PQ_EQUALS:
+				if (truncated) {
+					ss << " AND left(value, "
+					   << CPL_ODBC_PROPERTY_INDEX_PREFIX << ") = left(?, "
+					   << CPL_ODBC_PROPERTY_INDEX_PREFIX << ")";
+					params.push_back(p->values[0]);
+				}
+				ss << " AND value = ?";
+				params.push_back(p->values[0]);
+				break;
+
+			case CPL_PQ_IN:
+				if (truncated) {
+					ss << " AND left(value, "
+					   << CPL_ODBC_PROPERTY_INDEX_PREFIX << ") IN (";
+					for (size_t j = 0; j < p->num_values; j++) {
+						if (j > 0) ss << ", ";
+						ss << "left(?, " << CPL_ODBC_PROPERTY_INDEX_PREFIX
+						   << ")";
+						params.push_back(p->values[j]);
+					}
+					ss << ")";
+				}
+				ss << " AND value IN (";
+				for (size_t j = 0; j < p->num_values; j++) {
+					if (j > 0) ss << ", ";
+					ss << "?";
+					params.push_back(p->values[j]);
+				}
+				ss << ")";
+				break;
+
+			case CPL_PQ_PREFIX:
+				if (truncated) {
+					ss << " AND left(value, "
+					   << CPL_ODBC_PROPERTY_INDEX_PREFIX << ")"
+					   << " LIKE ? ESCAPE '!'";
+					params.push_back(cpl_odbc_like_prefix(p->values[0],
+								CPL_ODBC_PROPERTY_INDEX_PREFIX));
+				}
+				ss << " AND value LIKE ? ESCAPE '!'";
+				params.push_back(cpl_odbc_like_prefix(p->values[0],
+							(size_t) -1));
+				break;
+
+			default:
+				assert(0);
+		}
+
+		ss << ") p" << i;
+		if (i > 0) {
+			ss << " ON p" << i << ".id_hi = p0.id_hi"
+			   << " AND p" << i << ".id_lo = p0.id_lo";
+		}
+	}
+
+
+	// The objects
+
+	if (order.empty()) {
+		ss << "cpl_objects";
+	}
+	else {
+		ss << " JOIN cpl_objects"
+		   << " ON cpl_objects.id_hi = p0.id_hi"
+		   << " AND cpl_objects.id_lo = p0.id_lo";
+	}
 
-err_close:
-	ret = SQLCloseCursor(stmt);
-	if (!SQL_SUCCEEDED(ret)) {
-		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
+	ss << " WHERE 1 = 1";
+	if (originator != NULL) {
+		ss << " AND originator = ?";
+		params.push_back(originator);
+	}
+	if (type != NULL) {
+		ss << " AND type = ?";
+		params.push_back(type);
 	}
 
-err:
-	mutex_unlock(odbc->get_object_ancestry_lock);
-	return CPL_E_STATEMENT_ERROR;
+	return ss.str();
 }
 
 
 /**
- * An entry in the result set of the queries issued by
- * cpl_odbc_get_properties().
- */
-typedef struct __get_properties__entry {
-	cpl_id_t id;
-	long version;
-	SQLCHAR key[256];
-	SQLCHAR value[4096];
-} __get_properties__entry_t;
-
-
-/**
- * Get the properties associated with the given provenance object.
+ * Find the objects that satisfy all of the given property predicates, and
+ * optionally have the given originator and type.
  *
  * @param backend the pointer to the backend structure
- * @param id the the object ID
- * @param version the object version, or CPL_VERSION_NONE to access all
- *                version nodes associated with the given object
- * @param key the property to fetch - or NULL for all properties
- * @param iterator the iterator callback function
- * @param context the user context to be passed to the iterator function
- * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ * @param originator the object originator, or NULL for any
+ * @param type the object type, or NULL for any
+ * @param predicates the array of property predicates
+ * @param num_predicates the number of predicates
+ * @param iterator the iterator to be called for each matching object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_E_NOT_FOUND, or an error code
  */
 cpl_return_t
-cpl_odbc_get_properties(struct _cpl_db_backend_t* backend,
-						const cpl_id_t id,
-						const cpl_version_t version,
-						const char* key,
-						cpl_property_iterator_t iterator,
-						void* context)
+cpl_odbc_query_by_properties(struct _cpl_db_backend_t* backend,
+							 const char* originator,
+							 const char* type,
+							 const cpl_property_predicate_t* predicates,
+							 const size_t num_predicates,
+							 cpl_id_timestamp_iterator_t iterator,
+							 void* context)
 {
 	assert(backend != NULL);
 	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
 
-	std::list<__get_properties__entry_t*> entries;
-	__get_properties__entry_t entry;
-	SQLLEN ind_key, ind_value;
-
 	SQL_START;
 
 	cpl_return_t r = CPL_E_INTERNAL_ERROR;
-	bool found = false;
-	std::list<__get_properties__entry_t*>::iterator i;
+	cpl_id_timestamp_t entry;
+	std::list<cpl_id_timestamp_t> entries;
+	SQL_TIMESTAMP_STRUCT t;
+	SQLHSTMT stmt = SQL_NULL_HSTMT;
 
-	mutex_lock(odbc->get_properties_lock);
+	std::vector<std::string> params;
+	std::string q = cpl_odbc_query_by_properties_sql(odbc->db_type,
+			originator, type, predicates, num_predicates, params);
 
 
-	// Prepare the statement
+	// Prepare the statement, which depends on the shape of the query, using
+	// a private statement handle. The handle is allocated again after a
+	// reconnect, which frees all statements of the old connection.
 
 retry:
-	SQLHSTMT stmt;
-	int column_i = 3;
-	if (key == NULL) {
-		stmt = version == CPL_VERSION_NONE
-			? odbc->get_properties_stmt
-			: odbc->get_properties_with_ver_stmt;
-	}
-	else {
-		stmt = version == CPL_VERSION_NONE
-			? odbc->get_properties_with_key_stmt
-			: odbc->get_properties_with_key_ver_stmt;
+	ret = SQLAllocHandle(SQL_HANDLE_STMT, odbc->db_connection, &stmt);
+	if (!SQL_SUCCEEDED(ret)) {
+		stmt = SQL_NULL_HSTMT;
+		goto err;
 	}
 
-	SQL_BIND_INTEGER(stmt, 1, id.hi);
-	SQL_BIND_INTEGER(stmt, 2, id.lo);
+	ret = SQLPrepare(stmt, (SQLCHAR*) q.c_str(), SQL_NTS);
+	SQL_ASSERT_NO_ERROR(SQLPrepare, stmt, err);
 
-	if (key != NULL) {
-		SQL_BIND_VARCHAR(stmt, column_i, 255, key);
-		column_i++;
-	}
-	if (version != CPL_VERSION_NONE) {
-		SQL_BIND_INTEGER(stmt, column_i, version);
-		column_i++;
+	for (size_t i = 0; i < params.size(); i++) {
+		SQL_BIND_VARCHAR(stmt, (int) i + 1, 4095,
+						 params[i].c_str());
 	}
 
 
@@ -2491,15 +5510,7 @@ retry:
 	ret = SQLBindCol(stmt, 2, SQL_C_UBIGINT, &entry.id.lo, 0, NULL);
 	if (!SQL_SUCCEEDED(ret)) goto err_close;
 
-	ret = SQLBindCol(stmt, 3, SQL_C_SLONG, &entry.version, 0, NULL);
-	if (!SQL_SUCCEEDED(ret)) goto err_close;
-
-	ret = SQLBindCol(stmt, 4, SQL_C_CHAR, entry.key, sizeof(entry.key),
-			&ind_key);
-	if (!SQL_SUCCEEDED(ret)) goto err_close;
-
-	ret = SQLBindCol(stmt, 5, SQL_C_CHAR, entry.value, sizeof(entry.value),
-			&ind_value);
+	ret = SQLBindCol(stmt, 3, SQL_C_TYPE_TIMESTAMP, &t, sizeof(t), NULL);
 	if (!SQL_SUCCEEDED(ret)) goto err_close;
 
 
@@ -2516,17 +5527,8 @@ retry:
 			break;
 		}
 
-		found = true;
-
-		if (ind_key == SQL_NULL_DATA || ind_value == SQL_NULL_DATA) {
-			// NULLs should never occur here
-			continue;
-		}
-
-		__get_properties__entry_t* e = new __get_properties__entry_t;
-		memcpy(e, (const void*) &entry, sizeof(*e));
-
-		entries.push_back(e);
+		entry.timestamp = cpl_sql_timestamp_to_unix_time(t);
+		entries.push_back(entry);
 	}
 	
 	ret = SQLCloseCursor(stmt);
@@ -2535,51 +5537,29 @@ retry:
 		goto err;
 	}
 
-
-	// Unlock
-
-	mutex_unlock(odbc->get_properties_lock);
-
-
-	// If we did not get any data back, check for whether the object exists.
-	// If the version is set, the library already verified that the object
-	// actually exists.
-
-	if (!found && version != CPL_VERSION_NONE) {
-		// XXX This is ugly and potentially quite slow
-		r = cpl_odbc_get_version(backend, id, NULL);
-		if (!CPL_IS_SUCCESS(r)) goto err_free;
-	}
+	SQLFreeHandle(SQL_HANDLE_STMT, stmt);
 
 
 	// If we did not get any data back, terminate
 
-	if (entries.empty()) return CPL_S_NO_DATA;
+	if (entries.empty()) return CPL_E_NOT_FOUND;
 
 
 	// Call the user-provided callback function
 
 	if (iterator != NULL) {
+		std::list<cpl_id_timestamp_t>::iterator i;
 		for (i = entries.begin(); i != entries.end(); i++) {
-			r = iterator(id, (cpl_version_t) (*i)->version,
-						 (const char*) (*i)->key,
-						 (const char*) (*i)->value,
-						 context);
-			if (!CPL_IS_OK(r)) goto err_free;
+			r = iterator(i->id, i->timestamp, context);
+			if (!CPL_IS_OK(r)) return r;
 		}
 	}
 
-	r = CPL_OK;
+	return CPL_OK;
 
 
 	// Error handling
 
-err_free:
-	for (i = entries.begin(); i != entries.end(); i++) {
-		delete *i;
-	}
-	return r;
-
 err_close:
 	ret = SQLCloseCursor(stmt);
 	if (!SQL_SUCCEEDED(ret)) {
@@ -2587,74 +5567,172 @@ err_close:
 	}
 
 err:
-	mutex_unlock(odbc->get_properties_lock);
+	if (stmt != SQL_NULL_HSTMT) SQLFreeHandle(SQL_HANDLE_STMT, stmt);
 	return CPL_E_STATEMENT_ERROR;
 }
 
+/**
+ * Create the text of the query that computes the given graph statistic.
+ * The query returns the key and the count, or the day, the originator, the
+ * type, and the count for CPL_GS_OBJECTS_PER_DAY, and it takes the start of
+ * the time range and, if bounded, its end as the parameters.
+ *
+ * @param kind the statistic (one of the CPL_GS_* constants)
+ * @param bounded whether the time range has an end
+ * @return the query text
+ */
+static std::string
+cpl_odbc_graph_statistics_sql(const int kind, const bool bounded)
+{
+	const char* range = bounded ? " BETWEEN ? AND ?" : " >= ?";
+	std::ostringstream ss;
+
+	switch (kind) {
+
+	case CPL_GS_EDGES_BY_TYPE:
+		ss << "SELECT a.type, COUNT(*)"
+			  " FROM cpl_ancestry a, cpl_versions v"
+			  " WHERE a.from_id_hi = v.id_hi AND a.from_id_lo = v.id_lo"
+			  " AND a.from_version = v.version"
+			  " AND v.creation_time" << range <<
+			  " GROUP BY a.type ORDER BY a.type;";
+		break;
+
+	case CPL_GS_VERSIONS_PER_OBJECT:
+		ss << "SELECT n, COUNT(*) FROM"
+			  " (SELECT COUNT(*) AS n FROM cpl_objects o, cpl_versions v"
+			  " WHERE o.id_hi = v.id_hi AND o.id_lo = v.id_lo"
+			  " AND o.creation_time" << range <<
+			  " GROUP BY o.id_hi, o.id_lo) c"
+			  " GROUP BY n ORDER BY n;";
+		break;
+
+	case CPL_GS_FAN_IN:
+	case CPL_GS_FAN_OUT: {
+		// The ancestry edges point from the dependent version to its
+		// ancestor, so the fan-in of a version node is the number of edges
+		// that start at it
+
+		const char* e = kind == CPL_GS_FAN_IN ? "a.from" : "a.to";
+		ss << "SELECT n, COUNT(*) FROM"
+			  " (SELECT COUNT(a.from_id_hi) AS n FROM cpl_versions v"
+			  " LEFT JOIN cpl_ancestry a"
+			  " ON " << e << "_id_hi = v.id_hi AND " << e << "_id_lo = v.id_lo"
+			  " AND " << e << "_version = v.version"
+			  " WHERE v.creation_time" << range <<
+			  " GROUP BY v.id_hi, v.id_lo, v.version) c"
+			  " GROUP BY n ORDER BY n;";
+		break;
+	}
+
+	case CPL_GS_OBJECTS_PER_DAY:
+		ss << "SELECT CAST(creation_time AS DATE), originator, type, COUNT(*)"
+			  " FROM cpl_objects"
+			  " WHERE creation_time" << range <<
+			  " GROUP BY CAST(creation_time AS DATE), originator, type"
+			  " ORDER BY 1, 2, 3;";
+		break;
+
+	default:
+		assert(0);
+	}
+
+	return ss.str();
+}
+
 
 /**
- * An entry in the result set of the queries issued by
- * cpl_odbc_lookup_by_property().
+ * A buffered row of the graph statistics
  */
-typedef struct __lookup_by_property__entry {
-	cpl_id_t id;
-	long version;
-} __lookup_by_property__entry_t;
+typedef struct {
+	long long key;
+	std::string originator;
+	std::string type;
+	unsigned long long count;
+} _cpl_odbc_graph_statistic_t;
 
 
 /**
- * Lookup an object based on a property value.
+ * Compute a single kind of the graph statistics using a private statement
+ * handle and append the results to the given list
  *
- * @param backend the pointer to the backend structure
- * @param key the property name
- * @param value the property value
- * @param iterator the iterator callback function
- * @param context the user context to be passed to the iterator function
- * @return CPL_OK, CPL_E_NOT_FOUND, or an error code
+ * @param odbc the ODBC backend
+ * @param kind the statistic (one of the CPL_GS_* constants)
+ * @param start_time the start of the time range (inclusive)
+ * @param end_time the end of the time range (inclusive), or 0
+ * @param out the list of the results
+ * @return CPL_OK or an error code
  */
-cpl_return_t
-cpl_odbc_lookup_by_property(struct _cpl_db_backend_t* backend,
-							const char* key,
-							const char* value,
-							cpl_property_iterator_t iterator,
-							void* context)
+static cpl_return_t
+cpl_odbc_fetch_graph_statistic(cpl_odbc_t* odbc,
+							   const int kind,
+							   const unsigned long start_time,
+							   const unsigned long end_time,
+							   std::list<_cpl_odbc_graph_statistic_t>& out)
 {
-	assert(backend != NULL);
-	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
-
 	SQL_START;
 
-	cpl_return_t r = CPL_E_INTERNAL_ERROR;
-
-	std::list<__lookup_by_property__entry_t> entries;
-	__lookup_by_property__entry_t entry;
+	_cpl_odbc_graph_statistic_t e;
+	long long key = 0;
+	unsigned long long count = 0;
+	SQL_TIMESTAMP_STRUCT t;
+	char originator[256];
+	char type[256];
+	SQLLEN originator_length = 0;
+	SQLLEN type_length = 0;
+	SQLHSTMT stmt = SQL_NULL_HSTMT;
+	bool per_day = kind == CPL_GS_OBJECTS_PER_DAY;
 
-	mutex_lock(odbc->lookup_by_property_lock);
+	std::string q = cpl_odbc_graph_statistics_sql(kind, end_time != 0);
+	std::list<_cpl_odbc_graph_statistic_t> entries;
 
 
-	// Prepare the statement
+	// Prepare the statement using a private statement handle, which is
+	// allocated again after a reconnect
 
 retry:
-	SQLHSTMT stmt = odbc->lookup_by_property_stmt;
-	SQL_BIND_VARCHAR(stmt, 1, 255, key);
-	SQL_BIND_VARCHAR(stmt, 2, 4095, value);
+	ret = SQLAllocHandle(SQL_HANDLE_STMT, odbc->db_connection, &stmt);
+	if (!SQL_SUCCEEDED(ret)) {
+		stmt = SQL_NULL_HSTMT;
+		goto err;
+	}
+
+	ret = SQLPrepare(stmt, (SQLCHAR*) q.c_str(), SQL_NTS);
+	SQL_ASSERT_NO_ERROR(SQLPrepare, stmt, err);
+
+	SQL_BIND_TIMESTAMP(stmt, 1, start_time);
+	if (end_time != 0) SQL_BIND_TIMESTAMP(stmt, 2, end_time);
 
 
 	// Execute
-	
+
 	SQL_EXECUTE(stmt);
 
 
 	// Bind the columns
 
-	ret = SQLBindCol(stmt, 1, SQL_C_UBIGINT, &entry.id.hi, 0, NULL);
-	if (!SQL_SUCCEEDED(ret)) goto err_close;
+	if (per_day) {
+		ret = SQLBindCol(stmt, 1, SQL_C_TYPE_TIMESTAMP, &t, sizeof(t), NULL);
+		if (!SQL_SUCCEEDED(ret)) goto err_close;
 
-	ret = SQLBindCol(stmt, 2, SQL_C_UBIGINT, &entry.id.lo, 0, NULL);
-	if (!SQL_SUCCEEDED(ret)) goto err_close;
+		ret = SQLBindCol(stmt, 2, SQL_C_CHAR, originator, sizeof(originator),
+						 &originator_length);
+		if (!SQL_SUCCEEDED(ret)) goto err_close;
 
-	ret = SQLBindCol(stmt, 3, SQL_C_SLONG, &entry.version, 0, NULL);
-	if (!SQL_SUCCEEDED(ret)) goto err_close;
+		ret = SQLBindCol(stmt, 3, SQL_C_CHAR, type, sizeof(type),
+						 &type_length);
+		if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+		ret = SQLBindCol(stmt, 4, SQL_C_UBIGINT, &count, 0, NULL);
+		if (!SQL_SUCCEEDED(ret)) goto err_close;
+	}
+	else {
+		ret = SQLBindCol(stmt, 1, SQL_C_SBIGINT, &key, 0, NULL);
+		if (!SQL_SUCCEEDED(ret)) goto err_close;
+
+		ret = SQLBindCol(stmt, 2, SQL_C_UBIGINT, &count, 0, NULL);
+		if (!SQL_SUCCEEDED(ret)) goto err_close;
+	}
 
 
 	// Fetch the result
@@ -2670,37 +5748,27 @@ retry:
 			break;
 		}
 
-		entries.push_back(entry);
+		if (per_day) {
+			e.key = cpl_sql_timestamp_to_unix_time(t);
+			e.originator = originator_length == SQL_NULL_DATA ? "" : originator;
+			e.type = type_length == SQL_NULL_DATA ? "" : type;
+		}
+		else {
+			e.key = key;
+		}
+		e.count = count;
+		entries.push_back(e);
 	}
-	
+
 	ret = SQLCloseCursor(stmt);
 	if (!SQL_SUCCEEDED(ret)) {
 		print_odbc_error("SQLCloseCursor", stmt, SQL_HANDLE_STMT);
 		goto err;
 	}
 
+	SQLFreeHandle(SQL_HANDLE_STMT, stmt);
 
-	// Unlock
-
-	mutex_unlock(odbc->lookup_by_property_lock);
-
-
-	// If we did not get any data back, terminate
-
-	if (entries.empty()) return CPL_E_NOT_FOUND;
-
-
-	// Call the user-provided callback function
-
-	if (iterator != NULL) {
-		std::list<__lookup_by_property__entry_t>::iterator i;
-		for (i = entries.begin(); i != entries.end(); i++) {
-			r = iterator(i->id, (cpl_version_t) i->version,
-						 key, value, context);
-			if (!CPL_IS_OK(r)) return r;
-		}
-	}
-
+	out.splice(out.end(), entries);
 	return CPL_OK;
 
 
@@ -2713,11 +5781,72 @@ err_close:
 	}
 
 err:
-	mutex_unlock(odbc->lookup_by_property_lock);
+	if (stmt != SQL_NULL_HSTMT) SQLFreeHandle(SQL_HANDLE_STMT, stmt);
 	return CPL_E_STATEMENT_ERROR;
 }
 
 
+/**
+ * Compute aggregate statistics about the provenance graph, attributing each
+ * object, version node, and edge to the time of its creation. The grouping
+ * is done by the database server, so only the aggregates are transferred.
+ *
+ * @param backend the pointer to the backend structure
+ * @param kinds a logical combination of the CPL_GS_* constants
+ * @param start_time the start of the time range (inclusive)
+ * @param end_time the end of the time range (inclusive), or 0
+ * @param iterator the iterator to be called for each group, ordered by
+ *                 kind and then by key
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+cpl_return_t
+cpl_odbc_get_graph_statistics(struct _cpl_db_backend_t* backend,
+							  const int kinds,
+							  const unsigned long start_time,
+							  const unsigned long end_time,
+							  cpl_graph_statistic_iterator_t iterator,
+							  void* context)
+{
+	assert(backend != NULL);
+	cpl_odbc_t* odbc = (cpl_odbc_t*) backend;
+
+	cpl_return_t r = CPL_E_INTERNAL_ERROR;
+	bool found = false;
+
+	for (int kind = 1; kind <= CPL_GS_ALL; kind <<= 1) {
+		if ((kinds & kind) == 0) continue;
+
+
+		// Compute the statistic, and only then call the iterator, so that
+		// the statement is no longer in use
+
+		std::list<_cpl_odbc_graph_statistic_t> entries;
+		r = cpl_odbc_fetch_graph_statistic(odbc, kind, start_time, end_time,
+										   entries);
+		if (!CPL_IS_OK(r)) return r;
+		if (!entries.empty()) found = true;
+
+		std::list<_cpl_odbc_graph_statistic_t>::iterator i;
+		for (i = entries.begin(); i != entries.end(); i++) {
+			cpl_graph_statistic_t s;
+			s.kind = kind;
+			s.key = i->key;
+			s.originator = kind == CPL_GS_OBJECTS_PER_DAY
+				? i->originator.c_str() : NULL;
+			s.type = kind == CPL_GS_OBJECTS_PER_DAY ? i->type.c_str() : NULL;
+			s.count = i->count;
+
+			r = iterator(&s, context);
+			if (!CPL_IS_OK(r)) return r;
+		}
+	}
+
+	return found ? CPL_OK : CPL_S_NO_DATA;
+}
+
+
+
 
 /***************************************************************************/
 /** The export / interface struct                                         **/
@@ -2744,5 +5873,17 @@ const cpl_db_backend_t CPL_ODBC_BACKEND = {
 	cpl_odbc_get_object_ancestry,
 	cpl_odbc_get_properties,
 	cpl_odbc_lookup_by_property,
+	cpl_odbc_get_object_ancestry_batch,
+	cpl_odbc_get_transitive_ancestry,
+	cpl_odbc_get_object_info_batch,
+	cpl_odbc_get_version_info_batch,
+	cpl_odbc_get_session_info_batch,
+	cpl_odbc_get_objects_page,
+	cpl_odbc_get_versions_in_range,
+	cpl_odbc_get_session_activity,
+	cpl_odbc_query_by_properties,
+	cpl_odbc_get_contained_objects,
+	cpl_odbc_lookup_by_name_prefix,
+	cpl_odbc_get_graph_statistics,
 };
 
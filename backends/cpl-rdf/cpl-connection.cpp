@@ -36,9 +36,12 @@
 #include "cpl-connection.h"
 
 #include <libxml/parser.h>
-#include <libxml/tree.h>
+
+#include <algorithm>
+#include <cctype>
 
 #include <string>
+#include <utility>
 
 
 
@@ -46,6 +49,26 @@
 /** Constructor and Destructor                                            **/
 /***************************************************************************/
 
+/**
+ * Create a new easy handle for the connection's pool
+ *
+ * @param connection the connection handle
+ * @return the easy handle, or NULL on error
+ */
+static CURL*
+cpl_rdf_connection_new_handle(cpl_rdf_connection_t* connection)
+{
+	CURL* curl = curl_easy_init();
+	if (curl == NULL) return NULL;
+
+	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, connection->headers);
+	curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+	curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+
+	return curl;
+}
+
+
 /**
  * Initialize the connection
  *
@@ -55,28 +78,45 @@
 cpl_rdf_connection_t*
 cpl_rdf_connection_init(const char* url)
 {
+	CURL* curl;
+
+
 	// Allocate the struct
 
 	cpl_rdf_connection_t* c = new cpl_rdf_connection_t;
 	if (c == NULL) return NULL;
 
 	c->url = url;
+	c->driving = false;
 
 
 	// Initialize lock
 
 	mutex_init(c->lock);
+	cond_init(c->cond);
 
 
 	// Initialize Curl
 
-	c->curl = curl_easy_init();
-	if (c->curl == NULL) goto err_free;
-
 	c->headers = NULL;
-    c->headers = curl_slist_append(c->headers,
-			"Accept: text/plain, application/sparql-results+xml");
-    curl_easy_setopt(c->curl, CURLOPT_HTTPHEADER, c->headers);
+	c->headers = curl_slist_append(c->headers,
+			"Accept: application/sparql-results+json, "
+			"application/sparql-results+xml;q=0.9, text/plain;q=0.5");
+
+	c->multi = curl_multi_init();
+	if (c->multi == NULL) goto err_free;
+	curl_multi_setopt(c->multi, CURLMOPT_MAXCONNECTS,
+			(long) CPL_RDF_CONNECTION_POOL_SIZE);
+	curl_multi_setopt(c->multi, CURLMOPT_MAX_TOTAL_CONNECTIONS,
+			(long) CPL_RDF_CONNECTION_POOL_SIZE);
+
+
+	// Create the first handle now, so that cURL is initialized before the
+	// connection is shared between threads
+
+	curl = cpl_rdf_connection_new_handle(c);
+	if (curl == NULL) goto err_multi;
+	c->idle.push_back(curl);
 
 
 	// Finalize
@@ -86,7 +126,12 @@ cpl_rdf_connection_init(const char* url)
 
 	// Error handling
 
+err_multi:
+	curl_multi_cleanup(c->multi);
+
 err_free:
+	curl_slist_free_all(c->headers);
+	cond_destroy(c->cond);
 	mutex_destroy(c->lock);
 	delete c;
 	return NULL;
@@ -102,11 +147,16 @@ void
 cpl_rdf_connection_close(cpl_rdf_connection_t* connection)
 {
 	assert(connection != NULL);
-	assert(connection->curl != NULL);
+	assert(connection->multi != NULL);
+	assert(!connection->driving && connection->pending.empty());
 
+	for (size_t i = 0; i < connection->idle.size(); i++) {
+		curl_easy_cleanup(connection->idle[i]);
+	}
+	curl_multi_cleanup(connection->multi);
 	curl_slist_free_all(connection->headers);
-	curl_easy_cleanup(connection->curl);
 
+	cond_destroy(connection->cond);
 	mutex_destroy(connection->lock);
 
 	delete connection;
@@ -114,6 +164,194 @@ cpl_rdf_connection_close(cpl_rdf_connection_t* connection)
 
 
 
+/***************************************************************************/
+/** Private API: Handle pool and transfers                                **/
+/***************************************************************************/
+
+/**
+ * The state of a single transfer (CURLOPT_PRIVATE)
+ */
+typedef struct _cpl_rdf_transfer
+{
+	bool done;
+	CURLcode result;
+} _cpl_rdf_transfer_t;
+
+
+/**
+ * Take an idle easy handle from the pool, or create a new one
+ *
+ * @param connection the connection handle
+ * @return the easy handle, or NULL on error
+ */
+static CURL*
+cpl_rdf_connection_acquire(cpl_rdf_connection_t* connection)
+{
+	CURL* curl = NULL;
+
+	mutex_lock(connection->lock);
+	if (!connection->idle.empty()) {
+		curl = connection->idle.back();
+		connection->idle.pop_back();
+	}
+	mutex_unlock(connection->lock);
+
+	if (curl == NULL) curl = cpl_rdf_connection_new_handle(connection);
+	return curl;
+}
+
+
+/**
+ * Return an easy handle to the pool
+ *
+ * @param connection the connection handle
+ * @param curl the easy handle
+ */
+static void
+cpl_rdf_connection_release(cpl_rdf_connection_t* connection, CURL* curl)
+{
+	mutex_lock(connection->lock);
+	if (connection->idle.size() < CPL_RDF_CONNECTION_POOL_SIZE) {
+		connection->idle.push_back(curl);
+		curl = NULL;
+	}
+	mutex_unlock(connection->lock);
+
+	if (curl != NULL) curl_easy_cleanup(curl);
+}
+
+
+/**
+ * Perform a transfer on an easy handle using the connection's multi handle.
+ * If no other thread is driving the multi handle, the calling thread drives
+ * it (running the transfers of all other threads as well) until its own
+ * transfer completes; otherwise it waits for the driving thread.
+ *
+ * @param connection the connection handle
+ * @param curl the configured easy handle
+ * @return the cURL result code of the transfer
+ */
+static CURLcode
+cpl_rdf_connection_perform(cpl_rdf_connection_t* connection, CURL* curl)
+{
+	_cpl_rdf_transfer_t transfer;
+	transfer.done = false;
+	transfer.result = CURLE_OK;
+	curl_easy_setopt(curl, CURLOPT_PRIVATE, &transfer);
+
+
+	// Submit the transfer
+
+	mutex_lock(connection->lock);
+	connection->pending.push_back(curl);
+	if (connection->driving) curl_multi_wakeup(connection->multi);
+
+
+	// Wait for the transfer to complete, driving the multi handle if nobody
+	// else is doing so
+
+	while (!transfer.done) {
+
+		if (connection->driving) {
+			cond_wait(connection->cond, connection->lock);
+			continue;
+		}
+
+		connection->driving = true;
+		while (!transfer.done) {
+
+			std::vector<CURL*> added;
+			added.swap(connection->pending);
+			mutex_unlock(connection->lock);
+
+			std::vector<std::pair<CURL*, CURLcode> > finished;
+			for (size_t i = 0; i < added.size(); i++) {
+				if (curl_multi_add_handle(connection->multi, added[i])
+						!= CURLM_OK) {
+					finished.push_back(std::make_pair(added[i],
+								CURLE_FAILED_INIT));
+				}
+				else {
+					connection->active.push_back(added[i]);
+				}
+			}
+
+
+			// Run the transfers and collect the completed ones
+
+			int running = 0;
+			CURLMcode mc = curl_multi_perform(connection->multi, &running);
+
+			CURLMsg* msg;
+			int queued;
+			while ((msg = curl_multi_info_read(connection->multi, &queued))
+					!= NULL) {
+				if (msg->msg != CURLMSG_DONE) continue;
+				finished.push_back(std::make_pair(msg->easy_handle,
+							msg->data.result));
+			}
+
+			if (mc == CURLM_OK && finished.empty() && running > 0) {
+				mc = curl_multi_poll(connection->multi, NULL, 0,
+						CPL_RDF_CONNECTION_POLL_MS, NULL);
+			}
+
+
+			// An error of the multi handle is not specific to a transfer
+			// and would repeat on the next iteration, so fail all transfers
+			// that are still running
+
+			if (mc != CURLM_OK) {
+				fprintf(stderr, "CPL RDF ERROR: %s\n",
+						curl_multi_strerror(mc));
+				for (size_t i = 0; i < connection->active.size(); i++) {
+					CURL* h = connection->active[i];
+					bool done = false;
+					for (size_t j = 0; j < finished.size() && !done; j++) {
+						done = finished[j].first == h;
+					}
+					if (!done) {
+						finished.push_back(std::make_pair(h,
+									CURLE_FAILED_INIT));
+					}
+				}
+			}
+
+			for (size_t i = 0; i < finished.size(); i++) {
+				curl_multi_remove_handle(connection->multi,
+						finished[i].first);
+				std::vector<CURL*>::iterator a = std::find(
+						connection->active.begin(), connection->active.end(),
+						finished[i].first);
+				if (a != connection->active.end()) connection->active.erase(a);
+			}
+
+
+			// Notify the waiting threads
+
+			mutex_lock(connection->lock);
+			for (size_t i = 0; i < finished.size(); i++) {
+				_cpl_rdf_transfer_t* t = NULL;
+				curl_easy_getinfo(finished[i].first, CURLINFO_PRIVATE, &t);
+				t->result = finished[i].second;
+				t->done = true;
+			}
+			if (!finished.empty()) cond_broadcast(connection->cond);
+		}
+
+
+		// Let one of the other waiting threads take over
+
+		connection->driving = false;
+		cond_broadcast(connection->cond);
+	}
+
+	mutex_unlock(connection->lock);
+	return transfer.result;
+}
+
+
+
 /***************************************************************************/
 /** Public API: Helpers                                                   **/
 /***************************************************************************/
@@ -234,7 +472,7 @@ cpl_rdf_hex_string(const char* str)
     char r[4 + l * 2];
     
     for (p = 0; p < l; p++) {
-        sprintf(r + (2*p), "%02x", str[p]);
+        sprintf(r + (2*p), "%02x", (unsigned char) str[p]);
     }
 
     r[2*p] = '\0';
@@ -242,6 +480,27 @@ cpl_rdf_hex_string(const char* str)
 }
 
 
+/**
+ * Decode a hex-encoded string
+ *
+ * @param str the encoded string
+ * @return the decoded string
+ */
+std::string
+cpl_rdf_unhex_string(const char* str)
+{
+	std::string r;
+
+	for (const char* s = str; isxdigit(s[0]) && isxdigit(s[1]); s += 2) {
+		int hi = isdigit(s[0]) ? s[0] - '0' : (tolower(s[0]) - 'a' + 10);
+		int lo = isdigit(s[1]) ? s[1] - '0' : (tolower(s[1]) - 'a' + 10);
+		r += (char) ((hi << 4) | lo);
+	}
+
+	return r;
+}
+
+
 /***************************************************************************/
 /** Public API: Result Set                                                **/
 /***************************************************************************/
@@ -344,6 +603,20 @@ RDFResult::get_s(const char* key, int type, RDFValue** out) const
 }
 
 
+/**
+ * Remove and destroy all key/value pairs
+ */
+void
+RDFResult::clear(void)
+{
+	for (RDFResultMap::iterator i = m_results.begin();
+			i != m_results.end(); i++) {
+		delete i->second;
+	}
+	m_results.clear();
+}
+
+
 /**
  * Write a human-readable version of the result to the output stream
  * 
@@ -467,320 +740,1292 @@ operator<< (std::ostream& out, const RDFResultSet& rs)
 
 
 /**
- * Parse a single value
+ * The position of the streaming parser within the XML result set
+ */
+typedef enum {
+	RDF_SAX_DOCUMENT,
+	RDF_SAX_ROOT,
+	RDF_SAX_HEAD,
+	RDF_SAX_RESULTS,
+	RDF_SAX_RESULT,
+	RDF_SAX_BINDING,
+	RDF_SAX_VALUE,
+} _cpl_rdf_sax_position_t;
+
+
+/**
+ * The position of the incremental parser within the JSON result set
+ */
+typedef enum {
+	RDF_JSON_DOCUMENT,
+	RDF_JSON_TOP,
+	RDF_JSON_TOP_NEXT,
+	RDF_JSON_RESULTS,
+	RDF_JSON_RESULTS_NEXT,
+	RDF_JSON_ROW,
+	RDF_JSON_ROW_NEXT,
+	RDF_JSON_END,
+} _cpl_rdf_json_position_t;
+
+
+/**
+ * The state of the result set parser
+ */
+typedef struct _cpl_rdf_parser_state
+{
+	/**
+	 * The result format (CPL_RDF_RESULTS_*), or -1 if not yet known
+	 */
+	int format;
+
+	/**
+	 * The XML parser context
+	 */
+	xmlParserCtxtPtr parser;
+
+	/**
+	 * The received part of the JSON response that is not yet parsed, which
+	 * is at most one incomplete row or member of an enclosing object
+	 */
+	std::string json;
+
+	/**
+	 * The offset of the unparsed JSON data within the response
+	 */
+	size_t json_offset;
+
+	/**
+	 * The position within the JSON document
+	 */
+	_cpl_rdf_json_position_t json_position;
+
+	/**
+	 * The position within the XML document
+	 */
+	_cpl_rdf_sax_position_t position;
+
+	/**
+	 * The nesting depth of ignored elements
+	 */
+	int skip_depth;
+
+	/**
+	 * The row callback and its context
+	 */
+	cpl_rdf_row_callback_t callback;
+	void* context;
+
+	/**
+	 * The result set for error messages (can be NULL)
+	 */
+	RDFResultSet* errors;
+
+	/**
+	 * The current row
+	 */
+	RDFResult row;
+
+	/**
+	 * The name of the current binding
+	 */
+	std::string binding_name;
+
+	/**
+	 * Whether the current binding already has a value
+	 */
+	bool binding_has_value;
+
+	/**
+	 * Whether the current value is a URI (as opposed to a literal)
+	 */
+	bool value_is_uri;
+
+	/**
+	 * Whether the current literal has a datatype, and the datatype
+	 */
+	bool value_has_datatype;
+	std::string value_datatype;
+
+	/**
+	 * The text of the current value
+	 */
+	std::string value_text;
+
+	/**
+	 * Scratch space for JSON keys, term types, and skipped strings
+	 */
+	std::string json_key;
+	std::string json_type;
+	std::string json_skipped;
+
+	/**
+	 * The number of decoded results
+	 */
+	size_t num_results;
+
+	/**
+	 * The first error encountered while parsing or in the callback
+	 */
+	cpl_return_t ret;
+
+} _cpl_rdf_parser_state_t;
+
+
+/**
+ * Construct a typed value from its string representation
  *
- * @param cur the cursor to the &gt;binding&lt;...&gt;/binding&lt; tag
- * @param result_set the result set
+ * @param is_uri whether this is a URI (as opposed to a literal)
+ * @param datatype the literal datatype, or NULL for a plain string
+ * @param text the string representation
+ * @param errors the result set for error messages (can be NULL)
  * @param out the pointer to an already allocated value object
  * @return CPL_OK or an error code
  */
 static cpl_return_t
-cpl_rdf_parse_xml_value(xmlNodePtr cur,
-						RDFResultSet* result_set,
-						RDFValue* out)
+cpl_rdf_make_value(bool is_uri,
+				   const char* datatype,
+				   const std::string& text,
+				   RDFResultSet* errors,
+				   RDFValue* out)
 {
 	assert(out != NULL);
-	xmlNodePtr cur_value;
-	bool found = true;
-
-	for (cur_value = cur->children; cur_value != NULL;
-		 cur_value = cur_value->next) {
-
-
-		// Ignore selected nodes
+	out->raw = text;
 
-		if (strcmp((char*) cur_value->name, "text") == 0) continue;
-		if (strcmp((char*) cur_value->name, "comment") == 0) continue;
 
+	// URI
 
-		// URI
-
-		if (strcmp((char*) cur_value->name, "uri") == 0) {
-			out->type = RDF_XSD_URI;
-			if (cur_value->children==NULL) return CPL_E_BACKEND_INTERNAL_ERROR;
-			out->raw = (char*) XML_GET_CONTENT(cur_value->children);
-			out->v_uri = out->raw.c_str();
-			found = true;
-			continue;
-		}
+	if (is_uri) {
+		out->type = RDF_XSD_URI;
+		out->v_uri = out->raw.c_str();
+		return CPL_OK;
+	}
 
 
-		// Literal
+	// String
 
-		if (strcmp((char*) cur_value->name, "literal") == 0) {
-			const char* type;
-			type =(const char*)xmlGetProp(cur_value,(const xmlChar*)"datatype");
-			if (cur_value->children==NULL) return CPL_E_BACKEND_INTERNAL_ERROR;
-			out->raw = (char*) XML_GET_CONTENT(cur_value->children);
+	if (datatype == NULL) {
+		out->type = RDF_XSD_STRING;
+		out->v_string = out->raw.c_str();
+		return CPL_OK;
+	}
 
-			// String
-			
-			if (type == NULL) {
-				out->type = RDF_XSD_STRING;
-				out->v_string = out->raw.c_str();
-			}
-			
-			// Integer
-
-			else if (strstr(type, "#integer") != NULL) {
-				out->type = RDF_XSD_INTEGER;
-				char* e = NULL;
-				out->v_integer = strtoll(out->raw.c_str(), &e, 10);
-				assert(e != NULL);
-				if (*e != '\0') {
-					if (result_set != NULL) {
-						result_set->append_error_message("Could not parse "
-								"an integer literal \"%s\"", out->raw.c_str());
-					}
-					return CPL_E_BACKEND_INTERNAL_ERROR;
-				}
-			}
 
-			// Other
+	// Integer
 
-			else {
-				if (result_set != NULL) {
-					result_set->append_error_message("Unrecognized datatype "
-							"\"%s\"", type);
-				}
-				return CPL_E_BACKEND_INTERNAL_ERROR;
+	if (strstr(datatype, "#integer") != NULL) {
+		out->type = RDF_XSD_INTEGER;
+		char* e = NULL;
+		out->v_integer = strtoll(out->raw.c_str(), &e, 10);
+		assert(e != NULL);
+		if (*e != '\0' || out->raw.empty()) {
+			if (errors != NULL) {
+				errors->append_error_message("Could not parse "
+						"an integer literal \"%s\"", out->raw.c_str());
 			}
-
-			found = true;
-			continue;
+			return CPL_E_BACKEND_INTERNAL_ERROR;
 		}
+		return CPL_OK;
+	}
 
 
-		// Error: Unexpected node
+	// Other
 
-		if (result_set != NULL) {
-			result_set->append_error_message("Invalid node \"%s\" in the "
-					"<binding> tag of the server response", cur_value->name);
-		}
-		return CPL_E_BACKEND_INTERNAL_ERROR;
+	if (errors != NULL) {
+		errors->append_error_message("Unrecognized datatype \"%s\"", datatype);
 	}
+	return CPL_E_BACKEND_INTERNAL_ERROR;
+}
+
 
-	return found ? CPL_OK : CPL_E_BACKEND_INTERNAL_ERROR;
+/**
+ * Abort parsing due to an error
+ *
+ * @param st the parser state
+ * @param ret the error code
+ */
+static void
+cpl_rdf_sax_fail(_cpl_rdf_parser_state_t* st, cpl_return_t ret)
+{
+	assert(!CPL_IS_OK(ret));
+	if (CPL_IS_OK(st->ret)) st->ret = ret;
+	if (st->parser != NULL) xmlStopParser(st->parser);
 }
 
 
 /**
- * Parse a single result
+ * Pass the current row to the callback and clear it
  *
- * @param cur the cursor to the &gt;result&lt;...&gt;/result&lt; tag
- * @param result_set the result set
- * @param out the pointer to an already allocated result object
+ * @param st the parser state
  * @return CPL_OK or an error code
  */
 static cpl_return_t
-cpl_rdf_parse_xml_result(xmlNodePtr cur,
-						 RDFResultSet* result_set,
-						 RDFResult* out)
+cpl_rdf_emit_row(_cpl_rdf_parser_state_t* st)
 {
-	assert(out != NULL);
-	xmlNodePtr cur_binding;
-
-	for (cur_binding = cur->children; cur_binding != NULL;
-		 cur_binding = cur_binding->next) {
-
-
-		// Ignore selected nodes
-
-		if (strcmp((char*) cur_binding->name, "text") == 0) continue;
-		if (strcmp((char*) cur_binding->name, "comment") == 0) continue;
+	st->num_results++;
+	if (st->callback != NULL) {
+		cpl_return_t ret = st->callback(st->row, st->context);
+		if (!CPL_IS_OK(ret)) return ret;
+	}
+	st->row.clear();
+	return CPL_OK;
+}
 
 
-		// Binding
+/**
+ * The SAX handler for the start of an element
+ *
+ * @param ctx the parser state
+ * @param localname the local name of the element
+ * @param prefix the namespace prefix
+ * @param URI the namespace URI
+ * @param nb_namespaces the number of namespace definitions
+ * @param namespaces the namespace definitions
+ * @param nb_attributes the number of attributes
+ * @param nb_defaulted the number of defaulted attributes
+ * @param attributes the attributes as (localname, prefix, URI, value, end)
+ */
+static void
+cpl_rdf_sax_start_element(void* ctx,
+						  const xmlChar* localname,
+						  const xmlChar* prefix,
+						  const xmlChar* URI,
+						  int nb_namespaces,
+						  const xmlChar** namespaces,
+						  int nb_attributes,
+						  int nb_defaulted,
+						  const xmlChar** attributes)
+{
+	_cpl_rdf_parser_state_t* st = (_cpl_rdf_parser_state_t*) ctx;
+	const char* name = (const char*) localname;
+	if (!CPL_IS_OK(st->ret)) return;
 
-		if (strcmp((char*) cur_binding->name, "binding") == 0) {
+	switch (st->position) {
 
-			std::string name = "";
-			bool found = false;
+		case RDF_SAX_DOCUMENT:
+			st->position = RDF_SAX_ROOT;
+			return;
 
+		case RDF_SAX_ROOT:
+			if (strcmp(name, "head") == 0) {
+				st->position = RDF_SAX_HEAD;
+				st->skip_depth = 0;
+				return;
+			}
+			if (strcmp(name, "results") == 0) {
+				st->position = RDF_SAX_RESULTS;
+				return;
+			}
+			break;
 
-			// Find the variable name in the list of properties
-			// NOTE I guess we don't need the for loop at all...
+		case RDF_SAX_HEAD:
+			st->skip_depth++;
+			return;
 
-			xmlAttrPtr a;
-			for (a = cur_binding->properties; a != NULL; a = a->next) {
+		case RDF_SAX_RESULTS:
+			if (strcmp(name, "result") == 0) {
+				st->position = RDF_SAX_RESULT;
+				return;
+			}
+			break;
 
-				if (strcmp((char*) a->name, "name") == 0) {
-					xmlChar* s = xmlGetProp(cur_binding,
-											(const xmlChar*)"name");
-					if (s == NULL) continue;
-					name = (char*) s;
-					found = true;
-					continue;
+		case RDF_SAX_RESULT:
+			if (strcmp(name, "binding") == 0) {
+				bool found = false;
+				for (int i = 0; i < nb_attributes; i++) {
+					const xmlChar** a = attributes + 5 * i;
+					if (strcmp((const char*) a[0], "name") == 0) {
+						st->binding_name.assign((const char*) a[3],
+								(size_t) (a[4] - a[3]));
+						found = true;
+						continue;
+					}
+					if (st->errors != NULL) {
+						st->errors->append_error_message("Invalid property "
+								"\"%s\" in the <binding> node of the server "
+								"response", a[0]);
+					}
+					cpl_rdf_sax_fail(st, CPL_E_BACKEND_INTERNAL_ERROR);
+					return;
 				}
-
-
-				// Error: Unexpected property
-
-				if (result_set != NULL) {
-					result_set->append_error_message("Invalid property \"%s\" "
-							"in the <binding> node of the server response",
-							a->name);
+				if (!found) {
+					if (st->errors != NULL) {
+						st->errors->append_error_message("No property \"name\" "
+								"in the <binding> node of the server response");
+					}
+					cpl_rdf_sax_fail(st, CPL_E_BACKEND_INTERNAL_ERROR);
+					return;
 				}
-				return CPL_E_BACKEND_INTERNAL_ERROR;
+				st->binding_has_value = false;
+				st->position = RDF_SAX_BINDING;
+				return;
 			}
+			break;
 
-			if (!found) {
-				if (result_set != NULL) {
-					result_set->append_error_message("No property \"name\" "
-							"in the <binding> node of the server response");
+		case RDF_SAX_BINDING:
+			if (strcmp(name, "uri") == 0 || strcmp(name, "literal") == 0) {
+				st->value_is_uri = name[0] == 'u';
+				st->value_has_datatype = false;
+				for (int i = 0; i < nb_attributes; i++) {
+					const xmlChar** a = attributes + 5 * i;
+					if (strcmp((const char*) a[0], "datatype") == 0) {
+						st->value_datatype.assign((const char*) a[3],
+								(size_t) (a[4] - a[3]));
+						st->value_has_datatype = true;
+					}
 				}
-				return CPL_E_BACKEND_INTERNAL_ERROR;
+				st->value_text.clear();
+				st->position = RDF_SAX_VALUE;
+				return;
 			}
-
-
-			// Parse out the value
-
-			RDFValue* v = new RDFValue;
-			if (v == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
-			cpl_return_t ret;
-			ret = cpl_rdf_parse_xml_value(cur_binding, result_set, v);
-			if (!CPL_IS_OK(ret)) {
-				delete v;
-				return ret;
+			if (st->errors != NULL) {
+				st->errors->append_error_message("Invalid node \"%s\" in the "
+						"<binding> tag of the server response", name);
 			}
+			cpl_rdf_sax_fail(st, CPL_E_BACKEND_INTERNAL_ERROR);
+			return;
 
-
-			// Add it to the variable binding
-
-			out->put(name, v);
-
-			continue;
-		}
+		default:
+			break;
+	}
 
 
-		// Error: Unexpected node
+	// Error: Unexpected node
 
-		if (result_set != NULL) {
-			result_set->append_error_message("Invalid node \"%s\" in the "
-					"server response", cur_binding->name);
-		}
-		return CPL_E_BACKEND_INTERNAL_ERROR;
+	if (st->errors != NULL) {
+		st->errors->append_error_message("Invalid node \"%s\" in the "
+				"server response", name);
 	}
-
-	return CPL_OK;
+	cpl_rdf_sax_fail(st, CPL_E_BACKEND_INTERNAL_ERROR);
 }
 
 
 /**
- * Parse an XML result set
+ * The SAX handler for the end of an element
  *
- * @param str the XML string
- * @param str_len the length of the string, or 0 for a NULL-terminated string
- * @param out the result set to which the result should be appended (must be
- *            already allocated)
- * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ * @param ctx the parser state
+ * @param localname the local name of the element
+ * @param prefix the namespace prefix
+ * @param URI the namespace URI
  */
-static cpl_return_t
-cpl_rdf_parse_xml_result_set(const char* str,
-							 size_t str_len,
-							 RDFResultSet* out)
+static void
+cpl_rdf_sax_end_element(void* ctx,
+						const xmlChar* localname,
+						const xmlChar* prefix,
+						const xmlChar* URI)
 {
-	cpl_return_t ret = CPL_E_BACKEND_INTERNAL_ERROR;
-	size_t num_results = 0;
-
-	xmlNodePtr cur;
-	xmlNodePtr cur_result;
-	xmlNodePtr root;
-
-
-	// Initialize the parser
+	_cpl_rdf_parser_state_t* st = (_cpl_rdf_parser_state_t*) ctx;
+	cpl_return_t ret;
+	if (!CPL_IS_OK(st->ret)) return;
 
-	xmlDocPtr doc = xmlReadMemory(str, str_len == 0 ? strlen(str) : str_len,
-			 					  "server-response.xml", NULL, 0);
-	if (doc == NULL) {
-		ret = CPL_E_STATEMENT_ERROR;
-		goto err;
-	}
+	switch (st->position) {
 
+		case RDF_SAX_ROOT:
+			st->position = RDF_SAX_DOCUMENT;
+			break;
 
-	// Get the root node
+		case RDF_SAX_HEAD:
+			if (st->skip_depth > 0) {
+				st->skip_depth--;
+			}
+			else {
+				st->position = RDF_SAX_ROOT;
+			}
+			break;
 
-	root = xmlDocGetRootElement(doc);
+		case RDF_SAX_RESULTS:
+			st->position = RDF_SAX_ROOT;
+			break;
 
+		case RDF_SAX_RESULT:
+			st->position = RDF_SAX_RESULTS;
+			ret = cpl_rdf_emit_row(st);
+			if (!CPL_IS_OK(ret)) {
+				cpl_rdf_sax_fail(st, ret);
+				return;
+			}
+			break;
 
-	// Iterate over the root node
+		case RDF_SAX_BINDING:
+			if (!st->binding_has_value) {
+				if (st->errors != NULL) {
+					st->errors->append_error_message("No value in the "
+							"<binding> node of the server response");
+				}
+				cpl_rdf_sax_fail(st, CPL_E_BACKEND_INTERNAL_ERROR);
+				return;
+			}
+			st->position = RDF_SAX_RESULT;
+			break;
 
-	for (cur = root->children; cur != NULL; cur = cur->next) {
+		case RDF_SAX_VALUE:
+			{
+				RDFValue* v = new RDFValue;
+				ret = cpl_rdf_make_value(st->value_is_uri,
+						st->value_has_datatype
+							? st->value_datatype.c_str() : NULL,
+						st->value_text, st->errors, v);
+				if (!CPL_IS_OK(ret)) {
+					delete v;
+					cpl_rdf_sax_fail(st, ret);
+					return;
+				}
+				st->row.put(st->binding_name, v);
+				st->binding_has_value = true;
+				st->position = RDF_SAX_BINDING;
+			}
+			break;
 
+		default:
+			cpl_rdf_sax_fail(st, CPL_E_BACKEND_INTERNAL_ERROR);
+	}
+}
 
-		// Ignore selected nodes
 
-		if (strcmp((char*) cur->name, "text") == 0) continue;
-		if (strcmp((char*) cur->name, "comment") == 0) continue;
-		if (strcmp((char*) cur->name, "head") == 0) continue;
+/**
+ * The SAX handler for character data
+ *
+ * @param ctx the parser state
+ * @param ch the characters (not NULL-terminated)
+ * @param len the number of characters
+ */
+static void
+cpl_rdf_sax_characters(void* ctx, const xmlChar* ch, int len)
+{
+	_cpl_rdf_parser_state_t* st = (_cpl_rdf_parser_state_t*) ctx;
+	if (st->position == RDF_SAX_VALUE) {
+		st->value_text.append((const char*) ch, (size_t) len);
+	}
+}
 
 
-		// Results
+/**
+ * The SAX handler for parser errors
+ *
+ * @param ctx the parser state
+ * @param msg the format of the error message
+ * @param ... the arguments of the format
+ */
+static void
+cpl_rdf_sax_error(void* ctx, const char* msg, ...)
+{
+	_cpl_rdf_parser_state_t* st = (_cpl_rdf_parser_state_t*) ctx;
+	if (st->errors == NULL) return;
 
-		if (strcmp((char*) cur->name, "results") == 0) {
-			for (cur_result = cur->children; cur_result != NULL;
-				 cur_result = cur_result->next) {
+	va_list args;
+	va_start(args, msg);
+	char s[256];
+	vsnprintf(s, sizeof(s), msg, args);
+	s[sizeof(s)-1] = '\0';
+	va_end(args);
 
+	size_t l = strlen(s);
+	if (l > 0 && s[l-1] == '\n') s[l-1] = '\0';
+	st->errors->append_error_message("XML Parser Error: %s", s);
+}
 
-				// Ignore selected nodes
 
-				if (strcmp((char*) cur_result->name, "text") == 0) continue;
+/***************************************************************************/
+/** Private API: Parsing JSON responses                                   **/
+/***************************************************************************/
 
 
-				// Result
+/**
+ * The position of the JSON parser within the available part of the response
+ */
+typedef struct {
+	const char* start;
+	const char* p;
+	const char* end;
+	_cpl_rdf_parser_state_t* st;
 
-				if (strcmp((char*) cur_result->name, "result") == 0) {
-					RDFResult* r = new RDFResult;
-					if (r == NULL) {
-						return CPL_E_INSUFFICIENT_RESOURCES;
-						goto err;
-					}
-					ret = cpl_rdf_parse_xml_result(cur_result, out, r);
-					if (!CPL_IS_OK(ret)) {
-						delete r;
-						goto err;
-					}
-					if (out != NULL) out->append(r); else delete r;
-					num_results++;
-					continue;
-				}
+	/// Whether the available data extend to the end of the response
+	bool final;
 
+	/// Whether the last error was caused by the end of the available data
+	bool truncated;
+} _cpl_rdf_json_t;
 
-				// Error: Unexpected node
 
-				if (out != NULL) {
-					out->append_error_message("Invalid node \"%s\" in the "
-							"server response", cur_result->name);
-				}
-				ret = CPL_E_BACKEND_INTERNAL_ERROR;
-				goto err;
-			}
+/**
+ * Report a JSON syntax error, or if the error is at the end of the data
+ * that arrived so far, mark the parser as waiting for more data
+ *
+ * @param js the JSON parser
+ * @param what the description of the error
+ * @return CPL_E_STATEMENT_ERROR
+ */
+static cpl_return_t
+cpl_rdf_json_error(_cpl_rdf_json_t* js, const char* what)
+{
+	if (!js->final && (js->truncated || js->p >= js->end)) {
+		js->truncated = true;
+		return CPL_E_STATEMENT_ERROR;
+	}
+
+	if (js->st->errors != NULL) {
+		js->st->errors->append_error_message("JSON Parser Error: %s at "
+				"offset %lu", what, (unsigned long) (js->st->json_offset
+					+ (js->p - js->start)));
+	}
+	return CPL_E_STATEMENT_ERROR;
+}
+
+
+/**
+ * Skip whitespace
+ *
+ * @param js the JSON parser
+ */
+static inline void
+cpl_rdf_json_skip_ws(_cpl_rdf_json_t* js)
+{
+	while (js->p < js->end && (*js->p == ' ' || *js->p == '\n'
+				|| *js->p == '\r' || *js->p == '\t')) js->p++;
+}
+
+
+/**
+ * Consume the given character, skipping any whitespace before it
+ *
+ * @param js the JSON parser
+ * @param c the expected character
+ * @return CPL_OK or an error code
+ */
+static inline cpl_return_t
+cpl_rdf_json_expect(_cpl_rdf_json_t* js, char c)
+{
+	cpl_rdf_json_skip_ws(js);
+	if (js->p >= js->end || *js->p != c) {
+		char msg[32];
+		snprintf(msg, sizeof(msg), "Expected '%c'", c);
+		return cpl_rdf_json_error(js, msg);
+	}
+	js->p++;
+	return CPL_OK;
+}
+
+
+/**
+ * Start iterating over an object or an array
+ *
+ * @param js the JSON parser
+ * @param open the opening character ('{' or '[')
+ * @param close the closing character ('}' or ']')
+ * @param more the pointer to store whether there are any elements
+ * @return CPL_OK or an error code
+ */
+static inline cpl_return_t
+cpl_rdf_json_begin(_cpl_rdf_json_t* js, char open, char close, bool* more)
+{
+	cpl_return_t ret = cpl_rdf_json_expect(js, open);
+	if (!CPL_IS_OK(ret)) return ret;
+
+	cpl_rdf_json_skip_ws(js);
+	if (js->p >= js->end) {
+		return cpl_rdf_json_error(js, "Unexpected end of the response");
+	}
+	*more = *js->p != close;
+	if (!*more) js->p++;
+	return CPL_OK;
+}
+
+
+/**
+ * Advance past the separator after an element of an object or an array
+ *
+ * @param js the JSON parser
+ * @param close the closing character ('}' or ']')
+ * @param more the pointer to store whether there are more elements
+ * @return CPL_OK or an error code
+ */
+static inline cpl_return_t
+cpl_rdf_json_next(_cpl_rdf_json_t* js, char close, bool* more)
+{
+	cpl_rdf_json_skip_ws(js);
+	if (js->p < js->end) {
+		if (*js->p == ',') { js->p++; *more = true;  return CPL_OK; }
+		if (*js->p == close) { js->p++; *more = false; return CPL_OK; }
+	}
+	return cpl_rdf_json_error(js, close == '}'
+			? "Expected ',' or '}'" : "Expected ',' or ']'");
+}
+
+
+/**
+ * Parse four hexadecimal digits of a \u escape sequence
+ *
+ * @param js the JSON parser
+ * @param out the pointer to store the code unit
+ * @return true on success
+ */
+static inline bool
+cpl_rdf_json_hex4(_cpl_rdf_json_t* js, unsigned* out)
+{
+	if (js->end - js->p < 4) {
+		if (!js->final) js->truncated = true;
+		return false;
+	}
+
+	unsigned v = 0;
+	for (int i = 0; i < 4; i++) {
+		char c = *js->p++;
+		v <<= 4;
+		if (c >= '0' && c <= '9') v |= c - '0';
+		else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F') v |= c - 'A' + 10;
+		else return false;
+	}
+
+	*out = v;
+	return true;
+}
+
+
+/**
+ * Parse a string. Strings without escape sequences are copied directly
+ * from the buffer into the (reused) output string.
+ *
+ * @param js the JSON parser
+ * @param out the string to store the result
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_rdf_json_parse_string(_cpl_rdf_json_t* js, std::string& out)
+{
+	cpl_rdf_json_skip_ws(js);
+	if (js->p >= js->end || *js->p != '"') {
+		return cpl_rdf_json_error(js, "Expected a string");
+	}
+	js->p++;
+
+
+	// The fast path: no escape sequences
+
+	const char* s = js->p;
+	while (js->p < js->end && *js->p != '"' && *js->p != '\\') js->p++;
+	out.assign(s, js->p - s);
+	if (js->p < js->end && *js->p == '"') {
+		js->p++;
+		return CPL_OK;
+	}
+
+
+	// The slow path: decode the escape sequences
+
+	while (js->p < js->end) {
+		char c = *js->p++;
+		if (c == '"') return CPL_OK;
+		if (c != '\\') {
+			out += c;
 			continue;
 		}
+		if (js->p >= js->end) break;
 
+		c = *js->p++;
+		switch (c) {
+			case '"':
+			case '\\':
+			case '/': out += c; break;
+			case 'b': out += '\b'; break;
+			case 'f': out += '\f'; break;
+			case 'n': out += '\n'; break;
+			case 'r': out += '\r'; break;
+			case 't': out += '\t'; break;
+			case 'u':
+				{
+					unsigned cp, lo;
+					if (!cpl_rdf_json_hex4(js, &cp)) {
+						return cpl_rdf_json_error(js, "Invalid \\u escape");
+					}
+					if (cp >= 0xd800 && cp < 0xdc00) {
+						if (js->end - js->p < 6 && !js->final) {
+							js->truncated = true;
+						}
+						if (js->end - js->p < 6 || js->p[0] != '\\'
+								|| js->p[1] != 'u') {
+							return cpl_rdf_json_error(js, "Unpaired "
+									"surrogate");
+						}
+						js->p += 2;
+						if (!cpl_rdf_json_hex4(js, &lo)
+								|| lo < 0xdc00 || lo >= 0xe000) {
+							return cpl_rdf_json_error(js, "Unpaired "
+									"surrogate");
+						}
+						cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+					}
+					if (cp < 0x80) {
+						out += (char) cp;
+					}
+					else if (cp < 0x800) {
+						out += (char) (0xc0 | (cp >> 6));
+						out += (char) (0x80 | (cp & 0x3f));
+					}
+					else if (cp < 0x10000) {
+						out += (char) (0xe0 | (cp >> 12));
+						out += (char) (0x80 | ((cp >> 6) & 0x3f));
+						out += (char) (0x80 | (cp & 0x3f));
+					}
+					else {
+						out += (char) (0xf0 | (cp >> 18));
+						out += (char) (0x80 | ((cp >> 12) & 0x3f));
+						out += (char) (0x80 | ((cp >> 6) & 0x3f));
+						out += (char) (0x80 | (cp & 0x3f));
+					}
+				}
+				break;
+			default:
+				return cpl_rdf_json_error(js, "Invalid escape sequence");
+		}
+	}
 
-		// Error: Unexpected node
+	return cpl_rdf_json_error(js, "Unterminated string");
+}
 
-		if (out != NULL) {
-			out->append_error_message("Invalid node \"%s\" in the server"
-					" response", cur->name);
+
+/**
+ * Skip over a value of any type
+ *
+ * @param js the JSON parser
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_rdf_json_skip_value(_cpl_rdf_json_t* js)
+{
+	cpl_return_t ret;
+	int depth = 0;
+
+	do {
+		cpl_rdf_json_skip_ws(js);
+		if (js->p >= js->end) {
+			return cpl_rdf_json_error(js, "Unexpected end of the response");
+		}
+
+		char c = *js->p;
+		if (c == '"') {
+			ret = cpl_rdf_json_parse_string(js, js->st->json_skipped);
+			if (!CPL_IS_OK(ret)) return ret;
+		}
+		else if (c == '{' || c == '[') {
+			depth++;
+			js->p++;
+		}
+		else if (c == '}' || c == ']') {
+			if (depth == 0) return cpl_rdf_json_error(js, "Expected a value");
+			depth--;
+			js->p++;
+		}
+		else if (c == ',' || c == ':') {
+			if (depth == 0) return cpl_rdf_json_error(js, "Expected a value");
+			js->p++;
+		}
+		else {
+			const char* s = js->p;
+			while (js->p < js->end && strchr(",:}] \t\r\n", *js->p) == NULL) {
+				js->p++;
+			}
+			if (js->p == s) return cpl_rdf_json_error(js, "Expected a value");
+			if (js->p >= js->end && !js->final) {
+				return cpl_rdf_json_error(js, "Unexpected end of the response");
+			}
 		}
-		ret = CPL_E_BACKEND_INTERNAL_ERROR;
-		goto err;
 	}
+	while (depth > 0);
 
+	return CPL_OK;
+}
 
-	// Finish
 
-	ret = num_results == 0 ? CPL_S_NO_DATA : CPL_OK;
+/**
+ * Parse an RDF term, such as {"type": "uri", "value": "..."}, and add it
+ * to the current row under the current binding name
+ *
+ * @param js the JSON parser
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_rdf_json_parse_term(_cpl_rdf_json_t* js)
+{
+	_cpl_rdf_parser_state_t* st = js->st;
+	cpl_return_t ret;
+	bool more = false;
+	bool has_value = false;
+
+	st->json_type.clear();
+	st->value_has_datatype = false;
+
+
+	// Parse the term object
+
+	ret = cpl_rdf_json_begin(js, '{', '}', &more);
+	if (!CPL_IS_OK(ret)) return ret;
+
+	while (more) {
+		ret = cpl_rdf_json_parse_string(js, st->json_key);
+		if (!CPL_IS_OK(ret)) return ret;
+		ret = cpl_rdf_json_expect(js, ':');
+		if (!CPL_IS_OK(ret)) return ret;
+
+		if (st->json_key == "type") {
+			ret = cpl_rdf_json_parse_string(js, st->json_type);
+		}
+		else if (st->json_key == "value") {
+			ret = cpl_rdf_json_parse_string(js, st->value_text);
+			has_value = true;
+		}
+		else if (st->json_key == "datatype") {
+			ret = cpl_rdf_json_parse_string(js, st->value_datatype);
+			st->value_has_datatype = true;
+		}
+		else {
+			ret = cpl_rdf_json_skip_value(js);
+		}
+		if (!CPL_IS_OK(ret)) return ret;
+
+		ret = cpl_rdf_json_next(js, '}', &more);
+		if (!CPL_IS_OK(ret)) return ret;
+	}
+
+
+	// Determine the kind of the term
+
+	if (st->json_type == "uri") {
+		st->value_is_uri = true;
+	}
+	else if (st->json_type == "literal" || st->json_type == "typed-literal") {
+		st->value_is_uri = false;
+	}
+	else {
+		if (st->errors != NULL) {
+			st->errors->append_error_message("Invalid term type \"%s\" in "
+					"the server response", st->json_type.c_str());
+		}
+		return CPL_E_BACKEND_INTERNAL_ERROR;
+	}
+
+	if (!has_value) {
+		if (st->errors != NULL) {
+			st->errors->append_error_message("No value in the binding "
+					"\"%s\" of the server response", st->binding_name.c_str());
+		}
+		return CPL_E_BACKEND_INTERNAL_ERROR;
+	}
+
+
+	// Construct the value
+
+	RDFValue* v = new RDFValue;
+	ret = cpl_rdf_make_value(st->value_is_uri,
+			st->value_has_datatype ? st->value_datatype.c_str() : NULL,
+			st->value_text, st->errors, v);
+	if (!CPL_IS_OK(ret)) {
+		delete v;
+		return ret;
+	}
+	st->row.put(st->binding_name, v);
+
+	return CPL_OK;
+}
+
+
+/**
+ * Parse a member name and the colon after it into st->json_key
+ *
+ * @param js the JSON parser
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_rdf_json_parse_key(_cpl_rdf_json_t* js)
+{
+	cpl_return_t ret = cpl_rdf_json_parse_string(js, js->st->json_key);
+	if (!CPL_IS_OK(ret)) return ret;
+	return cpl_rdf_json_expect(js, ':');
+}
+
+
+/**
+ * Parse a row of the "bindings" array and pass it to the callback
+ *
+ * @param js the JSON parser
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_rdf_json_parse_row(_cpl_rdf_json_t* js)
+{
+	_cpl_rdf_parser_state_t* st = js->st;
+	cpl_return_t ret;
+	bool more = false;
+
+	st->row.clear();
+
+	ret = cpl_rdf_json_begin(js, '{', '}', &more);
+	if (!CPL_IS_OK(ret)) return ret;
+
+	while (more) {
+		ret = cpl_rdf_json_parse_string(js, st->binding_name);
+		if (!CPL_IS_OK(ret)) return ret;
+		ret = cpl_rdf_json_expect(js, ':');
+		if (!CPL_IS_OK(ret)) return ret;
+		ret = cpl_rdf_json_parse_term(js);
+		if (!CPL_IS_OK(ret)) return ret;
+		ret = cpl_rdf_json_next(js, '}', &more);
+		if (!CPL_IS_OK(ret)) return ret;
+	}
+
+	return cpl_rdf_emit_row(st);
+}
+
+
+/**
+ * Parse the next step of a JSON result set: a complete row, a separator,
+ * or a complete member of the enclosing objects other than the bindings,
+ * such as "head". Everything except for the rows is ignored.
+ *
+ * @param js the JSON parser
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_rdf_json_step(_cpl_rdf_json_t* js)
+{
+	_cpl_rdf_parser_state_t* st = js->st;
+	_cpl_rdf_json_position_t position = st->json_position;
+	cpl_return_t ret = CPL_OK;
+	bool more = false;
+
+	switch (st->json_position) {
+
+		case RDF_JSON_DOCUMENT:
+			ret = cpl_rdf_json_begin(js, '{', '}', &more);
+			position = more ? RDF_JSON_TOP : RDF_JSON_END;
+			break;
+
+		case RDF_JSON_TOP:
+			ret = cpl_rdf_json_parse_key(js);
+			if (!CPL_IS_OK(ret)) break;
+			if (st->json_key == "results") {
+				ret = cpl_rdf_json_begin(js, '{', '}', &more);
+				position = more ? RDF_JSON_RESULTS : RDF_JSON_TOP_NEXT;
+			}
+			else {
+				ret = cpl_rdf_json_skip_value(js);
+				position = RDF_JSON_TOP_NEXT;
+			}
+			break;
+
+		case RDF_JSON_TOP_NEXT:
+			ret = cpl_rdf_json_next(js, '}', &more);
+			position = more ? RDF_JSON_TOP : RDF_JSON_END;
+			break;
+
+		case RDF_JSON_RESULTS:
+			ret = cpl_rdf_json_parse_key(js);
+			if (!CPL_IS_OK(ret)) break;
+			if (st->json_key == "bindings") {
+				ret = cpl_rdf_json_begin(js, '[', ']', &more);
+				position = more ? RDF_JSON_ROW : RDF_JSON_RESULTS_NEXT;
+			}
+			else {
+				ret = cpl_rdf_json_skip_value(js);
+				position = RDF_JSON_RESULTS_NEXT;
+			}
+			break;
+
+		case RDF_JSON_RESULTS_NEXT:
+			ret = cpl_rdf_json_next(js, '}', &more);
+			position = more ? RDF_JSON_RESULTS : RDF_JSON_TOP_NEXT;
+			break;
+
+		case RDF_JSON_ROW:
+			ret = cpl_rdf_json_parse_row(js);
+			position = RDF_JSON_ROW_NEXT;
+			break;
+
+		case RDF_JSON_ROW_NEXT:
+			ret = cpl_rdf_json_next(js, ']', &more);
+			position = more ? RDF_JSON_ROW : RDF_JSON_RESULTS_NEXT;
+			break;
+
+		case RDF_JSON_END:
+			cpl_rdf_json_skip_ws(js);
+			if (js->p < js->end) {
+				ret = cpl_rdf_json_error(js, "Extra content at the end");
+			}
+			break;
+	}
+
+	if (!CPL_IS_OK(ret)) return ret;
+	st->json_position = position;
+	return CPL_OK;
+}
 
-err:
-	xmlFreeDoc(doc);
+
+/**
+ * Parse as much of a JSON result set in the SPARQL 1.1 Query Results JSON
+ * Format as the available data allow, passing each complete row to the
+ * callback. A step that is cut off by the end of the available data is
+ * left unconsumed, so that it can be parsed again once more data arrive.
+ *
+ * @param st the parser state
+ * @param str the available data, starting at the first unparsed byte
+ * @param str_len the length of the data
+ * @param final whether the data extend to the end of the response
+ * @param out_consumed the pointer to store the number of parsed bytes
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_rdf_json_parse_result_set(_cpl_rdf_parser_state_t* st,
+							  const char* str,
+							  size_t str_len,
+							  bool final,
+							  size_t* out_consumed)
+{
+	_cpl_rdf_json_t js;
+	cpl_return_t ret = CPL_OK;
+
+	js.start = str;
+	js.p = str;
+	js.end = str + str_len;
+	js.st = st;
+	js.final = final;
+
+	while (CPL_IS_OK(ret)) {
+		const char* step = js.p;
+		js.truncated = false;
+
+		bool end = st->json_position == RDF_JSON_END;
+		ret = cpl_rdf_json_step(&js);
+		if (!CPL_IS_OK(ret) && js.truncated) {
+			js.p = step;
+			ret = CPL_OK;
+			break;
+		}
+		if (end) break;
+	}
+
+	*out_consumed = js.p - js.start;
 	return ret;
 }
 
 
 
+/***************************************************************************/
+/** Private API: Parsing query results                                    **/
+/***************************************************************************/
+
+
+/**
+ * Initialize the result set parser
+ *
+ * @param st the parser state to initialize
+ * @param callback the row callback
+ * @param context the caller-provided context for the callback
+ * @param errors the result set for error messages (can be NULL)
+ */
+static void
+cpl_rdf_parser_init(_cpl_rdf_parser_state_t* st,
+					cpl_rdf_row_callback_t callback,
+					void* context,
+					RDFResultSet* errors)
+{
+	st->format = -1;
+	st->parser = NULL;
+	st->json_offset = 0;
+	st->json_position = RDF_JSON_DOCUMENT;
+	st->position = RDF_SAX_DOCUMENT;
+	st->skip_depth = 0;
+	st->callback = callback;
+	st->context = context;
+	st->errors = errors;
+	st->binding_has_value = false;
+	st->value_is_uri = false;
+	st->value_has_datatype = false;
+	st->num_results = 0;
+	st->ret = CPL_OK;
+}
+
+
+/**
+ * Select the result format and prepare the parser for the response body
+ *
+ * @param st the parser state
+ * @param format the result format (CPL_RDF_RESULTS_*)
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_rdf_parser_begin(_cpl_rdf_parser_state_t* st, int format)
+{
+	assert(st->format < 0);
+	st->format = format;
+
+	if (format == CPL_RDF_RESULTS_XML) {
+		xmlSAXHandler handler;
+		memset(&handler, 0, sizeof(handler));
+		handler.initialized = XML_SAX2_MAGIC;
+		handler.startElementNs = cpl_rdf_sax_start_element;
+		handler.endElementNs = cpl_rdf_sax_end_element;
+		handler.characters = cpl_rdf_sax_characters;
+		handler.error = cpl_rdf_sax_error;
+		handler.fatalError = cpl_rdf_sax_error;
+
+		st->parser = xmlCreatePushParserCtxt(&handler, st, NULL, 0,
+											 "server-response.xml");
+		if (st->parser == NULL) {
+			st->ret = CPL_E_INSUFFICIENT_RESOURCES;
+			return st->ret;
+		}
+	}
+
+	return CPL_OK;
+}
+
+
+/**
+ * Feed a chunk of the response body to the parser, which passes all rows
+ * that are complete to the callback. Only the incomplete part of a JSON
+ * response is kept until the next chunk.
+ *
+ * @param st the parser state
+ * @param data the chunk
+ * @param length the length of the chunk
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_rdf_parser_feed(_cpl_rdf_parser_state_t* st,
+					const char* data,
+					size_t length)
+{
+	if (!CPL_IS_OK(st->ret)) return st->ret;
+
+	if (st->format == CPL_RDF_RESULTS_JSON) {
+		size_t consumed;
+		if (st->json.empty()) {
+			st->ret = cpl_rdf_json_parse_result_set(st, data, length, false,
+					&consumed);
+			st->json.assign(data + consumed, length - consumed);
+		}
+		else {
+			st->json.append(data, length);
+			st->ret = cpl_rdf_json_parse_result_set(st, st->json.data(),
+					st->json.length(), false, &consumed);
+			st->json.erase(0, consumed);
+		}
+		st->json_offset += consumed;
+	}
+	else {
+		xmlParseChunk(st->parser, data, (int) length, 0);
+	}
+
+	return st->ret;
+}
+
+
+/**
+ * Finish parsing and release the parser
+ *
+ * @param st the parser state
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+static cpl_return_t
+cpl_rdf_parser_finish(_cpl_rdf_parser_state_t* st)
+{
+	if (CPL_IS_OK(st->ret)) {
+		if (st->format == CPL_RDF_RESULTS_JSON) {
+			size_t consumed;
+			st->ret = cpl_rdf_json_parse_result_set(st, st->json.data(),
+					st->json.length(), true, &consumed);
+		}
+		else if (st->parser == NULL) {
+			st->ret = CPL_E_STATEMENT_ERROR;
+		}
+		else {
+			xmlParseChunk(st->parser, NULL, 0, 1);
+			if (CPL_IS_OK(st->ret) && !st->parser->wellFormed) {
+				st->ret = CPL_E_STATEMENT_ERROR;
+			}
+		}
+	}
+
+	cpl_return_t ret = st->ret;
+	if (CPL_IS_OK(ret)) {
+		ret = st->num_results == 0 ? CPL_S_NO_DATA : CPL_OK;
+	}
+
+	if (st->parser != NULL) {
+		xmlFreeParserCtxt(st->parser);
+		st->parser = NULL;
+	}
+	st->json.clear();
+	st->row.clear();
+
+	return ret;
+}
+
+
+/**
+ * The row callback that collects the results into a result set
+ *
+ * @param row the decoded result row
+ * @param context the result set (can be NULL)
+ * @return CPL_OK
+ */
+static cpl_return_t
+cpl_rdf_collect_row(RDFResult& row, void* context)
+{
+	RDFResultSet* rs = (RDFResultSet*) context;
+	if (rs == NULL) return CPL_OK;
+
+	RDFResult* r = new RDFResult;
+	r->swap(row);
+	rs->append(r);
+
+	return CPL_OK;
+}
+
+
+/**
+ * Parse a complete query response that is already in memory
+ *
+ * @param str the response body
+ * @param str_len the length of the response body
+ * @param format the result format (CPL_RDF_RESULTS_*)
+ * @param callback the row callback
+ * @param context the caller-provided context for the callback
+ * @param errors the pointer to an already initialized result set (to store
+ *               error messages, can be NULL)
+ * @param chunk_size the number of bytes passed to the parser at a time, as
+ *                   if they arrived from the server, or 0 for the default
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+cpl_return_t
+cpl_rdf_parse_result_set(const char* str,
+						 size_t str_len,
+						 int format,
+						 cpl_rdf_row_callback_t callback,
+						 void* context,
+						 RDFResultSet* errors,
+						 size_t chunk_size)
+{
+	_cpl_rdf_parser_state_t st;
+	cpl_rdf_parser_init(&st, callback, context, errors);
+
+
+	// Feed the response in chunks, as if it arrived from the server
+
+	cpl_rdf_parser_begin(&st, format);
+	if (chunk_size == 0) chunk_size = 1 << 20;
+	while (str_len > 0) {
+		size_t l = str_len > chunk_size ? chunk_size : str_len;
+		if (!CPL_IS_OK(cpl_rdf_parser_feed(&st, str, l))) break;
+		str += l;
+		str_len -= l;
+	}
+
+	return cpl_rdf_parser_finish(&st);
+}
+
+
+
+
 /***************************************************************************/
 /** Public API: Submitting simple queries                                 **/
 /***************************************************************************/
@@ -791,13 +2036,40 @@ err:
  */
 typedef struct _cpl_rdf_writedata
 {
-	cpl_rdf_connection_t* connection;
+	CURL* curl;
 	std::string buffer;
+	long response_code;
+	_cpl_rdf_parser_state_t* parser;
 } _cpl_rdf_writedata_t;
 
 
 /**
- * The write function handler for cpl_rdf_connection_execute_query()
+ * Determine the format of a query response
+ *
+ * @param content_type the value of the Content-Type header (can be NULL)
+ * @param s the first chunk of the response body
+ * @param length the length of the chunk
+ * @return the result format (CPL_RDF_RESULTS_*)
+ */
+static int
+cpl_rdf_detect_format(const char* content_type, const char* s, size_t length)
+{
+	if (content_type != NULL) {
+		if (strstr(content_type, "json") != NULL) return CPL_RDF_RESULTS_JSON;
+		if (strstr(content_type, "xml" ) != NULL) return CPL_RDF_RESULTS_XML;
+	}
+
+	for (size_t i = 0; i < length; i++) {
+		if (isspace(s[i])) continue;
+		return s[i] == '{' ? CPL_RDF_RESULTS_JSON : CPL_RDF_RESULTS_XML;
+	}
+
+	return CPL_RDF_RESULTS_XML;
+}
+
+
+/**
+ * The write function handler for cpl_rdf_connection_execute_query_stream()
  *
  * @param s the pointer to the data received from cURL
  * @param size
@@ -809,105 +2081,169 @@ static size_t
 query_write_function(char *s, size_t size, size_t nmemb, void* userdata)
 {
 	_cpl_rdf_writedata_t* wd = (_cpl_rdf_writedata_t*) userdata;
-	wd->buffer += s;
-	//fprintf(stderr, "%s", s);
-	return size * nmemb;
+	size_t l = size * nmemb;
+
+
+	// Determine the response code before processing the first chunk
+
+	if (wd->response_code == 0) {
+		curl_easy_getinfo(wd->curl, CURLINFO_RESPONSE_CODE,
+				&wd->response_code);
+	}
+
+
+	// Keep the body of an error response as the error message
+
+	if (wd->response_code != 200) {
+		wd->buffer.append(s, l);
+		return l;
+	}
+
+
+	// Select the parser based on the negotiated content type
+
+	if (wd->parser->format < 0) {
+		char* content_type = NULL;
+		curl_easy_getinfo(wd->curl, CURLINFO_CONTENT_TYPE,
+				&content_type);
+		int format = cpl_rdf_detect_format(content_type, s, l);
+		if (!CPL_IS_OK(cpl_rdf_parser_begin(wd->parser, format))) return 0;
+	}
+
+
+	// Feed the parser, aborting the transfer on error
+
+	return CPL_IS_OK(cpl_rdf_parser_feed(wd->parser, s, l)) ? l : 0;
 }
 
 
 /**
- * Execute a query
+ * Execute a query and decode the results incrementally while they are
+ * still being received, calling the callback for each result row
  *
  * @param connection the connection handle
  * @param statement the query statement
- * @param out the pointer to an already initialized result set
- * @return an error code
+ * @param callback the row callback
+ * @param context the caller-provided context for the callback
+ * @param errors the pointer to an already initialized result set (to store
+ *               error messages, can be NULL)
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
  */
 cpl_return_t
-cpl_rdf_connection_execute_query(cpl_rdf_connection_t* connection,
-								 const char* statement,
-								 RDFResultSet* out)
+cpl_rdf_connection_execute_query_stream(cpl_rdf_connection_t* connection,
+										const char* statement,
+										cpl_rdf_row_callback_t callback,
+										void* context,
+										RDFResultSet* errors)
 {
 	char my_curl_error[CURL_ERROR_SIZE];
 	long response_code = 0;
+	cpl_return_t ret;
 
 
-	// Lock
+	// Initialize the parser
+
+	_cpl_rdf_parser_state_t parser;
+	cpl_rdf_parser_init(&parser, callback, context, errors);
 
-	mutex_lock(connection->lock);
+
+	// Get a handle from the pool
+
+	CURL* curl = cpl_rdf_connection_acquire(connection);
+	if (curl == NULL) {
+		parser.ret = CPL_E_INSUFFICIENT_RESOURCES;
+		cpl_rdf_parser_finish(&parser);
+		return CPL_E_INSUFFICIENT_RESOURCES;
+	}
 
 
 	// Connection options
 
 	_cpl_rdf_writedata_t wd;
-	wd.connection = connection;
+	wd.curl = curl;
 	wd.buffer = "";
+	wd.response_code = 0;
+	wd.parser = &parser;
 
-	curl_easy_setopt(connection->curl, CURLOPT_WRITEFUNCTION, query_write_function);
-	curl_easy_setopt(connection->curl, CURLOPT_WRITEDATA, &wd);
-	curl_easy_setopt(connection->curl, CURLOPT_ERRORBUFFER, my_curl_error);
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, query_write_function);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, &wd);
+	curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, my_curl_error);
 
 
 	// Configure GET
 
-	curl_easy_setopt(connection->curl, CURLOPT_POST, 0);
+	curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
 
-	char *encoded = curl_easy_escape(connection->curl, statement, 0);
+	char *encoded = curl_easy_escape(curl, statement, 0);
 	if (encoded == NULL) {
-		mutex_unlock(connection->lock);
-		return CPL_E_INSUFFICIENT_RESOURCES;
-	}
-
-	char *new_url = (char*) alloca(strlen(connection->url.c_str())
-									+ strlen(encoded) + 16);
-	if (new_url == NULL) {
-		curl_free(encoded);
-		mutex_unlock(connection->lock);
+		cpl_rdf_connection_release(connection, curl);
+		parser.ret = CPL_E_INSUFFICIENT_RESOURCES;
+		cpl_rdf_parser_finish(&parser);
 		return CPL_E_INSUFFICIENT_RESOURCES;
 	}
 
-	sprintf(new_url, "%s%cquery=%s", connection->url.c_str(),
-			strchr(connection->url.c_str(), '?') ? '&' : '?', encoded);
+	std::string new_url = connection->url;
+	new_url += strchr(connection->url.c_str(), '?') ? '&' : '?';
+	new_url += "query=";
+	new_url += encoded;
 	curl_free(encoded);
-	curl_easy_setopt(connection->curl, CURLOPT_URL, new_url);
+	curl_easy_setopt(curl, CURLOPT_URL, new_url.c_str());
 
 
-	// Execute the statement
+	// Execute the statement, parsing the responses as they arrive
 
-	CURLcode code = curl_easy_perform(connection->curl);
+	CURLcode code = cpl_rdf_connection_perform(connection, curl);
 
 	if (code) {
-		if (out != NULL) {
-			out->append_error_message("cURL Connection Error: %s",
-					my_curl_error);
+		if (code != CURLE_WRITE_ERROR || CPL_IS_OK(parser.ret)) {
+			if (errors != NULL) {
+				errors->append_error_message("cURL Connection Error: %s",
+						my_curl_error);
+			}
+			parser.ret = CPL_E_DB_CONNECTION_ERROR;
 		}
-		mutex_unlock(connection->lock);
-		return CPL_E_DB_CONNECTION_ERROR;
+		cpl_rdf_connection_release(connection, curl);
+		return cpl_rdf_parser_finish(&parser);
 	}
 
 
 	// Get the HTTP response code
 
-	curl_easy_getinfo(connection->curl, CURLINFO_RESPONSE_CODE, &response_code);
+	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+	cpl_rdf_connection_release(connection, curl);
+
 	if (response_code != 200) {
-		if (out != NULL) {
-			out->append_error_message("%s", wd.buffer.c_str());
+		if (errors != NULL) {
+			errors->append_error_message("%s", wd.buffer.c_str());
 		}
-		mutex_unlock(connection->lock);
+		parser.ret = CPL_E_STATEMENT_ERROR;
+		cpl_rdf_parser_finish(&parser);
 		return CPL_E_STATEMENT_ERROR;
 	}
 
 
-	// Unlock the connection
-
-	mutex_unlock(connection->lock);
+	// Finish parsing the response
 
+	ret = cpl_rdf_parser_finish(&parser);
+	return ret;
+}
 
-	// Parse the response
 
-	cpl_return_t ret = cpl_rdf_parse_xml_result_set(wd.buffer.c_str(),
-							wd.buffer.length(), out);
-	return ret;
+/**
+ * Execute a query
+ *
+ * @param connection the connection handle
+ * @param statement the query statement
+ * @param out the pointer to an already initialized result set
+ * @return an error code
+ */
+cpl_return_t
+cpl_rdf_connection_execute_query(cpl_rdf_connection_t* connection,
+								 const char* statement,
+								 RDFResultSet* out)
+{
+	return cpl_rdf_connection_execute_query_stream(connection, statement,
+			cpl_rdf_collect_row, out, out);
 }
 
 
@@ -925,7 +2261,7 @@ static size_t
 update_write_function(char *s, size_t size, size_t nmemb, void* userdata)
 {
 	_cpl_rdf_writedata_t* wd = (_cpl_rdf_writedata_t*) userdata;
-	wd->buffer += s;
+	wd->buffer.append(s, size * nmemb);
 	return size * nmemb;
 }
 
@@ -948,71 +2284,67 @@ cpl_rdf_connection_execute_update(cpl_rdf_connection_t* connection,
 	long response_code = 0;
 
 
-	// Lock
+	// Get a handle from the pool
 
-	mutex_lock(connection->lock);
+	CURL* curl = cpl_rdf_connection_acquire(connection);
+	if (curl == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
 
 
 	// Connection options
 
 	_cpl_rdf_writedata_t wd;
-	wd.connection = connection;
+	wd.curl = curl;
 	wd.buffer = "";
+	wd.response_code = 0;
+	wd.parser = NULL;
 
-	curl_easy_setopt(connection->curl, CURLOPT_WRITEFUNCTION, update_write_function);
-	curl_easy_setopt(connection->curl, CURLOPT_WRITEDATA, &wd);
-	curl_easy_setopt(connection->curl, CURLOPT_ERRORBUFFER, my_curl_error);
-	curl_easy_setopt(connection->curl, CURLOPT_URL, connection->url.c_str());
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, update_write_function);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, &wd);
+	curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, my_curl_error);
+	curl_easy_setopt(curl, CURLOPT_URL, connection->url.c_str());
 
 
 	// Configure POST
 
-	curl_easy_setopt(connection->curl, CURLOPT_POST, 1);
-
-	char *encoded = curl_easy_escape(connection->curl, statement, 0);
+	char *encoded = curl_easy_escape(curl, statement, 0);
 	if (encoded == NULL) {
-		mutex_unlock(connection->lock);
+		cpl_rdf_connection_release(connection, curl);
 		return CPL_E_INSUFFICIENT_RESOURCES;
 	}
 
-	char *field = (char*) alloca(strlen(encoded) + 16);
-	if (field == NULL) {
-		curl_free(encoded);
-		mutex_unlock(connection->lock);
-		return CPL_E_INSUFFICIENT_RESOURCES;
-	}
-
-	sprintf(field, "update=%s", encoded);
+	std::string field = "update=";
+	field += encoded;
 	curl_free(encoded);
-	curl_easy_setopt(connection->curl, CURLOPT_POSTFIELDS, field);
+	curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long) field.length());
+	curl_easy_setopt(curl, CURLOPT_POSTFIELDS, field.c_str());
 
 
 	// Execute the statement
 
-	CURLcode code = curl_easy_perform(connection->curl);
+	CURLcode code = cpl_rdf_connection_perform(connection, curl);
 
 	if (code) {
 		if (out != NULL) {
 			out->append_error_message("cURL Connection Error: %s",
 					my_curl_error);
 		}
-		mutex_unlock(connection->lock);
+		cpl_rdf_connection_release(connection, curl);
 		return CPL_E_DB_CONNECTION_ERROR;
 	}
 
 
 	// Get the HTTP response code
 
-	curl_easy_getinfo(connection->curl, CURLINFO_RESPONSE_CODE, &response_code);
+	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+	cpl_rdf_connection_release(connection, curl);
+
 	if (response_code != 200) {
 		if (out != NULL) {
 			out->append_error_message("%s", wd.buffer.c_str());
 		}
-		mutex_unlock(connection->lock);
 		return CPL_E_STATEMENT_ERROR;
 	}
 
-	mutex_unlock(connection->lock);
 	return CPL_OK;
 }
 
@@ -1023,3 +2355,50 @@ cpl_rdf_connection_execute_update(cpl_rdf_connection_t* connection,
 /***************************************************************************/
 
 
+/**
+ * The row callback that counts the rows
+ *
+ * @param row the decoded result row
+ * @param context the pointer to the size_t counter
+ * @return CPL_OK
+ */
+static cpl_return_t
+cpl_rdf_count_row(RDFResult& row, void* context)
+{
+	(*((size_t*) context))++;
+	return CPL_OK;
+}
+
+
+/**
+ * Parse a recorded SPARQL query response without contacting the database,
+ * which is useful for benchmarking the result parsers
+ *
+ * @param str the response body
+ * @param str_len the length of the response body
+ * @param format the result format (CPL_RDF_RESULTS_XML or _JSON)
+ * @param out_num_rows the pointer to store the number of decoded rows
+ *                     (can be NULL)
+ * @param chunk_size the number of bytes passed to the parser at a time, as
+ *                   if they arrived from the server, or 0 for the default
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+cpl_return_t
+cpl_rdf_parse_recorded_response(const char* str,
+								size_t str_len,
+								int format,
+								size_t* out_num_rows,
+								size_t chunk_size)
+{
+	if (str == NULL) return CPL_E_INVALID_ARGUMENT;
+	if (format != CPL_RDF_RESULTS_XML && format != CPL_RDF_RESULTS_JSON) {
+		return CPL_E_INVALID_ARGUMENT;
+	}
+
+	size_t n = 0;
+	cpl_return_t ret = cpl_rdf_parse_result_set(str, str_len, format,
+			cpl_rdf_count_row, &n, NULL, chunk_size);
+
+	if (out_num_rows != NULL) *out_num_rows = n;
+	return ret;
+}
@@ -36,6 +36,7 @@
 #define __CPL_CONNECTION_H__
 
 #include <private/cpl-platform.h>
+#include <backends/cpl-rdf.h>
 #include <cplxx.h>
 
 #include <curl/curl.h>
@@ -46,19 +47,61 @@
 
 
 
+/***************************************************************************/
+/** Constants                                                             **/
+/***************************************************************************/
+
+/**
+ * The maximum number of idle easy handles and of open keep-alive connections
+ * per connection handle (additional transfers wait for a free connection)
+ */
+#define CPL_RDF_CONNECTION_POOL_SIZE	16
+
+/**
+ * The maximum time in milliseconds to wait for socket activity before
+ * checking for newly submitted transfers
+ */
+#define CPL_RDF_CONNECTION_POLL_MS		1000
+
+
+
 /***************************************************************************/
 /** Types                                                                 **/
 /***************************************************************************/
 
 /**
- * The connection handle
+ * The connection handle. Each statement runs on its own easy handle taken
+ * from a pool, and all transfers are multiplexed through a single multi
+ * handle, which keeps the HTTP connections alive between statements. The
+ * multi handle is driven by one of the waiting threads at a time.
  */
 typedef struct {
-	
+
+	/**
+	 * The multi handle that drives all transfers
+	 */
+	CURLM* multi;
+
+	/**
+	 * The idle easy handles
+	 */
+	std::vector<CURL*> idle;
+
 	/**
-	 * The underlying connection handle
+	 * The easy handles that are waiting to be added to the multi handle
 	 */
-	CURL* curl;
+	std::vector<CURL*> pending;
+
+	/**
+	 * The easy handles that were added to the multi handle (accessed only
+	 * by the driving thread)
+	 */
+	std::vector<CURL*> active;
+
+	/**
+	 * Whether a thread is currently driving the multi handle
+	 */
+	bool driving;
 
 	/**
 	 * The SPARQL endpoint URL
@@ -75,14 +118,39 @@ typedef struct {
 	 */
 	mutex_t lock;
 
+	/**
+	 * The condition signaled when a transfer completes or when the driving
+	 * thread leaves
+	 */
+	cond_t cond;
+
 } cpl_rdf_connection_t;
 
 
+/**
+ * A single result in the result set
+ */
+class RDFResult;
+
 /**
  * The result set
  */
 class RDFResultSet;
 
+/**
+ * The row callback for streaming query results. The row is valid only for
+ * the duration of the call, but the callback may take its contents using
+ * RDFResult::swap(). The callback may be invoked from another thread that
+ * is driving the connection's transfers, so it must not block and must not
+ * submit queries through the same connection.
+ *
+ * @param row the decoded result row
+ * @param context the caller-provided context
+ * @return CPL_OK or an error code (aborts the query)
+ */
+typedef cpl_return_t (*cpl_rdf_row_callback_t)(RDFResult& row,
+											   void* context);
+
 
 
 /***************************************************************************/
@@ -125,6 +193,15 @@ cpl_rdf_escape_string(const char* str);
 std::string
 cpl_rdf_hex_string(const char* str);
 
+/**
+ * Decode a hex-encoded string
+ *
+ * @param str the encoded string
+ * @return the decoded string
+ */
+std::string
+cpl_rdf_unhex_string(const char* str);
+
 /**
  * Execute a query
  *
@@ -138,6 +215,68 @@ cpl_rdf_connection_execute_query(cpl_rdf_connection_t* connection,
 								 const char* statement,
 								 RDFResultSet* out);
 
+/**
+ * Execute a query and decode the results incrementally while they are
+ * still being received, calling the callback for each result row
+ *
+ * @param connection the connection handle
+ * @param statement the query statement
+ * @param callback the row callback
+ * @param context the caller-provided context for the callback
+ * @param errors the pointer to an already initialized result set (to store
+ *               error messages, can be NULL)
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+cpl_return_t
+cpl_rdf_connection_execute_query_stream(cpl_rdf_connection_t* connection,
+										const char* statement,
+										cpl_rdf_row_callback_t callback,
+										void* context,
+										RDFResultSet* errors = NULL);
+
+/**
+ * Parse a complete query response that is already in memory
+ *
+ * @param str the response body
+ * @param str_len the length of the response body
+ * @param format the result format (CPL_RDF_RESULTS_*)
+ * @param callback the row callback
+ * @param context the caller-provided context for the callback
+ * @param errors the pointer to an already initialized result set (to store
+ *               error messages, can be NULL)
+ * @param chunk_size the number of bytes passed to the parser at a time, as
+ *                   if they arrived from the server, or 0 for the default
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+cpl_return_t
+cpl_rdf_parse_result_set(const char* str,
+						 size_t str_len,
+						 int format,
+						 cpl_rdf_row_callback_t callback,
+						 void* context,
+						 RDFResultSet* errors = NULL,
+						 size_t chunk_size = 0);
+
+/**
+ * Parse a recorded SPARQL query response without contacting the database,
+ * which is useful for benchmarking the result parsers
+ *
+ * @param str the response body
+ * @param str_len the length of the response body
+ * @param format the result format (CPL_RDF_RESULTS_XML or _JSON)
+ * @param out_num_rows the pointer to store the number of decoded rows
+ *                     (can be NULL)
+ * @param chunk_size the number of bytes passed to the parser at a time, as
+ *                   if they arrived from the server, or 0 for the default
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+cpl_return_t
+cpl_rdf_parse_recorded_response(const char* str,
+								size_t str_len,
+								int format,
+								size_t* out_num_rows,
+								size_t chunk_size = 0);
+
 /**
  * Execute an update statement
  *
@@ -249,6 +388,28 @@ public:
 	cpl_return_t
 	get_s(const char* key, int type, RDFValue** out) const;
 
+	/**
+	 * Determine the number of bound variables
+	 *
+	 * @return the number of key/value pairs
+	 */
+	inline size_t
+	size(void) const { return m_results.size(); }
+
+	/**
+	 * Remove and destroy all key/value pairs
+	 */
+	void
+	clear(void);
+
+	/**
+	 * Exchange the contents of this result with another result
+	 *
+	 * @param other the other result
+	 */
+	inline void
+	swap(RDFResult& other) { m_results.swap(other.m_results); }
+
 	/**
 	 * Get a const_iterator over the results
 	 *
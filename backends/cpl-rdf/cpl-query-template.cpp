@@ -0,0 +1,402 @@
+/*
+ * cpl-query-template.cpp
+ * Core Provenance Library
+ *
+ * Copyright 2011
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+
+#include "stdafx.h"
+#include "cpl-query-template.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+
+/***************************************************************************/
+/** Helpers                                                               **/
+/***************************************************************************/
+
+/**
+ * The hexadecimal digits
+ */
+static const char CPL_RDF_HEX_DIGITS[] = "0123456789abcdef";
+
+
+/**
+ * Append a number in hexadecimal (the same as the "%llx" format)
+ *
+ * @param out the output buffer
+ * @param value the value
+ */
+void
+cpl_rdf_append_hex(std::string& out, unsigned long long value)
+{
+	char buf[2 * sizeof(value)];
+	char* p = buf + sizeof(buf);
+
+	do {
+		*--p = CPL_RDF_HEX_DIGITS[value & 0xf];
+		value >>= 4;
+	}
+	while (value != 0);
+
+	out.append(p, buf + sizeof(buf) - p);
+}
+
+
+/**
+ * Append a hex-encoded property key (the same as %k)
+ *
+ * @param out the output buffer
+ * @param key the property key
+ */
+void
+cpl_rdf_append_key(std::string& out, const char* key)
+{
+	out.append("c:", 2);
+	for (const unsigned char* p = (const unsigned char*) key; *p; p++) {
+		out.push_back(CPL_RDF_HEX_DIGITS[*p >> 4]);
+		out.push_back(CPL_RDF_HEX_DIGITS[*p & 0xf]);
+	}
+}
+
+
+/**
+ * Append an escaped string (the same as cpl_rdf_escape_string())
+ *
+ * @param out the output buffer
+ * @param str the string
+ */
+void
+cpl_rdf_append_escaped(std::string& out, const char* str)
+{
+	const char* run = str;
+
+	for (const char* p = str; *p != '\0'; p++) {
+		char e;
+
+		switch (*p) {
+			case '\t': e = 't'; break;
+			case '\b': e = 'b'; break;
+			case '\n': e = 'n'; break;
+			case '\r': e = 'r'; break;
+			case '\f': e = 'f'; break;
+			case '\\': e = '\\'; break;
+			case '\"': e = '\"'; break;
+			case '\'': e = '\''; break;
+			default  : continue;
+		}
+
+		out.append(run, p - run);
+		out.push_back('\\');
+		out.push_back(e);
+		run = p + 1;
+	}
+
+	out.append(run);
+}
+
+
+
+/***************************************************************************/
+/** Query Template                                                        **/
+/***************************************************************************/
+
+/**
+ * Create an empty template
+ */
+RDFQueryTemplate::RDFQueryTemplate(void)
+{
+	m_length = 0;
+}
+
+
+/**
+ * Compile the template
+ *
+ * @param prefixes the prefix declarations (can be NULL)
+ * @param text the template text
+ * @return CPL_OK or CPL_E_INVALID_ARGUMENT if the text is malformed
+ */
+cpl_return_t
+RDFQueryTemplate::compile(const char* prefixes, const char* text)
+{
+	if (text == NULL) return CPL_E_INVALID_ARGUMENT;
+
+	m_segments.clear();
+	m_params.clear();
+	m_length = 0;
+
+	std::string segment;
+	if (prefixes != NULL) segment = prefixes;
+
+
+	// Split the text into the fixed segments and the parameters
+
+	for (const char* p = text; *p != '\0'; p++) {
+		if (*p != '%') {
+			segment.push_back(*p);
+			continue;
+		}
+
+		RDFParamType type;
+		switch (*++p) {
+			case '%': segment.push_back('%'); continue;
+			case 'o': type = RDF_PARAM_OBJECT; break;
+			case 'n': type = RDF_PARAM_NODE; break;
+			case 's': type = RDF_PARAM_SESSION; break;
+			case 'd': type = RDF_PARAM_INTEGER; break;
+			case 'x': type = RDF_PARAM_HEX; break;
+			case 'l': type = RDF_PARAM_LITERAL; break;
+			case 'k': type = RDF_PARAM_KEY; break;
+			default:
+				m_segments.clear();
+				m_params.clear();
+				m_length = 0;
+				return CPL_E_INVALID_ARGUMENT;
+		}
+
+		m_length += segment.length();
+		m_segments.push_back(segment);
+		m_params.push_back(type);
+		segment.clear();
+	}
+
+	m_length += segment.length();
+	m_segments.push_back(segment);
+
+	return CPL_OK;
+}
+
+
+
+/***************************************************************************/
+/** Query                                                                 **/
+/***************************************************************************/
+
+/**
+ * Start instantiating a template
+ *
+ * @param t the compiled template
+ */
+RDFQuery::RDFQuery(const RDFQueryTemplate& t)
+	: m_template(t)
+{
+	m_index = 0;
+
+	// Reserve enough space for the fixed text plus the typical parameters
+	m_buffer.reserve(m_template.m_length + 48 * m_template.m_params.size());
+}
+
+
+/**
+ * Check the type of the next parameter and append the fixed text
+ * that precedes it
+ *
+ * @param type the parameter type
+ */
+void
+RDFQuery::next(RDFParamType type)
+{
+	if (m_index >= m_template.m_params.size()
+			|| m_template.m_params[m_index] != type) {
+		fprintf(stderr, "CPL RDF ERROR: Query template parameter mismatch.\n");
+		abort();
+	}
+
+	m_buffer.append(m_template.m_segments[m_index]);
+	m_index++;
+}
+
+
+/**
+ * Append an object ID (%o)
+ *
+ * @param id the object ID
+ * @return this query
+ */
+RDFQuery&
+RDFQuery::object(const cpl_id_t& id)
+{
+	next(RDF_PARAM_OBJECT);
+
+	m_buffer.append("o:", 2);
+	cpl_rdf_append_hex(m_buffer, id.hi);
+	m_buffer.push_back('-');
+	cpl_rdf_append_hex(m_buffer, id.lo);
+
+	return *this;
+}
+
+
+/**
+ * Append a version node (%n)
+ *
+ * @param id the object ID
+ * @param version the version
+ * @return this query
+ */
+RDFQuery&
+RDFQuery::node(const cpl_id_t& id, const cpl_version_t version)
+{
+	next(RDF_PARAM_NODE);
+
+	m_buffer.append("n:", 2);
+	cpl_rdf_append_hex(m_buffer, id.hi);
+	m_buffer.push_back('-');
+	cpl_rdf_append_hex(m_buffer, id.lo);
+	m_buffer.push_back('-');
+	cpl_rdf_append_hex(m_buffer, (unsigned) version);
+
+	return *this;
+}
+
+
+/**
+ * Append a session ID (%s)
+ *
+ * @param session the session ID
+ * @return this query
+ */
+RDFQuery&
+RDFQuery::session(const cpl_session_t& session)
+{
+	next(RDF_PARAM_SESSION);
+
+	m_buffer.append("s:", 2);
+	cpl_rdf_append_hex(m_buffer, session.hi);
+	m_buffer.push_back('-');
+	cpl_rdf_append_hex(m_buffer, session.lo);
+
+	return *this;
+}
+
+
+/**
+ * Append an integer (%d)
+ *
+ * @param value the value
+ * @return this query
+ */
+RDFQuery&
+RDFQuery::integer(long long value)
+{
+	next(RDF_PARAM_INTEGER);
+
+	char buf[24];
+	char* p = buf + sizeof(buf);
+	unsigned long long u = value < 0 ? 0ULL - (unsigned long long) value
+		: (unsigned long long) value;
+
+	do {
+		*--p = (char) ('0' + (u % 10));
+		u /= 10;
+	}
+	while (u != 0);
+	if (value < 0) *--p = '-';
+
+	m_buffer.append(p, buf + sizeof(buf) - p);
+
+	return *this;
+}
+
+
+/**
+ * Append an unsigned integer in hexadecimal (%x)
+ *
+ * @param value the value
+ * @return this query
+ */
+RDFQuery&
+RDFQuery::hex(unsigned long long value)
+{
+	next(RDF_PARAM_HEX);
+	cpl_rdf_append_hex(m_buffer, value);
+	return *this;
+}
+
+
+/**
+ * Append an escaped string literal (%l)
+ *
+ * @param str the string
+ * @return this query
+ */
+RDFQuery&
+RDFQuery::literal(const char* str)
+{
+	next(RDF_PARAM_LITERAL);
+
+	m_buffer.push_back('\"');
+	cpl_rdf_append_escaped(m_buffer, str == NULL ? "" : str);
+	m_buffer.push_back('\"');
+
+	return *this;
+}
+
+
+/**
+ * Append a hex-encoded property key (%k)
+ *
+ * @param key the property key
+ * @return this query
+ */
+RDFQuery&
+RDFQuery::key(const char* key)
+{
+	next(RDF_PARAM_KEY);
+	cpl_rdf_append_key(m_buffer, key);
+	return *this;
+}
+
+
+/**
+ * Get the complete statement. All parameters must have been appended.
+ *
+ * @return the statement
+ */
+const std::string&
+RDFQuery::str(void)
+{
+	if (m_index == m_template.m_params.size()) {
+		m_buffer.append(m_template.m_segments[m_index]);
+		m_index++;
+	}
+	else if (m_index < m_template.m_params.size()) {
+		fprintf(stderr, "CPL RDF ERROR: Missing query template parameters.\n");
+		abort();
+	}
+
+	return m_buffer;
+}
+
@@ -0,0 +1,286 @@
+/*
+ * cpl-query-template.h
+ * Core Provenance Library
+ *
+ * Copyright 2011
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+
+#ifndef __CPL_QUERY_TEMPLATE_H__
+#define __CPL_QUERY_TEMPLATE_H__
+
+#include <cplxx.h>
+
+#include <string>
+#include <vector>
+
+
+
+/***************************************************************************/
+/** Query Template                                                        **/
+/***************************************************************************/
+
+/**
+ * The type of a template parameter
+ */
+typedef enum {
+	RDF_PARAM_NONE,
+	RDF_PARAM_OBJECT,
+	RDF_PARAM_NODE,
+	RDF_PARAM_SESSION,
+	RDF_PARAM_INTEGER,
+	RDF_PARAM_HEX,
+	RDF_PARAM_LITERAL,
+	RDF_PARAM_KEY,
+} RDFParamType;
+
+/**
+ * A precompiled SPARQL statement with parameters. The fixed text, including
+ * the prefix declarations, is prepared only once, so that instantiating the
+ * template only needs to append the fixed segments and the formatted
+ * parameters to a buffer.
+ *
+ * The template text can contain the following parameters, which are filled
+ * in using RDFQuery in the order in which they appear:
+ *   %o  an object ID, as o:<hi>-<lo>
+ *   %n  a version node (object ID and version), as n:<hi>-<lo>-<version>
+ *   %s  a session ID, as s:<hi>-<lo>
+ *   %d  an integer
+ *   %x  an unsigned integer in hexadecimal
+ *   %l  an escaped string literal, including the quotes
+ *   %k  a hex-encoded property key, as c:<hex>
+ *   %%  the % character
+ */
+class RDFQueryTemplate
+{
+	friend class RDFQuery;
+
+
+public:
+
+	/**
+	 * Create an empty template
+	 */
+	RDFQueryTemplate(void);
+
+	/**
+	 * Compile the template
+	 *
+	 * @param prefixes the prefix declarations (can be NULL)
+	 * @param text the template text
+	 * @return CPL_OK or CPL_E_INVALID_ARGUMENT if the text is malformed
+	 */
+	cpl_return_t
+	compile(const char* prefixes, const char* text);
+
+	/**
+	 * Determine the number of parameters
+	 *
+	 * @return the number of parameters
+	 */
+	inline size_t
+	num_params(void) const { return m_params.size(); }
+
+
+protected:
+
+	/**
+	 * The fixed text segments (one more than the number of parameters)
+	 */
+	std::vector<std::string> m_segments;
+
+	/**
+	 * The parameter types
+	 */
+	std::vector<RDFParamType> m_params;
+
+	/**
+	 * The total length of the fixed text
+	 */
+	size_t m_length;
+};
+
+
+/**
+ * An instance of a query template, which is filled in by calling the
+ * parameter methods in the order in which the parameters appear in the
+ * template
+ */
+class RDFQuery
+{
+
+public:
+
+	/**
+	 * Start instantiating a template
+	 *
+	 * @param t the compiled template
+	 */
+	RDFQuery(const RDFQueryTemplate& t);
+
+	/**
+	 * Append an object ID (%o)
+	 *
+	 * @param id the object ID
+	 * @return this query
+	 */
+	RDFQuery&
+	object(const cpl_id_t& id);
+
+	/**
+	 * Append a version node (%n)
+	 *
+	 * @param id the object ID
+	 * @param version the version
+	 * @return this query
+	 */
+	RDFQuery&
+	node(const cpl_id_t& id, const cpl_version_t version);
+
+	/**
+	 * Append a session ID (%s)
+	 *
+	 * @param session the session ID
+	 * @return this query
+	 */
+	RDFQuery&
+	session(const cpl_session_t& session);
+
+	/**
+	 * Append an integer (%d)
+	 *
+	 * @param value the value
+	 * @return this query
+	 */
+	RDFQuery&
+	integer(long long value);
+
+	/**
+	 * Append an unsigned integer in hexadecimal (%x)
+	 *
+	 * @param value the value
+	 * @return this query
+	 */
+	RDFQuery&
+	hex(unsigned long long value);
+
+	/**
+	 * Append an escaped string literal (%l)
+	 *
+	 * @param str the string
+	 * @return this query
+	 */
+	RDFQuery&
+	literal(const char* str);
+
+	/**
+	 * Append a hex-encoded property key (%k)
+	 *
+	 * @param key the property key
+	 * @return this query
+	 */
+	RDFQuery&
+	key(const char* key);
+
+	/**
+	 * Get the complete statement. All parameters must have been appended.
+	 *
+	 * @return the statement
+	 */
+	const std::string&
+	str(void);
+
+	/**
+	 * Get the complete statement as a C string. All parameters must have
+	 * been appended.
+	 *
+	 * @return the statement
+	 */
+	inline const char*
+	c_str(void) { return str().c_str(); }
+
+
+protected:
+
+	/**
+	 * Check the type of the next parameter and append the fixed text
+	 * that precedes it
+	 *
+	 * @param type the parameter type
+	 */
+	void
+	next(RDFParamType type);
+
+	/**
+	 * The template
+	 */
+	const RDFQueryTemplate& m_template;
+
+	/**
+	 * The index of the next parameter
+	 */
+	size_t m_index;
+
+	/**
+	 * The statement buffer
+	 */
+	std::string m_buffer;
+};
+
+
+/**
+ * Append a number in hexadecimal (the same as the "%llx" format)
+ *
+ * @param out the output buffer
+ * @param value the value
+ */
+void
+cpl_rdf_append_hex(std::string& out, unsigned long long value);
+
+/**
+ * Append a hex-encoded property key (the same as %k)
+ *
+ * @param out the output buffer
+ * @param key the property key
+ */
+void
+cpl_rdf_append_key(std::string& out, const char* key);
+
+/**
+ * Append an escaped string (the same as cpl_rdf_escape_string())
+ *
+ * @param out the output buffer
+ * @param str the string
+ */
+void
+cpl_rdf_append_escaped(std::string& out, const char* str);
+
+#endif
+
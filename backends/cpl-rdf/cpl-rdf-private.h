@@ -36,12 +36,14 @@
 #define __CPL_RDF_PRIVATE_H__
 
 #include <backends/cpl-rdf.h>
-#include <private/cpl-lock.h>
 #include <private/cpl-platform.h>
+#include <pthread.h>
+#include <map>
 #include <string>
 
 #include <cplxx.h>
 #include "cpl-connection.h"
+#include "cpl-query-template.h"
 
 
 #ifdef __cplusplus
@@ -51,7 +53,109 @@ extern "C" {
 }	/* Hack for editors that try to be too smart about indentation */
 #endif
 
-#define CPL_RDF_SEM_INIT		"edu.harvard.pass.cpl.rdf.ver"
+/**
+ * The size of the write buffer in bytes, after which it is flushed
+ */
+#define CPL_RDF_WRITE_BUFFER_SIZE		(64 * 1024)
+
+/**
+ * The maximum time in milliseconds that an update can spend in the write
+ * buffer before it is flushed
+ */
+#define CPL_RDF_WRITE_BUFFER_DELAY_MS	500
+
+/**
+ * The number of times to try sending the write buffer before reporting
+ * the error to the caller that flushes it
+ */
+#define CPL_RDF_FLUSH_ATTEMPTS			3
+
+/**
+ * The number of rows fetched per request by the paginated queries
+ */
+#define CPL_RDF_PAGE_SIZE				1000
+
+/**
+ * The maximum number of version nodes in a single batched ancestry query
+ */
+#define CPL_RDF_BATCH_SIZE				256
+
+
+/***************************************************************************/
+/** Statement Templates                                                   **/
+/***************************************************************************/
+
+/**
+ * The precompiled statements of the RDF backend. The insert templates
+ * produce triples for the write buffer, and the query templates produce
+ * complete queries including the prefix declarations.
+ */
+typedef struct {
+
+	// Triples for the write buffer
+
+	RDFQueryTemplate insert_session;
+	RDFQueryTemplate insert_object;
+	RDFQueryTemplate insert_object_container;
+	RDFQueryTemplate insert_ancestry_edge;
+	RDFQueryTemplate insert_property;
+	RDFQueryTemplate delete_version_claim;
+
+	// Update operations
+
+	RDFQueryTemplate create_version;
+
+	// Queries
+
+	RDFQueryTemplate check_version_claim;
+	RDFQueryTemplate lookup_object;
+	RDFQueryTemplate lookup_object_ext;
+	RDFQueryTemplate get_version;
+	RDFQueryTemplate has_immediate_ancestor;
+	RDFQueryTemplate has_immediate_ancestor_node;
+	RDFQueryTemplate get_session_info;
+	RDFQueryTemplate get_object_info;
+	RDFQueryTemplate get_version_info;
+	RDFQueryTemplate get_versions_in_range;
+	RDFQueryTemplate get_session_activity;
+	RDFQueryTemplate get_ancestors;
+	RDFQueryTemplate get_ancestors_node;
+	RDFQueryTemplate get_descendants;
+	RDFQueryTemplate get_descendants_node;
+	RDFQueryTemplate get_properties;
+	RDFQueryTemplate get_properties_node;
+	RDFQueryTemplate get_property;
+	RDFQueryTemplate get_property_node;
+	RDFQueryTemplate lookup_by_property;
+
+	// Object info queries: the beginning of the query for each combination
+	// of CPL_I_NO_CREATION_SESSION and CPL_I_NO_VERSION, and the filters
+
+	RDFQueryTemplate object_info[4];
+	RDFQueryTemplate filter_after_object;
+	RDFQueryTemplate filter_originator;
+	RDFQueryTemplate filter_type;
+	RDFQueryTemplate filter_name_prefix;
+	RDFQueryTemplate filter_contained;
+	RDFQueryTemplate filter_contained_recursive;
+	RDFQueryTemplate filter_contained_node;
+	RDFQueryTemplate filter_contained_node_recursive;
+
+	// Graph statistics
+
+	RDFQueryTemplate stats_edges_by_type;
+	RDFQueryTemplate stats_versions_per_object;
+	RDFQueryTemplate stats_fan_in;
+	RDFQueryTemplate stats_fan_out;
+	RDFQueryTemplate stats_objects_per_day;
+
+	// Pagination clauses appended to the queries
+
+	RDFQueryTemplate page;
+	RDFQueryTemplate limit;
+
+} cpl_rdf_templates_t;
+
 
 
 /***************************************************************************/
@@ -94,9 +198,56 @@ typedef struct {
 	cpl_rdf_connection_t* connection_update;
 
 	/**
-	 * The shared semaphore for creating new versions
+	 * The precompiled statements
+	 */
+	cpl_rdf_templates_t templates;
+
+	/**
+	 * The templates of the multi-hop ancestry queries, which are compiled
+	 * on the first use of each shape (see cpl_rdf_hop_template())
+	 */
+	std::map<int, RDFQueryTemplate> hop_templates;
+
+	/**
+	 * The lock for the multi-hop ancestry templates
+	 */
+	pthread_mutex_t hop_templates_lock;
+
+	/**
+	 * The counter used to generate unique version creation claims
+	 */
+	unsigned long claim_counter;
+
+	/**
+	 * The write buffer: triples of the pending INSERT DATA statement
+	 */
+	std::string write_buffer;
+
+	/**
+	 * The triples of the pending DELETE DATA statement, which is sent after
+	 * the INSERT DATA statement
 	 */
-	cpl_shared_semaphore_t sem_create_version;
+	std::string delete_buffer;
+
+	/**
+	 * The lock for the write buffer
+	 */
+	mutex_t write_lock;
+
+	/**
+	 * The condition variable used to wake up the flush thread
+	 */
+	cond_t write_cond;
+
+	/**
+	 * The thread that flushes the buffer after the maximum delay
+	 */
+	thread_t flush_thread;
+
+	/**
+	 * Whether the flush thread should terminate
+	 */
+	bool flush_thread_stop;
 
 } cpl_rdf_t;
 
@@ -107,6 +258,16 @@ typedef struct {
 extern const cpl_db_backend_t CPL_RDF_BACKEND;
 
 
+/**
+ * Compile all statement templates
+ *
+ * @param t the templates
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+cpl_rdf_compile_templates(cpl_rdf_templates_t* t);
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -35,910 +35,2785 @@
 #include "stdafx.h"
 #include "cpl-rdf-private.h"
 
+#include <cerrno>
+#include <climits>
 #include <iostream>
+#include <list>
+#include <set>
 #include <sstream>
 #include <string>
+#include <vector>
 
 
 
-/***************************************************************************/
-/** Constructor and Destructor                                            **/
-/***************************************************************************/
+/**
+ * The context for cpl_rdf_row_object_info()
+ */
+typedef struct {
+	int flags;
+	std::list<cplxx_object_info_t> objects;
+} _cpl_rdf_object_info_context_t;
+
 
 /**
- * Create an RDF backend
+ * The row callback for cpl_rdf_get_all_objects()
  *
- * @param url_query the SPARQL query endpoint URL
- * @param url_update the SPARQL update endpoint URL
- * @param db_type the database type
- * @param out the pointer to the database backend variable
- * @return the error code
+ * @param row the result row with ?obj, ?time, ?orig, ?name, ?type, and
+ *            optionally ?container, ?session, and ?v
+ * @param context the _cpl_rdf_object_info_context_t
+ * @return CPL_OK or an error code
  */
-extern "C" cpl_return_t
-cpl_create_rdf_backend(const char* url_query,
-					   const char* url_update,
-					   int db_type,
-					   cpl_db_backend_t** out)
+static cpl_return_t
+cpl_rdf_row_object_info(RDFResult& row, void* context)
 {
-	cpl_return_t r = CPL_OK;
-
-	assert(out != NULL);
-	if (url_query  == NULL) return CPL_E_INVALID_ARGUMENT;
-	if (url_update == NULL) return CPL_E_INVALID_ARGUMENT;
+	_cpl_rdf_object_info_context_t* ctx
+		= (_cpl_rdf_object_info_context_t*) context;
+	cplxx_object_info_t e;
+	cpl_return_t ret;
+	RDFValue* v;
+	int r;
 
+	ret = row.get_s("obj", RDF_XSD_URI, &v);
+	if (!CPL_IS_OK(ret)) return ret;
+	r = sscanf(v->v_uri, "object:%llx-%llx", &e.id.hi, &e.id.lo);
+	if (r != 2) return CPL_E_BACKEND_INTERNAL_ERROR;
 
-	// Allocate the backend struct
+	ret = row.get_s("time", RDF_XSD_INTEGER, &v);
+	if (!CPL_IS_OK(ret)) return ret;
+	e.creation_time = v->v_integer;
 
-	cpl_rdf_t* rdf = new cpl_rdf_t;
-	if (rdf == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
-	memcpy(&rdf->backend, &CPL_RDF_BACKEND, sizeof(rdf->backend));
+	ret = row.get_s("orig", RDF_XSD_STRING, &v);
+	if (!CPL_IS_OK(ret)) return ret;
+	e.originator = v->v_string;
 
-	rdf->db_type = db_type;
-	rdf->url_query = url_query;
-	rdf->url_update = url_update;
+	ret = row.get_s("name", RDF_XSD_STRING, &v);
+	if (!CPL_IS_OK(ret)) return ret;
+	e.name = v->v_string;
 
+	ret = row.get_s("type", RDF_XSD_STRING, &v);
+	if (!CPL_IS_OK(ret)) return ret;
+	e.type = v->v_string;
 
-	// Initialize the connection handles
+	ret = row.get_s("container", RDF_XSD_URI, &v);
+	if (ret == CPL_E_DB_KEY_NOT_FOUND) {
+		e.container_id = CPL_NONE;
+		e.container_version = CPL_VERSION_NONE;
+	}
+	else if (CPL_IS_OK(ret)) {
+		r = sscanf(v->v_uri, "node:%llx-%llx-%x",
+				&e.container_id.hi, &e.container_id.lo, &e.container_version);
+		if (r != 3) return CPL_E_BACKEND_INTERNAL_ERROR;
+	}
+	else return ret;
 
-	rdf->connection_query = cpl_rdf_connection_init(rdf->url_query.c_str());
-	if (rdf->connection_query == NULL) {
-		r = CPL_E_DB_CONNECTION_ERROR;
-		goto err_free;
+	if ((ctx->flags & CPL_I_NO_CREATION_SESSION) == 0) {
+		ret = row.get_s("session", RDF_XSD_URI, &v);
+		if (!CPL_IS_OK(ret)) return ret;
+		r = sscanf(v->v_uri, "session:%llx-%llx",
+				&e.creation_session.hi, &e.creation_session.lo);
+		if (r != 2) return CPL_E_BACKEND_INTERNAL_ERROR;
+	}
+	else {
+		e.creation_session = CPL_NONE;
 	}
 
-	rdf->connection_update = cpl_rdf_connection_init(rdf->url_update.c_str());
-	if (rdf->connection_update == NULL) {
-		r = CPL_E_DB_CONNECTION_ERROR;
-		goto err_close_query;
+	if ((ctx->flags & CPL_I_NO_VERSION) == 0) {
+		ret = row.get_s("v", RDF_XSD_INTEGER, &v);
+		if (!CPL_IS_OK(ret)) return ret;
+		e.version = (cpl_version_t) v->v_integer;
+	}
+	else {
+		e.version = CPL_VERSION_NONE;
 	}
 
+	ctx->objects.push_back(e);
+	return CPL_OK;
+}
 
-	// Initialize the shared semaphore for version creation
 
-	rdf->sem_create_version = cpl_shared_semaphore_open(CPL_RDF_SEM_INIT);
-	if (rdf->sem_create_version == NULL) {
-		r = CPL_E_PLATFORM_ERROR;
-		goto err_close_all;
-	}
+/**
+ * The context for cpl_rdf_row_property()
+ */
+typedef struct {
+	cpl_id_t id;
+	cpl_version_t version;
+	const char* key;
+	const char* value;
+	std::list<cplxx_property_entry_t> properties;
+} _cpl_rdf_property_context_t;
 
 
-	// Return
+/**
+ * The row callback for cpl_rdf_get_properties() and
+ * cpl_rdf_lookup_by_property()
+ *
+ * @param row the result row with ?node (unless the version is known),
+ *            ?key (unless the key is known), and ?value (unless the value
+ *            is known)
+ * @param context the _cpl_rdf_property_context_t
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_rdf_row_property(RDFResult& row, void* context)
+{
+	_cpl_rdf_property_context_t* ctx = (_cpl_rdf_property_context_t*) context;
+	cplxx_property_entry_t e;
+	cpl_return_t ret;
+	RDFValue* v;
 
-	*out = (cpl_db_backend_t*) rdf;
-	return CPL_OK;
 
+	// Get the node
 
-err_close_all:
-	cpl_rdf_connection_close(rdf->connection_update);
+	if (ctx->version == CPL_VERSION_NONE) {
+		ret = row.get_s("node", RDF_XSD_URI, &v);
+		if (!CPL_IS_OK(ret)) return ret;
 
-err_close_query:
-	cpl_rdf_connection_close(rdf->connection_query);
+		int r = sscanf(v->v_uri, "node:%llx-%llx-%x",
+				&e.id.hi, &e.id.lo, &e.version);
+		if (r != 3) return CPL_E_BACKEND_INTERNAL_ERROR;
+	}
+	else {
+		e.id = ctx->id;
+		e.version = ctx->version;
+	}
 
-err_free:
-	delete rdf;
 
-	assert(!CPL_IS_OK(r));
-	return r;
+	// Get the key and the value
+
+	if (ctx->key == NULL) {
+		ret = row.get_s("key", RDF_XSD_URI, &v);
+		if (!CPL_IS_OK(ret)) return ret;
+		if (strncmp(v->v_uri, "custom:", 7) != 0) return CPL_OK;
+		e.key = cpl_rdf_unhex_string(v->v_uri + 7);
+	}
+	else {
+		e.key = ctx->key;
+	}
+
+	if (ctx->value == NULL) {
+		ret = row.get_s("value", RDF_XSD_STRING, &v);
+		if (!CPL_IS_OK(ret)) return ret;
+		e.value = v->v_string;
+	}
+	else {
+		e.value = ctx->value;
+	}
+
+	ctx->properties.push_back(e);
+	return CPL_OK;
 }
 
 
 /**
- * Destructor. If the constructor allocated the backend structure, it
- * should be freed by this function
+ * The context for cpl_rdf_row_version_info()
+ */
+typedef struct {
+	cpl_session_t session;
+	std::list<cpl_version_info_t> versions;
+} _cpl_rdf_version_info_context_t;
+
+
+/**
+ * The row callback for cpl_rdf_get_versions_in_range() and
+ * cpl_rdf_get_session_activity()
  *
- * @param backend the pointer to the backend structure
- * @param the error code
+ * @param row the result row with ?node, ?time, and ?session (unless the
+ *            session is known)
+ * @param context the _cpl_rdf_version_info_context_t
+ * @return CPL_OK or an error code
  */
-extern "C" cpl_return_t
-cpl_rdf_destroy(struct _cpl_db_backend_t* backend)
+static cpl_return_t
+cpl_rdf_row_version_info(RDFResult& row, void* context)
 {
-	assert(backend != NULL);
-	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+	_cpl_rdf_version_info_context_t* ctx
+		= (_cpl_rdf_version_info_context_t*) context;
+	cpl_version_info_t e;
+	cpl_return_t ret;
+	RDFValue* v;
+	int r;
 
-	cpl_shared_semaphore_close(rdf->sem_create_version);
-	cpl_rdf_connection_close(rdf->connection_query);
-	cpl_rdf_connection_close(rdf->connection_update);
+	ret = row.get_s("node", RDF_XSD_URI, &v);
+	if (!CPL_IS_OK(ret)) return ret;
+	r = sscanf(v->v_uri, "node:%llx-%llx-%x", &e.id.hi, &e.id.lo, &e.version);
+	if (r != 3) return CPL_E_BACKEND_INTERNAL_ERROR;
 
-	delete rdf;
+	if (ctx->session == CPL_NONE) {
+		ret = row.get_s("session", RDF_XSD_URI, &v);
+		if (!CPL_IS_OK(ret)) return ret;
+		r = sscanf(v->v_uri, "session:%llx-%llx", &e.session.hi, &e.session.lo);
+		if (r != 2) return CPL_E_BACKEND_INTERNAL_ERROR;
+	}
+	else {
+		e.session = ctx->session;
+	}
+
+	ret = row.get_s("time", RDF_XSD_INTEGER, &v);
+	if (!CPL_IS_OK(ret)) return ret;
+	e.creation_time = v->v_integer;
+
+	ctx->versions.push_back(e);
 	return CPL_OK;
 }
 
 
+/**
+ * An ancestry edge with both endpoints decoded from a result row
+ */
+typedef struct {
+	cpl_id_t from_id;
+	cpl_version_t from_version;
+	cpl_id_t to_id;
+	cpl_version_t to_version;
+	int type;
+} _cpl_rdf_ancestry_hop_t;
 
-/***************************************************************************/
-/** Public API                                                            **/
-/***************************************************************************/
 
 /**
- * Create a session.
+ * The ordering of the ancestry edges, used to remove the duplicate edges
+ * reached through different paths
+ */
+struct _cpl_rdf_ancestry_hop_less {
+	inline bool operator() (const _cpl_rdf_ancestry_hop_t& a,
+							const _cpl_rdf_ancestry_hop_t& b) const {
+		if (a.from_id != b.from_id) return a.from_id < b.from_id;
+		if (a.from_version != b.from_version)
+			return a.from_version < b.from_version;
+		if (a.to_id != b.to_id) return a.to_id < b.to_id;
+		if (a.to_version != b.to_version) return a.to_version < b.to_version;
+		return a.type < b.type;
+	}
+};
+
+
+/**
+ * The context for cpl_rdf_row_ancestry_hop()
+ */
+typedef struct {
+	cpl_id_t id;
+	cpl_version_t version;
+	std::set<_cpl_rdf_ancestry_hop_t, _cpl_rdf_ancestry_hop_less> seen;
+	std::list<_cpl_rdf_ancestry_hop_t> edges;
+} _cpl_rdf_ancestry_hop_context_t;
+
+
+/**
+ * The row callback for cpl_rdf_get_object_ancestry_hops()
  *
- * @param backend the pointer to the backend structure
- * @param session the session ID to use
- * @param mac_address human-readable MAC address (NULL if not available)
- * @param user the user name
- * @param pid the process ID
- * @param program the program name
- * @param cmdline the command line
+ * @param row the result row with ?edge, ?to, and ?from (unless the edge
+ *            starts at the queried node) and ?node (if the version is not
+ *            known)
+ * @param context the _cpl_rdf_ancestry_hop_context_t
  * @return CPL_OK or an error code
  */
-extern "C" cpl_return_t
-cpl_rdf_create_session(struct _cpl_db_backend_t* backend,
-					   const cpl_session_t session,
-					   const char* mac_address,
-					   const char* user,
-					   const int pid,
-					   const char* program,
-					   const char* cmdline)
+static cpl_return_t
+cpl_rdf_row_ancestry_hop(RDFResult& row, void* context)
 {
-	assert(backend != NULL && user != NULL && program != NULL && cmdline!=NULL);
-	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+	_cpl_rdf_ancestry_hop_context_t* ctx
+		= (_cpl_rdf_ancestry_hop_context_t*) context;
+	_cpl_rdf_ancestry_hop_t e;
+	cpl_return_t ret;
+	RDFValue* v;
+	int r;
 
-	char session_str[64];
-	sprintf(session_str, "s:%llx-%llx", session.hi, session.lo);
+	ret = row.get_s("edge", RDF_XSD_URI, &v);
+	if (!CPL_IS_OK(ret)) return ret;
+	r = sscanf(v->v_uri, "input:%x", &e.type);
+	if (r != 1) return CPL_E_BACKEND_INTERNAL_ERROR;
 
-	std::ostringstream ss;
 
-	// Only for debugging
-	// cpl_rdf_connection_execute_update(rdf->connection_update,
-	//		"DELETE { ?s ?p ?o } WHERE { ?s ?p ?o }");
+	// Get the endpoint closer to the queried node
 
-	ss << "PREFIX s: <session:>\n";
-	ss << "PREFIX p: <prop:>\n";
-	ss << "INSERT DATA { " << session_str;
-	ss << " p:mac_address \"" << cpl_rdf_escape_string(mac_address) << "\";";
-	ss << " p:username \"" << cpl_rdf_escape_string(user) << "\";";
-	ss << " p:pid " << pid << ";";
-	ss << " p:program \"" << cpl_rdf_escape_string(program) << "\";";
-	ss << " p:cmdline \"" << cpl_rdf_escape_string(cmdline) << "\";";
-	ss << " p:initialization_time " << time(NULL) << " }\n";
-
-	cpl_return_t ret = cpl_rdf_connection_execute_update(rdf->connection_update,
-			ss.str().c_str());
-	
-	return ret;
+	ret = row.get_s("from", RDF_XSD_URI, &v);
+	if (ret == CPL_E_DB_KEY_NOT_FOUND && ctx->version == CPL_VERSION_NONE) {
+		ret = row.get_s("node", RDF_XSD_URI, &v);
+	}
+
+	if (ret == CPL_E_DB_KEY_NOT_FOUND) {
+		e.from_id = ctx->id;
+		e.from_version = ctx->version;
+	}
+	else if (CPL_IS_OK(ret)) {
+		r = sscanf(v->v_uri, "node:%llx-%llx-%x",
+				&e.from_id.hi, &e.from_id.lo, &e.from_version);
+		if (r != 3) return CPL_E_BACKEND_INTERNAL_ERROR;
+	}
+	else return ret;
+
+
+	// Get the other endpoint
+
+	ret = row.get_s("to", RDF_XSD_URI, &v);
+	if (!CPL_IS_OK(ret)) return ret;
+	r = sscanf(v->v_uri, "node:%llx-%llx-%x",
+			&e.to_id.hi, &e.to_id.lo, &e.to_version);
+	if (r != 3) return CPL_E_BACKEND_INTERNAL_ERROR;
+
+	if (!ctx->seen.insert(e).second) return CPL_OK;
+	ctx->edges.push_back(e);
+	return CPL_OK;
 }
 
 
 /**
- * Create an object.
+ * Get the index of the object info template for the given flags
  *
- * @param backend the pointer to the backend structure
- * @param id the ID of the new object
- * @param originator the originator
- * @param name the object name
- * @param type the object type
- * @param container the ID of the object that should contain this object
- *                  (use CPL_NONE for no container)
- * @param container_version the version of the container (if not CPL_NONE)
- * @param session the session ID responsible for this provenance record
- * @return CPL_OK or an error code
+ * @param flags a logical combination of CPL_I_* flags
+ * @return the index in cpl_rdf_templates_t::object_info
  */
-extern "C" cpl_return_t
-cpl_rdf_create_object(struct _cpl_db_backend_t* backend,
-					  const cpl_id_t id,
-					  const char* originator,
-					  const char* name,
-					  const char* type,
-					  const cpl_id_t container,
-					  const cpl_version_t container_version,
-					  const cpl_session_t session)
+static inline int
+cpl_rdf_object_info_index(const int flags)
 {
-	assert(backend != NULL && originator != NULL
-			&& name != NULL && type != NULL);
-	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+	return ((flags & CPL_I_NO_CREATION_SESSION) != 0 ? 1 : 0)
+		 | ((flags & CPL_I_NO_VERSION) != 0 ? 2 : 0);
+}
 
-	char session_str[64];
-	sprintf(session_str, "s:%llx-%llx", session.hi, session.lo);
 
-	char id_str[64];
-	sprintf(id_str, "o:%llx-%llx", id.hi, id.lo);
+/**
+ * Create the query that returns information about objects, ordered by
+ * their IDs unless specified otherwise; the rows are processed by
+ * cpl_rdf_row_object_info()
+ *
+ * @param rdf the RDF backend
+ * @param flags a logical combination of CPL_I_* flags
+ * @param filter additional graph patterns and filters instantiated from the
+ *               filter_* templates, or an empty string
+ * @param order the ORDER BY clause, which must produce a total order
+ * @return the query text
+ */
+static std::string
+cpl_rdf_object_info_query(cpl_rdf_t* rdf, const int flags,
+						  const std::string& filter,
+						  const char* order = "?obj")
+{
+	RDFQuery q(rdf->templates.object_info[cpl_rdf_object_info_index(flags)]);
 
-	char node_str[64];
-	sprintf(node_str, "n:%llx-%llx-0", id.hi, id.lo);
+	std::string r = q.str();
+	r += filter;
+	r += " } ORDER BY ";
+	r += order;
+	return r;
+}
 
-	time_t creation_time = time(NULL);
 
-	std::ostringstream ss;
-
-	ss << "PREFIX s: <session:>\n";
-	ss << "PREFIX o: <object:>\n";
-	ss << "PREFIX n: <node:>\n";
-	ss << "PREFIX p: <prop:>\n";
-	ss << "PREFIX r: <rel:>\n";
-	ss << "INSERT DATA { " << id_str;
-	ss << " p:originator \"" << cpl_rdf_escape_string(originator) << "\";";
-	ss << " p:name \"" << cpl_rdf_escape_string(name) << "\";";
-	ss << " p:type \"" << cpl_rdf_escape_string(type) << "\";";
-	if (container != CPL_NONE) {
-		char container_str[64];
-		sprintf(container_str, "n:%llx-%llx-%x", container.hi,
-				container.lo, container_version);
-		ss << " r:container " << container_str << ";";
-	}
-	ss << " p:creation_time " << creation_time << ";";
-	ss << " r:version " << node_str << " .";
-	ss << " " << node_str << " r:session " << session_str << ";";
-	ss << " p:version 0;";
-	ss << " p:creation_time " << creation_time << ";";
-	ss << "}\n";
-
-	cpl_return_t ret = cpl_rdf_connection_execute_update(rdf->connection_update,
-			ss.str().c_str());
-	
-	return ret;
-}
+/**
+ * The context for cpl_rdf_row_count_page()
+ */
+typedef struct {
+	cpl_rdf_row_callback_t callback;
+	void* context;
+	size_t num_rows;
+} _cpl_rdf_page_context_t;
 
 
 /**
- * Look up an object by name. If multiple objects share the same name,
- * get the latest one.
+ * The row callback for cpl_rdf_query_page(), which counts the rows before
+ * passing them to the actual callback
  *
- * @param backend the pointer to the backend structure
- * @param originator the object originator (namespace)
- * @param name the object name
- * @param type the object type
- * @param out_id the pointer to store the object ID
+ * @param row the result row
+ * @param context the _cpl_rdf_page_context_t
  * @return CPL_OK or an error code
  */
-extern "C" cpl_return_t
-cpl_rdf_lookup_object(struct _cpl_db_backend_t* backend,
-					  const char* originator,
-					  const char* name,
-					  const char* type,
-					  cpl_id_t* out_id)
+static cpl_return_t
+cpl_rdf_row_count_page(RDFResult& row, void* context)
 {
-	assert(backend != NULL);
-	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+	_cpl_rdf_page_context_t* ctx = (_cpl_rdf_page_context_t*) context;
+	ctx->num_rows++;
+	return ctx->callback(row, ctx->context);
+}
 
-	std::ostringstream ss;
-
-	ss << "PREFIX o: <object:>\n";
-	ss << "PREFIX p: <prop:>\n";
-	ss << "SELECT ?obj WHERE { ?obj";
-	ss << " p:originator \"" << cpl_rdf_escape_string(originator) << "\";";
-	ss << " p:name \"" << cpl_rdf_escape_string(name) << "\";";
-	ss << " p:type \"" << cpl_rdf_escape_string(type) << "\";";
-	ss << " p:creation_time ?t .";
-	ss << " OPTIONAL { ?o_obj";
-	ss << "  p:originator \"" << cpl_rdf_escape_string(originator) << "\";";
-	ss << "  p:name \"" << cpl_rdf_escape_string(name) << "\";";
-	ss << "  p:type \"" << cpl_rdf_escape_string(type) << "\";";
-	ss << "  p:creation_time ?o_t .";
-	ss << "  FILTER ( ?o_t > ?t ) . } . FILTER ( !bound(?o_t) ) . }";
 
-	RDFResultSet rs;
-	cpl_return_t ret = cpl_rdf_connection_execute_query(rdf->connection_query,
-			ss.str().c_str(), &rs);
 
-	if (ret == CPL_S_NO_DATA) return CPL_E_NOT_FOUND;
-	if (!CPL_IS_OK(ret)) return ret;
+/***************************************************************************/
+/** Private API: Statement templates                                      **/
+/***************************************************************************/
+
+/**
+ * The prefix declarations used by all statements
+ */
+static const char* CPL_RDF_PREFIXES =
+	"PREFIX s: <session:>\n"
+	"PREFIX o: <object:>\n"
+	"PREFIX n: <node:>\n"
+	"PREFIX p: <prop:>\n"
+	"PREFIX r: <rel:>\n"
+	"PREFIX i: <input:>\n"
+	"PREFIX c: <custom:>\n";
+
+
+/**
+ * Compile all statement templates. See RDFQueryTemplate for the syntax
+ * of the parameters.
+ *
+ * @param t the templates
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+cpl_rdf_compile_templates(cpl_rdf_templates_t* t)
+{
+	cpl_return_t ret = CPL_OK;
+
+#define CPL_RDF_COMPILE(name, prefixes, text) \
+	if (CPL_IS_OK(ret)) ret = t->name.compile(prefixes, text);
+
+
+	// Triples for the write buffer, which get their prefixes when flushed
+
+	CPL_RDF_COMPILE(insert_session, NULL,
+		" %s p:mac_address %l; p:username %l; p:pid %d;"
+		" p:program %l; p:cmdline %l; p:initialization_time %d .");
+
+	CPL_RDF_COMPILE(insert_object, NULL,
+		" %o p:originator %l; p:name %l; p:type %l;"
+		" p:creation_time %d; r:version %n ."
+		" %n r:session %s; p:version 0; p:creation_time %d .");
+
+	CPL_RDF_COMPILE(insert_object_container, NULL,
+		" %o p:originator %l; p:name %l; p:type %l; r:container %n;"
+		" p:creation_time %d; r:version %n ."
+		" %n r:session %s; p:version 0; p:creation_time %d .");
+
+	CPL_RDF_COMPILE(insert_ancestry_edge, NULL,
+		" %n i:%x %n .");
+
+	CPL_RDF_COMPILE(insert_property, NULL,
+		" %n %k %l .");
+
+	CPL_RDF_COMPILE(delete_version_claim, NULL,
+		" %n p:claim %l .");
+
+
+	// Update operations, which are sent after the write buffer
+
+	CPL_RDF_COMPILE(create_version, NULL,
+		"INSERT { %o r:version %n ."
+		" %n r:session %s; p:version %d; p:creation_time %d; p:claim %l . }"
+		" WHERE { FILTER NOT EXISTS { %n p:version ?v } }");
+
+
+	// Queries
+
+	CPL_RDF_COMPILE(check_version_claim, CPL_RDF_PREFIXES,
+		"SELECT ?v WHERE { %n p:version ?v ; p:claim %l }");
+
+	CPL_RDF_COMPILE(lookup_object, CPL_RDF_PREFIXES,
+		"SELECT ?obj WHERE {"
+		" ?obj p:originator %l; p:name %l; p:type %l; p:creation_time ?t ."
+		" OPTIONAL {"
+		"  ?o_obj p:originator %l; p:name %l; p:type %l;"
+		"  p:creation_time ?o_t ."
+		"  FILTER ( ?o_t > ?t ) . } . FILTER ( !bound(?o_t) ) . }");
+
+	CPL_RDF_COMPILE(lookup_object_ext, CPL_RDF_PREFIXES,
+		"SELECT ?obj ?t WHERE {"
+		" ?obj p:originator %l; p:name %l; p:type %l; p:creation_time ?t . }");
+
+	CPL_RDF_COMPILE(get_version, CPL_RDF_PREFIXES,
+		"SELECT ?v WHERE {"
+		" %o r:version ?node . ?node p:version ?v ."
+		" OPTIONAL {"
+		"  %o r:version ?o_node . ?o_node p:version ?o_v ."
+		"  FILTER ( ?o_v > ?v ) . } . FILTER ( !bound(?o_v) ) . }");
+
+	CPL_RDF_COMPILE(has_immediate_ancestor, CPL_RDF_PREFIXES,
+		"SELECT ?v WHERE {"
+		" %o r:version ?node . ?node ?edge ?q_node ."
+		" %o r:version ?q_node . ?q_node p:version ?q_v ."
+		" FILTER ( ?q_v <= %d ) }");
+
+	CPL_RDF_COMPILE(has_immediate_ancestor_node, CPL_RDF_PREFIXES,
+		"SELECT ?v WHERE {"
+		" %n ?edge ?q_node ."
+		" %o r:version ?q_node . ?q_node p:version ?q_v ."
+		" FILTER ( ?q_v <= %d ) }");
+
+	CPL_RDF_COMPILE(get_session_info, CPL_RDF_PREFIXES,
+		"SELECT ?mac_address ?username ?pid ?program"
+		" ?initialization_time ?cmdline WHERE { %s"
+		" p:mac_address ?mac_address ;"
+		" p:username ?username ;"
+		" p:pid ?pid ;"
+		" p:program ?program ;"
+		" p:cmdline ?cmdline ;"
+		" p:initialization_time ?initialization_time . }");
+
+	CPL_RDF_COMPILE(get_object_info, CPL_RDF_PREFIXES,
+		"SELECT ?session ?time ?orig ?name ?type ?container WHERE {"
+		" %n r:session ?session ."
+		" %o p:creation_time ?time ;"
+		" p:originator ?orig ;"
+		" p:name ?name ;"
+		" p:type ?type ."
+		" OPTIONAL { %o r:container ?container . } }");
+
+	CPL_RDF_COMPILE(get_version_info, CPL_RDF_PREFIXES,
+		"SELECT ?session ?time WHERE {"
+		" %n r:session ?session ; p:creation_time ?time }");
+
+	CPL_RDF_COMPILE(get_versions_in_range, CPL_RDF_PREFIXES,
+		"SELECT ?node ?session ?time WHERE {"
+		" ?node p:version ?v ; r:session ?session ; p:creation_time ?time ."
+		" FILTER ( ?time >= %d && ?time <= %d ) . }"
+		" ORDER BY ?time ?node");
+
+	CPL_RDF_COMPILE(get_session_activity, CPL_RDF_PREFIXES,
+		"SELECT ?node ?time WHERE {"
+		" ?node r:session %s ; p:version ?v ; p:creation_time ?time . }"
+		" ORDER BY ?time ?node");
+
+	CPL_RDF_COMPILE(get_ancestors, CPL_RDF_PREFIXES,
+		"SELECT ?edge ?other ?node WHERE {"
+		" %o r:version ?node . ?node ?edge ?other ."
+		" FILTER( isURI(?other) ) }");
+
+	CPL_RDF_COMPILE(get_ancestors_node, CPL_RDF_PREFIXES,
+		"SELECT ?edge ?other WHERE {"
+		" %n ?edge ?other . FILTER( isURI(?other) ) }");
+
+	CPL_RDF_COMPILE(get_descendants, CPL_RDF_PREFIXES,
+		"SELECT ?edge ?other ?node WHERE {"
+		" %o r:version ?node . ?other ?edge ?node ."
+		" FILTER( isURI(?other) ) }");
+
+	CPL_RDF_COMPILE(get_descendants_node, CPL_RDF_PREFIXES,
+		"SELECT ?edge ?other WHERE {"
+		" ?other ?edge %n . FILTER( isURI(?other) ) }");
+
+	CPL_RDF_COMPILE(get_properties, CPL_RDF_PREFIXES,
+		"SELECT ?node ?key ?value WHERE {"
+		" %o r:version ?node . ?node ?key ?value ."
+		" FILTER ( regex(str(?key), \"^custom:\") ) . }"
+		" ORDER BY ?node ?key ?value");
+
+	CPL_RDF_COMPILE(get_properties_node, CPL_RDF_PREFIXES,
+		"SELECT ?key ?value WHERE {"
+		" %n ?key ?value ."
+		" FILTER ( regex(str(?key), \"^custom:\") ) . }"
+		" ORDER BY ?key ?value");
+
+	CPL_RDF_COMPILE(get_property, CPL_RDF_PREFIXES,
+		"SELECT ?node ?value WHERE {"
+		" %o r:version ?node . ?node %k ?value . }"
+		" ORDER BY ?node ?value");
+
+	CPL_RDF_COMPILE(get_property_node, CPL_RDF_PREFIXES,
+		"SELECT ?value WHERE { %n %k ?value . } ORDER BY ?value");
+
+	CPL_RDF_COMPILE(lookup_by_property, CPL_RDF_PREFIXES,
+		"SELECT ?node WHERE { ?node %k %l . } ORDER BY ?node");
+
+
+	// Object info queries, which are completed by the filters and by the
+	// closing brace and the ORDER BY clause
+
+	for (int i = 0; i < 4; i++) {
+		bool session = (i & 1) == 0;
+		bool version = (i & 2) == 0;
+
+		std::string text = "SELECT ?obj ?time ?orig ?name ?type ?container";
+		if (session) text += " ?session";
+		if (version) text += " ?v";
+		text += " WHERE {"
+			" ?obj p:originator ?orig ; p:name ?name ; p:type ?type ;"
+			" p:creation_time ?time ."
+			" OPTIONAL { ?obj r:container ?container . }";
+		if (session) {
+			text += " ?obj r:version ?node0 ."
+				" ?node0 p:version 0 ; r:session ?session .";
+		}
+		if (version) {
+			text += " ?obj r:version ?node . ?node p:version ?v ."
+				" OPTIONAL {"
+				"  ?obj r:version ?o_node . ?o_node p:version ?o_v ."
+				"  FILTER ( ?o_v > ?v ) . } . FILTER ( !bound(?o_v) ) .";
+		}
+
+		CPL_RDF_COMPILE(object_info[i], CPL_RDF_PREFIXES, text.c_str());
+	}
+
+	CPL_RDF_COMPILE(filter_after_object, NULL,
+		" FILTER ( STR(?obj) > STR(%o) ) .");
+
+	CPL_RDF_COMPILE(filter_originator, NULL,
+		" FILTER ( ?orig = %l ) .");
+
+	CPL_RDF_COMPILE(filter_type, NULL,
+		" FILTER ( ?type = %l ) .");
+
+	CPL_RDF_COMPILE(filter_name_prefix, NULL,
+		" FILTER ( STRSTARTS(?name, %l) ) .");
+
+	CPL_RDF_COMPILE(filter_contained, NULL,
+		" %o r:version ?cnode . ?obj r:container ?cnode .");
+
+	CPL_RDF_COMPILE(filter_contained_recursive, NULL,
+		" %o r:version ?cnode ."
+		" ?obj r:container/(^r:version/r:container)* ?cnode .");
+
+	CPL_RDF_COMPILE(filter_contained_node, NULL,
+		" ?obj r:container %n .");
+
+	CPL_RDF_COMPILE(filter_contained_node_recursive, NULL,
+		" ?obj r:container/(^r:version/r:container)* %n .");
+
+
+	// Graph statistics, with the time range as the first two parameters
+
+	CPL_RDF_COMPILE(stats_edges_by_type, CPL_RDF_PREFIXES,
+		"SELECT ?edge (COUNT(*) AS ?n) WHERE {"
+		" ?from p:version ?v ; p:creation_time ?time ; ?edge ?to ."
+		" FILTER ( ?time >= %d && ?time <= %d ) ."
+		" FILTER ( STRSTARTS(STR(?edge), \"input:\") ) ."
+		" } GROUP BY ?edge");
+
+	CPL_RDF_COMPILE(stats_versions_per_object, CPL_RDF_PREFIXES,
+		"SELECT ?k (COUNT(*) AS ?n) WHERE { {"
+		" SELECT ?obj (COUNT(?node) AS ?k) WHERE {"
+		" ?obj r:version ?node ; p:creation_time ?time ."
+		" FILTER ( ?time >= %d && ?time <= %d ) . } GROUP BY ?obj"
+		" } } GROUP BY ?k");
+
+	CPL_RDF_COMPILE(stats_fan_in, CPL_RDF_PREFIXES,
+		"SELECT ?k (COUNT(*) AS ?n) WHERE { {"
+		" SELECT ?node (COUNT(?other) AS ?k) WHERE {"
+		" ?node p:version ?v ; p:creation_time ?time ."
+		" FILTER ( ?time >= %d && ?time <= %d ) ."
+		" OPTIONAL { ?node ?edge ?other ."
+		" FILTER ( STRSTARTS(STR(?edge), \"input:\") ) . } } GROUP BY ?node"
+		" } } GROUP BY ?k");
+
+	CPL_RDF_COMPILE(stats_fan_out, CPL_RDF_PREFIXES,
+		"SELECT ?k (COUNT(*) AS ?n) WHERE { {"
+		" SELECT ?node (COUNT(?other) AS ?k) WHERE {"
+		" ?node p:version ?v ; p:creation_time ?time ."
+		" FILTER ( ?time >= %d && ?time <= %d ) ."
+		" OPTIONAL { ?other ?edge ?node ."
+		" FILTER ( STRSTARTS(STR(?edge), \"input:\") ) . } } GROUP BY ?node"
+		" } } GROUP BY ?k");
+
+	CPL_RDF_COMPILE(stats_objects_per_day, CPL_RDF_PREFIXES,
+		"SELECT ?day ?orig ?type (COUNT(*) AS ?n) WHERE {"
+		" ?obj p:originator ?orig ; p:type ?type ; p:creation_time ?time ."
+		" FILTER ( ?time >= %d && ?time <= %d ) ."
+		" BIND ( <http://www.w3.org/2001/XMLSchema#integer>"
+		"(FLOOR((?time + %d) / 86400)) AS ?day ) } GROUP BY ?day ?orig ?type");
+
+
+	// Pagination
+
+	CPL_RDF_COMPILE(page, NULL, " LIMIT %d OFFSET %d");
+	CPL_RDF_COMPILE(limit, NULL, " LIMIT %d");
+
+#undef CPL_RDF_COMPILE
+
+	return ret;
+}
+
+
+
+/***************************************************************************/
+/** Private API: Write buffer                                             **/
+/***************************************************************************/
+
+
+/**
+ * Send the pending triples to the server as a single INSERT DATA statement,
+ * followed by a DELETE DATA statement for the pending deletions and
+ * optionally by another update operation in the same request. The caller
+ * must hold the write lock. The update is tried several times, and
+ * the buffer is cleared only when it succeeds, so that the updates that were
+ * already accepted are not lost and get sent again by the next flush.
+ *
+ * @param rdf the RDF backend
+ * @param operation the additional update operation that uses the prefixes
+ *                  from CPL_RDF_PREFIXES (can be NULL)
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_rdf_flush_locked(cpl_rdf_t* rdf, const char* operation = NULL)
+{
+	if (rdf->write_buffer.empty() && rdf->delete_buffer.empty()
+			&& operation == NULL) return CPL_OK;
+
+	std::vector<std::string> operations;
+	if (!rdf->write_buffer.empty()) {
+		operations.push_back("INSERT DATA {" + rdf->write_buffer + " }");
+	}
+	if (!rdf->delete_buffer.empty()) {
+		operations.push_back("DELETE DATA {" + rdf->delete_buffer + " }");
+	}
+	if (operation != NULL) operations.push_back(operation);
+
+	std::string statement = CPL_RDF_PREFIXES;
+	for (size_t i = 0; i < operations.size(); i++) {
+		if (i > 0) statement += " ;\n";
+		statement += operations[i];
+	}
+
+	cpl_return_t ret = CPL_E_STATEMENT_ERROR;
+	for (int i = 0; i < CPL_RDF_FLUSH_ATTEMPTS; i++) {
+		ret = cpl_rdf_connection_execute_update(rdf->connection_update,
+				statement.c_str());
+		if (CPL_IS_OK(ret)) {
+			rdf->write_buffer.clear();
+			rdf->delete_buffer.clear();
+			break;
+		}
+	}
+
+	return ret;
+}
+
+
+/**
+ * Send the pending triples to the server
+ *
+ * @param rdf the RDF backend
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_rdf_flush(cpl_rdf_t* rdf)
+{
+	mutex_lock(rdf->write_lock);
+	cpl_return_t ret = cpl_rdf_flush_locked(rdf);
+	mutex_unlock(rdf->write_lock);
+	return ret;
+}
+
+
+/**
+ * Add triples to the write buffer, flushing it first if they do not fit.
+ * The triples use the prefixes from CPL_RDF_PREFIXES and each statement
+ * must be terminated by a period. If the pending triples cannot be sent,
+ * the new triples are rejected, so that the buffer does not grow while the
+ * server is unavailable.
+ *
+ * @param rdf the RDF backend
+ * @param triples the triples to insert
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_rdf_insert(cpl_rdf_t* rdf, const std::string& triples)
+{
+	cpl_return_t ret = CPL_OK;
+
+	mutex_lock(rdf->write_lock);
+
+	if (!rdf->write_buffer.empty() && rdf->write_buffer.length()
+			+ triples.length() > CPL_RDF_WRITE_BUFFER_SIZE) {
+		ret = cpl_rdf_flush_locked(rdf);
+	}
+
+	if (CPL_IS_OK(ret)) {
+		if (rdf->write_buffer.empty() && rdf->delete_buffer.empty()) {
+			cond_broadcast(rdf->write_cond);
+		}
+		rdf->write_buffer += triples;
+	}
+
+	mutex_unlock(rdf->write_lock);
+	return ret;
+}
+
+
+/**
+ * Add triples to be deleted by the next flush, after the pending triples
+ * are inserted. The triples use the prefixes from CPL_RDF_PREFIXES and each
+ * statement must be terminated by a period.
+ *
+ * @param rdf the RDF backend
+ * @param triples the triples to delete
+ */
+static void
+cpl_rdf_delete_later(cpl_rdf_t* rdf, const std::string& triples)
+{
+	mutex_lock(rdf->write_lock);
+
+	if (rdf->write_buffer.empty() && rdf->delete_buffer.empty()) {
+		cond_broadcast(rdf->write_cond);
+	}
+	rdf->delete_buffer += triples;
+
+	mutex_unlock(rdf->write_lock);
+}
+
+
+/**
+ * The flush thread, which sends the pending triples to the server once
+ * they have spent CPL_RDF_WRITE_BUFFER_DELAY_MS in the buffer. The thread
+ * is woken up when the first triple is added to an empty buffer. If the
+ * flush fails, the triples stay in the buffer and the flush is tried again
+ * after another delay.
+ *
+ * @param arg the RDF backend
+ */
+static THREAD_FUNCTION(cpl_rdf_flush_thread, arg)
+{
+	cpl_rdf_t* rdf = (cpl_rdf_t*) arg;
+
+	mutex_lock(rdf->write_lock);
+
+	while (!rdf->flush_thread_stop) {
+
+		if (rdf->write_buffer.empty() && rdf->delete_buffer.empty()) {
+			cond_wait(rdf->write_cond, rdf->write_lock);
+			continue;
+		}
+
+		if (cond_timedwait(rdf->write_cond, rdf->write_lock,
+					CPL_RDF_WRITE_BUFFER_DELAY_MS)) continue;
+
+		cpl_return_t ret = cpl_rdf_flush_locked(rdf);
+		if (!CPL_IS_OK(ret)) {
+			fprintf(stderr, "CPL RDF ERROR: Could not flush the write "
+					"buffer (error %d), will retry.\n", ret);
+		}
+	}
+
+	mutex_unlock(rdf->write_lock);
+	THREAD_RETURN;
+}
+
+
+/**
+ * Execute a query after flushing the write buffer, so that the query
+ * observes all previous updates
+ *
+ * @param rdf the RDF backend
+ * @param statement the query statement
+ * @param out the pointer to an already initialized result set
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+static cpl_return_t
+cpl_rdf_query(cpl_rdf_t* rdf, const char* statement, RDFResultSet* out)
+{
+	cpl_return_t ret = cpl_rdf_flush(rdf);
+	if (!CPL_IS_OK(ret)) return ret;
+
+	return cpl_rdf_connection_execute_query(rdf->connection_query,
+			statement, out);
+}
+
+
+/**
+ * Execute a streaming query after flushing the write buffer, so that the
+ * query observes all previous updates
+ *
+ * @param rdf the RDF backend
+ * @param statement the query statement
+ * @param callback the row callback
+ * @param context the caller-provided context for the callback
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+static cpl_return_t
+cpl_rdf_query_stream(cpl_rdf_t* rdf,
+					 const char* statement,
+					 cpl_rdf_row_callback_t callback,
+					 void* context)
+{
+	cpl_return_t ret = cpl_rdf_flush(rdf);
+	if (!CPL_IS_OK(ret)) return ret;
+
+	return cpl_rdf_connection_execute_query_stream(rdf->connection_query,
+			statement, callback, context);
+}
+
+
+/**
+ * Execute one page of a paginated query. The statement must have an ORDER
+ * BY clause, so that the pages do not overlap.
+ *
+ * @param rdf the RDF backend
+ * @param statement the query statement (without LIMIT and OFFSET)
+ * @param page the page number, starting at 0
+ * @param callback the row callback
+ * @param context the caller-provided context for the callback
+ * @param out_num_rows the pointer to store the number of rows in the page
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+static cpl_return_t
+cpl_rdf_query_page(cpl_rdf_t* rdf,
+				   const std::string& statement,
+				   size_t page,
+				   cpl_rdf_row_callback_t callback,
+				   void* context,
+				   size_t* out_num_rows)
+{
+	RDFQuery q(rdf->templates.page);
+	q.integer(CPL_RDF_PAGE_SIZE).integer(page * CPL_RDF_PAGE_SIZE);
+	std::string s = statement + q.str();
+
+	_cpl_rdf_page_context_t ctx;
+	ctx.callback = callback;
+	ctx.context = context;
+	ctx.num_rows = 0;
+
+	cpl_return_t ret = cpl_rdf_query_stream(rdf, s.c_str(),
+			cpl_rdf_row_count_page, &ctx);
+
+	*out_num_rows = ctx.num_rows;
+	return ret;
+}
+
+
+/**
+ * Execute an object info query (see cpl_rdf_object_info_query()) one page
+ * at a time, so that the responses stay small, and call the iterator for
+ * each object after each page
+ *
+ * @param rdf the RDF backend
+ * @param query the query statement (without LIMIT and OFFSET)
+ * @param flags a logical combination of CPL_I_* flags
+ * @param iterator the iterator to be called for each object (can be NULL)
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+static cpl_return_t
+cpl_rdf_iterate_object_info(cpl_rdf_t* rdf,
+							const std::string& query,
+							const int flags,
+							cpl_object_info_iterator_t iterator,
+							void* context)
+{
+	cpl_return_t ret;
+
+	_cpl_rdf_object_info_context_t ctx;
+	ctx.flags = flags;
+
+	bool found = false;
+	size_t num_rows = 0;
+
+	for (size_t page = 0; ; page++) {
+
+		ctx.objects.clear();
+		ret = cpl_rdf_query_page(rdf, query, page,
+				cpl_rdf_row_object_info, &ctx, &num_rows);
+
+		if (ret == CPL_S_NO_DATA) break;
+		if (!CPL_IS_OK(ret)) return ret;
+		if (!ctx.objects.empty()) found = true;
+
+		if (iterator != NULL) {
+			std::list<cplxx_object_info_t>::iterator i;
+			for (i = ctx.objects.begin(); i != ctx.objects.end(); i++) {
+
+				cpl_object_info_t e;
+				e.id = i->id;
+				e.version = i->version;
+				e.creation_session = i->creation_session;
+				e.creation_time = i->creation_time;
+				e.originator = (char*) i->originator.c_str();
+				e.name = (char*) i->name.c_str();
+				e.type = (char*) i->type.c_str();
+				e.container_id = i->container_id;
+				e.container_version = i->container_version;
+
+				ret = iterator(&e, context);
+				if (!CPL_IS_OK(ret)) return ret;
+			}
+		}
+
+		if (num_rows < CPL_RDF_PAGE_SIZE) break;
+	}
+
+	return found ? CPL_OK : CPL_S_NO_DATA;
+}
+
+
+
+/***************************************************************************/
+/** Constructor and Destructor                                            **/
+/***************************************************************************/
+
+/**
+ * Create an RDF backend
+ *
+ * @param url_query the SPARQL query endpoint URL
+ * @param url_update the SPARQL update endpoint URL
+ * @param db_type the database type
+ * @param out the pointer to the database backend variable
+ * @return the error code
+ */
+extern "C" cpl_return_t
+cpl_create_rdf_backend(const char* url_query,
+					   const char* url_update,
+					   int db_type,
+					   cpl_db_backend_t** out)
+{
+	cpl_return_t r = CPL_OK;
+
+	assert(out != NULL);
+	if (url_query  == NULL) return CPL_E_INVALID_ARGUMENT;
+	if (url_update == NULL) return CPL_E_INVALID_ARGUMENT;
+
+
+	// Allocate the backend struct
+
+	cpl_rdf_t* rdf = new cpl_rdf_t;
+	if (rdf == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
+	memcpy(&rdf->backend, &CPL_RDF_BACKEND, sizeof(rdf->backend));
+
+	rdf->db_type = db_type;
+	rdf->url_query = url_query;
+	rdf->url_update = url_update;
+
+
+	// Prepare the statements
+
+	r = cpl_rdf_compile_templates(&rdf->templates);
+	if (!CPL_IS_OK(r)) goto err_free;
+
+
+	// Initialize the connection handles
+
+	rdf->connection_query = cpl_rdf_connection_init(rdf->url_query.c_str());
+	if (rdf->connection_query == NULL) {
+		r = CPL_E_DB_CONNECTION_ERROR;
+		goto err_free;
+	}
+
+	rdf->connection_update = cpl_rdf_connection_init(rdf->url_update.c_str());
+	if (rdf->connection_update == NULL) {
+		r = CPL_E_DB_CONNECTION_ERROR;
+		goto err_close_query;
+	}
+
+
+	// Initialize the write buffer and start the flush thread
+
+	rdf->claim_counter = 0;
+	rdf->flush_thread_stop = false;
+	mutex_init(rdf->write_lock);
+	cond_init(rdf->write_cond);
+	pthread_mutex_init(&rdf->hop_templates_lock, NULL);
+
+	if (!thread_create(rdf->flush_thread, cpl_rdf_flush_thread, rdf)) {
+		r = CPL_E_PLATFORM_ERROR;
+		goto err_sync;
+	}
+
+
+	// Return
+
+	*out = (cpl_db_backend_t*) rdf;
+	return CPL_OK;
+
+
+err_sync:
+	pthread_mutex_destroy(&rdf->hop_templates_lock);
+	cond_destroy(rdf->write_cond);
+	mutex_destroy(rdf->write_lock);
+	cpl_rdf_connection_close(rdf->connection_update);
+
+err_close_query:
+	cpl_rdf_connection_close(rdf->connection_query);
+
+err_free:
+	delete rdf;
+
+	assert(!CPL_IS_OK(r));
+	return r;
+}
+
+
+/**
+ * Destructor. If the constructor allocated the backend structure, it
+ * should be freed by this function
+ *
+ * @param backend the pointer to the backend structure
+ * @param the error code
+ */
+extern "C" cpl_return_t
+cpl_rdf_destroy(struct _cpl_db_backend_t* backend)
+{
+	assert(backend != NULL);
+	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+
+
+	// Stop the flush thread and send the remaining updates
+
+	mutex_lock(rdf->write_lock);
+	rdf->flush_thread_stop = true;
+	cond_broadcast(rdf->write_cond);
+	mutex_unlock(rdf->write_lock);
+
+	thread_join(rdf->flush_thread);
+
+	cpl_return_t ret = cpl_rdf_flush(rdf);
+	if (!CPL_IS_OK(ret)) {
+		fprintf(stderr, "CPL RDF ERROR: Could not flush the write "
+				"buffer (error %d), %lu bytes of updates were lost.\n",
+				ret, (unsigned long) rdf->write_buffer.length());
+	}
+
+	pthread_mutex_destroy(&rdf->hop_templates_lock);
+	cond_destroy(rdf->write_cond);
+	mutex_destroy(rdf->write_lock);
+
+
+	// Close the connections
+
+	cpl_rdf_connection_close(rdf->connection_query);
+	cpl_rdf_connection_close(rdf->connection_update);
+
+	delete rdf;
+	return CPL_OK;
+}
+
+
+
+/***************************************************************************/
+/** Private API: Streaming result handlers                                **/
+/***************************************************************************/
+
+/**
+ * An object ID and a timestamp decoded from a result row
+ */
+typedef struct {
+	cpl_id_t id;
+	unsigned long timestamp;
+} _cpl_rdf_id_timestamp_t;
+
+
+/**
+ * The row callback for cpl_rdf_lookup_object_ext()
+ *
+ * @param row the result row with ?obj and ?t
+ * @param context the std::list<_cpl_rdf_id_timestamp_t>
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_rdf_row_id_timestamp(RDFResult& row, void* context)
+{
+	std::list<_cpl_rdf_id_timestamp_t>* l
+		= (std::list<_cpl_rdf_id_timestamp_t>*) context;
+	_cpl_rdf_id_timestamp_t e;
+	cpl_return_t ret;
+	RDFValue* v;
+
+	ret = row.get_s("obj", RDF_XSD_URI, &v);
+	if (!CPL_IS_OK(ret)) return ret;
+	int r = sscanf(v->v_uri, "object:%llx-%llx", &e.id.hi, &e.id.lo);
+	if (r != 2) return CPL_E_BACKEND_INTERNAL_ERROR;
+
+	ret = row.get_s("t", RDF_XSD_INTEGER, &v);
+	if (!CPL_IS_OK(ret)) return ret;
+	e.timestamp = v->v_integer;
+
+	l->push_back(e);
+	return CPL_OK;
+}
+
+
+/**
+ * An ancestry edge decoded from a result row
+ */
+typedef struct {
+	cpl_id_t query_id;
+	cpl_version_t query_version;
+	cpl_id_t other_id;
+	cpl_version_t other_version;
+	int type;
+} _cpl_rdf_ancestry_edge_t;
+
+
+/**
+ * The context for cpl_rdf_row_ancestry_edge()
+ */
+typedef struct {
+	cpl_version_t version;
+	int flags;
+	std::list<_cpl_rdf_ancestry_edge_t> edges;
+} _cpl_rdf_ancestry_context_t;
+
+
+/**
+ * The row callback for cpl_rdf_get_object_ancestry()
+ *
+ * @param row the result row with ?edge, ?other, and possibly ?node
+ * @param context the _cpl_rdf_ancestry_context_t
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_rdf_row_ancestry_edge(RDFResult& row, void* context)
+{
+	_cpl_rdf_ancestry_context_t* ctx = (_cpl_rdf_ancestry_context_t*) context;
+	_cpl_rdf_ancestry_edge_t e;
+	cpl_return_t ret;
+	RDFValue* v;
+	int r;
+
+
+	// Parse the edge and filter out non-ancestry edges
+
+	ret = row.get_s("edge", RDF_XSD_URI, &v);
+	if (!CPL_IS_OK(ret)) return ret;
+	if (strncmp(v->v_uri, "input:", 6) != 0) return CPL_OK;
+
+	r = sscanf(v->v_uri, "input:%x", &e.type);
+	if (r != 1) return CPL_E_BACKEND_INTERNAL_ERROR;
+
+
+	// Filter by type
+
+	int type_category = CPL_GET_DEPENDENCY_CATEGORY(e.type);
+	if (type_category == CPL_DEPENDENCY_CATEGORY_DATA
+			&& (ctx->flags & CPL_A_NO_DATA_DEPENDENCIES) != 0) return CPL_OK;
+	if (type_category == CPL_DEPENDENCY_CATEGORY_CONTROL
+			&& (ctx->flags & CPL_A_NO_CONTROL_DEPENDENCIES) != 0) return CPL_OK;
+
+
+	// Get the query node
+
+	if (ctx->version == CPL_VERSION_NONE) {
+		ret = row.get_s("node", RDF_XSD_URI, &v);
+		if (!CPL_IS_OK(ret)) return ret;
+
+		r = sscanf(v->v_uri, "node:%llx-%llx-%x",
+				&e.query_id.hi, &e.query_id.lo, &e.query_version);
+		if (r != 3) return CPL_E_BACKEND_INTERNAL_ERROR;
+	}
+	else {
+		e.query_id = CPL_NONE;
+		e.query_version = ctx->version;
+	}
+
+
+	// Get the other node
+
+	ret = row.get_s("other", RDF_XSD_URI, &v);
+	if (!CPL_IS_OK(ret)) return ret;
+
+	r = sscanf(v->v_uri, "node:%llx-%llx-%x",
+			&e.other_id.hi, &e.other_id.lo, &e.other_version);
+	if (r != 3) return CPL_E_BACKEND_INTERNAL_ERROR;
+
+	ctx->edges.push_back(e);
+	return CPL_OK;
+}
+
+
+
+/***************************************************************************/
+/** Public API                                                            **/
+/***************************************************************************/
+
+/**
+ * Create a session.
+ *
+ * @param backend the pointer to the backend structure
+ * @param session the session ID to use
+ * @param mac_address human-readable MAC address (NULL if not available)
+ * @param user the user name
+ * @param pid the process ID
+ * @param program the program name
+ * @param cmdline the command line
+ * @return CPL_OK or an error code
+ */
+extern "C" cpl_return_t
+cpl_rdf_create_session(struct _cpl_db_backend_t* backend,
+					   const cpl_session_t session,
+					   const char* mac_address,
+					   const char* user,
+					   const int pid,
+					   const char* program,
+					   const char* cmdline)
+{
+	assert(backend != NULL && user != NULL && program != NULL && cmdline!=NULL);
+	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+
+	// Only for debugging
+	// cpl_rdf_connection_execute_update(rdf->connection_update,
+	//		"DELETE { ?s ?p ?o } WHERE { ?s ?p ?o }");
+
+	RDFQuery q(rdf->templates.insert_session);
+	q.session(session).literal(mac_address).literal(user).integer(pid)
+	 .literal(program).literal(cmdline).integer(time(NULL));
+
+	return cpl_rdf_insert(rdf, q.str());
+}
+
+
+/**
+ * Create an object.
+ *
+ * @param backend the pointer to the backend structure
+ * @param id the ID of the new object
+ * @param originator the originator
+ * @param name the object name
+ * @param type the object type
+ * @param container the ID of the object that should contain this object
+ *                  (use CPL_NONE for no container)
+ * @param container_version the version of the container (if not CPL_NONE)
+ * @param session the session ID responsible for this provenance record
+ * @return CPL_OK or an error code
+ */
+extern "C" cpl_return_t
+cpl_rdf_create_object(struct _cpl_db_backend_t* backend,
+					  const cpl_id_t id,
+					  const char* originator,
+					  const char* name,
+					  const char* type,
+					  const cpl_id_t container,
+					  const cpl_version_t container_version,
+					  const cpl_session_t session)
+{
+	assert(backend != NULL && originator != NULL
+			&& name != NULL && type != NULL);
+	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+
+	time_t creation_time = time(NULL);
+
+	RDFQuery q(container == CPL_NONE ? rdf->templates.insert_object
+			: rdf->templates.insert_object_container);
+
+	q.object(id).literal(originator).literal(name).literal(type);
+	if (container != CPL_NONE) q.node(container, container_version);
+	q.integer(creation_time).node(id, 0);
+	q.node(id, 0).session(session).integer(creation_time);
+
+	return cpl_rdf_insert(rdf, q.str());
+}
+
+
+/**
+ * Look up an object by name. If multiple objects share the same name,
+ * get the latest one.
+ *
+ * @param backend the pointer to the backend structure
+ * @param originator the object originator (namespace)
+ * @param name the object name
+ * @param type the object type
+ * @param out_id the pointer to store the object ID
+ * @return CPL_OK or an error code
+ */
+extern "C" cpl_return_t
+cpl_rdf_lookup_object(struct _cpl_db_backend_t* backend,
+					  const char* originator,
+					  const char* name,
+					  const char* type,
+					  cpl_id_t* out_id)
+{
+	assert(backend != NULL);
+	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+
+	RDFQuery q(rdf->templates.lookup_object);
+	q.literal(originator).literal(name).literal(type);
+	q.literal(originator).literal(name).literal(type);
+
+	RDFResultSet rs;
+	cpl_return_t ret = cpl_rdf_query(rdf, q.c_str(), &rs);
+
+	if (ret == CPL_S_NO_DATA) return CPL_E_NOT_FOUND;
+	if (!CPL_IS_OK(ret)) return ret;
+
+	if (out_id != NULL) {
+		if (rs.size() == 0) return CPL_E_BACKEND_INTERNAL_ERROR;
+		//if (rs.size() >  1) return CPL_E_BACKEND_INTERNAL_ERROR;
+
+		RDFValue* v;
+		ret = rs[0].get_s("obj", RDF_XSD_URI, &v);
+		if (!CPL_IS_OK(ret)) return ret;
+		int r = sscanf(v->v_uri, "object:%llx-%llx", &out_id->hi, &out_id->lo);
+		if (r != 2) return CPL_E_BACKEND_INTERNAL_ERROR;
+	}
+	
+	return CPL_OK;
+}
+
+
+/**
+ * Look up an object by name. If multiple objects share the same name,
+ * return all of them.
+ *
+ * @param backend the pointer to the backend structure
+ * @param originator the object originator
+ * @param name the object name
+ * @param type the object type
+ * @param flags a logical combination of CPL_L_* flags
+ * @param iterator the iterator to be called for each matching object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+cpl_rdf_lookup_object_ext(struct _cpl_db_backend_t* backend,
+						  const char* originator,
+						  const char* name,
+						  const char* type,
+						  const int flags,
+						  cpl_id_timestamp_iterator_t iterator,
+						  void* context)
+{
+	assert(backend != NULL);
+	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+
+	RDFQuery q(rdf->templates.lookup_object_ext);
+	q.literal(originator).literal(name).literal(type);
+
+	std::list<_cpl_rdf_id_timestamp_t> l;
+	cpl_return_t ret = cpl_rdf_query_stream(rdf, q.c_str(),
+			cpl_rdf_row_id_timestamp, &l);
+
+	if (ret == CPL_S_NO_DATA) return CPL_E_NOT_FOUND;
+	if (!CPL_IS_OK(ret)) return ret;
+	if (l.empty()) return CPL_E_BACKEND_INTERNAL_ERROR;
+
+	std::list<_cpl_rdf_id_timestamp_t>::iterator i;
+	for (i = l.begin(); i != l.end(); i++) {
+		ret = iterator(i->id, i->timestamp, context);
+		if (!CPL_IS_OK(ret)) return ret;
+	}
+	
+	return CPL_OK;
+}
+
+
+/**
+ * Create a new version of the given object
+ *
+ * @param backend the pointer to the backend structure
+ * @param object_id the object ID
+ * @param version the new version of the object
+ * @param session the session ID responsible for this provenance record
+ * @return CPL_OK or an error code
+ */
+extern "C" cpl_return_t
+cpl_rdf_create_version(struct _cpl_db_backend_t* backend,
+					   const cpl_id_t object_id,
+					   const cpl_version_t version,
+					   const cpl_session_t session)
+{
+	assert(backend != NULL);
+	assert(version > 0);
+	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+	cpl_return_t ret;
+
+	// Create the version using a conditional update, which does nothing if
+	// the version already exists. SPARQL Update does not report whether
+	// anything was inserted, so the update also records a claim unique to
+	// this request, which tells us which request created the version.
+	// The claim is then deleted by the next flush of the write buffer.
+
+	mutex_lock(rdf->write_lock);
+
+	std::string claim;
+	cpl_rdf_append_hex(claim, session.hi);
+	claim.push_back('-');
+	cpl_rdf_append_hex(claim, session.lo);
+	claim.push_back('-');
+	cpl_rdf_append_hex(claim, rdf->claim_counter++);
+
+	RDFQuery q_create(rdf->templates.create_version);
+	q_create.object(object_id).node(object_id, version);
+	q_create.node(object_id, version).session(session).integer(version)
+			.integer(time(NULL)).literal(claim.c_str());
+	q_create.node(object_id, version);
+
+	ret = cpl_rdf_flush_locked(rdf, q_create.c_str());
+
+	mutex_unlock(rdf->write_lock);
+	if (!CPL_IS_OK(ret)) return ret;
+
+
+	// Check whether the version was created by this request
+
+	RDFQuery q_check(rdf->templates.check_version_claim);
+	q_check.node(object_id, version).literal(claim.c_str());
+
+	RDFResultSet rs;
+	ret = cpl_rdf_query(rdf, q_check.c_str(), &rs);
+
+	RDFQuery q_delete(rdf->templates.delete_version_claim);
+	q_delete.node(object_id, version).literal(claim.c_str());
+	cpl_rdf_delete_later(rdf, q_delete.str());
+
+	if (ret == CPL_S_NO_DATA) return CPL_E_ALREADY_EXISTS;
+	if (!CPL_IS_OK(ret)) return ret;
+
+	return CPL_OK;
+}
+
+
+/**
+ * Determine the version of the object
+ *
+ * @param backend the pointer to the backend structure
+ * @param id the object ID
+ * @param out_version the pointer to store the version of the object
+ * @return CPL_OK or an error code
+ */
+extern "C" cpl_return_t
+cpl_rdf_get_version(struct _cpl_db_backend_t* backend,
+					const cpl_id_t id,
+					cpl_version_t* out_version)
+{
+	assert(backend != NULL);
+	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+
+	RDFQuery q(rdf->templates.get_version);
+	q.object(id).object(id);
+
+	RDFResultSet rs;
+	cpl_return_t ret = cpl_rdf_query(rdf, q.c_str(), &rs);
+
+	if (ret == CPL_S_NO_DATA) return CPL_E_NOT_FOUND;
+	if (!CPL_IS_OK(ret)) return ret;
+
+	if (out_version != NULL) {
+		if (rs.size() == 0) return CPL_E_BACKEND_INTERNAL_ERROR;
+		//if (rs.size() >  1) return CPL_E_BACKEND_INTERNAL_ERROR;
+
+		RDFValue* v;
+		ret = rs[0].get_s("v", RDF_XSD_INTEGER, &v);
+		if (!CPL_IS_OK(ret)) return ret;
+		*out_version = (cpl_version_t) v->v_integer;
+	}
+	
+	return CPL_OK;
+}
+
+
+/**
+ * Add an ancestry edge
+ *
+ * @param backend the pointer to the backend structure
+ * @param from_id the edge source ID
+ * @param from_ver the edge source version
+ * @param to_id the edge destination ID
+ * @param to_ver the edge destination version
+ * @param type the data or control dependency type
+ * @return the object version or an error code
+ */
+extern "C" cpl_return_t
+cpl_rdf_add_ancestry_edge(struct _cpl_db_backend_t* backend,
+						  const cpl_id_t from_id,
+						  const cpl_version_t from_ver,
+						  const cpl_id_t to_id,
+						  const cpl_version_t to_ver,
+						  const int type)
+{
+	assert(backend != NULL);
+	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+
+	RDFQuery q(rdf->templates.insert_ancestry_edge);
+	q.node(from_id, from_ver).hex((unsigned) type).node(to_id, to_ver);
+
+	return cpl_rdf_insert(rdf, q.str());
+}
+
+
+/**
+ * Determine whether the given object has the given ancestor
+ *
+ * @param backend the pointer to the backend structure
+ * @param object_id the object ID
+ * @param version_hint the object version (if known), or CPL_VERSION_NONE
+ *                     otherwise
+ * @param query_object_id the object that we want to determine whether it
+ *                        is one of the immediate ancestors
+ * @param query_object_max_version the maximum version of the query
+ *                                 object to consider
+ * @param out the pointer to store a positive number if yes, or 0 if no
+ * @return CPL_OK or an error code
+ */
+extern "C" cpl_return_t
+cpl_rdf_has_immediate_ancestor(struct _cpl_db_backend_t* backend,
+							   const cpl_id_t object_id,
+							   const cpl_version_t version_hint,
+							   const cpl_id_t query_object_id,
+							   const cpl_version_t query_object_max_version,
+							   int* out)
+{
+	assert(backend != NULL);
+	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+
+	RDFQuery q(version_hint == CPL_VERSION_NONE
+			? rdf->templates.has_immediate_ancestor
+			: rdf->templates.has_immediate_ancestor_node);
+
+	if (version_hint == CPL_VERSION_NONE) {
+		q.object(object_id);
+	}
+	else {
+		q.node(object_id, version_hint);
+	}
+	q.object(query_object_id).integer(query_object_max_version);
+
+	RDFResultSet rs;
+	cpl_return_t ret = cpl_rdf_query(rdf, q.c_str(), &rs);
+
+	if (!CPL_IS_OK(ret)) {
+		//rs.print_error_messages(std::cerr);
+		return ret;
+	}
+	if (out != NULL) *out = (ret == CPL_S_NO_DATA) ? 0 : 1;
+	return CPL_OK;
+}
+
+
+/**
+ * Add a property to the given object
+ *
+ * @param backend the pointer to the backend structure
+ * @param id the object ID
+ * @param version the version number
+ * @param key the key
+ * @param value the value
+ * @return CPL_OK or an error code
+ */
+extern "C" cpl_return_t
+cpl_rdf_add_property(struct _cpl_db_backend_t* backend,
+                     const cpl_id_t id,
+                     const cpl_version_t version,
+                     const char* key,
+                     const char* value)
+{
+    assert(backend != NULL);
+    cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+
+	RDFQuery q(rdf->templates.insert_property);
+	q.node(id, version).key(key).literal(value);
+
+	return cpl_rdf_insert(rdf, q.str());
+}
+
+
+/**
+ * Get information about the given provenance session.
+ *
+ * @param id the session ID
+ * @param out_info the pointer to store the session info structure
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+cpl_rdf_get_session_info(struct _cpl_db_backend_t* backend,
+						 const cpl_session_t id,
+						 cpl_session_info_t** out_info)
+{
+	assert(backend != NULL);
+	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+	cpl_return_t ret;
+
+
+	// Prepare the query
+
+	RDFQuery q(rdf->templates.get_session_info);
+	q.session(id);
+
+
+	// Execute query
+
+	RDFResultSet rs;
+	ret = cpl_rdf_query(rdf, q.c_str(), &rs);
+
+	if (ret == CPL_S_NO_DATA) return CPL_E_NOT_FOUND;
+	if (!CPL_IS_OK(ret)) {
+		//rs.print_error_messages(std::cerr);
+		return ret;
+	}
+
+
+	// Process the result
+
+	if (out_info == NULL) return CPL_OK;
+	if (rs.size() == 0) return CPL_E_BACKEND_INTERNAL_ERROR;
+	if (rs.size() >  1) return CPL_E_BACKEND_INTERNAL_ERROR;
+
+	cpl_session_info_t* p = (cpl_session_info_t*) malloc(sizeof(*p));
+	if (p == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
+	memset(p, 0, sizeof(*p));
+	p->id = id;
+
+	RDFValue* v;
+
+	ret = rs[0].get_s("mac_address", RDF_XSD_STRING, &v);
+	if (!CPL_IS_OK(ret)) goto err;
+	p->mac_address = strdup(v->v_string);
+
+	ret = rs[0].get_s("username", RDF_XSD_STRING, &v);
+	if (!CPL_IS_OK(ret)) goto err;
+	p->user = strdup(v->v_string);
+
+	ret = rs[0].get_s("pid", RDF_XSD_INTEGER, &v);
+	if (!CPL_IS_OK(ret)) goto err;
+	p->pid = v->v_integer;
+
+	ret = rs[0].get_s("program", RDF_XSD_STRING, &v);
+	if (!CPL_IS_OK(ret)) goto err;
+	p->program = strdup(v->v_string);
+
+	ret = rs[0].get_s("cmdline", RDF_XSD_STRING, &v);
+	if (!CPL_IS_OK(ret)) goto err;
+	p->cmdline = strdup(v->v_string);
+
+	ret = rs[0].get_s("initialization_time", RDF_XSD_INTEGER, &v);
+	if (!CPL_IS_OK(ret)) goto err;
+	p->start_time = v->v_integer;
+
+	*out_info = p;
+	return CPL_OK;
+
+err:
+	if (p->mac_address != NULL) free(p->mac_address);
+	if (p->user != NULL) free(p->user);
+	if (p->program != NULL) free(p->program);
+	if (p->cmdline != NULL) free(p->cmdline);
+	free(p);
+
+	return ret;
+}
+
+
+/**
+ * Get all objects in the database
+ *
+ * @param backend the pointer to the backend structure
+ * @param flags a logical combination of CPL_I_* flags
+ * @param iterator the iterator to be called for each matching object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+cpl_rdf_get_all_objects(struct _cpl_db_backend_t* backend,
+						 const int flags,
+						 cpl_object_info_iterator_t iterator,
+						 void* context)
+{
+	assert(backend != NULL);
+	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+
+
+	// Prepare the query
+
+	std::string query = cpl_rdf_object_info_query(rdf, flags, "");
+
+
+	// Fetch the objects
+
+	return cpl_rdf_iterate_object_info(rdf, query, flags, iterator, context);
+}
+
+/**
+ * Get the objects created inside the given container, optionally including
+ * the contents of the nested containers at any depth.
+ *
+ * @param backend the pointer to the backend structure
+ * @param container the container ID
+ * @param version the container version, or CPL_VERSION_NONE for all
+ *                versions of the container
+ * @param recursive whether to descend into the nested containers
+ * @param flags a logical combination of CPL_I_* flags
+ * @param iterator the iterator to be called for each contained object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+cpl_return_t
+cpl_rdf_get_contained_objects(struct _cpl_db_backend_t* backend,
+							  const cpl_id_t container,
+							  const cpl_version_t version,
+							  const int recursive,
+							  const int flags,
+							  cpl_object_info_iterator_t iterator,
+							  void* context)
+{
+	assert(backend != NULL);
+	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+
+
+	// Prepare the query. The nested containers are reached by a property
+	// path that alternates between the container version nodes and their
+	// objects, so that the entire hierarchy is traversed by a single query.
+
+	const cpl_rdf_templates_t& t = rdf->templates;
+	std::string filter;
+	if (version == CPL_VERSION_NONE) {
+		RDFQuery f(recursive ? t.filter_contained_recursive
+							 : t.filter_contained);
+		filter = f.object(container).str();
+	}
+	else {
+		RDFQuery f(recursive ? t.filter_contained_node_recursive
+							 : t.filter_contained_node);
+		filter = f.node(container, version).str();
+	}
+
+	std::string query = cpl_rdf_object_info_query(rdf, flags, filter);
+
+
+	// Fetch the objects
+
+	return cpl_rdf_iterate_object_info(rdf, query, flags, iterator, context);
+}
+
+/**
+ * Get the objects whose names start with the given prefix, ordered by their
+ * names, optionally restricted to the given originator and type.
+ *
+ * @param backend the pointer to the backend structure
+ * @param originator the object originator, or NULL for any
+ * @param prefix the name prefix
+ * @param type the object type, or NULL for any
+ * @param flags a logical combination of CPL_I_* flags
+ * @param iterator the iterator to be called for each matching object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+cpl_return_t
+cpl_rdf_lookup_by_name_prefix(struct _cpl_db_backend_t* backend,
+							  const char* originator,
+							  const char* prefix,
+							  const char* type,
+							  const int flags,
+							  cpl_object_info_iterator_t iterator,
+							  void* context)
+{
+	assert(backend != NULL);
+	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+
+
+	// Prepare the query
+
+	const cpl_rdf_templates_t& t = rdf->templates;
+	std::string filter = RDFQuery(t.filter_name_prefix).literal(prefix).str();
+	if (originator != NULL) {
+		filter += RDFQuery(t.filter_originator).literal(originator).str();
+	}
+	if (type != NULL) {
+		filter += RDFQuery(t.filter_type).literal(type).str();
+	}
+
+	std::string query = cpl_rdf_object_info_query(rdf, flags, filter,
+			"?name ?obj");
+
+
+	// Fetch the objects
+
+	return cpl_rdf_iterate_object_info(rdf, query, flags, iterator, context);
+}
+
+
+
+
+/**
+ * Get the next page of objects in the order of their IDs, using keyset
+ * pagination on the object URIs
+ *
+ * @param backend the pointer to the backend structure
+ * @param after the ID of the last object of the previous page, or
+ *              CPL_NONE to get the first page
+ * @param originator the object originator, or NULL for any
+ * @param type the object type, or NULL for any
+ * @param flags a logical combination of CPL_I_* flags
+ * @param max_count the maximum number of objects to return
+ * @param out_infos the array of max_count pointers to store the object
+ *                  info structures
+ * @param out_count the pointer to store the number of returned objects
+ * @return CPL_OK, CPL_S_NO_DATA if there are no more objects, or an error
+ *         code
+ */
+cpl_return_t
+cpl_rdf_get_objects_page(struct _cpl_db_backend_t* backend,
+						 const cpl_id_t after,
+						 const char* originator,
+						 const char* type,
+						 const int flags,
+						 const size_t max_count,
+						 cpl_object_info_t** out_infos,
+						 size_t* out_count)
+{
+	assert(backend != NULL);
+	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+	cpl_return_t ret;
+
+	*out_count = 0;
+	if (max_count == 0) return CPL_OK;
+
+
+	// Prepare the query, limiting the page so that the response stays small
+
+	const cpl_rdf_templates_t& t = rdf->templates;
+	std::string filter;
+	if (after != CPL_NONE) {
+		filter += RDFQuery(t.filter_after_object).object(after).str();
+	}
+	if (originator != NULL) {
+		filter += RDFQuery(t.filter_originator).literal(originator).str();
+	}
+	if (type != NULL) {
+		filter += RDFQuery(t.filter_type).literal(type).str();
+	}
+
+	RDFQuery q_limit(t.limit);
+	q_limit.integer(max_count < CPL_RDF_PAGE_SIZE
+			? max_count : CPL_RDF_PAGE_SIZE);
+	std::string query = cpl_rdf_object_info_query(rdf, flags, filter)
+		+ q_limit.str();
+
+
+	// Execute the query
+
+	_cpl_rdf_object_info_context_t ctx;
+	ctx.flags = flags;
+
+	ret = cpl_rdf_query_stream(rdf, query.c_str(),
+			cpl_rdf_row_object_info, &ctx);
+	if (!CPL_IS_OK(ret)) return ret;
+	if (ret == CPL_S_NO_DATA || ctx.objects.empty()) return CPL_S_NO_DATA;
+
+
+	// Process the result
+
+	size_t count = 0;
+	std::list<cplxx_object_info_t>::iterator i;
+	for (i = ctx.objects.begin(); i != ctx.objects.end(); i++) {
+
+		cpl_object_info_t* p = (cpl_object_info_t*) malloc(sizeof(*p));
+		if (p == NULL) goto err;
+
+		p->id = i->id;
+		p->version = i->version;
+		p->creation_session = i->creation_session;
+		p->creation_time = i->creation_time;
+		p->originator = strdup(i->originator.c_str());
+		p->name = strdup(i->name.c_str());
+		p->type = strdup(i->type.c_str());
+		p->container_id = i->container_id;
+		p->container_version = i->container_version;
+
+		out_infos[count++] = p;
+		if (p->originator == NULL || p->name == NULL || p->type == NULL) {
+			goto err;
+		}
+	}
+
+	*out_count = count;
+	return CPL_OK;
+
+err:
+	for (size_t j = 0; j < count; j++) {
+		if (out_infos[j]->originator != NULL) free(out_infos[j]->originator);
+		if (out_infos[j]->name != NULL) free(out_infos[j]->name);
+		if (out_infos[j]->type != NULL) free(out_infos[j]->type);
+		free(out_infos[j]);
+		out_infos[j] = NULL;
+	}
+	return CPL_E_INSUFFICIENT_RESOURCES;
+}
+
+
+/**
+ * Get information about the given provenance object
+ *
+ * @param id the object ID
+ * @param version_hint the version of the given provenance object if known,
+ *                     or CPL_VERSION_NONE if not
+ * @param out_info the pointer to store the object info structure
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+cpl_rdf_get_object_info(struct _cpl_db_backend_t* backend,
+						const cpl_id_t id,
+						const cpl_version_t version_hint,
+						cpl_object_info_t** out_info)
+{
+	assert(backend != NULL);
+	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+	cpl_return_t ret;
+
+
+	// Get the version
+
+	cpl_version_t version;
+
+	if (version_hint == CPL_VERSION_NONE) {
+		ret = cpl_rdf_get_version(backend, id, &version);
+		if (!CPL_IS_OK(ret)) return ret;
+	}
+	else {
+		version = version_hint;
+	}
+
+
+	// Prepare the query
+
+	RDFQuery q(rdf->templates.get_object_info);
+	q.node(id, 0).object(id).object(id);
+
+
+	// Execute query
+
+	RDFResultSet rs;
+	ret = cpl_rdf_query(rdf, q.c_str(), &rs);
+
+	if (ret == CPL_S_NO_DATA) return CPL_E_NOT_FOUND;
+	if (!CPL_IS_OK(ret)) {
+		//rs.print_error_messages(std::cerr);
+		return ret;
+	}
+
+
+	// Process the result
+
+	if (out_info == NULL) return CPL_OK;
+	if (rs.size() == 0) return CPL_E_BACKEND_INTERNAL_ERROR;
+	//if (rs.size() >  1) return CPL_E_BACKEND_INTERNAL_ERROR;
+
+	cpl_object_info_t* p = (cpl_object_info_t*) malloc(sizeof(*p));
+	if (p == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
+	memset(p, 0, sizeof(*p));
+	p->id = id;
+	p->version = version;
+
+	RDFValue* v;
+	int r;
+
+	ret = rs[0].get_s("session", RDF_XSD_URI, &v);
+	if (!CPL_IS_OK(ret)) goto err;
+	r = sscanf(v->v_uri, "session:%llx-%llx",
+			&p->creation_session.hi, &p->creation_session.lo);
+	if (r != 2) { ret = CPL_E_BACKEND_INTERNAL_ERROR; goto err; }
+
+	ret = rs[0].get_s("time", RDF_XSD_INTEGER, &v);
+	if (!CPL_IS_OK(ret)) goto err;
+	p->creation_time = v->v_integer;
+
+	ret = rs[0].get_s("orig", RDF_XSD_STRING, &v);
+	if (!CPL_IS_OK(ret)) goto err;
+	p->originator = strdup(v->v_string);
+
+	ret = rs[0].get_s("name", RDF_XSD_STRING, &v);
+	if (!CPL_IS_OK(ret)) goto err;
+	p->name = strdup(v->v_string);
 
-	if (out_id != NULL) {
-		if (rs.size() == 0) return CPL_E_BACKEND_INTERNAL_ERROR;
-		//if (rs.size() >  1) return CPL_E_BACKEND_INTERNAL_ERROR;
+	ret = rs[0].get_s("type", RDF_XSD_STRING, &v);
+	if (!CPL_IS_OK(ret)) goto err;
+	p->type = strdup(v->v_string);
 
-		RDFValue* v;
-		ret = rs[0].get_s("obj", RDF_XSD_URI, &v);
-		if (!CPL_IS_OK(ret)) return ret;
-		int r = sscanf(v->v_uri, "object:%llx-%llx", &out_id->hi, &out_id->lo);
-		if (r != 2) return CPL_E_BACKEND_INTERNAL_ERROR;
+	ret = rs[0].get_s("container", RDF_XSD_URI, &v);
+	if (ret == CPL_E_DB_KEY_NOT_FOUND) {
+		p->container_id = CPL_NONE;
+		p->container_version = CPL_VERSION_NONE;
 	}
-	
+	else if (CPL_IS_OK(ret)) {
+		r = sscanf(v->v_uri, "node:%llx-%llx-%x",
+				&p->container_id.hi,&p->container_id.lo,&p->container_version);
+		if (r != 3) { ret = CPL_E_BACKEND_INTERNAL_ERROR; goto err; }
+	}
+	else goto err;
+
+	*out_info = p;
 	return CPL_OK;
+
+err:
+	if (p->originator != NULL) free(p->originator);
+	if (p->name != NULL) free(p->name);
+	if (p->type != NULL) free(p->type);
+	free(p);
+
+	return ret;
 }
 
 
 /**
- * Look up an object by name. If multiple objects share the same name,
- * return all of them.
+ * Get information about the specific version of a provenance object
  *
- * @param backend the pointer to the backend structure
- * @param originator the object originator
- * @param name the object name
- * @param type the object type
- * @param flags a logical combination of CPL_L_* flags
- * @param iterator the iterator to be called for each matching object
- * @param context the caller-provided iterator context
+ * @param id the object ID
+ * @param version the version of the given provenance object
+ * @param out_info the pointer to store the version info structure
  * @return CPL_OK or an error code
  */
 cpl_return_t
-cpl_rdf_lookup_object_ext(struct _cpl_db_backend_t* backend,
-						  const char* originator,
-						  const char* name,
-						  const char* type,
-						  const int flags,
-						  cpl_id_timestamp_iterator_t iterator,
-						  void* context)
+cpl_rdf_get_version_info(struct _cpl_db_backend_t* backend,
+						 const cpl_id_t id,
+						 const cpl_version_t version,
+						 cpl_version_info_t** out_info)
 {
 	assert(backend != NULL);
 	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+	cpl_return_t ret;
+
+
+	// Prepare the query
 
-	std::ostringstream ss;
+	RDFQuery q(rdf->templates.get_version_info);
+	q.node(id, version);
 
-	ss << "PREFIX o: <object:>\n";
-	ss << "PREFIX p: <prop:>\n";
-	ss << "SELECT ?obj, ?t WHERE { ?obj";
-	ss << " p:originator \"" << cpl_rdf_escape_string(originator) << "\";";
-	ss << " p:name \"" << cpl_rdf_escape_string(name) << "\";";
-	ss << " p:type \"" << cpl_rdf_escape_string(type) << "\";";
-	ss << " p:creation_time ?t . }";
+
+	// Execute query
 
 	RDFResultSet rs;
-	cpl_return_t ret = cpl_rdf_connection_execute_query(rdf->connection_query,
-			ss.str().c_str(), &rs);
+	ret = cpl_rdf_query(rdf, q.c_str(), &rs);
 
 	if (ret == CPL_S_NO_DATA) return CPL_E_NOT_FOUND;
-	if (!CPL_IS_OK(ret)) return ret;
+	if (!CPL_IS_OK(ret)) {
+		//rs.print_error_messages(std::cerr);
+		return ret;
+	}
+
+
+	// Process the result
+
+	if (out_info == NULL) return CPL_OK;
 	if (rs.size() == 0) return CPL_E_BACKEND_INTERNAL_ERROR;
+	//if (rs.size() >  1) return CPL_E_BACKEND_INTERNAL_ERROR;
 
-	cpl_id_t id;
-	unsigned long t;
+	cpl_version_info_t* p = (cpl_version_info_t*) malloc(sizeof(*p));
+	if (p == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
+	memset(p, 0, sizeof(*p));
+	p->id = id;
+	p->version = version;
 
-	for (unsigned u = 0; u < rs.size(); u++) {
+	RDFValue* v;
+	int r;
 
-		RDFValue* v;
-		ret = rs[u].get_s("obj", RDF_XSD_URI, &v);
-		if (!CPL_IS_OK(ret)) return ret;
-		int r = sscanf(v->v_uri, "object:%llx-%llx", &id.hi, &id.lo);
-		if (r != 2) return CPL_E_BACKEND_INTERNAL_ERROR;
+	ret = rs[0].get_s("session", RDF_XSD_URI, &v);
+	if (!CPL_IS_OK(ret)) goto err;
+	r = sscanf(v->v_uri, "session:%llx-%llx", &p->session.hi, &p->session.lo);
+	if (r != 2) { ret = CPL_E_BACKEND_INTERNAL_ERROR; goto err; }
 
-		ret = rs[u].get_s("t", RDF_XSD_INTEGER, &v);
-		if (!CPL_IS_OK(ret)) return ret;
-		t = v->v_integer;
+	ret = rs[0].get_s("time", RDF_XSD_INTEGER, &v);
+	if (!CPL_IS_OK(ret)) goto err;
+	p->creation_time = v->v_integer;
 
-		ret = iterator(id, t, context);
-		if (!CPL_IS_OK(ret)) return ret;
-	}
-	
+	*out_info = p;
 	return CPL_OK;
+
+err:
+	free(p);
+	return ret;
 }
 
 
 /**
- * Create a new version of the given object
+ * Run a paged query for version nodes and call the iterator for each of them
  *
- * @param backend the pointer to the backend structure
- * @param object_id the object ID
- * @param version the new version of the object
- * @param session the session ID responsible for this provenance record
- * @return CPL_OK or an error code
+ * @param rdf the backend
+ * @param query the query, which must be ordered
+ * @param session the session ID if known (and not returned by the query),
+ *                or CPL_NONE
+ * @param iterator the iterator to be called for each matching version
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
  */
-extern "C" cpl_return_t
-cpl_rdf_create_version(struct _cpl_db_backend_t* backend,
-					   const cpl_id_t object_id,
-					   const cpl_version_t version,
-					   const cpl_session_t session)
+static cpl_return_t
+cpl_rdf_iterate_versions(cpl_rdf_t* rdf,
+						 const std::string& query,
+						 const cpl_session_t session,
+						 cpl_version_info_iterator_t iterator,
+						 void* context)
 {
-	assert(backend != NULL);
-	assert(version > 0);
-	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
-
-	char session_str[64];
-	sprintf(session_str, "s:%llx-%llx", session.hi, session.lo);
-
-	char id_str[64];
-	sprintf(id_str, "o:%llx-%llx", object_id.hi, object_id.lo);
-
-	char node_str[64];
-	sprintf(node_str, "n:%llx-%llx-%x", object_id.hi, object_id.lo, version);
-
-	std::ostringstream ss_check;
-	std::ostringstream ss_create;
-
-	ss_check << "PREFIX n: <node:>\n";
-	ss_check << "PREFIX p: <prop:>\n";
-	ss_check << "SELECT ?v WHERE { " << node_str << " p:version ?v }";
+	cpl_return_t ret;
+	_cpl_rdf_version_info_context_t ctx;
+	ctx.session = session;
+	size_t num_rows = 0;
+	bool found = false;
 
-	ss_create << "PREFIX s: <session:>\n";
-	ss_create << "PREFIX o: <object:>\n";
-	ss_create << "PREFIX n: <node:>\n";
-	ss_create << "PREFIX p: <prop:>\n";
-	ss_create << "PREFIX r: <rel:>\n";
-	ss_create << "INSERT DATA { ";
-	ss_create << " " << id_str << " r:version " << node_str << " .";
-	ss_create << " " << node_str << " r:session " << session_str << ";";
-	ss_create << " p:version " << version << ";";
-	ss_create << " p:creation_time " << time(NULL) << ";";
-	ss_create << "}";
+	for (size_t page = 0; ; page++) {
 
-	cpl_shared_semaphore_wait(rdf->sem_create_version);
+		ctx.versions.clear();
+		ret = cpl_rdf_query_page(rdf, query, page,
+				cpl_rdf_row_version_info, &ctx, &num_rows);
 
-	RDFResultSet rs;
-	cpl_return_t ret = cpl_rdf_connection_execute_query(rdf->connection_query,
-			ss_check.str().c_str(), &rs);
+		if (ret == CPL_S_NO_DATA) break;
+		if (!CPL_IS_OK(ret)) return ret;
+		if (!ctx.versions.empty()) found = true;
 
-	if (!CPL_IS_OK(ret)) {
-		cpl_shared_semaphore_post(rdf->sem_create_version);
-		return ret;
-	}
-	if (ret != CPL_S_NO_DATA || rs.size() != 0) {
-		cpl_shared_semaphore_post(rdf->sem_create_version);
-		return CPL_E_ALREADY_EXISTS;
-	}
+		std::list<cpl_version_info_t>::iterator i;
+		for (i = ctx.versions.begin(); i != ctx.versions.end(); i++) {
+			ret = iterator(&(*i), context);
+			if (!CPL_IS_OK(ret)) return ret;
+		}
 
-	ret = cpl_rdf_connection_execute_update(rdf->connection_update,
-			ss_create.str().c_str());
-	if (!CPL_IS_OK(ret)) {
-		cpl_shared_semaphore_post(rdf->sem_create_version);
-		return ret;
+		if (num_rows < CPL_RDF_PAGE_SIZE) break;
 	}
 
-	cpl_shared_semaphore_post(rdf->sem_create_version);
-	return CPL_OK;
+	return found ? CPL_OK : CPL_S_NO_DATA;
 }
 
 
 /**
- * Determine the version of the object
+ * Iterate over all version nodes created within the given time range,
+ * ordered by their creation time
  *
  * @param backend the pointer to the backend structure
- * @param id the object ID
- * @param out_version the pointer to store the version of the object
- * @return CPL_OK or an error code
+ * @param start_time the start of the time range (inclusive)
+ * @param end_time the end of the time range (inclusive)
+ * @param iterator the iterator to be called for each matching version
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
  */
-extern "C" cpl_return_t
-cpl_rdf_get_version(struct _cpl_db_backend_t* backend,
-					const cpl_id_t id,
-					cpl_version_t* out_version)
+cpl_return_t
+cpl_rdf_get_versions_in_range(struct _cpl_db_backend_t* backend,
+							  const unsigned long start_time,
+							  const unsigned long end_time,
+							  cpl_version_info_iterator_t iterator,
+							  void* context)
 {
 	assert(backend != NULL);
 	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
 
-	char id_str[64];
-	sprintf(id_str, "o:%llx-%llx", id.hi, id.lo);
-
-	std::ostringstream ss;
-
-	ss << "PREFIX o: <object:>\n";
-	ss << "PREFIX p: <prop:>\n";
-	ss << "PREFIX r: <rel:>\n";
-	ss << "SELECT ?v WHERE { ";
-	ss << " " << id_str << " r:version ?node . ?node p:version ?v .";
-	ss << " OPTIONAL {";
-	ss << "  " << id_str <<" r:version ?o_node . ?o_node p:version ?o_v .";
-	ss << "  FILTER ( ?o_v > ?v ) . } . FILTER ( !bound(?o_v) ) . }";
-
-	RDFResultSet rs;
-	cpl_return_t ret = cpl_rdf_connection_execute_query(rdf->connection_query,
-			ss.str().c_str(), &rs);
-
-	if (ret == CPL_S_NO_DATA) return CPL_E_NOT_FOUND;
-	if (!CPL_IS_OK(ret)) return ret;
-
-	if (out_version != NULL) {
-		if (rs.size() == 0) return CPL_E_BACKEND_INTERNAL_ERROR;
-		//if (rs.size() >  1) return CPL_E_BACKEND_INTERNAL_ERROR;
+	RDFQuery q(rdf->templates.get_versions_in_range);
+	q.integer(start_time).integer(end_time);
 
-		RDFValue* v;
-		ret = rs[0].get_s("v", RDF_XSD_INTEGER, &v);
-		if (!CPL_IS_OK(ret)) return ret;
-		*out_version = (cpl_version_t) v->v_integer;
-	}
-	
-	return CPL_OK;
+	return cpl_rdf_iterate_versions(rdf, q.c_str(), CPL_NONE,
+									iterator, context);
 }
 
 
 /**
- * Add an ancestry edge
+ * Iterate over all version nodes created by the given session, ordered by
+ * their creation time
  *
  * @param backend the pointer to the backend structure
- * @param from_id the edge source ID
- * @param from_ver the edge source version
- * @param to_id the edge destination ID
- * @param to_ver the edge destination version
- * @param type the data or control dependency type
- * @return the object version or an error code
+ * @param session the session ID
+ * @param iterator the iterator to be called for each matching version
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
  */
-extern "C" cpl_return_t
-cpl_rdf_add_ancestry_edge(struct _cpl_db_backend_t* backend,
-						  const cpl_id_t from_id,
-						  const cpl_version_t from_ver,
-						  const cpl_id_t to_id,
-						  const cpl_version_t to_ver,
-						  const int type)
+cpl_return_t
+cpl_rdf_get_session_activity(struct _cpl_db_backend_t* backend,
+							 const cpl_session_t session,
+							 cpl_version_info_iterator_t iterator,
+							 void* context)
 {
 	assert(backend != NULL);
 	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
 
-	char node_from_str[64];
-	sprintf(node_from_str, "n:%llx-%llx-%x", from_id.hi, from_id.lo, from_ver);
-
-	char node_to_str[64];
-	sprintf(node_to_str, "n:%llx-%llx-%x", to_id.hi, to_id.lo, to_ver);
-
-	char edge[32];
-	sprintf(edge, "i:%x", type);
-
-	std::ostringstream ss;
-
-	ss << "PREFIX n: <node:>\n";
-	ss << "PREFIX i: <input:>\n";
-	ss << "INSERT DATA {";
-	ss << " " << node_from_str << " " << edge << " " << node_to_str << " }";
+	RDFQuery q(rdf->templates.get_session_activity);
+	q.session(session);
 
-	cpl_return_t ret = cpl_rdf_connection_execute_update(rdf->connection_update,
-			ss.str().c_str());
-	
-	return ret;
+	return cpl_rdf_iterate_versions(rdf, q.c_str(), session,
+									iterator, context);
 }
 
 
 /**
- * Determine whether the given object has the given ancestor
+ * Iterate over the ancestors or the descendants of a provenance object.
  *
  * @param backend the pointer to the backend structure
- * @param object_id the object ID
- * @param version_hint the object version (if known), or CPL_VERSION_NONE
- *                     otherwise
- * @param query_object_id the object that we want to determine whether it
- *                        is one of the immediate ancestors
- * @param query_object_max_version the maximum version of the query
- *                                 object to consider
- * @param out the pointer to store a positive number if yes, or 0 if no
- * @return CPL_OK or an error code
+ * @param id the object ID
+ * @param version the object version, or CPL_VERSION_NONE to access all
+ *                version nodes associated with the given object
+ * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+ *                  or CPL_D_DESCENDANTS)
+ * @param flags the bitwise combination of flags describing how should
+ *              the graph be traversed (a logical combination of the
+ *              CPL_A_* flags)
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
  */
-extern "C" cpl_return_t
-cpl_rdf_has_immediate_ancestor(struct _cpl_db_backend_t* backend,
-							   const cpl_id_t object_id,
-							   const cpl_version_t version_hint,
-							   const cpl_id_t query_object_id,
-							   const cpl_version_t query_object_max_version,
-							   int* out)
+cpl_return_t
+cpl_rdf_get_object_ancestry(struct _cpl_db_backend_t* backend,
+							const cpl_id_t id,
+							const cpl_version_t version,
+							const int direction,
+							const int flags,
+							cpl_ancestry_iterator_t iterator,
+							void* context)
 {
 	assert(backend != NULL);
 	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+	cpl_return_t ret;
 
-	char q_id_str[64];
-	sprintf(q_id_str, "o:%llx-%llx", query_object_id.hi, query_object_id.lo);
 
-	std::ostringstream ss;
+	// Prepare the query
+
+	const cpl_rdf_templates_t& t = rdf->templates;
+	RDFQuery q(direction == CPL_D_ANCESTORS
+			? (version == CPL_VERSION_NONE ? t.get_ancestors
+										   : t.get_ancestors_node)
+			: (version == CPL_VERSION_NONE ? t.get_descendants
+										   : t.get_descendants_node));
+
+	if (version == CPL_VERSION_NONE) {
+		q.object(id);
+	}
+	else {
+		q.node(id, version);
+	}
+
+
+	// Execute query, decoding the edges as they arrive
+
+	_cpl_rdf_ancestry_context_t ctx;
+	ctx.version = version;
+	ctx.flags = flags;
+
+	ret = cpl_rdf_query_stream(rdf, q.c_str(),
+			cpl_rdf_row_ancestry_edge, &ctx);
+
+	if (ret == CPL_S_NO_DATA) {
+		// We do not need to check here whether the object exists, because
+		// the query would at least return the session object in one case
+		// or the actual object in the other case if the given object
+		// exits (we do not fully filter the results in the query itself).
+		return CPL_E_NOT_FOUND;
+	}
+	if (!CPL_IS_OK(ret)) return ret;
 
-	char id_str[64];
-	sprintf(id_str, "o:%llx-%llx", object_id.hi, object_id.lo);
 
-	char node_str[64];
-	if (version_hint != CPL_VERSION_NONE) {
-		sprintf(node_str, "n:%llx-%llx-%x",
-				object_id.hi, object_id.lo, version_hint);
+	// Call the callback function (if available)
+
+	if (ctx.edges.empty()) return CPL_S_NO_DATA;
+	if (iterator == NULL) return CPL_OK;
+
+	std::list<_cpl_rdf_ancestry_edge_t>::iterator i;
+	for (i = ctx.edges.begin(); i != ctx.edges.end(); i++) {
+		ret = iterator(id, i->query_version, i->other_id, i->other_version,
+					   i->type, context);
+		if (!CPL_IS_OK(ret)) return ret;
 	}
 
-	ss << "PREFIX o: <object:>\n";
-	ss << "PREFIX p: <prop:>\n";
-	ss << "PREFIX r: <rel:>\n";
-	if (version_hint != CPL_VERSION_NONE) {
-		ss << "PREFIX n: <node:>\n";
+	return CPL_OK;
+}
+
+
+/**
+ * Create a SPARQL filter expression that accepts the ancestry edges allowed
+ * by the given CPL_A_* flags
+ *
+ * @param var the name of the edge variable
+ * @param flags the CPL_A_* flags
+ * @return the filter expression
+ */
+static std::string
+cpl_rdf_ancestry_edge_filter(const char* var, const int flags)
+{
+	std::string categories;
+
+	if ((flags & CPL_A_NO_DATA_DEPENDENCIES) == 0) {
+		cpl_rdf_append_hex(categories, CPL_DEPENDENCY_CATEGORY_DATA);
 	}
-	ss << "SELECT ?v WHERE { ";
-	if (version_hint != CPL_VERSION_NONE) {
-		ss << " " << node_str << " ?edge ?q_node .";
+	if ((flags & CPL_A_NO_CONTROL_DEPENDENCIES) == 0) {
+		cpl_rdf_append_hex(categories, CPL_DEPENDENCY_CATEGORY_CONTROL);
 	}
-	else {
-		ss << " " << id_str << " r:version ?node .";
-		ss << " ?node ?edge ?q_node .";
+	if ((flags & CPL_A_NO_PREV_NEXT_VERSION) == 0) {
+		cpl_rdf_append_hex(categories, CPL_DEPENDENCY_CATEGORY_VERSION);
 	}
-	ss << " " << q_id_str << " r:version ?q_node . ?q_node p:version ?q_v .";
-	ss << " FILTER ( ?q_v <= " << query_object_max_version << " ) }";
 
-	RDFResultSet rs;
-	cpl_return_t ret = cpl_rdf_connection_execute_query(rdf->connection_query,
-			ss.str().c_str(), &rs);
+	if (categories.empty()) return "false";
 
-	if (!CPL_IS_OK(ret)) {
-		//rs.print_error_messages(std::cerr);
-		return ret;
-	}
-	if (out != NULL) *out = (ret == CPL_S_NO_DATA) ? 0 : 1;
-	return CPL_OK;
+	std::string r = "regex(str(?";
+	r += var;
+	r += "), \"^input:[";
+	r += categories;
+	r += "][0-9a-f][0-9a-f]$\")";
+	return r;
 }
 
 
 /**
- * Add a property to the given object
+ * Get the query template for the multi-hop ancestry query of the given
+ * shape, compiling it on the first use. The query is a union of one path
+ * pattern per hop count; each pattern binds ?from to the last intermediate
+ * node (left unbound for the first hop) and ?edge and ?to to the final
+ * edge. Its only parameter is the start object (%o) if the version is
+ * CPL_VERSION_NONE, or the start version node (%n) otherwise.
  *
- * @param backend the pointer to the backend structure
- * @param id the object ID
- * @param version the version number
- * @param key the key
- * @param value the value
- * @return CPL_OK or an error code
+ * @param rdf the RDF backend
+ * @param version the object version, or CPL_VERSION_NONE
+ * @param direction the direction of the graph traversal
+ * @param flags the CPL_A_* flags
+ * @param max_hops the maximum number of hops (1 to CPL_RDF_MAX_HOPS)
+ * @return the template, or NULL if it could not be compiled
  */
-extern "C" cpl_return_t
-cpl_rdf_add_property(struct _cpl_db_backend_t* backend,
-                     const cpl_id_t id,
-                     const cpl_version_t version,
-                     const char* key,
-                     const char* value)
+static const RDFQueryTemplate*
+cpl_rdf_hop_template(cpl_rdf_t* rdf, const cpl_version_t version,
+					 const int direction, const int flags, const int max_hops)
 {
-    assert(backend != NULL);
-    cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+	const int edge_flags = CPL_A_NO_DATA_DEPENDENCIES
+		| CPL_A_NO_CONTROL_DEPENDENCIES | CPL_A_NO_PREV_NEXT_VERSION;
+	int shape = (max_hops << 8) | ((flags & edge_flags) << 2)
+		| (direction == CPL_D_ANCESTORS ? 2 : 0)
+		| (version == CPL_VERSION_NONE ? 1 : 0);
+
+	const RDFQueryTemplate* r = NULL;
+	pthread_mutex_lock(&rdf->hop_templates_lock);
+
+	std::map<int, RDFQueryTemplate>::iterator i
+		= rdf->hop_templates.find(shape);
+	if (i != rdf->hop_templates.end()) {
+		r = &i->second;
+		pthread_mutex_unlock(&rdf->hop_templates_lock);
+		return r;
+	}
 
-	char node_str[64];
-	sprintf(node_str, "n:%llx-%llx-%x", id.hi, id.lo, version);
 
-	std::ostringstream ss;
+	// Build the query text
+
+	std::string text = "SELECT DISTINCT";
+	if (version == CPL_VERSION_NONE) text += " ?node";
+	text += " ?from ?edge ?to WHERE {";
+	text += version == CPL_VERSION_NONE
+		? " %o r:version ?node ." : " VALUES ?node { %n }";
+
+	for (int hops = 1; hops <= max_hops; hops++) {
+		if (hops > 1) text += " UNION";
+		text += " {";
+
+		std::string prev = "?node";
+		for (int h = 1; h <= hops; h++) {
+
+			std::string e, n;
+			if (h < hops) {
+				e = "e";
+				cpl_rdf_append_hex(e, h);
+				if (h == hops - 1) {
+					n = "?from";
+				}
+				else {
+					n = "?x";
+					cpl_rdf_append_hex(n, h);
+				}
+			}
+			else {
+				e = "edge";
+				n = "?to";
+			}
+
+			const std::string& s = direction == CPL_D_ANCESTORS ? prev : n;
+			const std::string& o = direction == CPL_D_ANCESTORS ? n : prev;
+			text += " " + s + " ?" + e + " " + o + " .";
+			text += " FILTER ( " + cpl_rdf_ancestry_edge_filter(e.c_str(),
+					flags) + " ) .";
+
+			prev = n;
+		}
 
-	ss << "PREFIX n: <node:>\n";
-	ss << "PREFIX c: <custom:>\n";
-	ss << "INSERT DATA {";
-	ss << " " << node_str;
-    ss << " c:" << cpl_rdf_hex_string(key);
-    ss << " \"" << cpl_rdf_escape_string(value) << "\" }";
+		text += " }";
+	}
 
-	cpl_return_t ret = cpl_rdf_connection_execute_update(rdf->connection_update,
-			ss.str().c_str());
-	
-	return ret;
+	text += " FILTER ( isURI(?to) ) } ORDER BY";
+	if (version == CPL_VERSION_NONE) text += " ?node";
+	text += " ?from ?edge ?to";
+
+
+	// Compile it. Map entries are never removed, so the pointer stays valid
+	// after the lock is released.
+
+	RDFQueryTemplate& t = rdf->hop_templates[shape];
+	if (CPL_IS_OK(t.compile(CPL_RDF_PREFIXES, text.c_str()))) {
+		r = &t;
+	}
+	else {
+		rdf->hop_templates.erase(shape);
+	}
+
+	pthread_mutex_unlock(&rdf->hop_templates_lock);
+	return r;
 }
 
 
 /**
- * Get information about the given provenance session.
+ * Iterate over all ancestry edges that are at most the given number of hops
+ * away from a provenance object, fetching all hops in a single request.
  *
- * @param id the session ID
- * @param out_info the pointer to store the session info structure
- * @return CPL_OK or an error code
+ * @param backend the RDF backend
+ * @param id the object ID
+ * @param version the object version, or CPL_VERSION_NONE to start from all
+ *                version nodes associated with the given object
+ * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+ *                  or CPL_D_DESCENDANTS)
+ * @param flags the bitwise combination of flags describing how should
+ *              the graph be traversed (a logical combination of the
+ *              CPL_A_* flags)
+ * @param max_hops the maximum number of hops (1 to CPL_RDF_MAX_HOPS)
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
  */
-cpl_return_t
-cpl_rdf_get_session_info(struct _cpl_db_backend_t* backend,
-						 const cpl_session_t id,
-						 cpl_session_info_t** out_info)
+extern "C" cpl_return_t
+cpl_rdf_get_object_ancestry_hops(cpl_db_backend_t* backend,
+								 const cpl_id_t id,
+								 const cpl_version_t version,
+								 const int direction,
+								 const int flags,
+								 const int max_hops,
+								 cpl_ancestry_iterator_t iterator,
+								 void* context)
 {
 	assert(backend != NULL);
 	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
 	cpl_return_t ret;
 
-
-	// Prepare the query
-
-	char id_str[64];
-	sprintf(id_str, "s:%llx-%llx", id.hi, id.lo);
-
-	std::ostringstream ss;
-
-	ss << "PREFIX s: <session:>\n";
-	ss << "PREFIX p: <prop:>\n";
-	ss << "SELECT ?mac_address, ?username, ?pid, ?program, ";
-	ss << "?initialization_time, ?cmdline WHERE { " << id_str;
-	ss << " p:mac_address ?mac_address ;";
-	ss << " p:username ?username ;";
-	ss << " p:pid ?pid ;";
-	ss << " p:program ?program ;";
-	ss << " p:cmdline ?cmdline ;";
-	ss << " p:initialization_time ?initialization_time .";
-	ss << "}";
+	if (max_hops < 1 || max_hops > CPL_RDF_MAX_HOPS) {
+		return CPL_E_INVALID_ARGUMENT;
+	}
+	if (direction != CPL_D_ANCESTORS && direction != CPL_D_DESCENDANTS) {
+		return CPL_E_INVALID_ARGUMENT;
+	}
 
 
-	// Execute query
+	// Get the query template for this shape of the query and instantiate it
 
-	RDFResultSet rs;
-	ret = cpl_rdf_connection_execute_query(rdf->connection_query,
-			ss.str().c_str(), &rs);
+	const RDFQueryTemplate* t = cpl_rdf_hop_template(rdf, version, direction,
+			flags, max_hops);
+	if (t == NULL) return CPL_E_INTERNAL_ERROR;
 
-	if (ret == CPL_S_NO_DATA) return CPL_E_NOT_FOUND;
-	if (!CPL_IS_OK(ret)) {
-		//rs.print_error_messages(std::cerr);
-		return ret;
+	RDFQuery q(*t);
+	if (version == CPL_VERSION_NONE) {
+		q.object(id);
 	}
+	else {
+		q.node(id, version);
+	}
+	std::string query = q.str();
 
 
-	// Process the result
-
-	if (out_info == NULL) return CPL_OK;
-	if (rs.size() == 0) return CPL_E_BACKEND_INTERNAL_ERROR;
-	if (rs.size() >  1) return CPL_E_BACKEND_INTERNAL_ERROR;
+	// Fetch the edges one page at a time
 
-	cpl_session_info_t* p = (cpl_session_info_t*) malloc(sizeof(*p));
-	if (p == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
-	memset(p, 0, sizeof(*p));
-	p->id = id;
+	_cpl_rdf_ancestry_hop_context_t ctx;
+	ctx.id = id;
+	ctx.version = version;
 
-	RDFValue* v;
+	bool found = false;
+	size_t num_rows = 0;
 
-	ret = rs[0].get_s("mac_address", RDF_XSD_STRING, &v);
-	if (!CPL_IS_OK(ret)) goto err;
-	p->mac_address = strdup(v->v_string);
+	for (size_t page = 0; ; page++) {
 
-	ret = rs[0].get_s("username", RDF_XSD_STRING, &v);
-	if (!CPL_IS_OK(ret)) goto err;
-	p->user = strdup(v->v_string);
+		ctx.edges.clear();
+		ret = cpl_rdf_query_page(rdf, query, page,
+				cpl_rdf_row_ancestry_hop, &ctx, &num_rows);
 
-	ret = rs[0].get_s("pid", RDF_XSD_INTEGER, &v);
-	if (!CPL_IS_OK(ret)) goto err;
-	p->pid = v->v_integer;
+		if (ret == CPL_S_NO_DATA) break;
+		if (!CPL_IS_OK(ret)) return ret;
+		if (!ctx.edges.empty()) found = true;
 
-	ret = rs[0].get_s("program", RDF_XSD_STRING, &v);
-	if (!CPL_IS_OK(ret)) goto err;
-	p->program = strdup(v->v_string);
+		if (iterator != NULL) {
+			std::list<_cpl_rdf_ancestry_hop_t>::iterator i;
+			for (i = ctx.edges.begin(); i != ctx.edges.end(); i++) {
+				ret = iterator(i->from_id, i->from_version, i->to_id,
+							   i->to_version, i->type, context);
+				if (!CPL_IS_OK(ret)) return ret;
+			}
+		}
 
-	ret = rs[0].get_s("cmdline", RDF_XSD_STRING, &v);
-	if (!CPL_IS_OK(ret)) goto err;
-	p->cmdline = strdup(v->v_string);
+		if (num_rows < CPL_RDF_PAGE_SIZE) break;
+	}
 
-	ret = rs[0].get_s("initialization_time", RDF_XSD_INTEGER, &v);
-	if (!CPL_IS_OK(ret)) goto err;
-	p->start_time = v->v_integer;
 
-	*out_info = p;
-	return CPL_OK;
+	// If we did not get any data back, check for whether the object exists
 
-err:
-	if (p->mac_address != NULL) free(p->mac_address);
-	if (p->user != NULL) free(p->user);
-	if (p->program != NULL) free(p->program);
-	if (p->cmdline != NULL) free(p->cmdline);
-	free(p);
+	if (!found) {
+		if (version == CPL_VERSION_NONE) {
+			ret = cpl_rdf_get_version(backend, id, NULL);
+		}
+		else {
+			ret = cpl_rdf_get_version_info(backend, id, version, NULL);
+		}
+		if (!CPL_IS_SUCCESS(ret)) return ret;
+	}
 
-	return ret;
+	return found ? CPL_OK : CPL_S_NO_DATA;
 }
 
 
 /**
- * Get all objects in the database
+ * Iterate over the immediate ancestors or descendants of several version
+ * nodes at once, fetching up to CPL_RDF_BATCH_SIZE nodes per request.
  *
  * @param backend the pointer to the backend structure
- * @param flags a logical combination of CPL_I_* flags
- * @param iterator the iterator to be called for each matching object
- * @param context the caller-provided iterator context
- * @return CPL_OK or an error code
- */
-cpl_return_t
-cpl_rdf_get_all_objects(struct _cpl_db_backend_t* backend,
-						 const int flags,
-						 cpl_object_info_iterator_t iterator,
-						 void* context)
-{
-	return CPL_E_NOT_IMPLEMENTED;
-}
-
-
-/**
- * Get information about the given provenance object
- *
- * @param id the object ID
- * @param version_hint the version of the given provenance object if known,
- *                     or CPL_VERSION_NONE if not
- * @param out_info the pointer to store the object info structure
- * @return CPL_OK or an error code
+ * @param nodes the array of version nodes (the versions must not be
+ *              CPL_VERSION_NONE)
+ * @param count the number of nodes in the array
+ * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+ *                  or CPL_D_DESCENDANTS)
+ * @param flags the bitwise combination of flags describing how should
+ *              the graph be traversed (a logical combination of the
+ *              CPL_A_* flags)
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
  */
 cpl_return_t
-cpl_rdf_get_object_info(struct _cpl_db_backend_t* backend,
-						const cpl_id_t id,
-						const cpl_version_t version_hint,
-						cpl_object_info_t** out_info)
+cpl_rdf_get_object_ancestry_batch(struct _cpl_db_backend_t* backend,
+								  const cpl_id_version_t* nodes,
+								  const size_t count,
+								  const int direction,
+								  const int flags,
+								  cpl_ancestry_iterator_t iterator,
+								  void* context)
 {
 	assert(backend != NULL);
 	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
 	cpl_return_t ret;
+	bool found = false;
 
-
-	// Get the version
-
-	cpl_version_t version;
-
-	if (version_hint == CPL_VERSION_NONE) {
-		ret = cpl_rdf_get_version(backend, id, &version);
-		if (!CPL_IS_OK(ret)) return ret;
-	}
-	else {
-		version = version_hint;
+	if (direction != CPL_D_ANCESTORS && direction != CPL_D_DESCENDANTS) {
+		return CPL_E_INVALID_ARGUMENT;
 	}
 
+	std::string filter = cpl_rdf_ancestry_edge_filter("edge",
+			flags | CPL_A_NO_PREV_NEXT_VERSION);
 
-	// Prepare the query
+	for (size_t start = 0; start < count; start += CPL_RDF_BATCH_SIZE) {
+		size_t end = start + CPL_RDF_BATCH_SIZE;
+		if (end > count) end = count;
 
-	char id_str[64];
-	sprintf(id_str, "o:%llx-%llx", id.hi, id.lo);
 
-	char node_str[64];
-	sprintf(node_str, "n:%llx-%llx-0", id.hi, id.lo);
+		// Prepare the query, listing the query nodes in a VALUES block
 
-	std::ostringstream ss;
+		std::string q = CPL_RDF_PREFIXES;
+		q += "SELECT ?node ?edge ?other WHERE { VALUES ?node {";
 
-	ss << "PREFIX o: <object:>\n";
-	ss << "PREFIX p: <prop:>\n";
-	ss << "PREFIX r: <rel:>\n";
-	ss << "PREFIX n: <node:>\n";
-	ss << "SELECT ?session, ?time, ?orig, ?name, ?type, ?container WHERE {";
-	ss << " " << node_str << " r:session ?session .";
-	ss << " " << id_str << " p:creation_time ?time ;";
-	ss << " p:originator ?orig ;";
-	ss << " p:name ?name ;";
-	ss << " p:type ?type .";
-	ss << " OPTIONAL {";
-	ss << "  " << id_str << " r:container ?container .";
-	ss << " } ";
-	ss << "}";
+		for (size_t i = start; i < end; i++) {
+			if (nodes[i].version == CPL_VERSION_NONE) {
+				return CPL_E_INVALID_ARGUMENT;
+			}
+			q += " n:";
+			cpl_rdf_append_hex(q, nodes[i].id.hi);
+			q += "-";
+			cpl_rdf_append_hex(q, nodes[i].id.lo);
+			q += "-";
+			cpl_rdf_append_hex(q, (unsigned) nodes[i].version);
+		}
 
+		q += " } ";
+		q += direction == CPL_D_ANCESTORS
+			? "?node ?edge ?other ."
+			: "?other ?edge ?node .";
+		q += " FILTER ( isURI(?other) && ";
+		q += filter;
+		q += " ) }";
 
-	// Execute query
 
-	RDFResultSet rs;
-	ret = cpl_rdf_connection_execute_query(rdf->connection_query,
-			ss.str().c_str(), &rs);
+		// Execute the query, decoding the edges as they arrive
 
-	if (ret == CPL_S_NO_DATA) return CPL_E_NOT_FOUND;
-	if (!CPL_IS_OK(ret)) {
-		//rs.print_error_messages(std::cerr);
-		return ret;
-	}
+		_cpl_rdf_ancestry_context_t ctx;
+		ctx.version = CPL_VERSION_NONE;
+		ctx.flags = flags;
 
+		ret = cpl_rdf_query_stream(rdf, q.c_str(),
+				cpl_rdf_row_ancestry_edge, &ctx);
+		if (ret == CPL_S_NO_DATA) continue;
+		if (!CPL_IS_OK(ret)) return ret;
+		if (!ctx.edges.empty()) found = true;
 
-	// Process the result
 
-	if (out_info == NULL) return CPL_OK;
-	if (rs.size() == 0) return CPL_E_BACKEND_INTERNAL_ERROR;
-	//if (rs.size() >  1) return CPL_E_BACKEND_INTERNAL_ERROR;
+		// Call the callback function (if available)
 
-	cpl_object_info_t* p = (cpl_object_info_t*) malloc(sizeof(*p));
-	if (p == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
-	memset(p, 0, sizeof(*p));
-	p->id = id;
-	p->version = version;
+		if (iterator == NULL) continue;
 
-	RDFValue* v;
-	int r;
+		std::list<_cpl_rdf_ancestry_edge_t>::iterator i;
+		for (i = ctx.edges.begin(); i != ctx.edges.end(); i++) {
+			ret = iterator(i->query_id, i->query_version, i->other_id,
+						   i->other_version, i->type, context);
+			if (!CPL_IS_OK(ret)) return ret;
+		}
+	}
 
-	ret = rs[0].get_s("session", RDF_XSD_URI, &v);
-	if (!CPL_IS_OK(ret)) goto err;
-	r = sscanf(v->v_uri, "session:%llx-%llx",
-			&p->creation_session.hi, &p->creation_session.lo);
-	if (r != 2) { ret = CPL_E_BACKEND_INTERNAL_ERROR; goto err; }
+	return found ? CPL_OK : CPL_S_NO_DATA;
+}
 
-	ret = rs[0].get_s("time", RDF_XSD_INTEGER, &v);
-	if (!CPL_IS_OK(ret)) goto err;
-	p->creation_time = v->v_integer;
 
-	ret = rs[0].get_s("orig", RDF_XSD_STRING, &v);
-	if (!CPL_IS_OK(ret)) goto err;
-	p->originator = strdup(v->v_string);
+/**
+ * Iterate over all transitive ancestors or descendants of a version node
+ * using a precomputed closure of the provenance graph. The RDF store does
+ * not maintain one, so the library falls back to a level-batched traversal.
+ *
+ * @param backend the pointer to the backend structure
+ * @param id the object ID
+ * @param version the object version (must not be CPL_VERSION_NONE)
+ * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+ *                  or CPL_D_DESCENDANTS)
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_E_NOT_IMPLEMENTED
+ */
+cpl_return_t
+cpl_rdf_get_transitive_ancestry(struct _cpl_db_backend_t* backend,
+								const cpl_id_t id,
+								const cpl_version_t version,
+								const int direction,
+								cpl_ancestry_iterator_t iterator,
+								void* context)
+{
+	return CPL_E_NOT_IMPLEMENTED;
+}
 
-	ret = rs[0].get_s("name", RDF_XSD_STRING, &v);
-	if (!CPL_IS_OK(ret)) goto err;
-	p->name = strdup(v->v_string);
 
-	ret = rs[0].get_s("type", RDF_XSD_STRING, &v);
-	if (!CPL_IS_OK(ret)) goto err;
-	p->type = strdup(v->v_string);
+/**
+ * Get information about several provenance objects at once. The library
+ * falls back to cpl_rdf_get_object_info() for each object.
+ *
+ * @param backend the pointer to the backend structure
+ * @param ids the array of unique object IDs
+ * @param count the number of object IDs
+ * @param out_infos the array of count pointers to store the object info
+ *                  structures
+ * @return CPL_E_NOT_IMPLEMENTED
+ */
+cpl_return_t
+cpl_rdf_get_object_info_batch(struct _cpl_db_backend_t* backend,
+							  const cpl_id_t* ids,
+							  const size_t count,
+							  cpl_object_info_t** out_infos)
+{
+	return CPL_E_NOT_IMPLEMENTED;
+}
 
-	ret = rs[0].get_s("container", RDF_XSD_URI, &v);
-	if (ret == CPL_E_DB_KEY_NOT_FOUND) {
-		p->container_id = CPL_NONE;
-		p->container_version = CPL_VERSION_NONE;
-	}
-	else if (CPL_IS_OK(ret)) {
-		r = sscanf(v->v_uri, "node:%llx-%llx-%x",
-				&p->container_id.hi,&p->container_id.lo,&p->container_version);
-		if (r != 3) { ret = CPL_E_BACKEND_INTERNAL_ERROR; goto err; }
-	}
-	else goto err;
 
-	*out_info = p;
-	return CPL_OK;
+/**
+ * Get information about several version nodes at once. The library falls
+ * back to cpl_rdf_get_version_info() for each node.
+ *
+ * @param backend the pointer to the backend structure
+ * @param nodes the array of unique version nodes
+ * @param count the number of version nodes
+ * @param out_infos the array of count pointers to store the version info
+ *                  structures
+ * @return CPL_E_NOT_IMPLEMENTED
+ */
+cpl_return_t
+cpl_rdf_get_version_info_batch(struct _cpl_db_backend_t* backend,
+							   const cpl_id_version_t* nodes,
+							   const size_t count,
+							   cpl_version_info_t** out_infos)
+{
+	return CPL_E_NOT_IMPLEMENTED;
+}
 
-err:
-	if (p->originator != NULL) free(p->originator);
-	if (p->name != NULL) free(p->name);
-	if (p->type != NULL) free(p->type);
-	free(p);
 
-	return ret;
+/**
+ * Get information about several provenance sessions at once. The library
+ * falls back to cpl_rdf_get_session_info() for each session.
+ *
+ * @param backend the pointer to the backend structure
+ * @param ids the array of unique session IDs
+ * @param count the number of session IDs
+ * @param out_infos the array of count pointers to store the session info
+ *                  structures
+ * @return CPL_E_NOT_IMPLEMENTED
+ */
+cpl_return_t
+cpl_rdf_get_session_info_batch(struct _cpl_db_backend_t* backend,
+							   const cpl_session_t* ids,
+							   const size_t count,
+							   cpl_session_info_t** out_infos)
+{
+	return CPL_E_NOT_IMPLEMENTED;
 }
 
 
 /**
- * Get information about the specific version of a provenance object
+ * Get the properties associated with the given provenance object.
  *
- * @param id the object ID
- * @param version the version of the given provenance object
- * @param out_info the pointer to store the version info structure
- * @return CPL_OK or an error code
+ * @param backend the pointer to the backend structure
+ * @param id the the object ID
+ * @param version the object version, or CPL_VERSION_NONE to access all
+ *                version nodes associated with the given object
+ * @param key the property to fetch - or NULL for all properties
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
  */
 cpl_return_t
-cpl_rdf_get_version_info(struct _cpl_db_backend_t* backend,
-						 const cpl_id_t id,
-						 const cpl_version_t version,
-						 cpl_version_info_t** out_info)
+cpl_rdf_get_properties(struct _cpl_db_backend_t* backend,
+					   const cpl_id_t id,
+					   const cpl_version_t version,
+					   const char* key,
+					   cpl_property_iterator_t iterator,
+					   void* context)
 {
 	assert(backend != NULL);
 	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
@@ -947,89 +2822,83 @@ cpl_rdf_get_version_info(struct _cpl_db_backend_t* backend,
 
 	// Prepare the query
 
-	char node_str[64];
-	sprintf(node_str, "n:%llx-%llx-%x", id.hi, id.lo, version);
-
-	std::ostringstream ss;
+	const cpl_rdf_templates_t& t = rdf->templates;
+	RDFQuery q(key == NULL
+			? (version == CPL_VERSION_NONE ? t.get_properties
+										   : t.get_properties_node)
+			: (version == CPL_VERSION_NONE ? t.get_property
+										   : t.get_property_node));
 
-	ss << "PREFIX p: <prop:>\n";
-	ss << "PREFIX r: <rel:>\n";
-	ss << "PREFIX n: <node:>\n";
-	ss << "SELECT ?session, ?time WHERE {";
-	ss << " " << node_str << " r:session ?session ;";
-	ss << " p:creation_time ?time }";
+	if (version == CPL_VERSION_NONE) {
+		q.object(id);
+	}
+	else {
+		q.node(id, version);
+	}
+	if (key != NULL) q.key(key);
 
 
-	// Execute query
+	// Fetch the properties one page at a time
 
-	RDFResultSet rs;
-	ret = cpl_rdf_connection_execute_query(rdf->connection_query,
-			ss.str().c_str(), &rs);
+	_cpl_rdf_property_context_t ctx;
+	ctx.id = id;
+	ctx.version = version;
+	ctx.key = key;
+	ctx.value = NULL;
 
-	if (ret == CPL_S_NO_DATA) return CPL_E_NOT_FOUND;
-	if (!CPL_IS_OK(ret)) {
-		//rs.print_error_messages(std::cerr);
-		return ret;
-	}
+	bool found = false;
+	size_t num_rows = 0;
 
+	for (size_t page = 0; ; page++) {
 
-	// Process the result
+		ctx.properties.clear();
+		ret = cpl_rdf_query_page(rdf, q.str(), page,
+				cpl_rdf_row_property, &ctx, &num_rows);
 
-	if (out_info == NULL) return CPL_OK;
-	if (rs.size() == 0) return CPL_E_BACKEND_INTERNAL_ERROR;
-	//if (rs.size() >  1) return CPL_E_BACKEND_INTERNAL_ERROR;
+		if (ret == CPL_S_NO_DATA) break;
+		if (!CPL_IS_OK(ret)) return ret;
+		if (!ctx.properties.empty()) found = true;
 
-	cpl_version_info_t* p = (cpl_version_info_t*) malloc(sizeof(*p));
-	if (p == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
-	memset(p, 0, sizeof(*p));
-	p->id = id;
-	p->version = version;
+		if (iterator != NULL) {
+			std::list<cplxx_property_entry_t>::iterator i;
+			for (i = ctx.properties.begin(); i != ctx.properties.end(); i++) {
+				ret = iterator(i->id, i->version, i->key.c_str(),
+							   i->value.c_str(), context);
+				if (!CPL_IS_OK(ret)) return ret;
+			}
+		}
 
-	RDFValue* v;
-	int r;
+		if (num_rows < CPL_RDF_PAGE_SIZE) break;
+	}
 
-	ret = rs[0].get_s("session", RDF_XSD_URI, &v);
-	if (!CPL_IS_OK(ret)) goto err;
-	r = sscanf(v->v_uri, "session:%llx-%llx", &p->session.hi, &p->session.lo);
-	if (r != 2) { ret = CPL_E_BACKEND_INTERNAL_ERROR; goto err; }
 
-	ret = rs[0].get_s("time", RDF_XSD_INTEGER, &v);
-	if (!CPL_IS_OK(ret)) goto err;
-	p->creation_time = v->v_integer;
+	// If we did not get any data back, check for whether the object exists
 
-	*out_info = p;
-	return CPL_OK;
+	if (!found && version != CPL_VERSION_NONE) {
+		ret = cpl_rdf_get_version(backend, id, NULL);
+		if (!CPL_IS_SUCCESS(ret)) return ret;
+	}
 
-err:
-	free(p);
-	return ret;
+	return found ? CPL_OK : CPL_S_NO_DATA;
 }
 
 
 /**
- * Iterate over the ancestors or the descendants of a provenance object.
+ * Lookup an object based on a property value.
  *
  * @param backend the pointer to the backend structure
- * @param id the object ID
- * @param version the object version, or CPL_VERSION_NONE to access all
- *                version nodes associated with the given object
- * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
- *                  or CPL_D_DESCENDANTS)
- * @param flags the bitwise combination of flags describing how should
- *              the graph be traversed (a logical combination of the
- *              CPL_A_* flags)
+ * @param key the property name
+ * @param value the property value
  * @param iterator the iterator callback function
  * @param context the user context to be passed to the iterator function
- * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ * @return CPL_OK, CPL_E_NOT_FOUND, or an error code
  */
 cpl_return_t
-cpl_rdf_get_object_ancestry(struct _cpl_db_backend_t* backend,
-							const cpl_id_t id,
-							const cpl_version_t version,
-							const int direction,
-							const int flags,
-							cpl_ancestry_iterator_t iterator,
-							void* context)
+cpl_rdf_lookup_by_property(struct _cpl_db_backend_t* backend,
+						   const char* key,
+						   const char* value,
+						   cpl_property_iterator_t iterator,
+						   void* context)
 {
 	assert(backend != NULL);
 	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
@@ -1038,189 +2907,360 @@ cpl_rdf_get_object_ancestry(struct _cpl_db_backend_t* backend,
 
 	// Prepare the query
 
-	char str[64];
-	if (version == CPL_VERSION_NONE) {
-		sprintf(str, "o:%llx-%llx", id.hi, id.lo);
-	}
-	else {
-		sprintf(str, "n:%llx-%llx-%x", id.hi, id.lo, version);
-	}
+	RDFQuery q(rdf->templates.lookup_by_property);
+	q.key(key).literal(value);
 
-	std::ostringstream ss;
 
-	ss << "PREFIX p: <prop:>\n";
-	ss << "PREFIX r: <rel:>\n";
-	if (version == CPL_VERSION_NONE) {
-		ss << "PREFIX o: <object:>\n";
-	}
-	else {
-		ss << "PREFIX n: <node:>\n";
-	}
-	ss << "SELECT ?edge, ?other";
-	if (version == CPL_VERSION_NONE) {
-		ss << ", ?node";
-	}
-	ss << " WHERE {";
-	if (direction == CPL_D_ANCESTORS) {
-		if (version == CPL_VERSION_NONE) {
-			ss << " " << str << " r:version ?node . ?node";
-		}
-		else {
-			ss << " " << str;
-		}
-		ss << " ?edge ?other .";
-	}
-	else {
-		if (version == CPL_VERSION_NONE) {
-			ss << " " << str << " r:version ?node .";
-			ss << " ?other ?edge ?node .";
-		}
-		else {
-			ss << " ?other ?edge " << str << " .";
+	// Fetch the matching objects one page at a time
+
+	_cpl_rdf_property_context_t ctx;
+	ctx.id = CPL_NONE;
+	ctx.version = CPL_VERSION_NONE;
+	ctx.key = key;
+	ctx.value = value;
+
+	bool found = false;
+	size_t num_rows = 0;
+
+	for (size_t page = 0; ; page++) {
+
+		ctx.properties.clear();
+		ret = cpl_rdf_query_page(rdf, q.str(), page,
+				cpl_rdf_row_property, &ctx, &num_rows);
+
+		if (ret == CPL_S_NO_DATA) break;
+		if (!CPL_IS_OK(ret)) return ret;
+		if (!ctx.properties.empty()) found = true;
+
+		if (iterator != NULL) {
+			std::list<cplxx_property_entry_t>::iterator i;
+			for (i = ctx.properties.begin(); i != ctx.properties.end(); i++) {
+				ret = iterator(i->id, i->version, key, value, context);
+				if (!CPL_IS_OK(ret)) return ret;
+			}
 		}
+
+		if (num_rows < CPL_RDF_PAGE_SIZE) break;
 	}
-	ss << " FILTER( isURI(?other) ) }";
 
+	return found ? CPL_OK : CPL_E_NOT_FOUND;
+}
 
-	// Execute query
+/**
+ * Find the objects that satisfy all of the given property predicates, and
+ * optionally have the given originator and type.
+ *
+ * @param backend the pointer to the backend structure
+ * @param originator the object originator, or NULL for any
+ * @param type the object type, or NULL for any
+ * @param predicates the array of property predicates
+ * @param num_predicates the number of predicates
+ * @param iterator the iterator to be called for each matching object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_E_NOT_FOUND, or an error code
+ */
+cpl_return_t
+cpl_rdf_query_by_properties(struct _cpl_db_backend_t* backend,
+							const char* originator,
+							const char* type,
+							const cpl_property_predicate_t* predicates,
+							const size_t num_predicates,
+							cpl_id_timestamp_iterator_t iterator,
+							void* context)
+{
+	assert(backend != NULL);
+	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+	cpl_return_t ret;
 
-	RDFResultSet rs;
-	ret = cpl_rdf_connection_execute_query(rdf->connection_query,
-			ss.str().c_str(), &rs);
 
-	if (ret == CPL_S_NO_DATA) {
-		// We do not need to check here whether the object exists, because
-		// the query would at least return the session object in one case
-		// or the actual object in the other case if the given object
-		// exits (we do not fully filter the results in the query itself).
-		return CPL_E_NOT_FOUND;
-	}
-	if (!CPL_IS_OK(ret)) {
-		//rs.print_error_messages(std::cerr);
-		return ret;
+	// Prepare the query, matching each predicate against a (possibly
+	// different) version node of the object
+
+	std::string q = CPL_RDF_PREFIXES;
+	q += "SELECT DISTINCT ?obj ?t WHERE {";
+
+	for (size_t i = 0; i < num_predicates; i++) {
+		const cpl_property_predicate_t& p = predicates[i];
+		std::string var;
+		cpl_rdf_append_hex(var, i);
+
+		q += " ?obj r:version ?n";
+		q += var;
+		q += " . ?n";
+		q += var;
+		q += " ";
+		cpl_rdf_append_key(q, p.key);
+
+		switch (p.op) {
+
+			case CPL_PQ_EQUALS:
+				q += " \"";
+				cpl_rdf_append_escaped(q, p.values[0]);
+				q += "\" .";
+				break;
+
+			case CPL_PQ_IN:
+				q += " ?v";
+				q += var;
+				q += " . FILTER ( ?v";
+				q += var;
+				q += " IN (";
+				for (size_t j = 0; j < p.num_values; j++) {
+					q += j > 0 ? ", \"" : " \"";
+					cpl_rdf_append_escaped(q, p.values[j]);
+					q += "\"";
+				}
+				q += " ) ) .";
+				break;
+
+			case CPL_PQ_PREFIX:
+				q += " ?v";
+				q += var;
+				q += " . FILTER ( STRSTARTS(?v";
+				q += var;
+				q += ", \"";
+				cpl_rdf_append_escaped(q, p.values[0]);
+				q += "\") ) .";
+				break;
+
+			default:
+				return CPL_E_INVALID_ARGUMENT;
+		}
 	}
 
+	if (originator != NULL) {
+		q += " ?obj p:originator \"";
+		cpl_rdf_append_escaped(q, originator);
+		q += "\" .";
+	}
 
-	// Process the result
+	if (type != NULL) {
+		q += " ?obj p:type \"";
+		cpl_rdf_append_escaped(q, type);
+		q += "\" .";
+	}
 
-	if (rs.size() == 0) return CPL_E_BACKEND_INTERNAL_ERROR;
+	q += " ?obj p:creation_time ?t . } ORDER BY ?obj";
 
-	RDFValue* v;
-	int r;
-	bool found_matching_edges = false;
 
-	for (unsigned u = 0; u < rs.size(); u++) {
+	// Fetch the matching objects one page at a time
 
-		// Parse the edge and filter out non-ancestry edges
+	std::list<_cpl_rdf_id_timestamp_t> l;
+	bool found = false;
+	size_t num_rows = 0;
 
-		ret = rs[u].get_s("edge", RDF_XSD_URI, &v);
-		if (!CPL_IS_OK(ret)) return ret;
-		if (strncmp(v->v_uri, "input:", 6) != 0) continue;
+	for (size_t page = 0; ; page++) {
 
-		int type;
-		r = sscanf(v->v_uri, "input:%x", &type);
-		if (r != 1) return CPL_E_BACKEND_INTERNAL_ERROR;
+		l.clear();
+		ret = cpl_rdf_query_page(rdf, q, page,
+				cpl_rdf_row_id_timestamp, &l, &num_rows);
 
+		if (ret == CPL_S_NO_DATA) break;
+		if (!CPL_IS_OK(ret)) return ret;
+		if (!l.empty()) found = true;
 
-		// Filter by type
+		std::list<_cpl_rdf_id_timestamp_t>::iterator i;
+		for (i = l.begin(); i != l.end(); i++) {
+			ret = iterator(i->id, i->timestamp, context);
+			if (!CPL_IS_OK(ret)) return ret;
+		}
 
-		int type_category = CPL_GET_DEPENDENCY_CATEGORY((int) type);
-		if (type_category == CPL_DEPENDENCY_CATEGORY_DATA
-				&& (flags & CPL_A_NO_DATA_DEPENDENCIES) != 0) continue;
-		if (type_category == CPL_DEPENDENCY_CATEGORY_CONTROL
-				&& (flags & CPL_A_NO_CONTROL_DEPENDENCIES) != 0) continue;
+		if (num_rows < CPL_RDF_PAGE_SIZE) break;
+	}
 
+	return found ? CPL_OK : CPL_E_NOT_FOUND;
+}
 
-		// Get the query node
+/**
+ * The context for cpl_rdf_row_graph_statistic()
+ */
+typedef struct {
+	int kind;
+	long offset;
+	std::list<cplxx_graph_statistic_t> rows;
+} _cpl_rdf_graph_statistic_context_t;
 
-		cpl_version_t query_version;
 
-		if (version == CPL_VERSION_NONE) {
-			ret = rs[u].get_s("node", RDF_XSD_URI, &v);
-			if (!CPL_IS_OK(ret)) return ret;
+/**
+ * The row callback for cpl_rdf_get_graph_statistics()
+ *
+ * @param row the result row with ?n and either ?edge, ?k, or ?day, ?orig,
+ *            and ?type
+ * @param context the _cpl_rdf_graph_statistic_context_t
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_rdf_row_graph_statistic(RDFResult& row, void* context)
+{
+	_cpl_rdf_graph_statistic_context_t* ctx
+		= (_cpl_rdf_graph_statistic_context_t*) context;
+	cplxx_graph_statistic_t e;
+	cpl_return_t ret;
+	RDFValue* v;
 
-			cpl_id_t query_id;
-			r = sscanf(v->v_uri, "node:%llx-%llx-%x",
-					&query_id.hi, &query_id.lo, &query_version);
-			if (r != 3) return CPL_E_BACKEND_INTERNAL_ERROR;
-		}
-		else {
-			query_version = version;
-		}
+	e.kind = ctx->kind;
 
 
-		// Get the other node
+	// Some endpoints return a single row with a zero count and unbound
+	// groups when there is nothing to aggregate
 
-		ret = rs[u].get_s("other", RDF_XSD_URI, &v);
-		if (!CPL_IS_OK(ret)) return ret;
+	ret = row.get_s("n", RDF_XSD_INTEGER, &v);
+	if (ret == CPL_E_DB_KEY_NOT_FOUND) return CPL_OK;
+	if (!CPL_IS_OK(ret)) return ret;
+	if (v->v_integer == 0) return CPL_OK;
+	e.count = v->v_integer;
 
-		cpl_id_t other_id;
-		cpl_version_t other_version;
-		r = sscanf(v->v_uri, "node:%llx-%llx-%x",
-				&other_id.hi, &other_id.lo, &other_version);
-		if (r != 3) return CPL_E_BACKEND_INTERNAL_ERROR;
+	switch (ctx->kind) {
 
+		case CPL_GS_EDGES_BY_TYPE: {
+			unsigned type = 0;
+			ret = row.get_s("edge", RDF_XSD_URI, &v);
+			if (!CPL_IS_OK(ret)) return ret;
+			if (sscanf(v->v_uri, "input:%x", &type) != 1)
+				return CPL_E_BACKEND_INTERNAL_ERROR;
+			e.key = type;
+			break;
+		}
 
-		// Call the callback function (if available)
+		case CPL_GS_OBJECTS_PER_DAY:
+			ret = row.get_s("day", RDF_XSD_INTEGER, &v);
+			if (!CPL_IS_OK(ret)) return ret;
+			e.key = v->v_integer * 86400 - ctx->offset;
+			ret = row.get_s("orig", RDF_XSD_STRING, &v);
+			if (!CPL_IS_OK(ret)) return ret;
+			e.originator = v->v_string;
+			ret = row.get_s("type", RDF_XSD_STRING, &v);
+			if (!CPL_IS_OK(ret)) return ret;
+			e.type = v->v_string;
+			break;
 
-		found_matching_edges = true;
-		if (iterator != NULL) {
-			ret = iterator(id, query_version, other_id, other_version,
-						   type, context);
+		default:
+			ret = row.get_s("k", RDF_XSD_INTEGER, &v);
 			if (!CPL_IS_OK(ret)) return ret;
-		}
+			e.key = v->v_integer;
+			break;
 	}
 
-	return found_matching_edges ? CPL_OK : CPL_S_NO_DATA;
+	ctx->rows.push_back(e);
+	return CPL_OK;
 }
 
 
 /**
- * Get the properties associated with the given provenance object.
- *
- * @param backend the pointer to the backend structure
- * @param id the the object ID
- * @param version the object version, or CPL_VERSION_NONE to access all
- *                version nodes associated with the given object
- * @param key the property to fetch - or NULL for all properties
- * @param iterator the iterator callback function
- * @param context the user context to be passed to the iterator function
- * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ * The ordering of the graph statistics within a single kind
  */
-cpl_return_t
-cpl_rdf_get_properties(struct _cpl_db_backend_t* backend,
-					   const cpl_id_t id,
-					   const cpl_version_t version,
-					   const char* key,
-					   cpl_property_iterator_t iterator,
-					   void* context)
-{
-	return CPL_E_NOT_IMPLEMENTED;
-}
+struct _cpl_rdf_graph_statistic_less {
+	inline bool operator() (const cplxx_graph_statistic_t& a,
+							const cplxx_graph_statistic_t& b) const {
+		if (a.key != b.key) return a.key < b.key;
+		if (a.originator != b.originator) return a.originator < b.originator;
+		return a.type < b.type;
+	}
+};
 
 
 /**
- * Lookup an object based on a property value.
+ * Compute aggregate statistics about the provenance graph, attributing each
+ * object, version node, and edge to the time of its creation. The grouping
+ * is done by the SPARQL endpoint, so only the aggregates are transferred.
  *
  * @param backend the pointer to the backend structure
- * @param key the property name
- * @param value the property value
- * @param iterator the iterator callback function
- * @param context the user context to be passed to the iterator function
- * @return CPL_OK, CPL_E_NOT_FOUND, or an error code
+ * @param kinds a logical combination of the CPL_GS_* constants
+ * @param start_time the start of the time range (inclusive)
+ * @param end_time the end of the time range (inclusive), or 0
+ * @param iterator the iterator to be called for each group, ordered by
+ *                 kind and then by key
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
  */
 cpl_return_t
-cpl_rdf_lookup_by_property(struct _cpl_db_backend_t* backend,
-						   const char* key,
-						   const char* value,
-						   cpl_property_iterator_t iterator,
-						   void* context)
+cpl_rdf_get_graph_statistics(struct _cpl_db_backend_t* backend,
+							 const int kinds,
+							 const unsigned long start_time,
+							 const unsigned long end_time,
+							 cpl_graph_statistic_iterator_t iterator,
+							 void* context)
 {
-	return CPL_E_NOT_IMPLEMENTED;
+	assert(backend != NULL);
+	cpl_rdf_t* rdf = (cpl_rdf_t*) backend;
+	cpl_return_t ret;
+
+
+	// The creation times are stored as UNIX time, so the days are computed
+	// using the current offset of the local time zone from UTC
+
+	time_t now = time(NULL);
+	struct tm m;
+	localtime_r(&now, &m);
+
+	_cpl_rdf_graph_statistic_context_t ctx;
+	ctx.offset = m.tm_gmtoff;
+
+	long long end = end_time != 0 ? (long long) end_time : LLONG_MAX;
+	bool found = false;
+
+	for (int kind = 1; kind <= CPL_GS_ALL; kind <<= 1) {
+		if ((kinds & kind) == 0) continue;
+
+
+		// Prepare the query
+
+		const RDFQueryTemplate* t = NULL;
+		switch (kind) {
+			case CPL_GS_EDGES_BY_TYPE:
+				t = &rdf->templates.stats_edges_by_type; break;
+			case CPL_GS_VERSIONS_PER_OBJECT:
+				t = &rdf->templates.stats_versions_per_object; break;
+			case CPL_GS_FAN_IN:
+				t = &rdf->templates.stats_fan_in; break;
+			case CPL_GS_FAN_OUT:
+				t = &rdf->templates.stats_fan_out; break;
+			case CPL_GS_OBJECTS_PER_DAY:
+				t = &rdf->templates.stats_objects_per_day; break;
+		}
+
+		RDFQuery q(*t);
+		q.integer(start_time).integer(end);
+		if (kind == CPL_GS_OBJECTS_PER_DAY) q.integer(ctx.offset);
+
+
+		// Execute the query
+
+		ctx.kind = kind;
+		ctx.rows.clear();
+
+		ret = cpl_rdf_query_stream(rdf, q.c_str(),
+				cpl_rdf_row_graph_statistic, &ctx);
+		if (ret == CPL_S_NO_DATA) continue;
+		if (!CPL_IS_OK(ret)) return ret;
+		if (!ctx.rows.empty()) found = true;
+
+
+		// Call the iterator in the order of the keys
+
+		ctx.rows.sort(_cpl_rdf_graph_statistic_less());
+
+		std::list<cplxx_graph_statistic_t>::iterator i;
+		for (i = ctx.rows.begin(); i != ctx.rows.end(); i++) {
+			cpl_graph_statistic_t s;
+			s.kind = kind;
+			s.key = i->key;
+			s.originator = kind == CPL_GS_OBJECTS_PER_DAY
+				? i->originator.c_str() : NULL;
+			s.type = kind == CPL_GS_OBJECTS_PER_DAY ? i->type.c_str() : NULL;
+			s.count = i->count;
+
+			ret = iterator(&s, context);
+			if (!CPL_IS_OK(ret)) return ret;
+		}
+	}
+
+	return found ? CPL_OK : CPL_S_NO_DATA;
 }
 
 
 
+
 /***************************************************************************/
 /** The export / interface struct                                         **/
 /***************************************************************************/
@@ -1246,5 +3286,17 @@ const cpl_db_backend_t CPL_RDF_BACKEND = {
 	cpl_rdf_get_object_ancestry,
 	cpl_rdf_get_properties,
 	cpl_rdf_lookup_by_property,
+	cpl_rdf_get_object_ancestry_batch,
+	cpl_rdf_get_transitive_ancestry,
+	cpl_rdf_get_object_info_batch,
+	cpl_rdf_get_version_info_batch,
+	cpl_rdf_get_session_info_batch,
+	cpl_rdf_get_objects_page,
+	cpl_rdf_get_versions_in_range,
+	cpl_rdf_get_session_activity,
+	cpl_rdf_query_by_properties,
+	cpl_rdf_get_contained_objects,
+	cpl_rdf_lookup_by_name_prefix,
+	cpl_rdf_get_graph_statistics,
 };
 
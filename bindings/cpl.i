@@ -59,6 +59,7 @@ typedef cpl_db_backend_t* p_cpl_db_backend_t;
 typedef cpl_session_info_t* p_cpl_session_info_t;
 typedef cpl_object_info_t* p_cpl_object_info_t;
 typedef cpl_version_info_t* p_cpl_version_info_t;
+typedef cpl_cursor_t* p_cpl_cursor_t;
 
 inline _cpl_db_backend_t*
 cpl_dereference_pp_cpl_db_backend_t(p_cpl_db_backend_t* p) {
@@ -80,6 +81,11 @@ cpl_dereference_pp_cpl_version_info_t(p_cpl_version_info_t* p) {
     return *p;
 }
 
+inline cpl_cursor_t*
+cpl_dereference_pp_cpl_cursor_t(p_cpl_cursor_t* p) {
+    return *p;
+}
+
 inline cpl_session_info_t**
 cpl_convert_pp_cpl_session_info_t(p_cpl_session_info_t* p) {
     return p;
@@ -95,6 +101,11 @@ cpl_convert_pp_cpl_version_info_t(p_cpl_version_info_t* p) {
     return p;
 }
 
+inline cpl_cursor_t**
+cpl_convert_pp_cpl_cursor_t(p_cpl_cursor_t* p) {
+    return p;
+}
+
 inline int
 cpl_is_ok(cpl_return_t ret) {
     return CPL_IS_OK(ret);
@@ -171,6 +182,20 @@ cpl_convert_p_std_vector_cplxx_property_entry_t_to_p_void(
     return (void*) p;
 }
 
+typedef std::vector<cpl_version_info_t> std_vector_cpl_version_info_t;
+
+inline std::vector<cpl_version_info_t>&
+cpl_dereference_p_std_vector_cpl_version_info_t(
+        std_vector_cpl_version_info_t* p) {
+    return *p;
+}
+
+inline void*
+cpl_convert_p_std_vector_cpl_version_info_t_to_p_void(
+        std_vector_cpl_version_info_t* p) {
+    return (void*) p;
+}
+
 %}
 
 
@@ -190,6 +215,9 @@ cpl_dereference_pp_cpl_object_info_t(p_cpl_object_info_t* p);
 inline cpl_version_info_t*
 cpl_dereference_pp_cpl_version_info_t(p_cpl_version_info_t* p);
 
+inline cpl_cursor_t*
+cpl_dereference_pp_cpl_cursor_t(p_cpl_cursor_t* p);
+
 inline cpl_session_info_t**
 cpl_convert_pp_cpl_session_info_t(p_cpl_session_info_t* p);
 
@@ -199,6 +227,9 @@ cpl_convert_pp_cpl_object_info_t(p_cpl_object_info_t* p);
 inline cpl_version_info_t**
 cpl_convert_pp_cpl_version_info_t(p_cpl_version_info_t* p);
 
+inline cpl_cursor_t**
+cpl_convert_pp_cpl_cursor_t(p_cpl_cursor_t* p);
+
 inline int
 cpl_is_ok(cpl_return_t ret);
 
@@ -272,6 +303,16 @@ inline void*
 cpl_convert_p_std_vector_cplxx_property_entry_t_to_p_void(
         std_vector_cplxx_property_entry_t* p);
 
+%template (cpl_version_info_t_vector) std::vector<cpl_version_info_t>;
+
+inline std::vector<cpl_version_info_t>&
+cpl_dereference_p_std_vector_cpl_version_info_t(
+    std_vector_cpl_version_info_t* p);
+
+inline void*
+cpl_convert_p_std_vector_cpl_version_info_t_to_p_void(
+        std_vector_cpl_version_info_t* p);
+
 
 /*
  * Pointers
@@ -281,10 +322,12 @@ cpl_convert_p_std_vector_cplxx_property_entry_t_to_p_void(
 %pointer_functions(p_cpl_session_info_t, cpl_session_info_tpp);
 %pointer_functions(p_cpl_object_info_t, cpl_object_info_tpp);
 %pointer_functions(p_cpl_version_info_t, cpl_version_info_tpp);
+%pointer_functions(p_cpl_cursor_t, cpl_cursor_tpp);
 
 %pointer_functions(cpl_session_t, cpl_session_tp);
 %pointer_functions(cpl_id_t, cpl_id_tp);
 %pointer_functions(cpl_version_t, cpl_version_tp);
+%pointer_functions(int, intp);
 
 %pointer_functions(cpl_session_info_t, cpl_session_info_tp);
 %pointer_functions(cpl_object_info_t, cpl_object_info_tp);
@@ -302,4 +345,6 @@ cpl_convert_p_std_vector_cplxx_property_entry_t_to_p_void(
         std_vector_cplxx_object_info_tp);
 %pointer_functions(std_vector_cplxx_property_entry_t,
         std_vector_cplxx_property_entry_tp);
+%pointer_functions(std_vector_cpl_version_info_t,
+        std_vector_cpl_version_info_tp);
 
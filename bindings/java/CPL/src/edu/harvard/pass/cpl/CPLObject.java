@@ -37,6 +37,8 @@ package edu.harvard.pass.cpl;
 
 import swig.direct.CPLDirect.*;
 
+import java.util.Iterator;
+import java.util.NoSuchElementException;
 import java.util.Vector;
 
 
@@ -448,6 +450,173 @@ public class CPLObject {
     }
 
 
+    /**
+     * Iterate lazily over all provenance objects, optionally restricted to
+     * the given originator and/or type. The objects are fetched from the
+     * database in batches using a cursor, so that the memory use does not
+     * depend on the size of the database.
+     *
+     * @param originator the originator, or null for any
+     * @param type the type, or null for any
+     * @param batchSize the number of objects to fetch at a time
+     * @return an iterable collection of the objects
+     */
+    public static Iterable<CPLObject> iterateObjects(final String originator,
+            final String type, final int batchSize) {
+
+        return new Iterable<CPLObject>() {
+            public Iterator<CPLObject> iterator() {
+                return new ObjectCursorIterator(originator, type, batchSize);
+            }
+        };
+    }
+
+
+    /**
+     * Iterate lazily over all provenance objects
+     *
+     * @return an iterable collection of all provenance objects
+     */
+    public static Iterable<CPLObject> iterateObjects() {
+        return iterateObjects(null, null, 1000);
+    }
+
+
+    /**
+     * The iterator over a cursor opened by cpl_open_object_cursor()
+     */
+    private static class ObjectCursorIterator implements Iterator<CPLObject> {
+
+        /// The cursor, or null if it is already closed
+        private SWIGTYPE_p_cpl_cursor cursor;
+
+        /// The vector for the current batch
+        private SWIGTYPE_p_std_vector_cplxx_object_info_t pVector;
+
+        /// The current batch
+        private cplxx_object_info_t_vector batch;
+
+        /// The position in the current batch
+        private int position;
+
+        /// The batch size
+        private int batchSize;
+
+
+        /**
+         * Open the cursor
+         *
+         * @param originator the originator, or null for any
+         * @param type the type, or null for any
+         * @param batchSize the number of objects to fetch at a time
+         */
+        public ObjectCursorIterator(String originator, String type,
+                int batchSize) {
+
+            SWIGTYPE_p_p_cpl_cursor ppCursor
+                = CPLDirect.new_cpl_cursor_tpp();
+
+            try {
+                int r = CPLDirect.cpl_open_object_cursor(originator, type,
+                        CPLDirect.CPL_I_FAST,
+                        CPLDirect.cpl_convert_pp_cpl_cursor_t(ppCursor));
+                CPLException.assertSuccess(r);
+                cursor = CPLDirect.cpl_dereference_pp_cpl_cursor_t(ppCursor);
+            }
+            finally {
+                CPLDirect.delete_cpl_cursor_tpp(ppCursor);
+            }
+
+            this.pVector = CPLDirect.new_std_vector_cplxx_object_info_tp();
+            this.batch = null;
+            this.position = 0;
+            this.batchSize = batchSize;
+        }
+
+
+        /**
+         * Close the cursor and free the vector
+         */
+        private void close() {
+            if (cursor != null) {
+                CPLDirect.cpl_close_cursor(cursor);
+                CPLDirect.delete_std_vector_cplxx_object_info_tp(pVector);
+                cursor = null;
+                batch = null;
+            }
+        }
+
+
+        /**
+         * Determine whether there are more objects, fetching the next batch
+         * if necessary
+         *
+         * @return true if there are more objects
+         */
+        public boolean hasNext() {
+
+            if (batch != null && position < batch.size()) return true;
+            if (cursor == null) return false;
+
+            int r = CPLDirect.cpl_cursor_fetch_object_info_vector(cursor,
+                    batchSize, CPLDirect
+                    .cpl_convert_p_std_vector_cplxx_object_info_t_to_p_void(
+                        pVector));
+            if (r == CPLDirect.CPL_S_NO_DATA) {
+                close();
+                return false;
+            }
+            if (r < 0) {
+                close();
+                CPLException.assertSuccess(r);
+            }
+
+            batch = CPLDirect
+                .cpl_dereference_p_std_vector_cplxx_object_info_t(pVector);
+            position = 0;
+            return batch.size() > 0;
+        }
+
+
+        /**
+         * Return the next object
+         *
+         * @return the next object
+         */
+        public CPLObject next() {
+
+            if (!hasNext()) throw new NoSuchElementException();
+
+            cplxx_object_info_t e = batch.get(position++);
+
+            CPLObject o = new CPLObject(e.getId());
+            o.originator = e.getOriginator();
+            o.name = e.getName();
+            o.type = e.getType();
+
+            cpl_id_t containerId = e.getContainer_id();
+            if (CPL.isNone(containerId)) {
+                o.container = null;
+            }
+            else {
+                o.container = new CPLObjectVersion(new CPLObject(containerId),
+                        e.getContainer_version());
+            }
+            o.knowContainer = true;
+
+            return o;
+        }
+
+
+        /**
+         * Removing objects is not supported
+         */
+        public void remove() {
+            throw new UnsupportedOperationException();
+        }
+    }
+
+
 	/**
 	 * Determine whether this and the other object are equal
 	 *
@@ -180,6 +180,17 @@ public class test {
 		if (!objall.contains(obj2))
 			throw new RuntimeException("getAllObjects() is missing an object");
 
+        System.out.print("CPLObject.iterateObjects(ORIGINATOR, null, 2)");
+        int objiterCount = 0;
+        boolean objiterFound = false;
+        for (CPLObject o : CPLObject.iterateObjects(ORIGINATOR, null, 2)) {
+            if (o.equals(obj2)) objiterFound = true;
+            objiterCount++;
+        }
+		System.out.println(": " + objiterCount + " results");
+		if (!objiterFound)
+			throw new RuntimeException("iterateObjects() is missing an object");
+
 		System.out.println();
 
 
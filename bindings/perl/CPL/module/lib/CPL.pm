@@ -75,6 +75,7 @@ our %EXPORT_TAGS = ( 'all' => [ qw(
 	get_version_info
     get_all_objects
     get_all_objects_fast
+    object_iterator
 	get_object_ancestry
     get_properties
     lookup_by_property
@@ -108,6 +109,7 @@ our @EXPORT = qw(
 	get_version_info
     get_all_objects
     get_all_objects_fast
+    object_iterator
 	get_object_ancestry
     get_properties
     lookup_by_property
@@ -826,6 +828,74 @@ sub get_version_info {
 }
 
 
+#
+# Convert an instance of cplxx_object_info_t to a hash reference. If $fast is
+# true, omit the version and the creation session.
+#
+sub object_info_from_cplxx {
+	my ($info, $fast) = @_;
+
+	my $info_id = CPLDirect::cplxx_object_info_t::swig_id_get($info);
+	my $r_id = {
+		hi => CPLDirect::cpl_id_t::swig_hi_get($info_id),
+		lo => CPLDirect::cpl_id_t::swig_lo_get($info_id)
+	};
+
+    my $info_session =
+        CPLDirect::cplxx_object_info_t::swig_creation_session_get($info);
+    my $r_session = {
+       hi => CPLDirect::cpl_id_t::swig_hi_get($info_session),
+       lo => CPLDirect::cpl_id_t::swig_lo_get($info_session)
+    };
+
+    my $info_container =
+        CPLDirect::cplxx_object_info_t::swig_container_id_get($info);
+    my $r_container = {
+       hi => CPLDirect::cpl_id_t::swig_hi_get($info_container),
+       lo => CPLDirect::cpl_id_t::swig_lo_get($info_container)
+    };
+
+    my $r_element;
+    if ($fast) {
+        $r_element = {
+            id                => $r_id,
+            creation_time     => 
+                CPLDirect::cplxx_object_info_t::swig_creation_time_get($info),
+            originator        => 
+                CPLDirect::cplxx_object_info_t::swig_originator_get($info),
+            name              => 
+                CPLDirect::cplxx_object_info_t::swig_name_get($info),
+            type              => 
+                CPLDirect::cplxx_object_info_t::swig_type_get($info),
+            container_id      => $r_container,
+            container_version =>
+                CPLDirect::cplxx_object_info_t::swig_container_version_get($info),
+        };
+    }
+    else {
+        $r_element = {
+            id                => $r_id,
+            version           => 
+                CPLDirect::cplxx_object_info_t::swig_version_get($info),
+            creation_session  => $r_session,
+            creation_time     => 
+                CPLDirect::cplxx_object_info_t::swig_creation_time_get($info),
+            originator        => 
+                CPLDirect::cplxx_object_info_t::swig_originator_get($info),
+            name              => 
+                CPLDirect::cplxx_object_info_t::swig_name_get($info),
+            type              => 
+                CPLDirect::cplxx_object_info_t::swig_type_get($info),
+            container_id      => $r_container,
+            container_version =>
+                CPLDirect::cplxx_object_info_t::swig_container_version_get($info),
+        };
+    }
+
+	return $r_element;
+}
+
+
 #
 # Get all objects in the database. If $fast is true, return incomplete
 # information, but do so faster
@@ -855,65 +925,7 @@ sub get_all_objects {
 	my @r = ();
 	for (my $i = 0; $i < $vector_size; $i++) {
 		my $info = CPLDirect::cplxx_object_info_t_vector::get($vector, $i);
-
-		my $info_id = CPLDirect::cplxx_object_info_t::swig_id_get($info);
-		my $r_id = {
-			hi => CPLDirect::cpl_id_t::swig_hi_get($info_id),
-			lo => CPLDirect::cpl_id_t::swig_lo_get($info_id)
-		};
-
-        my $info_session =
-            CPLDirect::cplxx_object_info_t::swig_creation_session_get($info);
-        my $r_session = {
-           hi => CPLDirect::cpl_id_t::swig_hi_get($info_session),
-           lo => CPLDirect::cpl_id_t::swig_lo_get($info_session)
-        };
-
-        my $info_container =
-            CPLDirect::cplxx_object_info_t::swig_container_id_get($info);
-        my $r_container = {
-           hi => CPLDirect::cpl_id_t::swig_hi_get($info_container),
-           lo => CPLDirect::cpl_id_t::swig_lo_get($info_container)
-        };
-
-        my $r_element;
-        if ($fast) {
-            $r_element = {
-                id                => $r_id,
-                creation_time     => 
-                    CPLDirect::cplxx_object_info_t::swig_creation_time_get($info),
-                originator        => 
-                    CPLDirect::cplxx_object_info_t::swig_originator_get($info),
-                name              => 
-                    CPLDirect::cplxx_object_info_t::swig_name_get($info),
-                type              => 
-                    CPLDirect::cplxx_object_info_t::swig_type_get($info),
-                container_id      => $r_container,
-                container_version =>
-                    CPLDirect::cplxx_object_info_t::swig_container_version_get($info),
-            };
-        }
-        else {
-            $r_element = {
-                id                => $r_id,
-                version           => 
-                    CPLDirect::cplxx_object_info_t::swig_version_get($info),
-                creation_session  => $r_session,
-                creation_time     => 
-                    CPLDirect::cplxx_object_info_t::swig_creation_time_get($info),
-                originator        => 
-                    CPLDirect::cplxx_object_info_t::swig_originator_get($info),
-                name              => 
-                    CPLDirect::cplxx_object_info_t::swig_name_get($info),
-                type              => 
-                    CPLDirect::cplxx_object_info_t::swig_type_get($info),
-                container_id      => $r_container,
-                container_version =>
-                    CPLDirect::cplxx_object_info_t::swig_container_version_get($info),
-            };
-        }
-
-		push @r, $r_element;
+		push @r, object_info_from_cplxx($info, $fast);
 	}
 
     CPLDirect::delete_std_vector_cplxx_object_info_tp($vector_ptr);
@@ -930,6 +942,70 @@ sub get_all_objects_fast {
 }
 
 
+#
+# Return an iterator over all objects in the database, optionally restricted
+# to the given originator and/or type (use undef for any). Each call of the
+# iterator returns the next object, or undef at the end. The objects are
+# fetched from the database in batches of $batch_size using a cursor, so that
+# the memory use does not depend on the size of the database. If $fast is
+# true, return incomplete information, but do so faster.
+#
+sub object_iterator {
+	my ($originator, $type, $fast, $batch_size) = @_;
+
+	if (!defined($batch_size)) { $batch_size = 1000 }
+
+    my $flags = 0;
+    if ($fast) {
+        $flags = $CPLDirect::CPL_I_FAST;
+    }
+
+	my $cursor_ptr = CPLDirect::new_cpl_cursor_tpp();
+	my $ret = CPLDirect::cpl_open_object_cursor($originator, $type, $flags,
+			CPLDirect::cpl_convert_pp_cpl_cursor_t($cursor_ptr));
+
+	if (!CPLDirect::cpl_is_ok($ret)) {
+		CPLDirect::delete_cpl_cursor_tpp($cursor_ptr);
+		croak "Could not open an object cursor: " .
+			CPLDirect::cpl_error_string($ret);
+	}
+
+	my $cursor = CPLDirect::cpl_dereference_pp_cpl_cursor_t($cursor_ptr);
+	CPLDirect::delete_cpl_cursor_tpp($cursor_ptr);
+
+	my $vector_ptr = CPLDirect::new_std_vector_cplxx_object_info_tp();
+	my $vector = undef;
+	my $vector_size = 0;
+	my $i = 0;
+
+	return sub {
+		if (!defined($cursor)) { return undef }
+
+		if ($i >= $vector_size) {
+			my $ret = CPLDirect::cpl_cursor_fetch_object_info_vector($cursor,
+					$batch_size, $vector_ptr);
+			if ($ret == $CPLDirect::CPL_S_NO_DATA
+					|| !CPLDirect::cpl_is_ok($ret)) {
+				CPLDirect::cpl_close_cursor($cursor);
+				CPLDirect::delete_std_vector_cplxx_object_info_tp($vector_ptr);
+				$cursor = undef;
+				if ($ret == $CPLDirect::CPL_S_NO_DATA) { return undef }
+				croak "Could not fetch the objects: " .
+					CPLDirect::cpl_error_string($ret);
+			}
+
+			$vector = CPLDirect::cpl_dereference_p_std_vector_cplxx_object_info_t(
+					$vector_ptr);
+			$vector_size = CPLDirect::cplxx_object_info_t_vector::size($vector);
+			$i = 0;
+		}
+
+		my $info = CPLDirect::cplxx_object_info_t_vector::get($vector, $i++);
+		return object_info_from_cplxx($info, $fast);
+	};
+}
+
+
 #
 # Get the object ancestry
 #
@@ -267,6 +267,19 @@ print "  object 2:\n";
 print_hash_ref($objall_fast[2]);
 print "  ... (" . ($#objall_fast+1) . " elements)\n";
 
+print "CPL::object_iterator(\$ORIGINATOR, undef, 1, 2)";
+my $objiter = CPL::object_iterator($ORIGINATOR, undef, 1, 2);
+my $objiter_count = 0;
+my $objiter_found = 0;
+while (defined(my $o = $objiter->())) {
+	if (CPL::id_eq($o->{id}, $obj2)) { $objiter_found = 1 }
+	$objiter_count++;
+}
+print ": $objiter_count results\n";
+if (!$objiter_found) {
+	die "object_iterator() is missing an object";
+}
+
 print "\n";
 
 
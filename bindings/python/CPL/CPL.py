@@ -97,6 +97,7 @@ E_INVALID_VERSION = CPLDirect.CPL_E_INVALID_VERSION
 E_DB_NULL = CPLDirect.CPL_E_DB_NULL
 E_DB_KEY_NOT_FOUND = CPLDirect.CPL_E_DB_KEY_NOT_FOUND
 E_DB_INVALID_TYPE = CPLDirect.CPL_E_DB_INVALID_TYPE
+E_INVALID_QUERY = CPLDirect.CPL_E_INVALID_QUERY
 O_FILESYSTEM = CPLDirect.CPL_O_FILESYSTEM
 O_INTERNET = CPLDirect.CPL_O_INTERNET
 T_ARTIFACT = CPLDirect.CPL_T_ARTIFACT
@@ -560,7 +561,20 @@ class cpl_connection:
 		'''
 		Return all objects in the provenance database. If fast = True, then
 		fetch only incomplete information about each object, so that it is
-		faster.
+		faster. Use iter_objects() to avoid keeping all objects in memory.
+		'''
+
+		return list(self.iter_objects(fast=fast))
+
+
+	def iter_objects(self, originator=None, type=None, fast=False,
+			batch_size=1000):
+		'''
+		Iterate lazily over all objects in the provenance database, optionally
+		restricted to the given originator and/or type. The objects are
+		fetched from the database in batches of batch_size using a cursor, so
+		that the memory use does not depend on the size of the database. If
+		fast = True, then fetch only incomplete information about each object.
 		'''
 
 		if fast:
@@ -568,34 +582,115 @@ class cpl_connection:
 		else:
 			flags = 0
 
+		cpp = CPLDirect.new_cpl_cursor_tpp()
+		ret = CPLDirect.cpl_open_object_cursor(originator, type, flags,
+				CPLDirect.cpl_convert_pp_cpl_cursor_t(cpp))
+		if not CPLDirect.cpl_is_ok(ret):
+			CPLDirect.delete_cpl_cursor_tpp(cpp)
+			raise Exception('Unable to open an object cursor: ' +
+					CPLDirect.cpl_error_string(ret))
+
+		cursor = CPLDirect.cpl_dereference_pp_cpl_cursor_t(cpp)
+		CPLDirect.delete_cpl_cursor_tpp(cpp)
+
 		vp = CPLDirect.new_std_vector_cplxx_object_info_tp()
-		ret = CPLDirect.cpl_get_all_objects(flags,
-			CPLDirect.cpl_cb_collect_object_info_vector, vp)
+		try:
+			while True:
+				ret = CPLDirect.cpl_cursor_fetch_object_info_vector(cursor,
+						batch_size, vp)
+				if ret == S_NO_DATA:
+					break
+				if not CPLDirect.cpl_is_ok(ret):
+					raise Exception('Unable to fetch objects: ' +
+							CPLDirect.cpl_error_string(ret))
+
+				v = CPLDirect.cpl_dereference_p_std_vector_cplxx_object_info_t(
+						vp)
+				for e in v:
+					if e.container_id == NONE or e.container_version < 0:
+						container = None
+					else:
+						container = cpl_object_version(
+								cpl_object(e.container_id),
+								e.container_version)
+					if e.creation_session == NONE:
+						creation_session = None
+					else:
+						creation_session = cpl_session(e.creation_session)
+					yield cpl_object_info(cpl_object(e.id), e.version,
+						creation_session, e.creation_time, e.originator,
+						e.name, e.type, container)
+		finally:
+			CPLDirect.delete_std_vector_cplxx_object_info_tp(vp)
+			CPLDirect.cpl_close_cursor(cursor)
+
+
+	def __version_info_list(self, function, *args):
+		'''
+		Call a CPL function that lists version nodes using an iterator,
+		and return the results as a list of cpl_object_version_info.
+		'''
+		vp = CPLDirect.new_std_vector_cpl_version_info_tp()
+		cb = CPLDirect.cpl_cb_collect_version_info_vector
+		p = CPLDirect.cpl_convert_p_std_vector_cpl_version_info_t_to_p_void(vp)
+		ret = function(*(args + (cb, p)))
 
 		if not CPLDirect.cpl_is_ok(ret):
-			CPLDirect.delete_std_vector_cplxx_object_info_tp(vp)
-			raise Exception('Unable to get all objects: ' +
+			CPLDirect.delete_std_vector_cpl_version_info_tp(vp)
+			raise Exception('Unable to list versions: ' +
 					CPLDirect.cpl_error_string(ret))
 
-		v = CPLDirect.cpl_dereference_p_std_vector_cplxx_object_info_t(vp)
+		v = CPLDirect.cpl_dereference_p_std_vector_cpl_version_info_t(vp)
 		l = []
-		if v != S_NO_DATA :
+		if ret != S_NO_DATA:
 			for e in v:
-				if e.container_id == NONE or e.container_version < 0:
-					container = None
-				else:
-					container = cpl_object_version(cpl_object(e.container_id),
-							e.container_version)
-				if e.creation_session == NONE:
-					creation_session = None
-				else:
-					creation_session = cpl_session(e.creation_session)
-				l.append(cpl_object_info(cpl_object(e.id), e.version,
-					creation_session, e.creation_time, e.originator, e.name,
-					e.type, container))
+				l.append(cpl_object_version_info(cpl_object_version(
+					cpl_object(e.id), e.version), cpl_session(e.session),
+					e.creation_time))
 
-		CPLDirect.delete_std_vector_cplxx_object_info_tp(vp)
+		CPLDirect.delete_std_vector_cpl_version_info_tp(vp)
 		return l
+
+
+	def get_versions_in_range(self, start_time, end_time):
+		'''
+		Return the cpl_object_version_info of all versions created between
+		start_time and end_time (inclusive, both expressed as UNIX time),
+		ordered by their creation time.
+		'''
+		return self.__version_info_list(CPLDirect.cpl_get_versions_in_range,
+				start_time, end_time)
+
+
+	def get_session_activity(self, session):
+		'''
+		Return the cpl_object_version_info of all versions created by
+		the given session, ordered by their creation time.
+		'''
+		return self.__version_info_list(CPLDirect.cpl_get_session_activity,
+				session.id)
+
+
+	def enable_reachability_index(self, path=None):
+		'''
+		Enable the reachability index, which answers transitive
+		has_ancestor() queries in memory. The index is loaded from the
+		given file if it exists, or built from the database otherwise.
+		'''
+		ret = CPLDirect.cpl_enable_reachability_index(path)
+		if not CPLDirect.cpl_is_ok(ret):
+			raise Exception('Unable to enable the reachability index: ' +
+					CPLDirect.cpl_error_string(ret))
+
+
+	def rebuild_reachability_index(self):
+		'''
+		Rebuild the reachability index from the database.
+		'''
+		ret = CPLDirect.cpl_rebuild_reachability_index()
+		if not CPLDirect.cpl_is_ok(ret):
+			raise Exception('Unable to rebuild the reachability index: ' +
+					CPLDirect.cpl_error_string(ret))
 			
 
 	def get_object(self, originator, name, type, container=None):
@@ -1088,15 +1183,102 @@ class cpl_object:
 		return not ret == S_DUPLICATE_IGNORED
 
 
-	def has_ancestor(self, other):
+	def has_ancestor(self, other, transitive=False):
+		'''
+		Return True if the other object is an immediate ancestor of the
+		object, or an ancestor of any depth if transitive is True.
+		'''
+		bp = CPLDirect.new_intp()
+
+		ret = CPLDirect.cpl_is_ancestor(self.id, VERSION_NONE, other.id,
+		    VERSION_NONE, 1 if transitive else 0, bp)
+		if not CPLDirect.cpl_is_ok(ret):
+			CPLDirect.delete_intp(bp)
+			raise Exception('Error checking ancestry: ' +
+					CPLDirect.cpl_error_string(ret))
+
+		b = CPLDirect.intp_value(bp)
+		CPLDirect.delete_intp(bp)
+		return b != 0
+
+
+	def path_to(self, ancestor, version=None, ancestor_version=None,
+			max_depth=0):
+		'''
+		Return the shortest path from the object to the given ancestor as
+		a list of cpl_ancestor objects, starting at the object, or an empty
+		list if there is no such path. The versions default to the latest
+		version of the object and to the first version of the ancestor.
+		A max_depth of 0 means no limit.
+		'''
+		if version is None:
+			version = VERSION_NONE
+		if ancestor_version is None:
+			ancestor_version = VERSION_NONE
+		vp = CPLDirect.new_std_vector_cpl_ancestry_entry_tp()
+
+		ret = CPLDirect.cpl_find_provenance_path(self.id, version,
+		    ancestor.id, ancestor_version, max_depth,
+		    CPLDirect.cpl_cb_collect_ancestry_vector, vp)
+		if not CPLDirect.cpl_is_ok(ret):
+			CPLDirect.delete_std_vector_cpl_ancestry_entry_tp(vp)
+			raise Exception('Error finding the provenance path: ' +
+					CPLDirect.cpl_error_string(ret))
+
+		v = CPLDirect.cpl_dereference_p_std_vector_cpl_ancestry_entry_t(vp)
+		l = []
+		for entry in v:
+			a = cpl_ancestor(entry.other_object_id,
+				entry.other_object_version,
+				entry.query_object_id,
+				entry.query_object_version, entry.type, D_ANCESTORS)
+			l.append(a)
+
+		CPLDirect.delete_std_vector_cpl_ancestry_entry_tp(vp)
+		return l
+
+
+	def contents(self, version=None, recursive=False, fast=False):
 		'''
-		Return True if the other object is an ancestor of the object.
+		Return the list of cpl_object_info of the objects created inside this
+		container (or inside its given version). If recursive = True, include
+		also the contents of the nested containers. If fast = True, then
+		fetch only incomplete information about each object.
 		'''
-		ancestors = self.ancestry()
-		for a in ancestors:
-			if a.ancestor.object == other:
-				return True
-		return False
+		if version is None:
+			version = VERSION_NONE
+		if fast:
+			flags = CPLDirect.CPL_I_FAST
+		else:
+			flags = 0
+		vp = CPLDirect.new_std_vector_cplxx_object_info_tp()
+
+		ret = CPLDirect.cpl_get_contained_objects(self.id, version,
+				1 if recursive else 0, flags,
+				CPLDirect.cpl_cb_collect_object_info_vector, vp)
+		if ret == S_NO_DATA:
+			CPLDirect.delete_std_vector_cplxx_object_info_tp(vp)
+			return []
+		if not CPLDirect.cpl_is_ok(ret):
+			CPLDirect.delete_std_vector_cplxx_object_info_tp(vp)
+			raise Exception('Error retrieving the contents: ' +
+					CPLDirect.cpl_error_string(ret))
+
+		v = CPLDirect.cpl_dereference_p_std_vector_cplxx_object_info_t(vp)
+		l = []
+		for e in v:
+			container = cpl_object_version(cpl_object(e.container_id),
+					e.container_version)
+			if e.creation_session == NONE:
+				creation_session = None
+			else:
+				creation_session = cpl_session(e.creation_session)
+			l.append(cpl_object_info(cpl_object(e.id), e.version,
+				creation_session, e.creation_time, e.originator,
+				e.name, e.type, container))
+
+		CPLDirect.delete_std_vector_cplxx_object_info_tp(vp)
+		return l
 
 
 	def add_property(self, name, value):
@@ -1175,6 +1357,91 @@ class cpl_object:
 		return l
 
 
+	def lineage(self, version=None, direction=D_ANCESTORS, max_depth=0,
+			flags=0, threads=1):
+		'''
+		Return a list of cpl_ancestor objects for all edges reachable from
+		the object, fetching one level of the graph per database request.
+		A max_depth of 0 means no limit. If threads is not 1, the graph is
+		traversed by that many threads (0 for the default), and the edges
+		are not returned in the breadth-first order.
+		'''
+		if version is None:
+			version = VERSION_NONE
+		vp = CPLDirect.new_std_vector_cpl_ancestry_entry_tp()
+
+		if threads == 1:
+			ret = CPLDirect.cpl_get_object_lineage(self.id, version,
+			    direction, max_depth, flags,
+			    CPLDirect.cpl_cb_collect_ancestry_vector, vp)
+		else:
+			ret = CPLDirect.cpl_get_object_lineage_parallel(self.id,
+			    version, direction, max_depth, flags, threads,
+			    CPLDirect.cpl_cb_collect_ancestry_vector, vp)
+		if not CPLDirect.cpl_is_ok(ret):
+			CPLDirect.delete_std_vector_cpl_ancestry_entry_tp(vp)
+			raise Exception('Error retrieving lineage: ' +
+					CPLDirect.cpl_error_string(ret))
+
+		v = CPLDirect.cpl_dereference_p_std_vector_cpl_ancestry_entry_t(vp)
+		l = []
+		if direction == D_ANCESTORS:
+			for entry in v:
+				a = cpl_ancestor(entry.other_object_id,
+					entry.other_object_version,
+					entry.query_object_id,
+					entry.query_object_version, entry.type, direction)
+				l.append(a)
+		else:
+			for entry in v:
+				a = cpl_ancestor(entry.query_object_id,
+					entry.query_object_version,
+					entry.other_object_id,
+					entry.other_object_version, entry.type, direction)
+				l.append(a)
+
+		CPLDirect.delete_std_vector_cpl_ancestry_entry_tp(vp)
+		return l
+
+
+	def transitive_ancestry(self, version=None, direction=D_ANCESTORS):
+		'''
+		Return a list of cpl_ancestor objects connecting the object with
+		each of its transitive ancestors or descendants, which is fetched
+		using a single lookup if the database maintains the ancestry closure.
+		'''
+		if version is None:
+			version = VERSION_NONE
+		vp = CPLDirect.new_std_vector_cpl_ancestry_entry_tp()
+
+		ret = CPLDirect.cpl_get_transitive_ancestry(self.id, version,
+		    direction, CPLDirect.cpl_cb_collect_ancestry_vector, vp)
+		if not CPLDirect.cpl_is_ok(ret):
+			CPLDirect.delete_std_vector_cpl_ancestry_entry_tp(vp)
+			raise Exception('Error retrieving transitive ancestry: ' +
+					CPLDirect.cpl_error_string(ret))
+
+		v = CPLDirect.cpl_dereference_p_std_vector_cpl_ancestry_entry_t(vp)
+		l = []
+		if direction == D_ANCESTORS:
+			for entry in v:
+				a = cpl_ancestor(entry.other_object_id,
+					entry.other_object_version,
+					entry.query_object_id,
+					entry.query_object_version, entry.type, direction)
+				l.append(a)
+		else:
+			for entry in v:
+				a = cpl_ancestor(entry.query_object_id,
+					entry.query_object_version,
+					entry.other_object_id,
+					entry.other_object_version, entry.type, direction)
+				l.append(a)
+
+		CPLDirect.delete_std_vector_cpl_ancestry_entry_tp(vp)
+		return l
+
+
 	def properties(self, key=None, version=None):
 		'''
 		Return all the properties associated with the current object.
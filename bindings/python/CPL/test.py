@@ -201,6 +201,28 @@ for t in all_objects:
 		print '  ... (' + str(len(all_objects)) + ' objects total)'
 		break
 
+print 'Objects with originator ' + originator + ' (lazy, batches of 2)'
+lazy_ids = [t.object.id for t in c.iter_objects(originator, batch_size=2)]
+for o in [o1, o2, o3, o4, o5]:
+	if o.id not in lazy_ids:
+		print 'ERROR: iter_objects is missing an object'
+		sys.exit(1)
+if len(lazy_ids) != len(set([str(x) for x in lazy_ids])):
+	print 'ERROR: iter_objects returned a duplicate object'
+	sys.exit(1)
+
+print 'Versions created by this session'
+activity = c.get_session_activity(c.session)
+activity_ids = [str(v.object_version.object.id) for v in activity]
+for o in [o1, o2, o3, o4, o5]:
+	if str(o.id) not in activity_ids:
+		print 'ERROR: get_session_activity is missing an object'
+		sys.exit(1)
+if len(c.get_versions_in_range(activity[0].creation_time,
+		activity[-1].creation_time)) < len(activity):
+	print 'ERROR: get_versions_in_range is missing a version'
+	sys.exit(1)
+
 
 # Dependencies
 print
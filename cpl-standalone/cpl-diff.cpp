@@ -0,0 +1,806 @@
+/*
+ * cpl-diff.cpp
+ * Core Provenance Library
+ *
+ * Copyright 2011
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#include "stdafx.h"
+#include "cpl-diff.h"
+
+#include <cpl-file.h>
+
+#include <algorithm>
+
+
+/***************************************************************************/
+/** Helpers                                                               **/
+/***************************************************************************/
+
+/**
+ * The initial value of the FNV-1a hash
+ */
+#define CPL_DIFF_HASH_INIT				0xcbf29ce484222325ULL
+
+/**
+ * The FNV-1a prime
+ */
+#define CPL_DIFF_HASH_PRIME				0x100000001b3ULL
+
+
+/**
+ * Add an integer to a hash
+ *
+ * @param h the hash
+ * @param x the integer
+ * @return the new hash
+ */
+static unsigned long long
+cpl_diff_hash_int(unsigned long long h, const unsigned long long x)
+{
+	for (int i = 0; i < 64; i += 8) {
+		h ^= (x >> i) & 0xff;
+		h *= CPL_DIFF_HASH_PRIME;
+	}
+	return h;
+}
+
+
+/**
+ * Add a string to a hash
+ *
+ * @param h the hash
+ * @param s the string
+ * @return the new hash
+ */
+static unsigned long long
+cpl_diff_hash_string(unsigned long long h, const std::string& s)
+{
+	h = cpl_diff_hash_int(h, s.size());
+	for (size_t i = 0; i < s.size(); i++) {
+		h ^= (unsigned char) s[i];
+		h *= CPL_DIFF_HASH_PRIME;
+	}
+	return h;
+}
+
+
+/**
+ * Add a sorted list of integers to a hash
+ *
+ * @param h the hash
+ * @param l the list, which will be sorted
+ * @return the new hash
+ */
+static unsigned long long
+cpl_diff_hash_list(unsigned long long h, std::vector<unsigned long long>& l)
+{
+	std::sort(l.begin(), l.end());
+	h = cpl_diff_hash_int(h, l.size());
+	for (size_t i = 0; i < l.size(); i++) h = cpl_diff_hash_int(h, l[i]);
+	return h;
+}
+
+
+/**
+ * Create the key used to align the objects
+ *
+ * @param originator the object originator
+ * @param name the object name
+ * @param type the object type
+ * @return the key
+ */
+static std::string
+cpl_diff_key(const std::string& originator, const std::string& name,
+			 const std::string& type)
+{
+	std::string key = originator;
+	key += '\0';
+	key += name;
+	key += '\0';
+	key += type;
+	return key;
+}
+
+
+
+/***************************************************************************/
+/** Constructor and Destructor                                            **/
+/***************************************************************************/
+
+/**
+ * Create the diff
+ *
+ * @param backend the database backend
+ */
+CPLLineageDiff::CPLLineageDiff(cpl_db_backend_t* backend)
+{
+	m_backend = backend;
+	m_iterator = NULL;
+	m_context = NULL;
+	m_found = false;
+}
+
+
+/**
+ * Destroy the diff
+ */
+CPLLineageDiff::~CPLLineageDiff(void)
+{
+}
+
+
+
+/***************************************************************************/
+/** Fetching the Lineage                                                  **/
+/***************************************************************************/
+
+/**
+ * Get the node of an object, creating it if necessary, and record a newly
+ * reached version node
+ *
+ * @param ctx the fetch context
+ * @param id the object ID
+ * @param version the object version
+ * @return the node
+ */
+CPLLineageDiff::node_t*
+CPLLineageDiff::visit(fetch_context_t* ctx, const cpl_id_t id,
+					  const cpl_version_t version)
+{
+	node_map_t::iterator i = ctx->side->nodes.find(id);
+	if (i == ctx->side->nodes.end()) {
+		node_t n;
+		n.id = id;
+		n.version = version;
+		n.key_hash = 0;
+		n.hash = 0;
+		n.inputs_hash = 0;
+		n.index = -1;
+		n.lowlink = -1;
+		n.on_stack = false;
+		i = ctx->side->nodes.insert(std::make_pair(id, n)).first;
+	}
+	else if (i->second.version < version) {
+		i->second.version = version;
+	}
+
+	if (ctx->visited.insert(std::make_pair(id, version)).second) {
+		cpl_id_version_t e;
+		e.id = id;
+		e.version = version;
+		ctx->next.push_back(e);
+	}
+
+	return &i->second;
+}
+
+
+/**
+ * The ancestry iterator, which adds an input
+ *
+ * @param query_object_id the ID of the consumer
+ * @param query_object_version the version of the consumer
+ * @param other_object_id the ID of the input
+ * @param other_object_version the version of the input
+ * @param type the type of the dependency
+ * @param context the pointer to fetch_context_t
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+CPLLineageDiff::cb_edge(const cpl_id_t query_object_id,
+						const cpl_version_t query_object_version,
+						const cpl_id_t other_object_id,
+						const cpl_version_t other_object_version,
+						const int type,
+						void* context)
+{
+	fetch_context_t* ctx = (fetch_context_t*) context;
+
+	visit(ctx, other_object_id, other_object_version);
+	if (query_object_id == other_object_id) return CPL_OK;
+
+	node_map_t::iterator i = ctx->side->nodes.find(query_object_id);
+	if (i == ctx->side->nodes.end()) return CPL_E_INTERNAL_ERROR;
+	i->second.inputs.insert(input_t(other_object_id, type));
+
+	return CPL_OK;
+}
+
+
+/**
+ * Fetch the ancestry of one side of the diff
+ *
+ * @param side 0 for the left side, or 1 for the right side
+ * @param roots the version nodes to start from
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+CPLLineageDiff::load(const int side, const std::vector<cpl_id_version_t>& roots)
+{
+	if (side < 0 || side > 1) return CPL_E_INVALID_ARGUMENT;
+
+	side_t& s = m_sides[side];
+	fetch_context_t ctx;
+	ctx.side = &s;
+
+
+	// Add the roots
+
+	std::set<cpl_id_t> root_ids;
+	std::vector<cpl_id_version_t>::const_iterator i;
+	for (i = roots.begin(); i != roots.end(); i++) {
+		visit(&ctx, i->id, i->version);
+		if (root_ids.insert(i->id).second) {
+			s.roots.push_back(input_t(i->id, 0));
+		}
+	}
+
+
+	// Traverse the ancestry one level at a time, following both the
+	// dependencies and the previous versions
+
+	std::vector<cpl_id_version_t> frontier;
+	frontier.swap(ctx.next);
+
+	while (!frontier.empty()) {
+
+		for (i = frontier.begin(); i != frontier.end(); i++) {
+			if (i->version > 0) visit(&ctx, i->id, i->version - 1);
+		}
+
+		cpl_return_t r = m_backend->cpl_db_get_object_ancestry_batch(
+				m_backend, &frontier[0], frontier.size(), CPL_D_ANCESTORS,
+				CPL_A_NO_PREV_NEXT_VERSION, cb_edge, &ctx);
+		if (!CPL_IS_OK(r)) return r;
+
+		frontier.clear();
+		frontier.swap(ctx.next);
+	}
+
+	return fetch_info(s);
+}
+
+
+/**
+ * Fetch the object info and the SHA1 fingerprints of all nodes
+ *
+ * @param side the side
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+CPLLineageDiff::fetch_info(side_t& side)
+{
+	cpl_return_t r;
+
+	std::vector<cpl_id_t> ids;
+	std::vector<node_t*> nodes;
+	for (node_map_t::iterator i = side.nodes.begin();
+			i != side.nodes.end(); i++) {
+		ids.push_back(i->first);
+		nodes.push_back(&i->second);
+	}
+
+
+	// Fetch the object info in batches
+
+	for (size_t b = 0; b < ids.size(); b += CPL_DIFF_BATCH_SIZE) {
+
+		size_t n = ids.size() - b;
+		if (n > CPL_DIFF_BATCH_SIZE) n = CPL_DIFF_BATCH_SIZE;
+
+		std::vector<cpl_object_info_t*> infos(n, (cpl_object_info_t*) NULL);
+		r = cpl_get_object_info_batch(&ids[b], n, &infos[0]);
+		if (!CPL_IS_OK(r)) return r;
+
+		for (size_t i = 0; i < n; i++) {
+			nodes[b + i]->originator = infos[i]->originator;
+			nodes[b + i]->name = infos[i]->name;
+			nodes[b + i]->type = infos[i]->type;
+			cpl_free_object_info(infos[i]);
+		}
+	}
+
+
+	// Fetch the SHA1 fingerprints, which are kept in the properties, so
+	// there is one request per object (they are served from the result
+	// cache if it is enabled)
+
+	std::vector<cplxx_property_entry_t> properties;
+	for (size_t i = 0; i < nodes.size(); i++) {
+
+		properties.clear();
+		r = cpl_get_properties(nodes[i]->id, CPL_VERSION_NONE, CPL_P_SHA1,
+				cpl_cb_collect_properties_vector, &properties);
+		if (!CPL_IS_OK(r)) return r;
+
+		cpl_version_t best = CPL_VERSION_NONE;
+		for (size_t j = 0; j < properties.size(); j++) {
+			if (properties[j].version > nodes[i]->version) continue;
+			if (properties[j].version < best) continue;
+			best = properties[j].version;
+			nodes[i]->sha1 = properties[j].value;
+		}
+	}
+
+	return CPL_OK;
+}
+
+
+
+/***************************************************************************/
+/** Hashing                                                               **/
+/***************************************************************************/
+
+/**
+ * Compute the hashes of all nodes
+ *
+ * @param side the side
+ */
+void
+CPLLineageDiff::compute_hashes(side_t& side)
+{
+	node_map_t::iterator i;
+	std::set<input_t>::const_iterator j;
+
+
+	// Hash the keys
+
+	for (i = side.nodes.begin(); i != side.nodes.end(); i++) {
+		node_t& n = i->second;
+		n.key_hash = cpl_diff_hash_string(CPL_DIFF_HASH_INIT, n.originator);
+		n.key_hash = cpl_diff_hash_string(n.key_hash, n.name);
+		n.key_hash = cpl_diff_hash_string(n.key_hash, n.type);
+	}
+
+
+	// Find the strongly connected components using Tarjan's algorithm. The
+	// components are completed in the reverse topological order, so the
+	// hashes of the components reachable from a component are known by the
+	// time it is completed.
+
+	int counter = 0;
+	std::vector<node_t*> stack;
+	std::vector<std::pair<node_t*, std::set<input_t>::const_iterator> > calls;
+
+	for (i = side.nodes.begin(); i != side.nodes.end(); i++) {
+
+		node_t* s = &i->second;
+		if (s->index >= 0) continue;
+
+		s->index = s->lowlink = counter++;
+		s->on_stack = true;
+		stack.push_back(s);
+		calls.push_back(std::make_pair(s, s->inputs.begin()));
+
+		while (!calls.empty()) {
+
+			node_t* v = calls.back().first;
+
+
+			// Visit the next input
+
+			if (calls.back().second != v->inputs.end()) {
+
+				node_t* w = &side.nodes.find(calls.back().second->first)
+					->second;
+				calls.back().second++;
+
+				if (w->index < 0) {
+					w->index = w->lowlink = counter++;
+					w->on_stack = true;
+					stack.push_back(w);
+					calls.push_back(std::make_pair(w, w->inputs.begin()));
+				}
+				else if (w->on_stack && w->index < v->lowlink) {
+					v->lowlink = w->index;
+				}
+
+				continue;
+			}
+
+
+			// Return from the node
+
+			calls.pop_back();
+			if (!calls.empty() && v->lowlink < calls.back().first->lowlink) {
+				calls.back().first->lowlink = v->lowlink;
+			}
+			if (v->lowlink != v->index) continue;
+
+
+			// Pop the component
+
+			std::set<node_t*> members;
+			node_t* w;
+			do {
+				w = stack.back();
+				stack.pop_back();
+				w->on_stack = false;
+				members.insert(w);
+			}
+			while (w != v);
+
+
+			// Hash each member without the hash of the component, which
+			// covers all members and everything they can reach
+
+			std::vector<unsigned long long> member_hashes;
+			std::vector<unsigned long long> reachable;
+			std::map<node_t*, unsigned long long> own;
+
+			std::set<node_t*>::iterator m;
+			for (m = members.begin(); m != members.end(); m++) {
+
+				std::vector<unsigned long long> inputs;
+				for (j = (*m)->inputs.begin(); j != (*m)->inputs.end(); j++) {
+					node_t* x = &side.nodes.find(j->first)->second;
+					inputs.push_back(cpl_diff_hash_int(x->key_hash,
+								(unsigned long long) j->second));
+					if (members.find(x) == members.end()) {
+						reachable.push_back(x->hash);
+					}
+				}
+
+				unsigned long long h = (*m)->key_hash;
+				h = cpl_diff_hash_string(h, (*m)->sha1);
+				h = cpl_diff_hash_list(h, inputs);
+
+				own[*m] = h;
+				member_hashes.push_back(h);
+			}
+
+			std::sort(reachable.begin(), reachable.end());
+			reachable.erase(std::unique(reachable.begin(), reachable.end()),
+							reachable.end());
+
+			unsigned long long c = cpl_diff_hash_list(CPL_DIFF_HASH_INIT,
+					member_hashes);
+			c = cpl_diff_hash_list(c, reachable);
+
+			for (m = members.begin(); m != members.end(); m++) {
+				(*m)->hash = cpl_diff_hash_int(own[*m], c);
+			}
+		}
+	}
+
+
+	// Hash the inputs of each node
+
+	for (i = side.nodes.begin(); i != side.nodes.end(); i++) {
+		node_t& n = i->second;
+		std::vector<unsigned long long> inputs;
+		for (j = n.inputs.begin(); j != n.inputs.end(); j++) {
+			inputs.push_back(cpl_diff_hash_int(
+						side.nodes.find(j->first)->second.hash,
+						(unsigned long long) j->second));
+		}
+		n.inputs_hash = cpl_diff_hash_list(CPL_DIFF_HASH_INIT, inputs);
+	}
+}
+
+
+
+/***************************************************************************/
+/** Comparison                                                            **/
+/***************************************************************************/
+
+/**
+ * Resolve the inputs to their nodes
+ *
+ * @param side the side
+ * @param inputs the inputs
+ * @param out the vector to store the nodes
+ */
+void
+CPLLineageDiff::resolve(side_t& side, const std::vector<input_t>& inputs,
+						std::vector<node_input_t>& out)
+{
+	out.clear();
+	std::vector<input_t>::const_iterator i;
+	for (i = inputs.begin(); i != inputs.end(); i++) {
+		out.push_back(node_input_t(&side.nodes.find(i->first)->second,
+								   i->second));
+	}
+}
+
+
+/**
+ * Compare the two sides
+ *
+ * @param align_roots whether to align the roots with each other, which
+ *                    requires exactly one root object on each side,
+ *                    instead of matching them like the inputs
+ * @param iterator the iterator to be called for each difference
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA if there are no differences, or an error
+ *         code
+ */
+cpl_return_t
+CPLLineageDiff::run(const bool align_roots, cpl_diff_iterator_t iterator,
+					void* context)
+{
+	cpl_return_t r;
+
+	m_iterator = iterator;
+	m_context = context;
+	m_found = false;
+	m_queue.clear();
+	m_scheduled.clear();
+
+	compute_hashes(m_sides[0]);
+	compute_hashes(m_sides[1]);
+
+
+	// Compare the roots
+
+	std::vector<node_input_t> left;
+	std::vector<node_input_t> right;
+	resolve(m_sides[0], m_sides[0].roots, left);
+	resolve(m_sides[1], m_sides[1].roots, right);
+
+	if (align_roots) {
+		if (left.size() != 1 || right.size() != 1) {
+			return CPL_E_INVALID_ARGUMENT;
+		}
+		r = match(NULL, NULL, left[0].first, right[0].first, 0);
+	}
+	else {
+		r = compare(NULL, NULL, left, right);
+	}
+	if (!CPL_IS_OK(r)) return r;
+
+
+	// Compare the inputs of the pairs of nodes that differ, breadth-first
+
+	for (size_t i = 0; i < m_queue.size(); i++) {
+
+		node_t* l = m_queue[i].first;
+		node_t* n = m_queue[i].second;
+
+		resolve(m_sides[0], std::vector<input_t>(l->inputs.begin(),
+					l->inputs.end()), left);
+		resolve(m_sides[1], std::vector<input_t>(n->inputs.begin(),
+					n->inputs.end()), right);
+
+		r = compare(l, n, left, right);
+		if (!CPL_IS_OK(r)) return r;
+	}
+
+	return m_found ? CPL_OK : CPL_S_NO_DATA;
+}
+
+
+/**
+ * Match and compare the inputs of two aligned consumers
+ *
+ * @param left_consumer the left consumer, or NULL for the roots
+ * @param right_consumer the right consumer, or NULL for the roots
+ * @param left the inputs of the left consumer
+ * @param right the inputs of the right consumer
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+CPLLineageDiff::compare(const node_t* left_consumer,
+						const node_t* right_consumer,
+						const std::vector<node_input_t>& left,
+						const std::vector<node_input_t>& right)
+{
+	typedef std::pair<std::vector<node_t*>, std::vector<node_t*> > group_t;
+	typedef std::map<std::pair<std::string, int>, group_t> group_map_t;
+
+	cpl_return_t r;
+	std::vector<node_input_t>::const_iterator i;
+
+
+	// Group the inputs by their originator, name, type, and dependency type
+
+	group_map_t groups;
+	for (i = left.begin(); i != left.end(); i++) {
+		node_t* n = i->first;
+		groups[std::make_pair(cpl_diff_key(n->originator, n->name, n->type),
+				i->second)].first.push_back(n);
+	}
+	for (i = right.begin(); i != right.end(); i++) {
+		node_t* n = i->first;
+		groups[std::make_pair(cpl_diff_key(n->originator, n->name, n->type),
+				i->second)].second.push_back(n);
+	}
+
+
+	// Match the inputs within each group: first the identical ones, then
+	// the ones with the same content, and then the rest in the order of
+	// their IDs
+
+	std::vector<node_input_t> left_over;
+	std::vector<node_input_t> right_over;
+
+	for (group_map_t::iterator g = groups.begin(); g != groups.end(); g++) {
+
+		int type = g->first.second;
+		std::vector<node_t*>& L = g->second.first;
+		std::vector<node_t*>& R = g->second.second;
+		std::vector<bool> l_used(L.size(), false);
+		std::vector<bool> r_used(R.size(), false);
+
+		for (size_t a = 0; a < L.size(); a++) {
+			for (size_t b = 0; b < R.size(); b++) {
+				if (r_used[b] || L[a]->hash != R[b]->hash) continue;
+				l_used[a] = r_used[b] = true;
+				break;
+			}
+		}
+
+		for (size_t a = 0; a < L.size(); a++) {
+			if (l_used[a] || L[a]->sha1.empty()) continue;
+			for (size_t b = 0; b < R.size(); b++) {
+				if (r_used[b] || L[a]->sha1 != R[b]->sha1) continue;
+				l_used[a] = r_used[b] = true;
+				r = match(left_consumer, right_consumer, L[a], R[b], type);
+				if (!CPL_IS_OK(r)) return r;
+				break;
+			}
+		}
+
+		size_t b = 0;
+		for (size_t a = 0; a < L.size(); a++) {
+			if (l_used[a]) continue;
+			while (b < R.size() && r_used[b]) b++;
+			if (b >= R.size()) break;
+			l_used[a] = r_used[b] = true;
+			r = match(left_consumer, right_consumer, L[a], R[b], type);
+			if (!CPL_IS_OK(r)) return r;
+		}
+
+		for (size_t a = 0; a < L.size(); a++) {
+			if (!l_used[a]) left_over.push_back(node_input_t(L[a], type));
+		}
+		for (size_t b = 0; b < R.size(); b++) {
+			if (!r_used[b]) right_over.push_back(node_input_t(R[b], type));
+		}
+	}
+
+
+	// Match the leftovers by their content, and report the rest
+
+	std::vector<bool> r_used(right_over.size(), false);
+
+	for (size_t a = 0; a < left_over.size(); a++) {
+
+		node_t* l = left_over[a].first;
+		int type = left_over[a].second;
+		bool found = false;
+
+		for (size_t b = 0; b < right_over.size() && !l->sha1.empty(); b++) {
+			node_t* n = right_over[b].first;
+			if (r_used[b] || type != right_over[b].second) continue;
+			if (l->sha1 != n->sha1) continue;
+
+			r_used[b] = found = true;
+			r = match(left_consumer, right_consumer, l, n, type);
+			if (!CPL_IS_OK(r)) return r;
+			break;
+		}
+
+		if (!found) {
+			r = report(CPL_DIFF_REMOVED, 0, type, left_consumer,
+					   right_consumer, l, NULL);
+			if (!CPL_IS_OK(r)) return r;
+		}
+	}
+
+	for (size_t b = 0; b < right_over.size(); b++) {
+		if (r_used[b]) continue;
+		r = report(CPL_DIFF_ADDED, 0, right_over[b].second, left_consumer,
+				   right_consumer, NULL, right_over[b].first);
+		if (!CPL_IS_OK(r)) return r;
+	}
+
+	return CPL_OK;
+}
+
+
+/**
+ * Compare two aligned inputs, and schedule the comparison of their own
+ * inputs if they differ
+ *
+ * @param left_consumer the left consumer, or NULL for the roots
+ * @param right_consumer the right consumer, or NULL for the roots
+ * @param left the left input
+ * @param right the right input
+ * @param type the dependency type
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+CPLLineageDiff::match(const node_t* left_consumer,
+					  const node_t* right_consumer,
+					  node_t* left, node_t* right, const int type)
+{
+	if (left->hash == right->hash) return CPL_OK;
+
+	int changes = 0;
+	if (left->sha1 != right->sha1) changes |= CPL_DIFF_CONTENT;
+	if (left->inputs_hash != right->inputs_hash) changes |= CPL_DIFF_INPUTS;
+	if (left->originator != right->originator || left->name != right->name
+			|| left->type != right->type) {
+		changes |= CPL_DIFF_RENAMED;
+	}
+	if (changes == 0) return CPL_OK;
+
+	cpl_return_t r = report(CPL_DIFF_CHANGED, changes, type, left_consumer,
+							right_consumer, left, right);
+	if (!CPL_IS_OK(r)) return r;
+
+	if ((changes & CPL_DIFF_INPUTS) != 0
+			&& m_scheduled.insert(std::make_pair(left->id, right->id)).second) {
+		m_queue.push_back(std::make_pair(left, right));
+	}
+
+	return CPL_OK;
+}
+
+
+/**
+ * Report a difference
+ *
+ * @param kind the kind of the difference
+ * @param changes the changes
+ * @param type the dependency type
+ * @param left_consumer the left consumer, or NULL for the roots
+ * @param right_consumer the right consumer, or NULL for the roots
+ * @param left the left input, or NULL if added
+ * @param right the right input, or NULL if removed
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+CPLLineageDiff::report(const int kind, const int changes, const int type,
+					   const node_t* left_consumer,
+					   const node_t* right_consumer,
+					   const node_t* left, const node_t* right)
+{
+	const node_t* n = right != NULL ? right : left;
+
+	cpl_diff_entry_t e;
+	e.kind = kind;
+	e.changes = changes;
+	e.dependency_type = type;
+	e.left_consumer = left_consumer == NULL ? CPL_NONE : left_consumer->id;
+	e.right_consumer = right_consumer == NULL ? CPL_NONE : right_consumer->id;
+	e.left_id = left == NULL ? CPL_NONE : left->id;
+	e.left_version = left == NULL ? CPL_VERSION_NONE : left->version;
+	e.right_id = right == NULL ? CPL_NONE : right->id;
+	e.right_version = right == NULL ? CPL_VERSION_NONE : right->version;
+	e.originator = n->originator.c_str();
+	e.name = n->name.c_str();
+	e.type = n->type.c_str();
+
+	m_found = true;
+	return m_iterator(&e, m_context);
+}
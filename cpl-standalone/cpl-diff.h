@@ -0,0 +1,364 @@
+/*
+ * cpl-diff.h
+ * Core Provenance Library
+ *
+ * Copyright 2011
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#ifndef __CPL_DIFF_H__
+#define __CPL_DIFF_H__
+
+#include <cplxx.h>
+#include <cpl-db-backend.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+
+/***************************************************************************/
+/** Constants                                                             **/
+/***************************************************************************/
+
+/**
+ * The maximum number of objects in a single batched request for their
+ * information
+ */
+#define CPL_DIFF_BATCH_SIZE				256
+
+
+
+/***************************************************************************/
+/** Lineage Diff                                                          **/
+/***************************************************************************/
+
+/**
+ * A comparison of the ancestries of two sets of version nodes.
+ *
+ * Each side is fetched one level at a time using batched backend calls,
+ * and all versions of an object that are reached are merged into a single
+ * node, so that the inputs of a process are compared as a whole, even
+ * though each of them was added in a different version. The resulting
+ * object graph might contain cycles, so its strongly connected components
+ * are found using Tarjan's algorithm, and each node is assigned a hash of
+ * its originator, name, type, SHA1 fingerprint, and of everything it can
+ * reach. Two nodes with the same hash thus have identical ancestries, and
+ * the comparison does not descend into them.
+ *
+ * The comparison starts from the roots and proceeds breadth-first through
+ * the pairs of aligned nodes whose inputs differ. The inputs of such a pair
+ * are matched by their originator, name, type, and dependency type, then
+ * among the leftovers by their SHA1 fingerprints, and whatever remains is
+ * reported as added or removed.
+ */
+class CPLLineageDiff
+{
+
+public:
+
+	/**
+	 * Create the diff
+	 *
+	 * @param backend the database backend
+	 */
+	CPLLineageDiff(cpl_db_backend_t* backend);
+
+	/**
+	 * Destroy the diff
+	 */
+	~CPLLineageDiff(void);
+
+	/**
+	 * Fetch the ancestry of one side of the diff
+	 *
+	 * @param side 0 for the left side, or 1 for the right side
+	 * @param roots the version nodes to start from
+	 * @return CPL_OK or an error code
+	 */
+	cpl_return_t
+	load(const int side, const std::vector<cpl_id_version_t>& roots);
+
+	/**
+	 * Compare the two sides
+	 *
+	 * @param align_roots whether to align the roots with each other, which
+	 *                    requires exactly one root object on each side,
+	 *                    instead of matching them like the inputs
+	 * @param iterator the iterator to be called for each difference
+	 * @param context the caller-provided iterator context
+	 * @return CPL_OK, CPL_S_NO_DATA if there are no differences, or an error
+	 *         code
+	 */
+	cpl_return_t
+	run(const bool align_roots, cpl_diff_iterator_t iterator, void* context);
+
+
+protected:
+
+	/**
+	 * The hash value
+	 */
+	typedef unsigned long long hash_t;
+
+	/**
+	 * An input: the object ID and the dependency type
+	 */
+	typedef std::pair<cpl_id_t, int> input_t;
+
+	/**
+	 * An object node
+	 */
+	typedef struct {
+
+		/// The object ID
+		cpl_id_t id;
+
+		/// The latest version reached by the traversal
+		cpl_version_t version;
+
+		/// The object originator
+		std::string originator;
+
+		/// The object name
+		std::string name;
+
+		/// The object type
+		std::string type;
+
+		/// The SHA1 fingerprint of the latest version reached by the
+		/// traversal, or empty if none
+		std::string sha1;
+
+		/// The inputs of all versions reached by the traversal
+		std::set<input_t> inputs;
+
+		/// The hash of the originator, name, and type
+		hash_t key_hash;
+
+		/// The hash of the node and everything it can reach
+		hash_t hash;
+
+		/// The hash of the inputs and everything they can reach
+		hash_t inputs_hash;
+
+		/// Tarjan's algorithm: the discovery index, or -1 if not visited
+		int index;
+
+		/// Tarjan's algorithm: the smallest reachable discovery index
+		int lowlink;
+
+		/// Tarjan's algorithm: whether the node is on the stack
+		bool on_stack;
+
+	} node_t;
+
+	/**
+	 * The map of object nodes
+	 */
+	typedef std::map<cpl_id_t, node_t> node_map_t;
+
+	/**
+	 * One side of the diff
+	 */
+	typedef struct {
+
+		/// The object nodes
+		node_map_t nodes;
+
+		/// The root objects, all with the dependency type 0
+		std::vector<input_t> roots;
+
+	} side_t;
+
+	/**
+	 * An input resolved to its node
+	 */
+	typedef std::pair<node_t*, int> node_input_t;
+
+	/**
+	 * The context of the ancestry callback
+	 */
+	typedef struct {
+
+		/// The side being fetched
+		side_t* side;
+
+		/// The visited version nodes
+		std::set<std::pair<cpl_id_t, cpl_version_t> > visited;
+
+		/// The next level of the traversal
+		std::vector<cpl_id_version_t> next;
+
+	} fetch_context_t;
+
+	/**
+	 * Get the node of an object, creating it if necessary, and record
+	 * a newly reached version node
+	 *
+	 * @param ctx the fetch context
+	 * @param id the object ID
+	 * @param version the object version
+	 * @return the node
+	 */
+	static node_t*
+	visit(fetch_context_t* ctx, const cpl_id_t id,
+		  const cpl_version_t version);
+
+	/**
+	 * The ancestry iterator, which adds an input
+	 *
+	 * @param query_object_id the ID of the consumer
+	 * @param query_object_version the version of the consumer
+	 * @param other_object_id the ID of the input
+	 * @param other_object_version the version of the input
+	 * @param type the type of the dependency
+	 * @param context the pointer to fetch_context_t
+	 * @return CPL_OK or an error code
+	 */
+	static cpl_return_t
+	cb_edge(const cpl_id_t query_object_id,
+			const cpl_version_t query_object_version,
+			const cpl_id_t other_object_id,
+			const cpl_version_t other_object_version,
+			const int type,
+			void* context);
+
+	/**
+	 * Fetch the object info and the SHA1 fingerprints of all nodes
+	 *
+	 * @param side the side
+	 * @return CPL_OK or an error code
+	 */
+	cpl_return_t
+	fetch_info(side_t& side);
+
+	/**
+	 * Compute the hashes of all nodes
+	 *
+	 * @param side the side
+	 */
+	void
+	compute_hashes(side_t& side);
+
+	/**
+	 * Resolve the inputs to their nodes
+	 *
+	 * @param side the side
+	 * @param inputs the inputs
+	 * @param out the vector to store the nodes
+	 */
+	void
+	resolve(side_t& side, const std::vector<input_t>& inputs,
+			std::vector<node_input_t>& out);
+
+	/**
+	 * Match and compare the inputs of two aligned consumers
+	 *
+	 * @param left_consumer the left consumer, or NULL for the roots
+	 * @param right_consumer the right consumer, or NULL for the roots
+	 * @param left the inputs of the left consumer
+	 * @param right the inputs of the right consumer
+	 * @return CPL_OK or an error code
+	 */
+	cpl_return_t
+	compare(const node_t* left_consumer, const node_t* right_consumer,
+			const std::vector<node_input_t>& left,
+			const std::vector<node_input_t>& right);
+
+	/**
+	 * Compare two aligned inputs, and schedule the comparison of their own
+	 * inputs if they differ
+	 *
+	 * @param left_consumer the left consumer, or NULL for the roots
+	 * @param right_consumer the right consumer, or NULL for the roots
+	 * @param left the left input
+	 * @param right the right input
+	 * @param type the dependency type
+	 * @return CPL_OK or an error code
+	 */
+	cpl_return_t
+	match(const node_t* left_consumer, const node_t* right_consumer,
+		  node_t* left, node_t* right, const int type);
+
+	/**
+	 * Report a difference
+	 *
+	 * @param kind the kind of the difference
+	 * @param changes the changes
+	 * @param type the dependency type
+	 * @param left_consumer the left consumer, or NULL for the roots
+	 * @param right_consumer the right consumer, or NULL for the roots
+	 * @param left the left input, or NULL if added
+	 * @param right the right input, or NULL if removed
+	 * @return CPL_OK or an error code
+	 */
+	cpl_return_t
+	report(const int kind, const int changes, const int type,
+		   const node_t* left_consumer, const node_t* right_consumer,
+		   const node_t* left, const node_t* right);
+
+	/**
+	 * The database backend
+	 */
+	cpl_db_backend_t* m_backend;
+
+	/**
+	 * The two sides
+	 */
+	side_t m_sides[2];
+
+	/**
+	 * The pairs of nodes whose inputs are scheduled for comparison
+	 */
+	std::vector<std::pair<node_t*, node_t*> > m_queue;
+
+	/**
+	 * The pairs of nodes that have already been scheduled
+	 */
+	std::set<std::pair<cpl_id_t, cpl_id_t> > m_scheduled;
+
+	/**
+	 * The iterator
+	 */
+	cpl_diff_iterator_t m_iterator;
+
+	/**
+	 * The iterator context
+	 */
+	void* m_context;
+
+	/**
+	 * Whether any difference has been reported
+	 */
+	bool m_found;
+};
+
+#endif
@@ -0,0 +1,494 @@
+/*
+ * cpl-lineage.cpp
+ * Core Provenance Library
+ *
+ * Copyright 2011
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#include "stdafx.h"
+#include "cpl-lineage.h"
+
+
+/***************************************************************************/
+/** Constructor and Destructor                                            **/
+/***************************************************************************/
+
+/**
+ * Create the traversal
+ *
+ * @param backend the database backend
+ * @param direction CPL_D_ANCESTORS or CPL_D_DESCENDANTS
+ * @param max_depth the maximum depth, or 0 for no limit
+ * @param flags a logical combination of the CPL_A_* flags
+ * @param num_threads the number of worker threads
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator
+ */
+CPLParallelLineage::CPLParallelLineage(cpl_db_backend_t* backend,
+									   const int direction,
+									   const int max_depth,
+									   const int flags,
+									   const int num_threads,
+									   cpl_ancestry_iterator_t iterator,
+									   void* context)
+{
+	m_backend = backend;
+	m_direction = direction;
+	m_max_depth = max_depth;
+	m_flags = flags;
+	m_iterator = iterator;
+	m_context = context;
+
+	m_found = false;
+	m_outstanding = 0;
+	m_available = 0;
+	m_error = CPL_OK;
+
+	mutex_init(m_sink_lock);
+	mutex_init(m_lock);
+	cond_init(m_cond);
+
+	for (int i = 0; i < CPL_LINEAGE_VISITED_SHARDS; i++) {
+		mutex_init(m_shards[i].lock);
+	}
+
+	for (int i = 0; i < num_threads; i++) {
+		worker_t* w = new worker_t;
+		w->lineage = this;
+		w->index = i;
+		w->started = false;
+		w->task = NULL;
+		mutex_init(w->lock);
+		m_workers.push_back(w);
+	}
+}
+
+
+/**
+ * Destroy the traversal
+ */
+CPLParallelLineage::~CPLParallelLineage(void)
+{
+	for (size_t i = 0; i < m_workers.size(); i++) {
+		worker_t* w = m_workers[i];
+		for (size_t j = 0; j < w->tasks.size(); j++) delete w->tasks[j];
+		mutex_destroy(w->lock);
+		delete w;
+	}
+
+	for (int i = 0; i < CPL_LINEAGE_VISITED_SHARDS; i++) {
+		mutex_destroy(m_shards[i].lock);
+	}
+
+	cond_destroy(m_cond);
+	mutex_destroy(m_lock);
+	mutex_destroy(m_sink_lock);
+}
+
+
+
+/***************************************************************************/
+/** Traversal                                                             **/
+/***************************************************************************/
+
+/**
+ * Run the traversal. The calling thread acts as one of the workers.
+ *
+ * @param nodes the start nodes
+ * @param version_edges whether to report the version edges of the
+ *                      start nodes
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+cpl_return_t
+CPLParallelLineage::run(const std::vector<cpl_id_version_t>& nodes,
+						const bool version_edges)
+{
+	assert(!m_workers.empty());
+
+
+	// Mark the start nodes as visited and queue them in the first worker,
+	// from which the other workers steal them
+
+	worker_t* first = m_workers[0];
+
+	for (size_t i = 0; i < nodes.size(); i++) {
+		node_state_t st;
+		st.depth = 0;
+		st.expanded = true;
+		shard_t& s = shard(nodes[i].id, nodes[i].version);
+		s.nodes[std::make_pair(nodes[i].id, nodes[i].version)] = st;
+	}
+
+	for (size_t start = 0; start < nodes.size();
+			start += CPL_LINEAGE_TASK_SIZE) {
+		size_t end = start + CPL_LINEAGE_TASK_SIZE;
+		if (end > nodes.size()) end = nodes.size();
+
+		task_t* t = new task_t;
+		t->nodes.assign(nodes.begin() + start, nodes.begin() + end);
+		t->depth = 0;
+		t->report = true;
+		t->version_edges = version_edges;
+
+		first->tasks.push_back(t);
+		m_outstanding++;
+		m_available++;
+	}
+
+
+	// Start the other workers; if a thread cannot be created, the
+	// remaining workers simply do its share of the work
+
+	for (size_t i = 1; i < m_workers.size(); i++) {
+		worker_t* w = m_workers[i];
+		w->started = thread_create(w->thread, thread_main, w);
+	}
+
+	work(first);
+
+	for (size_t i = 1; i < m_workers.size(); i++) {
+		if (m_workers[i]->started) thread_join(m_workers[i]->thread);
+	}
+
+	if (!CPL_IS_OK(m_error)) return m_error;
+	return m_found ? CPL_OK : CPL_S_NO_DATA;
+}
+
+
+/**
+ * The worker thread
+ *
+ * @param arg the pointer to worker_t
+ * @return nothing
+ */
+THREAD_FUNCTION(CPLParallelLineage::thread_main, arg)
+{
+	worker_t* w = (worker_t*) arg;
+	w->lineage->work(w);
+	THREAD_RETURN;
+}
+
+
+/**
+ * Run the worker loop until there is no more work
+ *
+ * @param w the worker
+ */
+void
+CPLParallelLineage::work(worker_t* w)
+{
+	task_t* t;
+
+	while ((t = take(w)) != NULL) {
+
+		w->task = t;
+		cpl_return_t ret = expand(w, t);
+		if (!CPL_IS_OK(ret)) fail(ret);
+
+		w->task = NULL;
+		delete t;
+
+		mutex_lock(m_lock);
+		if (--m_outstanding == 0) cond_broadcast(m_cond);
+		mutex_unlock(m_lock);
+	}
+}
+
+
+/**
+ * Take a task from the worker's own deque or steal one from another
+ * worker, waiting until a task becomes available
+ *
+ * @param w the worker
+ * @return the task, or NULL if the traversal is finished
+ */
+CPLParallelLineage::task_t*
+CPLParallelLineage::take(worker_t* w)
+{
+	size_t n = m_workers.size();
+
+	while (true) {
+		task_t* t = NULL;
+
+
+		// Take the newest task from the worker's own deque, which keeps
+		// the frontier of each worker small
+
+		mutex_lock(w->lock);
+		if (!w->tasks.empty()) {
+			t = w->tasks.back();
+			w->tasks.pop_back();
+		}
+		mutex_unlock(w->lock);
+
+
+		// Otherwise steal the oldest task from another worker, which is
+		// likely to produce the most new work
+
+		for (size_t k = 1; t == NULL && k < n; k++) {
+			worker_t* v = m_workers[(w->index + k) % n];
+			mutex_lock(v->lock);
+			if (!v->tasks.empty()) {
+				t = v->tasks.front();
+				v->tasks.pop_front();
+			}
+			mutex_unlock(v->lock);
+		}
+
+
+		// Wait for more work, or finish if there is none
+
+		mutex_lock(m_lock);
+		if (t != NULL) {
+			m_available--;
+			mutex_unlock(m_lock);
+			return t;
+		}
+
+		while (m_available == 0 && m_outstanding > 0 && CPL_IS_OK(m_error)) {
+			cond_wait(m_cond, m_lock);
+		}
+
+		bool finished = m_outstanding == 0 || !CPL_IS_OK(m_error);
+		mutex_unlock(m_lock);
+
+		if (finished) return NULL;
+	}
+}
+
+
+/**
+ * Expand the nodes of a task
+ *
+ * @param w the worker
+ * @param t the task
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+CPLParallelLineage::expand(worker_t* w, task_t* t)
+{
+	cpl_return_t ret;
+
+
+	// Add the previous or the next versions of the nodes
+
+	if (t->version_edges && (m_flags & CPL_A_NO_PREV_NEXT_VERSION) == 0) {
+		std::vector<cpl_id_version_t>::iterator i;
+		for (i = t->nodes.begin(); i != t->nodes.end(); i++) {
+
+			if (m_direction == CPL_D_ANCESTORS) {
+				if (i->version <= 0) continue;
+				ret = cb_edge(i->id, i->version, i->id, i->version - 1,
+						CPL_VERSION_GENERIC, w);
+				if (!CPL_IS_OK(ret)) return ret;
+			}
+			else {
+				cpl_hash_map_id_t<cpl_version_t>::type::iterator cv
+					= w->current_versions.find(i->id);
+				cpl_version_t c;
+				if (cv == w->current_versions.end()) {
+					ret = cpl_get_version(i->id, &c);
+					if (!CPL_IS_OK(ret)) return ret;
+					w->current_versions[i->id] = c;
+				}
+				else {
+					c = cv->second;
+				}
+
+				if (i->version >= c) continue;
+				ret = cb_edge(i->id, i->version, i->id, i->version + 1,
+						CPL_VERSION_GENERIC, w);
+				if (!CPL_IS_OK(ret)) return ret;
+			}
+		}
+	}
+
+
+	// Fetch the edges of all nodes using a single backend call
+
+	ret = m_backend->cpl_db_get_object_ancestry_batch(m_backend,
+			&t->nodes[0], t->nodes.size(), m_direction,
+			m_flags | CPL_A_NO_PREV_NEXT_VERSION, cb_edge, w);
+	if (!CPL_IS_SUCCESS(ret)) return ret;
+
+
+	// Queue the remaining newly discovered nodes
+
+	if (!w->next_report.empty()) push(w, w->next_report, t->depth + 1, true);
+	if (!w->next_quiet.empty()) push(w, w->next_quiet, t->depth + 1, false);
+
+	return CPL_OK;
+}
+
+
+/**
+ * The callback for the batched backend calls
+ *
+ * @param query_object_id the ID of the expanded object
+ * @param query_object_version the version of the expanded object
+ * @param other_object_id the ID of the object on the other end
+ * @param other_object_version the version of the other object
+ * @param type the type of the dependency
+ * @param context the pointer to worker_t
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+CPLParallelLineage::cb_edge(const cpl_id_t query_object_id,
+							const cpl_version_t query_object_version,
+							const cpl_id_t other_object_id,
+							const cpl_version_t other_object_version,
+							const int type, void* context)
+{
+	worker_t* w = (worker_t*) context;
+	CPLParallelLineage* l = w->lineage;
+
+	if (w->task->report) {
+		mutex_lock(l->m_sink_lock);
+		l->m_found = true;
+		cpl_return_t ret = l->m_iterator(query_object_id, query_object_version,
+				other_object_id, other_object_version, type, l->m_context);
+		mutex_unlock(l->m_sink_lock);
+		if (!CPL_IS_OK(ret)) return ret;
+	}
+
+	l->visit(w, other_object_id, other_object_version, w->task->depth + 1);
+	return CPL_OK;
+}
+
+
+/**
+ * Record a node at the given depth in the visited set, and add it to
+ * the worker's next tasks if it needs to be expanded
+ *
+ * @param w the worker
+ * @param id the object ID
+ * @param version the object version
+ * @param depth the depth
+ */
+void
+CPLParallelLineage::visit(worker_t* w, const cpl_id_t id,
+						  const cpl_version_t version, const int depth)
+{
+	bool expandable = m_max_depth == 0 || depth < m_max_depth;
+	bool queue = false;
+	bool report = true;
+
+	shard_t& s = shard(id, version);
+	std::pair<cpl_id_t, cpl_version_t> n(id, version);
+
+	mutex_lock(s.lock);
+
+	std::map<std::pair<cpl_id_t, cpl_version_t>, node_state_t>::iterator i
+		= s.nodes.find(n);
+	if (i == s.nodes.end()) {
+		node_state_t st;
+		st.depth = depth;
+		st.expanded = expandable;
+		s.nodes[n] = st;
+		queue = expandable;
+	}
+	else if (m_max_depth > 0 && depth < i->second.depth) {
+
+		// The node was reached through a shorter path, so its subgraph
+		// might now extend deeper before hitting the depth limit
+
+		i->second.depth = depth;
+		if (expandable) {
+			report = !i->second.expanded;
+			i->second.expanded = true;
+			queue = true;
+		}
+	}
+
+	mutex_unlock(s.lock);
+
+	if (!queue) return;
+
+	cpl_id_version_t e;
+	e.id = id;
+	e.version = version;
+
+	std::vector<cpl_id_version_t>& next
+		= report ? w->next_report : w->next_quiet;
+	next.push_back(e);
+	if (next.size() >= CPL_LINEAGE_TASK_SIZE) push(w, next, depth, report);
+}
+
+
+/**
+ * Turn the given nodes into a task and push it to the worker's deque
+ *
+ * @param w the worker
+ * @param nodes the nodes (will be cleared)
+ * @param depth the depth of the nodes
+ * @param report whether to report the edges of the nodes
+ */
+void
+CPLParallelLineage::push(worker_t* w, std::vector<cpl_id_version_t>& nodes,
+						 const int depth, const bool report)
+{
+	task_t* t = new task_t;
+	t->nodes.swap(nodes);
+	t->depth = depth;
+	t->report = report;
+	t->version_edges = true;
+
+
+	// Count the task before publishing it, so that the count of the
+	// outstanding tasks cannot drop to zero while the task is in flight
+
+	mutex_lock(m_lock);
+	m_outstanding++;
+	m_available++;
+	mutex_unlock(m_lock);
+
+	mutex_lock(w->lock);
+	w->tasks.push_back(t);
+	mutex_unlock(w->lock);
+
+	mutex_lock(m_lock);
+	cond_broadcast(m_cond);
+	mutex_unlock(m_lock);
+}
+
+
+/**
+ * Record an error and stop the traversal
+ *
+ * @param ret the error code
+ */
+void
+CPLParallelLineage::fail(const cpl_return_t ret)
+{
+	mutex_lock(m_lock);
+	if (CPL_IS_OK(m_error)) m_error = ret;
+	cond_broadcast(m_cond);
+	mutex_unlock(m_lock);
+}
@@ -0,0 +1,406 @@
+/*
+ * cpl-lineage.h
+ * Core Provenance Library
+ *
+ * Copyright 2011
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#ifndef __CPL_LINEAGE_H__
+#define __CPL_LINEAGE_H__
+
+#include <cplxx.h>
+#include <cpl-db-backend.h>
+#include <private/cpl-platform.h>
+
+#include <deque>
+#include <map>
+#include <vector>
+
+
+/***************************************************************************/
+/** Constants                                                             **/
+/***************************************************************************/
+
+/**
+ * The number of worker threads if the caller does not specify it
+ */
+#define CPL_LINEAGE_DEFAULT_THREADS		8
+
+/**
+ * The maximum number of worker threads
+ */
+#define CPL_LINEAGE_MAX_THREADS			64
+
+/**
+ * The maximum number of version nodes in a single task, and thus in
+ * a single batched backend call. Smaller tasks spread a wide frontier
+ * across more threads at the cost of more round trips.
+ */
+#define CPL_LINEAGE_TASK_SIZE			32
+
+/**
+ * The number of independently locked partitions of the visited set
+ */
+#define CPL_LINEAGE_VISITED_SHARDS		64
+
+
+
+/***************************************************************************/
+/** Parallel Lineage Traversal                                            **/
+/***************************************************************************/
+
+/**
+ * A parallel traversal of the ancestors or the descendants of a set of
+ * version nodes, which returns the same edges as cpl_get_object_lineage(),
+ * but not in the breadth-first order.
+ *
+ * The frontier is split into tasks of at most CPL_LINEAGE_TASK_SIZE nodes
+ * each. Every worker keeps its own deque of tasks, takes the newest task
+ * from its back, and when it runs out of work, it steals the oldest task
+ * from the front of another worker's deque. Each task is expanded using
+ * a single batched backend call, so several calls run at the same time;
+ * the backend must be thread-safe, and it benefits from the traversal if
+ * it can serve concurrent calls, such as the RDF backend with its pool of
+ * connection handles.
+ *
+ * The visited set is keyed by the version node and is partitioned into
+ * CPL_LINEAGE_VISITED_SHARDS independently locked shards. It records the
+ * smallest known depth of each node, so that if a node is reached through
+ * a shorter path after it has been expanded, its descendants are revisited
+ * without reporting their edges again, which keeps the depth limit exact.
+ *
+ * The edges are passed to the iterator one at a time while holding a lock,
+ * so the iterator does not need to be thread-safe, but it is called from
+ * the worker threads.
+ */
+class CPLParallelLineage
+{
+
+public:
+
+	/**
+	 * Create the traversal
+	 *
+	 * @param backend the database backend
+	 * @param direction CPL_D_ANCESTORS or CPL_D_DESCENDANTS
+	 * @param max_depth the maximum depth, or 0 for no limit
+	 * @param flags a logical combination of the CPL_A_* flags
+	 * @param num_threads the number of worker threads
+	 * @param iterator the iterator callback function
+	 * @param context the user context to be passed to the iterator
+	 */
+	CPLParallelLineage(cpl_db_backend_t* backend, const int direction,
+					   const int max_depth, const int flags,
+					   const int num_threads,
+					   cpl_ancestry_iterator_t iterator, void* context);
+
+	/**
+	 * Destroy the traversal
+	 */
+	~CPLParallelLineage(void);
+
+	/**
+	 * Run the traversal. The calling thread acts as one of the workers.
+	 *
+	 * @param nodes the start nodes
+	 * @param version_edges whether to report the version edges of the
+	 *                      start nodes
+	 * @return CPL_OK, CPL_S_NO_DATA, or an error code
+	 */
+	cpl_return_t
+	run(const std::vector<cpl_id_version_t>& nodes, const bool version_edges);
+
+
+protected:
+
+	/**
+	 * A unit of work
+	 */
+	typedef struct {
+
+		/// The version nodes to expand
+		std::vector<cpl_id_version_t> nodes;
+
+		/// The depth of the nodes
+		int depth;
+
+		/// Whether to pass the edges to the iterator (false if the nodes
+		/// have already been expanded through a longer path)
+		bool report;
+
+		/// Whether to add the previous or the next versions of the nodes
+		bool version_edges;
+
+	} task_t;
+
+	/**
+	 * A worker
+	 */
+	typedef struct {
+
+		/// The traversal
+		CPLParallelLineage* lineage;
+
+		/// The worker number
+		int index;
+
+		/// The thread (unused by the calling thread)
+		thread_t thread;
+
+		/// Whether the thread has been started
+		bool started;
+
+		/// The lock for the task deque
+		mutex_t lock;
+
+		/// The tasks
+		std::deque<task_t*> tasks;
+
+		/// The task being processed
+		task_t* task;
+
+		/// The newly discovered nodes to report
+		std::vector<cpl_id_version_t> next_report;
+
+		/// The rediscovered nodes to expand without reporting
+		std::vector<cpl_id_version_t> next_quiet;
+
+		/// The cached current versions of objects
+		cpl_hash_map_id_t<cpl_version_t>::type current_versions;
+
+	} worker_t;
+
+	/**
+	 * The state of a visited node
+	 */
+	typedef struct {
+
+		/// The smallest known depth
+		int depth;
+
+		/// Whether the node has been queued for expansion
+		bool expanded;
+
+	} node_state_t;
+
+	/**
+	 * A partition of the visited set
+	 */
+	typedef struct {
+
+		/// The lock
+		mutex_t lock;
+
+		/// The visited nodes
+		std::map<std::pair<cpl_id_t, cpl_version_t>, node_state_t> nodes;
+
+	} shard_t;
+
+	/**
+	 * Get the partition of the visited set for the given node
+	 *
+	 * @param id the object ID
+	 * @param version the object version
+	 * @return the shard
+	 */
+	inline shard_t&
+	shard(const cpl_id_t id, const cpl_version_t version)
+	{
+		return m_shards[(id.hi ^ id.lo ^ (unsigned long long) version)
+			% CPL_LINEAGE_VISITED_SHARDS];
+	}
+
+	/**
+	 * The worker thread
+	 *
+	 * @param arg the pointer to worker_t
+	 * @return nothing
+	 */
+	static THREAD_FUNCTION(thread_main, arg);
+
+	/**
+	 * The callback for the batched backend calls
+	 *
+	 * @param query_object_id the ID of the expanded object
+	 * @param query_object_version the version of the expanded object
+	 * @param other_object_id the ID of the object on the other end
+	 * @param other_object_version the version of the other object
+	 * @param type the type of the dependency
+	 * @param context the pointer to worker_t
+	 * @return CPL_OK or an error code
+	 */
+	static cpl_return_t
+	cb_edge(const cpl_id_t query_object_id,
+			const cpl_version_t query_object_version,
+			const cpl_id_t other_object_id,
+			const cpl_version_t other_object_version,
+			const int type, void* context);
+
+	/**
+	 * Run the worker loop until there is no more work
+	 *
+	 * @param w the worker
+	 */
+	void
+	work(worker_t* w);
+
+	/**
+	 * Take a task from the worker's own deque or steal one from another
+	 * worker, waiting until a task becomes available
+	 *
+	 * @param w the worker
+	 * @return the task, or NULL if the traversal is finished
+	 */
+	task_t*
+	take(worker_t* w);
+
+	/**
+	 * Expand the nodes of a task
+	 *
+	 * @param w the worker
+	 * @param t the task
+	 * @return CPL_OK or an error code
+	 */
+	cpl_return_t
+	expand(worker_t* w, task_t* t);
+
+	/**
+	 * Record a node at the given depth in the visited set, and add it to
+	 * the worker's next tasks if it needs to be expanded
+	 *
+	 * @param w the worker
+	 * @param id the object ID
+	 * @param version the object version
+	 * @param depth the depth
+	 */
+	void
+	visit(worker_t* w, const cpl_id_t id, const cpl_version_t version,
+		  const int depth);
+
+	/**
+	 * Turn the given nodes into a task and push it to the worker's deque
+	 *
+	 * @param w the worker
+	 * @param nodes the nodes (will be cleared)
+	 * @param depth the depth of the nodes
+	 * @param report whether to report the edges of the nodes
+	 */
+	void
+	push(worker_t* w, std::vector<cpl_id_version_t>& nodes, const int depth,
+		 const bool report);
+
+	/**
+	 * Record an error and stop the traversal
+	 *
+	 * @param ret the error code
+	 */
+	void
+	fail(const cpl_return_t ret);
+
+
+protected:
+
+	/**
+	 * The database backend
+	 */
+	cpl_db_backend_t* m_backend;
+
+	/**
+	 * The direction of the traversal
+	 */
+	int m_direction;
+
+	/**
+	 * The maximum depth, or 0 for no limit
+	 */
+	int m_max_depth;
+
+	/**
+	 * The traversal flags
+	 */
+	int m_flags;
+
+	/**
+	 * The user-provided iterator
+	 */
+	cpl_ancestry_iterator_t m_iterator;
+
+	/**
+	 * The user-provided context
+	 */
+	void* m_context;
+
+	/**
+	 * The workers
+	 */
+	std::vector<worker_t*> m_workers;
+
+	/**
+	 * The partitions of the visited set
+	 */
+	shard_t m_shards[CPL_LINEAGE_VISITED_SHARDS];
+
+	/**
+	 * The lock for the iterator
+	 */
+	mutex_t m_sink_lock;
+
+	/**
+	 * Whether the iterator has been called at least once
+	 */
+	bool m_found;
+
+	/**
+	 * The lock for the scheduling state below
+	 */
+	mutex_t m_lock;
+
+	/**
+	 * The condition signaled when a task is pushed or the traversal ends
+	 */
+	cond_t m_cond;
+
+	/**
+	 * The number of tasks that are queued or being processed
+	 */
+	size_t m_outstanding;
+
+	/**
+	 * The number of tasks in the deques
+	 */
+	size_t m_available;
+
+	/**
+	 * The first error, or CPL_OK
+	 */
+	cpl_return_t m_error;
+};
+
+#endif
@@ -90,6 +90,49 @@ typedef cpl_hash_map_id_t<cpl_open_object_t*>::type
 	cpl_hash_map_id_to_open_object_t;
 
 
+/**
+ * The kind of a cursor
+ */
+#define CPL_CURSOR_OBJECTS			1
+
+
+/**
+ * State of a cursor (cpl_cursor_t)
+ */
+struct cpl_cursor {
+
+	/**
+	 * The cursor kind (CPL_CURSOR_*)
+	 */
+	int kind;
+
+	/**
+	 * A logical combination of CPL_I_* flags
+	 */
+	int flags;
+
+	/**
+	 * The originator filter, or NULL for any
+	 */
+	char* originator;
+
+	/**
+	 * The type filter, or NULL for any
+	 */
+	char* type;
+
+	/**
+	 * The ID of the last returned object, or CPL_NONE if none
+	 */
+	cpl_id_t last;
+
+	/**
+	 * Whether there are no more rows
+	 */
+	bool done;
+};
+
+
 /***************************************************************************/
 /** Private functions                                                     **/
 /***************************************************************************/
@@ -0,0 +1,983 @@
+/*
+ * cpl-query.cpp
+ * Core Provenance Library
+ *
+ * Copyright 2011
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#include "stdafx.h"
+#include "cpl-query.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+
+/***************************************************************************/
+/** Helpers                                                               **/
+/***************************************************************************/
+
+/**
+ * The maximum number of digits in a number in the query
+ */
+#define CPL_QUERY_MAX_DIGITS			6
+
+
+/**
+ * A dependency that can be used in a hop
+ */
+typedef struct {
+
+	/// The name
+	const char* name;
+
+	/// The CPL_A_* flags to pass to the backend
+	int flags;
+
+	/// The dependency type, or CPL_DEPENDENCY_NONE for the whole category
+	int type;
+
+} cpl_query_dependency_t;
+
+
+/**
+ * The dependencies that can be used in a hop
+ */
+static const cpl_query_dependency_t CPL_QUERY_DEPENDENCIES[] = {
+	{ "DATA"       , CPL_A_NO_CONTROL_DEPENDENCIES, CPL_DEPENDENCY_NONE  },
+	{ "INPUT"      , CPL_A_NO_CONTROL_DEPENDENCIES, CPL_DATA_INPUT       },
+	{ "IPC"        , CPL_A_NO_CONTROL_DEPENDENCIES, CPL_DATA_IPC         },
+	{ "TRANSLATION", CPL_A_NO_CONTROL_DEPENDENCIES, CPL_DATA_TRANSLATION },
+	{ "COPY"       , CPL_A_NO_CONTROL_DEPENDENCIES, CPL_DATA_COPY        },
+	{ "CONTROL"    , CPL_A_NO_DATA_DEPENDENCIES   , CPL_DEPENDENCY_NONE  },
+	{ "OP"         , CPL_A_NO_DATA_DEPENDENCIES   , CPL_CONTROL_OP       },
+	{ "START"      , CPL_A_NO_DATA_DEPENDENCIES   , CPL_CONTROL_START    },
+	{ NULL         , 0                            , 0                    }
+};
+
+
+/**
+ * Convert a string to upper case
+ *
+ * @param s the string
+ * @return the string in upper case
+ */
+static std::string
+cpl_query_upper(const std::string& s)
+{
+	std::string r = s;
+	for (size_t i = 0; i < r.size(); i++) {
+		r[i] = (char) toupper((unsigned char) r[i]);
+	}
+	return r;
+}
+
+
+
+/***************************************************************************/
+/** Constructor and Destructor                                            **/
+/***************************************************************************/
+
+/**
+ * Create the query
+ *
+ * @param backend the database backend
+ */
+CPLQuery::CPLQuery(cpl_db_backend_t* backend)
+{
+	m_backend = backend;
+	m_position = 0;
+	m_return = 0;
+	m_limit = 0;
+}
+
+
+/**
+ * Destroy the query
+ */
+CPLQuery::~CPLQuery(void)
+{
+}
+
+
+
+/***************************************************************************/
+/** Parser                                                                **/
+/***************************************************************************/
+
+/**
+ * Split the query into tokens
+ *
+ * @param text the query text
+ * @return CPL_OK or CPL_E_INVALID_QUERY
+ */
+cpl_return_t
+CPLQuery::tokenize(const char* text)
+{
+	m_tokens.clear();
+	m_position = 0;
+
+	const char* p = text;
+	while (*p != '\0') {
+
+		unsigned char c = (unsigned char) *p;
+		if (isspace(c)) {
+			p++;
+			continue;
+		}
+
+		token_t t;
+
+		if (isalpha(c) || c == '_') {
+			t.kind = T_IDENTIFIER;
+			while (isalnum((unsigned char) *p) || *p == '_') t.text += *(p++);
+		}
+		else if (isdigit(c)) {
+			t.kind = T_NUMBER;
+			while (isdigit((unsigned char) *p)) t.text += *(p++);
+			if (t.text.size() > CPL_QUERY_MAX_DIGITS) {
+				return CPL_E_INVALID_QUERY;
+			}
+		}
+		else if (c == '\'' || c == '"') {
+			t.kind = T_STRING;
+			for (p++; *p != '\0' && *p != (char) c; p++) {
+				if (*p == '\\' && p[1] != '\0') p++;
+				t.text += *p;
+			}
+			if (*p == '\0') return CPL_E_INVALID_QUERY;
+			p++;
+		}
+		else if (c == '.' && p[1] == '.') {
+			t.kind = T_SYMBOL;
+			t.text = "..";
+			p += 2;
+		}
+		else if (strchr("()[]{}:,-<>*", c) != NULL) {
+			t.kind = T_SYMBOL;
+			t.text = *(p++);
+		}
+		else {
+			return CPL_E_INVALID_QUERY;
+		}
+
+		m_tokens.push_back(t);
+	}
+
+	token_t end;
+	end.kind = T_END;
+	m_tokens.push_back(end);
+
+	return CPL_OK;
+}
+
+
+/**
+ * Consume the next token if it is the given symbol
+ *
+ * @param symbol the symbol
+ * @return true if consumed
+ */
+bool
+CPLQuery::accept_symbol(const char* symbol)
+{
+	const token_t& t = m_tokens[m_position];
+	if (t.kind != T_SYMBOL || t.text != symbol) return false;
+
+	m_position++;
+	return true;
+}
+
+
+/**
+ * Consume the next token if it is the given keyword
+ *
+ * @param keyword the keyword in upper case
+ * @return true if consumed
+ */
+bool
+CPLQuery::accept_keyword(const char* keyword)
+{
+	const token_t& t = m_tokens[m_position];
+	if (t.kind != T_IDENTIFIER || cpl_query_upper(t.text) != keyword) {
+		return false;
+	}
+
+	m_position++;
+	return true;
+}
+
+
+/**
+ * Consume the next token if it is of the given kind
+ *
+ * @param kind the token kind
+ * @param out the string to store the text of the token
+ * @return true if consumed
+ */
+bool
+CPLQuery::accept(const int kind, std::string& out)
+{
+	const token_t& t = m_tokens[m_position];
+	if (t.kind != kind) return false;
+
+	out = t.text;
+	m_position++;
+	return true;
+}
+
+
+/**
+ * Parse a node
+ *
+ * @param node the node to fill in
+ * @return CPL_OK or CPL_E_INVALID_QUERY
+ */
+cpl_return_t
+CPLQuery::parse_node(node_t& node)
+{
+	if (!accept_symbol("(")) return CPL_E_INVALID_QUERY;
+
+	accept(T_IDENTIFIER, node.variable);
+
+	if (accept_symbol(":")) {
+		if (!accept(T_IDENTIFIER, node.type) && !accept(T_STRING, node.type)) {
+			return CPL_E_INVALID_QUERY;
+		}
+	}
+
+	if (accept_symbol("{")) {
+		do {
+			std::string key, value;
+			if (!accept(T_IDENTIFIER, key) && !accept(T_STRING, key)) {
+				return CPL_E_INVALID_QUERY;
+			}
+			if (!accept_symbol(":")) return CPL_E_INVALID_QUERY;
+			if (!accept(T_STRING, value) && !accept(T_NUMBER, value)) {
+				return CPL_E_INVALID_QUERY;
+			}
+
+			if (key == "name") {
+				node.name = value;
+			}
+			else if (key == "originator") {
+				node.originator = value;
+			}
+			else {
+				node.properties.push_back(std::make_pair(key, value));
+			}
+		}
+		while (accept_symbol(","));
+
+		if (!accept_symbol("}")) return CPL_E_INVALID_QUERY;
+	}
+
+	if (!accept_symbol(")")) return CPL_E_INVALID_QUERY;
+	return CPL_OK;
+}
+
+
+/**
+ * Parse a hop
+ *
+ * @param rel the hop to fill in
+ * @return CPL_OK or CPL_E_INVALID_QUERY
+ */
+cpl_return_t
+CPLQuery::parse_rel(rel_t& rel)
+{
+	bool to_left = accept_symbol("<");
+	if (!accept_symbol("-")) return CPL_E_INVALID_QUERY;
+
+	rel.direction = to_left ? CPL_D_DESCENDANTS : CPL_D_ANCESTORS;
+	rel.flags = 0;
+	rel.type = CPL_DEPENDENCY_NONE;
+	rel.min_hops = 1;
+	rel.max_hops = 1;
+
+	if (accept_symbol("[")) {
+
+
+		// The dependency
+
+		if (accept_symbol(":")) {
+			std::string name;
+			if (!accept(T_IDENTIFIER, name)) return CPL_E_INVALID_QUERY;
+			name = cpl_query_upper(name);
+
+			const cpl_query_dependency_t* d = CPL_QUERY_DEPENDENCIES;
+			while (d->name != NULL && name != d->name) d++;
+			if (d->name == NULL) return CPL_E_INVALID_QUERY;
+
+			rel.flags = d->flags;
+			rel.type = d->type;
+		}
+
+
+		// The range
+
+		if (accept_symbol("*")) {
+			std::string n;
+			rel.max_hops = -1;
+			if (accept(T_NUMBER, n)) {
+				rel.min_hops = atoi(n.c_str());
+				rel.max_hops = rel.min_hops;
+			}
+			if (accept_symbol("..")) {
+				rel.max_hops = -1;
+				if (accept(T_NUMBER, n)) rel.max_hops = atoi(n.c_str());
+			}
+			if (rel.max_hops >= 0 && rel.min_hops > rel.max_hops) {
+				return CPL_E_INVALID_QUERY;
+			}
+		}
+
+		if (!accept_symbol("]")) return CPL_E_INVALID_QUERY;
+	}
+
+	if (!accept_symbol("-")) return CPL_E_INVALID_QUERY;
+	if (!to_left && !accept_symbol(">")) return CPL_E_INVALID_QUERY;
+
+	return CPL_OK;
+}
+
+
+/**
+ * Parse the query
+ *
+ * @param text the query text
+ * @return CPL_OK, CPL_E_INVALID_QUERY, or an error code
+ */
+cpl_return_t
+CPLQuery::parse(const char* text)
+{
+	cpl_return_t r;
+
+	m_nodes.clear();
+	m_rels.clear();
+	m_return = 0;
+	m_limit = 0;
+	m_property_matches.clear();
+
+	r = tokenize(text);
+	if (!CPL_IS_OK(r)) return r;
+
+
+	// The path
+
+	if (!accept_keyword("MATCH")) return CPL_E_INVALID_QUERY;
+
+	node_t node;
+	r = parse_node(node);
+	if (!CPL_IS_OK(r)) return r;
+	m_nodes.push_back(node);
+
+	while (!accept_keyword("RETURN")) {
+
+		rel_t rel;
+		r = parse_rel(rel);
+		if (!CPL_IS_OK(r)) return r;
+
+		node_t next;
+		r = parse_node(next);
+		if (!CPL_IS_OK(r)) return r;
+
+		m_rels.push_back(rel);
+		m_nodes.push_back(next);
+	}
+
+
+	// The result
+
+	std::string variable;
+	if (!accept(T_IDENTIFIER, variable)) return CPL_E_INVALID_QUERY;
+
+	if (accept_keyword("LIMIT")) {
+		std::string n;
+		if (!accept(T_NUMBER, n)) return CPL_E_INVALID_QUERY;
+		m_limit = (size_t) atoi(n.c_str());
+		if (m_limit == 0) return CPL_E_INVALID_QUERY;
+	}
+
+	if (m_tokens[m_position].kind != T_END) return CPL_E_INVALID_QUERY;
+
+
+	// Resolve the returned variable; each variable can be used only once,
+	// since the path cannot loop back to a node
+
+	bool found = false;
+	for (size_t i = 0; i < m_nodes.size(); i++) {
+		if (m_nodes[i].variable.empty()) continue;
+		for (size_t j = 0; j < i; j++) {
+			if (m_nodes[j].variable == m_nodes[i].variable) {
+				return CPL_E_INVALID_QUERY;
+			}
+		}
+		if (m_nodes[i].variable == variable) {
+			m_return = i;
+			found = true;
+		}
+	}
+
+	return found ? CPL_OK : CPL_E_INVALID_QUERY;
+}
+
+
+
+/***************************************************************************/
+/** Matching the Nodes                                                    **/
+/***************************************************************************/
+
+/**
+ * Determine how selective a node is when used to start the execution
+ *
+ * @param node the node
+ * @return the selectivity, with higher values for fewer objects
+ */
+int
+CPLQuery::selectivity(const node_t& node)
+{
+	if (!node.name.empty()) return 3;
+	if (!node.properties.empty()) return 2;
+	if (!node.type.empty() || !node.originator.empty()) return 1;
+	return 0;
+}
+
+
+/**
+ * Fetch the information about the objects that are not yet cached
+ *
+ * @param ids the object IDs
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+CPLQuery::fetch_info(const std::vector<cpl_id_t>& ids)
+{
+	std::vector<cpl_id_t> missing;
+	id_set_t seen;
+	for (size_t i = 0; i < ids.size(); i++) {
+		if (m_info.find(ids[i]) != m_info.end()) continue;
+		if (seen.insert(ids[i]).second) missing.push_back(ids[i]);
+	}
+
+	for (size_t b = 0; b < missing.size(); b += CPL_QUERY_BATCH_SIZE) {
+
+		size_t n = missing.size() - b;
+		if (n > CPL_QUERY_BATCH_SIZE) n = CPL_QUERY_BATCH_SIZE;
+
+		std::vector<cpl_object_info_t*> infos(n, (cpl_object_info_t*) NULL);
+		cpl_return_t r = cpl_get_object_info_batch(&missing[b], n, &infos[0]);
+		if (!CPL_IS_OK(r)) return r;
+
+		std::vector<cplxx_object_info_t> objects;
+		for (size_t i = 0; i < n; i++) {
+			cpl_cb_collect_object_info_vector(infos[i], &objects);
+			cpl_free_object_info(infos[i]);
+		}
+		for (size_t i = 0; i < objects.size(); i++) {
+			m_info[objects[i].id] = objects[i];
+		}
+	}
+
+	return CPL_OK;
+}
+
+
+/**
+ * Get the objects that have all properties required by a node, using
+ * a single backend query
+ *
+ * @param index the node index
+ * @param out the pointer to store the pointer to the cached set
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+CPLQuery::property_matches(const size_t index, const id_set_t** out)
+{
+	std::map<size_t, id_set_t>::iterator i = m_property_matches.find(index);
+	if (i != m_property_matches.end()) {
+		*out = &i->second;
+		return CPL_OK;
+	}
+
+	const node_t& node = m_nodes[index];
+	size_t n = node.properties.size();
+
+	std::vector<const char*> values(n);
+	std::vector<cpl_property_predicate_t> predicates(n);
+	for (size_t k = 0; k < n; k++) {
+		values[k] = node.properties[k].second.c_str();
+		predicates[k].key = node.properties[k].first.c_str();
+		predicates[k].op = CPL_PQ_EQUALS;
+		predicates[k].values = &values[k];
+		predicates[k].num_values = 1;
+	}
+
+	std::vector<cpl_id_timestamp_t> found;
+	cpl_return_t r = cpl_query_by_properties(
+			node.originator.empty() ? NULL : node.originator.c_str(),
+			node.type.empty() ? NULL : node.type.c_str(),
+			&predicates[0], n, cpl_cb_collect_id_timestamp_vector, &found);
+	if (r != CPL_E_NOT_FOUND && !CPL_IS_OK(r)) return r;
+
+	id_set_t& s = m_property_matches[index];
+	for (size_t k = 0; k < found.size(); k++) s.insert(found[k].id);
+
+	*out = &s;
+	return CPL_OK;
+}
+
+
+/**
+ * Find the candidates for the node that starts the execution
+ *
+ * @param index the node index
+ * @param out the set to store the matching objects
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+CPLQuery::lookup(const size_t index, id_set_t& out)
+{
+	const node_t& node = m_nodes[index];
+	cpl_return_t r;
+	id_set_t candidates;
+
+
+	// Use the property index if there are any properties, the name index
+	// if there is at least the originator or the type, or a scan of all
+	// objects otherwise
+
+	if (!node.properties.empty()) {
+		const id_set_t* s;
+		r = property_matches(index, &s);
+		if (!CPL_IS_OK(r)) return r;
+		candidates = *s;
+	}
+	else {
+		std::vector<cplxx_object_info_t> objects;
+		if (selectivity(node) > 0) {
+			r = cpl_lookup_by_name_prefix(
+					node.originator.empty() ? NULL : node.originator.c_str(),
+					node.name.c_str(),
+					node.type.empty() ? NULL : node.type.c_str(),
+					0, cpl_cb_collect_object_info_vector, &objects);
+		}
+		else {
+			r = cpl_get_all_objects(0, cpl_cb_collect_object_info_vector,
+									&objects);
+		}
+		if (!CPL_IS_OK(r)) return r;
+
+		for (size_t i = 0; i < objects.size(); i++) {
+			m_info[objects[i].id] = objects[i];
+			candidates.insert(objects[i].id);
+		}
+	}
+
+	return filter(index, candidates, out);
+}
+
+
+/**
+ * Select the objects that match a node
+ *
+ * @param index the node index
+ * @param in the objects
+ * @param out the set to store the matching objects
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+CPLQuery::filter(const size_t index, const id_set_t& in, id_set_t& out)
+{
+	const node_t& node = m_nodes[index];
+	cpl_return_t r;
+
+	r = fetch_info(std::vector<cpl_id_t>(in.begin(), in.end()));
+	if (!CPL_IS_OK(r)) return r;
+
+	const id_set_t* properties = NULL;
+	if (!node.properties.empty()) {
+		r = property_matches(index, &properties);
+		if (!CPL_IS_OK(r)) return r;
+	}
+
+	for (id_set_t::const_iterator i = in.begin(); i != in.end(); i++) {
+
+		std::map<cpl_id_t, cplxx_object_info_t>::iterator info
+			= m_info.find(*i);
+		if (info == m_info.end()) continue;
+
+		const cplxx_object_info_t& e = info->second;
+		if (!node.originator.empty() && e.originator != node.originator) {
+			continue;
+		}
+		if (!node.name.empty() && e.name != node.name) continue;
+		if (!node.type.empty() && e.type != node.type) continue;
+		if (properties != NULL && properties->find(*i) == properties->end()) {
+			continue;
+		}
+
+		out.insert(*i);
+	}
+
+	return CPL_OK;
+}
+
+
+
+/***************************************************************************/
+/** Traversing the Hops                                                   **/
+/***************************************************************************/
+
+/**
+ * The ancestry iterator, which collects the reached version nodes
+ *
+ * @param query_object_id the ID of the query object
+ * @param query_object_version the version of the query object
+ * @param other_object_id the ID of the reached object
+ * @param other_object_version the version of the reached object
+ * @param type the type of the dependency
+ * @param context the pointer to reach_context_t
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+CPLQuery::cb_edge(const cpl_id_t query_object_id,
+				  const cpl_version_t query_object_version,
+				  const cpl_id_t other_object_id,
+				  const cpl_version_t other_object_version,
+				  const int type,
+				  void* context)
+{
+	reach_context_t* ctx = (reach_context_t*) context;
+	if (ctx->rel->type != CPL_DEPENDENCY_NONE && ctx->rel->type != type) {
+		return CPL_OK;
+	}
+
+	cpl_id_version_t e;
+	e.id = other_object_id;
+	e.version = other_object_version;
+	ctx->found.push_back(e);
+
+	return CPL_OK;
+}
+
+
+/**
+ * Record a reached version node, and add it and the other versions of the
+ * object that it implies to the next level of the traversal
+ *
+ * @param ctx the reach context
+ * @param id the object ID
+ * @param version the object version
+ * @param depth the number of crossed dependencies
+ */
+void
+CPLQuery::visit(reach_context_t& ctx, const cpl_id_t id,
+				const cpl_version_t version, const int depth)
+{
+	const rel_t& rel = *ctx.rel;
+	if (depth >= rel.min_hops) ctx.out->insert(id);
+
+
+	// Once the minimum is reached, the number of crossed dependencies does
+	// not matter anymore, since the version node was reached sooner
+
+	int level = depth < rel.min_hops ? depth : rel.min_hops;
+	std::pair<cpl_id_t, int> key(id, level);
+	std::map<std::pair<cpl_id_t, int>, cpl_version_t>::iterator b
+		= ctx.bounds.find(key);
+
+
+	// Determine the range of versions that became reachable
+
+	cpl_version_t first, last;
+	if (ctx.direction == CPL_D_ANCESTORS) {
+		cpl_version_t bound = b == ctx.bounds.end() ? -1 : b->second;
+		if (version <= bound) return;
+		first = bound + 1;
+		last = version;
+		ctx.bounds[key] = last;
+	}
+	else {
+		cpl_version_t bound = version + 1;
+		if (b != ctx.bounds.end()) {
+			bound = b->second;
+		}
+		else {
+			std::map<cpl_id_t, cplxx_object_info_t>::iterator i
+				= m_info.find(id);
+			if (i != m_info.end() && i->second.version >= version) {
+				bound = i->second.version + 1;
+			}
+		}
+		if (version >= bound) return;
+		first = version;
+		last = bound - 1;
+		ctx.bounds[key] = first;
+	}
+
+	for (cpl_version_t v = first; v <= last; v++) {
+		cpl_id_version_t e;
+		e.id = id;
+		e.version = v;
+		ctx.next.push_back(e);
+	}
+}
+
+
+/**
+ * Find the objects reachable through a hop
+ *
+ * @param rel the hop
+ * @param direction the direction of the traversal
+ * @param start the objects to start from
+ * @param out the set to store the reached objects
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+CPLQuery::reach(const rel_t& rel, const int direction, const id_set_t& start,
+				id_set_t& out)
+{
+	cpl_return_t r;
+
+	r = fetch_info(std::vector<cpl_id_t>(start.begin(), start.end()));
+	if (!CPL_IS_OK(r)) return r;
+
+	reach_context_t ctx;
+	ctx.rel = &rel;
+	ctx.direction = direction;
+	ctx.out = &out;
+
+
+	// Start from all versions of the objects: from the latest version
+	// when going to the ancestors, and from the first one otherwise
+
+	for (id_set_t::const_iterator i = start.begin(); i != start.end(); i++) {
+		std::map<cpl_id_t, cplxx_object_info_t>::iterator info
+			= m_info.find(*i);
+		if (info == m_info.end()) continue;
+		visit(ctx, *i, direction == CPL_D_ANCESTORS
+				? info->second.version : 0, 0);
+	}
+
+
+	// Cross one dependency at a time, fetching each level using batched
+	// requests
+
+	std::vector<cpl_id_version_t> frontier;
+	frontier.swap(ctx.next);
+
+	for (int depth = 0; !frontier.empty()
+			&& (rel.max_hops < 0 || depth < rel.max_hops); depth++) {
+
+		ctx.found.clear();
+		for (size_t b = 0; b < frontier.size(); b += CPL_QUERY_BATCH_SIZE) {
+
+			size_t n = frontier.size() - b;
+			if (n > CPL_QUERY_BATCH_SIZE) n = CPL_QUERY_BATCH_SIZE;
+
+			r = m_backend->cpl_db_get_object_ancestry_batch(m_backend,
+					&frontier[b], n, direction,
+					rel.flags | CPL_A_NO_PREV_NEXT_VERSION, cb_edge, &ctx);
+			if (!CPL_IS_OK(r)) return r;
+		}
+
+
+		// Get the current versions of the reached objects, which bound
+		// their later versions
+
+		std::vector<cpl_id_t> ids;
+		for (size_t i = 0; i < ctx.found.size(); i++) {
+			ids.push_back(ctx.found[i].id);
+		}
+		r = fetch_info(ids);
+		if (!CPL_IS_OK(r)) return r;
+
+		for (size_t i = 0; i < ctx.found.size(); i++) {
+			visit(ctx, ctx.found[i].id, ctx.found[i].version, depth + 1);
+		}
+
+		frontier.clear();
+		frontier.swap(ctx.next);
+	}
+
+	return CPL_OK;
+}
+
+
+
+/***************************************************************************/
+/** Execution                                                             **/
+/***************************************************************************/
+
+/**
+ * Propagate the objects bound to a node to its neighbor
+ *
+ * @param from the index of the node
+ * @param to the index of the neighbor
+ * @param sets the objects bound to each node
+ * @param known whether the objects bound to each node are known
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+CPLQuery::step(const size_t from, const size_t to,
+			   std::vector<id_set_t>& sets, std::vector<bool>& known)
+{
+	cpl_return_t r;
+
+	const rel_t& rel = m_rels[from < to ? from : to];
+	int direction = rel.direction;
+	if (from > to) {
+		direction = direction == CPL_D_ANCESTORS
+			? CPL_D_DESCENDANTS : CPL_D_ANCESTORS;
+	}
+
+	id_set_t reached;
+	r = reach(rel, direction, sets[from], reached);
+	if (!CPL_IS_OK(r)) return r;
+
+	id_set_t matched;
+	r = filter(to, reached, matched);
+	if (!CPL_IS_OK(r)) return r;
+
+	if (known[to]) {
+		id_set_t s;
+		std::set_intersection(matched.begin(), matched.end(),
+							  sets[to].begin(), sets[to].end(),
+							  std::inserter(s, s.begin()));
+		sets[to].swap(s);
+	}
+	else {
+		sets[to].swap(matched);
+		known[to] = true;
+	}
+
+	return CPL_OK;
+}
+
+
+/**
+ * Execute the parsed query
+ *
+ * @param iterator the iterator to be called for each returned object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA if nothing matches, or an error code
+ */
+cpl_return_t
+CPLQuery::execute(cpl_object_info_iterator_t iterator, void* context)
+{
+	if (m_nodes.empty()) return CPL_E_INVALID_QUERY;
+
+	cpl_return_t r;
+	size_t n = m_nodes.size();
+
+
+	// Start from the most selective node
+
+	size_t start = 0;
+	for (size_t i = 1; i < n; i++) {
+		if (selectivity(m_nodes[i]) > selectivity(m_nodes[start])) start = i;
+	}
+
+	std::vector<id_set_t> sets(n);
+	std::vector<bool> known(n, false);
+
+	r = lookup(start, sets[start]);
+	if (!CPL_IS_OK(r)) return r;
+	known[start] = true;
+
+
+	// Propagate the objects outward from the starting node
+
+	for (size_t i = start; i + 1 < n; i++) {
+		r = step(i, i + 1, sets, known);
+		if (!CPL_IS_OK(r)) return r;
+	}
+	for (size_t i = start; i > 0; i--) {
+		r = step(i, i - 1, sets, known);
+		if (!CPL_IS_OK(r)) return r;
+	}
+
+
+	// Reduce them inward from both ends, so that only the objects that
+	// complete the path on both sides remain at the starting node
+
+	for (size_t i = n - 1; i > start; i--) {
+		r = step(i, i - 1, sets, known);
+		if (!CPL_IS_OK(r)) return r;
+	}
+	for (size_t i = 0; i < start; i++) {
+		r = step(i, i + 1, sets, known);
+		if (!CPL_IS_OK(r)) return r;
+	}
+
+
+	// Propagate them outward again up to the returned node
+
+	for (size_t i = start; i < m_return; i++) {
+		r = step(i, i + 1, sets, known);
+		if (!CPL_IS_OK(r)) return r;
+	}
+	for (size_t i = start; i > m_return; i--) {
+		r = step(i, i - 1, sets, known);
+		if (!CPL_IS_OK(r)) return r;
+	}
+
+
+	// Return the objects
+
+	size_t count = 0;
+	id_set_t& result = sets[m_return];
+
+	for (id_set_t::iterator i = result.begin(); i != result.end(); i++) {
+
+		const cplxx_object_info_t& e = m_info[*i];
+
+		cpl_object_info_t info;
+		info.id = e.id;
+		info.version = e.version;
+		info.creation_session = e.creation_session;
+		info.creation_time = e.creation_time;
+		info.originator = (char*) e.originator.c_str();
+		info.name = (char*) e.name.c_str();
+		info.type = (char*) e.type.c_str();
+		info.container_id = e.container_id;
+		info.container_version = e.container_version;
+
+		r = iterator(&info, context);
+		if (!CPL_IS_OK(r)) return r;
+
+		if (++count == m_limit) break;
+	}
+
+	return count > 0 ? CPL_OK : CPL_S_NO_DATA;
+}
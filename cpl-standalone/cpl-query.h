@@ -0,0 +1,446 @@
+/*
+ * cpl-query.h
+ * Core Provenance Library
+ *
+ * Copyright 2011
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#ifndef __CPL_QUERY_H__
+#define __CPL_QUERY_H__
+
+#include <cplxx.h>
+#include <cpl-db-backend.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+
+/***************************************************************************/
+/** Constants                                                             **/
+/***************************************************************************/
+
+/**
+ * The maximum number of objects or version nodes in a single batched
+ * request
+ */
+#define CPL_QUERY_BATCH_SIZE			256
+
+
+
+/***************************************************************************/
+/** Path Queries                                                          **/
+/***************************************************************************/
+
+/**
+ * A path query over the provenance graph, such as:
+ *
+ *   MATCH (f:FILE {name:'/x'})<-[:DATA*1..5]-(p:PROCESS) RETURN p
+ *
+ * The grammar, in which the keywords are case-insensitive, is:
+ *
+ *   query := MATCH node { rel node } RETURN variable [ LIMIT number ]
+ *   node  := ( [variable] [: type] [{ key : value { , key : value } }] )
+ *   rel   := -[ spec ]->  |  <-[ spec ]-  |  -->  |  <--
+ *   spec  := [: dependency] [* [min] [.. [max]]]
+ *
+ * The keys "name" and "originator" refer to the object, and all other keys
+ * to its properties. The arrow points from the dependent object to its
+ * ancestor, so the example finds the processes that read /x, directly or
+ * through up to four other objects. The dependency is DATA, CONTROL, or one
+ * of the subtypes INPUT, IPC, TRANSLATION, COPY, OP, and START. A hop
+ * without a range crosses exactly one dependency, and a hop with "*" but
+ * without a bound has the minimum of 1 and no maximum. The versions of an
+ * object are traversed for free, so a hop from an object can continue from
+ * any of its later versions when going to the descendants, and from any of
+ * its earlier versions when going to the ancestors.
+ *
+ * The execution starts from the most selective node: the name lookup uses
+ * the name index and the property lookup the property index, both with the
+ * originator and the type pushed down to the backend. The hops expand one
+ * level of version nodes at a time using batched backend calls, with the
+ * dependency category pushed down as well. The sets of objects bound to
+ * the nodes are first propagated outward from the starting node, then
+ * reduced inward from both ends, and finally propagated outward again up
+ * to the returned node, so that every returned object is a part of
+ * a complete match of the path.
+ */
+class CPLQuery
+{
+
+public:
+
+	/**
+	 * Create the query
+	 *
+	 * @param backend the database backend
+	 */
+	CPLQuery(cpl_db_backend_t* backend);
+
+	/**
+	 * Destroy the query
+	 */
+	~CPLQuery(void);
+
+	/**
+	 * Parse the query
+	 *
+	 * @param text the query text
+	 * @return CPL_OK, CPL_E_INVALID_QUERY, or an error code
+	 */
+	cpl_return_t
+	parse(const char* text);
+
+	/**
+	 * Execute the parsed query
+	 *
+	 * @param iterator the iterator to be called for each returned object
+	 * @param context the caller-provided iterator context
+	 * @return CPL_OK, CPL_S_NO_DATA if nothing matches, or an error code
+	 */
+	cpl_return_t
+	execute(cpl_object_info_iterator_t iterator, void* context);
+
+
+protected:
+
+	/**
+	 * A token
+	 */
+	typedef struct {
+
+		/// The kind of the token (one of the T_* constants)
+		int kind;
+
+		/// The text of the token, with the quotes and escapes removed
+		std::string text;
+
+	} token_t;
+
+	/**
+	 * The kinds of the tokens
+	 */
+	enum {
+		T_END,
+		T_IDENTIFIER,
+		T_NUMBER,
+		T_STRING,
+		T_SYMBOL,
+	};
+
+	/**
+	 * A node of the path
+	 */
+	typedef struct {
+
+		/// The variable, or empty if none
+		std::string variable;
+
+		/// The object originator, or empty for any
+		std::string originator;
+
+		/// The object name, or empty for any
+		std::string name;
+
+		/// The object type, or empty for any
+		std::string type;
+
+		/// The required property values
+		std::vector<std::pair<std::string, std::string> > properties;
+
+	} node_t;
+
+	/**
+	 * A hop between two nodes of the path
+	 */
+	typedef struct {
+
+		/// The direction from the left node to the right node
+		/// (CPL_D_ANCESTORS or CPL_D_DESCENDANTS)
+		int direction;
+
+		/// The CPL_A_* flags passed to the backend
+		int flags;
+
+		/// The dependency type, or CPL_DEPENDENCY_NONE for any
+		int type;
+
+		/// The minimum number of dependencies to cross
+		int min_hops;
+
+		/// The maximum number of dependencies to cross, or -1 for no limit
+		int max_hops;
+
+	} rel_t;
+
+	/**
+	 * A set of object IDs
+	 */
+	typedef std::set<cpl_id_t> id_set_t;
+
+	/**
+	 * The context of the ancestry callback
+	 */
+	typedef struct {
+
+		/// The hop
+		const rel_t* rel;
+
+		/// The direction of the traversal
+		int direction;
+
+		/// The version nodes returned by the backend
+		std::vector<cpl_id_version_t> found;
+
+		/// The reached versions of each object for each number of crossed
+		/// dependencies up to the minimum: the highest version when going
+		/// to the ancestors, or the lowest version when going to the
+		/// descendants, since the versions beyond it are reached as well
+		std::map<std::pair<cpl_id_t, int>, cpl_version_t> bounds;
+
+		/// The next level of the traversal
+		std::vector<cpl_id_version_t> next;
+
+		/// The reached objects
+		id_set_t* out;
+
+	} reach_context_t;
+
+	/**
+	 * Split the query into tokens
+	 *
+	 * @param text the query text
+	 * @return CPL_OK or CPL_E_INVALID_QUERY
+	 */
+	cpl_return_t
+	tokenize(const char* text);
+
+	/**
+	 * Consume the next token if it is the given symbol
+	 *
+	 * @param symbol the symbol
+	 * @return true if consumed
+	 */
+	bool
+	accept_symbol(const char* symbol);
+
+	/**
+	 * Consume the next token if it is the given keyword
+	 *
+	 * @param keyword the keyword in upper case
+	 * @return true if consumed
+	 */
+	bool
+	accept_keyword(const char* keyword);
+
+	/**
+	 * Consume the next token if it is of the given kind
+	 *
+	 * @param kind the token kind
+	 * @param out the string to store the text of the token
+	 * @return true if consumed
+	 */
+	bool
+	accept(const int kind, std::string& out);
+
+	/**
+	 * Parse a node
+	 *
+	 * @param node the node to fill in
+	 * @return CPL_OK or CPL_E_INVALID_QUERY
+	 */
+	cpl_return_t
+	parse_node(node_t& node);
+
+	/**
+	 * Parse a hop
+	 *
+	 * @param rel the hop to fill in
+	 * @return CPL_OK or CPL_E_INVALID_QUERY
+	 */
+	cpl_return_t
+	parse_rel(rel_t& rel);
+
+	/**
+	 * Determine how selective a node is when used to start the execution
+	 *
+	 * @param node the node
+	 * @return the selectivity, with higher values for fewer objects
+	 */
+	static int
+	selectivity(const node_t& node);
+
+	/**
+	 * Fetch the information about the objects that are not yet cached
+	 *
+	 * @param ids the object IDs
+	 * @return CPL_OK or an error code
+	 */
+	cpl_return_t
+	fetch_info(const std::vector<cpl_id_t>& ids);
+
+	/**
+	 * Get the objects that have all properties required by a node, using
+	 * a single backend query
+	 *
+	 * @param index the node index
+	 * @param out the pointer to store the pointer to the cached set
+	 * @return CPL_OK or an error code
+	 */
+	cpl_return_t
+	property_matches(const size_t index, const id_set_t** out);
+
+	/**
+	 * Find the candidates for the node that starts the execution
+	 *
+	 * @param index the node index
+	 * @param out the set to store the matching objects
+	 * @return CPL_OK or an error code
+	 */
+	cpl_return_t
+	lookup(const size_t index, id_set_t& out);
+
+	/**
+	 * Select the objects that match a node
+	 *
+	 * @param index the node index
+	 * @param in the objects
+	 * @param out the set to store the matching objects
+	 * @return CPL_OK or an error code
+	 */
+	cpl_return_t
+	filter(const size_t index, const id_set_t& in, id_set_t& out);
+
+	/**
+	 * The ancestry iterator, which collects the reached version nodes
+	 *
+	 * @param query_object_id the ID of the query object
+	 * @param query_object_version the version of the query object
+	 * @param other_object_id the ID of the reached object
+	 * @param other_object_version the version of the reached object
+	 * @param type the type of the dependency
+	 * @param context the pointer to reach_context_t
+	 * @return CPL_OK or an error code
+	 */
+	static cpl_return_t
+	cb_edge(const cpl_id_t query_object_id,
+			const cpl_version_t query_object_version,
+			const cpl_id_t other_object_id,
+			const cpl_version_t other_object_version,
+			const int type,
+			void* context);
+
+	/**
+	 * Record a reached version node, and add it and the other versions of
+	 * the object that it implies to the next level of the traversal
+	 *
+	 * @param ctx the reach context
+	 * @param id the object ID
+	 * @param version the object version
+	 * @param depth the number of crossed dependencies
+	 */
+	void
+	visit(reach_context_t& ctx, const cpl_id_t id,
+		  const cpl_version_t version, const int depth);
+
+	/**
+	 * Find the objects reachable through a hop
+	 *
+	 * @param rel the hop
+	 * @param direction the direction of the traversal
+	 * @param start the objects to start from
+	 * @param out the set to store the reached objects
+	 * @return CPL_OK or an error code
+	 */
+	cpl_return_t
+	reach(const rel_t& rel, const int direction, const id_set_t& start,
+		  id_set_t& out);
+
+	/**
+	 * Propagate the objects bound to a node to its neighbor
+	 *
+	 * @param from the index of the node
+	 * @param to the index of the neighbor
+	 * @param sets the objects bound to each node
+	 * @param known whether the objects bound to each node are known
+	 * @return CPL_OK or an error code
+	 */
+	cpl_return_t
+	step(const size_t from, const size_t to, std::vector<id_set_t>& sets,
+		 std::vector<bool>& known);
+
+	/**
+	 * The database backend
+	 */
+	cpl_db_backend_t* m_backend;
+
+	/**
+	 * The tokens
+	 */
+	std::vector<token_t> m_tokens;
+
+	/**
+	 * The position of the next token
+	 */
+	size_t m_position;
+
+	/**
+	 * The nodes of the path
+	 */
+	std::vector<node_t> m_nodes;
+
+	/**
+	 * The hops of the path, where m_rels[i] connects the nodes i and i + 1
+	 */
+	std::vector<rel_t> m_rels;
+
+	/**
+	 * The index of the returned node
+	 */
+	size_t m_return;
+
+	/**
+	 * The maximum number of returned objects, or 0 for no limit
+	 */
+	size_t m_limit;
+
+	/**
+	 * The cache of the object information
+	 */
+	std::map<cpl_id_t, cplxx_object_info_t> m_info;
+
+	/**
+	 * The cache of the results of the property queries by the node index
+	 */
+	std::map<size_t, id_set_t> m_property_matches;
+};
+
+#endif
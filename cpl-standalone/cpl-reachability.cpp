@@ -0,0 +1,767 @@
+/*
+ * cpl-reachability.cpp
+ * Core Provenance Library
+ *
+ * Copyright 2011
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#include "stdafx.h"
+#include "cpl-reachability.h"
+
+#include <algorithm>
+#include <string>
+
+
+/***************************************************************************/
+/** Helpers                                                               **/
+/***************************************************************************/
+
+/**
+ * The magic string at the beginning of an index file
+ */
+#define CPL_REACHABILITY_FILE_MAGIC		"CPL-REACHABILITY-INDEX"
+
+/**
+ * The version of the index file format
+ */
+#define CPL_REACHABILITY_FILE_VERSION	1
+
+
+/**
+ * The context for the iterators used by CPLReachabilityIndex::build()
+ */
+typedef struct {
+	CPLReachabilityIndex* index;
+	std::vector<cpl_id_version_t> nodes;
+} cpl_reachability_build_context_t;
+
+
+/**
+ * The object iterator used by CPLReachabilityIndex::build(), which adds all
+ * versions of each object
+ *
+ * @param info the object info
+ * @param context the pointer to cpl_reachability_build_context_t
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_reachability_build_object(const cpl_object_info_t* info, void* context)
+{
+	cpl_reachability_build_context_t* ctx
+		= (cpl_reachability_build_context_t*) context;
+
+	for (cpl_version_t v = 0; v <= info->version; v++) {
+		cpl_id_version_t n;
+		n.id = info->id;
+		n.version = v;
+		ctx->nodes.push_back(n);
+	}
+
+	ctx->index->add_version(info->id, info->version);
+	return CPL_OK;
+}
+
+
+/**
+ * The ancestry iterator used by CPLReachabilityIndex::build(), which adds
+ * the edges
+ *
+ * @param query_object_id the ID of the descendant
+ * @param query_object_version the version of the descendant
+ * @param other_object_id the ID of the ancestor
+ * @param other_object_version the version of the ancestor
+ * @param type the type of the dependency
+ * @param context the pointer to cpl_reachability_build_context_t
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_reachability_build_edge(const cpl_id_t query_object_id,
+							const cpl_version_t query_object_version,
+							const cpl_id_t other_object_id,
+							const cpl_version_t other_object_version,
+							const int type,
+							void* context)
+{
+	cpl_reachability_build_context_t* ctx
+		= (cpl_reachability_build_context_t*) context;
+
+	ctx->index->add_edge(query_object_id, query_object_version,
+						 other_object_id, other_object_version);
+	return CPL_OK;
+}
+
+
+
+/***************************************************************************/
+/** Reachability Index: Construction and Persistence                      **/
+/***************************************************************************/
+
+/**
+ * Create an empty index
+ */
+CPLReachabilityIndex::CPLReachabilityIndex(void)
+{
+	m_lock = 0;
+	m_next_rank = 1;
+	m_stale = false;
+	m_visit_mark = 0;
+}
+
+
+/**
+ * Destroy the index
+ */
+CPLReachabilityIndex::~CPLReachabilityIndex(void)
+{
+}
+
+
+/**
+ * Remove all nodes and edges
+ */
+void
+CPLReachabilityIndex::clear(void)
+{
+	cpl_lock(&m_lock);
+
+	m_objects.clear();
+	m_ids.clear();
+	m_versions.clear();
+	m_edges.clear();
+	m_in_degree.clear();
+	for (int t = 0; t < CPL_REACHABILITY_TRAVERSALS; t++) {
+		m_rank[t].clear();
+		m_low[t].clear();
+	}
+	m_visited.clear();
+
+	m_next_rank = 1;
+	m_stale = false;
+	m_visit_mark = 0;
+
+	cpl_unlock(&m_lock);
+}
+
+
+/**
+ * Build the index from a scan of all objects and edges in the database
+ *
+ * @param backend the database backend
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+CPLReachabilityIndex::build(cpl_db_backend_t* backend)
+{
+	cpl_return_t ret;
+	clear();
+
+
+	// Add all version nodes
+
+	cpl_reachability_build_context_t ctx;
+	ctx.index = this;
+
+	ret = backend->cpl_db_get_all_objects(backend,
+			CPL_I_NO_CREATION_SESSION, cpl_reachability_build_object, &ctx);
+	if (!CPL_IS_OK(ret)) return ret;
+
+
+	// Add the edges, fetching the ancestors of many nodes at once
+
+	for (size_t start = 0; start < ctx.nodes.size();
+			start += CPL_REACHABILITY_BATCH_SIZE) {
+
+		size_t count = ctx.nodes.size() - start;
+		if (count > CPL_REACHABILITY_BATCH_SIZE) {
+			count = CPL_REACHABILITY_BATCH_SIZE;
+		}
+
+		ret = backend->cpl_db_get_object_ancestry_batch(backend,
+				&ctx.nodes[start], count, CPL_D_ANCESTORS,
+				CPL_A_NO_PREV_NEXT_VERSION, cpl_reachability_build_edge, &ctx);
+		if (!CPL_IS_OK(ret)) return ret;
+	}
+
+
+	// Compute the labels
+
+	cpl_lock(&m_lock);
+	relabel();
+	cpl_unlock(&m_lock);
+
+	return CPL_OK;
+}
+
+
+/**
+ * Load the index from a file
+ *
+ * @param path the file name
+ * @return CPL_OK, CPL_E_NOT_FOUND if the file does not exist, or
+ *         an error code if it could not be read
+ */
+cpl_return_t
+CPLReachabilityIndex::load(const char* path)
+{
+	FILE* f = fopen(path, "r");
+	if (f == NULL) return CPL_E_NOT_FOUND;
+
+	clear();
+	cpl_lock(&m_lock);
+
+
+	// Read the header
+
+	char magic[64];
+	int format = 0, traversals = 0;
+	unsigned count = 0;
+
+	if (fscanf(f, "%63s %d %d %u", magic, &format, &traversals, &count) != 4
+			|| strcmp(magic, CPL_REACHABILITY_FILE_MAGIC) != 0
+			|| format != CPL_REACHABILITY_FILE_VERSION
+			|| traversals != CPL_REACHABILITY_TRAVERSALS) {
+		goto err;
+	}
+
+
+	// Read the nodes, which are stored in the order in which they were
+	// created, so that the versions of each object are consecutive
+
+	m_edges.resize(count);
+	m_in_degree.resize(count, 0);
+	for (int t = 0; t < CPL_REACHABILITY_TRAVERSALS; t++) {
+		m_rank[t].resize(count);
+		m_low[t].resize(count);
+	}
+	m_next_rank = 1;
+
+	for (unsigned u = 0; u < count; u++) {
+		cpl_id_t id;
+		unsigned version;
+		unsigned num_edges;
+
+		if (fscanf(f, "%llx %llx %x", &id.hi, &id.lo, &version) != 3) {
+			goto err;
+		}
+
+		std::vector<unsigned>& versions = m_objects[id];
+		if (version != versions.size()) goto err;
+		versions.push_back(u);
+		m_ids.push_back(id);
+		m_versions.push_back((cpl_version_t) version);
+
+		for (int t = 0; t < CPL_REACHABILITY_TRAVERSALS; t++) {
+			if (fscanf(f, "%u %u", &m_low[t][u], &m_rank[t][u]) != 2) {
+				goto err;
+			}
+			if (m_rank[t][u] >= m_next_rank) m_next_rank = m_rank[t][u] + 1;
+		}
+
+		if (fscanf(f, "%u", &num_edges) != 1) goto err;
+		m_edges[u].resize(num_edges);
+		for (unsigned i = 0; i < num_edges; i++) {
+			unsigned v;
+			if (fscanf(f, "%u", &v) != 1 || v >= count) goto err;
+			m_edges[u][i] = v;
+			m_in_degree[v]++;
+		}
+	}
+
+	fclose(f);
+	cpl_unlock(&m_lock);
+	return CPL_OK;
+
+
+	// Error handling
+
+err:
+	fclose(f);
+	cpl_unlock(&m_lock);
+	clear();
+	return CPL_E_INVALID_ARGUMENT;
+}
+
+
+/**
+ * Write the index to a file
+ *
+ * @param path the file name
+ * @return CPL_OK or an error code
+ */
+cpl_return_t
+CPLReachabilityIndex::save(const char* path)
+{
+	cpl_lock(&m_lock);
+	if (m_stale) relabel();
+
+
+	// Write to a temporary file, which then replaces the index file, so
+	// that an interrupted write does not leave behind a truncated index
+
+	std::string tmp = path;
+	tmp += ".tmp";
+
+	FILE* f = fopen(tmp.c_str(), "w");
+	if (f == NULL) {
+		cpl_unlock(&m_lock);
+		return CPL_E_PLATFORM_ERROR;
+	}
+
+	fprintf(f, "%s %d %d %u\n", CPL_REACHABILITY_FILE_MAGIC,
+			CPL_REACHABILITY_FILE_VERSION, CPL_REACHABILITY_TRAVERSALS,
+			(unsigned) m_ids.size());
+
+	for (size_t u = 0; u < m_ids.size(); u++) {
+		fprintf(f, "%llx %llx %x", m_ids[u].hi, m_ids[u].lo,
+				(unsigned) m_versions[u]);
+		for (int t = 0; t < CPL_REACHABILITY_TRAVERSALS; t++) {
+			fprintf(f, " %u %u", m_low[t][u], m_rank[t][u]);
+		}
+		fprintf(f, " %u", (unsigned) m_edges[u].size());
+		for (size_t i = 0; i < m_edges[u].size(); i++) {
+			fprintf(f, " %u", m_edges[u][i]);
+		}
+		fputc('\n', f);
+	}
+
+	bool ok = !ferror(f);
+	if (fclose(f) != 0) ok = false;
+	cpl_unlock(&m_lock);
+
+	if (!ok) {
+		remove(tmp.c_str());
+		return CPL_E_PLATFORM_ERROR;
+	}
+
+#ifdef _WINDOWS
+	remove(path);
+#endif
+	if (rename(tmp.c_str(), path) != 0) {
+		remove(tmp.c_str());
+		return CPL_E_PLATFORM_ERROR;
+	}
+
+	return CPL_OK;
+}
+
+
+
+/***************************************************************************/
+/** Reachability Index: Updates                                           **/
+/***************************************************************************/
+
+/**
+ * Find a node, creating it and all of its missing previous versions
+ * if necessary
+ *
+ * @param id the object ID
+ * @param version the object version
+ * @return the node index
+ */
+unsigned
+CPLReachabilityIndex::find_or_create(const cpl_id_t id,
+									 const cpl_version_t version)
+{
+	assert(version >= 0);
+	std::vector<unsigned>& versions = m_objects[id];
+
+	if (version < (cpl_version_t) versions.size()) return versions[version];
+
+	while ((cpl_version_t) versions.size() <= version) {
+		unsigned u = (unsigned) m_ids.size();
+
+		m_ids.push_back(id);
+		m_versions.push_back((cpl_version_t) versions.size());
+		m_edges.push_back(std::vector<unsigned>());
+		m_in_degree.push_back(0);
+		for (int t = 0; t < CPL_REACHABILITY_TRAVERSALS; t++) {
+			m_rank[t].push_back(m_next_rank);
+			m_low[t].push_back(m_next_rank);
+		}
+		m_next_rank++;
+
+		if (!versions.empty()) link(u, versions.back(), true);
+		versions.push_back(u);
+	}
+
+	return versions[version];
+}
+
+
+/**
+ * Add an edge without the lock
+ *
+ * @param from the node index of the descendant
+ * @param to the node index of the ancestor
+ * @param from_is_new whether the descendant was just created
+ */
+void
+CPLReachabilityIndex::link(const unsigned from, const unsigned to,
+						   const bool from_is_new)
+{
+	std::vector<unsigned>& e = m_edges[from];
+	if (std::find(e.begin(), e.end(), to) != e.end()) return;
+
+	e.push_back(to);
+	m_in_degree[to]++;
+
+	if (m_stale) return;
+
+
+	// The labels stay valid if nothing can reach the descendant yet and if
+	// the ancestor comes before it in all traversals
+
+	bool ok = from_is_new || m_in_degree[from] == 0;
+	for (int t = 0; ok && t < CPL_REACHABILITY_TRAVERSALS; t++) {
+		if (m_rank[t][to] >= m_rank[t][from]) ok = false;
+	}
+
+	if (!ok) {
+		m_stale = true;
+		return;
+	}
+
+	for (int t = 0; t < CPL_REACHABILITY_TRAVERSALS; t++) {
+		if (m_low[t][to] < m_low[t][from]) m_low[t][from] = m_low[t][to];
+	}
+}
+
+
+/**
+ * Add a new version of an object, together with the edge to its
+ * previous version
+ *
+ * @param id the object ID
+ * @param version the new version
+ */
+void
+CPLReachabilityIndex::add_version(const cpl_id_t id,
+								  const cpl_version_t version)
+{
+	cpl_lock(&m_lock);
+	find_or_create(id, version);
+	cpl_unlock(&m_lock);
+}
+
+
+/**
+ * Add an ancestry edge
+ *
+ * @param from_id the ID of the descendant
+ * @param from_version the version of the descendant
+ * @param to_id the ID of the ancestor
+ * @param to_version the version of the ancestor
+ */
+void
+CPLReachabilityIndex::add_edge(const cpl_id_t from_id,
+							   const cpl_version_t from_version,
+							   const cpl_id_t to_id,
+							   const cpl_version_t to_version)
+{
+	cpl_lock(&m_lock);
+
+	unsigned to = find_or_create(to_id, to_version);
+	unsigned from = find_or_create(from_id, from_version);
+	link(from, to, false);
+
+	cpl_unlock(&m_lock);
+}
+
+
+/**
+ * Recompute all labels
+ */
+void
+CPLReachabilityIndex::relabel(void)
+{
+	size_t n = m_ids.size();
+	std::vector<unsigned> next_child(n);
+	std::vector<unsigned> stack;
+	std::vector<char> visited;
+
+
+	// Run an iterative post-order depth-first traversal from all nodes
+	// without descendants, visiting the roots and the children in the
+	// opposite order in each other traversal to get different labels
+
+	for (int t = 0; t < CPL_REACHABILITY_TRAVERSALS; t++) {
+		bool reverse = (t & 1) != 0;
+		unsigned rank = 1;
+
+		visited.assign(n, 0);
+		std::fill(next_child.begin(), next_child.end(), 0);
+		m_rank[t].resize(n);
+		m_low[t].resize(n);
+
+		for (size_t r = 0; r < n; r++) {
+			unsigned root = (unsigned) (reverse ? n - 1 - r : r);
+			if (visited[root] || m_in_degree[root] != 0) continue;
+
+			visited[root] = 1;
+			stack.push_back(root);
+
+			while (!stack.empty()) {
+				unsigned u = stack.back();
+				const std::vector<unsigned>& e = m_edges[u];
+
+				if (next_child[u] < e.size()) {
+					size_t i = next_child[u]++;
+					unsigned v = e[reverse ? e.size() - 1 - i : i];
+					if (!visited[v]) {
+						visited[v] = 1;
+						stack.push_back(v);
+					}
+					continue;
+				}
+
+				stack.pop_back();
+				m_rank[t][u] = rank;
+				m_low[t][u] = rank;
+				rank++;
+
+				for (size_t i = 0; i < e.size(); i++) {
+					if (m_low[t][e[i]] < m_low[t][u]) {
+						m_low[t][u] = m_low[t][e[i]];
+					}
+				}
+			}
+		}
+
+		m_next_rank = rank;
+	}
+
+	m_stale = false;
+}
+
+
+
+/***************************************************************************/
+/** Reachability Index: Queries                                           **/
+/***************************************************************************/
+
+/**
+ * Get the latest version of an object known to the index
+ *
+ * @param id the object ID
+ * @param out_version the pointer to store the version
+ * @return CPL_OK or CPL_E_NOT_FOUND if the object is not in the index
+ */
+cpl_return_t
+CPLReachabilityIndex::get_version(const cpl_id_t id,
+								  cpl_version_t* out_version)
+{
+	cpl_lock(&m_lock);
+	CPL_AutoUnlock __au(&m_lock);
+	(void) __au;
+
+	cpl_hash_map_id_t<std::vector<unsigned> >::type::iterator i
+		= m_objects.find(id);
+	if (i == m_objects.end() || i->second.empty()) return CPL_E_NOT_FOUND;
+
+	*out_version = (cpl_version_t) i->second.size() - 1;
+	return CPL_OK;
+}
+
+
+/**
+ * Determine whether the index contains an ancestry edge
+ *
+ * @param from_id the ID of the descendant
+ * @param from_version the version of the descendant
+ * @param to_id the ID of the ancestor
+ * @param to_version the version of the ancestor
+ * @return true if the edge is in the index
+ */
+bool
+CPLReachabilityIndex::has_edge(const cpl_id_t from_id,
+							   const cpl_version_t from_version,
+							   const cpl_id_t to_id,
+							   const cpl_version_t to_version)
+{
+	cpl_lock(&m_lock);
+	CPL_AutoUnlock __au(&m_lock);
+	(void) __au;
+
+	cpl_hash_map_id_t<std::vector<unsigned> >::type::iterator i, j;
+
+	i = m_objects.find(from_id);
+	j = m_objects.find(to_id);
+	if (i == m_objects.end() || j == m_objects.end()) return false;
+	if (from_version < 0 || to_version < 0) return false;
+	if (from_version >= (cpl_version_t) i->second.size()) return false;
+	if (to_version >= (cpl_version_t) j->second.size()) return false;
+
+	const std::vector<unsigned>& e = m_edges[i->second[from_version]];
+	return std::find(e.begin(), e.end(), j->second[to_version]) != e.end();
+}
+
+
+/**
+ * Determine whether a node is reachable from another node by a path
+ * of at least one edge
+ *
+ * @param u the start node
+ * @param v the target node
+ * @return true if v is reachable from u
+ */
+bool
+CPLReachabilityIndex::reachable(const unsigned u, const unsigned v)
+{
+	if (!contains(u, v)) return false;
+
+
+	// Start a new visit, resetting the marks only when they wrap around
+
+	if (m_visited.size() < m_ids.size()) m_visited.resize(m_ids.size(), 0);
+	if (++m_visit_mark == 0) {
+		std::fill(m_visited.begin(), m_visited.end(), 0);
+		m_visit_mark = 1;
+	}
+
+
+	// Depth-first search, pruned by the labels
+
+	std::vector<unsigned> stack;
+	stack.push_back(u);
+
+	while (!stack.empty()) {
+		unsigned x = stack.back();
+		stack.pop_back();
+
+		const std::vector<unsigned>& e = m_edges[x];
+		for (size_t i = 0; i < e.size(); i++) {
+			unsigned y = e[i];
+			if (y == v) return true;
+			if (m_visited[y] == m_visit_mark || !contains(y, v)) continue;
+			m_visited[y] = m_visit_mark;
+			stack.push_back(y);
+		}
+	}
+
+	return false;
+}
+
+
+/**
+ * Determine whether an object version is an ancestor of another
+ *
+ * @param id the ID of the descendant
+ * @param version the version of the descendant, or CPL_VERSION_NONE
+ *                for its latest version (or for any of its versions if
+ *                not transitive)
+ * @param ancestor_id the ID of the ancestor
+ * @param ancestor_version the version of the ancestor, or
+ *                         CPL_VERSION_NONE for any of its versions
+ * @param transitive whether to consider the ancestors of any depth
+ *                   instead of only the immediate ancestors
+ * @param out_result the pointer to store the result (0 or 1)
+ * @return CPL_OK, CPL_E_NOT_FOUND if either node is not in the index,
+ *         or an error code
+ */
+cpl_return_t
+CPLReachabilityIndex::is_ancestor(const cpl_id_t id,
+								  const cpl_version_t version,
+								  const cpl_id_t ancestor_id,
+								  const cpl_version_t ancestor_version,
+								  const bool transitive,
+								  int* out_result)
+{
+	cpl_lock(&m_lock);
+	CPL_AutoUnlock __au(&m_lock);
+	(void) __au;
+
+
+	// Find the nodes
+
+	cpl_hash_map_id_t<std::vector<unsigned> >::type::iterator i, j;
+
+	i = m_objects.find(id);
+	j = m_objects.find(ancestor_id);
+	if (i == m_objects.end() || j == m_objects.end()) return CPL_E_NOT_FOUND;
+
+	const std::vector<unsigned>& a = i->second;
+	const std::vector<unsigned>& b = j->second;
+
+	if (version != CPL_VERSION_NONE
+			&& (version < 0 || version >= (cpl_version_t) a.size())) {
+		return CPL_E_NOT_FOUND;
+	}
+	if (ancestor_version != CPL_VERSION_NONE
+			&& (ancestor_version < 0
+				|| ancestor_version >= (cpl_version_t) b.size())) {
+		return CPL_E_NOT_FOUND;
+	}
+
+	*out_result = 0;
+
+
+	// Immediate ancestors: check the edges of the given version, or of all
+	// versions except for the edges between the versions themselves
+
+	if (!transitive) {
+		size_t first = version == CPL_VERSION_NONE ? 0 : version;
+		size_t last = version == CPL_VERSION_NONE ? a.size() - 1 : version;
+
+		for (size_t k = first; k <= last; k++) {
+			const std::vector<unsigned>& e = m_edges[a[k]];
+			for (size_t l = 0; l < e.size(); l++) {
+				unsigned y = e[l];
+				if (m_ids[y] != ancestor_id) continue;
+				if (version == CPL_VERSION_NONE && ancestor_id == id) continue;
+				if (ancestor_version == CPL_VERSION_NONE
+						|| m_versions[y] == ancestor_version) {
+					*out_result = 1;
+					return CPL_OK;
+				}
+			}
+		}
+
+		return CPL_OK;
+	}
+
+
+	// Transitive ancestors: since each version is an ancestor of the next
+	// one, the latest version reaches everything that the object reaches,
+	// and any version of the ancestor is reachable if its first one is
+
+	if (version == CPL_VERSION_NONE && ancestor_version == CPL_VERSION_NONE
+			&& ancestor_id == id) {
+		return CPL_OK;
+	}
+
+	unsigned u = version == CPL_VERSION_NONE ? a.back() : a[version];
+	unsigned v = ancestor_version == CPL_VERSION_NONE ? b.front()
+													  : b[ancestor_version];
+
+	if (m_stale) relabel();
+	*out_result = reachable(u, v) ? 1 : 0;
+
+	return CPL_OK;
+}
@@ -0,0 +1,339 @@
+/*
+ * cpl-reachability.h
+ * Core Provenance Library
+ *
+ * Copyright 2011
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#ifndef __CPL_REACHABILITY_H__
+#define __CPL_REACHABILITY_H__
+
+#include <cplxx.h>
+#include <cpl-db-backend.h>
+#include <private/cpl-lock.h>
+
+#include <vector>
+
+
+/***************************************************************************/
+/** Constants                                                             **/
+/***************************************************************************/
+
+/**
+ * The number of independent interval labels per node. More labels prune
+ * more of the graph during a query at the cost of memory.
+ */
+#define CPL_REACHABILITY_TRAVERSALS		2
+
+/**
+ * The number of version nodes per batched backend call while building
+ * the index
+ */
+#define CPL_REACHABILITY_BATCH_SIZE		4096
+
+/**
+ * The index of a node that does not exist
+ */
+#define CPL_REACHABILITY_NONE			((unsigned) -1)
+
+
+
+/***************************************************************************/
+/** Reachability Index                                                    **/
+/***************************************************************************/
+
+/**
+ * An in-memory reachability index over the version DAG, in which the nodes
+ * are the object versions, and the edges point from each version to its
+ * immediate ancestors, including the previous version of the same object.
+ *
+ * Each node carries CPL_REACHABILITY_TRAVERSALS interval labels
+ * [low, rank], where rank is the post-order number of the node in a
+ * depth-first traversal and low is the smallest rank reachable from it
+ * (GRAIL labeling). If v is reachable from u, the labels of v are nested
+ * inside the labels of u, so a query answers most negative cases without
+ * a traversal and otherwise runs a depth-first search that skips all
+ * subgraphs whose labels do not contain the target.
+ *
+ * The cycle avoidance algorithm adds edges only from newly created
+ * versions, which do not have any descendants yet, so a new node can
+ * simply receive the next rank, which keeps the labels of all other nodes
+ * valid. Any other update marks the labels as stale, and they are then
+ * recomputed in linear time before the next query.
+ */
+class CPLReachabilityIndex
+{
+
+public:
+
+	/**
+	 * Create an empty index
+	 */
+	CPLReachabilityIndex(void);
+
+	/**
+	 * Destroy the index
+	 */
+	~CPLReachabilityIndex(void);
+
+	/**
+	 * Remove all nodes and edges
+	 */
+	void
+	clear(void);
+
+	/**
+	 * Build the index from a scan of all objects and edges in the database.
+	 * The index is cleared first, so it should not be in use yet.
+	 *
+	 * @param backend the database backend
+	 * @return CPL_OK or an error code
+	 */
+	cpl_return_t
+	build(cpl_db_backend_t* backend);
+
+	/**
+	 * Load the index from a file
+	 *
+	 * @param path the file name
+	 * @return CPL_OK, CPL_E_NOT_FOUND if the file does not exist, or
+	 *         an error code if it could not be read
+	 */
+	cpl_return_t
+	load(const char* path);
+
+	/**
+	 * Write the index to a file
+	 *
+	 * @param path the file name
+	 * @return CPL_OK or an error code
+	 */
+	cpl_return_t
+	save(const char* path);
+
+	/**
+	 * Add a new version of an object, together with the edge to its
+	 * previous version
+	 *
+	 * @param id the object ID
+	 * @param version the new version
+	 */
+	void
+	add_version(const cpl_id_t id, const cpl_version_t version);
+
+	/**
+	 * Add an ancestry edge
+	 *
+	 * @param from_id the ID of the descendant
+	 * @param from_version the version of the descendant
+	 * @param to_id the ID of the ancestor
+	 * @param to_version the version of the ancestor
+	 */
+	void
+	add_edge(const cpl_id_t from_id, const cpl_version_t from_version,
+			 const cpl_id_t to_id, const cpl_version_t to_version);
+
+	/**
+	 * Get the latest version of an object known to the index
+	 *
+	 * @param id the object ID
+	 * @param out_version the pointer to store the version
+	 * @return CPL_OK or CPL_E_NOT_FOUND if the object is not in the index
+	 */
+	cpl_return_t
+	get_version(const cpl_id_t id, cpl_version_t* out_version);
+
+	/**
+	 * Determine whether the index contains an ancestry edge
+	 *
+	 * @param from_id the ID of the descendant
+	 * @param from_version the version of the descendant
+	 * @param to_id the ID of the ancestor
+	 * @param to_version the version of the ancestor
+	 * @return true if the edge is in the index
+	 */
+	bool
+	has_edge(const cpl_id_t from_id, const cpl_version_t from_version,
+			 const cpl_id_t to_id, const cpl_version_t to_version);
+
+	/**
+	 * Determine whether an object version is an ancestor of another
+	 *
+	 * @param id the ID of the descendant
+	 * @param version the version of the descendant, or CPL_VERSION_NONE
+	 *                for its latest version (or for any of its versions if
+	 *                not transitive)
+	 * @param ancestor_id the ID of the ancestor
+	 * @param ancestor_version the version of the ancestor, or
+	 *                         CPL_VERSION_NONE for any of its versions
+	 * @param transitive whether to consider the ancestors of any depth
+	 *                   instead of only the immediate ancestors
+	 * @param out_result the pointer to store the result (0 or 1)
+	 * @return CPL_OK, CPL_E_NOT_FOUND if either node is not in the index,
+	 *         or an error code
+	 */
+	cpl_return_t
+	is_ancestor(const cpl_id_t id, const cpl_version_t version,
+				const cpl_id_t ancestor_id,
+				const cpl_version_t ancestor_version,
+				const bool transitive, int* out_result);
+
+	/**
+	 * Get the number of nodes
+	 *
+	 * @return the number of version nodes in the index
+	 */
+	inline size_t
+	size(void) const { return m_ids.size(); }
+
+
+protected:
+
+	/**
+	 * Find a node, creating it and all of its missing previous versions
+	 * if necessary
+	 *
+	 * @param id the object ID
+	 * @param version the object version
+	 * @return the node index
+	 */
+	unsigned
+	find_or_create(const cpl_id_t id, const cpl_version_t version);
+
+	/**
+	 * Add an edge without the lock
+	 *
+	 * @param from the node index of the descendant
+	 * @param to the node index of the ancestor
+	 * @param from_is_new whether the descendant was just created
+	 */
+	void
+	link(const unsigned from, const unsigned to, const bool from_is_new);
+
+	/**
+	 * Recompute all labels
+	 */
+	void
+	relabel(void);
+
+	/**
+	 * Determine whether the labels of a node contain the labels of another
+	 *
+	 * @param u the outer node
+	 * @param v the inner node
+	 * @return true if all labels of v are nested in the labels of u
+	 */
+	inline bool
+	contains(const unsigned u, const unsigned v) const
+	{
+		for (int t = 0; t < CPL_REACHABILITY_TRAVERSALS; t++) {
+			if (m_low[t][u] > m_low[t][v] || m_rank[t][v] > m_rank[t][u]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Determine whether a node is reachable from another node by a path
+	 * of at least one edge
+	 *
+	 * @param u the start node
+	 * @param v the target node
+	 * @return true if v is reachable from u
+	 */
+	bool
+	reachable(const unsigned u, const unsigned v);
+
+
+protected:
+
+	/**
+	 * The lock
+	 */
+	cpl_lock_t m_lock;
+
+	/**
+	 * The nodes of each object, indexed by the version
+	 */
+	cpl_hash_map_id_t<std::vector<unsigned> >::type m_objects;
+
+	/**
+	 * The object ID of each node
+	 */
+	std::vector<cpl_id_t> m_ids;
+
+	/**
+	 * The version of each node
+	 */
+	std::vector<cpl_version_t> m_versions;
+
+	/**
+	 * The immediate ancestors of each node
+	 */
+	std::vector<std::vector<unsigned> > m_edges;
+
+	/**
+	 * The number of immediate descendants of each node
+	 */
+	std::vector<unsigned> m_in_degree;
+
+	/**
+	 * The post-order rank of each node in each traversal
+	 */
+	std::vector<unsigned> m_rank[CPL_REACHABILITY_TRAVERSALS];
+
+	/**
+	 * The lowest rank reachable from each node in each traversal
+	 */
+	std::vector<unsigned> m_low[CPL_REACHABILITY_TRAVERSALS];
+
+	/**
+	 * The rank for the next new node
+	 */
+	unsigned m_next_rank;
+
+	/**
+	 * Whether the labels need to be recomputed
+	 */
+	bool m_stale;
+
+	/**
+	 * The visit mark of each node in the current query
+	 */
+	std::vector<unsigned> m_visited;
+
+	/**
+	 * The visit mark of the current query
+	 */
+	unsigned m_visit_mark;
+};
+
+#endif
@@ -0,0 +1,448 @@
+/*
+ * cpl-result-cache.cpp
+ * Core Provenance Library
+ *
+ * Copyright 2011
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#include "stdafx.h"
+#include "cpl-result-cache.h"
+
+
+/***************************************************************************/
+/** Helpers                                                               **/
+/***************************************************************************/
+
+/**
+ * The estimated per-entry overhead of the cache, in bytes
+ */
+#define CPL_RESULT_CACHE_ENTRY_OVERHEAD		128
+
+
+/***************************************************************************/
+/** Class CPLResultCache                                                  **/
+/***************************************************************************/
+
+/**
+ * Compare two keys, ordering them by the object ID first
+ *
+ * @param other the other key
+ * @return true if this key is less than the other key
+ */
+bool
+CPLResultCache::Key::operator< (const Key& other) const
+{
+	if (!(id == other.id)) return id < other.id;
+	if (version != other.version) return version < other.version;
+	if (query != other.query) return query < other.query;
+	if (flags != other.flags) return flags < other.flags;
+	if (has_property != other.has_property) return !has_property;
+	return property < other.property;
+}
+
+
+/**
+ * Create an empty cache
+ *
+ * @param max_bytes the maximum memory footprint of the cached results
+ */
+CPLResultCache::CPLResultCache(const size_t max_bytes)
+{
+	m_lock = 0;
+	m_max_bytes = max_bytes;
+	m_bytes = 0;
+	m_references = 1;
+	memset(m_generations, 0, sizeof(m_generations));
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+/**
+ * Destroy the cache
+ */
+CPLResultCache::~CPLResultCache(void)
+{
+}
+
+
+/**
+ * Add a reference
+ */
+void
+CPLResultCache::reference(void)
+{
+	cpl_lock(&m_lock);
+	CPL_AutoUnlock __lock(&m_lock);
+
+	m_references++;
+}
+
+
+/**
+ * Remove a reference
+ *
+ * @return true if this was the last reference, in which case the caller
+ *         needs to destroy the cache
+ */
+bool
+CPLResultCache::release(void)
+{
+	cpl_lock(&m_lock);
+	CPL_AutoUnlock __lock(&m_lock);
+
+	assert(m_references > 0);
+	return --m_references == 0;
+}
+
+
+/**
+ * Get the invalidation generation of an object, which changes whenever the
+ * object is invalidated
+ *
+ * @param id the object ID
+ * @return the generation
+ */
+unsigned long
+CPLResultCache::generation(const cpl_id_t id)
+{
+	cpl_lock(&m_lock);
+	CPL_AutoUnlock __lock(&m_lock);
+
+	return generation_counter(id);
+}
+
+
+/**
+ * Find an entry that is still valid and mark it as the most recently used,
+ * dropping it if it is stale. The caller must hold the lock.
+ *
+ * @param key the key
+ * @param current_version the current version of the object
+ * @return the entry, or NULL if not found
+ */
+CPLResultCache::Entry*
+CPLResultCache::find(const Key& key, const cpl_version_t current_version)
+{
+	std::map<Key, entry_list_t::iterator>::iterator i = m_index.find(key);
+	if (i == m_index.end()) {
+		m_stats.misses++;
+		return NULL;
+	}
+
+	entry_list_t::iterator e = i->second;
+	if (!e->immutable && e->tag != current_version) {
+		remove(e);
+		m_stats.invalidations++;
+		m_stats.misses++;
+		return NULL;
+	}
+
+	m_entries.splice(m_entries.begin(), m_entries, e);
+	m_stats.hits++;
+	return &*e;
+}
+
+
+/**
+ * Add an entry, replacing any previous entry for the same key, and evict
+ * the least recently used entries if the cache is full. The caller must
+ * hold the lock.
+ *
+ * @param entry the entry, whose contents are moved into the cache
+ */
+void
+CPLResultCache::insert(Entry& entry)
+{
+	if (entry.bytes > m_max_bytes) return;
+
+	std::map<Key, entry_list_t::iterator>::iterator i
+		= m_index.find(entry.key);
+	if (i != m_index.end()) remove(i->second);
+
+	while (!m_entries.empty() && m_bytes + entry.bytes > m_max_bytes) {
+		entry_list_t::iterator last = m_entries.end();
+		remove(--last);
+		m_stats.evictions++;
+	}
+
+	m_entries.push_front(Entry());
+	Entry& e = m_entries.front();
+	e.key = entry.key;
+	e.immutable = entry.immutable;
+	e.tag = entry.tag;
+	e.ret = entry.ret;
+	e.bytes = entry.bytes;
+	e.edges.swap(entry.edges);
+	e.properties.swap(entry.properties);
+
+	m_index[e.key] = m_entries.begin();
+	m_bytes += e.bytes;
+}
+
+
+/**
+ * Remove an entry. The caller must hold the lock.
+ *
+ * @param i the entry
+ */
+void
+CPLResultCache::remove(entry_list_t::iterator i)
+{
+	m_bytes -= i->bytes;
+	m_index.erase(i->key);
+	m_entries.erase(i);
+}
+
+
+/**
+ * Look up the ancestors of an object
+ *
+ * @param id the object ID
+ * @param version the object version, or CPL_VERSION_NONE
+ * @param flags the CPL_A_* flags passed to the backend
+ * @param current_version the current version of the object
+ * @param out the vector to store the edges
+ * @param out_ret the pointer to store the return code of the backend
+ * @return true if found
+ */
+bool
+CPLResultCache::get_ancestry(const cpl_id_t id, const cpl_version_t version,
+							 const int flags,
+							 const cpl_version_t current_version,
+							 std::vector<cpl_ancestry_entry_t>& out,
+							 cpl_return_t* out_ret)
+{
+	Key key;
+	key.id = id;
+	key.version = version;
+	key.query = Q_ANCESTRY;
+	key.flags = flags;
+	key.has_property = false;
+
+	cpl_lock(&m_lock);
+	CPL_AutoUnlock __lock(&m_lock);
+
+	Entry* e = find(key, current_version);
+	if (e == NULL) return false;
+
+	out = e->edges;
+	*out_ret = e->ret;
+	return true;
+}
+
+
+/**
+ * Add the ancestors of an object
+ *
+ * @param id the object ID
+ * @param version the object version, or CPL_VERSION_NONE
+ * @param flags the CPL_A_* flags passed to the backend
+ * @param current_version the current version of the object, determined
+ *                        before calling the backend
+ * @param generation the generation of the object, determined before calling
+ *                   the backend
+ * @param edges the edges
+ * @param ret the return code of the backend
+ */
+void
+CPLResultCache::put_ancestry(const cpl_id_t id, const cpl_version_t version,
+							 const int flags,
+							 const cpl_version_t current_version,
+							 const unsigned long generation,
+							 const std::vector<cpl_ancestry_entry_t>& edges,
+							 const cpl_return_t ret)
+{
+	Entry entry;
+	entry.key.id = id;
+	entry.key.version = version;
+	entry.key.query = Q_ANCESTRY;
+	entry.key.flags = flags;
+	entry.key.has_property = false;
+	entry.immutable = version != CPL_VERSION_NONE
+		&& version < current_version;
+	entry.tag = current_version;
+	entry.ret = ret;
+	entry.edges = edges;
+	entry.bytes = CPL_RESULT_CACHE_ENTRY_OVERHEAD
+		+ edges.size() * sizeof(cpl_ancestry_entry_t);
+
+	cpl_lock(&m_lock);
+	CPL_AutoUnlock __lock(&m_lock);
+
+	// Drop the result if the object was invalidated while the backend was
+	// running, since the result might be older than the update
+
+	if (generation_counter(id) != generation) return;
+
+	insert(entry);
+}
+
+
+/**
+ * Look up the properties of an object
+ *
+ * @param id the object ID
+ * @param version the object version, or CPL_VERSION_NONE
+ * @param key the property name, or NULL for all properties
+ * @param current_version the current version of the object
+ * @param out the vector to store the properties
+ * @param out_ret the pointer to store the return code of the backend
+ * @return true if found
+ */
+bool
+CPLResultCache::get_properties(const cpl_id_t id,
+							   const cpl_version_t version,
+							   const char* key,
+							   const cpl_version_t current_version,
+							   std::vector<cplxx_property_entry_t>& out,
+							   cpl_return_t* out_ret)
+{
+	Key k;
+	k.id = id;
+	k.version = version;
+	k.query = Q_PROPERTIES;
+	k.flags = 0;
+	k.has_property = key != NULL;
+	if (key != NULL) k.property = key;
+
+	cpl_lock(&m_lock);
+	CPL_AutoUnlock __lock(&m_lock);
+
+	Entry* e = find(k, current_version);
+	if (e == NULL) return false;
+
+	out = e->properties;
+	*out_ret = e->ret;
+	return true;
+}
+
+
+/**
+ * Add the properties of an object
+ *
+ * @param id the object ID
+ * @param version the object version, or CPL_VERSION_NONE
+ * @param key the property name, or NULL for all properties
+ * @param current_version the current version of the object, determined
+ *                        before calling the backend
+ * @param generation the generation of the object, determined before calling
+ *                   the backend
+ * @param properties the properties
+ * @param ret the return code of the backend
+ */
+void
+CPLResultCache::put_properties(const cpl_id_t id,
+							   const cpl_version_t version,
+							   const char* key,
+							   const cpl_version_t current_version,
+							   const unsigned long generation,
+							   const std::vector<cplxx_property_entry_t>&
+							       properties,
+							   const cpl_return_t ret)
+{
+	Entry entry;
+	entry.key.id = id;
+	entry.key.version = version;
+	entry.key.query = Q_PROPERTIES;
+	entry.key.flags = 0;
+	entry.key.has_property = key != NULL;
+	if (key != NULL) entry.key.property = key;
+	entry.immutable = version != CPL_VERSION_NONE
+		&& version < current_version;
+	entry.tag = current_version;
+	entry.ret = ret;
+	entry.properties = properties;
+	entry.bytes = CPL_RESULT_CACHE_ENTRY_OVERHEAD
+		+ entry.key.property.size();
+	for (size_t i = 0; i < properties.size(); i++) {
+		entry.bytes += sizeof(cplxx_property_entry_t)
+			+ properties[i].key.size() + properties[i].value.size();
+	}
+
+	cpl_lock(&m_lock);
+	CPL_AutoUnlock __lock(&m_lock);
+
+	// Drop the result if the object was invalidated while the backend was
+	// running, since the result might be older than the update
+
+	if (generation_counter(id) != generation) return;
+
+	insert(entry);
+}
+
+
+/**
+ * Drop all results for the given object that can still change
+ *
+ * @param id the object ID
+ */
+void
+CPLResultCache::invalidate(const cpl_id_t id)
+{
+	Key first;
+	first.id = id;
+	first.version = CPL_VERSION_NONE;
+	first.query = 0;
+	first.flags = 0;
+	first.has_property = false;
+
+	cpl_lock(&m_lock);
+	CPL_AutoUnlock __lock(&m_lock);
+
+	generation_counter(id)++;
+
+	std::map<Key, entry_list_t::iterator>::iterator i
+		= m_index.lower_bound(first);
+	while (i != m_index.end() && i->first.id == id) {
+		entry_list_t::iterator e = i->second;
+		i++;
+		if (e->immutable) continue;
+		remove(e);
+		m_stats.invalidations++;
+	}
+}
+
+
+/**
+ * Get the statistics
+ *
+ * @param out the pointer to store the statistics
+ */
+void
+CPLResultCache::get_stats(cpl_result_cache_stats_t* out)
+{
+	cpl_lock(&m_lock);
+	CPL_AutoUnlock __lock(&m_lock);
+
+	*out = m_stats;
+	out->entries = m_entries.size();
+	out->bytes = m_bytes;
+	out->max_bytes = m_max_bytes;
+}
@@ -0,0 +1,344 @@
+/*
+ * cpl-result-cache.h
+ * Core Provenance Library
+ *
+ * Copyright 2011
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#ifndef __CPL_RESULT_CACHE_H__
+#define __CPL_RESULT_CACHE_H__
+
+#include <cplxx.h>
+#include <private/cpl-lock.h>
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+
+/***************************************************************************/
+/** Constants                                                             **/
+/***************************************************************************/
+
+/**
+ * The number of invalidation generation counters, which are shared by the
+ * objects whose IDs hash to the same counter
+ */
+#define CPL_RESULT_CACHE_GENERATIONS	1024
+
+
+
+/***************************************************************************/
+/** Result Cache                                                          **/
+/***************************************************************************/
+
+/**
+ * A bounded LRU cache of the results of cpl_get_object_ancestry() for the
+ * ancestors and of cpl_get_properties().
+ *
+ * The cycle avoidance algorithm adds edges only from newly created
+ * versions, and properties are added only to the current version, so the
+ * results for a version older than the current version of the object never
+ * change, and they are kept until evicted. All other results are tagged
+ * with the current version of the object at the time of the query, and they
+ * are treated as stale as soon as the object has a different version. The
+ * results for an object are also dropped when the object is thawed or when
+ * a property is added to it through this instance of the library.
+ *
+ * A query can race with an update that invalidates the object after the
+ * backend returned the old result, but before the result is added to the
+ * cache. The caller thus captures the invalidation generation of the object
+ * before calling the backend, and the result is not added if the object was
+ * invalidated since then.
+ *
+ * The cache is reference counted, so that it can be disabled while other
+ * threads still use it. It is created with one reference, and the last
+ * release() tells the caller to destroy it.
+ */
+class CPLResultCache
+{
+
+public:
+
+	/**
+	 * Create an empty cache
+	 *
+	 * @param max_bytes the maximum memory footprint of the cached results
+	 */
+	CPLResultCache(const size_t max_bytes);
+
+	/**
+	 * Destroy the cache
+	 */
+	~CPLResultCache(void);
+
+	/**
+	 * Add a reference
+	 */
+	void
+	reference(void);
+
+	/**
+	 * Remove a reference
+	 *
+	 * @return true if this was the last reference, in which case the
+	 *         caller needs to destroy the cache
+	 */
+	bool
+	release(void);
+
+	/**
+	 * Get the invalidation generation of an object, which changes whenever
+	 * the object is invalidated
+	 *
+	 * @param id the object ID
+	 * @return the generation
+	 */
+	unsigned long
+	generation(const cpl_id_t id);
+
+	/**
+	 * Look up the ancestors of an object
+	 *
+	 * @param id the object ID
+	 * @param version the object version, or CPL_VERSION_NONE
+	 * @param flags the CPL_A_* flags passed to the backend
+	 * @param current_version the current version of the object
+	 * @param out the vector to store the edges
+	 * @param out_ret the pointer to store the return code of the backend
+	 * @return true if found
+	 */
+	bool
+	get_ancestry(const cpl_id_t id, const cpl_version_t version,
+				 const int flags, const cpl_version_t current_version,
+				 std::vector<cpl_ancestry_entry_t>& out,
+				 cpl_return_t* out_ret);
+
+	/**
+	 * Add the ancestors of an object
+	 *
+	 * @param id the object ID
+	 * @param version the object version, or CPL_VERSION_NONE
+	 * @param flags the CPL_A_* flags passed to the backend
+	 * @param current_version the current version of the object, determined
+	 *                        before calling the backend
+	 * @param generation the generation of the object, determined before
+	 *                   calling the backend
+	 * @param edges the edges
+	 * @param ret the return code of the backend
+	 */
+	void
+	put_ancestry(const cpl_id_t id, const cpl_version_t version,
+				 const int flags, const cpl_version_t current_version,
+				 const unsigned long generation,
+				 const std::vector<cpl_ancestry_entry_t>& edges,
+				 const cpl_return_t ret);
+
+	/**
+	 * Look up the properties of an object
+	 *
+	 * @param id the object ID
+	 * @param version the object version, or CPL_VERSION_NONE
+	 * @param key the property name, or NULL for all properties
+	 * @param current_version the current version of the object
+	 * @param out the vector to store the properties
+	 * @param out_ret the pointer to store the return code of the backend
+	 * @return true if found
+	 */
+	bool
+	get_properties(const cpl_id_t id, const cpl_version_t version,
+				   const char* key, const cpl_version_t current_version,
+				   std::vector<cplxx_property_entry_t>& out,
+				   cpl_return_t* out_ret);
+
+	/**
+	 * Add the properties of an object
+	 *
+	 * @param id the object ID
+	 * @param version the object version, or CPL_VERSION_NONE
+	 * @param key the property name, or NULL for all properties
+	 * @param current_version the current version of the object, determined
+	 *                        before calling the backend
+	 * @param generation the generation of the object, determined before
+	 *                   calling the backend
+	 * @param properties the properties
+	 * @param ret the return code of the backend
+	 */
+	void
+	put_properties(const cpl_id_t id, const cpl_version_t version,
+				   const char* key, const cpl_version_t current_version,
+				   const unsigned long generation,
+				   const std::vector<cplxx_property_entry_t>& properties,
+				   const cpl_return_t ret);
+
+	/**
+	 * Drop all results for the given object that can still change
+	 *
+	 * @param id the object ID
+	 */
+	void
+	invalidate(const cpl_id_t id);
+
+	/**
+	 * Get the statistics
+	 *
+	 * @param out the pointer to store the statistics
+	 */
+	void
+	get_stats(cpl_result_cache_stats_t* out);
+
+
+protected:
+
+	/**
+	 * The kinds of the cached queries
+	 */
+	enum {
+		Q_ANCESTRY,
+		Q_PROPERTIES,
+	};
+
+	/**
+	 * The key of a cached result
+	 */
+	struct Key {
+		cpl_id_t id;
+		cpl_version_t version;
+		int query;
+		int flags;
+		bool has_property;
+		std::string property;
+
+		bool operator< (const Key& other) const;
+	};
+
+	/**
+	 * A cached result
+	 */
+	struct Entry {
+		Key key;
+		bool immutable;
+		cpl_version_t tag;
+		cpl_return_t ret;
+		size_t bytes;
+		std::vector<cpl_ancestry_entry_t> edges;
+		std::vector<cplxx_property_entry_t> properties;
+	};
+
+	/**
+	 * The list of entries, ordered from the most recently used
+	 */
+	typedef std::list<Entry> entry_list_t;
+
+	/**
+	 * Find an entry that is still valid and mark it as the most recently
+	 * used, dropping it if it is stale. The caller must hold the lock.
+	 *
+	 * @param key the key
+	 * @param current_version the current version of the object
+	 * @return the entry, or NULL if not found
+	 */
+	Entry*
+	find(const Key& key, const cpl_version_t current_version);
+
+	/**
+	 * Add an entry, replacing any previous entry for the same key, and
+	 * evict the least recently used entries if the cache is full. The
+	 * caller must hold the lock.
+	 *
+	 * @param entry the entry, whose contents are moved into the cache
+	 */
+	void
+	insert(Entry& entry);
+
+	/**
+	 * Remove an entry. The caller must hold the lock.
+	 *
+	 * @param i the entry
+	 */
+	void
+	remove(entry_list_t::iterator i);
+
+	/**
+	 * Get the invalidation generation counter of an object. The caller
+	 * must hold the lock.
+	 *
+	 * @param id the object ID
+	 * @return the reference to the counter
+	 */
+	inline unsigned long&
+	generation_counter(const cpl_id_t id)
+	{
+		return m_generations[(id.hi ^ id.lo) % CPL_RESULT_CACHE_GENERATIONS];
+	}
+
+	/**
+	 * The lock
+	 */
+	cpl_lock_t m_lock;
+
+	/**
+	 * The maximum memory footprint of the cached results
+	 */
+	size_t m_max_bytes;
+
+	/**
+	 * The memory footprint of the cached results
+	 */
+	size_t m_bytes;
+
+	/**
+	 * The entries, ordered from the most recently used
+	 */
+	entry_list_t m_entries;
+
+	/**
+	 * The index of the entries by their keys, ordered by the object ID
+	 */
+	std::map<Key, entry_list_t::iterator> m_index;
+
+	/**
+	 * The invalidation generation counters
+	 */
+	unsigned long m_generations[CPL_RESULT_CACHE_GENERATIONS];
+
+	/**
+	 * The number of references
+	 */
+	unsigned m_references;
+
+	/**
+	 * The statistics
+	 */
+	cpl_result_cache_stats_t m_stats;
+};
+
+#endif
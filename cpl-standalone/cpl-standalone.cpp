@@ -35,6 +35,16 @@
 #include "stdafx.h"
 #include "cpl-private.h"
 #include "cpl-platform.h"
+#include "cpl-lineage.h"
+#include "cpl-diff.h"
+#include "cpl-query.h"
+#include "cpl-reachability.h"
+#include "cpl-result-cache.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
 
 #ifndef _WINDOWS
 #include <errno.h>
@@ -73,7 +83,7 @@ EXPORT const char* CPL_S_STR[] = {
 /**
  * The last error code number
  */
-#define __CPL_E_LAST_ERROR				-17
+#define __CPL_E_LAST_ERROR				-18
 
 /**
  * Error code strings
@@ -97,6 +107,7 @@ EXPORT const char* CPL_E_STR[] = {
 	__CPL_E_STR__15,
 	__CPL_E_STR__16,
 	__CPL_E_STR__17,
+	__CPL_E_STR__18,
 };
 
 /**
@@ -151,6 +162,46 @@ static cpl_db_backend_t* cpl_db_backend = NULL;
  */
 static cpl_session_t cpl_session = CPL_NONE;
 
+/**
+ * The reachability index, or NULL if not enabled
+ */
+static CPLReachabilityIndex* cpl_reachability_index = NULL;
+
+/**
+ * The file of the reachability index, or empty to keep it only in memory
+ */
+static std::string cpl_reachability_index_path;
+
+/**
+ * The lock for the reachability index pointer, its file name, and the
+ * update log, which needs to be held while using the index
+ */
+static cpl_lock_t cpl_reachability_index_lock;
+
+/**
+ * The lock that serializes the rebuilds of the reachability index
+ */
+static cpl_lock_t cpl_reachability_rebuild_lock;
+
+/**
+ * The updates made while the reachability index is being rebuilt, which
+ * are replayed on the new index before it replaces the old one, or NULL if
+ * no rebuild is in progress. An update with the CPL_VERSION_NONE ancestor
+ * version adds only a version.
+ */
+static std::vector<std::pair<cpl_id_version_t, cpl_id_version_t> >*
+	cpl_reachability_index_log = NULL;
+
+/**
+ * The query result cache, or NULL if not enabled
+ */
+static CPLResultCache* cpl_result_cache = NULL;
+
+/**
+ * The lock for the result cache pointer
+ */
+static cpl_lock_t cpl_result_cache_lock;
+
 
 
 /***************************************************************************/
@@ -327,6 +378,117 @@ cpl_drop_object_cache(bool force)
 }
 
 
+/**
+ * Add a new version of an object to the reachability index, if enabled
+ *
+ * @param id the object ID
+ * @param version the new version
+ */
+static void
+cpl_reachability_add_version(const cpl_id_t id, const cpl_version_t version)
+{
+	cpl_lock(&cpl_reachability_index_lock);
+
+	if (cpl_reachability_index != NULL) {
+		cpl_reachability_index->add_version(id, version);
+	}
+
+	if (cpl_reachability_index_log != NULL) {
+		cpl_id_version_t from, to;
+		from.id = id;
+		from.version = version;
+		to.id = CPL_NONE;
+		to.version = CPL_VERSION_NONE;
+		cpl_reachability_index_log->push_back(std::make_pair(from, to));
+	}
+
+	cpl_unlock(&cpl_reachability_index_lock);
+}
+
+
+/**
+ * Add an ancestry edge to the reachability index, if enabled
+ *
+ * @param from_id the ID of the descendant
+ * @param from_version the version of the descendant
+ * @param to_id the ID of the ancestor
+ * @param to_version the version of the ancestor
+ */
+static void
+cpl_reachability_add_edge(const cpl_id_t from_id,
+						  const cpl_version_t from_version,
+						  const cpl_id_t to_id,
+						  const cpl_version_t to_version)
+{
+	cpl_lock(&cpl_reachability_index_lock);
+
+	if (cpl_reachability_index != NULL) {
+		cpl_reachability_index->add_edge(from_id, from_version,
+										 to_id, to_version);
+	}
+
+	if (cpl_reachability_index_log != NULL) {
+		cpl_id_version_t from, to;
+		from.id = from_id;
+		from.version = from_version;
+		to.id = to_id;
+		to.version = to_version;
+		cpl_reachability_index_log->push_back(std::make_pair(from, to));
+	}
+
+	cpl_unlock(&cpl_reachability_index_lock);
+}
+
+
+/**
+ * Get a reference to the result cache, which keeps it alive even if it is
+ * disabled in the meantime
+ *
+ * @return the cache, which needs to be released, or NULL if not enabled
+ */
+static CPLResultCache*
+cpl_result_cache_acquire(void)
+{
+	cpl_lock(&cpl_result_cache_lock);
+
+	CPLResultCache* cache = cpl_result_cache;
+	if (cache != NULL) cache->reference();
+
+	cpl_unlock(&cpl_result_cache_lock);
+	return cache;
+}
+
+
+/**
+ * Release a reference to the result cache, destroying it if it was the
+ * last reference
+ *
+ * @param cache the cache
+ */
+static void
+cpl_result_cache_release(CPLResultCache* cache)
+{
+	if (cache->release()) delete cache;
+}
+
+
+/**
+ * Drop the results for the given object from the result cache, if enabled.
+ * This needs to be called after the object is updated in the database.
+ *
+ * @param id the object ID
+ */
+static void
+cpl_result_cache_invalidate(const cpl_id_t id)
+{
+	CPLResultCache* cache = cpl_result_cache_acquire();
+	if (cache == NULL) return;
+
+	cache->invalidate(id);
+	cpl_result_cache_release(cache);
+}
+
+
 /**
  * Create (thaw) a new version of the given provenance object if necessary
  *
@@ -423,7 +585,11 @@ cpl_thaw(const cpl_id_t id,
 		while (!CPL_IS_OK(r));
 
 		assert(version != CPL_VERSION_NONE);
+
+		cpl_reachability_add_version(id, version);
 	}
+
+	cpl_result_cache_invalidate(id);
 	
 
 	// Update the cache
@@ -755,6 +921,25 @@ cpl_detach(void)
 
 	cpl_drop_object_cache(true);
 
+	cpl_lock(&cpl_reachability_rebuild_lock);
+	cpl_lock(&cpl_reachability_index_lock);
+	if (cpl_reachability_index != NULL) {
+		if (!cpl_reachability_index_path.empty()) {
+			cpl_reachability_index->save(cpl_reachability_index_path.c_str());
+		}
+		delete cpl_reachability_index;
+		cpl_reachability_index = NULL;
+		cpl_reachability_index_path.clear();
+	}
+	cpl_unlock(&cpl_reachability_index_lock);
+	cpl_unlock(&cpl_reachability_rebuild_lock);
+
+	cpl_lock(&cpl_result_cache_lock);
+	CPLResultCache* cache = cpl_result_cache;
+	cpl_result_cache = NULL;
+	cpl_unlock(&cpl_result_cache_lock);
+	if (cache != NULL) cpl_result_cache_release(cache);
+
 	cpl_db_backend->cpl_db_destroy(cpl_db_backend);
 	cpl_db_backend = NULL;
 
@@ -850,6 +1035,8 @@ cpl_create_object(const char* originator,
 											   cpl_session);
 	CPL_RUNTIME_VERIFY(ret);
 
+	cpl_reachability_add_version(id, 0);
+
 
 	// Create an in-memory state
 
@@ -1141,11 +1328,14 @@ cpl_add_property(const cpl_id_t id,
 
     // Call the backend
 
-	return cpl_db_backend->cpl_db_add_property(cpl_db_backend,
-											   id,
-                                               version,
-											   key,
-											   value);
+	ret = cpl_db_backend->cpl_db_add_property(cpl_db_backend,
+											  id,
+											  version,
+											  key,
+											  value);
+
+	cpl_result_cache_invalidate(id);
+	return ret;
 }
 
 
@@ -1345,6 +1535,8 @@ cpl_add_dependency(const cpl_id_t from_id,
 	}
 	while (!CPL_IS_OK(r));
 
+	cpl_reachability_add_version(from_id, from_version);
+
 	if (obj_from != NULL) {
 		obj_from->frozen = false;
 		obj_from->last_session = cpl_session;
@@ -1363,6 +1555,10 @@ cpl_add_dependency(const cpl_id_t from_id,
 																to_id,
 																to_version,
 																type));
+
+	cpl_reachability_add_edge(from_id, from_version, to_id, to_version);
+
+	cpl_result_cache_invalidate(from_id);
 	
 
 	// Update the ancestor list
@@ -1386,362 +1582,2486 @@ cpl_add_dependency(const cpl_id_t from_id,
 
 
 /***************************************************************************/
-/** Public API: Provenance Access API                                     **/
+/** Private API: Helpers for the Provenance Access API                    **/
 /***************************************************************************/
 
 
 /**
- * Get a version of a provenance object.
- *
- * @param id the object ID
- * @param out_version the pointer to store the version of the object
- * @return CPL_OK or an error code
+ * A version node visited by cpl_get_object_lineage()
  */
-extern "C" EXPORT cpl_return_t
-cpl_get_version(const cpl_id_t id,
-				cpl_version_t* out_version)
-{
-	CPL_ENSURE_INITALIZED;
-	cpl_version_t version;
+typedef std::pair<cpl_id_t, cpl_version_t> cpl_lineage_node_t;
 
-	if (cpl_cache && !cpl_cache_check) {
-		cpl_open_object_t* obj = NULL;
-		CPL_RUNTIME_VERIFY(cpl_get_open_object_handle(id, &obj));
-		version = obj->version;
-		cpl_unlock(&obj->locked);
-	}
-	else {
-		cpl_return_t ret;
-		ret = cpl_db_backend->cpl_db_get_version(cpl_db_backend,
-												 id, &version);
-		CPL_RUNTIME_VERIFY(ret);
-	}
 
-	if (out_version != NULL) *out_version = version;
-	return CPL_OK;
-}
+/**
+ * The context for cpl_cb_lineage_edge()
+ */
+typedef struct {
+
+	/// The user-provided iterator
+	cpl_ancestry_iterator_t iterator;
+
+	/// The user-provided context
+	void* context;
+
+	/// The set of visited nodes
+	std::set<cpl_lineage_node_t> visited;
+
+	/// The nodes in the next level of the traversal
+	std::vector<cpl_id_version_t> next;
+
+	/// Whether we traversed at least one edge
+	bool found;
+
+} cpl_lineage_context_t;
 
 
 /**
- * Get the ID of the current session.
+ * The iterator callback used by cpl_get_object_lineage(), which adds the
+ * newly discovered nodes to the next level of the traversal and then
+ * passes the edge to the user-provided iterator.
  *
- * @param out_session the pointer to store the ID of the current session
+ * @param query_object_id the ID of the object on which we are querying
+ * @param query_object_version the version of the queried object
+ * @param other_object_id the ID of the object on the other end of the
+ *                        dependency/ancestry edge
+ * @param other_object_version the version of the other object
+ * @param type the type of the data or the control dependency
+ * @param context the pointer to cpl_lineage_context_t
  * @return CPL_OK or an error code
  */
-extern "C" EXPORT cpl_return_t
-cpl_get_current_session(cpl_session_t* out_session)
+static cpl_return_t
+cpl_cb_lineage_edge(const cpl_id_t query_object_id,
+					const cpl_version_t query_object_version,
+					const cpl_id_t other_object_id,
+					const cpl_version_t other_object_version,
+					const int type,
+					void* context)
 {
-	CPL_ENSURE_INITALIZED;
+	cpl_lineage_context_t* ctx = (cpl_lineage_context_t*) context;
+	ctx->found = true;
+
+	cpl_lineage_node_t n(other_object_id, other_object_version);
+	if (ctx->visited.insert(n).second) {
+		cpl_id_version_t e;
+		e.id = other_object_id;
+		e.version = other_object_version;
+		ctx->next.push_back(e);
+	}
 
-	if (out_session != NULL) *out_session = cpl_session;
-	return CPL_OK;
+	return ctx->iterator(query_object_id, query_object_version,
+						 other_object_id, other_object_version,
+						 type, ctx->context);
 }
 
 
 /**
- * Get information about the given provenance session.
+ * The context for cpl_cb_transitive_ancestry()
+ */
+typedef struct {
+
+	/// The user-provided iterator
+	cpl_ancestry_iterator_t iterator;
+
+	/// The user-provided context
+	void* context;
+
+	/// The start node
+	cpl_lineage_node_t start;
+
+	/// Whether to skip all versions of the start object
+	bool skip_object;
+
+	/// The set of already returned nodes
+	std::set<cpl_lineage_node_t> returned;
+
+} cpl_transitive_ancestry_context_t;
+
+
+/**
+ * The iterator callback used by cpl_get_transitive_ancestry(), which passes
+ * each reachable node to the user-provided iterator exactly once
  *
- * @param id the session ID
- * @param out_info the pointer to store the session info structure
+ * @param query_object_id the ID of the object on which we are querying
+ * @param query_object_version the version of the queried object
+ * @param other_object_id the ID of the object on the other end of the
+ *                        dependency/ancestry edge
+ * @param other_object_version the version of the other object
+ * @param type the type of the data or the control dependency
+ * @param context the pointer to cpl_transitive_ancestry_context_t
  * @return CPL_OK or an error code
  */
-extern "C" EXPORT cpl_return_t
-cpl_get_session_info(const cpl_session_t id,
-					 cpl_session_info_t** out_info)
+static cpl_return_t
+cpl_cb_transitive_ancestry(const cpl_id_t query_object_id,
+						   const cpl_version_t query_object_version,
+						   const cpl_id_t other_object_id,
+						   const cpl_version_t other_object_version,
+						   const int type,
+						   void* context)
 {
-	CPL_ENSURE_INITALIZED;
-	CPL_ENSURE_NOT_NONE(id);
-	CPL_ENSURE_NOT_NULL(out_info);
+	cpl_transitive_ancestry_context_t* ctx
+		= (cpl_transitive_ancestry_context_t*) context;
 
+	if (ctx->skip_object && other_object_id == ctx->start.first) return CPL_OK;
 
-	// Call the database backend
+	cpl_lineage_node_t n(other_object_id, other_object_version);
+	if (!ctx->returned.insert(n).second) return CPL_OK;
 
-	return cpl_db_backend->cpl_db_get_session_info(cpl_db_backend, id,
-												   out_info);
+	return ctx->iterator(ctx->start.first, ctx->start.second,
+						 other_object_id, other_object_version,
+						 CPL_DEPENDENCY_NONE, ctx->context);
 }
 
 
 /**
- * Free cpl_session_info_t.
+ * The context for cpl_cb_is_ancestor()
+ */
+typedef struct {
+
+	/// The ancestor to look for
+	cpl_id_t ancestor_id;
+
+	/// The version of the ancestor, or CPL_VERSION_NONE for any version
+	cpl_version_t ancestor_version;
+
+	/// Whether the ancestor was found
+	bool found;
+
+} cpl_is_ancestor_context_t;
+
+
+/**
+ * The iterator callback used by cpl_is_ancestor() when it cannot use
+ * the reachability index
  *
- * @param info the pointer to the session info structure
- * @return CPL_OK or an error code
+ * @param query_object_id the ID of the object on which we are querying
+ * @param query_object_version the version of the queried object
+ * @param other_object_id the ID of the object on the other end of the
+ *                        dependency/ancestry edge
+ * @param other_object_version the version of the other object
+ * @param type the type of the data or the control dependency
+ * @param context the pointer to cpl_is_ancestor_context_t
+ * @return CPL_OK
  */
-extern "C" EXPORT cpl_return_t
-cpl_free_session_info(cpl_session_info_t* info)
+static cpl_return_t
+cpl_cb_is_ancestor(const cpl_id_t query_object_id,
+				   const cpl_version_t query_object_version,
+				   const cpl_id_t other_object_id,
+				   const cpl_version_t other_object_version,
+				   const int type,
+				   void* context)
 {
-	CPL_ENSURE_NOT_NULL(info);
+	cpl_is_ancestor_context_t* ctx = (cpl_is_ancestor_context_t*) context;
 
-	if (info->mac_address != NULL) free(info->mac_address);
-	if (info->user != NULL) free(info->user);
-	if (info->program != NULL) free(info->program);
-	if (info->cmdline != NULL) free(info->cmdline);
+	if (other_object_id == ctx->ancestor_id
+			&& (ctx->ancestor_version == CPL_VERSION_NONE
+				|| other_object_version == ctx->ancestor_version)) {
+		ctx->found = true;
+	}
 
-	free(info);
 	return CPL_OK;
 }
 
 
 /**
- * Get all objects in the database
+ * The iterator callback that collects the immediate ancestors of the latest
+ * version of an object for cpl_reachability_is_ancestor()
  *
- * @param flags a logical combination of CPL_I_* flags
- * @param iterator the iterator to be called for each matching object
- * @param context the caller-provided iterator context
- * @return CPL_OK or an error code
+ * @param query_object_id the ID of the object on which we are querying
+ * @param query_object_version the version of the queried object
+ * @param other_object_id the ID of the object on the other end of the
+ *                        dependency/ancestry edge
+ * @param other_object_version the version of the other object
+ * @param type the type of the data or the control dependency
+ * @param context the pointer to a vector of cpl_id_version_t
+ * @return CPL_OK
  */
-extern "C" EXPORT cpl_return_t
-cpl_get_all_objects(const int flags,
-					cpl_object_info_iterator_t iterator,
-					void* context)
+static cpl_return_t
+cpl_cb_collect_ancestors(const cpl_id_t query_object_id,
+						 const cpl_version_t query_object_version,
+						 const cpl_id_t other_object_id,
+						 const cpl_version_t other_object_version,
+						 const int type,
+						 void* context)
 {
-	CPL_ENSURE_INITALIZED;
-	CPL_ENSURE_NOT_NULL(iterator);
+	std::vector<cpl_id_version_t>* v
+		= (std::vector<cpl_id_version_t>*) context;
 
-	return cpl_db_backend->cpl_db_get_all_objects(cpl_db_backend, flags,
-                                                  iterator, context);
+	cpl_id_version_t n;
+	n.id = other_object_id;
+	n.version = other_object_version;
+	v->push_back(n);
+
+	return CPL_OK;
 }
 
 
 /**
- * Get information about the given provenance object.
+ * Answer cpl_is_ancestor() using the reachability index, if it is current
+ * for the queried object.
  *
- * @param id the object ID
- * @param out_info the pointer to store the object info structure
- * @return CPL_OK or an error code
+ * Edges are added only to the latest version of an object, and only until
+ * it gets a descendant, so all versions reachable from the queried version
+ * other than the latest version of the queried object itself are final. The
+ * index is thus current for the query if it knows the latest version of the
+ * object, and, if that version is queried, all of its immediate ancestors.
+ *
+ * @param id the ID of the descendant
+ * @param version the version of the descendant, or CPL_VERSION_NONE
+ * @param ancestor_id the ID of the ancestor
+ * @param ancestor_version the version of the ancestor, or CPL_VERSION_NONE
+ * @param transitive whether to consider the ancestors of any depth
+ * @param out_result the pointer to store the result (0 or 1)
+ * @return CPL_OK, CPL_E_NOT_FOUND if the index cannot answer the query, or
+ *         an error code
  */
-extern "C" EXPORT cpl_return_t
-cpl_get_object_info(const cpl_id_t id,
-					cpl_object_info_t** out_info)
+static cpl_return_t
+cpl_reachability_is_ancestor(const cpl_id_t id,
+							 const cpl_version_t version,
+							 const cpl_id_t ancestor_id,
+							 const cpl_version_t ancestor_version,
+							 const bool transitive,
+							 int* out_result)
 {
-	CPL_ENSURE_INITALIZED;
-	CPL_ENSURE_NOT_NONE(id);
-	CPL_ENSURE_NOT_NULL(out_info);
+	cpl_return_t ret;
 
 
-	// Get the latest version of the object, if available
+	// Get the latest version and its immediate ancestors from the database
 
-	cpl_version_t version_hint = CPL_VERSION_NONE;
-	if (cpl_cache && !cpl_cache_check) {
-		cpl_open_object_t* obj = NULL;
-		CPL_RUNTIME_VERIFY(cpl_get_open_object_handle(id, &obj));
-		version_hint = obj->version;
-		cpl_unlock(&obj->locked);
+	cpl_version_t latest;
+	ret = cpl_db_backend->cpl_db_get_version(cpl_db_backend, id, &latest);
+	if (!CPL_IS_OK(ret)) return CPL_E_NOT_FOUND;
+
+	std::vector<cpl_id_version_t> ancestors;
+	bool check_ancestors = version == CPL_VERSION_NONE || version == latest;
+	if (check_ancestors) {
+		ret = cpl_db_backend->cpl_db_get_object_ancestry(cpl_db_backend, id,
+				latest, CPL_D_ANCESTORS, CPL_A_NO_PREV_NEXT_VERSION,
+				cpl_cb_collect_ancestors, &ancestors);
+		if (!CPL_IS_OK(ret) && ret != CPL_S_NO_DATA) return CPL_E_NOT_FOUND;
 	}
 
 
-	// Call the database backend
+	// Check whether the index is current, and if so, use it
 
-	return cpl_db_backend->cpl_db_get_object_info(cpl_db_backend, id,
-												  version_hint, out_info);
+	cpl_lock(&cpl_reachability_index_lock);
+	CPL_AutoUnlock __au(&cpl_reachability_index_lock);
+	(void) __au;
+
+	if (cpl_reachability_index == NULL) return CPL_E_NOT_FOUND;
+
+	cpl_version_t indexed;
+	ret = cpl_reachability_index->get_version(id, &indexed);
+	if (!CPL_IS_OK(ret) || indexed != latest) return CPL_E_NOT_FOUND;
+
+	for (size_t i = 0; i < ancestors.size(); i++) {
+		if (!cpl_reachability_index->has_edge(id, latest,
+					ancestors[i].id, ancestors[i].version)) {
+			return CPL_E_NOT_FOUND;
+		}
+	}
+
+	return cpl_reachability_index->is_ancestor(id, version, ancestor_id,
+			ancestor_version, transitive, out_result);
 }
 
 
 /**
- * Free cpl_object_info_t.
- *
- * @param info the pointer to the object info structure.
- * @return CPL_OK or an error code
+ * A node discovered by one side of the search in cpl_find_provenance_path()
  */
-extern "C" EXPORT cpl_return_t
-cpl_free_object_info(cpl_object_info_t* info)
-{
-	CPL_ENSURE_NOT_NULL(info);
+typedef struct {
 
-	if (info->originator != NULL) free(info->originator);
-	if (info->name != NULL) free(info->name);
-	if (info->type != NULL) free(info->type);
+	/// The node from which it was discovered (itself for the start node)
+	cpl_lineage_node_t parent;
 
-	free(info);
-	return CPL_OK;
-}
+	/// The type of the edge between the parent and the node
+	int type;
+
+	/// The number of edges from the start of the search
+	int depth;
+
+} cpl_path_step_t;
 
 
 /**
- * Get information about the specific version of a provenance object.
- *
- * @param id the object ID
- * @param version the version of the given provenance object
- * @param out_info the pointer to store the version info structure
+ * The context for cpl_cb_path_edge(), which describes one side of the
+ * bidirectional search
+ */
+typedef struct {
+
+	/// The nodes discovered by this side
+	std::map<cpl_lineage_node_t, cpl_path_step_t>* visited;
+
+	/// The nodes discovered by the other side
+	std::map<cpl_lineage_node_t, cpl_path_step_t>* other;
+
+	/// The nodes in the next level of this side
+	std::vector<cpl_id_version_t> next;
+
+	/// The depth of the next level
+	int depth;
+
+	/// Whether the two sides met
+	bool met;
+
+	/// The node at which the sides met with the shortest combined path
+	cpl_lineage_node_t meet;
+
+	/// The length of the path through the meeting node
+	int length;
+
+} cpl_path_context_t;
+
+
+/**
+ * The iterator callback used by cpl_find_provenance_path(), which records
+ * the newly discovered nodes and checks whether the other side of the
+ * search has already reached them
+ *
+ * @param query_object_id the ID of the object on which we are querying
+ * @param query_object_version the version of the queried object
+ * @param other_object_id the ID of the object on the other end of the
+ *                        dependency/ancestry edge
+ * @param other_object_version the version of the other object
+ * @param type the type of the data or the control dependency
+ * @param context the pointer to cpl_path_context_t
+ * @return CPL_OK
+ */
+static cpl_return_t
+cpl_cb_path_edge(const cpl_id_t query_object_id,
+				 const cpl_version_t query_object_version,
+				 const cpl_id_t other_object_id,
+				 const cpl_version_t other_object_version,
+				 const int type,
+				 void* context)
+{
+	cpl_path_context_t* ctx = (cpl_path_context_t*) context;
+
+	cpl_lineage_node_t n(other_object_id, other_object_version);
+	if (ctx->visited->find(n) != ctx->visited->end()) return CPL_OK;
+
+	cpl_path_step_t step;
+	step.parent = cpl_lineage_node_t(query_object_id, query_object_version);
+	step.type = type;
+	step.depth = ctx->depth;
+	(*ctx->visited)[n] = step;
+
+	cpl_id_version_t e;
+	e.id = other_object_id;
+	e.version = other_object_version;
+	ctx->next.push_back(e);
+
+	std::map<cpl_lineage_node_t, cpl_path_step_t>::iterator i
+		= ctx->other->find(n);
+	if (i != ctx->other->end()) {
+		int length = ctx->depth + i->second.depth;
+		if (!ctx->met || length < ctx->length) {
+			ctx->met = true;
+			ctx->meet = n;
+			ctx->length = length;
+		}
+	}
+
+	return CPL_OK;
+}
+
+
+/**
+ * Expand one level of one side of the search in cpl_find_provenance_path()
+ * using a single batched call to the database backend
+ *
+ * @param frontier the nodes of the current level
+ * @param direction CPL_D_ANCESTORS or CPL_D_DESCENDANTS
+ * @param current_versions the cache of the current versions of objects
+ * @param ctx the context of the side, which receives the next level
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_path_expand(std::vector<cpl_id_version_t>& frontier,
+				const int direction,
+				cpl_hash_map_id_t<cpl_version_t>::type& current_versions,
+				cpl_path_context_t* ctx)
+{
+	cpl_return_t r;
+
+
+	// Add the previous or the next versions of the frontier nodes
+
+	std::vector<cpl_id_version_t>::iterator i;
+	for (i = frontier.begin(); i != frontier.end(); i++) {
+
+		if (direction == CPL_D_ANCESTORS) {
+			if (i->version <= 0) continue;
+			cpl_cb_path_edge(i->id, i->version, i->id, i->version - 1,
+					CPL_VERSION_GENERIC, ctx);
+		}
+		else {
+			cpl_hash_map_id_t<cpl_version_t>::type::iterator cv
+				= current_versions.find(i->id);
+			cpl_version_t c;
+			if (cv == current_versions.end()) {
+				CPL_RUNTIME_VERIFY(cpl_get_version(i->id, &c));
+				current_versions[i->id] = c;
+			}
+			else {
+				c = cv->second;
+			}
+
+			if (i->version >= c) continue;
+			cpl_cb_path_edge(i->id, i->version, i->id, i->version + 1,
+					CPL_VERSION_GENERIC, ctx);
+		}
+	}
+
+
+	// Fetch the edges of the entire level
+
+	r = cpl_db_backend->cpl_db_get_object_ancestry_batch(cpl_db_backend,
+			&frontier[0], frontier.size(), direction,
+			CPL_A_NO_PREV_NEXT_VERSION, cpl_cb_path_edge, ctx);
+	if (!CPL_IS_OK(r)) return r;
+
+	return CPL_OK;
+}
+
+
+
+/***************************************************************************/
+/** Public API: Provenance Access API                                     **/
+/***************************************************************************/
+
+
+/**
+ * Get a version of a provenance object.
+ *
+ * @param id the object ID
+ * @param out_version the pointer to store the version of the object
+ * @return CPL_OK or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_version(const cpl_id_t id,
+				cpl_version_t* out_version)
+{
+	CPL_ENSURE_INITALIZED;
+	cpl_version_t version;
+
+	if (cpl_cache && !cpl_cache_check) {
+		cpl_open_object_t* obj = NULL;
+		CPL_RUNTIME_VERIFY(cpl_get_open_object_handle(id, &obj));
+		version = obj->version;
+		cpl_unlock(&obj->locked);
+	}
+	else {
+		cpl_return_t ret;
+		ret = cpl_db_backend->cpl_db_get_version(cpl_db_backend,
+												 id, &version);
+		CPL_RUNTIME_VERIFY(ret);
+	}
+
+	if (out_version != NULL) *out_version = version;
+	return CPL_OK;
+}
+
+
+/**
+ * Get the ID of the current session.
+ *
+ * @param out_session the pointer to store the ID of the current session
+ * @return CPL_OK or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_current_session(cpl_session_t* out_session)
+{
+	CPL_ENSURE_INITALIZED;
+
+	if (out_session != NULL) *out_session = cpl_session;
+	return CPL_OK;
+}
+
+
+/**
+ * Get information about the given provenance session.
+ *
+ * @param id the session ID
+ * @param out_info the pointer to store the session info structure
+ * @return CPL_OK or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_session_info(const cpl_session_t id,
+					 cpl_session_info_t** out_info)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NONE(id);
+	CPL_ENSURE_NOT_NULL(out_info);
+
+
+	// Call the database backend
+
+	return cpl_db_backend->cpl_db_get_session_info(cpl_db_backend, id,
+												   out_info);
+}
+
+
+/**
+ * Free cpl_session_info_t.
+ *
+ * @param info the pointer to the session info structure
+ * @return CPL_OK or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_free_session_info(cpl_session_info_t* info)
+{
+	CPL_ENSURE_NOT_NULL(info);
+
+	if (info->mac_address != NULL) free(info->mac_address);
+	if (info->user != NULL) free(info->user);
+	if (info->program != NULL) free(info->program);
+	if (info->cmdline != NULL) free(info->cmdline);
+
+	free(info);
+	return CPL_OK;
+}
+
+
+/**
+ * Create a deep copy of cpl_session_info_t.
+ *
+ * @param info the session info structure to copy
+ * @param out_info the pointer to store the copy
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_copy_session_info(const cpl_session_info_t* info,
+					  cpl_session_info_t** out_info)
+{
+	cpl_session_info_t* p
+		= (cpl_session_info_t*) malloc(sizeof(cpl_session_info_t));
+	if (p == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
+	memcpy(p, info, sizeof(*p));
+
+	p->mac_address = info->mac_address == NULL
+		? NULL : strdup(info->mac_address);
+	p->user = info->user == NULL ? NULL : strdup(info->user);
+	p->program = info->program == NULL ? NULL : strdup(info->program);
+	p->cmdline = info->cmdline == NULL ? NULL : strdup(info->cmdline);
+
+	*out_info = p;
+	return CPL_OK;
+}
+
+
+/**
+ * Get information about several provenance sessions at once. The IDs do
+ * not need to be unique; each output slot receives its own structure.
+ *
+ * @param ids the array of session IDs
+ * @param count the number of session IDs
+ * @param out_infos the array of count pointers to store the session info
+ *                  structures, each of which needs to be freed using
+ *                  cpl_free_session_info(); all are set to NULL on error
+ * @return CPL_OK or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_session_info_batch(const cpl_session_t* ids,
+						   const size_t count,
+						   cpl_session_info_t** out_infos)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NULL(ids);
+	CPL_ENSURE_NOT_NULL(out_infos);
+
+	cpl_return_t r = CPL_OK;
+	std::map<cpl_session_t, size_t> first;
+	std::vector<cpl_session_t> unique;
+	std::vector<cpl_session_info_t*> infos;
+
+	for (size_t i = 0; i < count; i++) {
+		out_infos[i] = NULL;
+		CPL_ENSURE_NOT_NONE(ids[i]);
+		if (first.find(ids[i]) == first.end()) {
+			first[ids[i]] = i;
+			unique.push_back(ids[i]);
+		}
+	}
+	if (count == 0) return CPL_OK;
+
+
+	// Call the database backend, falling back to one query per session if
+	// the backend cannot batch the request
+
+	infos.resize(unique.size(), NULL);
+	r = cpl_db_backend->cpl_db_get_session_info_batch(cpl_db_backend,
+													  &unique[0],
+													  unique.size(),
+													  &infos[0]);
+	if (r == CPL_E_NOT_IMPLEMENTED) {
+		r = CPL_OK;
+		for (size_t i = 0; i < unique.size() && CPL_IS_OK(r); i++) {
+			r = cpl_db_backend->cpl_db_get_session_info(cpl_db_backend,
+														unique[i],
+														&infos[i]);
+		}
+	}
+	if (!CPL_IS_OK(r)) goto err;
+
+
+	// Distribute the results, copying them for the repeated IDs
+
+	for (size_t i = 0; i < unique.size(); i++) {
+		out_infos[first[unique[i]]] = infos[i];
+		infos[i] = NULL;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (out_infos[i] != NULL) continue;
+		r = cpl_copy_session_info(out_infos[first[ids[i]]], &out_infos[i]);
+		if (!CPL_IS_OK(r)) goto err;
+	}
+
+	return CPL_OK;
+
+
+	// Error handling
+
+err:
+	for (size_t i = 0; i < infos.size(); i++) {
+		if (infos[i] != NULL) cpl_free_session_info(infos[i]);
+	}
+	for (size_t i = 0; i < count; i++) {
+		if (out_infos[i] != NULL) cpl_free_session_info(out_infos[i]);
+		out_infos[i] = NULL;
+	}
+	return r;
+}
+
+
+/**
+ * Get all objects in the database
+ *
+ * @param flags a logical combination of CPL_I_* flags
+ * @param iterator the iterator to be called for each matching object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_all_objects(const int flags,
+					cpl_object_info_iterator_t iterator,
+					void* context)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NULL(iterator);
+
+	return cpl_db_backend->cpl_db_get_all_objects(cpl_db_backend, flags,
+                                                  iterator, context);
+}
+
+
+/**
+ * Get the objects created inside the given container. If recursive is
+ * nonzero, include also the contents of the nested containers (all their
+ * versions), at any depth.
+ *
+ * @param container the container ID
+ * @param version the container version, or CPL_VERSION_NONE for all
+ *                versions of the container
+ * @param recursive whether to descend into the nested containers
+ * @param flags a logical combination of CPL_I_* flags
+ * @param iterator the iterator to be called for each contained object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA if the container is empty, or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_contained_objects(const cpl_id_t container,
+						  const cpl_version_t version,
+						  const int recursive,
+						  const int flags,
+						  cpl_object_info_iterator_t iterator,
+						  void* context)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NONE(container);
+	CPL_ENSURE_NOT_NULL(iterator);
+
+	if (version != CPL_VERSION_NONE) {
+		CPL_ENSURE_NOT_NEGATIVE(version);
+	}
+
+	return cpl_db_backend->cpl_db_get_contained_objects(cpl_db_backend,
+														container, version,
+														recursive, flags,
+														iterator, context);
+}
+
+
+/**
+ * Get the objects whose names start with the given prefix, such as the
+ * files under a given directory, ordered by their names and optionally
+ * restricted to the given originator and type.
+ *
+ * @param originator the object originator, or NULL for any
+ * @param prefix the name prefix
+ * @param type the object type, or NULL for any
+ * @param flags a logical combination of CPL_I_* flags
+ * @param iterator the iterator to be called for each matching object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA if there are no such objects, or an error
+ *         code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_lookup_by_name_prefix(const char* originator,
+						  const char* prefix,
+						  const char* type,
+						  const int flags,
+						  cpl_object_info_iterator_t iterator,
+						  void* context)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NULL(prefix);
+	CPL_ENSURE_NOT_NULL(iterator);
+
+	return cpl_db_backend->cpl_db_lookup_by_name_prefix(cpl_db_backend,
+														originator, prefix,
+														type, flags,
+														iterator, context);
+}
+
+
+/**
+ * Open a cursor over all objects in the database, optionally restricted to
+ * the given originator and/or type. The cursor does not keep any database
+ * resources open between the fetches; it remembers only the last returned
+ * object ID, and each fetch resumes right after it.
+ *
+ * @param originator the object originator, or NULL for any
+ * @param type the object type, or NULL for any
+ * @param flags a logical combination of CPL_I_* flags
+ * @param out_cursor the pointer to store the new cursor, which needs to be
+ *                   closed using cpl_close_cursor()
  * @return CPL_OK or an error code
  */
 extern "C" EXPORT cpl_return_t
-cpl_get_version_info(const cpl_id_t id,
-					 const cpl_version_t version,
-					 cpl_version_info_t** out_info)
+cpl_open_object_cursor(const char* originator,
+					   const char* type,
+					   const int flags,
+					   cpl_cursor_t** out_cursor)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NULL(out_cursor);
+
+	cpl_cursor_t* c = (cpl_cursor_t*) malloc(sizeof(cpl_cursor_t));
+	if (c == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
+
+	c->kind = CPL_CURSOR_OBJECTS;
+	c->flags = flags;
+	c->originator = originator == NULL ? NULL : strdup(originator);
+	c->type = type == NULL ? NULL : strdup(type);
+	c->last = CPL_NONE;
+	c->done = false;
+
+	if ((originator != NULL && c->originator == NULL)
+			|| (type != NULL && c->type == NULL)) {
+		cpl_close_cursor(c);
+		return CPL_E_INSUFFICIENT_RESOURCES;
+	}
+
+	*out_cursor = c;
+	return CPL_OK;
+}
+
+
+/**
+ * Fetch the next batch of objects from a cursor.
+ *
+ * @param cursor the cursor opened by cpl_open_object_cursor()
+ * @param max_count the maximum number of objects to fetch
+ * @param out_infos the array of max_count pointers to store the object info
+ *                  structures, each of which needs to be freed using
+ *                  cpl_free_object_info()
+ * @param out_count the pointer to store the number of fetched objects
+ * @return CPL_OK, CPL_S_NO_DATA if there are no more objects, or an error
+ *         code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_cursor_fetch_objects(cpl_cursor_t* cursor,
+						 const size_t max_count,
+						 cpl_object_info_t** out_infos,
+						 size_t* out_count)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NULL(cursor);
+	CPL_ENSURE_NOT_NULL(out_infos);
+	CPL_ENSURE_NOT_NULL(out_count);
+
+	if (cursor->kind != CPL_CURSOR_OBJECTS) return CPL_E_INVALID_ARGUMENT;
+
+	cpl_return_t r = CPL_OK;
+	size_t count = 0;
+
+	*out_count = 0;
+	if (max_count == 0) return CPL_OK;
+
+
+	// Fetch the pages until we fill the caller's buffer; the backend can
+	// return short pages, so only an empty page ends the scan
+
+	while (count < max_count && !cursor->done) {
+
+		size_t n = 0;
+		r = cpl_db_backend->cpl_db_get_objects_page(cpl_db_backend,
+				cursor->last, cursor->originator, cursor->type,
+				cursor->flags, max_count - count, out_infos + count, &n);
+
+		if (r == CPL_S_NO_DATA || (CPL_IS_OK(r) && n == 0)) {
+			cursor->done = true;
+			break;
+		}
+		if (!CPL_IS_OK(r)) {
+			for (size_t i = 0; i < count; i++) {
+				cpl_free_object_info(out_infos[i]);
+				out_infos[i] = NULL;
+			}
+			return r;
+		}
+
+		count += n;
+		cursor->last = out_infos[count - 1]->id;
+	}
+
+	*out_count = count;
+	return count == 0 ? CPL_S_NO_DATA : CPL_OK;
+}
+
+
+/**
+ * Close a cursor and free its resources.
+ *
+ * @param cursor the cursor
+ * @return CPL_OK or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_close_cursor(cpl_cursor_t* cursor)
+{
+	CPL_ENSURE_NOT_NULL(cursor);
+
+	if (cursor->originator != NULL) free(cursor->originator);
+	if (cursor->type != NULL) free(cursor->type);
+
+	free(cursor);
+	return CPL_OK;
+}
+
+
+/**
+ * Get information about the given provenance object.
+ *
+ * @param id the object ID
+ * @param out_info the pointer to store the object info structure
+ * @return CPL_OK or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_object_info(const cpl_id_t id,
+					cpl_object_info_t** out_info)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NONE(id);
+	CPL_ENSURE_NOT_NULL(out_info);
+
+
+	// Get the latest version of the object, if available
+
+	cpl_version_t version_hint = CPL_VERSION_NONE;
+	if (cpl_cache && !cpl_cache_check) {
+		cpl_open_object_t* obj = NULL;
+		CPL_RUNTIME_VERIFY(cpl_get_open_object_handle(id, &obj));
+		version_hint = obj->version;
+		cpl_unlock(&obj->locked);
+	}
+
+
+	// Call the database backend
+
+	return cpl_db_backend->cpl_db_get_object_info(cpl_db_backend, id,
+												  version_hint, out_info);
+}
+
+
+/**
+ * Free cpl_object_info_t.
+ *
+ * @param info the pointer to the object info structure.
+ * @return CPL_OK or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_free_object_info(cpl_object_info_t* info)
+{
+	CPL_ENSURE_NOT_NULL(info);
+
+	if (info->originator != NULL) free(info->originator);
+	if (info->name != NULL) free(info->name);
+	if (info->type != NULL) free(info->type);
+
+	free(info);
+	return CPL_OK;
+}
+
+
+/**
+ * Create a deep copy of cpl_object_info_t.
+ *
+ * @param info the object info structure to copy
+ * @param out_info the pointer to store the copy
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cpl_copy_object_info(const cpl_object_info_t* info,
+					 cpl_object_info_t** out_info)
+{
+	cpl_object_info_t* p
+		= (cpl_object_info_t*) malloc(sizeof(cpl_object_info_t));
+	if (p == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
+	memcpy(p, info, sizeof(*p));
+
+	p->originator = info->originator == NULL
+		? NULL : strdup(info->originator);
+	p->name = info->name == NULL ? NULL : strdup(info->name);
+	p->type = info->type == NULL ? NULL : strdup(info->type);
+
+	*out_info = p;
+	return CPL_OK;
+}
+
+
+/**
+ * Get information about several provenance objects at once. The IDs do
+ * not need to be unique; each output slot receives its own structure.
+ *
+ * @param ids the array of object IDs
+ * @param count the number of object IDs
+ * @param out_infos the array of count pointers to store the object info
+ *                  structures, each of which needs to be freed using
+ *                  cpl_free_object_info(); all are set to NULL on error
+ * @return CPL_OK or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_object_info_batch(const cpl_id_t* ids,
+						  const size_t count,
+						  cpl_object_info_t** out_infos)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NULL(ids);
+	CPL_ENSURE_NOT_NULL(out_infos);
+
+	cpl_return_t r = CPL_OK;
+	std::map<cpl_id_t, size_t> first;
+	std::vector<cpl_id_t> unique;
+	std::vector<cpl_object_info_t*> infos;
+
+	for (size_t i = 0; i < count; i++) {
+		out_infos[i] = NULL;
+		CPL_ENSURE_NOT_NONE(ids[i]);
+		if (first.find(ids[i]) == first.end()) {
+			first[ids[i]] = i;
+			unique.push_back(ids[i]);
+		}
+	}
+	if (count == 0) return CPL_OK;
+
+
+	// Call the database backend, falling back to one query per object if
+	// the backend cannot batch the request
+
+	infos.resize(unique.size(), NULL);
+	r = cpl_db_backend->cpl_db_get_object_info_batch(cpl_db_backend,
+													 &unique[0],
+													 unique.size(),
+													 &infos[0]);
+	if (r == CPL_E_NOT_IMPLEMENTED) {
+		r = CPL_OK;
+		for (size_t i = 0; i < unique.size() && CPL_IS_OK(r); i++) {
+			r = cpl_get_object_info(unique[i], &infos[i]);
+		}
+	}
+	if (!CPL_IS_OK(r)) goto err;
+
+
+	// Distribute the results, copying them for the repeated IDs
+
+	for (size_t i = 0; i < unique.size(); i++) {
+		out_infos[first[unique[i]]] = infos[i];
+		infos[i] = NULL;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (out_infos[i] != NULL) continue;
+		r = cpl_copy_object_info(out_infos[first[ids[i]]], &out_infos[i]);
+		if (!CPL_IS_OK(r)) goto err;
+	}
+
+	return CPL_OK;
+
+
+	// Error handling
+
+err:
+	for (size_t i = 0; i < infos.size(); i++) {
+		if (infos[i] != NULL) cpl_free_object_info(infos[i]);
+	}
+	for (size_t i = 0; i < count; i++) {
+		if (out_infos[i] != NULL) cpl_free_object_info(out_infos[i]);
+		out_infos[i] = NULL;
+	}
+	return r;
+}
+
+
+/**
+ * Get information about the specific version of a provenance object.
+ *
+ * @param id the object ID
+ * @param version the version of the given provenance object
+ * @param out_info the pointer to store the version info structure
+ * @return CPL_OK or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_version_info(const cpl_id_t id,
+					 const cpl_version_t version,
+					 cpl_version_info_t** out_info)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NONE(id);
+	CPL_ENSURE_NOT_NULL(out_info);
+
+	return cpl_db_backend->cpl_db_get_version_info(cpl_db_backend, id,
+												   version, out_info);
+}
+
+
+/**
+ * Free cpl_version_info_t.
+ *
+ * @param info the pointer to the version info structure
+ * @return CPL_OK or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_free_version_info(cpl_version_info_t* info)
+{
+	CPL_ENSURE_NOT_NULL(info);
+
+	free(info);
+	return CPL_OK;
+}
+
+
+/**
+ * Get information about several version nodes at once. The nodes do not
+ * need to be unique; each output slot receives its own structure.
+ *
+ * @param nodes the array of version nodes
+ * @param count the number of version nodes
+ * @param out_infos the array of count pointers to store the version info
+ *                  structures, each of which needs to be freed using
+ *                  cpl_free_version_info(); all are set to NULL on error
+ * @return CPL_OK or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_version_info_batch(const cpl_id_version_t* nodes,
+						   const size_t count,
+						   cpl_version_info_t** out_infos)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NULL(nodes);
+	CPL_ENSURE_NOT_NULL(out_infos);
+
+	cpl_return_t r = CPL_OK;
+	std::map<cpl_lineage_node_t, size_t> first;
+	std::vector<cpl_id_version_t> unique;
+	std::vector<cpl_version_info_t*> infos;
+
+	for (size_t i = 0; i < count; i++) {
+		out_infos[i] = NULL;
+		CPL_ENSURE_NOT_NONE(nodes[i].id);
+		cpl_lineage_node_t n(nodes[i].id, nodes[i].version);
+		if (first.find(n) == first.end()) {
+			first[n] = i;
+			unique.push_back(nodes[i]);
+		}
+	}
+	if (count == 0) return CPL_OK;
+
+
+	// Call the database backend, falling back to one query per version if
+	// the backend cannot batch the request
+
+	infos.resize(unique.size(), NULL);
+	r = cpl_db_backend->cpl_db_get_version_info_batch(cpl_db_backend,
+													  &unique[0],
+													  unique.size(),
+													  &infos[0]);
+	if (r == CPL_E_NOT_IMPLEMENTED) {
+		r = CPL_OK;
+		for (size_t i = 0; i < unique.size() && CPL_IS_OK(r); i++) {
+			r = cpl_db_backend->cpl_db_get_version_info(cpl_db_backend,
+														unique[i].id,
+														unique[i].version,
+														&infos[i]);
+		}
+	}
+	if (!CPL_IS_OK(r)) goto err;
+
+
+	// Distribute the results, copying them for the repeated nodes
+
+	for (size_t i = 0; i < unique.size(); i++) {
+		cpl_lineage_node_t n(unique[i].id, unique[i].version);
+		out_infos[first[n]] = infos[i];
+		infos[i] = NULL;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (out_infos[i] != NULL) continue;
+		cpl_lineage_node_t n(nodes[i].id, nodes[i].version);
+		cpl_version_info_t* p
+			= (cpl_version_info_t*) malloc(sizeof(cpl_version_info_t));
+		if (p == NULL) { r = CPL_E_INSUFFICIENT_RESOURCES; goto err; }
+		memcpy(p, out_infos[first[n]], sizeof(*p));
+		out_infos[i] = p;
+	}
+
+	return CPL_OK;
+
+
+	// Error handling
+
+err:
+	for (size_t i = 0; i < infos.size(); i++) {
+		if (infos[i] != NULL) cpl_free_version_info(infos[i]);
+	}
+	for (size_t i = 0; i < count; i++) {
+		if (out_infos[i] != NULL) cpl_free_version_info(out_infos[i]);
+		out_infos[i] = NULL;
+	}
+	return r;
+}
+
+
+/**
+ * Iterate over all version nodes created within the given time range,
+ * ordered by their creation time.
+ *
+ * @param start_time the start of the time range (inclusive), expressed as
+ *                   UNIX time
+ * @param end_time the end of the time range (inclusive), expressed as
+ *                 UNIX time
+ * @param iterator the iterator to be called for each matching version
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_versions_in_range(const unsigned long start_time,
+						  const unsigned long end_time,
+						  cpl_version_info_iterator_t iterator,
+						  void* context)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NULL(iterator);
+
+	if (start_time > end_time) return CPL_E_INVALID_ARGUMENT;
+
+	return cpl_db_backend->cpl_db_get_versions_in_range(cpl_db_backend,
+			start_time, end_time, iterator, context);
+}
+
+
+/**
+ * Iterate over all version nodes created by the given session, ordered by
+ * their creation time.
+ *
+ * @param session the session ID
+ * @param iterator the iterator to be called for each matching version
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_session_activity(const cpl_session_t session,
+						 cpl_version_info_iterator_t iterator,
+						 void* context)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NONE(session);
+	CPL_ENSURE_NOT_NULL(iterator);
+
+	return cpl_db_backend->cpl_db_get_session_activity(cpl_db_backend,
+			session, iterator, context);
+}
+
+
+/**
+ * Iterate over the ancestors or the descendants of a provenance object.
+ *
+ * @param id the object ID
+ * @param version the object version, or CPL_VERSION_NONE to access all
+ *                version nodes associated with the given object
+ * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+ *                  or CPL_D_DESCENDANTS)
+ * @param flags the bitwise combination of flags describing how should
+ *              the graph be traversed (a logical combination of the
+ *              CPL_A_* flags)
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_object_ancestry(const cpl_id_t id,
+						const cpl_version_t version,
+						const int direction,
+						const int flags,
+						cpl_ancestry_iterator_t iterator,
+						void* context)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NONE(id);
+	CPL_ENSURE_NOT_NULL(iterator);
+
+	if (direction != CPL_D_ANCESTORS && direction != CPL_D_DESCENDANTS) {
+		return CPL_E_INVALID_ARGUMENT;
+	}
+
+
+	// Validate the object version
+
+	cpl_version_t current_version = CPL_VERSION_NONE;
+	if (version != CPL_VERSION_NONE) {
+		CPL_ENSURE_NOT_NEGATIVE(version);
+
+		CPL_RUNTIME_VERIFY(cpl_get_version(id, &current_version));
+		if (version < 0 || version > current_version) {
+			return CPL_E_INVALID_VERSION;
+		}
+	}
+
+
+	// Add the previous or the next version of the object to the result set
+	
+	int new_flags = flags | CPL_A_NO_PREV_NEXT_VERSION;
+	bool has_version_dependency = false;
+	if (version != CPL_VERSION_NONE && (flags&CPL_A_NO_PREV_NEXT_VERSION) == 0){
+		if (version > 0 && direction == CPL_D_ANCESTORS) {
+			has_version_dependency = true;
+			CPL_RUNTIME_VERIFY(iterator(id, version, id, version - 1,
+										CPL_VERSION_GENERIC, context));
+		}
+		else if (version < current_version && direction == CPL_D_DESCENDANTS) {
+			has_version_dependency = true;
+			CPL_RUNTIME_VERIFY(iterator(id, version, id, version + 1,
+										CPL_VERSION_GENERIC, context));
+		}
+	}
+
+
+	// Call the database backend, or use the result cache for the ancestors
+	// (the descendants of an object change whenever another object starts
+	// to depend on it, which the cache would not observe)
+
+	cpl_return_t r = CPL_OK;
+	CPLResultCache* cache = NULL;
+	if (direction == CPL_D_ANCESTORS) cache = cpl_result_cache_acquire();
+
+	if (cache == NULL) {
+		r = cpl_db_backend->cpl_db_get_object_ancestry(cpl_db_backend,
+													   id, version,
+													   direction,
+													   new_flags, iterator,
+													   context);
+	}
+	else {
+		if (current_version == CPL_VERSION_NONE) {
+			r = cpl_get_version(id, &current_version);
+		}
+
+		std::vector<cpl_ancestry_entry_t> edges;
+		if (CPL_IS_OK(r)) {
+			unsigned long generation = cache->generation(id);
+			if (!cache->get_ancestry(id, version, new_flags,
+						current_version, edges, &r)) {
+				r = cpl_db_backend->cpl_db_get_object_ancestry(
+						cpl_db_backend, id, version, direction, new_flags,
+						cpl_cb_collect_ancestry_vector, &edges);
+				if (CPL_IS_OK(r)) {
+					cache->put_ancestry(id, version, new_flags,
+							current_version, generation, edges, r);
+				}
+			}
+		}
+
+		cpl_result_cache_release(cache);
+		if (!CPL_IS_OK(r)) return r;
+
+		std::vector<cpl_ancestry_entry_t>::iterator i;
+		for (i = edges.begin(); i != edges.end(); i++) {
+			CPL_RUNTIME_VERIFY(iterator(i->query_object_id,
+										i->query_object_version,
+										i->other_object_id,
+										i->other_object_version,
+										i->type, context));
+		}
+	}
+	
+	if (r == CPL_S_NO_DATA && has_version_dependency) return CPL_OK;
+	return r;
+}
+
+
+/**
+ * Iterate over the transitive ancestors or descendants of a provenance
+ * object. The graph is traversed breadth-first, and each level of the
+ * traversal is fetched from the database using a single batched request,
+ * so the number of round trips grows with the depth of the lineage rather
+ * than with the number of its nodes. The iterator is called once for each
+ * traversed edge, with the query node set to the node closer to the start.
+ *
+ * @param id the object ID
+ * @param version the object version, or CPL_VERSION_NONE to start from all
+ *                version nodes associated with the given object
+ * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+ *                  or CPL_D_DESCENDANTS)
+ * @param max_depth the maximum number of edges between the start and any
+ *                  returned node, or 0 for no limit
+ * @param flags the bitwise combination of flags describing how should
+ *              the graph be traversed (a logical combination of the
+ *              CPL_A_* flags)
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_object_lineage(const cpl_id_t id,
+					   const cpl_version_t version,
+					   const int direction,
+					   const int max_depth,
+					   const int flags,
+					   cpl_ancestry_iterator_t iterator,
+					   void* context)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NONE(id);
+	CPL_ENSURE_NOT_NULL(iterator);
+	CPL_ENSURE_NOT_NEGATIVE(max_depth);
+
+	if (direction != CPL_D_ANCESTORS && direction != CPL_D_DESCENDANTS) {
+		return CPL_E_INVALID_ARGUMENT;
+	}
+
+
+	// Validate the object version
+
+	cpl_version_t current_version;
+	CPL_RUNTIME_VERIFY(cpl_get_version(id, &current_version));
+
+	if (version != CPL_VERSION_NONE) {
+		CPL_ENSURE_NOT_NEGATIVE(version);
+		if (version > current_version) return CPL_E_INVALID_VERSION;
+	}
+
+
+	// Initialize the traversal with either the given version node or with
+	// all version nodes of the object
+
+	cpl_lineage_context_t ctx;
+	ctx.iterator = iterator;
+	ctx.context = context;
+	ctx.found = false;
+
+	std::vector<cpl_id_version_t> frontier;
+	cpl_hash_map_id_t<cpl_version_t>::type current_versions;
+	current_versions[id] = current_version;
+
+	cpl_version_t v = version == CPL_VERSION_NONE ? 0 : version;
+	cpl_version_t v_last = version == CPL_VERSION_NONE ? current_version
+													   : version;
+	for ( ; v <= v_last; v++) {
+		cpl_id_version_t e;
+		e.id = id;
+		e.version = v;
+		frontier.push_back(e);
+		ctx.visited.insert(cpl_lineage_node_t(id, v));
+	}
+
+
+	// Traverse the graph one level at a time
+
+	bool version_edges = (flags & CPL_A_NO_PREV_NEXT_VERSION) == 0;
+	cpl_return_t r;
+
+	for (int depth = 0; !frontier.empty()
+			&& (max_depth == 0 || depth < max_depth); depth++) {
+
+		ctx.next.clear();
+
+
+		// Add the previous or the next versions of the frontier nodes. As
+		// in cpl_get_object_ancestry(), there are no version edges between
+		// the start nodes if we start from all versions of the object.
+
+		if (version_edges && (depth > 0 || version != CPL_VERSION_NONE)) {
+			std::vector<cpl_id_version_t>::iterator i;
+			for (i = frontier.begin(); i != frontier.end(); i++) {
+
+				if (direction == CPL_D_ANCESTORS) {
+					if (i->version <= 0) continue;
+					r = cpl_cb_lineage_edge(i->id, i->version, i->id,
+							i->version - 1, CPL_VERSION_GENERIC, &ctx);
+					if (!CPL_IS_OK(r)) return r;
+				}
+				else {
+					cpl_hash_map_id_t<cpl_version_t>::type::iterator cv
+						= current_versions.find(i->id);
+					cpl_version_t c;
+					if (cv == current_versions.end()) {
+						CPL_RUNTIME_VERIFY(cpl_get_version(i->id, &c));
+						current_versions[i->id] = c;
+					}
+					else {
+						c = cv->second;
+					}
+
+					if (i->version >= c) continue;
+					r = cpl_cb_lineage_edge(i->id, i->version, i->id,
+							i->version + 1, CPL_VERSION_GENERIC, &ctx);
+					if (!CPL_IS_OK(r)) return r;
+				}
+			}
+		}
+
+
+		// Fetch the edges of the entire level using a single call to the
+		// database backend
+
+		r = cpl_db_backend->cpl_db_get_object_ancestry_batch(cpl_db_backend,
+				&frontier[0], frontier.size(), direction,
+				flags | CPL_A_NO_PREV_NEXT_VERSION,
+				cpl_cb_lineage_edge, &ctx);
+		if (!CPL_IS_OK(r)) return r;
+
+		frontier.swap(ctx.next);
+	}
+
+	return ctx.found ? CPL_OK : CPL_S_NO_DATA;
+}
+
+
+/**
+ * Iterate over the transitive ancestors or descendants of a provenance
+ * object using several threads. The result is the same as that of
+ * cpl_get_object_lineage(), but the frontier of the traversal is expanded
+ * by a pool of work-stealing threads, each issuing its own batched
+ * requests to the database, so the edges are not returned in the
+ * breadth-first order. The iterator is called from the worker threads,
+ * but never from more than one thread at a time.
+ *
+ * @param id the object ID
+ * @param version the object version, or CPL_VERSION_NONE to start from all
+ *                version nodes associated with the given object
+ * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+ *                  or CPL_D_DESCENDANTS)
+ * @param max_depth the maximum number of edges between the start and any
+ *                  returned node, or 0 for no limit
+ * @param flags the bitwise combination of flags describing how should
+ *              the graph be traversed (a logical combination of the
+ *              CPL_A_* flags)
+ * @param num_threads the number of threads including the calling thread,
+ *                    or 0 for the default
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_object_lineage_parallel(const cpl_id_t id,
+								const cpl_version_t version,
+								const int direction,
+								const int max_depth,
+								const int flags,
+								const int num_threads,
+								cpl_ancestry_iterator_t iterator,
+								void* context)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NONE(id);
+	CPL_ENSURE_NOT_NULL(iterator);
+	CPL_ENSURE_NOT_NEGATIVE(max_depth);
+	CPL_ENSURE_NOT_NEGATIVE(num_threads);
+
+	if (direction != CPL_D_ANCESTORS && direction != CPL_D_DESCENDANTS) {
+		return CPL_E_INVALID_ARGUMENT;
+	}
+
+	int n = num_threads == 0 ? CPL_LINEAGE_DEFAULT_THREADS : num_threads;
+	if (n > CPL_LINEAGE_MAX_THREADS) n = CPL_LINEAGE_MAX_THREADS;
+
+
+	// Validate the object version
+
+	cpl_version_t current_version;
+	CPL_RUNTIME_VERIFY(cpl_get_version(id, &current_version));
+
+	if (version != CPL_VERSION_NONE) {
+		CPL_ENSURE_NOT_NEGATIVE(version);
+		if (version > current_version) return CPL_E_INVALID_VERSION;
+	}
+
+
+	// Start from either the given version node or from all version nodes
+	// of the object, in which case there are no version edges between them
+
+	std::vector<cpl_id_version_t> start;
+
+	cpl_version_t v = version == CPL_VERSION_NONE ? 0 : version;
+	cpl_version_t v_last = version == CPL_VERSION_NONE ? current_version
+													   : version;
+	for ( ; v <= v_last; v++) {
+		cpl_id_version_t e;
+		e.id = id;
+		e.version = v;
+		start.push_back(e);
+	}
+
+
+	// Run the traversal
+
+	CPLParallelLineage lineage(cpl_db_backend, direction, max_depth, flags,
+							   n, iterator, context);
+	return lineage.run(start, version != CPL_VERSION_NONE);
+}
+
+
+/**
+ * Iterate over all transitive ancestors or descendants of a provenance
+ * object, including the other versions of the same object. Each reachable
+ * version node is returned once, with the type set to CPL_DEPENDENCY_NONE.
+ * If the database maintains an ancestry closure, the entire result is
+ * fetched using a single indexed lookup; otherwise the graph is traversed
+ * as in cpl_get_object_lineage().
+ *
+ * @param id the object ID
+ * @param version the object version, or CPL_VERSION_NONE to consider all
+ *                version nodes associated with the given object (which
+ *                are then excluded from the result)
+ * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+ *                  or CPL_D_DESCENDANTS)
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_transitive_ancestry(const cpl_id_t id,
+							const cpl_version_t version,
+							const int direction,
+							cpl_ancestry_iterator_t iterator,
+							void* context)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NONE(id);
+	CPL_ENSURE_NOT_NULL(iterator);
+
+	if (direction != CPL_D_ANCESTORS && direction != CPL_D_DESCENDANTS) {
+		return CPL_E_INVALID_ARGUMENT;
+	}
+
+
+	// Validate the object version. All versions of the object together
+	// reach the same nodes as the latest version when looking for the
+	// ancestors, or as the first version when looking for the descendants.
+
+	cpl_version_t current_version;
+	CPL_RUNTIME_VERIFY(cpl_get_version(id, &current_version));
+
+	cpl_version_t v = version;
+	if (version != CPL_VERSION_NONE) {
+		CPL_ENSURE_NOT_NEGATIVE(version);
+		if (version > current_version) return CPL_E_INVALID_VERSION;
+	}
+	else {
+		v = direction == CPL_D_ANCESTORS ? current_version : 0;
+	}
+
+	cpl_transitive_ancestry_context_t ctx;
+	ctx.iterator = iterator;
+	ctx.context = context;
+	ctx.start = cpl_lineage_node_t(id, v);
+	ctx.skip_object = version == CPL_VERSION_NONE;
+
+
+	// Use the closure maintained by the database if possible, and traverse
+	// the graph otherwise
+
+	cpl_return_t r;
+	r = cpl_db_backend->cpl_db_get_transitive_ancestry(cpl_db_backend,
+			id, v, direction, cpl_cb_transitive_ancestry, &ctx);
+	if (r == CPL_E_NOT_IMPLEMENTED) {
+		r = cpl_get_object_lineage(id, v, direction, 0, 0,
+				cpl_cb_transitive_ancestry, &ctx);
+	}
+	if (!CPL_IS_OK(r)) return r;
+
+	return ctx.returned.empty() ? CPL_S_NO_DATA : CPL_OK;
+}
+
+
+/**
+ * Determine whether an object version is an ancestor of another. The query
+ * uses the reachability index if it is enabled, and it otherwise traverses
+ * the graph in the database.
+ *
+ * @param id the ID of the descendant
+ * @param version the version of the descendant, or CPL_VERSION_NONE for
+ *                its latest version (or any of its versions if not
+ *                transitive)
+ * @param ancestor_id the ID of the ancestor
+ * @param ancestor_version the version of the ancestor, or CPL_VERSION_NONE
+ *                         for any of its versions
+ * @param transitive nonzero to consider the ancestors of any depth, or 0
+ *                   to consider only the immediate ancestors
+ * @param out_result the pointer to store the result (1 if it is an
+ *                   ancestor, or 0 otherwise)
+ * @return CPL_OK or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_is_ancestor(const cpl_id_t id,
+				const cpl_version_t version,
+				const cpl_id_t ancestor_id,
+				const cpl_version_t ancestor_version,
+				const int transitive,
+				int* out_result)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NONE(id);
+	CPL_ENSURE_NOT_NONE(ancestor_id);
+	CPL_ENSURE_NOT_NULL(out_result);
+
+	if (version != CPL_VERSION_NONE) {
+		CPL_ENSURE_NOT_NEGATIVE(version);
+	}
+	if (ancestor_version != CPL_VERSION_NONE) {
+		CPL_ENSURE_NOT_NEGATIVE(ancestor_version);
+	}
+
+
+	// Use the reachability index if possible. It does not know about the
+	// updates made by other processes since it was loaded or built, so fall
+	// back to the database if it is not current for the queried object.
+
+	if (cpl_reachability_index != NULL) {
+		cpl_return_t r = cpl_reachability_is_ancestor(id, version,
+				ancestor_id, ancestor_version, transitive != 0, out_result);
+		if (r != CPL_E_NOT_FOUND) return r;
+	}
+
+
+	// Otherwise traverse the graph
+
+	cpl_is_ancestor_context_t ctx;
+	ctx.ancestor_id = ancestor_id;
+	ctx.ancestor_version = ancestor_version;
+	ctx.found = false;
+
+	if (!transitive) {
+		CPL_RUNTIME_VERIFY(cpl_get_object_ancestry(id, version,
+					CPL_D_ANCESTORS, 0, cpl_cb_is_ancestor, &ctx));
+	}
+	else if (version != CPL_VERSION_NONE || ancestor_version != CPL_VERSION_NONE
+			|| ancestor_id != id) {
+
+		// The latest version reaches everything reachable from the object
+
+		cpl_version_t v = version;
+		if (v == CPL_VERSION_NONE) {
+			CPL_RUNTIME_VERIFY(cpl_get_version(id, &v));
+		}
+
+		CPL_RUNTIME_VERIFY(cpl_get_transitive_ancestry(id, v,
+					CPL_D_ANCESTORS, cpl_cb_is_ancestor, &ctx));
+	}
+
+	*out_result = ctx.found ? 1 : 0;
+	return CPL_OK;
+}
+
+
+/**
+ * Find the shortest provenance path from an object version to one of its
+ * ancestors. The search is bidirectional: it expands the ancestors of the
+ * first node and the descendants of the second node, always advancing the
+ * side with the smaller frontier by one level using a single batched
+ * request, until the two sides meet. The iterator is called once for each
+ * edge of the path, in the order from the descendant to the ancestor, with
+ * the query node set to the node closer to the descendant.
+ *
+ * @param from_id the ID of the descendant
+ * @param from_version the version of the descendant, or CPL_VERSION_NONE
+ *                     for its latest version
+ * @param to_id the ID of the ancestor
+ * @param to_version the version of the ancestor, or CPL_VERSION_NONE for
+ *                   its first version
+ * @param max_depth the maximum length of the path, or 0 for no limit
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA if there is no such path, or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_find_provenance_path(const cpl_id_t from_id,
+						 const cpl_version_t from_version,
+						 const cpl_id_t to_id,
+						 const cpl_version_t to_version,
+						 const int max_depth,
+						 cpl_ancestry_iterator_t iterator,
+						 void* context)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NONE(from_id);
+	CPL_ENSURE_NOT_NONE(to_id);
+	CPL_ENSURE_NOT_NULL(iterator);
+	CPL_ENSURE_NOT_NEGATIVE(max_depth);
+
+
+	// Resolve and validate the versions; the latest version of the
+	// descendant and the first version of the ancestor are connected to
+	// all other versions of the same objects
+
+	cpl_hash_map_id_t<cpl_version_t>::type current_versions;
+	cpl_version_t from_current, to_current;
+	CPL_RUNTIME_VERIFY(cpl_get_version(from_id, &from_current));
+	CPL_RUNTIME_VERIFY(cpl_get_version(to_id, &to_current));
+	current_versions[from_id] = from_current;
+	current_versions[to_id] = to_current;
+
+	cpl_version_t fv = from_version;
+	cpl_version_t tv = to_version == CPL_VERSION_NONE ? 0 : to_version;
+	if (fv == CPL_VERSION_NONE) fv = from_current;
+	CPL_ENSURE_NOT_NEGATIVE(fv);
+	CPL_ENSURE_NOT_NEGATIVE(tv);
+	if (fv > from_current || tv > to_current) return CPL_E_INVALID_VERSION;
+
+	cpl_lineage_node_t from(from_id, fv);
+	cpl_lineage_node_t to(to_id, tv);
+	if (from == to) return CPL_OK;
+
+
+	// Initialize both sides of the search
+
+	std::map<cpl_lineage_node_t, cpl_path_step_t> up;
+	std::map<cpl_lineage_node_t, cpl_path_step_t> down;
+
+	cpl_path_step_t start;
+	start.type = CPL_DEPENDENCY_NONE;
+	start.depth = 0;
+	start.parent = from;
+	up[from] = start;
+	start.parent = to;
+	down[to] = start;
+
+	std::vector<cpl_id_version_t> up_frontier(1);
+	up_frontier[0].id = from_id;
+	up_frontier[0].version = fv;
+
+	std::vector<cpl_id_version_t> down_frontier(1);
+	down_frontier[0].id = to_id;
+	down_frontier[0].version = tv;
+
+	cpl_path_context_t up_ctx;
+	up_ctx.visited = &up;
+	up_ctx.other = &down;
+	up_ctx.depth = 0;
+	up_ctx.met = false;
+	up_ctx.length = 0;
+
+	cpl_path_context_t down_ctx;
+	down_ctx.visited = &down;
+	down_ctx.other = &up;
+	down_ctx.depth = 0;
+	down_ctx.met = false;
+	down_ctx.length = 0;
+
+
+	// Advance the side with the smaller frontier one level at a time. The
+	// first level in which the sides meet contains the shortest path.
+
+	cpl_path_context_t* met = NULL;
+	cpl_return_t r;
+
+	while (!up_frontier.empty() && !down_frontier.empty()
+			&& (max_depth == 0 || up_ctx.depth + down_ctx.depth < max_depth)) {
+
+		bool go_up = up_frontier.size() <= down_frontier.size();
+		cpl_path_context_t* ctx = go_up ? &up_ctx : &down_ctx;
+		std::vector<cpl_id_version_t>& frontier
+			= go_up ? up_frontier : down_frontier;
+
+		ctx->next.clear();
+		ctx->depth++;
+
+		r = cpl_path_expand(frontier, go_up ? CPL_D_ANCESTORS
+				: CPL_D_DESCENDANTS, current_versions, ctx);
+		if (!CPL_IS_OK(r)) return r;
+
+		frontier.swap(ctx->next);
+
+		if (ctx->met) {
+			met = ctx;
+			break;
+		}
+	}
+
+	if (met == NULL) return CPL_S_NO_DATA;
+
+
+	// Reconstruct the path: from the start to the meeting node using the
+	// ancestors side, and from there to the ancestor using the other side
+
+	std::vector<cpl_lineage_node_t> path;
+	std::vector<int> types;
+
+	for (cpl_lineage_node_t n = met->meet; n != from; n = up[n].parent) {
+		path.push_back(n);
+		types.push_back(up[n].type);
+	}
+	path.push_back(from);
+	std::reverse(path.begin(), path.end());
+	std::reverse(types.begin(), types.end());
+
+	for (cpl_lineage_node_t n = met->meet; n != to; n = down[n].parent) {
+		path.push_back(down[n].parent);
+		types.push_back(down[n].type);
+	}
+
+
+	// Return the edges
+
+	for (size_t i = 0; i + 1 < path.size(); i++) {
+		r = iterator(path[i].first, path[i].second,
+					 path[i + 1].first, path[i + 1].second,
+					 types[i], context);
+		if (!CPL_IS_OK(r)) return r;
+	}
+
+	return CPL_OK;
+}
+
+
+/**
+ * Get the properties associated with the given provenance object.
+ *
+ * @param id the the object ID
+ * @param version the object version, or CPL_VERSION_NONE to access all
+ *                version nodes associated with the given object
+ * @param key the property to fetch - or NULL for all properties
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_properties(const cpl_id_t id,
+				   const cpl_version_t version,
+				   const char* key,
+				   cpl_property_iterator_t iterator,
+				   void* context)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NONE(id);
+	CPL_ENSURE_NOT_NULL(iterator);
+
+
+	// Validate the object version
+
+	cpl_version_t current_version = CPL_VERSION_NONE;
+	if (version != CPL_VERSION_NONE) {
+		CPL_ENSURE_NOT_NEGATIVE(version);
+
+		CPL_RUNTIME_VERIFY(cpl_get_version(id, &current_version));
+
+		if (version < 0 || version > current_version) {
+			return CPL_E_INVALID_VERSION;
+		}
+	}
+
+
+	// Call the database backend
+
+	CPLResultCache* cache = cpl_result_cache_acquire();
+	if (cache == NULL) {
+		return cpl_db_backend->cpl_db_get_properties(cpl_db_backend,
+													 id, version, key,
+													 iterator, context);
+	}
+
+
+	// Use the result cache
+
+	cpl_return_t r = CPL_OK;
+	if (current_version == CPL_VERSION_NONE) {
+		r = cpl_get_version(id, &current_version);
+	}
+
+	std::vector<cplxx_property_entry_t> properties;
+	if (CPL_IS_OK(r)) {
+		unsigned long generation = cache->generation(id);
+		if (!cache->get_properties(id, version, key, current_version,
+					properties, &r)) {
+			r = cpl_db_backend->cpl_db_get_properties(cpl_db_backend,
+					id, version, key, cpl_cb_collect_properties_vector,
+					&properties);
+			if (CPL_IS_OK(r)) {
+				cache->put_properties(id, version, key, current_version,
+						generation, properties, r);
+			}
+		}
+	}
+
+	cpl_result_cache_release(cache);
+	if (!CPL_IS_OK(r)) return r;
+
+	std::vector<cplxx_property_entry_t>::iterator i;
+	for (i = properties.begin(); i != properties.end(); i++) {
+		CPL_RUNTIME_VERIFY(iterator(i->id, i->version, i->key.c_str(),
+									i->value.c_str(), context));
+	}
+
+	return r;
+}
+
+
+/**
+ * Lookup an object based on a property value.
+ *
+ * @param key the property name
+ * @param value the property value
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_E_NOT_FOUND, or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_lookup_by_property(const char* key,
+					   const char* value,
+					   cpl_property_iterator_t iterator,
+					   void* context)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NULL(iterator);
+	CPL_ENSURE_NOT_NULL(key);
+	CPL_ENSURE_NOT_NULL(value);
+
+
+	// Call the database backend
+
+	return cpl_db_backend->cpl_db_lookup_by_property(cpl_db_backend,
+													 key, value,
+													 iterator, context);
+}
+
+
+/**
+ * Find the objects that satisfy all of the given property predicates, and
+ * optionally have the given originator and type. The iterator is called
+ * once for each matching object.
+ *
+ * @param originator the object originator, or NULL for any
+ * @param type the object type, or NULL for any
+ * @param predicates the array of property predicates
+ * @param num_predicates the number of predicates
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_E_NOT_FOUND, or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_query_by_properties(const char* originator,
+						const char* type,
+						const cpl_property_predicate_t* predicates,
+						const size_t num_predicates,
+						cpl_id_timestamp_iterator_t iterator,
+						void* context)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NULL(iterator);
+	if (num_predicates > 0) CPL_ENSURE_NOT_NULL(predicates);
+
+
+	// Validate the predicates
+
+	for (size_t i = 0; i < num_predicates; i++) {
+		const cpl_property_predicate_t& p = predicates[i];
+
+		CPL_ENSURE_NOT_NULL(p.key);
+		CPL_ENSURE_NOT_NULL(p.values);
+
+		switch (p.op) {
+			case CPL_PQ_EQUALS:
+			case CPL_PQ_PREFIX:
+				if (p.num_values != 1) return CPL_E_INVALID_ARGUMENT;
+				break;
+			case CPL_PQ_IN:
+				if (p.num_values < 1) return CPL_E_INVALID_ARGUMENT;
+				break;
+			default:
+				return CPL_E_INVALID_ARGUMENT;
+		}
+
+		for (size_t j = 0; j < p.num_values; j++) {
+			CPL_ENSURE_NOT_NULL(p.values[j]);
+		}
+	}
+
+
+	// Call the database backend
+
+	return cpl_db_backend->cpl_db_query_by_properties(cpl_db_backend,
+													  originator, type,
+													  predicates,
+													  num_predicates,
+													  iterator, context);
+}
+
+
+/**
+ * Compute aggregate statistics about the provenance graph in the database.
+ * Each object, version node, and edge is attributed to the time at which it
+ * was created (an edge is created together with the version node from which
+ * it originates), so that the statistics can be refreshed incrementally by
+ * adding up the results for disjoint time ranges. The numbers of versions
+ * and edges of the counted objects and version nodes are as of the time of
+ * the query. The iterator is called for each group, ordered by kind and
+ * then by key.
+ *
+ * @param kinds the statistics to compute (a logical combination of the
+ *              CPL_GS_* constants)
+ * @param start_time the start of the time range (inclusive), expressed as
+ *                   UNIX time
+ * @param end_time the end of the time range (inclusive), expressed as
+ *                 UNIX time, or 0 for no limit
+ * @param iterator the iterator to be called for each group
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA if there is nothing to count, or an error
+ *         code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_get_graph_statistics(const int kinds,
+						 const unsigned long start_time,
+						 const unsigned long end_time,
+						 cpl_graph_statistic_iterator_t iterator,
+						 void* context)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NULL(iterator);
+
+	if ((kinds & ~CPL_GS_ALL) != 0 || kinds == 0) {
+		return CPL_E_INVALID_ARGUMENT;
+	}
+	if (end_time != 0 && end_time < start_time) {
+		return CPL_E_INVALID_ARGUMENT;
+	}
+
+	return cpl_db_backend->cpl_db_get_graph_statistics(cpl_db_backend,
+													   kinds, start_time,
+													   end_time, iterator,
+													   context);
+}
+
+
+/**
+ * Compare the lineages of two object versions, such as the outputs of two
+ * runs of the same pipeline. Each lineage is fetched one level at a time
+ * using batched requests, and the versions of each object within it are
+ * merged into a single node. The inputs of each pair of aligned nodes are
+ * matched by their originator, name, type, and dependency type, and the
+ * inputs left over are then matched by their SHA1 fingerprints. Pairs of
+ * nodes whose entire ancestry hashes to the same value are skipped without
+ * being compared further. The iterator is called once for each added,
+ * removed, or changed input, starting from the two roots, which are
+ * always aligned with each other.
+ *
+ * @param left_id the ID of the left root
+ * @param left_version the version of the left root, or CPL_VERSION_NONE
+ *                     for its latest version
+ * @param right_id the ID of the right root
+ * @param right_version the version of the right root, or CPL_VERSION_NONE
+ *                      for its latest version
+ * @param iterator the iterator to be called for each difference
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA if the lineages are identical, or an error
+ *         code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_diff_lineage(const cpl_id_t left_id,
+				 const cpl_version_t left_version,
+				 const cpl_id_t right_id,
+				 const cpl_version_t right_version,
+				 cpl_diff_iterator_t iterator,
+				 void* context)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NONE(left_id);
+	CPL_ENSURE_NOT_NONE(right_id);
+	CPL_ENSURE_NOT_NULL(iterator);
+
+
+	// Resolve and validate the versions
+
+	cpl_id_version_t roots[2];
+	roots[0].id = left_id;
+	roots[0].version = left_version;
+	roots[1].id = right_id;
+	roots[1].version = right_version;
+
+	for (int i = 0; i < 2; i++) {
+		cpl_version_t current_version;
+		CPL_RUNTIME_VERIFY(cpl_get_version(roots[i].id, &current_version));
+
+		if (roots[i].version == CPL_VERSION_NONE) {
+			roots[i].version = current_version;
+		}
+		else {
+			CPL_ENSURE_NOT_NEGATIVE(roots[i].version);
+			if (roots[i].version > current_version) {
+				return CPL_E_INVALID_VERSION;
+			}
+		}
+	}
+
+
+	// Fetch and compare the two lineages
+
+	CPLLineageDiff diff(cpl_db_backend);
+
+	for (int i = 0; i < 2; i++) {
+		std::vector<cpl_id_version_t> r(1, roots[i]);
+		CPL_RUNTIME_VERIFY(diff.load(i, r));
+	}
+
+	return diff.run(true, iterator, context);
+}
+
+
+/**
+ * Compare the lineages of all version nodes created by two sessions. This
+ * works like cpl_diff_lineage(), except that the roots are the objects
+ * modified by each session, which are aligned the same way as the inputs.
+ *
+ * @param left the left session
+ * @param right the right session
+ * @param iterator the iterator to be called for each difference
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA if the lineages are identical, or an error
+ *         code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_diff_sessions(const cpl_session_t left,
+				  const cpl_session_t right,
+				  cpl_diff_iterator_t iterator,
+				  void* context)
+{
+	CPL_ENSURE_INITALIZED;
+	CPL_ENSURE_NOT_NONE(left);
+	CPL_ENSURE_NOT_NONE(right);
+	CPL_ENSURE_NOT_NULL(iterator);
+
+	CPLLineageDiff diff(cpl_db_backend);
+	cpl_session_t sessions[2] = { left, right };
+
+	for (int i = 0; i < 2; i++) {
+
+		// Get the version nodes created by the session
+
+		std::vector<cpl_version_info_t> activity;
+		CPL_RUNTIME_VERIFY(cpl_db_backend->cpl_db_get_session_activity(
+					cpl_db_backend, sessions[i],
+					cpl_cb_collect_version_info_vector, &activity));
+
+		std::vector<cpl_id_version_t> roots;
+		std::vector<cpl_version_info_t>::iterator j;
+		for (j = activity.begin(); j != activity.end(); j++) {
+			cpl_id_version_t e;
+			e.id = j->id;
+			e.version = j->version;
+			roots.push_back(e);
+		}
+
+
+		// Fetch the lineage
+
+		CPL_RUNTIME_VERIFY(diff.load(i, roots));
+	}
+
+	return diff.run(false, iterator, context);
+}
+
+
+/**
+ * Run a path query over the provenance graph, such as:
+ *
+ *   MATCH (f:FILE {name:'/x'})<-[:DATA*1..5]-(p:PROCESS) RETURN p
+ *
+ * A query matches a single linear path of nodes, each of which can specify
+ * the object type, name, originator, and property values, connected by hops
+ * that point from the dependent object to its ancestor and can restrict the
+ * dependency type and the number of crossed dependencies. It returns the
+ * distinct objects bound to the returned variable, in the order of their
+ * IDs. The versions of an object are traversed for free.
+ *
+ * @param query the query text
+ * @param iterator the iterator to be called for each returned object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA if nothing matches, CPL_E_INVALID_QUERY,
+ *         or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_query(const char* query,
+		  cpl_object_info_iterator_t iterator,
+		  void* context)
 {
 	CPL_ENSURE_INITALIZED;
-	CPL_ENSURE_NOT_NONE(id);
-	CPL_ENSURE_NOT_NULL(out_info);
+	CPL_ENSURE_NOT_NULL(query);
+	CPL_ENSURE_NOT_NULL(iterator);
 
-	return cpl_db_backend->cpl_db_get_version_info(cpl_db_backend, id,
-												   version, out_info);
+	CPLQuery q(cpl_db_backend);
+	CPL_RUNTIME_VERIFY(q.parse(query));
+
+	return q.execute(iterator, context);
 }
 
 
+
+/***************************************************************************/
+/** Public API: Reachability Index                                        **/
+/***************************************************************************/
+
+
 /**
- * Free cpl_version_info_t.
+ * Enable the in-memory reachability index, which answers the transitive
+ * cpl_is_ancestor() queries without traversing the graph in the database.
+ * The index is loaded from the given file if it exists, or built from a
+ * scan of the database otherwise, and it is then updated with all objects,
+ * versions, and dependencies created through this instance of the library.
+ * The file is rewritten by cpl_rebuild_reachability_index() and
+ * cpl_detach().
  *
- * @param info the pointer to the version info structure
+ * The index does not observe the updates made by other processes. Each
+ * query first checks the latest version of the queried object and its
+ * immediate ancestors in the database, and it falls back to a traversal of
+ * the database if the index is not current for them, so a loaded file that
+ * is out of date or the updates made by other processes make the queries
+ * slower until the next cpl_rebuild_reachability_index().
+ *
+ * @param path the index file, or NULL to keep the index only in memory
  * @return CPL_OK or an error code
  */
 extern "C" EXPORT cpl_return_t
-cpl_free_version_info(cpl_version_info_t* info)
+cpl_enable_reachability_index(const char* path)
 {
-	CPL_ENSURE_NOT_NULL(info);
+	CPL_ENSURE_INITALIZED;
+
+	if (cpl_reachability_index != NULL) return CPL_E_ALREADY_INITIALIZED;
+
+
+	// Load the index, or build it if it does not exist or cannot be read
+
+	CPLReachabilityIndex* index = new CPLReachabilityIndex();
+	if (index == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
+
+	cpl_return_t r = CPL_E_NOT_FOUND;
+	if (path != NULL) r = index->load(path);
+
+	if (!CPL_IS_OK(r)) {
+		r = index->build(cpl_db_backend);
+		if (CPL_IS_OK(r) && path != NULL) r = index->save(path);
+		if (!CPL_IS_OK(r)) {
+			delete index;
+			return r;
+		}
+	}
+
+
+	// Enable the index
+
+	cpl_lock(&cpl_reachability_index_lock);
+	if (cpl_reachability_index != NULL) {
+		cpl_unlock(&cpl_reachability_index_lock);
+		delete index;
+		return CPL_E_ALREADY_INITIALIZED;
+	}
+	cpl_reachability_index_path = path == NULL ? "" : path;
+	cpl_reachability_index = index;
+	cpl_unlock(&cpl_reachability_index_lock);
 
-	free(info);
 	return CPL_OK;
 }
 
 
 /**
- * Iterate over the ancestors or the descendants of a provenance object.
+ * Rebuild the reachability index from a scan of the database, and write
+ * it to its file, if any. The new index is built separately while the old
+ * one keeps answering the queries, and it then replaces the old index
+ * together with the updates made in the meantime.
  *
- * @param id the object ID
- * @param version the object version, or CPL_VERSION_NONE to access all
- *                version nodes associated with the given object
- * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
- *                  or CPL_D_DESCENDANTS)
- * @param flags the bitwise combination of flags describing how should
- *              the graph be traversed (a logical combination of the
- *              CPL_A_* flags)
- * @param iterator the iterator callback function
- * @param context the user context to be passed to the iterator function
- * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ * @return CPL_OK or an error code
  */
 extern "C" EXPORT cpl_return_t
-cpl_get_object_ancestry(const cpl_id_t id,
-						const cpl_version_t version,
-						const int direction,
-						const int flags,
-						cpl_ancestry_iterator_t iterator,
-						void* context)
+cpl_rebuild_reachability_index(void)
 {
 	CPL_ENSURE_INITALIZED;
-	CPL_ENSURE_NOT_NONE(id);
-	CPL_ENSURE_NOT_NULL(iterator);
 
-	if (direction != CPL_D_ANCESTORS && direction != CPL_D_DESCENDANTS) {
-		return CPL_E_INVALID_ARGUMENT;
-	}
+	cpl_lock(&cpl_reachability_rebuild_lock);
+	CPL_AutoUnlock __au(&cpl_reachability_rebuild_lock);
+	(void) __au;
 
 
-	// Validate the object version
+	// Start recording the updates
 
-	cpl_version_t current_version = CPL_VERSION_NONE;
-	if (version != CPL_VERSION_NONE) {
-		CPL_ENSURE_NOT_NEGATIVE(version);
+	std::vector<std::pair<cpl_id_version_t, cpl_id_version_t> > log;
 
-		CPL_RUNTIME_VERIFY(cpl_get_version(id, &current_version));
-		if (version < 0 || version > current_version) {
-			return CPL_E_INVALID_VERSION;
-		}
+	cpl_lock(&cpl_reachability_index_lock);
+	if (cpl_reachability_index == NULL) {
+		cpl_unlock(&cpl_reachability_index_lock);
+		return CPL_E_NOT_INITIALIZED;
 	}
+	cpl_reachability_index_log = &log;
+	cpl_unlock(&cpl_reachability_index_lock);
 
 
-	// Add the previous or the next version of the object to the result set
-	
-	int new_flags = flags | CPL_A_NO_PREV_NEXT_VERSION;
-	bool has_version_dependency = false;
-	if (version != CPL_VERSION_NONE && (flags&CPL_A_NO_PREV_NEXT_VERSION) == 0){
-		if (version > 0 && direction == CPL_D_ANCESTORS) {
-			has_version_dependency = true;
-			CPL_RUNTIME_VERIFY(iterator(id, version, id, version - 1,
-										CPL_VERSION_GENERIC, context));
-		}
-		else if (version < current_version && direction == CPL_D_DESCENDANTS) {
-			has_version_dependency = true;
-			CPL_RUNTIME_VERIFY(iterator(id, version, id, version + 1,
-										CPL_VERSION_GENERIC, context));
+	// Build the new index
+
+	CPLReachabilityIndex* index = new CPLReachabilityIndex();
+	cpl_return_t ret = index->build(cpl_db_backend);
+
+
+	// Replay the recorded updates and replace the old index
+
+	CPLReachabilityIndex* old = NULL;
+	std::string path;
+
+	cpl_lock(&cpl_reachability_index_lock);
+	cpl_reachability_index_log = NULL;
+
+	if (CPL_IS_OK(ret) && cpl_reachability_index == NULL) {
+		ret = CPL_E_NOT_INITIALIZED;
+	}
+
+	if (CPL_IS_OK(ret)) {
+		for (size_t i = 0; i < log.size(); i++) {
+			const cpl_id_version_t& from = log[i].first;
+			const cpl_id_version_t& to = log[i].second;
+			if (to.version == CPL_VERSION_NONE) {
+				index->add_version(from.id, from.version);
+			}
+			else {
+				index->add_edge(from.id, from.version, to.id, to.version);
+			}
 		}
+
+		old = cpl_reachability_index;
+		cpl_reachability_index = index;
+		path = cpl_reachability_index_path;
+		index = NULL;
 	}
 
+	cpl_unlock(&cpl_reachability_index_lock);
 
-	// Call the database backend
+	if (index != NULL) delete index;
+	if (old != NULL) delete old;
+	CPL_RUNTIME_VERIFY(ret);
 
-	cpl_return_t r;
-	r = cpl_db_backend->cpl_db_get_object_ancestry(cpl_db_backend,
-												   id, version, direction,
-												   new_flags, iterator,
-												   context);
-	
-	if (r == CPL_S_NO_DATA && has_version_dependency) return CPL_OK;
-	return r;
+
+	// Save the new index. The index can be disabled by cpl_detach() only
+	// after the rebuild lock is released, so it stays valid.
+
+	if (!path.empty()) {
+		CPL_RUNTIME_VERIFY(cpl_reachability_index->save(path.c_str()));
+	}
+
+	return CPL_OK;
 }
 
 
+
+/***************************************************************************/
+/** Public API: Result Cache                                              **/
+/***************************************************************************/
+
+
 /**
- * Get the properties associated with the given provenance object.
+ * Enable the in-memory cache of the results of cpl_get_object_ancestry()
+ * for the ancestors and of cpl_get_properties(). The results for versions
+ * older than the current version of the object never change and are kept
+ * until evicted; the other results are dropped when the object is thawed,
+ * gains a new version, or gains a new property.
  *
- * @param id the the object ID
- * @param version the object version, or CPL_VERSION_NONE to access all
- *                version nodes associated with the given object
- * @param key the property to fetch - or NULL for all properties
- * @param iterator the iterator callback function
- * @param context the user context to be passed to the iterator function
- * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ * The updates made by other processes are observed only when they create
+ * a new version of the object, so properties added by another process to
+ * its current version might not be visible until then.
+ *
+ * @param max_bytes the maximum memory footprint of the cached results
+ * @return CPL_OK or an error code
  */
 extern "C" EXPORT cpl_return_t
-cpl_get_properties(const cpl_id_t id,
-				   const cpl_version_t version,
-				   const char* key,
-				   cpl_property_iterator_t iterator,
-				   void* context)
+cpl_enable_result_cache(const size_t max_bytes)
 {
 	CPL_ENSURE_INITALIZED;
-	CPL_ENSURE_NOT_NONE(id);
-	CPL_ENSURE_NOT_NULL(iterator);
 
+	if (max_bytes == 0) return CPL_E_INVALID_ARGUMENT;
 
-	// Validate the object version
-
-	if (version != CPL_VERSION_NONE) {
-		CPL_ENSURE_NOT_NEGATIVE(version);
+	CPLResultCache* cache = new CPLResultCache(max_bytes);
+	if (cache == NULL) return CPL_E_INSUFFICIENT_RESOURCES;
 
-		cpl_version_t current_version;
-		CPL_RUNTIME_VERIFY(cpl_get_version(id, &current_version));
+	cpl_lock(&cpl_result_cache_lock);
+	bool enabled = cpl_result_cache != NULL;
+	if (!enabled) cpl_result_cache = cache;
+	cpl_unlock(&cpl_result_cache_lock);
 
-		if (version < 0 || version > current_version) {
-			return CPL_E_INVALID_VERSION;
-		}
+	if (enabled) {
+		delete cache;
+		return CPL_E_ALREADY_INITIALIZED;
 	}
 
+	return CPL_OK;
+}
+
 
-	// Call the database backend
+/**
+ * Disable the result cache and release its memory. The memory is released
+ * as soon as the queries that are using the cache in other threads finish.
+ *
+ * @return CPL_OK or an error code
+ */
+extern "C" EXPORT cpl_return_t
+cpl_disable_result_cache(void)
+{
+	CPL_ENSURE_INITALIZED;
+
+	cpl_lock(&cpl_result_cache_lock);
+	CPLResultCache* cache = cpl_result_cache;
+	cpl_result_cache = NULL;
+	cpl_unlock(&cpl_result_cache_lock);
+
+	if (cache == NULL) return CPL_E_NOT_INITIALIZED;
 
-	return cpl_db_backend->cpl_db_get_properties(cpl_db_backend,
-												 id, version, key,
-												 iterator, context);
+	cpl_result_cache_release(cache);
+	return CPL_OK;
 }
 
 
 /**
- * Lookup an object based on a property value.
+ * Get the statistics of the result cache.
  *
- * @param key the property name
- * @param value the property value
- * @param iterator the iterator callback function
- * @param context the user context to be passed to the iterator function
- * @return CPL_OK, CPL_E_NOT_FOUND, or an error code
+ * @param out_stats the pointer to store the statistics
+ * @return CPL_OK or an error code
  */
 extern "C" EXPORT cpl_return_t
-cpl_lookup_by_property(const char* key,
-					   const char* value,
-					   cpl_property_iterator_t iterator,
-					   void* context)
+cpl_get_result_cache_stats(cpl_result_cache_stats_t* out_stats)
 {
 	CPL_ENSURE_INITALIZED;
-	CPL_ENSURE_NOT_NULL(iterator);
-	CPL_ENSURE_NOT_NULL(key);
-	CPL_ENSURE_NOT_NULL(value);
-
+	CPL_ENSURE_NOT_NULL(out_stats);
 
-	// Call the database backend
+	CPLResultCache* cache = cpl_result_cache_acquire();
+	if (cache == NULL) return CPL_E_NOT_INITIALIZED;
 
-	return cpl_db_backend->cpl_db_lookup_by_property(cpl_db_backend,
-													 key, value,
-													 iterator, context);
+	cache->get_stats(out_stats);
+	cpl_result_cache_release(cache);
+	return CPL_OK;
 }
 
 
@@ -1966,6 +4286,143 @@ cpl_cb_collect_property_lookup_vector(const cpl_id_t id,
 }
 
 
+/**
+ * The iterator callback for cpl_get_versions_in_range() and
+ * cpl_get_session_activity() that collects the returned information in
+ * an instance of std::vector<cpl_version_info_t>.
+ *
+ * @param info the version info
+ * @param context the pointer to an instance of the vector
+ * @return CPL_OK or an error code
+ */
+#ifdef SWIG
+%constant
+#endif
+EXPORT cpl_return_t
+cpl_cb_collect_version_info_vector(const cpl_version_info_t* info,
+								   void* context)
+{
+	if (context == NULL) return CPL_E_INVALID_ARGUMENT;
+
+	std::vector<cpl_version_info_t>& l =
+		*((std::vector<cpl_version_info_t>*) context);
+	l.push_back(*info);
+
+	return CPL_OK;
+}
+
+
+/**
+ * The iterator callback for cpl_get_graph_statistics() that collects the
+ * returned information in an instance of
+ * std::vector<cplxx_graph_statistic_t>.
+ *
+ * @param stat the statistic
+ * @param context the pointer to an instance of the vector
+ * @return CPL_OK or an error code
+ */
+#ifdef SWIG
+%constant
+#endif
+EXPORT cpl_return_t
+cpl_cb_collect_graph_statistics_vector(const cpl_graph_statistic_t* stat,
+									   void* context)
+{
+	if (context == NULL) return CPL_E_INVALID_ARGUMENT;
+
+	cplxx_graph_statistic_t e;
+	e.kind = stat->kind;
+	e.key = stat->key;
+	if (stat->originator != NULL) e.originator = stat->originator;
+	if (stat->type != NULL) e.type = stat->type;
+	e.count = stat->count;
+
+	std::vector<cplxx_graph_statistic_t>& l =
+		*((std::vector<cplxx_graph_statistic_t>*) context);
+	l.push_back(e);
+
+	return CPL_OK;
+}
+
+
+/**
+ * The iterator callback for cpl_diff_lineage() and cpl_diff_sessions() that
+ * collects the returned information in an instance of
+ * std::vector<cplxx_diff_entry_t>.
+ *
+ * @param entry the difference
+ * @param context the pointer to an instance of the vector
+ * @return CPL_OK or an error code
+ */
+#ifdef SWIG
+%constant
+#endif
+EXPORT cpl_return_t
+cpl_cb_collect_diff_vector(const cpl_diff_entry_t* entry,
+						   void* context)
+{
+	if (context == NULL) return CPL_E_INVALID_ARGUMENT;
+
+	cplxx_diff_entry_t e;
+	e.kind = entry->kind;
+	e.changes = entry->changes;
+	e.dependency_type = entry->dependency_type;
+	e.left_consumer = entry->left_consumer;
+	e.right_consumer = entry->right_consumer;
+	e.left_id = entry->left_id;
+	e.left_version = entry->left_version;
+	e.right_id = entry->right_id;
+	e.right_version = entry->right_version;
+	e.originator = entry->originator;
+	e.name = entry->name;
+	e.type = entry->type;
+
+	std::vector<cplxx_diff_entry_t>& l =
+		*((std::vector<cplxx_diff_entry_t>*) context);
+	l.push_back(e);
+
+	return CPL_OK;
+}
+
+
+/**
+ * Fetch the next batch of objects from a cursor into an instance of
+ * std::vector<cplxx_object_info_t>, replacing its previous contents.
+ *
+ * @param cursor the cursor opened by cpl_open_object_cursor()
+ * @param max_count the maximum number of objects to fetch
+ * @param context the pointer to an instance of the vector
+ * @return CPL_OK, CPL_S_NO_DATA if there are no more objects, or an error
+ *         code
+ */
+EXPORT cpl_return_t
+cpl_cursor_fetch_object_info_vector(cpl_cursor_t* cursor,
+									const size_t max_count,
+									void* context)
+{
+	if (context == NULL) return CPL_E_INVALID_ARGUMENT;
+
+	std::vector<cplxx_object_info_t>& l =
+		*((std::vector<cplxx_object_info_t>*) context);
+	l.clear();
+	if (max_count == 0) return CPL_OK;
+
+	std::vector<cpl_object_info_t*> infos(max_count, NULL);
+	size_t count = 0;
+
+	cpl_return_t ret = cpl_cursor_fetch_objects(cursor, max_count,
+												&infos[0], &count);
+	if (!CPL_IS_OK(ret)) return ret;
+
+	for (size_t i = 0; i < count; i++) {
+		cpl_cb_collect_object_info_vector(infos[i], context);
+		cpl_free_object_info(infos[i]);
+	}
+
+	return ret;
+}
+
+
 
 #endif /* __cplusplus */
 
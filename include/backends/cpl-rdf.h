@@ -68,6 +68,22 @@ extern "C" {
 
 
 
+/***************************************************************************/
+/** Result Formats                                                        **/
+/***************************************************************************/
+
+/**
+ * SPARQL Query Results XML Format
+ */
+#define CPL_RDF_RESULTS_XML		0
+
+/**
+ * SPARQL Query Results JSON Format
+ */
+#define CPL_RDF_RESULTS_JSON	1
+
+
+
 /***************************************************************************/
 /** Constructor                                                           **/
 /***************************************************************************/
@@ -87,6 +103,47 @@ cpl_create_rdf_backend(const char* url_query,
 					   int db_type,
 					   cpl_db_backend_t** out);
 
+
+
+/***************************************************************************/
+/** Extended Queries                                                      **/
+/***************************************************************************/
+
+/**
+ * The maximum number of hops for cpl_rdf_get_object_ancestry_hops()
+ */
+#define CPL_RDF_MAX_HOPS		8
+
+/**
+ * Iterate over all ancestry edges that are at most the given number of hops
+ * away from a provenance object, fetching all hops in a single request
+ * instead of one request per object. The iterator is called once for each
+ * edge, with the endpoint closer to the queried object as the query object.
+ *
+ * @param backend the RDF backend
+ * @param id the object ID
+ * @param version the object version, or CPL_VERSION_NONE to start from all
+ *                version nodes associated with the given object
+ * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+ *                  or CPL_D_DESCENDANTS)
+ * @param flags the bitwise combination of flags describing how should
+ *              the graph be traversed (a logical combination of the
+ *              CPL_A_* flags)
+ * @param max_hops the maximum number of hops (1 to CPL_RDF_MAX_HOPS)
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+cpl_return_t
+cpl_rdf_get_object_ancestry_hops(cpl_db_backend_t* backend,
+								 const cpl_id_t id,
+								 const cpl_version_t version,
+								 const int direction,
+								 const int flags,
+								 const int max_hops,
+								 cpl_ancestry_iterator_t iterator,
+								 void* context);
+
 #ifdef __cplusplus
 }
 #endif
@@ -359,6 +359,266 @@ typedef struct _cpl_db_backend_t {
 								 cpl_property_iterator_t iterator,
 								 void* context);
 
+	/**
+	 * Iterate over the immediate ancestors or descendants of several
+	 * version nodes at once, fetching them in as few requests as possible.
+	 * The iterator receives the query node of each edge, so the edges can
+	 * be returned in any order.
+	 *
+	 * @param backend the pointer to the backend structure
+	 * @param nodes the array of version nodes (the versions must not be
+	 *              CPL_VERSION_NONE)
+	 * @param count the number of nodes in the array
+	 * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+	 *                  or CPL_D_DESCENDANTS)
+	 * @param flags the bitwise combination of flags describing how should
+	 *              the graph be traversed (a logical combination of the
+	 *              CPL_A_* flags)
+	 * @param iterator the iterator callback function
+	 * @param context the user context to be passed to the iterator function
+	 * @return CPL_OK, CPL_S_NO_DATA, or an error code
+	 */
+	cpl_return_t
+	(*cpl_db_get_object_ancestry_batch)(struct _cpl_db_backend_t* backend,
+										const cpl_id_version_t* nodes,
+										const size_t count,
+										const int direction,
+										const int flags,
+										cpl_ancestry_iterator_t iterator,
+										void* context);
+
+	/**
+	 * Iterate over all transitive ancestors or descendants of a version
+	 * node, including the other versions of the same object, using
+	 * a precomputed closure of the provenance graph. Each reachable node is
+	 * returned exactly once, with the type set to CPL_DEPENDENCY_NONE.
+	 *
+	 * @param backend the pointer to the backend structure
+	 * @param id the object ID
+	 * @param version the object version (must not be CPL_VERSION_NONE)
+	 * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+	 *                  or CPL_D_DESCENDANTS)
+	 * @param iterator the iterator callback function
+	 * @param context the user context to be passed to the iterator function
+	 * @return CPL_OK, CPL_S_NO_DATA, CPL_E_NOT_IMPLEMENTED if the closure
+	 *         is not available, or an error code
+	 */
+	cpl_return_t
+	(*cpl_db_get_transitive_ancestry)(struct _cpl_db_backend_t* backend,
+									  const cpl_id_t id,
+									  const cpl_version_t version,
+									  const int direction,
+									  cpl_ancestry_iterator_t iterator,
+									  void* context);
+
+	/**
+	 * Get information about several provenance objects at once, including
+	 * their latest versions.
+	 *
+	 * @param backend the pointer to the backend structure
+	 * @param ids the array of unique object IDs
+	 * @param count the number of object IDs
+	 * @param out_infos the array of count pointers to store the object info
+	 *                  structures, which are all set to NULL on error
+	 * @return CPL_OK, CPL_E_NOT_FOUND if any of the objects does not exist,
+	 *         CPL_E_NOT_IMPLEMENTED if the backend cannot batch the request,
+	 *         or an error code
+	 */
+	cpl_return_t
+	(*cpl_db_get_object_info_batch)(struct _cpl_db_backend_t* backend,
+									const cpl_id_t* ids,
+									const size_t count,
+									cpl_object_info_t** out_infos);
+
+	/**
+	 * Get information about several version nodes at once.
+	 *
+	 * @param backend the pointer to the backend structure
+	 * @param nodes the array of unique version nodes
+	 * @param count the number of version nodes
+	 * @param out_infos the array of count pointers to store the version info
+	 *                  structures, which are all set to NULL on error
+	 * @return CPL_OK, CPL_E_NOT_FOUND if any of the versions does not exist,
+	 *         CPL_E_NOT_IMPLEMENTED if the backend cannot batch the request,
+	 *         or an error code
+	 */
+	cpl_return_t
+	(*cpl_db_get_version_info_batch)(struct _cpl_db_backend_t* backend,
+									 const cpl_id_version_t* nodes,
+									 const size_t count,
+									 cpl_version_info_t** out_infos);
+
+	/**
+	 * Get information about several provenance sessions at once.
+	 *
+	 * @param backend the pointer to the backend structure
+	 * @param ids the array of unique session IDs
+	 * @param count the number of session IDs
+	 * @param out_infos the array of count pointers to store the session info
+	 *                  structures, which are all set to NULL on error
+	 * @return CPL_OK, CPL_E_NOT_FOUND if any of the sessions does not exist,
+	 *         CPL_E_NOT_IMPLEMENTED if the backend cannot batch the request,
+	 *         or an error code
+	 */
+	cpl_return_t
+	(*cpl_db_get_session_info_batch)(struct _cpl_db_backend_t* backend,
+									 const cpl_session_t* ids,
+									 const size_t count,
+									 cpl_session_info_t** out_infos);
+
+	/**
+	 * Get the next page of objects in the order of their IDs, using keyset
+	 * pagination. The order is backend-specific, but it must be the same
+	 * for all pages.
+	 *
+	 * @param backend the pointer to the backend structure
+	 * @param after the ID of the last object of the previous page, or
+	 *              CPL_NONE to get the first page
+	 * @param originator the object originator, or NULL for any
+	 * @param type the object type, or NULL for any
+	 * @param flags a logical combination of CPL_I_* flags
+	 * @param max_count the maximum number of objects to return
+	 * @param out_infos the array of max_count pointers to store the object
+	 *                  info structures
+	 * @param out_count the pointer to store the number of returned objects,
+	 *                  which can be less than max_count even if there are
+	 *                  more objects
+	 * @return CPL_OK, CPL_S_NO_DATA if there are no more objects, or an
+	 *         error code
+	 */
+	cpl_return_t
+	(*cpl_db_get_objects_page)(struct _cpl_db_backend_t* backend,
+							   const cpl_id_t after,
+							   const char* originator,
+							   const char* type,
+							   const int flags,
+							   const size_t max_count,
+							   cpl_object_info_t** out_infos,
+							   size_t* out_count);
+
+	/**
+	 * Iterate over all version nodes created within the given time range,
+	 * ordered by their creation time.
+	 *
+	 * @param backend the pointer to the backend structure
+	 * @param start_time the start of the time range (inclusive)
+	 * @param end_time the end of the time range (inclusive)
+	 * @param iterator the iterator to be called for each matching version
+	 * @param context the caller-provided iterator context
+	 * @return CPL_OK, CPL_S_NO_DATA, or an error code
+	 */
+	cpl_return_t
+	(*cpl_db_get_versions_in_range)(struct _cpl_db_backend_t* backend,
+									const unsigned long start_time,
+									const unsigned long end_time,
+									cpl_version_info_iterator_t iterator,
+									void* context);
+
+	/**
+	 * Iterate over all version nodes created by the given session, ordered
+	 * by their creation time.
+	 *
+	 * @param backend the pointer to the backend structure
+	 * @param session the session ID
+	 * @param iterator the iterator to be called for each matching version
+	 * @param context the caller-provided iterator context
+	 * @return CPL_OK, CPL_S_NO_DATA, or an error code
+	 */
+	cpl_return_t
+	(*cpl_db_get_session_activity)(struct _cpl_db_backend_t* backend,
+								   const cpl_session_t session,
+								   cpl_version_info_iterator_t iterator,
+								   void* context);
+
+	/**
+	 * Find the objects that satisfy all of the given property predicates,
+	 * and optionally have the given originator and type. The predicates
+	 * have been already validated by the caller.
+	 *
+	 * @param backend the pointer to the backend structure
+	 * @param originator the object originator, or NULL for any
+	 * @param type the object type, or NULL for any
+	 * @param predicates the array of property predicates
+	 * @param num_predicates the number of predicates
+	 * @param iterator the iterator to be called for each matching object
+	 * @param context the caller-provided iterator context
+	 * @return CPL_OK, CPL_E_NOT_FOUND, or an error code
+	 */
+	cpl_return_t
+	(*cpl_db_query_by_properties)(struct _cpl_db_backend_t* backend,
+								  const char* originator,
+								  const char* type,
+								  const cpl_property_predicate_t* predicates,
+								  const size_t num_predicates,
+								  cpl_id_timestamp_iterator_t iterator,
+								  void* context);
+
+	/**
+	 * Get the objects created inside the given container, optionally
+	 * including the contents of the nested containers at any depth.
+	 *
+	 * @param backend the pointer to the backend structure
+	 * @param container the container ID
+	 * @param version the container version, or CPL_VERSION_NONE for all
+	 *                versions of the container
+	 * @param recursive whether to descend into the nested containers
+	 * @param flags a logical combination of CPL_I_* flags
+	 * @param iterator the iterator to be called for each contained object
+	 * @param context the caller-provided iterator context
+	 * @return CPL_OK, CPL_S_NO_DATA, or an error code
+	 */
+	cpl_return_t
+	(*cpl_db_get_contained_objects)(struct _cpl_db_backend_t* backend,
+									const cpl_id_t container,
+									const cpl_version_t version,
+									const int recursive,
+									const int flags,
+									cpl_object_info_iterator_t iterator,
+									void* context);
+
+	/**
+	 * Get the objects whose names start with the given prefix, ordered by
+	 * their names, optionally restricted to the given originator and type.
+	 *
+	 * @param backend the pointer to the backend structure
+	 * @param originator the object originator, or NULL for any
+	 * @param prefix the name prefix
+	 * @param type the object type, or NULL for any
+	 * @param flags a logical combination of CPL_I_* flags
+	 * @param iterator the iterator to be called for each matching object
+	 * @param context the caller-provided iterator context
+	 * @return CPL_OK, CPL_S_NO_DATA, or an error code
+	 */
+	cpl_return_t
+	(*cpl_db_lookup_by_name_prefix)(struct _cpl_db_backend_t* backend,
+									const char* originator,
+									const char* prefix,
+									const char* type,
+									const int flags,
+									cpl_object_info_iterator_t iterator,
+									void* context);
+
+	/**
+	 * Compute aggregate statistics about the provenance graph, attributing
+	 * each object, version node, and edge to the time of its creation.
+	 *
+	 * @param backend the pointer to the backend structure
+	 * @param kinds a logical combination of the CPL_GS_* constants
+	 * @param start_time the start of the time range (inclusive)
+	 * @param end_time the end of the time range (inclusive), or 0
+	 * @param iterator the iterator to be called for each group, ordered by
+	 *                 kind and then by key
+	 * @param context the caller-provided iterator context
+	 * @return CPL_OK, CPL_S_NO_DATA, or an error code
+	 */
+	cpl_return_t
+	(*cpl_db_get_graph_statistics)(struct _cpl_db_backend_t* backend,
+								   const int kinds,
+								   const unsigned long start_time,
+								   const unsigned long end_time,
+								   cpl_graph_statistic_iterator_t iterator,
+								   void* context);
+
 } cpl_db_backend_t;
 
 
@@ -242,6 +242,17 @@ typedef struct cpl_version_info {
 
 } cpl_version_info_t;
 
+/**
+ * The iterator callback for getting multiple version infos.
+ *
+ * @param info the version info
+ * @param context the application-provided context
+ * @return CPL_OK or an error code (the caller should fail on this error)
+ */
+typedef cpl_return_t (*cpl_version_info_iterator_t)
+						(const cpl_version_info_t* info,
+						 void* context);
+
 /**
  * The iterator callback function used by cpl_lookup_object_ext().
  *
@@ -315,6 +326,157 @@ typedef cpl_return_t (*cpl_property_iterator_t)
 						 const char* value,
 						 void* context);
 
+/**
+ * An opaque cursor for paging through a large result set, such as the set
+ * of all objects, in constant memory.
+ */
+typedef struct cpl_cursor cpl_cursor_t;
+
+/**
+ * A condition on the values of a property, used by cpl_query_by_properties().
+ * The condition holds for an object if at least one of its versions has the
+ * given property with a matching value.
+ */
+typedef struct cpl_property_predicate {
+
+	/// The property name.
+	const char* key;
+
+	/// The comparison operator (one of the CPL_PQ_* constants).
+	int op;
+
+	/// The array of values (exactly one for CPL_PQ_EQUALS and CPL_PQ_PREFIX).
+	const char* const* values;
+
+	/// The number of values.
+	size_t num_values;
+
+} cpl_property_predicate_t;
+
+/**
+ * One row of the aggregate statistics about the provenance graph, returned
+ * by cpl_get_graph_statistics().
+ */
+typedef struct cpl_graph_statistic {
+
+	/// The kind of the statistic (one of the CPL_GS_* constants).
+	int kind;
+
+	/// The group: the dependency type for CPL_GS_EDGES_BY_TYPE, the number
+	/// of versions for CPL_GS_VERSIONS_PER_OBJECT, the number of edges for
+	/// CPL_GS_FAN_IN and CPL_GS_FAN_OUT, or the local midnight that starts
+	/// the day, expressed as UNIX time, for CPL_GS_OBJECTS_PER_DAY.
+	long long key;
+
+	/// The object originator (CPL_GS_OBJECTS_PER_DAY only, otherwise NULL).
+	const char* originator;
+
+	/// The object type (CPL_GS_OBJECTS_PER_DAY only, otherwise NULL).
+	const char* type;
+
+	/// The number of edges, objects, or versions in the group.
+	unsigned long long count;
+
+} cpl_graph_statistic_t;
+
+/**
+ * The statistics of the query result cache, returned by
+ * cpl_get_result_cache_stats().
+ */
+typedef struct cpl_result_cache_stats {
+
+	/// The number of queries answered from the cache.
+	unsigned long long hits;
+
+	/// The number of queries passed to the database backend.
+	unsigned long long misses;
+
+	/// The number of results dropped because the object has changed.
+	unsigned long long invalidations;
+
+	/// The number of results dropped to stay within the memory limit.
+	unsigned long long evictions;
+
+	/// The number of cached results.
+	size_t entries;
+
+	/// The estimated memory footprint of the cached results, in bytes.
+	size_t bytes;
+
+	/// The memory limit, in bytes.
+	size_t max_bytes;
+
+} cpl_result_cache_stats_t;
+
+/**
+ * One difference between two lineages, returned by cpl_diff_lineage() and
+ * cpl_diff_sessions(). Each difference concerns an input of a pair of
+ * aligned objects (the consumers), or one of the roots of the diff.
+ */
+typedef struct cpl_diff_entry {
+
+	/// The kind of the difference (CPL_DIFF_ADDED, CPL_DIFF_REMOVED, or
+	/// CPL_DIFF_CHANGED).
+	int kind;
+
+	/// What has changed (a logical combination of CPL_DIFF_CONTENT,
+	/// CPL_DIFF_INPUTS, and CPL_DIFF_RENAMED), or 0 if not CPL_DIFF_CHANGED.
+	int changes;
+
+	/// The dependency type of the input, or 0 for the roots.
+	int dependency_type;
+
+	/// The consumer in the left lineage, or CPL_NONE for the roots.
+	cpl_id_t left_consumer;
+
+	/// The consumer in the right lineage, or CPL_NONE for the roots.
+	cpl_id_t right_consumer;
+
+	/// The input in the left lineage, or CPL_NONE if added.
+	cpl_id_t left_id;
+
+	/// The latest version of the left input within its lineage.
+	cpl_version_t left_version;
+
+	/// The input in the right lineage, or CPL_NONE if removed.
+	cpl_id_t right_id;
+
+	/// The latest version of the right input within its lineage.
+	cpl_version_t right_version;
+
+	/// The originator of the input (of the right one if both exist).
+	const char* originator;
+
+	/// The name of the input (of the right one if both exist).
+	const char* name;
+
+	/// The type of the input (of the right one if both exist).
+	const char* type;
+
+} cpl_diff_entry_t;
+
+/**
+ * The iterator callback for cpl_get_graph_statistics().
+ *
+ * @param stat the statistic
+ * @param context the application-provided context
+ * @return CPL_OK or an error code (the caller should fail on this error)
+ */
+typedef cpl_return_t (*cpl_graph_statistic_iterator_t)
+						(const cpl_graph_statistic_t* stat,
+						 void* context);
+
+/**
+ * The iterator callback for cpl_diff_lineage() and cpl_diff_sessions().
+ *
+ * @param entry the difference
+ * @param context the application-provided context
+ * @return CPL_OK or an error code (the caller should fail on this error)
+ */
+typedef cpl_return_t (*cpl_diff_iterator_t)
+						(const cpl_diff_entry_t* entry,
+						 void* context);
+
 /*
  * Static assertions
  */
@@ -624,6 +786,12 @@ WINDLL_API extern const cpl_id_t CPL_NONE;
 #define CPL_E_DB_INVALID_TYPE			-17
 #define __CPL_E_STR__17	"The value in a database has an unexpected type"
 
+/**
+ * The query is not valid
+ */
+#define CPL_E_INVALID_QUERY				-18
+#define __CPL_E_STR__18					"Invalid query"
+
 
 
 /***************************************************************************/
@@ -718,6 +886,92 @@ WINDLL_API extern const cpl_id_t CPL_NONE;
  */
 #define CPL_A_NO_CONTROL_DEPENDENCIES	(1 << 2)
 
+/**
+ * Match the property value exactly
+ */
+#define CPL_PQ_EQUALS					1
+
+/**
+ * Match the property values that start with the given prefix
+ */
+#define CPL_PQ_PREFIX					2
+
+/**
+ * Match any of the given property values
+ */
+#define CPL_PQ_IN						3
+
+/**
+ * Count the ancestry edges by their dependency type
+ */
+#define CPL_GS_EDGES_BY_TYPE			(1 << 0)
+
+/**
+ * Count the objects by their number of versions
+ */
+#define CPL_GS_VERSIONS_PER_OBJECT		(1 << 1)
+
+/**
+ * Count the version nodes by their number of direct ancestors
+ */
+#define CPL_GS_FAN_IN					(1 << 2)
+
+/**
+ * Count the version nodes by their number of direct descendants
+ */
+#define CPL_GS_FAN_OUT					(1 << 3)
+
+/**
+ * Count the objects by their originator, type, and creation day
+ */
+#define CPL_GS_OBJECTS_PER_DAY			(1 << 4)
+
+/**
+ * Compute all statistics
+ */
+#define CPL_GS_ALL						(CPL_GS_EDGES_BY_TYPE \
+											| CPL_GS_VERSIONS_PER_OBJECT \
+											| CPL_GS_FAN_IN \
+											| CPL_GS_FAN_OUT \
+											| CPL_GS_OBJECTS_PER_DAY)
+
+
+
+/***************************************************************************/
+/** Lineage Diff                                                          **/
+/***************************************************************************/
+
+/**
+ * The input exists only in the right lineage
+ */
+#define CPL_DIFF_ADDED					1
+
+/**
+ * The input exists only in the left lineage
+ */
+#define CPL_DIFF_REMOVED				2
+
+/**
+ * The input exists in both lineages, but it or its ancestry differs
+ */
+#define CPL_DIFF_CHANGED				3
+
+/**
+ * The SHA1 fingerprints of the two inputs differ
+ */
+#define CPL_DIFF_CONTENT				(1 << 0)
+
+/**
+ * The inputs of the two inputs differ, directly or transitively
+ */
+#define CPL_DIFF_INPUTS					(1 << 1)
+
+/**
+ * The two inputs were aligned by their SHA1 fingerprints, but their
+ * originators, names, or types differ
+ */
+#define CPL_DIFF_RENAMED				(1 << 2)
+
 
 
 /***************************************************************************/
@@ -972,6 +1226,22 @@ cpl_get_session_info(const cpl_session_t id,
 EXPORT cpl_return_t
 cpl_free_session_info(cpl_session_info_t* info);
 
+/**
+ * Get information about several provenance sessions at once. The IDs do
+ * not need to be unique; each output slot receives its own structure.
+ *
+ * @param ids the array of session IDs
+ * @param count the number of session IDs
+ * @param out_infos the array of count pointers to store the session info
+ *                  structures, each of which needs to be freed using
+ *                  cpl_free_session_info(); all are set to NULL on error
+ * @return CPL_OK or an error code
+ */
+EXPORT cpl_return_t
+cpl_get_session_info_batch(const cpl_session_t* ids,
+						   const size_t count,
+						   cpl_session_info_t** out_infos);
+
 /**
  * Get all objects in the database
  *
@@ -985,6 +1255,96 @@ cpl_get_all_objects(const int flags,
 					cpl_object_info_iterator_t iterator,
 					void* context);
 
+/**
+ * Get the objects created inside the given container. If recursive is
+ * nonzero, include also the contents of the nested containers (all their
+ * versions), at any depth.
+ *
+ * @param container the container ID
+ * @param version the container version, or CPL_VERSION_NONE for all
+ *                versions of the container
+ * @param recursive whether to descend into the nested containers
+ * @param flags a logical combination of CPL_I_* flags
+ * @param iterator the iterator to be called for each contained object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA if the container is empty, or an error code
+ */
+EXPORT cpl_return_t
+cpl_get_contained_objects(const cpl_id_t container,
+						  const cpl_version_t version,
+						  const int recursive,
+						  const int flags,
+						  cpl_object_info_iterator_t iterator,
+						  void* context);
+
+/**
+ * Get the objects whose names start with the given prefix, such as the
+ * files under a given directory, ordered by their names and optionally
+ * restricted to the given originator and type.
+ *
+ * @param originator the object originator, or NULL for any
+ * @param prefix the name prefix
+ * @param type the object type, or NULL for any
+ * @param flags a logical combination of CPL_I_* flags
+ * @param iterator the iterator to be called for each matching object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA if there are no such objects, or an error
+ *         code
+ */
+EXPORT cpl_return_t
+cpl_lookup_by_name_prefix(const char* originator,
+						  const char* prefix,
+						  const char* type,
+						  const int flags,
+						  cpl_object_info_iterator_t iterator,
+						  void* context);
+
+/**
+ * Open a cursor over all objects in the database, optionally restricted to
+ * the given originator and/or type. The cursor does not keep any database
+ * resources open between the fetches; it remembers only the last returned
+ * object ID, and each fetch resumes right after it.
+ *
+ * @param originator the object originator, or NULL for any
+ * @param type the object type, or NULL for any
+ * @param flags a logical combination of CPL_I_* flags
+ * @param out_cursor the pointer to store the new cursor, which needs to be
+ *                   closed using cpl_close_cursor()
+ * @return CPL_OK or an error code
+ */
+EXPORT cpl_return_t
+cpl_open_object_cursor(const char* originator,
+					   const char* type,
+					   const int flags,
+					   cpl_cursor_t** out_cursor);
+
+/**
+ * Fetch the next batch of objects from a cursor.
+ *
+ * @param cursor the cursor opened by cpl_open_object_cursor()
+ * @param max_count the maximum number of objects to fetch
+ * @param out_infos the array of max_count pointers to store the object info
+ *                  structures, each of which needs to be freed using
+ *                  cpl_free_object_info()
+ * @param out_count the pointer to store the number of fetched objects
+ * @return CPL_OK, CPL_S_NO_DATA if there are no more objects, or an error
+ *         code
+ */
+EXPORT cpl_return_t
+cpl_cursor_fetch_objects(cpl_cursor_t* cursor,
+						 const size_t max_count,
+						 cpl_object_info_t** out_infos,
+						 size_t* out_count);
+
+/**
+ * Close a cursor and free its resources.
+ *
+ * @param cursor the cursor
+ * @return CPL_OK or an error code
+ */
+EXPORT cpl_return_t
+cpl_close_cursor(cpl_cursor_t* cursor);
+
 /**
  * Get information about the given provenance object.
  *
@@ -1005,6 +1365,22 @@ cpl_get_object_info(const cpl_id_t id,
 EXPORT cpl_return_t
 cpl_free_object_info(cpl_object_info_t* info);
 
+/**
+ * Get information about several provenance objects at once. The IDs do
+ * not need to be unique; each output slot receives its own structure.
+ *
+ * @param ids the array of object IDs
+ * @param count the number of object IDs
+ * @param out_infos the array of count pointers to store the object info
+ *                  structures, each of which needs to be freed using
+ *                  cpl_free_object_info(); all are set to NULL on error
+ * @return CPL_OK or an error code
+ */
+EXPORT cpl_return_t
+cpl_get_object_info_batch(const cpl_id_t* ids,
+						  const size_t count,
+						  cpl_object_info_t** out_infos);
+
 /**
  * Get information about the specific version of a provenance object.
  *
@@ -1027,6 +1403,54 @@ cpl_get_version_info(const cpl_id_t id,
 EXPORT cpl_return_t
 cpl_free_version_info(cpl_version_info_t* info);
 
+/**
+ * Get information about several version nodes at once. The nodes do not
+ * need to be unique; each output slot receives its own structure.
+ *
+ * @param nodes the array of version nodes
+ * @param count the number of version nodes
+ * @param out_infos the array of count pointers to store the version info
+ *                  structures, each of which needs to be freed using
+ *                  cpl_free_version_info(); all are set to NULL on error
+ * @return CPL_OK or an error code
+ */
+EXPORT cpl_return_t
+cpl_get_version_info_batch(const cpl_id_version_t* nodes,
+						   const size_t count,
+						   cpl_version_info_t** out_infos);
+
+/**
+ * Iterate over all version nodes created within the given time range,
+ * ordered by their creation time.
+ *
+ * @param start_time the start of the time range (inclusive), expressed as
+ *                   UNIX time
+ * @param end_time the end of the time range (inclusive), expressed as
+ *                 UNIX time
+ * @param iterator the iterator to be called for each matching version
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+EXPORT cpl_return_t
+cpl_get_versions_in_range(const unsigned long start_time,
+						  const unsigned long end_time,
+						  cpl_version_info_iterator_t iterator,
+						  void* context);
+
+/**
+ * Iterate over all version nodes created by the given session, ordered by
+ * their creation time.
+ *
+ * @param session the session ID
+ * @param iterator the iterator to be called for each matching version
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+EXPORT cpl_return_t
+cpl_get_session_activity(const cpl_session_t session,
+						 cpl_version_info_iterator_t iterator,
+						 void* context);
+
 /**
  * Iterate over the ancestors or the descendants of a provenance object.
  *
@@ -1050,6 +1474,152 @@ cpl_get_object_ancestry(const cpl_id_t id,
 						cpl_ancestry_iterator_t iterator,
 						void* context);
 
+/**
+ * Iterate over the transitive ancestors or descendants of a provenance
+ * object. The graph is traversed breadth-first, and each level of the
+ * traversal is fetched from the database using a single batched request,
+ * so the number of round trips grows with the depth of the lineage rather
+ * than with the number of its nodes. The iterator is called once for each
+ * traversed edge, with the query node set to the node closer to the start.
+ *
+ * @param id the object ID
+ * @param version the object version, or CPL_VERSION_NONE to start from all
+ *                version nodes associated with the given object
+ * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+ *                  or CPL_D_DESCENDANTS)
+ * @param max_depth the maximum number of edges between the start and any
+ *                  returned node, or 0 for no limit
+ * @param flags the bitwise combination of flags describing how should
+ *              the graph be traversed (a logical combination of the
+ *              CPL_A_* flags)
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+EXPORT cpl_return_t
+cpl_get_object_lineage(const cpl_id_t id,
+					   const cpl_version_t version,
+					   const int direction,
+					   const int max_depth,
+					   const int flags,
+					   cpl_ancestry_iterator_t iterator,
+					   void* context);
+
+/**
+ * Iterate over the transitive ancestors or descendants of a provenance
+ * object using several threads. The result is the same as that of
+ * cpl_get_object_lineage(), but the frontier of the traversal is expanded
+ * by a pool of work-stealing threads, each issuing its own batched
+ * requests to the database, so the edges are not returned in the
+ * breadth-first order. The iterator is called from the worker threads,
+ * but never from more than one thread at a time.
+ *
+ * @param id the object ID
+ * @param version the object version, or CPL_VERSION_NONE to start from all
+ *                version nodes associated with the given object
+ * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+ *                  or CPL_D_DESCENDANTS)
+ * @param max_depth the maximum number of edges between the start and any
+ *                  returned node, or 0 for no limit
+ * @param flags the bitwise combination of flags describing how should
+ *              the graph be traversed (a logical combination of the
+ *              CPL_A_* flags)
+ * @param num_threads the number of threads including the calling thread,
+ *                    or 0 for the default
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+EXPORT cpl_return_t
+cpl_get_object_lineage_parallel(const cpl_id_t id,
+								const cpl_version_t version,
+								const int direction,
+								const int max_depth,
+								const int flags,
+								const int num_threads,
+								cpl_ancestry_iterator_t iterator,
+								void* context);
+
+/**
+ * Iterate over all transitive ancestors or descendants of a provenance
+ * object, including the other versions of the same object. Each reachable
+ * version node is returned once, with the type set to CPL_DEPENDENCY_NONE.
+ * If the database maintains an ancestry closure, the entire result is
+ * fetched using a single indexed lookup; otherwise the graph is traversed
+ * as in cpl_get_object_lineage().
+ *
+ * @param id the object ID
+ * @param version the object version, or CPL_VERSION_NONE to consider all
+ *                version nodes associated with the given object (which
+ *                are then excluded from the result)
+ * @param direction the direction of the graph traversal (CPL_D_ANCESTORS
+ *                  or CPL_D_DESCENDANTS)
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA, or an error code
+ */
+EXPORT cpl_return_t
+cpl_get_transitive_ancestry(const cpl_id_t id,
+							const cpl_version_t version,
+							const int direction,
+							cpl_ancestry_iterator_t iterator,
+							void* context);
+
+/**
+ * Determine whether an object version is an ancestor of another. The query
+ * uses the reachability index if it is enabled, and it otherwise traverses
+ * the graph in the database.
+ *
+ * @param id the ID of the descendant
+ * @param version the version of the descendant, or CPL_VERSION_NONE for
+ *                its latest version (or any of its versions if not
+ *                transitive)
+ * @param ancestor_id the ID of the ancestor
+ * @param ancestor_version the version of the ancestor, or CPL_VERSION_NONE
+ *                         for any of its versions
+ * @param transitive nonzero to consider the ancestors of any depth, or 0
+ *                   to consider only the immediate ancestors
+ * @param out_result the pointer to store the result (1 if it is an
+ *                   ancestor, or 0 otherwise)
+ * @return CPL_OK or an error code
+ */
+EXPORT cpl_return_t
+cpl_is_ancestor(const cpl_id_t id,
+				const cpl_version_t version,
+				const cpl_id_t ancestor_id,
+				const cpl_version_t ancestor_version,
+				const int transitive,
+				int* out_result);
+
+/**
+ * Find the shortest provenance path from an object version to one of its
+ * ancestors. The search is bidirectional: it expands the ancestors of the
+ * first node and the descendants of the second node, always advancing the
+ * side with the smaller frontier by one level using a single batched
+ * request, until the two sides meet. The iterator is called once for each
+ * edge of the path, in the order from the descendant to the ancestor, with
+ * the query node set to the node closer to the descendant.
+ *
+ * @param from_id the ID of the descendant
+ * @param from_version the version of the descendant, or CPL_VERSION_NONE
+ *                     for its latest version
+ * @param to_id the ID of the ancestor
+ * @param to_version the version of the ancestor, or CPL_VERSION_NONE for
+ *                   its first version
+ * @param max_depth the maximum length of the path, or 0 for no limit
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_S_NO_DATA if there is no such path, or an error code
+ */
+EXPORT cpl_return_t
+cpl_find_provenance_path(const cpl_id_t from_id,
+						 const cpl_version_t from_version,
+						 const cpl_id_t to_id,
+						 const cpl_version_t to_version,
+						 const int max_depth,
+						 cpl_ancestry_iterator_t iterator,
+						 void* context);
+
 /**
  * Get the properties associated with the given provenance object.
  *
@@ -1083,6 +1653,205 @@ cpl_lookup_by_property(const char* key,
 					   cpl_property_iterator_t iterator,
 					   void* context);
 
+/**
+ * Find the objects that satisfy all of the given property predicates, and
+ * optionally have the given originator and type. The iterator is called
+ * once for each matching object.
+ *
+ * @param originator the object originator, or NULL for any
+ * @param type the object type, or NULL for any
+ * @param predicates the array of property predicates
+ * @param num_predicates the number of predicates
+ * @param iterator the iterator callback function
+ * @param context the user context to be passed to the iterator function
+ * @return CPL_OK, CPL_E_NOT_FOUND, or an error code
+ */
+EXPORT cpl_return_t
+cpl_query_by_properties(const char* originator,
+						const char* type,
+						const cpl_property_predicate_t* predicates,
+						const size_t num_predicates,
+						cpl_id_timestamp_iterator_t iterator,
+						void* context);
+
+/**
+ * Compute aggregate statistics about the provenance graph in the database.
+ * Each object, version node, and edge is attributed to the time at which it
+ * was created (an edge is created together with the version node from which
+ * it originates), so that the statistics can be refreshed incrementally by
+ * adding up the results for disjoint time ranges. The numbers of versions
+ * and edges of the counted objects and version nodes are as of the time of
+ * the query. The iterator is called for each group, ordered by kind and
+ * then by key.
+ *
+ * @param kinds the statistics to compute (a logical combination of the
+ *              CPL_GS_* constants)
+ * @param start_time the start of the time range (inclusive), expressed as
+ *                   UNIX time
+ * @param end_time the end of the time range (inclusive), expressed as
+ *                 UNIX time, or 0 for no limit
+ * @param iterator the iterator to be called for each group
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA if there is nothing to count, or an error
+ *         code
+ */
+EXPORT cpl_return_t
+cpl_get_graph_statistics(const int kinds,
+						 const unsigned long start_time,
+						 const unsigned long end_time,
+						 cpl_graph_statistic_iterator_t iterator,
+						 void* context);
+
+/**
+ * Compare the lineages of two object versions, such as the outputs of two
+ * runs of the same pipeline. Each lineage is fetched one level at a time
+ * using batched requests, and the versions of each object within it are
+ * merged into a single node. The inputs of each pair of aligned nodes are
+ * matched by their originator, name, type, and dependency type, and the
+ * inputs left over are then matched by their SHA1 fingerprints. Pairs of
+ * nodes whose entire ancestry hashes to the same value are skipped without
+ * being compared further. The iterator is called once for each added,
+ * removed, or changed input, starting from the two roots, which are
+ * always aligned with each other.
+ *
+ * @param left_id the ID of the left root
+ * @param left_version the version of the left root, or CPL_VERSION_NONE
+ *                     for its latest version
+ * @param right_id the ID of the right root
+ * @param right_version the version of the right root, or CPL_VERSION_NONE
+ *                      for its latest version
+ * @param iterator the iterator to be called for each difference
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA if the lineages are identical, or an error
+ *         code
+ */
+EXPORT cpl_return_t
+cpl_diff_lineage(const cpl_id_t left_id,
+				 const cpl_version_t left_version,
+				 const cpl_id_t right_id,
+				 const cpl_version_t right_version,
+				 cpl_diff_iterator_t iterator,
+				 void* context);
+
+/**
+ * Compare the lineages of all version nodes created by two sessions. This
+ * works like cpl_diff_lineage(), except that the roots are the objects
+ * modified by each session, which are aligned the same way as the inputs.
+ *
+ * @param left the left session
+ * @param right the right session
+ * @param iterator the iterator to be called for each difference
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA if the lineages are identical, or an error
+ *         code
+ */
+EXPORT cpl_return_t
+cpl_diff_sessions(const cpl_session_t left,
+				  const cpl_session_t right,
+				  cpl_diff_iterator_t iterator,
+				  void* context);
+
+/**
+ * Run a path query over the provenance graph, such as:
+ *
+ *   MATCH (f:FILE {name:'/x'})<-[:DATA*1..5]-(p:PROCESS) RETURN p
+ *
+ * A query matches a single linear path of nodes, each of which can specify
+ * the object type, name, originator, and property values, connected by hops
+ * that point from the dependent object to its ancestor and can restrict the
+ * dependency type and the number of crossed dependencies. It returns the
+ * distinct objects bound to the returned variable, in the order of their
+ * IDs. The versions of an object are traversed for free.
+ *
+ * @param query the query text
+ * @param iterator the iterator to be called for each returned object
+ * @param context the caller-provided iterator context
+ * @return CPL_OK, CPL_S_NO_DATA if nothing matches, CPL_E_INVALID_QUERY,
+ *         or an error code
+ */
+EXPORT cpl_return_t
+cpl_query(const char* query,
+		  cpl_object_info_iterator_t iterator,
+		  void* context);
+
+
+/***************************************************************************/
+/** Reachability Index                                                    **/
+/***************************************************************************/
+
+/**
+ * Enable the in-memory reachability index, which answers the transitive
+ * cpl_is_ancestor() queries without traversing the graph in the database.
+ * The index is loaded from the given file if it exists, or built from a
+ * scan of the database otherwise, and it is then updated with all objects,
+ * versions, and dependencies created through this instance of the library.
+ * The file is rewritten by cpl_rebuild_reachability_index() and
+ * cpl_detach().
+ *
+ * The index does not observe the updates made by other processes. Each
+ * query first checks the latest version of the queried object and its
+ * immediate ancestors in the database, and it falls back to a traversal of
+ * the database if the index is not current for them, so a loaded file that
+ * is out of date or the updates made by other processes make the queries
+ * slower until the next cpl_rebuild_reachability_index().
+ *
+ * @param path the index file, or NULL to keep the index only in memory
+ * @return CPL_OK or an error code
+ */
+EXPORT cpl_return_t
+cpl_enable_reachability_index(const char* path);
+
+/**
+ * Rebuild the reachability index from a scan of the database, and write
+ * it to its file, if any. The new index is built separately while the old
+ * one keeps answering the queries, and it then replaces the old index
+ * together with the updates made in the meantime.
+ *
+ * @return CPL_OK or an error code
+ */
+EXPORT cpl_return_t
+cpl_rebuild_reachability_index(void);
+
+
+/***************************************************************************/
+/** Result Cache                                                          **/
+/***************************************************************************/
+
+/**
+ * Enable the in-memory cache of the results of cpl_get_object_ancestry()
+ * for the ancestors and of cpl_get_properties(). The results for versions
+ * older than the current version of the object never change and are kept
+ * until evicted; the other results are dropped when the object is thawed,
+ * gains a new version, or gains a new property.
+ *
+ * The updates made by other processes are observed only when they create
+ * a new version of the object, so properties added by another process to
+ * its current version might not be visible until then.
+ *
+ * @param max_bytes the maximum memory footprint of the cached results
+ * @return CPL_OK or an error code
+ */
+EXPORT cpl_return_t
+cpl_enable_result_cache(const size_t max_bytes);
+
+/**
+ * Disable the result cache and release its memory. The memory is released
+ * as soon as the queries that are using the cache in other threads finish.
+ *
+ * @return CPL_OK or an error code
+ */
+EXPORT cpl_return_t
+cpl_disable_result_cache(void);
+
+/**
+ * Get the statistics of the result cache.
+ *
+ * @param out_stats the pointer to store the statistics
+ * @return CPL_OK or an error code
+ */
+EXPORT cpl_return_t
+cpl_get_result_cache_stats(cpl_result_cache_stats_t* out_stats);
+
 
 /***************************************************************************/
 /** Utility functions                                                     **/
@@ -345,6 +345,75 @@ typedef struct cplxx_property_entry {
 } cplxx_property_entry_t;
 
 
+/**
+ * A row of the graph statistics, which is a C++ analogue of
+ * cpl_graph_statistic_t
+ */
+typedef struct cplxx_graph_statistic {
+
+	/// The kind of the statistic (one of the CPL_GS_* constants)
+	int kind;
+
+	/// The group key
+	long long key;
+
+	/// The object originator (CPL_GS_OBJECTS_PER_DAY only)
+	std::string originator;
+
+	/// The object type (CPL_GS_OBJECTS_PER_DAY only)
+	std::string type;
+
+	/// The number of edges, objects, or versions in the group
+	unsigned long long count;
+
+} cplxx_graph_statistic_t;
+
+
+/**
+ * A difference between two lineages, which is a C++ analogue of
+ * cpl_diff_entry_t
+ */
+typedef struct cplxx_diff_entry {
+
+	/// The kind of the difference (one of the CPL_DIFF_* kinds)
+	int kind;
+
+	/// What has changed (a logical combination of the CPL_DIFF_* changes)
+	int changes;
+
+	/// The dependency type of the input
+	int dependency_type;
+
+	/// The consumer in the left lineage
+	cpl_id_t left_consumer;
+
+	/// The consumer in the right lineage
+	cpl_id_t right_consumer;
+
+	/// The input in the left lineage
+	cpl_id_t left_id;
+
+	/// The latest version of the left input within its lineage
+	cpl_version_t left_version;
+
+	/// The input in the right lineage
+	cpl_id_t right_id;
+
+	/// The latest version of the right input within its lineage
+	cpl_version_t right_version;
+
+	/// The originator of the input
+	std::string originator;
+
+	/// The name of the input
+	std::string name;
+
+	/// The type of the input
+	std::string type;
+
+} cplxx_diff_entry_t;
+
+
 
 /***************************************************************************/
 /** Callbacks                                                             **/
@@ -474,6 +543,69 @@ cpl_cb_collect_property_lookup_vector(const cpl_id_t id,
 									  const char* value,
 									  void* context);
 
+/**
+ * The iterator callback for cpl_get_versions_in_range() and
+ * cpl_get_session_activity() that collects the returned information in
+ * an instance of std::vector<cpl_version_info_t>.
+ *
+ * @param info the version info
+ * @param context the pointer to an instance of the vector
+ * @return CPL_OK or an error code
+ */
+#ifdef SWIG
+%constant
+#endif
+EXPORT cpl_return_t
+cpl_cb_collect_version_info_vector(const cpl_version_info_t* info,
+								   void* context);
+
+/**
+ * The iterator callback for cpl_get_graph_statistics() that collects the
+ * returned information in an instance of
+ * std::vector<cplxx_graph_statistic_t>.
+ *
+ * @param stat the statistic
+ * @param context the pointer to an instance of the vector
+ * @return CPL_OK or an error code
+ */
+#ifdef SWIG
+%constant
+#endif
+EXPORT cpl_return_t
+cpl_cb_collect_graph_statistics_vector(const cpl_graph_statistic_t* stat,
+									   void* context);
+
+/**
+ * The iterator callback for cpl_diff_lineage() and cpl_diff_sessions() that
+ * collects the returned information in an instance of
+ * std::vector<cplxx_diff_entry_t>.
+ *
+ * @param entry the difference
+ * @param context the pointer to an instance of the vector
+ * @return CPL_OK or an error code
+ */
+#ifdef SWIG
+%constant
+#endif
+EXPORT cpl_return_t
+cpl_cb_collect_diff_vector(const cpl_diff_entry_t* entry,
+						   void* context);
+
+/**
+ * Fetch the next batch of objects from a cursor into an instance of
+ * std::vector<cplxx_object_info_t>, replacing its previous contents.
+ *
+ * @param cursor the cursor opened by cpl_open_object_cursor()
+ * @param max_count the maximum number of objects to fetch
+ * @param context the pointer to an instance of the vector
+ * @return CPL_OK, CPL_S_NO_DATA if there are no more objects, or an error
+ *         code
+ */
+EXPORT cpl_return_t
+cpl_cursor_fetch_object_info_vector(cpl_cursor_t* cursor,
+									const size_t max_count,
+									void* context);
+
 #endif /* __cplusplus */
 
 #endif /* __CPLXX_H__ */
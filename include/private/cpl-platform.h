@@ -36,7 +36,9 @@
 #define __CPL_PRIVATE_PLATFORM_H__
 
 #if !(defined _WIN32 || defined _WIN64)
+#include <errno.h>
 #include <pthread.h>
+#include <time.h>
 #endif
 
 
@@ -119,6 +121,213 @@ typedef pthread_mutex_t mutex_t;
 
 
 
+/***************************************************************************/
+/** Cross-Platform Compatibility: Condition Variable                      **/
+/***************************************************************************/
+
+#if defined _WIN32 || defined _WIN64
+
+/**
+ * Condition variable
+ */
+typedef CONDITION_VARIABLE cond_t;
+
+/**
+ * Initialize a condition variable
+ *
+ * @param c the condition variable
+ */
+#define cond_init(c) InitializeConditionVariable(&(c));
+
+/**
+ * Destroy a condition variable
+ *
+ * @param c the condition variable
+ */
+#define cond_destroy(c)
+
+/**
+ * Wait on a condition variable
+ *
+ * @param c the condition variable
+ * @param m the locked mutex
+ */
+#define cond_wait(c, m) SleepConditionVariableCS(&(c), &(m), INFINITE);
+
+/**
+ * Wait on a condition variable for at most the given time
+ *
+ * @param c the condition variable
+ * @param m the locked mutex
+ * @param ms the maximum time to wait in milliseconds
+ * @return true if woken up, or false if the time ran out
+ */
+#define cond_timedwait(c, m, ms) \
+	(SleepConditionVariableCS(&(c), &(m), (DWORD) (ms)) != 0)
+
+/**
+ * Wake up all threads waiting on a condition variable
+ *
+ * @param c the condition variable
+ */
+#define cond_broadcast(c) WakeAllConditionVariable(&(c));
+
+#else
+
+/**
+ * Condition variable
+ */
+typedef pthread_cond_t cond_t;
+
+/**
+ * Initialize a condition variable
+ *
+ * @param c the condition variable
+ */
+#define cond_init(c) pthread_cond_init(&(c), NULL);
+
+/**
+ * Destroy a condition variable
+ *
+ * @param c the condition variable
+ */
+#define cond_destroy(c) pthread_cond_destroy(&(c));
+
+/**
+ * Wait on a condition variable
+ *
+ * @param c the condition variable
+ * @param m the locked mutex
+ */
+#define cond_wait(c, m) pthread_cond_wait(&(c), &(m));
+
+/**
+ * Wait on a condition variable for at most the given time
+ *
+ * @param c the condition variable
+ * @param m the locked mutex
+ * @param ms the maximum time to wait in milliseconds
+ * @return true if woken up, or false if the time ran out
+ */
+static inline bool
+pthread_cond_timedwait_ms(pthread_cond_t* c, pthread_mutex_t* m,
+						  unsigned long ms)
+{
+	struct timespec deadline;
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += ms / 1000;
+	deadline.tv_nsec += (long) (ms % 1000) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+	return pthread_cond_timedwait(c, m, &deadline) != ETIMEDOUT;
+}
+
+/**
+ * Wait on a condition variable for at most the given time
+ *
+ * @param c the condition variable
+ * @param m the locked mutex
+ * @param ms the maximum time to wait in milliseconds
+ * @return true if woken up, or false if the time ran out
+ */
+#define cond_timedwait(c, m, ms) pthread_cond_timedwait_ms(&(c), &(m), (ms))
+
+/**
+ * Wake up all threads waiting on a condition variable
+ *
+ * @param c the condition variable
+ */
+#define cond_broadcast(c) pthread_cond_broadcast(&(c));
+
+#endif
+
+
+
+/***************************************************************************/
+/** Cross-Platform Compatibility: Thread                                  **/
+/***************************************************************************/
+
+#if defined _WIN32 || defined _WIN64
+
+/**
+ * Thread
+ */
+typedef HANDLE thread_t;
+
+/**
+ * Declare a thread function
+ *
+ * @param f the function name
+ * @param a the name of the argument
+ */
+#define THREAD_FUNCTION(f, a) DWORD WINAPI f(LPVOID a)
+
+/**
+ * Return from a thread function
+ */
+#define THREAD_RETURN return 0
+
+/**
+ * Start a thread
+ *
+ * @param t the thread
+ * @param f the thread function
+ * @param a the argument
+ * @return true on success
+ */
+#define thread_create(t, f, a) \
+	(((t) = CreateThread(NULL, 0, (f), (a), 0, NULL)) != NULL)
+
+/**
+ * Wait for a thread to finish
+ *
+ * @param t the thread
+ */
+#define thread_join(t) { WaitForSingleObject((t), INFINITE); CloseHandle(t); }
+
+#else
+
+/**
+ * Thread
+ */
+typedef pthread_t thread_t;
+
+/**
+ * Declare a thread function
+ *
+ * @param f the function name
+ * @param a the name of the argument
+ */
+#define THREAD_FUNCTION(f, a) void* f(void* a)
+
+/**
+ * Return from a thread function
+ */
+#define THREAD_RETURN return NULL
+
+/**
+ * Start a thread
+ *
+ * @param t the thread
+ * @param f the thread function
+ * @param a the argument
+ * @return true on success
+ */
+#define thread_create(t, f, a) (pthread_create(&(t), NULL, (f), (a)) == 0)
+
+/**
+ * Wait for a thread to finish
+ *
+ * @param t the thread
+ */
+#define thread_join(t) pthread_join((t), NULL);
+
+#endif
+
+
+
 /***************************************************************************/
 /** Helpers: Mutex                                                        **/
 /***************************************************************************/
@@ -45,7 +45,7 @@ USE cpl;
 SET FOREIGN_KEY_CHECKS = 0;
 
 DROP TABLE IF EXISTS cpl_objects, cpl_sessions, cpl_versions, cpl_ancestry,
-                     cpl_properties;
+                     cpl_properties, cpl_ancestry_closure, cpl_latest_versions;
 
 SET FOREIGN_KEY_CHECKS = 1;
 
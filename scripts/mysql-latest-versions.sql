@@ -0,0 +1,88 @@
+--
+-- mysql-latest-versions.sql
+-- Core Provenance Library
+--
+-- Copyright 2011
+--      The President and Fellows of Harvard College.
+--
+-- Redistribution and use in source and binary forms, with or without
+-- modification, are permitted provided that the following conditions
+-- are met:
+-- 1. Redistributions of source code must retain the above copyright
+--    notice, this list of conditions and the following disclaimer.
+-- 2. Redistributions in binary form must reproduce the above copyright
+--    notice, this list of conditions and the following disclaimer in the
+--    documentation and/or other materials provided with the distribution.
+-- 3. Neither the name of the University nor the names of its contributors
+--    may be used to endorse or promote products derived from this software
+--    without specific prior written permission.
+--
+-- THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+-- ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+-- IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+-- ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+-- FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+-- DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+-- OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+-- HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+-- LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+-- OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+-- SUCH DAMAGE.
+--
+-- Contributor(s): Peter Macko
+--
+
+
+-- ------------------------------------------------------------------------ --
+-- Instructions                                                             --
+-- ------------------------------------------------------------------------ --
+--
+-- Execute this script as the MySQL root to add the table of the latest
+-- object versions to a database created by an older version of the setup
+-- script. The table is maintained by a trigger on cpl_versions; please
+-- reconnect all running applications so that they start using it.
+--
+-- Usage on Linux:
+--    mysql -u root -p < scripts/mysql-latest-versions.sql
+--
+
+
+-- ------------------------------------------------------------------------ --
+-- Add the MySQL Latest Versions                                            --
+-- ------------------------------------------------------------------------ --
+
+USE cpl;
+
+
+--
+-- Create the table and the trigger that maintains it
+--
+
+CREATE TABLE IF NOT EXISTS cpl_latest_versions (
+       id_hi BIGINT NOT NULL,
+       id_lo BIGINT NOT NULL,
+       version INT NOT NULL,
+       PRIMARY KEY(id_hi, id_lo),
+       FOREIGN KEY(id_hi, id_lo, version)
+                   REFERENCES cpl_versions(id_hi, id_lo, version));
+
+DROP TRIGGER IF EXISTS cpl_versions_latest;
+
+CREATE TRIGGER cpl_versions_latest AFTER INSERT ON cpl_versions
+       FOR EACH ROW
+       INSERT INTO cpl_latest_versions (id_hi, id_lo, version)
+            VALUES (NEW.id_hi, NEW.id_lo, NEW.version)
+       ON DUPLICATE KEY UPDATE version = GREATEST(version, NEW.version);
+
+
+--
+-- Populate the table from the existing versions. The trigger is already in
+-- place, so the versions created in the meantime are not lost.
+--
+
+INSERT INTO cpl_latest_versions (id_hi, id_lo, version)
+SELECT * FROM (SELECT id_hi, id_lo, MAX(version) AS max_version
+                 FROM cpl_versions
+                GROUP BY id_hi, id_lo) AS m
+    ON DUPLICATE KEY UPDATE
+       version = GREATEST(cpl_latest_versions.version, m.max_version);
@@ -77,6 +77,10 @@ CREATE TABLE IF NOT EXISTS cpl_objects (
        container_id_lo BIGINT,
        container_ver INT,
        PRIMARY KEY (id_hi, id_lo),
+       INDEX cpl_objects_type_originator (type, originator),
+       INDEX cpl_objects_container (container_id_hi, container_id_lo,
+                                    container_ver),
+       INDEX cpl_objects_name (name),
        FOREIGN KEY (container_id_hi, container_id_lo, container_ver)
                     REFERENCES cpl_versions(id_hi, id_lo, version));
 
@@ -99,6 +103,8 @@ CREATE TABLE IF NOT EXISTS cpl_versions (
        session_id_hi BIGINT,
        session_id_lo BIGINT,
        PRIMARY KEY(id_hi, id_lo, version),
+       INDEX cpl_versions_creation_time (creation_time),
+       INDEX cpl_versions_session (session_id_hi, session_id_lo),
        FOREIGN KEY(id_hi, id_lo) REFERENCES cpl_objects(id_hi, id_lo),
        FOREIGN KEY(session_id_hi, session_id_lo)
                    REFERENCES cpl_sessions(id_hi, id_lo));
@@ -125,8 +131,54 @@ CREATE TABLE IF NOT EXISTS cpl_properties (
        name VARCHAR(255) NOT NULL,
        value VARCHAR(4095) NOT NULL,
 	   PRIMARY KEY(id_hi, id_lo, version, name),
+       INDEX cpl_properties_name_value (name, value(255)),
        FOREIGN KEY(id_hi, id_lo, version)
            REFERENCES cpl_versions(id_hi, id_lo, version));
 
+--
+-- The optional ancestry closure, which contains all pairs of version nodes
+-- connected by a path in the provenance graph (including the paths through
+-- the consecutive versions of an object), so that the transitive ancestry
+-- queries become single index lookups. Omit this table to save space; it
+-- can be added or rebuilt later using scripts/mysql-closure.sql.
+--
+
+CREATE TABLE IF NOT EXISTS cpl_ancestry_closure (
+       from_id_hi BIGINT NOT NULL,
+       from_id_lo BIGINT NOT NULL,
+       from_version INT NOT NULL,
+       to_id_hi BIGINT NOT NULL,
+       to_id_lo BIGINT NOT NULL,
+       to_version INT NOT NULL,
+       PRIMARY KEY(from_id_hi, from_id_lo, from_version,
+                   to_id_hi, to_id_lo, to_version),
+       INDEX cpl_ancestry_closure_to (to_id_hi, to_id_lo, to_version),
+       FOREIGN KEY(from_id_hi, from_id_lo, from_version)
+                   REFERENCES cpl_versions(id_hi, id_lo, version),
+       FOREIGN KEY(to_id_hi, to_id_lo, to_version)
+                   REFERENCES cpl_versions(id_hi, id_lo, version));
+
+--
+-- The latest version of each object, which is maintained by a trigger on
+-- cpl_versions within the same statement that inserts the new version, so
+-- that looking up the current version of an object is a primary key read.
+--
+
+CREATE TABLE IF NOT EXISTS cpl_latest_versions (
+       id_hi BIGINT NOT NULL,
+       id_lo BIGINT NOT NULL,
+       version INT NOT NULL,
+       PRIMARY KEY(id_hi, id_lo),
+       FOREIGN KEY(id_hi, id_lo, version)
+                   REFERENCES cpl_versions(id_hi, id_lo, version));
+
+DROP TRIGGER IF EXISTS cpl_versions_latest;
+
+CREATE TRIGGER cpl_versions_latest AFTER INSERT ON cpl_versions
+       FOR EACH ROW
+       INSERT INTO cpl_latest_versions (id_hi, id_lo, version)
+            VALUES (NEW.id_hi, NEW.id_lo, NEW.version)
+       ON DUPLICATE KEY UPDATE version = GREATEST(version, NEW.version);
+
 SET FOREIGN_KEY_CHECKS = 1;
 
@@ -0,0 +1,113 @@
+--
+-- postgresql-closure.sql
+-- Core Provenance Library
+--
+-- Copyright 2011
+--      The President and Fellows of Harvard College.
+--
+-- Redistribution and use in source and binary forms, with or without
+-- modification, are permitted provided that the following conditions
+-- are met:
+-- 1. Redistributions of source code must retain the above copyright
+--    notice, this list of conditions and the following disclaimer.
+-- 2. Redistributions in binary form must reproduce the above copyright
+--    notice, this list of conditions and the following disclaimer in the
+--    documentation and/or other materials provided with the distribution.
+-- 3. Neither the name of the University nor the names of its contributors
+--    may be used to endorse or promote products derived from this software
+--    without specific prior written permission.
+--
+-- THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+-- ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+-- IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+-- ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+-- FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+-- DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+-- OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+-- HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+-- LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+-- OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+-- SUCH DAMAGE.
+--
+-- Contributor(s): Peter Macko
+--
+
+
+-- ------------------------------------------------------------------------ --
+-- Instructions                                                             --
+-- ------------------------------------------------------------------------ --
+--
+-- Execute this script as the user postgres to add the optional ancestry
+-- closure to an existing database, or to rebuild it. The closure is then
+-- maintained by the ODBC backend; please reconnect all running applications
+-- so that they start using it. The script requires PostgreSQL 9.5 or newer.
+--
+-- Usage on Linux:
+--   sudo -u postgres psql postgres < scripts/postgresql-closure.sql
+--
+
+
+-- ------------------------------------------------------------------------ --
+-- Build the PostgreSQL Ancestry Closure                                    --
+-- ------------------------------------------------------------------------ --
+
+\connect cpl
+
+
+--
+-- Create the table
+--
+
+CREATE TABLE IF NOT EXISTS cpl_ancestry_closure (
+       from_id_hi BIGINT NOT NULL,
+       from_id_lo BIGINT NOT NULL,
+       from_version INT NOT NULL,
+       to_id_hi BIGINT NOT NULL,
+       to_id_lo BIGINT NOT NULL,
+       to_version INT NOT NULL,
+       PRIMARY KEY(from_id_hi, from_id_lo, from_version,
+                   to_id_hi, to_id_lo, to_version),
+       FOREIGN KEY(from_id_hi, from_id_lo, from_version)
+                   REFERENCES cpl_versions(id_hi, id_lo, version),
+       FOREIGN KEY(to_id_hi, to_id_lo, to_version)
+                   REFERENCES cpl_versions(id_hi, id_lo, version));
+
+CREATE INDEX IF NOT EXISTS cpl_ancestry_closure_to
+       ON cpl_ancestry_closure(to_id_hi, to_id_lo, to_version);
+
+GRANT ALL PRIVILEGES ON TABLE cpl_ancestry_closure TO cpl WITH GRANT OPTION;
+
+
+--
+-- Compute the closure of the ancestry edges and of the edges between
+-- the consecutive versions of each object
+--
+
+BEGIN;
+LOCK TABLE cpl_ancestry, cpl_versions IN SHARE MODE;
+DELETE FROM cpl_ancestry_closure;
+
+INSERT INTO cpl_ancestry_closure
+       (from_id_hi, from_id_lo, from_version, to_id_hi, to_id_lo, to_version)
+WITH RECURSIVE
+     edges (from_id_hi, from_id_lo, from_version,
+            to_id_hi, to_id_lo, to_version) AS (
+       SELECT from_id_hi, from_id_lo, from_version,
+              to_id_hi, to_id_lo, to_version
+         FROM cpl_ancestry
+        UNION
+       SELECT id_hi, id_lo, version, id_hi, id_lo, version - 1
+         FROM cpl_versions
+        WHERE version > 0),
+     closure (from_id_hi, from_id_lo, from_version,
+              to_id_hi, to_id_lo, to_version) AS (
+       SELECT * FROM edges
+        UNION
+       SELECT c.from_id_hi, c.from_id_lo, c.from_version,
+              e.to_id_hi, e.to_id_lo, e.to_version
+         FROM closure c, edges e
+        WHERE c.to_id_hi = e.from_id_hi AND c.to_id_lo = e.from_id_lo
+          AND c.to_version = e.from_version)
+SELECT * FROM closure;
+
+COMMIT;
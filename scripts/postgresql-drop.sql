@@ -40,5 +40,6 @@
 \connect cpl
 ALTER TABLE cpl_objects DROP CONSTRAINT IF EXISTS cpl_objects_fk;
 DROP TABLE IF EXISTS cpl_objects, cpl_sessions, cpl_versions, cpl_ancestry,
-                     cpl_properties;
+                     cpl_properties, cpl_ancestry_closure, cpl_latest_versions;
+DROP FUNCTION IF EXISTS cpl_update_latest_version();
 
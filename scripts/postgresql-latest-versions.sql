@@ -0,0 +1,99 @@
+--
+-- postgresql-latest-versions.sql
+-- Core Provenance Library
+--
+-- Copyright 2011
+--      The President and Fellows of Harvard College.
+--
+-- Redistribution and use in source and binary forms, with or without
+-- modification, are permitted provided that the following conditions
+-- are met:
+-- 1. Redistributions of source code must retain the above copyright
+--    notice, this list of conditions and the following disclaimer.
+-- 2. Redistributions in binary form must reproduce the above copyright
+--    notice, this list of conditions and the following disclaimer in the
+--    documentation and/or other materials provided with the distribution.
+-- 3. Neither the name of the University nor the names of its contributors
+--    may be used to endorse or promote products derived from this software
+--    without specific prior written permission.
+--
+-- THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+-- ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+-- IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+-- ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+-- FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+-- DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+-- OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+-- HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+-- LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+-- OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+-- SUCH DAMAGE.
+--
+-- Contributor(s): Peter Macko
+--
+
+
+-- ------------------------------------------------------------------------ --
+-- Instructions                                                             --
+-- ------------------------------------------------------------------------ --
+--
+-- Execute this script as the user postgres to add the table of the latest
+-- object versions to a database created by an older version of the setup
+-- script. The table is maintained by a trigger on cpl_versions; please
+-- reconnect all running applications so that they start using it. The
+-- script requires PostgreSQL 9.5 or newer.
+--
+-- Usage on Linux:
+--   sudo -u postgres psql postgres < scripts/postgresql-latest-versions.sql
+--
+
+
+-- ------------------------------------------------------------------------ --
+-- Add the PostgreSQL Latest Versions                                       --
+-- ------------------------------------------------------------------------ --
+
+\connect cpl
+
+
+--
+-- Create the table and the trigger that maintains it
+--
+
+CREATE TABLE IF NOT EXISTS cpl_latest_versions (
+       id_hi BIGINT NOT NULL,
+       id_lo BIGINT NOT NULL,
+       version INT NOT NULL,
+       PRIMARY KEY(id_hi, id_lo),
+       FOREIGN KEY(id_hi, id_lo, version)
+                   REFERENCES cpl_versions(id_hi, id_lo, version));
+
+GRANT ALL PRIVILEGES ON TABLE cpl_latest_versions TO cpl WITH GRANT OPTION;
+
+CREATE OR REPLACE FUNCTION cpl_update_latest_version() RETURNS TRIGGER AS $$
+BEGIN
+       INSERT INTO cpl_latest_versions (id_hi, id_lo, version)
+            VALUES (NEW.id_hi, NEW.id_lo, NEW.version)
+       ON CONFLICT (id_hi, id_lo) DO UPDATE
+               SET version = GREATEST(cpl_latest_versions.version,
+                                      EXCLUDED.version);
+       RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+DROP TRIGGER IF EXISTS cpl_versions_latest ON cpl_versions;
+
+CREATE TRIGGER cpl_versions_latest AFTER INSERT ON cpl_versions
+       FOR EACH ROW EXECUTE PROCEDURE cpl_update_latest_version();
+
+
+--
+-- Populate the table from the existing versions. The trigger is already in
+-- place, so the versions created in the meantime are not lost.
+--
+
+INSERT INTO cpl_latest_versions (id_hi, id_lo, version)
+SELECT id_hi, id_lo, MAX(version)
+  FROM cpl_versions
+ GROUP BY id_hi, id_lo
+    ON CONFLICT (id_hi, id_lo) DO UPDATE
+       SET version = GREATEST(cpl_latest_versions.version, EXCLUDED.version);
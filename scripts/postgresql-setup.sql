@@ -37,7 +37,8 @@
 -- Instructions                                                             --
 -- ------------------------------------------------------------------------ --
 --
--- Execute this script as the user postgres.
+-- Execute this script as the user postgres. The script requires PostgreSQL
+-- 9.5 or newer.
 --
 -- Usage on Linux:
 --   sudo -u postgres psql postgres < scripts/postgresql-setup.sql
@@ -75,6 +76,13 @@ CREATE TABLE IF NOT EXISTS cpl_objects (
        container_ver INT,
        PRIMARY KEY (id_hi, id_lo));
 
+CREATE INDEX cpl_objects_type_originator
+       ON cpl_objects(type, originator);
+CREATE INDEX cpl_objects_container
+       ON cpl_objects(container_id_hi, container_id_lo, container_ver);
+CREATE INDEX cpl_objects_name
+       ON cpl_objects(name text_pattern_ops);
+
 CREATE TABLE IF NOT EXISTS cpl_sessions (
        id_hi BIGINT,
        id_lo BIGINT,
@@ -98,6 +106,11 @@ CREATE TABLE IF NOT EXISTS cpl_versions (
        FOREIGN KEY(session_id_hi, session_id_lo)
                    REFERENCES cpl_sessions(id_hi, id_lo));
 
+CREATE INDEX cpl_versions_creation_time
+       ON cpl_versions(creation_time);
+CREATE INDEX cpl_versions_session
+       ON cpl_versions(session_id_hi, session_id_lo);
+
 CREATE TABLE IF NOT EXISTS cpl_ancestry (
        from_id_hi BIGINT NOT NULL,
        from_id_lo BIGINT NOT NULL,
@@ -122,6 +135,64 @@ CREATE TABLE IF NOT EXISTS cpl_properties (
        FOREIGN KEY(id_hi, id_lo, version)
            REFERENCES cpl_versions(id_hi, id_lo, version));
 
+CREATE INDEX cpl_properties_name_value
+       ON cpl_properties(name, left(value, 255) text_pattern_ops);
+
+--
+-- The optional ancestry closure, which contains all pairs of version nodes
+-- connected by a path in the provenance graph (including the paths through
+-- the consecutive versions of an object), so that the transitive ancestry
+-- queries become single index lookups. Omit this table to save space; it
+-- can be added or rebuilt later using scripts/postgresql-closure.sql.
+--
+
+CREATE TABLE IF NOT EXISTS cpl_ancestry_closure (
+       from_id_hi BIGINT NOT NULL,
+       from_id_lo BIGINT NOT NULL,
+       from_version INT NOT NULL,
+       to_id_hi BIGINT NOT NULL,
+       to_id_lo BIGINT NOT NULL,
+       to_version INT NOT NULL,
+       PRIMARY KEY(from_id_hi, from_id_lo, from_version,
+                   to_id_hi, to_id_lo, to_version),
+       FOREIGN KEY(from_id_hi, from_id_lo, from_version)
+                   REFERENCES cpl_versions(id_hi, id_lo, version),
+       FOREIGN KEY(to_id_hi, to_id_lo, to_version)
+                   REFERENCES cpl_versions(id_hi, id_lo, version));
+
+CREATE INDEX cpl_ancestry_closure_to
+       ON cpl_ancestry_closure(to_id_hi, to_id_lo, to_version);
+
+--
+-- The latest version of each object, which is maintained by a trigger on
+-- cpl_versions within the same statement that inserts the new version, so
+-- that looking up the current version of an object is a primary key read.
+--
+
+CREATE TABLE IF NOT EXISTS cpl_latest_versions (
+       id_hi BIGINT NOT NULL,
+       id_lo BIGINT NOT NULL,
+       version INT NOT NULL,
+       PRIMARY KEY(id_hi, id_lo),
+       FOREIGN KEY(id_hi, id_lo, version)
+                   REFERENCES cpl_versions(id_hi, id_lo, version));
+
+CREATE OR REPLACE FUNCTION cpl_update_latest_version() RETURNS TRIGGER AS $$
+BEGIN
+       INSERT INTO cpl_latest_versions (id_hi, id_lo, version)
+            VALUES (NEW.id_hi, NEW.id_lo, NEW.version)
+       ON CONFLICT (id_hi, id_lo) DO UPDATE
+               SET version = GREATEST(cpl_latest_versions.version,
+                                      EXCLUDED.version);
+       RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+DROP TRIGGER IF EXISTS cpl_versions_latest ON cpl_versions;
+
+CREATE TRIGGER cpl_versions_latest AFTER INSERT ON cpl_versions
+       FOR EACH ROW EXECUTE PROCEDURE cpl_update_latest_version();
+
 ALTER TABLE cpl_objects ADD CONSTRAINT cpl_objects_fk
       FOREIGN KEY (container_id_hi, container_id_lo, container_ver)
       REFERENCES cpl_versions(id_hi, id_lo, version);
@@ -136,4 +207,6 @@ GRANT ALL PRIVILEGES ON TABLE cpl_sessions TO cpl WITH GRANT OPTION;
 GRANT ALL PRIVILEGES ON TABLE cpl_versions TO cpl WITH GRANT OPTION;
 GRANT ALL PRIVILEGES ON TABLE cpl_ancestry TO cpl WITH GRANT OPTION;
 GRANT ALL PRIVILEGES ON TABLE cpl_properties TO cpl WITH GRANT OPTION;
+GRANT ALL PRIVILEGES ON TABLE cpl_ancestry_closure TO cpl WITH GRANT OPTION;
+GRANT ALL PRIVILEGES ON TABLE cpl_latest_versions TO cpl WITH GRANT OPTION;
 
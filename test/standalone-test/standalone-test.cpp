@@ -78,6 +78,10 @@ static struct test_info TESTS[] =
 {
 	{"Simple",       "The Simplest Test",                test_simple       },
 	{"Mini-Stress",  "The Mini Stress Test",             test_mini_stress  },
+	{"Lineage",      "Parallel Lineage Benchmark",       test_lineage      },
+	{"RDF-Parse",    "SPARQL Result Parsing Benchmark",  test_rdf_parse    },
+	{"RDF-Server",   "SPARQL Connection Pool Benchmark", test_rdf_server   },
+	{"RDF-Template", "SPARQL Template Benchmark",        test_rdf_template },
 	{0, 0, 0}
 };
 
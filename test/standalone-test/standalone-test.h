@@ -75,6 +75,15 @@ struct test_info
 }
 
 
+/**
+ * Get the current system time in seconds
+ *
+ * @return the current time in seconds
+ */
+double
+current_time_seconds(void);
+
+
 /***************************************************************************/
 /** Tests (in their respective .cpp files)                                **/
 /***************************************************************************/
@@ -91,6 +100,31 @@ test_simple(void);
 void
 test_mini_stress(void);
 
+/**
+ * The speedup benchmark for the parallel lineage traversal
+ */
+void
+test_lineage(void);
+
+/**
+ * The parse throughput benchmark for the SPARQL result formats
+ */
+void
+test_rdf_parse(void);
+
+/**
+ * The concurrent query throughput benchmark for the RDF connection layer,
+ * using a local stub SPARQL server
+ */
+void
+test_rdf_server(void);
+
+/**
+ * The CPU cost benchmark for building SPARQL statements
+ */
+void
+test_rdf_template(void);
+
 
 #endif
 
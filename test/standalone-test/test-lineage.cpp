@@ -0,0 +1,176 @@
+/*
+ * test-lineage.cpp
+ * Core Provenance Library
+ *
+ * Copyright 2011
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#include "stdafx.h"
+#include "standalone-test.h"
+
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * The number of objects derived directly from the root
+ */
+#define LINEAGE_WIDTH			64
+
+/**
+ * The number of objects derived from each object in the first level
+ */
+#define LINEAGE_FANOUT			8
+
+/**
+ * The maximum number of threads
+ */
+#define LINEAGE_MAX_THREADS		16
+
+
+/**
+ * The iterator callback that counts the edges
+ *
+ * @param query_object_id the ID of the object on which we are querying
+ * @param query_object_verson the version of the queried object
+ * @param other_object_id the ID of the object on the other end of the
+ *                        dependency/ancestry edge
+ * @param other_object_version the version of the other object
+ * @param type the type of the data or the control dependency
+ * @param context the pointer to the counter (size_t)
+ * @return CPL_OK
+ */
+static cpl_return_t
+cb_count_edges(const cpl_id_t query_object_id,
+			   const cpl_version_t query_object_version,
+			   const cpl_id_t other_object_id,
+			   const cpl_version_t other_object_version,
+			   const int type,
+			   void* context)
+{
+	(*((size_t*) context))++;
+	return CPL_OK;
+}
+
+
+/**
+ * Create a new object
+ *
+ * @param name the object name
+ * @param index the object number
+ * @return the object ID
+ */
+static cpl_id_t
+create_object(const char* name, size_t index)
+{
+	char s[64];
+#ifdef _WINDOWS
+	sprintf_s(s, sizeof(s),
+#else
+	snprintf(s, sizeof(s),
+#endif
+			"%s-%lu", name, (unsigned long) index);
+
+	cpl_id_t id;
+	cpl_return_t ret = cpl_create_object(ORIGINATOR, s, "Benchmark",
+			CPL_NONE, &id);
+	CPL_VERIFY(cpl_create_object, ret);
+
+	return id;
+}
+
+
+/**
+ * The benchmark for the parallel lineage traversal, which measures the
+ * speedup against the number of threads on a wide two-level graph
+ */
+void
+test_lineage(void)
+{
+	cpl_return_t ret;
+
+
+	// Create a graph with a root, LINEAGE_WIDTH derived objects, and
+	// LINEAGE_FANOUT objects derived from each of them
+
+	print(L_DEBUG, "Creating %d objects...",
+			1 + LINEAGE_WIDTH * (1 + LINEAGE_FANOUT));
+
+	cpl_id_t root = create_object("Lineage Root", 0);
+
+	for (size_t i = 0; i < LINEAGE_WIDTH; i++) {
+		cpl_id_t a = create_object("Lineage A", i);
+		ret = cpl_data_flow(a, root, CPL_DATA_INPUT);
+		CPL_VERIFY(cpl_data_flow, ret);
+
+		for (size_t j = 0; j < LINEAGE_FANOUT; j++) {
+			cpl_id_t b = create_object("Lineage B", i * LINEAGE_FANOUT + j);
+			ret = cpl_data_flow(b, a, CPL_DATA_INPUT);
+			CPL_VERIFY(cpl_data_flow, ret);
+		}
+	}
+
+
+	// The baseline: the level-batched sequential traversal
+
+	size_t expected = 0;
+	double start_time = current_time_seconds();
+	ret = cpl_get_object_lineage(root, 0, CPL_D_DESCENDANTS, 0, 0,
+			cb_count_edges, &expected);
+	CPL_VERIFY(cpl_get_object_lineage, ret);
+	double base = current_time_seconds() - start_time;
+	if (base <= 0) base = 1e-9;
+
+	print(L_DEBUG, "  sequential  %8.3lf s  %6lu edges", base,
+			(unsigned long) expected);
+
+
+	// Measure the speedup as the number of threads grows
+
+	for (int n = 1; n <= LINEAGE_MAX_THREADS; n *= 2) {
+		size_t count = 0;
+		start_time = current_time_seconds();
+		ret = cpl_get_object_lineage_parallel(root, 0, CPL_D_DESCENDANTS,
+				0, 0, n, cb_count_edges, &count);
+		CPL_VERIFY(cpl_get_object_lineage_parallel, ret);
+		double t = current_time_seconds() - start_time;
+		if (t <= 0) t = 1e-9;
+
+		print(L_DEBUG, "  %2d thread%s  %8.3lf s  %6lu edges  %5.2lfx", n,
+				n == 1 ? " " : "s", t, (unsigned long) count, base / t);
+
+		if (count != expected) {
+			throw CPLException("The parallel traversal returned %lu edges "
+					"instead of %lu", (unsigned long) count,
+					(unsigned long) expected);
+		}
+	}
+}
@@ -0,0 +1,259 @@
+/*
+ * test-rdf-parse.cpp
+ * Core Provenance Library
+ *
+ * Copyright 2011
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#include "stdafx.h"
+#include "standalone-test.h"
+
+#ifndef _WINDOWS
+#include <backends/cpl-rdf.h>
+#include "../../backends/cpl-rdf/cpl-connection.h"
+#endif
+
+#include <string>
+
+using namespace std;
+
+
+/**
+ * The number of rows in the recorded responses
+ */
+#define RDF_PARSE_NUM_ROWS		20000
+
+/**
+ * The number of times to parse each response
+ */
+#define RDF_PARSE_ITERATIONS	10
+
+
+/**
+ * The URI of the XSD integer datatype
+ */
+#define XSD_INTEGER		"http://www.w3.org/2001/XMLSchema#integer"
+
+
+/**
+ * Create a response to an ancestry query with the given number of rows,
+ * in the same shape as returned by 4store
+ *
+ * @param format the result format (CPL_RDF_RESULTS_XML or _JSON)
+ * @param num_rows the number of rows
+ * @return the response body
+ */
+#ifndef _WINDOWS
+static string
+create_ancestry_response(int format, size_t num_rows)
+{
+	string s;
+	char buf[512];
+
+	if (format == CPL_RDF_RESULTS_JSON) {
+		s += "{\"head\":{\"vars\":[\"edge\",\"other\",\"node\"]},\n";
+		s += " \"results\":{\"bindings\":[\n";
+	}
+	else {
+		s += "<?xml version=\"1.0\"?>\n";
+		s += "<sparql xmlns=\"http://www.w3.org/2005/sparql-results#\">\n";
+		s += " <head>\n  <variable name=\"edge\"/>\n";
+		s += "  <variable name=\"other\"/>\n  <variable name=\"node\"/>\n";
+		s += " </head>\n <results>\n";
+	}
+
+	for (size_t i = 0; i < num_rows; i++) {
+		unsigned long long hi = 0x1000 + i * 7;
+		unsigned long long lo = 0xabcdef00ULL + i * 13;
+		int type = (int) (i % 3);
+
+		if (format == CPL_RDF_RESULTS_JSON) {
+			snprintf(buf, sizeof(buf), "%s{"
+					"\"edge\":{\"type\":\"uri\",\"value\":\"input:%x\"},"
+					"\"other\":{\"type\":\"uri\",\"value\":\"node:%llx-%llx-%x\"},"
+					"\"node\":{\"type\":\"uri\",\"value\":\"node:%llx-%llx-%x\"},"
+					"\"t\":{\"type\":\"typed-literal\","
+					"\"datatype\":\"" XSD_INTEGER "\",\"value\":\"%lu\"}}\n",
+					i == 0 ? "" : ",", type, hi, lo, type,
+					lo, hi, (int) (i % 5), (unsigned long) (1300000000 + i));
+		}
+		else {
+			snprintf(buf, sizeof(buf), "  <result>\n"
+					"   <binding name=\"edge\"><uri>input:%x</uri></binding>\n"
+					"   <binding name=\"other\"><uri>node:%llx-%llx-%x</uri>"
+					"</binding>\n"
+					"   <binding name=\"node\"><uri>node:%llx-%llx-%x</uri>"
+					"</binding>\n"
+					"   <binding name=\"t\"><literal datatype=\"" XSD_INTEGER
+					"\">%lu</literal></binding>\n"
+					"  </result>\n",
+					type, hi, lo, type,
+					lo, hi, (int) (i % 5), (unsigned long) (1300000000 + i));
+		}
+		s += buf;
+	}
+
+	if (format == CPL_RDF_RESULTS_JSON) {
+		s += "]}}\n";
+	}
+	else {
+		s += " </results>\n</sparql>\n";
+	}
+
+	return s;
+}
+
+
+/**
+ * Measure the parse throughput of the given response
+ *
+ * @param name the name of the format
+ * @param format the result format (CPL_RDF_RESULTS_XML or _JSON)
+ * @param response the response body
+ * @param num_rows the expected number of rows
+ * @return the time in seconds needed to parse the response once
+ */
+static double
+benchmark_rdf_parse(const char* name, int format, const string& response,
+		size_t num_rows)
+{
+	cpl_return_t ret;
+	size_t n = 0;
+
+	double start_time = current_time_seconds();
+
+	for (int i = 0; i < RDF_PARSE_ITERATIONS; i++) {
+		ret = cpl_rdf_parse_recorded_response(response.c_str(),
+				response.length(), format, &n);
+		CPL_VERIFY(cpl_rdf_parse_recorded_response, ret);
+		if (n != num_rows) {
+			throw CPLException("The %s parser returned %lu rows instead of "
+					"%lu", name, (unsigned long) n, (unsigned long) num_rows);
+		}
+	}
+
+	double t = (current_time_seconds() - start_time) / RDF_PARSE_ITERATIONS;
+	if (t <= 0) t = 1e-9;
+
+	print(L_DEBUG, "  %-4s %8.2lf KB  %8.3lf ms  %8.2lf MB/s  %10.0lf rows/s",
+			name, response.length() / 1024.0, t * 1000.0,
+			response.length() / (1024.0 * 1024.0) / t, num_rows / t);
+
+	return t;
+}
+#endif
+
+
+/**
+ * The parse throughput benchmark for the SPARQL result formats
+ */
+void
+test_rdf_parse(void)
+{
+#ifdef _WINDOWS
+	print(L_DEBUG, "The RDF backend is not available on Windows");
+#else
+	string xml  = create_ancestry_response(CPL_RDF_RESULTS_XML,
+			RDF_PARSE_NUM_ROWS);
+	string json = create_ancestry_response(CPL_RDF_RESULTS_JSON,
+			RDF_PARSE_NUM_ROWS);
+
+	print(L_DEBUG, "Parsing %d recorded ancestry rows, %d iterations:",
+			RDF_PARSE_NUM_ROWS, RDF_PARSE_ITERATIONS);
+
+	double t_xml  = benchmark_rdf_parse("XML", CPL_RDF_RESULTS_XML, xml,
+			RDF_PARSE_NUM_ROWS);
+	double t_json = benchmark_rdf_parse("JSON", CPL_RDF_RESULTS_JSON, json,
+			RDF_PARSE_NUM_ROWS);
+
+	print(L_DEBUG, "JSON is %.2lfx the size of XML and parses %.2lfx faster",
+			json.length() / (double) xml.length(), t_xml / t_json);
+
+
+	// Malformed responses must be rejected
+
+	const char* bad = "{\"results\":{\"bindings\":[{\"x\":}]}}";
+	cpl_return_t ret = cpl_rdf_parse_recorded_response(bad, strlen(bad),
+			CPL_RDF_RESULTS_JSON, NULL);
+	if (CPL_IS_OK(ret)) {
+		throw CPLException("A malformed JSON response was not rejected");
+	}
+
+
+	// The rows need to be the same when the response arrives in small
+	// chunks, which split the rows, the strings, the escape sequences, and
+	// the literals of the JSON response at every position
+
+	const char* escaped = "{\"results\":{\"distinct\":false,\"bindings\":["
+		"{\"x\":{\"type\":\"literal\",\"value\":\"a\\u00e9\\ud83d\\ude00"
+		"\\\"b\"}},{\"y\":{\"type\":\"uri\",\"value\":\"node:1\"}}]},"
+		"\"head\":{\"vars\":[\"x\",\"y\"],\"link\":[]},\"boolean\":true}";
+	size_t escaped_length = strlen(escaped);
+
+	for (size_t c = 1; c <= escaped_length; c++) {
+		size_t n = 0;
+		ret = cpl_rdf_parse_recorded_response(escaped, escaped_length,
+				CPL_RDF_RESULTS_JSON, &n, c);
+		CPL_VERIFY(cpl_rdf_parse_recorded_response, ret);
+		if (n != 2) {
+			throw CPLException("The JSON parser returned %lu rows instead of "
+					"2 with %lu-byte chunks", (unsigned long) n,
+					(unsigned long) c);
+		}
+
+		ret = cpl_rdf_parse_recorded_response(escaped, escaped_length - 1,
+				CPL_RDF_RESULTS_JSON, NULL, c);
+		if (CPL_IS_OK(ret)) {
+			throw CPLException("A truncated JSON response was not rejected");
+		}
+	}
+
+	string small_xml  = create_ancestry_response(CPL_RDF_RESULTS_XML, 100);
+	string small_json = create_ancestry_response(CPL_RDF_RESULTS_JSON, 100);
+	const size_t chunk_sizes[] = { 1, 7, 4096 };
+
+	for (size_t i = 0; i < sizeof(chunk_sizes) / sizeof(*chunk_sizes); i++) {
+		size_t n_xml = 0, n_json = 0;
+		ret = cpl_rdf_parse_recorded_response(small_xml.c_str(),
+				small_xml.length(), CPL_RDF_RESULTS_XML, &n_xml,
+				chunk_sizes[i]);
+		CPL_VERIFY(cpl_rdf_parse_recorded_response, ret);
+		ret = cpl_rdf_parse_recorded_response(small_json.c_str(),
+				small_json.length(), CPL_RDF_RESULTS_JSON, &n_json,
+				chunk_sizes[i]);
+		CPL_VERIFY(cpl_rdf_parse_recorded_response, ret);
+		if (n_xml != 100 || n_json != 100) {
+			throw CPLException("The parsers returned %lu and %lu rows instead "
+					"of 100 with %lu-byte chunks", (unsigned long) n_xml,
+					(unsigned long) n_json, (unsigned long) chunk_sizes[i]);
+		}
+	}
+#endif
+}
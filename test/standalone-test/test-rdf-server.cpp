@@ -0,0 +1,442 @@
+/*
+ * test-rdf-server.cpp
+ * Core Provenance Library
+ *
+ * Copyright 2011
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#include "stdafx.h"
+#include "standalone-test.h"
+
+#ifndef _WINDOWS
+#include <backends/cpl-rdf.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * The simulated processing time of a statement in the stub server (in us)
+ */
+#define RDF_SERVER_LATENCY_US		2000
+
+/**
+ * The number of queries issued by each client thread
+ */
+#define RDF_SERVER_QUERIES			100
+
+/**
+ * The maximum number of client threads
+ */
+#define RDF_SERVER_MAX_THREADS		8
+
+
+#ifndef _WINDOWS
+
+/**
+ * The response to every query, a single row with ?v = 1
+ */
+static const char* RDF_SERVER_RESPONSE =
+	"{\"head\":{\"vars\":[\"v\"]},\"results\":{\"bindings\":[{\"v\":"
+	"{\"type\":\"typed-literal\",\"datatype\":"
+	"\"http://www.w3.org/2001/XMLSchema#integer\",\"value\":\"1\"}}]}}";
+
+
+/**
+ * The stub SPARQL server
+ */
+typedef struct {
+	int listen_fd;
+	int port;
+	pthread_t accept_thread;
+	pthread_mutex_t lock;
+	vector<pthread_t> connection_threads;
+	unsigned long num_connections;
+	unsigned long num_queries;
+	unsigned long num_updates;
+} rdf_stub_server_t;
+
+
+/**
+ * The argument of the connection thread
+ */
+typedef struct {
+	rdf_stub_server_t* server;
+	int fd;
+} rdf_stub_connection_t;
+
+
+/**
+ * Send the whole buffer
+ *
+ * @param fd the socket
+ * @param s the data
+ * @param length the length of the data
+ * @return true on success
+ */
+static bool
+rdf_stub_send(int fd, const char* s, size_t length)
+{
+	while (length > 0) {
+		ssize_t r = send(fd, s, length, MSG_NOSIGNAL);
+		if (r <= 0) return false;
+		s += r;
+		length -= r;
+	}
+	return true;
+}
+
+
+/**
+ * Serve the HTTP/1.1 requests of one keep-alive connection until the client
+ * closes it. GET requests are answered with RDF_SERVER_RESPONSE, POST
+ * requests with an empty body.
+ *
+ * @param arg the rdf_stub_connection_t (will be freed)
+ * @return NULL
+ */
+static void*
+rdf_stub_connection_thread(void* arg)
+{
+	rdf_stub_connection_t* c = (rdf_stub_connection_t*) arg;
+	rdf_stub_server_t* server = c->server;
+	int fd = c->fd;
+	delete c;
+
+	string buffer;
+	char chunk[4096];
+
+	while (true) {
+
+		// Read the request header
+
+		size_t header_end;
+		while ((header_end = buffer.find("\r\n\r\n")) == string::npos) {
+			ssize_t r = recv(fd, chunk, sizeof(chunk), 0);
+			if (r <= 0) goto done;
+			buffer.append(chunk, r);
+		}
+
+
+		// Read the request body
+
+		size_t content_length = 0;
+		size_t p = buffer.find("Content-Length:");
+		if (p != string::npos && p < header_end) {
+			content_length = strtoul(buffer.c_str() + p + 15, NULL, 10);
+		}
+
+		size_t request_length = header_end + 4 + content_length;
+		while (buffer.length() < request_length) {
+			ssize_t r = recv(fd, chunk, sizeof(chunk), 0);
+			if (r <= 0) goto done;
+			buffer.append(chunk, r);
+		}
+
+		bool is_get = buffer.compare(0, 4, "GET ") == 0;
+		buffer.erase(0, request_length);
+
+
+		// Respond
+
+		usleep(RDF_SERVER_LATENCY_US);
+
+		const char* body = is_get ? RDF_SERVER_RESPONSE : "";
+		char header[256];
+		snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\n"
+				"Content-Type: %s\r\n"
+				"Content-Length: %lu\r\n\r\n",
+				is_get ? "application/sparql-results+json" : "text/plain",
+				(unsigned long) strlen(body));
+
+		if (!rdf_stub_send(fd, header, strlen(header))) goto done;
+		if (!rdf_stub_send(fd, body, strlen(body))) goto done;
+
+		pthread_mutex_lock(&server->lock);
+		if (is_get) server->num_queries++; else server->num_updates++;
+		pthread_mutex_unlock(&server->lock);
+	}
+
+done:
+	close(fd);
+	return NULL;
+}
+
+
+/**
+ * Accept the connections, starting a thread for each
+ *
+ * @param arg the rdf_stub_server_t
+ * @return NULL
+ */
+static void*
+rdf_stub_accept_thread(void* arg)
+{
+	rdf_stub_server_t* server = (rdf_stub_server_t*) arg;
+
+	while (true) {
+		int fd = accept(server->listen_fd, NULL, NULL);
+		if (fd < 0) break;
+
+		int one = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+		rdf_stub_connection_t* c = new rdf_stub_connection_t;
+		c->server = server;
+		c->fd = fd;
+
+		pthread_t t;
+		if (pthread_create(&t, NULL, rdf_stub_connection_thread, c) != 0) {
+			close(fd);
+			delete c;
+			continue;
+		}
+
+		pthread_mutex_lock(&server->lock);
+		server->connection_threads.push_back(t);
+		server->num_connections++;
+		pthread_mutex_unlock(&server->lock);
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Start the stub SPARQL server on an ephemeral port of the loopback
+ * interface
+ *
+ * @param server the server struct to initialize
+ */
+static void
+rdf_stub_server_start(rdf_stub_server_t* server)
+{
+	server->num_connections = 0;
+	server->num_queries = 0;
+	server->num_updates = 0;
+	pthread_mutex_init(&server->lock, NULL);
+
+	server->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (server->listen_fd < 0) {
+		throw CPLException("Could not create the server socket");
+	}
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+
+	socklen_t addr_len = sizeof(addr);
+	if (bind(server->listen_fd, (struct sockaddr*) &addr, sizeof(addr)) != 0
+			|| listen(server->listen_fd, 64) != 0
+			|| getsockname(server->listen_fd, (struct sockaddr*) &addr,
+				&addr_len) != 0) {
+		close(server->listen_fd);
+		throw CPLException("Could not start the stub SPARQL server");
+	}
+	server->port = ntohs(addr.sin_port);
+
+	if (pthread_create(&server->accept_thread, NULL, rdf_stub_accept_thread,
+				server) != 0) {
+		close(server->listen_fd);
+		throw CPLException("Could not start the stub SPARQL server thread");
+	}
+}
+
+
+/**
+ * Stop the stub SPARQL server. The clients must have already closed their
+ * connections.
+ *
+ * @param server the server
+ */
+static void
+rdf_stub_server_stop(rdf_stub_server_t* server)
+{
+	shutdown(server->listen_fd, SHUT_RDWR);
+	close(server->listen_fd);
+	pthread_join(server->accept_thread, NULL);
+
+	for (size_t i = 0; i < server->connection_threads.size(); i++) {
+		pthread_join(server->connection_threads[i], NULL);
+	}
+
+	pthread_mutex_destroy(&server->lock);
+}
+
+
+/**
+ * The client thread
+ *
+ * @param arg the backend
+ * @return NULL on success, or a non-NULL value on error
+ */
+static void*
+rdf_stub_client_thread(void* arg)
+{
+	cpl_db_backend_t* backend = (cpl_db_backend_t*) arg;
+	cpl_id_t id;
+	id.hi = 1;
+	id.lo = 2;
+
+	for (int i = 0; i < RDF_SERVER_QUERIES; i++) {
+		cpl_version_t version = CPL_VERSION_NONE;
+		cpl_return_t ret = backend->cpl_db_get_version(backend, id, &version);
+		if (!CPL_IS_OK(ret) || version != 1) return (void*) 1;
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Run the queries from the given number of threads
+ *
+ * @param backend the backend
+ * @param num_threads the number of threads
+ * @return the throughput in queries per second
+ */
+static double
+benchmark_rdf_server(cpl_db_backend_t* backend, int num_threads)
+{
+	vector<pthread_t> threads(num_threads);
+	bool ok = true;
+
+	double start_time = current_time_seconds();
+
+	for (int i = 0; i < num_threads; i++) {
+		if (pthread_create(&threads[i], NULL, rdf_stub_client_thread,
+					backend) != 0) {
+			throw CPLException("Could not create a client thread");
+		}
+	}
+
+	for (int i = 0; i < num_threads; i++) {
+		void* r = NULL;
+		pthread_join(threads[i], &r);
+		if (r != NULL) ok = false;
+	}
+
+	double t = current_time_seconds() - start_time;
+	if (t <= 0) t = 1e-9;
+
+	if (!ok) throw CPLException("A query to the stub SPARQL server failed");
+
+	return num_threads * RDF_SERVER_QUERIES / t;
+}
+
+#endif
+
+
+/**
+ * The concurrent query throughput benchmark for the RDF connection layer,
+ * using a local stub SPARQL server
+ */
+void
+test_rdf_server(void)
+{
+#ifdef _WINDOWS
+	print(L_DEBUG, "The RDF backend is not available on Windows");
+#else
+	cpl_return_t ret;
+
+	rdf_stub_server_t server;
+	rdf_stub_server_start(&server);
+
+	char url[64];
+	snprintf(url, sizeof(url), "http://127.0.0.1:%d/sparql/", server.port);
+	print(L_DEBUG, "Stub SPARQL server: %s (%d us per statement)", url,
+			RDF_SERVER_LATENCY_US);
+
+	cpl_db_backend_t* backend = NULL;
+	ret = cpl_create_rdf_backend(url, url, CPL_RDF_GENERIC, &backend);
+	CPL_VERIFY(cpl_create_rdf_backend, ret);
+
+	try {
+
+		// Measure the throughput as the number of threads grows
+
+		double base = 0;
+		for (int n = 1; n <= RDF_SERVER_MAX_THREADS; n *= 2) {
+			double qps = benchmark_rdf_server(backend, n);
+			if (n == 1) base = qps;
+			print(L_DEBUG, "  %d thread%s  %8.0lf queries/s  %5.2lfx", n,
+					n == 1 ? " " : "s", qps, qps / base);
+		}
+
+
+		// Updates and queries share the pooled handles
+
+		cpl_id_t id;
+		id.hi = 1;
+		id.lo = 2;
+		ret = backend->cpl_db_add_property(backend, id, 1, "key", "value");
+		CPL_VERIFY(cpl_db_add_property, ret);
+		ret = backend->cpl_db_get_version(backend, id, NULL);
+		CPL_VERIFY(cpl_db_get_version, ret);
+	}
+	catch (...) {
+		backend->cpl_db_destroy(backend);
+		rdf_stub_server_stop(&server);
+		throw;
+	}
+
+	backend->cpl_db_destroy(backend);
+	rdf_stub_server_stop(&server);
+
+	print(L_DEBUG, "Server: %lu connections, %lu queries, %lu updates",
+			server.num_connections, server.num_queries, server.num_updates);
+
+
+	// Check that the connections were kept alive and reused (the backend
+	// has separate connection handles for queries and for updates)
+
+	if (server.num_updates != 1) {
+		throw CPLException("The stub server received %lu updates instead "
+				"of 1", server.num_updates);
+	}
+	if (server.num_connections > RDF_SERVER_MAX_THREADS + 1) {
+		throw CPLException("The connection layer opened %lu connections for "
+				"at most %d concurrent statements", server.num_connections,
+				RDF_SERVER_MAX_THREADS + 1);
+	}
+#endif
+}
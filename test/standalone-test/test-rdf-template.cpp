@@ -0,0 +1,237 @@
+/*
+ * test-rdf-template.cpp
+ * Core Provenance Library
+ *
+ * Copyright 2011
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#include "stdafx.h"
+#include "standalone-test.h"
+
+#ifndef _WINDOWS
+#include <backends/cpl-rdf.h>
+#include "../../backends/cpl-rdf/cpl-rdf-private.h"
+#endif
+
+#include <cstdio>
+#include <ctime>
+#include <sstream>
+
+using namespace std;
+
+
+/**
+ * The number of times to format the statements
+ */
+#define RDF_TEMPLATE_ITERATIONS		200000
+
+
+#ifndef _WINDOWS
+
+/**
+ * Format a representative mix of statements (an object, a property, an
+ * ancestry edge, and a version query) using ostringstream and sprintf, the
+ * way the RDF backend built them before the statement templates
+ *
+ * @param t the compiled templates (unused)
+ * @param id the object ID
+ * @param version the object version
+ * @param session the session ID
+ * @return the total length of the statements
+ */
+static size_t
+format_statements_stream(const cpl_rdf_templates_t& t,
+						 const cpl_id_t& id,
+						 const cpl_version_t version,
+						 const cpl_session_t& session)
+{
+	size_t length = 0;
+
+	char session_str[64];
+	sprintf(session_str, "s:%llx-%llx", session.hi, session.lo);
+
+	char id_str[64];
+	sprintf(id_str, "o:%llx-%llx", id.hi, id.lo);
+
+	char node_str[64];
+	sprintf(node_str, "n:%llx-%llx-%x", id.hi, id.lo, version);
+
+	char node0_str[64];
+	sprintf(node0_str, "n:%llx-%llx-0", id.hi, id.lo);
+
+	ostringstream ss_object;
+	ss_object << " " << id_str;
+	ss_object << " p:originator \"" << cpl_rdf_escape_string("/benchmark")
+			  << "\";";
+	ss_object << " p:name \"" << cpl_rdf_escape_string("data \"file\".txt")
+			  << "\";";
+	ss_object << " p:type \"" << cpl_rdf_escape_string("file") << "\";";
+	ss_object << " p:creation_time " << 1300000000 << ";";
+	ss_object << " r:version " << node0_str << " .";
+	ss_object << " " << node0_str << " r:session " << session_str << ";";
+	ss_object << " p:version 0;";
+	ss_object << " p:creation_time " << 1300000000 << " .";
+	length += ss_object.str().length();
+
+	ostringstream ss_property;
+	ss_property << " " << node_str;
+	ss_property << " c:" << cpl_rdf_hex_string("checksum");
+	ss_property << " \"" << cpl_rdf_escape_string("0123456789abcdef") << "\" .";
+	length += ss_property.str().length();
+
+	char edge[32];
+	sprintf(edge, "i:%x", CPL_DATA_INPUT);
+	ostringstream ss_edge;
+	ss_edge << " " << node_str << " " << edge << " " << node0_str << " .";
+	length += ss_edge.str().length();
+
+	ostringstream ss_query;
+	ss_query << "PREFIX o: <object:>\n";
+	ss_query << "PREFIX p: <prop:>\n";
+	ss_query << "PREFIX r: <rel:>\n";
+	ss_query << "SELECT ?v WHERE { ";
+	ss_query << " " << id_str << " r:version ?node . ?node p:version ?v .";
+	ss_query << " OPTIONAL {";
+	ss_query << "  " << id_str <<" r:version ?o_node . ?o_node p:version ?o_v .";
+	ss_query << "  FILTER ( ?o_v > ?v ) . } . FILTER ( !bound(?o_v) ) . }";
+	length += ss_query.str().length();
+
+	return length;
+}
+
+
+/**
+ * Format the same mix of statements as format_statements_stream() using
+ * the precompiled statement templates of the RDF backend
+ *
+ * @param t the compiled templates
+ * @param id the object ID
+ * @param version the object version
+ * @param session the session ID
+ * @return the total length of the statements
+ */
+static size_t
+format_statements_template(const cpl_rdf_templates_t& t,
+						   const cpl_id_t& id,
+						   const cpl_version_t version,
+						   const cpl_session_t& session)
+{
+	size_t length = 0;
+
+	RDFQuery q_object(t.insert_object);
+	q_object.object(id).literal("/benchmark").literal("data \"file\".txt")
+			.literal("file").integer(1300000000).node(id, 0);
+	q_object.node(id, 0).session(session).integer(1300000000);
+	length += q_object.str().length();
+
+	RDFQuery q_property(t.insert_property);
+	q_property.node(id, version).key("checksum").literal("0123456789abcdef");
+	length += q_property.str().length();
+
+	RDFQuery q_edge(t.insert_ancestry_edge);
+	q_edge.node(id, version).hex(CPL_DATA_INPUT).node(id, 0);
+	length += q_edge.str().length();
+
+	RDFQuery q_query(t.get_version);
+	q_query.object(id).object(id);
+	length += q_query.str().length();
+
+	return length;
+}
+
+
+/**
+ * Measure the CPU time needed to format the statements
+ *
+ * @param name the name of the method
+ * @param t the compiled templates
+ * @param format the formatting function
+ * @return the CPU time in seconds per iteration
+ */
+static double
+benchmark_rdf_template(const char* name,
+					   const cpl_rdf_templates_t& t,
+					   size_t (*format)(const cpl_rdf_templates_t&,
+										const cpl_id_t&,
+										const cpl_version_t,
+										const cpl_session_t&))
+{
+	size_t length = 0;
+	cpl_id_t id;
+	cpl_session_t session;
+	session.hi = 0x5e55105eULL;
+	session.lo = 0xfeedfacecafebeefULL;
+
+	clock_t start = clock();
+
+	for (size_t i = 0; i < RDF_TEMPLATE_ITERATIONS; i++) {
+		id.hi = 0x1000 + i;
+		id.lo = 0xabcdef0123456789ULL ^ (i * 0x9e3779b97f4a7c15ULL);
+		length += format(t, id, (cpl_version_t) (i & 0xff), session);
+	}
+
+	double d = (clock() - start) / (double) CLOCKS_PER_SEC
+		/ RDF_TEMPLATE_ITERATIONS;
+	if (d <= 0) d = 1e-12;
+
+	print(L_DEBUG, "  %-8s %8.0lf ns/call  %6.0lf bytes/call", name,
+			d * 1e9, length / (double) RDF_TEMPLATE_ITERATIONS);
+
+	return d;
+}
+
+#endif
+
+
+/**
+ * The CPU cost benchmark for building SPARQL statements
+ */
+void
+test_rdf_template(void)
+{
+#ifdef _WINDOWS
+	print(L_DEBUG, "The RDF backend is not available on Windows");
+#else
+	cpl_rdf_templates_t t;
+	cpl_return_t ret = cpl_rdf_compile_templates(&t);
+	CPL_VERIFY(cpl_rdf_compile_templates, ret);
+
+	print(L_DEBUG, "Formatting 4 statements, %d iterations:",
+			RDF_TEMPLATE_ITERATIONS);
+
+	double t_stream = benchmark_rdf_template("stream", t,
+			format_statements_stream);
+	double t_template = benchmark_rdf_template("template", t,
+			format_statements_template);
+
+	print(L_DEBUG, "The statement templates are %.2lfx faster",
+			t_stream / t_template);
+#endif
+}
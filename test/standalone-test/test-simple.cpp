@@ -35,6 +35,8 @@
 #include "stdafx.h"
 #include "standalone-test.h"
 
+#include <private/cpl-platform.h>
+
 #include <map>
 #include <set>
 #include <vector>
@@ -43,6 +45,23 @@
 using namespace std;
 
 
+/**
+ * The number of threads that query the result cache concurrently
+ */
+#define RESULT_CACHE_THREADS		4
+
+/**
+ * The number of properties added while the result cache is being queried
+ */
+#define RESULT_CACHE_UPDATES		16
+
+/**
+ * The number of times the result cache is disabled and enabled while it is
+ * being queried
+ */
+#define RESULT_CACHE_TOGGLES		16
+
+
 /**
  * Print the cpl_session_info_t structure
  *
@@ -264,6 +283,24 @@ cb_lookup_by_property(const cpl_id_t id,
 }
 
 
+/**
+ * The iterator callback function used by the version listing functions.
+ *
+ * @param info the version info
+ * @param context the application-provided context
+ * @return CPL_OK or an error code (the caller should fail on this error)
+ */
+static cpl_return_t
+cb_collect_version_info(const cpl_version_info_t* info,
+						void* context)
+{
+	std::vector<cpl_version_info_t>* v
+		= (std::vector<cpl_version_info_t>*) context;
+	v->push_back(*info);
+	return CPL_OK;
+}
+
+
 /**
  * Check the time
  *
@@ -329,6 +366,66 @@ contains(std::set<std::pair<cpl_id_t, cpl_version_t> >& s, const cpl_id_t id,
 }
 
 
+/**
+ * The context of the result cache test threads
+ */
+typedef struct result_cache_thread_context {
+	cpl_id_t id;
+	volatile bool done;
+	volatile cpl_return_t ret;
+} result_cache_thread_context_t;
+
+
+/**
+ * The thread that repeatedly queries the properties and the ancestors of an
+ * object through the result cache until told to stop
+ *
+ * @param arg the result_cache_thread_context_t
+ */
+static THREAD_FUNCTION(result_cache_reader_thread, arg)
+{
+	result_cache_thread_context_t* ctx = (result_cache_thread_context_t*) arg;
+
+	while (!ctx->done && CPL_IS_OK(ctx->ret)) {
+		std::vector<cplxx_property_entry_t> properties;
+		cpl_return_t r = cpl_get_properties(ctx->id, CPL_VERSION_NONE,
+				"RC", cpl_cb_collect_properties_vector, &properties);
+		if (!CPL_IS_OK(r)) ctx->ret = r;
+
+		std::vector<cpl_ancestry_entry_t> edges;
+		r = cpl_get_object_ancestry(ctx->id, CPL_VERSION_NONE,
+				CPL_D_ANCESTORS, 0, cpl_cb_collect_ancestry_vector, &edges);
+		if (!CPL_IS_OK(r)) ctx->ret = r;
+	}
+
+	THREAD_RETURN;
+}
+
+
+/**
+ * Run a path query and collect the IDs of the returned objects
+ *
+ * @param query the query text
+ * @param out the set to store the object IDs
+ * @return the return code of cpl_query()
+ */
+static cpl_return_t
+query_ids(const std::string& query, std::set<cpl_id_t>& out)
+{
+	std::vector<cplxx_object_info_t> v;
+	cpl_return_t ret = cpl_query(query.c_str(),
+			cpl_cb_collect_object_info_vector, &v);
+	print(L_DEBUG, "cpl_query --> %d [%d]", ret, (int) v.size());
+
+	out.clear();
+	for (size_t i = 0; i < v.size(); i++) out.insert(v[i].id);
+	if (out.size() != v.size())
+		throw CPLException("The query returned an object more than once.");
+
+	return ret;
+}
+
+
 /**
  * Create a random binary file
  *
@@ -606,6 +703,223 @@ test_simple(void)
 	print(L_DEBUG, " ");
 
 
+	// Container contents
+
+	cpl_id_t objn;
+	ret = cpl_create_object(ORIGINATOR, "Object B", "File", obj2, &objn);
+	print(L_DEBUG, "cpl_create_object --> %llx:%llx [%d]", objn.hi,objn.lo,ret);
+	CPL_VERIFY(cpl_create_object, ret);
+	if (with_delays) delay();
+
+	std::set<cpl_id_t> cset;
+
+	oiv.clear();
+	ret = cpl_get_contained_objects(obj, 0, 0, CPL_I_FAST,
+			cpl_cb_collect_object_info_vector, &oiv);
+	print(L_DEBUG, "cpl_get_contained_objects --> %d objects [%d]",
+			(int) oiv.size(), ret);
+	CPL_VERIFY(cpl_get_contained_objects, ret);
+	for (size_t i = 0; i < oiv.size(); i++) cset.insert(oiv[i].id);
+	if (cset.size() != 2 || !cset.count(obj2) || !cset.count(obj3))
+		throw CPLException("Unexpected contents of a container");
+	if (with_delays) delay();
+
+	oiv.clear();
+	cset.clear();
+	ret = cpl_get_contained_objects(obj, CPL_VERSION_NONE, 1, 0,
+			cpl_cb_collect_object_info_vector, &oiv);
+	print(L_DEBUG, "cpl_get_contained_objects --> %d objects [%d]",
+			(int) oiv.size(), ret);
+	CPL_VERIFY(cpl_get_contained_objects, ret);
+	for (size_t i = 0; i < oiv.size(); i++) {
+		cset.insert(oiv[i].id);
+		if (oiv[i].id == objn && oiv[i].container_id != obj2)
+			throw CPLException("Unexpected container of a nested object");
+	}
+	if (cset.size() != 3 || !cset.count(objn))
+		throw CPLException("Unexpected contents of a container");
+	if (with_delays) delay();
+
+	oiv.clear();
+	ret = cpl_get_contained_objects(obj3, CPL_VERSION_NONE, 1, 0,
+			cpl_cb_collect_object_info_vector, &oiv);
+	print(L_DEBUG, "cpl_get_contained_objects --> %d objects [%d]",
+			(int) oiv.size(), ret);
+	if (ret != CPL_S_NO_DATA)
+		throw CPLException("An object without contents returned objects");
+	if (with_delays) delay();
+
+	print(L_DEBUG, " ");
+
+
+	// Name prefix lookup
+
+	char prefix_base[64];
+	snprintf(prefix_base, sizeof(prefix_base), "/prefix-%llx-%llx",
+			obj.hi, obj.lo);
+	const char* prefix_names[] = { "/b", "/a", "/a/c", "/a_1", "/ab", "x" };
+	std::set<cpl_id_t> pset;
+	cpl_id_t prefix_b = CPL_NONE;
+
+	for (size_t i = 0; i < sizeof(prefix_names) / sizeof(char*); i++) {
+		std::string n = std::string(prefix_base) + prefix_names[i];
+		cpl_id_t o;
+		ret = cpl_create_object(ORIGINATOR, n.c_str(), i == 0 ? "Proc" : "File",
+				CPL_NONE, &o);
+		print(L_DEBUG, "cpl_create_object --> %llx:%llx [%d]", o.hi,o.lo,ret);
+		CPL_VERIFY(cpl_create_object, ret);
+		if (i == 0) prefix_b = o;
+		if (prefix_names[i][0] == '/') pset.insert(o);
+	}
+	if (with_delays) delay();
+
+	std::string prefix = std::string(prefix_base) + "/";
+	oiv.clear();
+	ret = cpl_lookup_by_name_prefix(ORIGINATOR, prefix.c_str(), NULL, 0,
+			cpl_cb_collect_object_info_vector, &oiv);
+	print(L_DEBUG, "cpl_lookup_by_name_prefix --> %d objects [%d]",
+			(int) oiv.size(), ret);
+	CPL_VERIFY(cpl_lookup_by_name_prefix, ret);
+	cset.clear();
+	for (size_t i = 0; i < oiv.size(); i++) cset.insert(oiv[i].id);
+	if (cset != pset || oiv.size() != pset.size())
+		throw CPLException("Unexpected result of a name prefix lookup");
+	if (oiv.front().name != prefix + "a" || oiv.back().id != prefix_b)
+		throw CPLException("The name prefix lookup is not ordered by name");
+	if (with_delays) delay();
+
+	prefix = std::string(prefix_base) + "/a_";
+	oiv.clear();
+	ret = cpl_lookup_by_name_prefix(ORIGINATOR, prefix.c_str(), "File", 0,
+			cpl_cb_collect_object_info_vector, &oiv);
+	print(L_DEBUG, "cpl_lookup_by_name_prefix --> %d objects [%d]",
+			(int) oiv.size(), ret);
+	CPL_VERIFY(cpl_lookup_by_name_prefix, ret);
+	if (oiv.size() != 1 || oiv[0].name != prefix + "1")
+		throw CPLException("The name prefix was not matched literally");
+	if (with_delays) delay();
+
+	prefix = std::string(prefix_base) + "/";
+	oiv.clear();
+	ret = cpl_lookup_by_name_prefix(ORIGINATOR, prefix.c_str(), "Proc",
+			CPL_I_FAST, cpl_cb_collect_object_info_vector, &oiv);
+	print(L_DEBUG, "cpl_lookup_by_name_prefix --> %d objects [%d]",
+			(int) oiv.size(), ret);
+	CPL_VERIFY(cpl_lookup_by_name_prefix, ret);
+	if (oiv.size() != 1 || oiv[0].id != prefix_b)
+		throw CPLException("Unexpected result of a name prefix lookup");
+	if (with_delays) delay();
+
+	prefix = std::string(prefix_base) + "/none/";
+	oiv.clear();
+	ret = cpl_lookup_by_name_prefix(NULL, prefix.c_str(), NULL, CPL_I_FAST,
+			cpl_cb_collect_object_info_vector, &oiv);
+	print(L_DEBUG, "cpl_lookup_by_name_prefix --> %d objects [%d]",
+			(int) oiv.size(), ret);
+	if (ret != CPL_S_NO_DATA)
+		throw CPLException("A name prefix lookup returned unexpected objects");
+	if (with_delays) delay();
+
+	print(L_DEBUG, " ");
+
+
+	// Graph statistics
+
+	std::vector<cplxx_graph_statistic_t> gsv;
+	ret = cpl_get_graph_statistics(CPL_GS_ALL, 0, 0,
+			cpl_cb_collect_graph_statistics_vector, &gsv);
+	print(L_DEBUG, "cpl_get_graph_statistics --> %d rows [%d]",
+			(int) gsv.size(), ret);
+	CPL_VERIFY(cpl_get_graph_statistics, ret);
+
+	unsigned long long gs_sum[CPL_GS_ALL + 1];
+	memset(gs_sum, 0, sizeof(gs_sum));
+	unsigned long long gs_inputs = 0;
+	bool gs_found_originator = false;
+	for (size_t i = 0; i < gsv.size(); i++) {
+		cplxx_graph_statistic_t& s = gsv[i];
+		if (i > 0 && (s.kind < gsv[i-1].kind
+					|| (s.kind == gsv[i-1].kind && s.key < gsv[i-1].key)))
+			throw CPLException("The graph statistics are not ordered");
+		gs_sum[s.kind] += s.count;
+		if (s.kind == CPL_GS_FAN_IN) gs_inputs += s.key * s.count;
+		if (s.kind == CPL_GS_OBJECTS_PER_DAY && s.originator == ORIGINATOR)
+			gs_found_originator = true;
+	}
+	print(L_DEBUG, "  %llu edges, %llu objects, %llu versions",
+			gs_sum[CPL_GS_EDGES_BY_TYPE], gs_sum[CPL_GS_VERSIONS_PER_OBJECT],
+			gs_sum[CPL_GS_FAN_IN]);
+	if (gs_sum[CPL_GS_EDGES_BY_TYPE] == 0 || !gs_found_originator)
+		throw CPLException("The graph statistics are missing some data");
+	if (gs_sum[CPL_GS_EDGES_BY_TYPE] != gs_inputs
+			|| gs_sum[CPL_GS_FAN_IN] != gs_sum[CPL_GS_FAN_OUT]
+			|| gs_sum[CPL_GS_VERSIONS_PER_OBJECT]
+				!= gs_sum[CPL_GS_OBJECTS_PER_DAY])
+		throw CPLException("The graph statistics are inconsistent");
+	if (with_delays) delay();
+
+	gsv.clear();
+	ret = cpl_get_graph_statistics(CPL_GS_EDGES_BY_TYPE,
+			(unsigned long) time(NULL) + 86400, 0,
+			cpl_cb_collect_graph_statistics_vector, &gsv);
+	print(L_DEBUG, "cpl_get_graph_statistics --> %d rows [%d]",
+			(int) gsv.size(), ret);
+	if (ret != CPL_S_NO_DATA)
+		throw CPLException("The graph statistics of the future are not empty");
+	if (with_delays) delay();
+
+	print(L_DEBUG, " ");
+
+
+	// Object listing using a cursor, in small batches
+
+	for (int pass = 0; pass < 2; pass++) {
+
+		const char* cursor_type = pass == 0 ? NULL : "Proc";
+		cpl_cursor_t* cursor = NULL;
+		ret = cpl_open_object_cursor(ORIGINATOR, cursor_type, 0, &cursor);
+		print(L_DEBUG, "cpl_open_object_cursor --> %d", ret);
+		CPL_VERIFY(cpl_open_object_cursor, ret);
+
+		std::set<cpl_id_t> cursor_ids;
+		cpl_object_info_t* cursor_infos[2];
+		size_t cursor_count = 0;
+		while (true) {
+			ret = cpl_cursor_fetch_objects(cursor, 2, cursor_infos,
+										   &cursor_count);
+			if (ret == CPL_S_NO_DATA) break;
+			CPL_VERIFY(cpl_cursor_fetch_objects, ret);
+
+			for (size_t i = 0; i < cursor_count; i++) {
+				cpl_object_info_t* ci = cursor_infos[i];
+				bool ok = cursor_ids.insert(ci->id).second
+					&& strcmp(ci->originator, ORIGINATOR) == 0
+					&& (cursor_type == NULL
+						|| strcmp(ci->type, cursor_type) == 0)
+					&& ci->version != CPL_VERSION_NONE;
+				cpl_free_object_info(ci);
+				if (!ok) {
+					cpl_close_cursor(cursor);
+					throw CPLException("The cursor returned a wrong object");
+				}
+			}
+		}
+		print(L_DEBUG, "cpl_cursor_fetch_objects --> %d objects",
+			  (int) cursor_ids.size());
+
+		ret = cpl_close_cursor(cursor);
+		CPL_VERIFY(cpl_close_cursor, ret);
+
+		if (cursor_ids.count(obj) == 0 || cursor_ids.count(obj3) == 0
+				|| (cursor_ids.count(obj2) == 0) != (pass == 1)) {
+			throw CPLException("Object listing using a cursor did not return "
+					"the correct objects");
+		}
+	}
+
+	print(L_DEBUG, " ");
+
+
 	// Object info
 
 	cpl_object_info_t* info = NULL;
@@ -713,6 +1027,104 @@ test_simple(void)
 	print(L_DEBUG, " ");
 
 
+	// Batched object, version, and session info
+
+	cpl_id_t batch_ids[3] = { obj, obj2, obj };
+	cpl_object_info_t* batch_infos[3];
+	ret = cpl_get_object_info_batch(batch_ids, 3, batch_infos);
+	print(L_DEBUG, "cpl_get_object_info_batch --> %d", ret);
+	CPL_VERIFY(cpl_get_object_info_batch, ret);
+	if (with_delays) delay();
+
+	for (int i = 0; i < 3; i++) {
+		if (batch_infos[i]->id != batch_ids[i]) {
+			throw CPLException("The returned object information is incorrect");
+		}
+	}
+	if (batch_infos[0] == batch_infos[2]
+			|| strcmp(batch_infos[0]->name, batch_infos[2]->name) != 0
+			|| strcmp(batch_infos[1]->name, "Object A") != 0) {
+		throw CPLException("The returned object information is incorrect");
+	}
+	for (int i = 0; i < 3; i++) cpl_free_object_info(batch_infos[i]);
+
+	cpl_id_version_t batch_nodes[2];
+	batch_nodes[0].id = obj;  batch_nodes[0].version = version1;
+	batch_nodes[1].id = obj2; batch_nodes[1].version = version2;
+	cpl_version_info_t* batch_vinfos[2];
+	unsigned long batch_vtimes[2];
+	ret = cpl_get_version_info_batch(batch_nodes, 2, batch_vinfos);
+	print(L_DEBUG, "cpl_get_version_info_batch --> %d", ret);
+	CPL_VERIFY(cpl_get_version_info_batch, ret);
+	if (with_delays) delay();
+
+	for (int i = 0; i < 2; i++) {
+		if (batch_vinfos[i]->id != batch_nodes[i].id
+				|| batch_vinfos[i]->version != batch_nodes[i].version
+				|| batch_vinfos[i]->session != session) {
+			throw CPLException("The returned version information is incorrect");
+		}
+		batch_vtimes[i] = batch_vinfos[i]->creation_time;
+		cpl_free_version_info(batch_vinfos[i]);
+	}
+
+	cpl_session_info_t* batch_sinfo = NULL;
+	ret = cpl_get_session_info_batch(&session, 1, &batch_sinfo);
+	print(L_DEBUG, "cpl_get_session_info_batch --> %d", ret);
+	CPL_VERIFY(cpl_get_session_info_batch, ret);
+	if (batch_sinfo->id != session) {
+		throw CPLException("The returned session information is incorrect");
+	}
+	cpl_free_session_info(batch_sinfo);
+
+	print(L_DEBUG, " ");
+
+
+	// Versions by time range and by session
+
+	for (int pass = 0; pass < 2; pass++) {
+
+		bool first_older = batch_vtimes[0] <= batch_vtimes[1];
+		unsigned long t1 = batch_vtimes[first_older ? 0 : 1];
+		unsigned long t2 = batch_vtimes[first_older ? 1 : 0];
+		std::vector<cpl_version_info_t> vlist;
+
+		if (pass == 0) {
+			ret = cpl_get_versions_in_range(t1, t2, cb_collect_version_info,
+											&vlist);
+			print(L_DEBUG, "cpl_get_versions_in_range --> %d versions [%d]",
+				  (int) vlist.size(), ret);
+			CPL_VERIFY(cpl_get_versions_in_range, ret);
+		}
+		else {
+			ret = cpl_get_session_activity(session, cb_collect_version_info,
+										   &vlist);
+			print(L_DEBUG, "cpl_get_session_activity --> %d versions [%d]",
+				  (int) vlist.size(), ret);
+			CPL_VERIFY(cpl_get_session_activity, ret);
+		}
+		if (with_delays) delay();
+
+		std::set<std::pair<cpl_id_t, cpl_version_t> > vset;
+		for (size_t i = 0; i < vlist.size(); i++) {
+			if ((pass == 0 && (vlist[i].creation_time < t1
+							   || vlist[i].creation_time > t2))
+					|| (pass == 1 && vlist[i].session != session)
+					|| (i > 0 && vlist[i].creation_time
+								 < vlist[i - 1].creation_time)) {
+				throw CPLException("The returned version list is incorrect");
+			}
+			vset.insert(std::pair<cpl_id_t, cpl_version_t>(vlist[i].id,
+						vlist[i].version));
+		}
+		if (!contains(vset, obj, version1) || !contains(vset, obj2, version2)) {
+			throw CPLException("The returned version list is incomplete");
+		}
+	}
+
+	print(L_DEBUG, " ");
+
+
 	// Ancestry (all checks assume the cycle avoidance algorithm)
 
 	cb_object_ancestry_context_t actx;
@@ -793,6 +1205,159 @@ test_simple(void)
 	print(L_DEBUG, " ");
 
 
+	// Lineage
+
+	actx.direction = CPL_D_DESCENDANTS;
+	actx.results.clear();
+	print(L_DEBUG, "Lineage descendants of version 0 (one level):");
+	ret = cpl_get_object_lineage(obj, 0, actx.direction, 1, 0,
+								 cb_object_ancestry, &actx);
+	print(L_DEBUG, "cpl_get_object_lineage --> %d", ret);
+	CPL_VERIFY(cpl_get_object_lineage, ret);
+	if (with_delays) delay();
+
+	if (actx.results.size() != 3) throw CPLException("Invalid lineage");
+
+	print(L_DEBUG, " ");
+
+	actx.direction = CPL_D_DESCENDANTS;
+	actx.results.clear();
+	print(L_DEBUG, "Lineage descendants of version 0:");
+	ret = cpl_get_object_lineage(obj, 0, actx.direction, 0, 0,
+								 cb_object_ancestry, &actx);
+	print(L_DEBUG, "cpl_get_object_lineage --> %d", ret);
+	CPL_VERIFY(cpl_get_object_lineage, ret);
+	if (with_delays) delay();
+
+	if (actx.results.size() < 3) throw CPLException("Invalid lineage");
+
+	print(L_DEBUG, " ");
+
+	std::multiset<std::pair<cpl_id_t, cpl_version_t> > lineage_set;
+	for (size_t i = 0; i < actx.results.size(); i++) {
+		lineage_set.insert(std::make_pair(actx.results[i].id,
+					actx.results[i].version));
+	}
+
+	actx.direction = CPL_D_DESCENDANTS;
+	actx.results.clear();
+	print(L_DEBUG, "Parallel lineage descendants of version 0:");
+	ret = cpl_get_object_lineage_parallel(obj, 0, actx.direction, 0, 0, 4,
+										  cb_object_ancestry, &actx);
+	print(L_DEBUG, "cpl_get_object_lineage_parallel --> %d", ret);
+	CPL_VERIFY(cpl_get_object_lineage_parallel, ret);
+	if (with_delays) delay();
+
+	std::multiset<std::pair<cpl_id_t, cpl_version_t> > parallel_set;
+	for (size_t i = 0; i < actx.results.size(); i++) {
+		parallel_set.insert(std::make_pair(actx.results[i].id,
+					actx.results[i].version));
+	}
+	if (parallel_set != lineage_set) throw CPLException("Invalid lineage");
+
+	print(L_DEBUG, " ");
+
+
+	// Transitive ancestry
+
+	actx.direction = CPL_D_ANCESTORS;
+	actx.results.clear();
+	print(L_DEBUG, "Transitive ancestors of all versions:");
+	ret = cpl_get_transitive_ancestry(obj, CPL_VERSION_NONE, actx.direction,
+									  cb_object_ancestry, &actx);
+	print(L_DEBUG, "cpl_get_transitive_ancestry --> %d", ret);
+	CPL_VERIFY(cpl_get_transitive_ancestry, ret);
+	if (with_delays) delay();
+
+	if (actx.results.size() != 1) throw CPLException("Invalid ancestry");
+	if (actx.results[0].id != obj3) throw CPLException("Invalid ancestry");
+
+	print(L_DEBUG, " ");
+
+	actx.direction = CPL_D_DESCENDANTS;
+	actx.results.clear();
+	print(L_DEBUG, "Transitive descendants of version 0:");
+	ret = cpl_get_transitive_ancestry(obj, 0, actx.direction,
+									  cb_object_ancestry, &actx);
+	print(L_DEBUG, "cpl_get_transitive_ancestry --> %d", ret);
+	CPL_VERIFY(cpl_get_transitive_ancestry, ret);
+	if (with_delays) delay();
+
+	if (actx.results.size() < 3) throw CPLException("Invalid ancestry");
+
+	print(L_DEBUG, " ");
+
+
+	// Provenance path
+
+	std::vector<cpl_ancestry_entry_t> path;
+	ret = cpl_find_provenance_path(obj, CPL_VERSION_NONE, obj3, 0, 0,
+								   cpl_cb_collect_ancestry_vector, &path);
+	print(L_DEBUG, "cpl_find_provenance_path --> %d [%d edges]", ret,
+			(int) path.size());
+	CPL_VERIFY(cpl_find_provenance_path, ret);
+	if (with_delays) delay();
+
+	if (path.empty() || path[0].query_object_id != obj
+			|| path.back().other_object_id != obj3
+			|| path.back().other_object_version != 0) {
+		throw CPLException("Invalid provenance path");
+	}
+	for (size_t i = 1; i < path.size(); i++) {
+		if (path[i].query_object_id != path[i-1].other_object_id
+				|| path[i].query_object_version
+					!= path[i-1].other_object_version) {
+			throw CPLException("Invalid provenance path");
+		}
+	}
+
+	path.clear();
+	ret = cpl_find_provenance_path(obj3, 0, obj2, CPL_VERSION_NONE, 0,
+								   cpl_cb_collect_ancestry_vector, &path);
+	print(L_DEBUG, "cpl_find_provenance_path --> %d", ret);
+	if (ret != CPL_S_NO_DATA) CPL_VERIFY(cpl_find_provenance_path, ret);
+	if (ret != CPL_S_NO_DATA || !path.empty()) {
+		throw CPLException("Found a provenance path that does not exist");
+	}
+
+	print(L_DEBUG, " ");
+
+
+	// Ancestor checks, first using the database and then using the
+	// reachability index
+
+	for (int pass = 0; pass < 2; pass++) {
+		int b;
+
+		if (pass == 1) {
+			ret = cpl_enable_reachability_index(NULL);
+			print(L_DEBUG, "cpl_enable_reachability_index --> %d", ret);
+			if (ret != CPL_E_ALREADY_INITIALIZED) {
+				CPL_VERIFY(cpl_enable_reachability_index, ret);
+			}
+		}
+
+		ret = cpl_is_ancestor(obj2, CPL_VERSION_NONE, obj, CPL_VERSION_NONE,
+							  0, &b);
+		print(L_DEBUG, "cpl_is_ancestor --> %d [%d]", ret, b);
+		CPL_VERIFY(cpl_is_ancestor, ret);
+		if (!b) throw CPLException("Missing immediate ancestor");
+
+		ret = cpl_is_ancestor(obj, CPL_VERSION_NONE, obj3, 0, 1, &b);
+		print(L_DEBUG, "cpl_is_ancestor --> %d [%d]", ret, b);
+		CPL_VERIFY(cpl_is_ancestor, ret);
+		if (!b) throw CPLException("Missing transitive ancestor");
+
+		ret = cpl_is_ancestor(obj, CPL_VERSION_NONE, obj2, CPL_VERSION_NONE,
+							  1, &b);
+		print(L_DEBUG, "cpl_is_ancestor --> %d [%d]", ret, b);
+		CPL_VERIFY(cpl_is_ancestor, ret);
+		if (b) throw CPLException("Unexpected transitive ancestor");
+	}
+
+	print(L_DEBUG, " ");
+
+
 	// Properties
 
 	ret = cpl_add_property(obj, "LABEL", "Process A [Proc]");
@@ -912,6 +1477,35 @@ test_simple(void)
 		throw CPLException("The object is missing in the result set.");
 	if (with_delays) delay();
 
+	const char* qlabel[] = { "Process " };
+	const char* qtag[] = { "Goodbye", "Hello" };
+	cpl_property_predicate_t qpred[2] = {
+		{ "LABEL", CPL_PQ_PREFIX, qlabel, 1 },
+		{ "TAG", CPL_PQ_IN, qtag, 2 },
+	};
+
+	std::map<cpl_id_t, unsigned long> qctx;
+	ret = cpl_query_by_properties(ORIGINATOR, "Proc", qpred, 2,
+			cb_lookup_object_ext, &qctx);
+	print(L_DEBUG, "cpl_query_by_properties --> %d [%d]", ret,
+			(int) qctx.size());
+	CPL_VERIFY(cpl_query_by_properties, ret);
+	if (!contains(qctx, obj3))
+		throw CPLException("The object is missing in the result set.");
+	if (contains(qctx, obj))
+		throw CPLException("The result set contains an unexpected object.");
+	if (with_delays) delay();
+
+	qctx.clear();
+	ret = cpl_query_by_properties(ORIGINATOR, "File", qpred, 2,
+			cb_lookup_object_ext, &qctx);
+	print(L_DEBUG, "cpl_query_by_properties --> %d [%d]", ret,
+			(int) qctx.size());
+	if (ret != CPL_E_NOT_FOUND) CPL_VERIFY(cpl_query_by_properties, ret);
+	if (contains(qctx, obj3))
+		throw CPLException("The result set contains an unexpected object.");
+	if (with_delays) delay();
+
 	print(L_DEBUG, " ");
 
 
@@ -952,6 +1546,277 @@ test_simple(void)
 	print(L_DEBUG, " ");
 
 
+	/*
+	 * Result cache
+	 */
+
+	cpl_result_cache_stats_t rcstats;
+
+	ret = cpl_enable_result_cache(1024 * 1024);
+	print(L_DEBUG, "cpl_enable_result_cache --> %d", ret);
+	CPL_VERIFY(cpl_enable_result_cache, ret);
+
+	std::vector<cpl_ancestry_entry_t> rcanc1, rcanc2;
+	ret = cpl_get_object_ancestry(obj3, CPL_VERSION_NONE, CPL_D_ANCESTORS,
+			0, cpl_cb_collect_ancestry_vector, &rcanc1);
+	if (ret != CPL_S_NO_DATA) CPL_VERIFY(cpl_get_object_ancestry, ret);
+	ret = cpl_get_object_ancestry(obj3, CPL_VERSION_NONE, CPL_D_ANCESTORS,
+			0, cpl_cb_collect_ancestry_vector, &rcanc2);
+	if (ret != CPL_S_NO_DATA) CPL_VERIFY(cpl_get_object_ancestry, ret);
+	if (rcanc1.size() != rcanc2.size())
+		throw CPLException("The cached ancestry differs from the original.");
+
+	pctx.clear();
+	ret = cpl_get_properties(obj3, CPL_VERSION_NONE, "TAG",
+			cb_get_properties, &pctx);
+	CPL_VERIFY(cpl_get_properties, ret);
+	pctx.clear();
+	ret = cpl_get_properties(obj3, CPL_VERSION_NONE, "TAG",
+			cb_get_properties, &pctx);
+	CPL_VERIFY(cpl_get_properties, ret);
+	if (!contains(pctx, "TAG", "Hello") || pctx.size() != 1)
+		throw CPLException("The cached properties differ from the original.");
+
+	ret = cpl_get_result_cache_stats(&rcstats);
+	print(L_DEBUG, "cpl_get_result_cache_stats --> %d [%llu hits, "
+			"%llu misses]", ret, rcstats.hits, rcstats.misses);
+	CPL_VERIFY(cpl_get_result_cache_stats, ret);
+	if (rcstats.hits != 2 || rcstats.misses != 2 || rcstats.entries != 2)
+		throw CPLException("Unexpected result cache statistics.");
+
+	ret = cpl_add_property(obj3, "TAG", "Cached");
+	print(L_DEBUG, "cpl_add_property --> %d", ret);
+	CPL_VERIFY(cpl_add_property, ret);
+
+	pctx.clear();
+	ret = cpl_get_properties(obj3, CPL_VERSION_NONE, "TAG",
+			cb_get_properties, &pctx);
+	CPL_VERIFY(cpl_get_properties, ret);
+	if (!contains(pctx, "TAG", "Cached") || pctx.size() != 2)
+		throw CPLException("The result cache returned stale properties.");
+
+	result_cache_thread_context_t rcctx;
+	thread_t rcthreads[RESULT_CACHE_THREADS];
+	rcctx.id = obj3;
+	rcctx.done = false;
+	rcctx.ret = CPL_OK;
+
+	for (int i = 0; i < RESULT_CACHE_THREADS; i++) {
+		if (!thread_create(rcthreads[i], result_cache_reader_thread, &rcctx))
+			throw CPLException("Could not start a result cache thread.");
+	}
+
+	// Each property query after the updates needs to return all of them,
+	// even if a thread tried to cache a result from before the last update
+
+	for (int i = 0; i < RESULT_CACHE_UPDATES && CPL_IS_OK(ret); i++) {
+		char rcvalue[16];
+		snprintf(rcvalue, sizeof(rcvalue), "%d", i);
+		ret = cpl_add_property(obj3, "RC", rcvalue);
+	}
+
+	size_t rcsizes[2] = { 0, 0 };
+	for (int i = 0; i < 2 && CPL_IS_OK(ret); i++) {
+		std::vector<cplxx_property_entry_t> rcprops;
+		ret = cpl_get_properties(obj3, CPL_VERSION_NONE, "RC",
+				cpl_cb_collect_properties_vector, &rcprops);
+		rcsizes[i] = rcprops.size();
+	}
+
+
+	// Disable and enable the cache while the threads are using it
+
+	for (int i = 0; i < RESULT_CACHE_TOGGLES && CPL_IS_OK(ret); i++) {
+		ret = cpl_disable_result_cache();
+		if (CPL_IS_OK(ret)) ret = cpl_enable_result_cache(1024 * 1024);
+	}
+
+	rcctx.done = true;
+	for (int i = 0; i < RESULT_CACHE_THREADS; i++) {
+		thread_join(rcthreads[i]);
+	}
+
+	print(L_DEBUG, "Concurrent result cache use --> %d, queries --> %d "
+			"[%d, %d properties]", ret, rcctx.ret, (int) rcsizes[0],
+			(int) rcsizes[1]);
+	CPL_VERIFY(cpl_add_property, ret);
+	CPL_VERIFY(cpl_get_properties, rcctx.ret);
+	if (rcsizes[0] != RESULT_CACHE_UPDATES
+			|| rcsizes[1] != RESULT_CACHE_UPDATES)
+		throw CPLException("The result cache kept stale properties.");
+
+	ret = cpl_disable_result_cache();
+	print(L_DEBUG, "cpl_disable_result_cache --> %d", ret);
+	CPL_VERIFY(cpl_disable_result_cache, ret);
+	if (with_delays) delay();
+
+	print(L_DEBUG, " ");
+
+
+	/*
+	 * Lineage diff
+	 */
+
+	const char* dnames[] = { "Diff Input 1", "Diff Input 2", "Diff Process",
+		"Diff Output", "Diff Input 1", "Diff Input 3", "Diff Process",
+		"Diff Output" };
+	cpl_id_t dobj[8];
+
+	for (int i = 0; i < 8; i++) {
+		ret = cpl_create_object(ORIGINATOR, dnames[i],
+				i % 4 == 2 ? "Proc" : "File", CPL_NONE, &dobj[i]);
+		CPL_VERIFY(cpl_create_object, ret);
+	}
+
+	ret = cpl_add_property(dobj[0], CPL_P_SHA1, "1111");
+	CPL_VERIFY(cpl_add_property, ret);
+	ret = cpl_add_property(dobj[4], CPL_P_SHA1, "2222");
+	CPL_VERIFY(cpl_add_property, ret);
+
+	for (int i = 0; i < 8; i += 4) {
+		ret = cpl_data_flow(dobj[i + 2], dobj[i], CPL_DATA_INPUT);
+		CPL_VERIFY(cpl_data_flow, ret);
+		ret = cpl_data_flow(dobj[i + 2], dobj[i + 1], CPL_DATA_INPUT);
+		CPL_VERIFY(cpl_data_flow, ret);
+		ret = cpl_data_flow(dobj[i + 3], dobj[i + 2], CPL_DATA_INPUT);
+		CPL_VERIFY(cpl_data_flow, ret);
+	}
+	if (with_delays) delay();
+
+	std::vector<cplxx_diff_entry_t> dv;
+	ret = cpl_diff_lineage(dobj[3], CPL_VERSION_NONE, dobj[7],
+			CPL_VERSION_NONE, cpl_cb_collect_diff_vector, &dv);
+	print(L_DEBUG, "cpl_diff_lineage --> %d [%d]", ret, (int) dv.size());
+	CPL_VERIFY(cpl_diff_lineage, ret);
+
+	int dcount[4] = { 0, 0, 0, 0 };
+	for (size_t i = 0; i < dv.size(); i++) {
+		dcount[dv[i].kind]++;
+		if (dv[i].kind == CPL_DIFF_REMOVED
+				&& (dv[i].name != "Diff Input 2"
+					|| dv[i].left_id != dobj[1]
+					|| dv[i].left_consumer != dobj[2]
+					|| dv[i].right_consumer != dobj[6]))
+			throw CPLException("The diff reported a wrong removed input.");
+		if (dv[i].kind == CPL_DIFF_ADDED
+				&& (dv[i].name != "Diff Input 3"
+					|| dv[i].right_id != dobj[5]))
+			throw CPLException("The diff reported a wrong added input.");
+		if (dv[i].kind == CPL_DIFF_CHANGED && dv[i].left_id == dobj[0]
+				&& (dv[i].right_id != dobj[4]
+					|| dv[i].changes != CPL_DIFF_CONTENT))
+			throw CPLException("The diff reported a wrong changed input.");
+	}
+	if (dcount[CPL_DIFF_ADDED] != 1 || dcount[CPL_DIFF_REMOVED] != 1
+			|| dcount[CPL_DIFF_CHANGED] != 3)
+		throw CPLException("The diff reported unexpected differences.");
+
+	dv.clear();
+	ret = cpl_diff_lineage(dobj[3], CPL_VERSION_NONE, dobj[3],
+			CPL_VERSION_NONE, cpl_cb_collect_diff_vector, &dv);
+	print(L_DEBUG, "cpl_diff_lineage --> %d [%d]", ret, (int) dv.size());
+	if (ret != CPL_S_NO_DATA || !dv.empty())
+		throw CPLException("The diff of identical lineages is not empty.");
+	if (with_delays) delay();
+
+	print(L_DEBUG, " ");
+
+
+	/*
+	 * Path query
+	 */
+
+	std::vector<cplxx_object_info_t> qv;
+	std::string qs = std::string("MATCH (i:File {name:'Diff Input 2', ")
+		+ "originator:'" + ORIGINATOR + "'})<-[:DATA*1..2]-(o:File) RETURN o";
+	ret = cpl_query(qs.c_str(), cpl_cb_collect_object_info_vector, &qv);
+	print(L_DEBUG, "cpl_query --> %d [%d]", ret, (int) qv.size());
+	CPL_VERIFY(cpl_query, ret);
+
+	bool qfound = false;
+	for (size_t i = 0; i < qv.size(); i++) {
+		if (qv[i].id == dobj[3]) qfound = true;
+		if (qv[i].id == dobj[7] || qv[i].name != "Diff Output")
+			throw CPLException("The query returned an unexpected object.");
+	}
+	if (!qfound) throw CPLException("The query did not return the output.");
+
+	// Tag the first input with a property unique to this run, so that the
+	// paths below start from one object, and give its process a controller
+
+	char qrun[64];
+	snprintf(qrun, sizeof(qrun), "%llx:%llx", dobj[0].hi, dobj[0].lo);
+	ret = cpl_add_property(dobj[0], "QUERY_TAG", qrun);
+	CPL_VERIFY(cpl_add_property, ret);
+
+	cpl_id_t qctl;
+	ret = cpl_create_object(ORIGINATOR, "Query Controller", "Proc",
+			CPL_NONE, &qctl);
+	CPL_VERIFY(cpl_create_object, ret);
+	ret = cpl_control_flow(dobj[2], qctl, CPL_CONTROL_START);
+	CPL_VERIFY(cpl_control_flow, ret);
+
+	std::string qi = std::string("(i {QUERY_TAG:'") + qrun + "'})";
+	std::set<cpl_id_t> qids;
+
+	ret = query_ids("MATCH " + qi + " RETURN i", qids);
+	CPL_VERIFY(cpl_query, ret);
+	if (qids.size() != 1 || qids.count(dobj[0]) != 1)
+		throw CPLException("The property filter did not match the input.");
+
+	ret = query_ids("MATCH (o:File)-[:DATA*1..2]->" + qi + " RETURN o", qids);
+	CPL_VERIFY(cpl_query, ret);
+	if (qids.size() != 1 || qids.count(dobj[3]) != 1)
+		throw CPLException("The -> hop did not return the output.");
+
+	ret = query_ids("MATCH (o)-->(p)-->" + qi + " RETURN o", qids);
+	CPL_VERIFY(cpl_query, ret);
+	if (qids.size() != 1 || qids.count(dobj[3]) != 1)
+		throw CPLException("The --> hops did not return the output.");
+
+	ret = query_ids("MATCH " + qi + "<-[*]-(x) RETURN x", qids);
+	CPL_VERIFY(cpl_query, ret);
+	if (qids.size() != 2 || qids.count(dobj[2]) != 1
+			|| qids.count(dobj[3]) != 1)
+		throw CPLException("The * hop returned unexpected objects.");
+
+	ret = query_ids("MATCH " + qi + "<-[*0..]-(x) RETURN x", qids);
+	CPL_VERIFY(cpl_query, ret);
+	if (qids.size() != 3 || qids.count(dobj[0]) != 1
+			|| qids.count(dobj[2]) != 1 || qids.count(dobj[3]) != 1)
+		throw CPLException("The *0.. hop returned unexpected objects.");
+
+	ret = query_ids("MATCH " + qi + "<-[*0..]-(x) RETURN x LIMIT 2", qids);
+	CPL_VERIFY(cpl_query, ret);
+	if (qids.size() != 2)
+		throw CPLException("The query did not respect the limit.");
+
+	ret = query_ids("MATCH " + qi + "<--(p)-[:CONTROL]->(c) RETURN c", qids);
+	CPL_VERIFY(cpl_query, ret);
+	if (qids.size() != 1 || qids.count(qctl) != 1)
+		throw CPLException("The CONTROL hop did not return the controller.");
+
+	ret = query_ids("MATCH " + qi + "<--(p)-[:DATA]->(c) RETURN c", qids);
+	CPL_VERIFY(cpl_query, ret);
+	if (qids.count(qctl) != 0 || qids.count(dobj[0]) != 1)
+		throw CPLException("The DATA hop followed a control dependency.");
+
+	const char* qinvalid[] = {
+		"MATCH (o:File)<-[:DATA*2..1]-() RETURN o",
+		"MATCH (a)-->(a) RETURN a",
+		"MATCH (a {name:'Diff Input 1}) RETURN a",
+	};
+	for (size_t i = 0; i < sizeof(qinvalid) / sizeof(*qinvalid); i++) {
+		ret = query_ids(qinvalid[i], qids);
+		if (ret != CPL_E_INVALID_QUERY)
+			throw CPLException("The query was expected to be invalid: %s",
+					qinvalid[i]);
+	}
+	if (with_delays) delay();
+
+	print(L_DEBUG, " ");
+
+
     /*
      * File API
      */
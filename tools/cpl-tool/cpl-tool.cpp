@@ -61,6 +61,12 @@ char __program_name[2048];
 const char* tool_name = NULL;
 
 
+/**
+ * The database backend
+ */
+cpl_db_backend_t* db_backend = NULL;
+
+
 /**
  * strcasecmp() for Windows
  */
@@ -77,7 +83,12 @@ static struct tool_info TOOLS[] =
 	{"ancestors"   , "List all ancestors of a file"       , tool_ancestors   },
 	{"descendants" , "List all descendants of a file"     , tool_descendants },
 	{"disclose"    , "Disclose data or control flow"      , tool_disclose    },
+	{"export"      , "Export the provenance as N-Triples" , tool_export      },
+	{"import"      , "Import provenance from N-Triples"   , tool_import      },
 	{"info"        , "Print information about the object" , tool_obj_info    },
+	{"ls"          , "List the files with provenance"     , tool_ls          },
+	{"query"       , "Run a path query over the graph"    , tool_query       },
+	{"stats"       , "Print statistics about the graph"   , tool_stats       },
 	//{"move",         "Move one or more files",           NULL              },
 	//{"copy",         "Copy one or more files",           NULL              },
 	{0, 0, 0}
@@ -407,6 +418,8 @@ main(int argc, char** argv)
 			throw CPLException("Failed to initialize the Core Provenance "
 					"Library");
 		}
+
+		db_backend = backend;
 	}
 	catch (std::exception& e) {
 		fprintf(stderr, "%s: %s\n", program_name, e.what());
@@ -425,6 +438,7 @@ main(int argc, char** argv)
 	int r = -1;
 
 	try {
+		optind = 1;		// The tool parses its own options from the start
 		r = tool->func(argc - cpl_argc, argv + cpl_argc);
 	}
 	catch (std::exception& e) {
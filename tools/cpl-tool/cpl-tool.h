@@ -50,6 +50,9 @@ extern const char* program_name;
 /// The tool name
 extern const char* tool_name;
 
+/// The database backend
+extern struct _cpl_db_backend_t* db_backend;
+
 
 /***************************************************************************/
 /** Termcap Variables                                                     **/
@@ -190,6 +193,26 @@ tool_descendants(int argc, char** argv);
 int
 tool_disclose(int argc, char** argv);
 
+/**
+ * Export the provenance graph as N-Triples
+ *
+ * @param argc the number of command-line arguments
+ * @param argv the vector of command-line arguments
+ * @return the exit code
+ */
+int
+tool_export(int argc, char** argv);
+
+/**
+ * Import the provenance graph from N-Triples
+ *
+ * @param argc the number of command-line arguments
+ * @param argv the vector of command-line arguments
+ * @return the exit code
+ */
+int
+tool_import(int argc, char** argv);
+
 /**
  * Print information about the object
  *
@@ -200,5 +223,35 @@ tool_disclose(int argc, char** argv);
 int
 tool_obj_info(int argc, char** argv);
 
+/**
+ * List the files with provenance in a directory
+ *
+ * @param argc the number of command-line arguments
+ * @param argv the vector of command-line arguments
+ * @return the exit code
+ */
+int
+tool_ls(int argc, char** argv);
+
+/**
+ * Run a path query over the provenance graph
+ *
+ * @param argc the number of command-line arguments
+ * @param argv the vector of command-line arguments
+ * @return the exit code
+ */
+int
+tool_query(int argc, char** argv);
+
+/**
+ * Print aggregate statistics about the provenance graph
+ *
+ * @param argc the number of command-line arguments
+ * @param argv the vector of command-line arguments
+ * @return the exit code
+ */
+int
+tool_stats(int argc, char** argv);
+
 #endif
 
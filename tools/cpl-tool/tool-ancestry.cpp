@@ -37,6 +37,8 @@
 
 #include <getopt_compat.h>
 #include <list>
+#include <map>
+#include <set>
 #include <vector>
 
 #include <sys/stat.h>
@@ -69,6 +71,12 @@ static bool verbose = false;
 static bool include_session = false;
 
 
+/**
+ * Whether to print a flat list of nodes and edges instead of a tree
+ */
+static bool flat_list = false;
+
+
 /**
  * Session cache - type
  */
@@ -84,7 +92,7 @@ static session_map_t session_map;
 /**
  * Short command-line options
  */
-static const char* SHORT_OPTIONS = "d:fhRrv";
+static const char* SHORT_OPTIONS = "d:fhlRrv";
 
 
 /**
@@ -94,6 +102,7 @@ static struct option LONG_OPTIONS[] =
 {
 	{"follow",               no_argument,       0, 'f'},
 	{"help",                 no_argument,       0, 'h'},
+	{"list",                 no_argument,       0, 'l'},
 	{"max-depth",            required_argument, 0, 'd'},
 	{"recursive-ancestry",   no_argument,       0, 'f'},
 	{"recursive",            no_argument,       0, 'R'},
@@ -116,6 +125,7 @@ usage(void)
 	P("  -d, --max-depth DEPTH    Set the max depth for the -f/--follow flag");
 	P("  -f, --follow             Follow the ancestry relationships recursively");
 	P("  -h, --help               Print this message and exit");
+	P("  -l, --list               Print a flat list of nodes and edges");
 	P("  -R, -r, --recursive      Traverse the directories recursively");
 	P("  -v, --verbose            Enable verbose mode");
 #undef P
@@ -138,91 +148,281 @@ cb_atexit(void)
 
 
 /**
- * Print a single level of provenance for the given object ID
- * 
- * @param id the provenance object ID
- * @param version the version of the provenance object or CPL_VERSION_NONE
+ * A version node
+ */
+typedef std::pair<cpl_id_t, cpl_version_t> node_t;
+
+
+/**
+ * The traversed part of the provenance graph together with the information
+ * about its objects and sessions
+ */
+struct provenance_graph {
+
+	/// The start node, whose version might be CPL_VERSION_NONE
+	node_t root;
+
+	/// The nodes in the order of their discovery, starting with the root
+	std::vector<node_t> nodes;
+
+	/// The number of each node, which is its index in the nodes vector
+	std::map<node_t, size_t> numbers;
+
+	/// The number of edges that lead to each node
+	std::map<node_t, size_t> in_degree;
+
+	/// The edges from each expanded node, in the order of their discovery
+	std::map<node_t, std::vector<cpl_ancestry_entry_t> > edges;
+
+	/// The object info of each object
+	std::map<cpl_id_t, cpl_object_info_t*> infos;
+
+	/// The session responsible for each version node (if requested)
+	std::map<node_t, cpl_session_info_t*> sessions;
+
+	/**
+	 * Free the object info structures (the session info structures are
+	 * owned by the session cache)
+	 */
+	~provenance_graph() {
+		for (std::map<cpl_id_t, cpl_object_info_t*>::iterator i
+				= infos.begin(); i != infos.end(); i++) {
+			if (i->second != NULL) cpl_free_object_info(i->second);
+		}
+	}
+};
+
+
+/**
+ * Add a node to the graph if it is not already there
+ *
+ * @param g the graph
+ * @param n the node
+ */
+static void
+add_node(provenance_graph& g, const node_t& n)
+{
+	if (g.numbers.find(n) != g.numbers.end()) return;
+	g.numbers[n] = g.nodes.size();
+	g.nodes.push_back(n);
+}
+
+
+/**
+ * The iterator callback for cpl_get_object_lineage() that adds the edge
+ * to the provenance_graph
+ *
+ * @param query_object_id the ID of the object on which we are querying
+ * @param query_object_version the version of the queried object
+ * @param other_object_id the ID of the object on the other end of the
+ *                        dependency/ancestry edge
+ * @param other_object_version the version of the other object
+ * @param type the type of the data or the control dependency
+ * @param context the pointer to the provenance_graph
+ * @return CPL_OK
+ */
+static cpl_return_t
+cb_collect_graph_edge(const cpl_id_t query_object_id,
+					  const cpl_version_t query_object_version,
+					  const cpl_id_t other_object_id,
+					  const cpl_version_t other_object_version,
+					  const int type,
+					  void* context)
+{
+	provenance_graph& g = *((provenance_graph*) context);
+
+	cpl_ancestry_entry_t e;
+	e.query_object_id = query_object_id;
+	e.query_object_version = query_object_version;
+	e.other_object_id = other_object_id;
+	e.other_object_version = other_object_version;
+	e.type = type;
+
+
+	// If we started from all versions of the object, attach their edges
+	// directly to the root
+
+	node_t from(query_object_id, query_object_version);
+	if (g.root.second == CPL_VERSION_NONE && query_object_id == g.root.first) {
+		from = g.root;
+	}
+
+	node_t to(other_object_id, other_object_version);
+	add_node(g, to);
+	g.in_degree[to]++;
+	g.edges[from].push_back(e);
+
+	return CPL_OK;
+}
+
+
+/**
+ * Traverse the provenance graph and fetch the object info, and if needed
+ * also the session info, of all its nodes using batched queries
+ *
+ * @param g the graph with the root already set
  * @param direction CPL_D_ANCESTORS or CPL_D_DESCENDANTS
- * @param levelEnds the vector with boolean values describing whether the
- *                  list of ancestor has been finished at the given level
  * @param maxDepth the maximum depth (-1 to disable)
  */
 static void
-print_provenance(cpl_id_t id, cpl_version_t version, int direction,
-		std::vector<bool> levelEnds, int maxDepth)
+collect_provenance(provenance_graph& g, int direction, int maxDepth)
 {
 	cpl_return_t ret;
 
 
-	// Query the provenance
-	
-	std::list<cpl_ancestry_entry_t> l;
-	ret = cpl_get_object_ancestry(id, version, direction, 0,
-			cpl_cb_collect_ancestry_list, &l);
+	// Traverse the graph, expanding each node only once
+
+	add_node(g, g.root);
+
+	ret = cpl_get_object_lineage(g.root.first, g.root.second, direction,
+			maxDepth < 0 ? 0 : maxDepth, 0, cb_collect_graph_edge, &g);
 	if (!CPL_IS_OK(ret)) {
-		
-		cpl_object_info_t* info;
-		cpl_return_t ret2 = cpl_get_object_info(id, &info);
-		if (!CPL_IS_OK(ret)) {
-			throw CPLException("Could not lookup provenance object %x:%x -- %s",
-					id.hi, id.lo, cpl_error_string(ret2));
+		throw CPLException("Could not look up the %s -- %s",
+				direction == CPL_D_ANCESTORS ? "ancestors" : "descendants",
+				cpl_error_string(ret));
+	}
+
+
+	// Get the object info of all objects at once
+
+	std::vector<cpl_id_t> ids;
+	for (size_t k = 0; k < g.nodes.size(); k++) {
+		if (g.infos.find(g.nodes[k].first) == g.infos.end()) {
+			g.infos[g.nodes[k].first] = NULL;
+			ids.push_back(g.nodes[k].first);
 		}
-		std::string name = info->name;
-		cpl_free_object_info(info);
+	}
 
-		throw CPLException("Could not look up the %s of \"%s\" -- %s",
-				direction == CPL_D_ANCESTORS ? "ancestors" : "descendants",
-				name.c_str(), cpl_error_string(ret));
+	std::vector<cpl_object_info_t*> infos(ids.size(), NULL);
+	ret = cpl_get_object_info_batch(&ids[0], ids.size(), &infos[0]);
+	if (!CPL_IS_OK(ret)) {
+		throw CPLException("Could not lookup the provenance objects -- %s",
+				cpl_error_string(ret));
 	}
+	for (size_t k = 0; k < ids.size(); k++) g.infos[ids[k]] = infos[k];
 
+	if (!include_session) return;
 
-	// Process each ancestry entry
-	
-	for (std::list<cpl_ancestry_entry_t>::iterator next = l.begin();
-			next != l.end();) {
-		std::list<cpl_ancestry_entry_t>::iterator i = next++;
+
+	// Get the version info of all nodes with a known version, including
+	// the query nodes of the edges from the root
+
+	std::set<node_t> node_set;
+	for (size_t k = 0; k < g.nodes.size(); k++) {
+		if (g.nodes[k].second != CPL_VERSION_NONE) node_set.insert(g.nodes[k]);
+	}
+	std::vector<cpl_ancestry_entry_t>& root_edges = g.edges[g.root];
+	for (size_t k = 0; k < root_edges.size(); k++) {
+		node_set.insert(node_t(root_edges[k].query_object_id,
+					root_edges[k].query_object_version));
+	}
+	if (node_set.empty()) return;
+
+	std::vector<cpl_id_version_t> nodes;
+	for (std::set<node_t>::iterator i = node_set.begin();
+			i != node_set.end(); i++) {
+		cpl_id_version_t n;
+		n.id = i->first;
+		n.version = i->second;
+		nodes.push_back(n);
+	}
+
+	std::vector<cpl_version_info_t*> vinfos(nodes.size(), NULL);
+	ret = cpl_get_version_info_batch(&nodes[0], nodes.size(), &vinfos[0]);
+	if (!CPL_IS_OK(ret)) {
+		throw CPLException("Could not lookup the version info -- %s",
+				cpl_error_string(ret));
+	}
 
 
-		// Get the object info
+	// Get the info of the sessions that are not already cached
 
-		cpl_object_info_t* info;
-		ret = cpl_get_object_info(i->other_object_id, &info);
+	std::vector<cpl_session_t> sids;
+	for (size_t k = 0; k < vinfos.size(); k++) {
+		cpl_session_t sid = vinfos[k]->session;
+		if (session_map.find(sid) == session_map.end()) {
+			session_map[sid] = NULL;
+			sids.push_back(sid);
+		}
+	}
+
+	if (!sids.empty()) {
+		std::vector<cpl_session_info_t*> sinfos(sids.size(), NULL);
+		ret = cpl_get_session_info_batch(&sids[0], sids.size(), &sinfos[0]);
 		if (!CPL_IS_OK(ret)) {
-			throw CPLException("Could not lookup provenance object %x:%x -- %s",
-					i->other_object_id.hi, i->other_object_id.lo,
+			for (size_t k = 0; k < sids.size(); k++) {
+				session_map.erase(sids[k]);
+			}
+			for (size_t k = 0; k < vinfos.size(); k++) {
+				cpl_free_version_info(vinfos[k]);
+			}
+			throw CPLException("Could not lookup the session info -- %s",
 					cpl_error_string(ret));
 		}
+		for (size_t k = 0; k < sids.size(); k++) {
+			session_map[sids[k]] = sinfos[k];
+		}
+	}
 
+	for (size_t k = 0; k < vinfos.size(); k++) {
+		g.sessions[node_t(nodes[k].id, nodes[k].version)]
+			= session_map[vinfos[k]->session];
+		cpl_free_version_info(vinfos[k]);
+	}
+}
 
-		// Get the session info (if needed)
 
-		cpl_session_info_t* session = NULL;
-		if (include_session) {
+/**
+ * Print the name of a provenance object
+ *
+ * @param info the object info
+ */
+static void
+print_object_name(const cpl_object_info_t* info)
+{
+	if (strcmp(info->originator, CPL_O_FILESYSTEM) == 0) {
+		printf("%s", info->name);
+		if (strcmp(info->type, CPL_T_FILE) != 0) {
+			printf(" [%s]", info->type);
+		}
+	}
+	else {
+		printf("%s :: %s [%s]", info->originator, info->name, info->type);
+	}
+}
 
-			cpl_version_info_t* vinfo;
-			ret = cpl_get_version_info(i->query_object_id,
-					i->query_object_version, &vinfo);
-			if (!CPL_IS_OK(ret)) {
-				cpl_free_object_info(info);
-				throw CPLException("Could not lookup the version info of "
-						"\"%s\" -- %s", info->name, cpl_error_string(ret));
-			}
-			cpl_session_t sid = vinfo->session;
-			cpl_free_version_info(vinfo);
 
-			session_map_t::iterator j = session_map.find(sid);
-			if (j != session_map.end()) {
-				session = j->second;
-			}
-			else {
-				ret = cpl_get_session_info(sid, &session);
-				if (!CPL_IS_OK(ret)) {
-					throw CPLException("Could not lookup the session info of "
-							"\"%s\" -- %s", info->name, cpl_error_string(ret));
-				}
-				session_map[sid] = session;
-			}
-		}
+/**
+ * Print the provenance tree below the given node. Each node with more than
+ * one incoming edge is expanded only once and marked with its number, and
+ * the subsequent occurrences of the node refer back to it.
+ *
+ * @param g the provenance graph
+ * @param node the node
+ * @param expanded the set of already expanded nodes
+ * @param levelEnds the vector with boolean values describing whether the
+ *                  list of ancestor has been finished at the given level
+ * @param maxDepth the maximum depth below the node (-1 to disable)
+ */
+static void
+print_provenance(provenance_graph& g, const node_t& node,
+		std::set<node_t>& expanded, std::vector<bool>& levelEnds,
+		int maxDepth)
+{
+	std::map<node_t, std::vector<cpl_ancestry_entry_t> >::iterator e
+		= g.edges.find(node);
+	if (e == g.edges.end()) return;
+
+
+	// Process each ancestry entry (the vector does not change while
+	// iterating, since all edges have been already collected)
+
+	std::vector<cpl_ancestry_entry_t>& l = e->second;
+	for (size_t index = 0; index < l.size(); index++) {
+
+		cpl_ancestry_entry_t& i = l[index];
+		bool last = index + 1 == l.size();
+		node_t other(i.other_object_id, i.other_object_version);
 
 
 		// Print
@@ -237,38 +437,41 @@ print_provenance(cpl_id_t id, cpl_version_t version, int direction,
 
 		printf(" %s%s%s%s ",
 				termcap_ac_start,
-				next == l.end() ? termcap_left_bottom_corner : termcap_left_tee,
+				last ? termcap_left_bottom_corner : termcap_left_tee,
 				termcap_horizontal_line,
 				termcap_ac_end);
 
-		if (strcmp(info->originator, CPL_O_FILESYSTEM) == 0) {
-			printf("%s", info->name);
-			if (strcmp(info->type, CPL_T_FILE) != 0) {
-				printf(" [%s]", info->type);
-			}
-		}
-		else {
-			printf("%s :: %s [%s]", info->originator, info->name, info->type);
-		}
-
-		printf(", ver. %d", i->other_object_version);
+		print_object_name(g.infos[i.other_object_id]);
+		printf(", ver. %d", i.other_object_version);
 
 		if (include_session) {
+			cpl_session_info_t* session = g.sessions[node_t(
+					i.query_object_id, i.query_object_version)];
 			printf(", by session command: %s", session->cmdline);
 		}
 
-		printf("\n");
-		
-		cpl_free_object_info(info);
 
+		// Refer back to an already expanded node, or expand it now
+
+		bool expand = maxDepth != 0 && g.edges.find(other) != g.edges.end();
+		bool shared = g.in_degree[other] > 1;
+
+		if (expand && !expanded.insert(other).second) {
+			if (shared) {
+				printf(" (see #%d above)\n", (int) g.numbers[other]);
+			}
+			else {
+				printf(" (see above)\n");
+			}
+			continue;
+		}
 
-		// Call recursively
-		
-		if (recursiveAncestry && maxDepth != 0) {
+		if (expand && shared) printf(" #%d", (int) g.numbers[other]);
+		printf("\n");
 
-			levelEnds.push_back(next == l.end());
-			print_provenance(i->other_object_id, i->other_object_version,
-							 direction, levelEnds,
+		if (expand) {
+			levelEnds.push_back(last);
+			print_provenance(g, other, expanded, levelEnds,
 							 maxDepth > 0 ? maxDepth - 1 : maxDepth);
 			levelEnds.pop_back();
 		}
@@ -276,6 +479,65 @@ print_provenance(cpl_id_t id, cpl_version_t version, int direction,
 }
 
 
+/**
+ * Print the provenance graph as a flat list of nodes and edges, in which
+ * each node and each edge appears only once
+ *
+ * @param g the provenance graph
+ */
+static void
+print_provenance_list(provenance_graph& g)
+{
+	printf("Nodes:\n");
+
+	for (size_t k = 0; k < g.nodes.size(); k++) {
+		node_t& n = g.nodes[k];
+
+		printf("  #%d ", (int) k);
+		print_object_name(g.infos[n.first]);
+		if (n.second != CPL_VERSION_NONE) printf(", ver. %d", n.second);
+
+		if (include_session && g.sessions.find(n) != g.sessions.end()) {
+			printf(", by session command: %s", g.sessions[n]->cmdline);
+		}
+
+		printf("\n");
+	}
+
+	printf("Edges:\n");
+
+	for (size_t k = 0; k < g.nodes.size(); k++) {
+		std::map<node_t, std::vector<cpl_ancestry_entry_t> >::iterator e
+			= g.edges.find(g.nodes[k]);
+		if (e == g.edges.end()) continue;
+
+		std::vector<cpl_ancestry_entry_t>& l = e->second;
+		for (size_t index = 0; index < l.size(); index++) {
+			node_t other(l[index].other_object_id,
+					l[index].other_object_version);
+
+			const char* category;
+			switch (CPL_GET_DEPENDENCY_CATEGORY(l[index].type)) {
+				case CPL_DEPENDENCY_CATEGORY_DATA:
+					category = "data";
+					break;
+				case CPL_DEPENDENCY_CATEGORY_CONTROL:
+					category = "control";
+					break;
+				case CPL_DEPENDENCY_CATEGORY_VERSION:
+					category = "version";
+					break;
+				default:
+					category = "unknown";
+			}
+
+			printf("  #%d -> #%d (%s)\n", (int) k, (int) g.numbers[other],
+					category);
+		}
+	}
+}
+
+
 /**
  * Print a single level of provenance for the given file
  * 
@@ -327,9 +589,22 @@ print_file_provenance(const char* filename, int direction, int maxDepth)
 			printf("\n");
 		}
 
-		std::vector<bool> levelEnds;
-		print_provenance(id, version, direction, levelEnds,
-				maxDepth > 0 ? maxDepth - 1 : maxDepth);
+		provenance_graph g;
+		g.root = node_t(id, version);
+		collect_provenance(g, direction, recursiveAncestry ? maxDepth : 1);
+
+		if (flat_list) {
+			print_provenance_list(g);
+		}
+		else {
+			std::set<node_t> expanded;
+			expanded.insert(g.root);
+
+			std::vector<bool> levelEnds;
+			print_provenance(g, g.root, expanded, levelEnds,
+					!recursiveAncestry ? 0
+					: maxDepth > 0 ? maxDepth - 1 : maxDepth);
+		}
 	}
 	else {
 		printf("\n");
@@ -373,6 +648,10 @@ tool_ancestry(int argc, char** argv, int direction)
 			usage();
 			return 0;
 
+		case 'l':
+			flat_list = true;
+			break;
+
 		case 'r':
 		case 'R':
 			recursive = true;
@@ -0,0 +1,227 @@
+/*
+ * tool-ls.cpp
+ * Core Provenance Library
+ *
+ * Copyright 2012
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#include "stdafx.h"
+#include "cpl-tool.h"
+
+#include <getopt_compat.h>
+#include <list>
+
+using namespace std;
+
+
+/**
+ * Recursive mode
+ */
+static bool recursive = false;
+
+
+/**
+ * Verbose mode
+ */
+static bool verbose = false;
+
+
+/**
+ * Short command-line options
+ */
+static const char* SHORT_OPTIONS = "hRrv";
+
+
+/**
+ * Long command-line options
+ */
+static struct option LONG_OPTIONS[] =
+{
+	{"help",                 no_argument,       0, 'h'},
+	{"recursive",            no_argument,       0, 'R'},
+	{"verbose",              no_argument,       0, 'v'},
+	{0, 0, 0, 0}
+};
+
+
+/**
+ * Print the usage information
+ */
+static void
+usage(void)
+{
+#define P(...) { fprintf(stderr, __VA_ARGS__); fputc('\n', stderr); }
+	P("Usage: %s %s [OPTIONS] DIRECTORY...",
+			program_name, tool_name);
+	P(" ");
+	P("List the files with provenance in the given directories, including");
+	P("the files that no longer exist.");
+	P(" ");
+	P("Options:");
+	P("  -h, --help               Print this message and exit");
+	P("  -R, -r, --recursive      Include the subdirectories");
+	P("  -v, --verbose            Enable verbose mode");
+#undef P
+}
+
+
+/**
+ * Print an object found by the prefix query
+ *
+ * @param info the object info
+ * @param context the pointer to the length of the directory prefix
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cb_list_object(const cpl_object_info_t* info, void* context)
+{
+	size_t prefix_length = *((size_t*) context);
+
+
+	// Skip the contents of the subdirectories unless in the recursive mode
+
+	const char* rest = info->name + prefix_length;
+	if (!recursive && strchr(rest, '/') != NULL) return CPL_OK;
+
+
+	// Print
+
+	if (verbose) {
+		printf("%s\t%s\t%d\t%llx:%llx\n", info->name, info->type,
+				info->version, info->id.hi, info->id.lo);
+	}
+	else {
+		printf("%s\n", info->name);
+	}
+
+	return CPL_OK;
+}
+
+
+/**
+ * List the files with provenance in the given directory
+ *
+ * @param directory the directory name
+ */
+static void
+list_directory(const char* directory)
+{
+	// Get the real path of the directory, which is the form in which
+	// cpl_lookup_file() stores the file names. Fall back to the given path
+	// if the directory no longer exists.
+
+	std::string prefix;
+	char* path = realpath(directory, NULL);
+	if (path != NULL) {
+		prefix = path;
+		free(path);
+	}
+	else if (directory[0] == '/') {
+		prefix = directory;
+	}
+	else {
+		throw CPLException("Could not resolve \"%s\"", directory);
+	}
+
+	if (prefix.empty() || prefix[prefix.length() - 1] != '/') {
+		prefix.push_back('/');
+	}
+
+
+	// Query the name index
+
+	size_t prefix_length = prefix.length();
+	int flags = verbose ? CPL_I_NO_CREATION_SESSION : CPL_I_FAST;
+
+	cpl_return_t ret = cpl_lookup_by_name_prefix(CPL_O_FILESYSTEM,
+			prefix.c_str(), NULL, flags, cb_list_object, &prefix_length);
+	if (ret == CPL_S_NO_DATA) return;
+	if (!CPL_IS_OK(ret)) {
+		throw CPLException("Could not list the provenance of \"%s\" -- %s",
+				directory, cpl_error_string(ret));
+	}
+}
+
+
+/**
+ * List the files with provenance in a directory
+ *
+ * @param argc the number of command-line arguments
+ * @param argv the vector of command-line arguments
+ * @return the exit code
+ */
+int
+tool_ls(int argc, char** argv)
+{
+	// Parse the command-line arguments
+
+	int c, option_index = 0;
+	while ((c = getopt_long(argc, argv, SHORT_OPTIONS,
+							LONG_OPTIONS, &option_index)) >= 0) {
+
+		switch (c) {
+
+		case 'h':
+			usage();
+			return 0;
+
+		case 'r':
+		case 'R':
+			recursive = true;
+			break;
+
+		case 'v':
+			verbose = true;
+			break;
+
+		case '?':
+		case ':':
+			// getopt_long already printed an error message
+			return 1;
+
+		default:
+			abort();
+		}
+	}
+
+
+	// List the current directory if no directories are given
+
+	if (optind >= argc) {
+		list_directory(".");
+		return 0;
+	}
+
+	for (int i = optind; i < argc; i++) {
+		list_directory(argv[i]);
+	}
+
+	return 0;
+}
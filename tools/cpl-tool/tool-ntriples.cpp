@@ -0,0 +1,1402 @@
+/*
+ * tool-session.cpp
+ * Core Provenance Library
+ *
+ * Copyright 2012
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#include "stdafx.h"
+#include "cpl-tool.h"
+
+#include <cpl-db-backend.h>
+#include <getopt_compat.h>
+#include <cctype>
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * The URI of the XSD integer datatype
+ */
+#define XSD_INTEGER		"http://www.w3.org/2001/XMLSchema#integer"
+
+
+/**
+ * The number of objects fetched from the object cursor at a time
+ */
+#define EXPORT_BATCH_SIZE	256
+
+
+/**
+ * Verbose mode
+ */
+static bool verbose = false;
+
+
+/**
+ * The output file for the export (or NULL for stdout)
+ */
+static const char* output_file = NULL;
+
+
+/**
+ * Short command-line options for export
+ */
+static const char* EXPORT_SHORT_OPTIONS = "ho:v";
+
+
+/**
+ * Long command-line options for export
+ */
+static struct option EXPORT_LONG_OPTIONS[] =
+{
+	{"help",                 no_argument,       0, 'h'},
+	{"output",               required_argument, 0, 'o'},
+	{"verbose",              no_argument,       0, 'v'},
+	{0, 0, 0, 0}
+};
+
+
+/**
+ * Short command-line options for import
+ */
+static const char* IMPORT_SHORT_OPTIONS = "hv";
+
+
+/**
+ * Long command-line options for import
+ */
+static struct option IMPORT_LONG_OPTIONS[] =
+{
+	{"help",                 no_argument,       0, 'h'},
+	{"verbose",              no_argument,       0, 'v'},
+	{0, 0, 0, 0}
+};
+
+
+/**
+ * Print the usage information for export
+ */
+static void
+usage_export(void)
+{
+#define P(...) { fprintf(stderr, __VA_ARGS__); fputc('\n', stderr); }
+	P("Usage: %s %s [OPTIONS]", program_name, tool_name);
+	P(" ");
+	P("Export the entire provenance graph as N-Triples, using the same");
+	P("vocabulary as the RDF backend. The output is also valid Turtle.");
+	P(" ");
+	P("Options:");
+	P("  -h, --help               Print this message and exit");
+	P("  -o, --output FILE        Write to the given file instead of stdout");
+	P("  -v, --verbose            Print progress to stderr");
+#undef P
+}
+
+
+/**
+ * Print the usage information for import
+ */
+static void
+usage_import(void)
+{
+#define P(...) { fprintf(stderr, __VA_ARGS__); fputc('\n', stderr); }
+	P("Usage: %s %s [OPTIONS] [FILE]", program_name, tool_name);
+	P(" ");
+	P("Import N-Triples created by the export command, preserving all object");
+	P("and session IDs. Reads from stdin if FILE is missing or \"-\". Creation");
+	P("times are assigned by the target database.");
+	P(" ");
+	P("Each object, version, property, and ancestry edge is written by a");
+	P("separate backend call. The RDF backend buffers these writes, but the");
+	P("ODBC backend commits each of them on its own, so a large import into");
+	P("an ODBC database is limited by the round trips to the server.");
+	P(" ");
+	P("Options:");
+	P("  -h, --help               Print this message and exit");
+	P("  -v, --verbose            Print progress to stderr");
+#undef P
+}
+
+
+
+/***************************************************************************/
+/** Export                                                                **/
+/***************************************************************************/
+
+/**
+ * The export state
+ */
+typedef struct export_context
+{
+	FILE* out;
+	cpl_hash_set_id_t sessions;
+	unsigned long long num_triples;
+	unsigned long long num_objects;
+	const char* error_operation;
+	cpl_return_t error;
+} export_context_t;
+
+
+/**
+ * Format an object ID as an N-Triples term
+ *
+ * @param id the object ID
+ * @return the term
+ */
+static string
+nt_object(const cpl_id_t& id)
+{
+	char buf[64];
+	snprintf(buf, sizeof(buf), "<object:%llx-%llx>", id.hi, id.lo);
+	return buf;
+}
+
+
+/**
+ * Format a version node as an N-Triples term
+ *
+ * @param id the object ID
+ * @param version the version
+ * @return the term
+ */
+static string
+nt_node(const cpl_id_t& id, const cpl_version_t version)
+{
+	char buf[64];
+	snprintf(buf, sizeof(buf), "<node:%llx-%llx-%x>", id.hi, id.lo, version);
+	return buf;
+}
+
+
+/**
+ * Format a session ID as an N-Triples term
+ *
+ * @param id the session ID
+ * @return the term
+ */
+static string
+nt_session(const cpl_session_t& id)
+{
+	char buf[64];
+	snprintf(buf, sizeof(buf), "<session:%llx-%llx>", id.hi, id.lo);
+	return buf;
+}
+
+
+/**
+ * Format an integer as an N-Triples literal
+ *
+ * @param value the value
+ * @return the term
+ */
+static string
+nt_integer(long long value)
+{
+	char buf[96];
+	snprintf(buf, sizeof(buf), "\"%lld\"^^<" XSD_INTEGER ">", value);
+	return buf;
+}
+
+
+/**
+ * Format a string as an N-Triples literal
+ *
+ * @param str the string (NULL is treated as an empty string)
+ * @return the term
+ */
+static string
+nt_string(const char* str)
+{
+	string r = "\"";
+	if (str == NULL) str = "";
+
+	for (const unsigned char* p = (const unsigned char*) str; *p; p++) {
+		switch (*p) {
+			case '\t': r += "\\t"; break;
+			case '\b': r += "\\b"; break;
+			case '\n': r += "\\n"; break;
+			case '\r': r += "\\r"; break;
+			case '\f': r += "\\f"; break;
+			case '\"': r += "\\\""; break;
+			case '\\': r += "\\\\"; break;
+			default:
+				if (*p < 0x20 || *p == 0x7f) {
+					char buf[8];
+					snprintf(buf, sizeof(buf), "\\u%04X", *p);
+					r += buf;
+				}
+				else {
+					r += (char) *p;
+				}
+		}
+	}
+
+	r += "\"";
+	return r;
+}
+
+
+/**
+ * Write a triple
+ *
+ * @param ctx the export context
+ * @param s the subject
+ * @param p the predicate
+ * @param o the object
+ */
+static void
+write_triple(export_context_t* ctx, const string& s, const char* p,
+		const string& o)
+{
+	fprintf(ctx->out, "%s <%s> %s .\n", s.c_str(), p, o.c_str());
+	ctx->num_triples++;
+}
+
+
+/**
+ * The iterator callback for exporting properties
+ *
+ * @param id the object ID
+ * @param version the object version
+ * @param key the property name
+ * @param value the property value
+ * @param context the export context
+ * @return CPL_OK
+ */
+static cpl_return_t
+cb_export_property(const cpl_id_t id, const cpl_version_t version,
+		const char* key, const char* value, void* context)
+{
+	export_context_t* ctx = (export_context_t*) context;
+
+	string predicate = "custom:";
+	for (const unsigned char* p = (const unsigned char*) key; *p; p++) {
+		char buf[4];
+		snprintf(buf, sizeof(buf), "%02x", *p);
+		predicate += buf;
+	}
+
+	write_triple(ctx, nt_node(id, version), predicate.c_str(),
+			nt_string(value));
+	return CPL_OK;
+}
+
+
+/**
+ * The iterator callback that exports an object together with its versions,
+ * their properties, and the sessions that created them
+ *
+ * @param info the object info
+ * @param context the export context
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cb_export_object(const cpl_object_info_t* info, void* context)
+{
+	export_context_t* ctx = (export_context_t*) context;
+	cpl_return_t ret;
+
+
+	// Get the versions and write the sessions that we have not seen yet
+
+	vector<cpl_version_info_t> versions;
+
+	for (cpl_version_t v = 0; v <= info->version; v++) {
+
+		cpl_version_info_t* vinfo;
+		ret = cpl_get_version_info(info->id, v, &vinfo);
+		if (!CPL_IS_OK(ret)) {
+			ctx->error_operation = "get the version info";
+			return ctx->error = ret;
+		}
+		versions.push_back(*vinfo);
+		cpl_free_version_info(vinfo);
+
+		cpl_session_t sid = versions.back().session;
+		if (ctx->sessions.find(sid) != ctx->sessions.end()) continue;
+
+		cpl_session_info_t* s;
+		ret = cpl_get_session_info(sid, &s);
+		if (!CPL_IS_OK(ret)) {
+			ctx->error_operation = "get the session info";
+			return ctx->error = ret;
+		}
+
+		string subject = nt_session(sid);
+		write_triple(ctx, subject, "prop:mac_address",
+				nt_string(s->mac_address));
+		write_triple(ctx, subject, "prop:username", nt_string(s->user));
+		write_triple(ctx, subject, "prop:pid", nt_integer(s->pid));
+		write_triple(ctx, subject, "prop:program", nt_string(s->program));
+		write_triple(ctx, subject, "prop:cmdline", nt_string(s->cmdline));
+		write_triple(ctx, subject, "prop:initialization_time",
+				nt_integer(s->start_time));
+
+		cpl_free_session_info(s);
+		ctx->sessions.insert(sid);
+	}
+
+
+	// Write the object
+
+	string subject = nt_object(info->id);
+	write_triple(ctx, subject, "prop:originator", nt_string(info->originator));
+	write_triple(ctx, subject, "prop:name", nt_string(info->name));
+	write_triple(ctx, subject, "prop:type", nt_string(info->type));
+	if (info->container_id != CPL_NONE) {
+		write_triple(ctx, subject, "rel:container",
+				nt_node(info->container_id, info->container_version));
+	}
+	write_triple(ctx, subject, "prop:creation_time",
+			nt_integer(info->creation_time));
+
+
+	// Write the versions
+
+	for (size_t i = 0; i < versions.size(); i++) {
+		string node = nt_node(info->id, versions[i].version);
+		write_triple(ctx, subject, "rel:version", node);
+		write_triple(ctx, node, "rel:session",
+				nt_session(versions[i].session));
+		write_triple(ctx, node, "prop:version",
+				nt_integer(versions[i].version));
+		write_triple(ctx, node, "prop:creation_time",
+				nt_integer(versions[i].creation_time));
+	}
+
+
+	// Write the properties
+
+	ret = cpl_get_properties(info->id, CPL_VERSION_NONE, NULL,
+			cb_export_property, ctx);
+	if (!CPL_IS_OK(ret)) {
+		ctx->error_operation = "get the properties";
+		return ctx->error = ret;
+	}
+
+	ctx->num_objects++;
+	if (verbose && ctx->num_objects % 10000 == 0) {
+		fprintf(stderr, "%s %s: %llu objects, %llu triples\n", program_name,
+				tool_name, ctx->num_objects, ctx->num_triples);
+	}
+
+	return CPL_OK;
+}
+
+
+/**
+ * The iterator callback for exporting ancestry edges
+ *
+ * @param query_object_id the ID of the object on which we are querying
+ * @param query_object_version the version of the queried object
+ * @param other_object_id the ID of the object on the other end of the
+ *                        dependency/ancestry edge
+ * @param other_object_version the version of the other object
+ * @param type the type of the data or control dependency
+ * @param context the export context
+ * @return CPL_OK
+ */
+static cpl_return_t
+cb_export_edge(const cpl_id_t query_object_id,
+		const cpl_version_t query_object_version,
+		const cpl_id_t other_object_id,
+		const cpl_version_t other_object_version,
+		const int type, void* context)
+{
+	export_context_t* ctx = (export_context_t*) context;
+
+	char predicate[32];
+	snprintf(predicate, sizeof(predicate), "input:%x", type);
+
+	write_triple(ctx, nt_node(query_object_id, query_object_version),
+			predicate, nt_node(other_object_id, other_object_version));
+	return CPL_OK;
+}
+
+
+/**
+ * The iterator callback that exports the ancestry edges of an object
+ *
+ * @param info the object info
+ * @param context the export context
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+cb_export_object_edges(const cpl_object_info_t* info, void* context)
+{
+	export_context_t* ctx = (export_context_t*) context;
+
+	cpl_return_t ret = cpl_get_object_ancestry(info->id, CPL_VERSION_NONE,
+			CPL_D_ANCESTORS, 0, cb_export_edge, ctx);
+	if (!CPL_IS_OK(ret)) {
+		ctx->error_operation = "get the ancestry";
+		return ctx->error = ret;
+	}
+
+	return CPL_OK;
+}
+
+
+/**
+ * Call the given export callback for each object in the database, fetching
+ * the objects from a cursor in batches of EXPORT_BATCH_SIZE, so that only
+ * one batch is held in memory at a time
+ *
+ * @param flags a logical combination of CPL_I_* flags
+ * @param callback the export callback
+ * @param ctx the export context
+ * @return CPL_OK or an error code
+ */
+static cpl_return_t
+export_all_objects(const int flags, cpl_object_info_iterator_t callback,
+				   export_context_t* ctx)
+{
+	cpl_cursor_t* cursor = NULL;
+	cpl_return_t ret = cpl_open_object_cursor(NULL, NULL, flags, &cursor);
+	if (!CPL_IS_OK(ret)) return ret;
+
+	cpl_object_info_t* infos[EXPORT_BATCH_SIZE];
+	size_t count = 0;
+
+	while (true) {
+		ret = cpl_cursor_fetch_objects(cursor, EXPORT_BATCH_SIZE, infos,
+				&count);
+		if (ret == CPL_S_NO_DATA) {
+			ret = CPL_OK;
+			break;
+		}
+		if (!CPL_IS_OK(ret)) break;
+
+		size_t i = 0;
+		for (; i < count && CPL_IS_OK(ret); i++) {
+			ret = callback(infos[i], ctx);
+			cpl_free_object_info(infos[i]);
+		}
+		for (; i < count; i++) cpl_free_object_info(infos[i]);
+		if (!CPL_IS_OK(ret)) break;
+	}
+
+	cpl_close_cursor(cursor);
+	return ret;
+}
+
+
+/**
+ * Export the provenance graph as N-Triples
+ *
+ * @param argc the number of command-line arguments
+ * @param argv the vector of command-line arguments
+ * @return the exit code
+ */
+int
+tool_export(int argc, char** argv)
+{
+	// Parse the command-line arguments
+
+	int c, option_index = 0;
+	while ((c = getopt_long(argc, argv, EXPORT_SHORT_OPTIONS,
+							EXPORT_LONG_OPTIONS, &option_index)) >= 0) {
+
+		switch (c) {
+
+		case 'h':
+			usage_export();
+			return 0;
+
+		case 'o':
+			output_file = optarg;
+			break;
+
+		case 'v':
+			verbose = true;
+			break;
+
+		case '?':
+		case ':':
+			// getopt_long already printed an error message
+			return 1;
+
+		default:
+			abort();
+		}
+	}
+
+	if (optind < argc) {
+		usage_export();
+		return 1;
+	}
+
+
+	// Open the output file
+
+	export_context_t ctx;
+	ctx.out = stdout;
+	ctx.num_triples = 0;
+	ctx.num_objects = 0;
+	ctx.error_operation = NULL;
+	ctx.error = CPL_OK;
+
+	if (output_file != NULL && strcmp(output_file, "-") != 0) {
+		ctx.out = fopen(output_file, "w");
+		if (ctx.out == NULL) {
+			throw CPLException("Cannot open \"%s\" for writing -- %s",
+					output_file, strerror(errno));
+		}
+	}
+
+
+	// Write the sessions, objects, versions, and properties first, and the
+	// ancestry edges after all objects, so that the file can be imported
+	// in a single pass. Both passes page through the objects using a
+	// cursor, so only one batch of objects and the set of the already
+	// written session IDs are held in memory.
+
+	cpl_return_t ret = export_all_objects(0, cb_export_object, &ctx);
+	if (CPL_IS_OK(ret)) {
+		ret = export_all_objects(CPL_I_FAST, cb_export_object_edges, &ctx);
+	}
+
+	bool write_error = ferror(ctx.out) != 0;
+	if (ctx.out != stdout) {
+		if (fclose(ctx.out) != 0) write_error = true;
+	}
+	else {
+		if (fflush(ctx.out) != 0) write_error = true;
+	}
+
+	if (!CPL_IS_OK(ret)) {
+		if (ctx.error_operation != NULL) {
+			throw CPLException("Could not %s -- %s", ctx.error_operation,
+					cpl_error_string(ctx.error));
+		}
+		throw CPLException("Could not list the objects -- %s",
+				cpl_error_string(ret));
+	}
+	if (write_error) {
+		throw CPLException("Could not write the output -- %s",
+				strerror(errno));
+	}
+
+	if (verbose) {
+		fprintf(stderr, "%s %s: Exported %llu objects (%llu triples).\n",
+				program_name, tool_name, ctx.num_objects, ctx.num_triples);
+	}
+
+	return 0;
+}
+
+
+
+/***************************************************************************/
+/** Import                                                                **/
+/***************************************************************************/
+
+/**
+ * A parsed triple
+ */
+typedef struct nt_triple
+{
+	string subject;
+	string predicate;
+	string object;
+	bool object_is_literal;
+	string datatype;
+} nt_triple_t;
+
+
+/**
+ * A version node waiting to be imported
+ */
+typedef struct import_node
+{
+	bool has_session;
+	cpl_session_t session;
+	vector<pair<string, string> > properties;
+} import_node_t;
+
+
+/**
+ * An object waiting to be imported, together with its versions
+ */
+typedef struct import_object
+{
+	cpl_id_t id;
+	bool has_object;
+	string originator;
+	string name;
+	string type;
+	cpl_id_t container_id;
+	cpl_version_t container_version;
+	map<cpl_version_t, import_node_t> nodes;
+} import_object_t;
+
+
+/**
+ * A session waiting to be imported
+ */
+typedef struct import_session
+{
+	cpl_session_t id;
+	string mac_address;
+	string user;
+	int pid;
+	string program;
+	string cmdline;
+} import_session_t;
+
+
+/**
+ * The objects waiting for their container to be imported
+ */
+typedef map<pair<cpl_id_t, cpl_version_t>, list<import_object_t> >
+	import_pending_map_t;
+
+
+/**
+ * The import state
+ */
+typedef struct import_context
+{
+	unsigned long line;
+
+	bool has_session;
+	import_session_t session;
+
+	bool has_object;
+	import_object_t object;
+
+	import_pending_map_t pending;
+	size_t num_pending;
+
+	cpl_hash_map_id_t<cpl_version_t>::type imported;
+
+	unsigned long long num_triples;
+	unsigned long long num_sessions;
+	unsigned long long num_objects;
+	unsigned long long num_edges;
+} import_context_t;
+
+
+/**
+ * Read a line of any length
+ *
+ * @param f the input file
+ * @param line the string to store the line (without the end of line)
+ * @return true if a line was read, or false on the end of the file
+ */
+static bool
+read_line(FILE* f, string& line)
+{
+	char buf[4096];
+	line.clear();
+
+	while (fgets(buf, sizeof(buf), f) != NULL) {
+		size_t l = strlen(buf);
+		if (l > 0 && buf[l - 1] == '\n') {
+			line.append(buf, l - 1);
+			if (!line.empty() && line[line.length() - 1] == '\r') {
+				line.erase(line.length() - 1);
+			}
+			return true;
+		}
+		line.append(buf, l);
+	}
+
+	return !line.empty();
+}
+
+
+/**
+ * Append a Unicode code point encoded as UTF-8
+ *
+ * @param out the output string
+ * @param cp the code point
+ */
+static void
+append_utf8(string& out, unsigned long cp)
+{
+	if (cp < 0x80) {
+		out += (char) cp;
+	}
+	else if (cp < 0x800) {
+		out += (char) (0xc0 | (cp >> 6));
+		out += (char) (0x80 | (cp & 0x3f));
+	}
+	else if (cp < 0x10000) {
+		out += (char) (0xe0 | (cp >> 12));
+		out += (char) (0x80 | ((cp >> 6) & 0x3f));
+		out += (char) (0x80 | (cp & 0x3f));
+	}
+	else {
+		out += (char) (0xf0 | (cp >> 18));
+		out += (char) (0x80 | ((cp >> 12) & 0x3f));
+		out += (char) (0x80 | ((cp >> 6) & 0x3f));
+		out += (char) (0x80 | (cp & 0x3f));
+	}
+}
+
+
+/**
+ * Parse an N-Triples term
+ *
+ * @param p the pointer to the parse position, which will be advanced
+ * @param out the string to store the IRI or the literal value
+ * @param out_literal the pointer to store whether the term is a literal
+ * @param out_datatype the string to store the literal datatype (can be NULL)
+ * @return true if the term was parsed successfully
+ */
+static bool
+parse_term(const char*& p, string& out, bool* out_literal,
+		string* out_datatype)
+{
+	while (*p == ' ' || *p == '\t') p++;
+	out.clear();
+	if (out_datatype != NULL) out_datatype->clear();
+
+
+	// IRI
+
+	if (*p == '<') {
+		const char* end = strchr(p + 1, '>');
+		if (end == NULL) return false;
+		out.assign(p + 1, end - p - 1);
+		p = end + 1;
+		*out_literal = false;
+		return true;
+	}
+
+
+	// Literal
+
+	if (*p != '\"') return false;
+	*out_literal = true;
+
+	for (p++; *p != '\"'; p++) {
+		if (*p == '\0') return false;
+		if (*p != '\\') {
+			out += *p;
+			continue;
+		}
+
+		p++;
+		switch (*p) {
+			case 't' : out += '\t'; break;
+			case 'b' : out += '\b'; break;
+			case 'n' : out += '\n'; break;
+			case 'r' : out += '\r'; break;
+			case 'f' : out += '\f'; break;
+			case '\"': out += '\"'; break;
+			case '\'': out += '\''; break;
+			case '\\': out += '\\'; break;
+			case 'u' :
+			case 'U' : {
+					int digits = *p == 'u' ? 4 : 8;
+					unsigned long cp = 0;
+					for (int i = 0; i < digits; i++) {
+						char c = *++p;
+						cp <<= 4;
+						if (c >= '0' && c <= '9') cp |= c - '0';
+						else if (c >= 'a' && c <= 'f') cp |= c - 'a' + 10;
+						else if (c >= 'A' && c <= 'F') cp |= c - 'A' + 10;
+						else return false;
+					}
+					append_utf8(out, cp);
+				}
+				break;
+			default:
+				return false;
+		}
+	}
+	p++;
+
+
+	// Datatype or language tag
+
+	if (p[0] == '^' && p[1] == '^' && p[2] == '<') {
+		const char* end = strchr(p + 3, '>');
+		if (end == NULL) return false;
+		if (out_datatype != NULL) out_datatype->assign(p + 3, end - p - 3);
+		p = end + 1;
+	}
+	else if (*p == '@') {
+		for (p++; isalnum(*p) || *p == '-'; p++) ;
+	}
+
+	return true;
+}
+
+
+/**
+ * Parse a line with a triple
+ *
+ * @param line the line
+ * @param t the triple to store the result
+ * @param line_number the line number (for error messages)
+ * @return true if the line contains a triple, false if it is empty or
+ *         a comment
+ * @throws CPLException if the line is malformed
+ */
+static bool
+parse_triple(const string& line, nt_triple_t& t, unsigned long line_number)
+{
+	const char* p = line.c_str();
+	bool literal;
+
+	while (*p == ' ' || *p == '\t') p++;
+	if (*p == '\0' || *p == '#') return false;
+
+	if (!parse_term(p, t.subject, &literal, NULL) || literal
+			|| !parse_term(p, t.predicate, &literal, NULL) || literal
+			|| !parse_term(p, t.object, &t.object_is_literal, &t.datatype)) {
+		throw CPLException("Line %lu: Malformed or unsupported triple",
+				line_number);
+	}
+
+	while (*p == ' ' || *p == '\t') p++;
+	if (*p != '.') {
+		throw CPLException("Line %lu: Expected \".\"", line_number);
+	}
+
+	return true;
+}
+
+
+/**
+ * Parse an object ID from an IRI
+ *
+ * @param iri the IRI
+ * @param out the pointer to store the ID
+ * @return true if the IRI is an object IRI
+ */
+static inline bool
+parse_object_iri(const string& iri, cpl_id_t* out)
+{
+	return sscanf(iri.c_str(), "object:%llx-%llx", &out->hi, &out->lo) == 2;
+}
+
+
+/**
+ * Parse a version node from an IRI
+ *
+ * @param iri the IRI
+ * @param out_id the pointer to store the object ID
+ * @param out_version the pointer to store the version
+ * @return true if the IRI is a node IRI
+ */
+static inline bool
+parse_node_iri(const string& iri, cpl_id_t* out_id,
+		cpl_version_t* out_version)
+{
+	return sscanf(iri.c_str(), "node:%llx-%llx-%x",
+			&out_id->hi, &out_id->lo, out_version) == 3;
+}
+
+
+/**
+ * Parse a session ID from an IRI
+ *
+ * @param iri the IRI
+ * @param out the pointer to store the ID
+ * @return true if the IRI is a session IRI
+ */
+static inline bool
+parse_session_iri(const string& iri, cpl_session_t* out)
+{
+	return sscanf(iri.c_str(), "session:%llx-%llx", &out->hi, &out->lo) == 2;
+}
+
+
+/**
+ * Decode a hex-encoded property key
+ *
+ * @param hex the hex-encoded string
+ * @param out the string to store the result
+ * @return true on success
+ */
+static bool
+unhex(const char* hex, string& out)
+{
+	out.clear();
+	size_t l = strlen(hex);
+	if (l % 2 != 0) return false;
+
+	for (size_t i = 0; i < l; i += 2) {
+		unsigned int c;
+		if (sscanf(hex + i, "%2x", &c) != 1) return false;
+		out += (char) c;
+	}
+
+	return true;
+}
+
+
+/**
+ * Verify the result of a backend call
+ *
+ * @param ret the return code
+ * @param what the description of the operation
+ * @param id the object or session ID
+ */
+static void
+import_verify(cpl_return_t ret, const char* what, const cpl_id_t& id)
+{
+	if (!CPL_IS_OK(ret)) {
+		throw CPLException("Could not %s %llx:%llx -- %s", what,
+				id.hi, id.lo, cpl_error_string(ret));
+	}
+}
+
+
+/**
+ * Import the pending session
+ *
+ * @param ctx the import context
+ */
+static void
+finish_session(import_context_t* ctx)
+{
+	if (!ctx->has_session) return;
+	import_session_t& s = ctx->session;
+
+	cpl_return_t ret = db_backend->cpl_db_create_session(db_backend, s.id,
+			s.mac_address.c_str(), s.user.c_str(), s.pid,
+			s.program.c_str(), s.cmdline.c_str());
+	import_verify(ret, "create session", s.id);
+
+	ctx->has_session = false;
+	ctx->num_sessions++;
+}
+
+
+/**
+ * Import an object, its versions, and its properties, and then all
+ * objects that were waiting for it as their container
+ *
+ * @param ctx the import context
+ * @param o the object
+ */
+static void
+import_object(import_context_t* ctx, import_object_t& o)
+{
+	cpl_return_t ret;
+
+
+	// Wait for the container if it was not imported yet. The containers
+	// imported by this run are checked without querying the database,
+	// which would flush the write buffer of the RDF backend.
+
+	if (o.has_object && o.container_id != CPL_NONE) {
+		cpl_hash_map_id_t<cpl_version_t>::type::iterator c
+			= ctx->imported.find(o.container_id);
+		if (c == ctx->imported.end() || c->second < o.container_version) {
+			cpl_version_info_t* info;
+			ret = cpl_get_version_info(o.container_id, o.container_version,
+					&info);
+			if (ret == CPL_E_NOT_FOUND) {
+				pair<cpl_id_t, cpl_version_t> key(o.container_id,
+						o.container_version);
+				ctx->pending[key].push_back(o);
+				ctx->num_pending++;
+				return;
+			}
+			import_verify(ret, "look up the container of", o.id);
+			cpl_free_version_info(info);
+		}
+	}
+
+
+	// Create the object and its versions
+
+	map<cpl_version_t, import_node_t>::iterator i;
+	cpl_version_t last = CPL_VERSION_NONE;
+
+	if (o.has_object) {
+		i = o.nodes.find(0);
+		if (i == o.nodes.end() || !i->second.has_session) {
+			throw CPLException("Object %llx:%llx does not have a session for "
+					"version 0", o.id.hi, o.id.lo);
+		}
+
+		ret = db_backend->cpl_db_create_object(db_backend, o.id,
+				o.originator.c_str(), o.name.c_str(), o.type.c_str(),
+				o.container_id, o.container_version, i->second.session);
+		import_verify(ret, "create object", o.id);
+		ctx->num_objects++;
+		last = 0;
+	}
+
+	for (i = o.nodes.begin(); i != o.nodes.end(); i++) {
+		if (i->first == 0 || !i->second.has_session) continue;
+		ret = db_backend->cpl_db_create_version(db_backend, o.id, i->first,
+				i->second.session);
+		import_verify(ret, "create a version of", o.id);
+		last = i->first;
+	}
+
+	for (i = o.nodes.begin(); i != o.nodes.end(); i++) {
+		vector<pair<string, string> >& properties = i->second.properties;
+		for (size_t j = 0; j < properties.size(); j++) {
+			ret = db_backend->cpl_db_add_property(db_backend, o.id, i->first,
+					properties[j].first.c_str(), properties[j].second.c_str());
+			import_verify(ret, "add a property to", o.id);
+		}
+	}
+
+	// Remember the last imported version for the objects inside it
+
+	if (last != CPL_VERSION_NONE) {
+		cpl_hash_map_id_t<cpl_version_t>::type::iterator c
+			= ctx->imported.find(o.id);
+		if (c == ctx->imported.end()) ctx->imported[o.id] = last;
+		else if (c->second < last) c->second = last;
+	}
+
+
+	// Import the objects that were waiting for this one
+
+	for (i = o.nodes.begin(); i != o.nodes.end(); i++) {
+		pair<cpl_id_t, cpl_version_t> key(o.id, i->first);
+		import_pending_map_t::iterator p = ctx->pending.find(key);
+		if (p == ctx->pending.end()) continue;
+
+		list<import_object_t> waiting;
+		waiting.swap(p->second);
+		ctx->pending.erase(p);
+
+		for (list<import_object_t>::iterator w = waiting.begin();
+				w != waiting.end(); w++) {
+			ctx->num_pending--;
+			import_object(ctx, *w);
+		}
+	}
+}
+
+
+/**
+ * Import the pending object
+ *
+ * @param ctx the import context
+ */
+static void
+finish_object(import_context_t* ctx)
+{
+	if (!ctx->has_object) return;
+	ctx->has_object = false;
+	import_object(ctx, ctx->object);
+}
+
+
+/**
+ * Get the pending object record for the given object ID, importing the
+ * previous record if it belongs to a different object
+ *
+ * @param ctx the import context
+ * @param id the object ID
+ * @return the object record
+ */
+static import_object_t&
+get_object_record(import_context_t* ctx, const cpl_id_t& id)
+{
+	if (ctx->has_object && ctx->object.id == id) return ctx->object;
+
+	finish_session(ctx);
+	finish_object(ctx);
+
+	ctx->has_object = true;
+	ctx->object.id = id;
+	ctx->object.has_object = false;
+	ctx->object.originator.clear();
+	ctx->object.name.clear();
+	ctx->object.type.clear();
+	ctx->object.container_id = CPL_NONE;
+	ctx->object.container_version = CPL_VERSION_NONE;
+	ctx->object.nodes.clear();
+
+	return ctx->object;
+}
+
+
+/**
+ * Get the version node record for the given node
+ *
+ * @param ctx the import context
+ * @param id the object ID
+ * @param version the version
+ * @return the node record
+ */
+static import_node_t&
+get_node_record(import_context_t* ctx, const cpl_id_t& id,
+		const cpl_version_t version)
+{
+	import_object_t& o = get_object_record(ctx, id);
+
+	map<cpl_version_t, import_node_t>::iterator i = o.nodes.find(version);
+	if (i != o.nodes.end()) return i->second;
+
+	import_node_t& n = o.nodes[version];
+	n.has_session = false;
+	n.session = CPL_NONE;
+	return n;
+}
+
+
+/**
+ * Import a triple
+ *
+ * @param ctx the import context
+ * @param t the triple
+ */
+static void
+import_triple(import_context_t* ctx, const nt_triple_t& t)
+{
+	const string& p = t.predicate;
+	cpl_id_t id;
+	cpl_version_t version;
+	ctx->num_triples++;
+
+
+	// Session
+
+	cpl_session_t sid;
+	if (parse_session_iri(t.subject, &sid)) {
+		if (!ctx->has_session || ctx->session.id != sid) {
+			finish_session(ctx);
+			finish_object(ctx);
+
+			ctx->has_session = true;
+			ctx->session.id = sid;
+			ctx->session.mac_address.clear();
+			ctx->session.user.clear();
+			ctx->session.pid = 0;
+			ctx->session.program.clear();
+			ctx->session.cmdline.clear();
+		}
+
+		import_session_t& s = ctx->session;
+		if (p == "prop:mac_address") s.mac_address = t.object;
+		else if (p == "prop:username") s.user = t.object;
+		else if (p == "prop:pid") s.pid = atoi(t.object.c_str());
+		else if (p == "prop:program") s.program = t.object;
+		else if (p == "prop:cmdline") s.cmdline = t.object;
+		return;
+	}
+
+
+	// Object
+
+	if (parse_object_iri(t.subject, &id)) {
+		import_object_t& o = get_object_record(ctx, id);
+		o.has_object = true;
+
+		if (p == "prop:originator") o.originator = t.object;
+		else if (p == "prop:name") o.name = t.object;
+		else if (p == "prop:type") o.type = t.object;
+		else if (p == "rel:container") {
+			if (!parse_node_iri(t.object, &o.container_id,
+						&o.container_version)) {
+				throw CPLException("Line %lu: Invalid container", ctx->line);
+			}
+		}
+		return;
+	}
+
+
+	// Version node
+
+	if (!parse_node_iri(t.subject, &id, &version)) {
+		throw CPLException("Line %lu: Unsupported subject <%s>",
+				ctx->line, t.subject.c_str());
+	}
+
+	if (p.compare(0, 6, "input:") == 0) {
+
+		// Ancestry edges refer to two objects, so import all pending
+		// records first
+
+		finish_session(ctx);
+		finish_object(ctx);
+
+		cpl_id_t to_id;
+		cpl_version_t to_version;
+		unsigned type;
+		if (sscanf(p.c_str(), "input:%x", &type) != 1
+				|| !parse_node_iri(t.object, &to_id, &to_version)) {
+			throw CPLException("Line %lu: Invalid ancestry edge", ctx->line);
+		}
+
+		cpl_return_t ret = db_backend->cpl_db_add_ancestry_edge(db_backend,
+				id, version, to_id, to_version, (int) type);
+		import_verify(ret, "add an ancestry edge to", id);
+		ctx->num_edges++;
+		return;
+	}
+
+	if (p == "rel:session") {
+		import_node_t& n = get_node_record(ctx, id, version);
+		if (!parse_session_iri(t.object, &n.session)) {
+			throw CPLException("Line %lu: Invalid session", ctx->line);
+		}
+		n.has_session = true;
+	}
+	else if (p.compare(0, 7, "custom:") == 0) {
+		import_node_t& n = get_node_record(ctx, id, version);
+		string key;
+		if (!unhex(p.c_str() + 7, key)) {
+			throw CPLException("Line %lu: Invalid property key", ctx->line);
+		}
+		n.properties.push_back(pair<string, string>(key, t.object));
+	}
+}
+
+
+/**
+ * Import the provenance graph from N-Triples
+ *
+ * @param argc the number of command-line arguments
+ * @param argv the vector of command-line arguments
+ * @return the exit code
+ */
+int
+tool_import(int argc, char** argv)
+{
+	// Parse the command-line arguments
+
+	int c, option_index = 0;
+	while ((c = getopt_long(argc, argv, IMPORT_SHORT_OPTIONS,
+							IMPORT_LONG_OPTIONS, &option_index)) >= 0) {
+
+		switch (c) {
+
+		case 'h':
+			usage_import();
+			return 0;
+
+		case 'v':
+			verbose = true;
+			break;
+
+		case '?':
+		case ':':
+			// getopt_long already printed an error message
+			return 1;
+
+		default:
+			abort();
+		}
+	}
+
+	if (optind + 1 < argc) {
+		usage_import();
+		return 1;
+	}
+	if (db_backend == NULL) {
+		throw CPLException("No database backend");
+	}
+
+
+	// Open the input file
+
+	const char* input_file = optind < argc ? argv[optind] : "-";
+	FILE* f = stdin;
+
+	if (strcmp(input_file, "-") != 0) {
+		f = fopen(input_file, "r");
+		if (f == NULL) {
+			throw CPLException("Cannot open \"%s\" -- %s", input_file,
+					strerror(errno));
+		}
+	}
+
+
+	// Import the triples one line at a time. The triples of each session
+	// and of each object (including its version nodes) are expected to be
+	// adjacent, as written by the export command, so only one session and
+	// one object need to be kept in memory, together with the objects
+	// that are waiting for their container.
+
+	import_context_t ctx;
+	ctx.line = 0;
+	ctx.has_session = false;
+	ctx.has_object = false;
+	ctx.num_pending = 0;
+	ctx.num_triples = 0;
+	ctx.num_sessions = 0;
+	ctx.num_objects = 0;
+	ctx.num_edges = 0;
+
+	try {
+		string line;
+		nt_triple_t t;
+
+		while (read_line(f, line)) {
+			ctx.line++;
+			if (!parse_triple(line, t, ctx.line)) continue;
+			import_triple(&ctx, t);
+
+			if (verbose && ctx.num_triples % 100000 == 0) {
+				fprintf(stderr, "%s %s: %llu triples\n", program_name,
+						tool_name, ctx.num_triples);
+			}
+		}
+
+		if (ferror(f)) {
+			throw CPLException("Could not read the input -- %s",
+					strerror(errno));
+		}
+
+		finish_session(&ctx);
+		finish_object(&ctx);
+	}
+	catch (...) {
+		if (f != stdin) fclose(f);
+		throw;
+	}
+
+	if (f != stdin) fclose(f);
+
+	if (ctx.num_pending > 0) {
+		throw CPLException("%lu objects refer to containers that do not "
+				"exist", (unsigned long) ctx.num_pending);
+	}
+
+	if (verbose) {
+		fprintf(stderr, "%s %s: Imported %llu sessions, %llu objects, and "
+				"%llu ancestry edges (%llu triples).\n", program_name,
+				tool_name, ctx.num_sessions, ctx.num_objects, ctx.num_edges,
+				ctx.num_triples);
+	}
+
+	return 0;
+}
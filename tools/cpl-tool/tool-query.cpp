@@ -0,0 +1,175 @@
+/*
+ * tool-query.cpp
+ * Core Provenance Library
+ *
+ * Copyright 2012
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#include "stdafx.h"
+#include "cpl-tool.h"
+
+#include <getopt_compat.h>
+
+using namespace std;
+
+
+/**
+ * Verbose mode
+ */
+static bool verbose = false;
+
+
+/**
+ * Short command-line options
+ */
+static const char* SHORT_OPTIONS = "hv";
+
+
+/**
+ * Long command-line options
+ */
+static struct option LONG_OPTIONS[] =
+{
+	{"help",                 no_argument,       0, 'h'},
+	{"verbose",              no_argument,       0, 'v'},
+	{0, 0, 0, 0}
+};
+
+
+/**
+ * Print the usage information
+ */
+static void
+usage(void)
+{
+#define P(...) { fprintf(stderr, __VA_ARGS__); fputc('\n', stderr); }
+	P("Usage: %s %s [OPTIONS] QUERY...", program_name, tool_name);
+	P(" ");
+	P("Run a path query over the provenance graph and print the returned");
+	P("objects, for example:");
+	P(" ");
+	P("  %s %s \"MATCH (f:FILE {name:'/x'})<-[:DATA*1..5]-(p:PROCESS)"
+			" RETURN p\"", program_name, tool_name);
+	P(" ");
+	P("The arrow points from the dependent object to its ancestor. The");
+	P("query can be split into several arguments, which are joined using");
+	P("spaces.");
+	P(" ");
+	P("Options:");
+	P("  -h, --help               Print this message and exit");
+	P("  -v, --verbose            Enable verbose mode");
+#undef P
+}
+
+
+/**
+ * Print an object returned by the query
+ *
+ * @param info the object info
+ * @param context the unused context
+ * @return CPL_OK
+ */
+static cpl_return_t
+cb_print_object(const cpl_object_info_t* info, void* context)
+{
+	if (verbose) {
+		printf("%s\t%s\t%s\t%d\t%llx:%llx\n", info->originator, info->name,
+				info->type, info->version, info->id.hi, info->id.lo);
+	}
+	else {
+		printf("%s\t%s\n", info->name, info->type);
+	}
+
+	return CPL_OK;
+}
+
+
+/**
+ * Run a path query over the provenance graph
+ *
+ * @param argc the number of command-line arguments
+ * @param argv the vector of command-line arguments
+ * @return the exit code
+ */
+int
+tool_query(int argc, char** argv)
+{
+	// Parse the command-line arguments
+
+	int c, option_index = 0;
+	while ((c = getopt_long(argc, argv, SHORT_OPTIONS,
+							LONG_OPTIONS, &option_index)) >= 0) {
+
+		switch (c) {
+
+		case 'h':
+			usage();
+			return 0;
+
+		case 'v':
+			verbose = true;
+			break;
+
+		case '?':
+		case ':':
+			// getopt_long already printed an error message
+			return 1;
+
+		default:
+			abort();
+		}
+	}
+
+	if (optind >= argc) {
+		usage();
+		return 1;
+	}
+
+
+	// Join the query
+
+	std::string query;
+	for (int i = optind; i < argc; i++) {
+		if (i > optind) query += " ";
+		query += argv[i];
+	}
+
+
+	// Run the query
+
+	cpl_return_t ret = cpl_query(query.c_str(), cb_print_object, NULL);
+	if (ret == CPL_S_NO_DATA) return 0;
+	if (!CPL_IS_OK(ret)) {
+		throw CPLException("Could not run the query -- %s",
+				cpl_error_string(ret));
+	}
+
+	return 0;
+}
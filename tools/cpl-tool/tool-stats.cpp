@@ -0,0 +1,302 @@
+/*
+ * tool-stats.cpp
+ * Core Provenance Library
+ *
+ * Copyright 2012
+ *      The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Contributor(s): Peter Macko
+ */
+
+#include "stdafx.h"
+#include "cpl-tool.h"
+
+#include <getopt_compat.h>
+#include <ctime>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * Short command-line options
+ */
+static const char* SHORT_OPTIONS = "hk:s:u:";
+
+
+/**
+ * Long command-line options
+ */
+static struct option LONG_OPTIONS[] =
+{
+	{"help",                 no_argument,       0, 'h'},
+	{"kind",                 required_argument, 0, 'k'},
+	{"since",                required_argument, 0, 's'},
+	{"until",                required_argument, 0, 'u'},
+	{0, 0, 0, 0}
+};
+
+
+/**
+ * The names of the statistics for the command line and their headings
+ */
+static struct {
+	int kind;
+	const char* name;
+	const char* heading;
+} KINDS[] =
+{
+	{CPL_GS_EDGES_BY_TYPE      , "edges"   , "Edges by dependency type"    },
+	{CPL_GS_VERSIONS_PER_OBJECT, "versions", "Objects by number of versions"},
+	{CPL_GS_FAN_IN             , "fan-in"  , "Versions by number of inputs"},
+	{CPL_GS_FAN_OUT            , "fan-out" , "Versions by number of outputs"},
+	{CPL_GS_OBJECTS_PER_DAY    , "days"    , "Objects created per day"     },
+	{0, 0, 0}
+};
+
+
+/**
+ * Print the usage information
+ */
+static void
+usage(void)
+{
+#define P(...) { fprintf(stderr, __VA_ARGS__); fputc('\n', stderr); }
+	P("Usage: %s %s [OPTIONS]", program_name, tool_name);
+	P(" ");
+	P("Print aggregate statistics about the provenance graph. Each object,");
+	P("version, and edge is counted in the time range in which it was");
+	P("created, so that the results for disjoint time ranges add up.");
+	P(" ");
+	P("Options:");
+	P("  -h, --help               Print this message and exit");
+	P("  -k, --kind KIND          Print only the given statistic (edges,");
+	P("                           versions, fan-in, fan-out, or days); can");
+	P("                           be specified more than once");
+	P("  -s, --since TIME         Count only what was created at or after");
+	P("                           the given time (YYYY-MM-DD or UNIX time)");
+	P("  -u, --until TIME         Count only what was created before the");
+	P("                           given time (YYYY-MM-DD or UNIX time)");
+#undef P
+}
+
+
+/**
+ * Parse a time specification, which is either a date in the local time
+ * zone or UNIX time
+ *
+ * @param str the string
+ * @return the UNIX time
+ */
+static unsigned long
+parse_time(const char* str)
+{
+	int year, month, day;
+	char c;
+
+	if (sscanf(str, "%d-%d-%d%c", &year, &month, &day, &c) == 3) {
+		struct tm m;
+		memset(&m, 0, sizeof(m));
+		m.tm_year = year - 1900;
+		m.tm_mon = month - 1;
+		m.tm_mday = day;
+		m.tm_isdst = -1;
+		time_t t = mktime(&m);
+		if (t == (time_t) -1) {
+			throw CPLException("Invalid date \"%s\"", str);
+		}
+		return (unsigned long) t;
+	}
+
+	unsigned long t;
+	if (sscanf(str, "%lu%c", &t, &c) == 1) return t;
+
+	throw CPLException("Invalid time \"%s\"", str);
+}
+
+
+/**
+ * Format a dependency type
+ *
+ * @param type the dependency type
+ * @return the formatted string
+ */
+static std::string
+format_dependency_type(int type)
+{
+	const char* name = NULL;
+	switch (type) {
+		case CPL_DEPENDENCY_NONE   : name = "none"            ; break;
+		case CPL_DATA_INPUT        : name = "data input"      ; break;
+		case CPL_DATA_IPC          : name = "data ipc"        ; break;
+		case CPL_DATA_TRANSLATION  : name = "data translation"; break;
+		case CPL_DATA_COPY         : name = "data copy"       ; break;
+		case CPL_CONTROL_OP        : name = "control op"      ; break;
+		case CPL_CONTROL_START     : name = "control start"   ; break;
+		case CPL_VERSION_PREV      : name = "version prev"    ; break;
+	}
+	if (name != NULL) return name;
+
+	char buf[32];
+	snprintf(buf, sizeof(buf), "0x%x", type);
+	return buf;
+}
+
+
+/**
+ * Print aggregate statistics about the provenance graph
+ *
+ * @param argc the number of command-line arguments
+ * @param argv the vector of command-line arguments
+ * @return the exit code
+ */
+int
+tool_stats(int argc, char** argv)
+{
+	int kinds = 0;
+	unsigned long start_time = 0;
+	unsigned long end_time = 0;
+
+
+	// Parse the command-line arguments
+
+	int c, option_index = 0;
+	while ((c = getopt_long(argc, argv, SHORT_OPTIONS,
+							LONG_OPTIONS, &option_index)) >= 0) {
+
+		switch (c) {
+
+		case 'h':
+			usage();
+			return 0;
+
+		case 'k': {
+			int k = 0;
+			for (int i = 0; KINDS[i].name != NULL; i++) {
+				if (strcmp(KINDS[i].name, optarg) == 0) k = KINDS[i].kind;
+			}
+			if (k == 0) {
+				throw CPLException("Unknown statistic \"%s\"", optarg);
+			}
+			kinds |= k;
+			break;
+		}
+
+		case 's':
+			start_time = parse_time(optarg);
+			break;
+
+		case 'u':
+			end_time = parse_time(optarg);
+			if (end_time < 2) {
+				throw CPLException("The end time is too early");
+			}
+			end_time--;
+			break;
+
+		case '?':
+		case ':':
+			// getopt_long already printed an error message
+			return 1;
+
+		default:
+			abort();
+		}
+	}
+
+	if (optind < argc) {
+		usage();
+		return 1;
+	}
+
+	if (kinds == 0) kinds = CPL_GS_ALL;
+
+
+	// Compute the statistics
+
+	std::vector<cplxx_graph_statistic_t> stats;
+	cpl_return_t ret = cpl_get_graph_statistics(kinds, start_time, end_time,
+			cpl_cb_collect_graph_statistics_vector, &stats);
+	if (ret != CPL_S_NO_DATA) CPL_VERIFY(ret);
+
+
+	// Format the labels of the groups
+
+	std::vector<std::string> labels;
+	int width = 24;
+
+	for (size_t index = 0; index < stats.size(); index++) {
+		cplxx_graph_statistic_t& s = stats[index];
+		std::string label;
+
+		if (s.kind == CPL_GS_EDGES_BY_TYPE) {
+			label = format_dependency_type((int) s.key);
+		}
+		else if (s.kind == CPL_GS_OBJECTS_PER_DAY) {
+			char day[32];
+			time_t t = (time_t) s.key;
+			struct tm m;
+#ifdef _WINDOWS
+			localtime_s(&m, &t);
+#else
+			localtime_r(&t, &m);
+#endif
+			strftime(day, sizeof(day), "%Y-%m-%d", &m);
+			label = std::string(day) + "  " + s.originator + "  " + s.type;
+		}
+		else {
+			char buf[32];
+			snprintf(buf, sizeof(buf), "%lld", s.key);
+			label = buf;
+		}
+
+		if ((int) label.length() > width) width = (int) label.length();
+		labels.push_back(label);
+	}
+
+
+	// Print the statistics, which are already ordered by their kind
+
+	size_t index = 0;
+	for (int i = 0; KINDS[i].name != NULL; i++) {
+		if ((kinds & KINDS[i].kind) == 0) continue;
+
+		printf("%s:\n", KINDS[i].heading);
+		unsigned long long total = 0;
+
+		for ( ; index < stats.size() && stats[index].kind == KINDS[i].kind;
+				index++) {
+			printf("    %-*s %12llu\n", width, labels[index].c_str(),
+					stats[index].count);
+			total += stats[index].count;
+		}
+
+		printf("    %-*s %12llu\n\n", width, "Total", total);
+	}
+
+	return 0;
+}